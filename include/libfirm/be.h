@@ -103,6 +103,16 @@ FIRM_API void be_set_after_transform_func(after_transform_func func);
  */
 FIRM_API void be_main(FILE *output, const char *compilation_unit_name);
 
+/**
+ * Like be_main() but writes a relocatable object file instead of assembly,
+ * so no assembler has to be run. Object files contain no debug information
+ * besides the call frame information.
+ *
+ * @return zero if the target cannot write object files directly, nothing is
+ *         written in this case
+ */
+FIRM_API int be_main_object(FILE *output, const char *compilation_unit_name);
+
 /**
  * parse assembler constraint strings and returns flags (so the frontend knows
  * which operands are inputs/outputs and whether memory is required)
@@ -64,6 +64,16 @@ FIRM_API unsigned heights_recompute_block(ir_heights_t *h, ir_node *block);
  */
 FIRM_API ir_heights_t *heights_new(ir_graph *irg);
 
+/**
+ * Creates a new heights object, where each data dependence edge counts with
+ * the latency of the node it starts at instead of 1. The height of a node is
+ * then the length of the critical path from the node to the end of its block.
+ * @param irg     The graph.
+ * @param latency Returns the latency of a node.
+ */
+FIRM_API ir_heights_t *heights_new_weighted(ir_graph *irg,
+                                            unsigned (*latency)(const ir_node *node));
+
 /**
  * Frees a heights object.
  * @param h The heights object.
@@ -5,7 +5,7 @@
 
 /**
  * @file
- * @brief   Input/Output textual representation of firm.
+ * @brief   Input/Output textual and binary representation of firm.
  * @author  Moritz Kroll
  */
 #ifndef FIRM_IR_IRIO_H
@@ -38,9 +38,27 @@ FIRM_API int ir_export(const char *filename);
  */
 FIRM_API void ir_export_file(FILE *output);
 
+/**
+ * Exports the whole irp to the given file in a compact binary form.
+ * The binary form contains the same information as the textual one, but
+ * is considerably faster to import and allows to read graphs on demand
+ * (see ir_import_lazy()).
+ *
+ * @param filename  the name of the resulting file
+ * @return  0 if no errors occured, other values in case of errors
+ */
+FIRM_API int ir_export_binary(const char *filename);
+
+/**
+ * same as ir_export_binary but writes to a FILE*
+ * @note As with any FILE* errors are indicated by ferror(output)
+ */
+FIRM_API void ir_export_binary_file(FILE *output);
+
 /**
  * Imports the data stored in the given file.
  * Imports any type graphs and ir graphs contained in the file.
+ * Both the textual and the binary form are accepted.
  *
  * @param filename  the name of the file
  * @returns 0 if no errors occured, other values in case of errors
@@ -52,6 +70,48 @@ FIRM_API int ir_import(const char *filename);
  */
 FIRM_API int ir_import_file(FILE *input, const char *inputname);
 
+/** A binary file opened by ir_import_lazy(). */
+typedef struct ir_import_t ir_import_t;
+
+/**
+ * Opens a file written by ir_export_binary() and imports its types and
+ * entities. The ir graphs are only read when requested with
+ * ir_import_lazy_get_irg(). The file stays mapped into memory until
+ * ir_import_lazy_finish() is called.
+ *
+ * @param filename  the name of the file
+ * @returns the opened file or NULL in case of errors
+ */
+FIRM_API ir_import_t *ir_import_lazy(const char *filename);
+
+/**
+ * Returns the number of ir graphs contained in a lazily imported file.
+ */
+FIRM_API size_t ir_import_lazy_get_n_irgs(const ir_import_t *import);
+
+/**
+ * Returns the entity of the ir graph at position @p pos of a lazily imported
+ * file.
+ */
+FIRM_API ir_entity *ir_import_lazy_get_irg_entity(ir_import_t *import,
+                                                  size_t pos);
+
+/**
+ * Reads the ir graph of entity @p entity from a lazily imported file, if it
+ * has not been read yet.
+ *
+ * @returns the ir graph or NULL if the file contains no graph for @p entity
+ */
+FIRM_API ir_graph *ir_import_lazy_get_irg(ir_import_t *import,
+                                          ir_entity *entity);
+
+/**
+ * Closes a lazily imported file. Graphs which were not read are dropped.
+ *
+ * @returns 0 if no errors occured, other values in case of errors
+ */
+FIRM_API int ir_import_lazy_finish(ir_import_t *import);
+
 /** @} */
 
 #include "end.h"
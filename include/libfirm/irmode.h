@@ -99,6 +99,17 @@ FIRM_API ir_mode *new_float_mode(const char *name,
  */
 FIRM_API ir_mode *new_non_arithmetic_mode(const char *name, unsigned bit_size);
 
+/**
+ * Creates a new mode for vectors of @p n_elements values of the int or float
+ * mode @p element_mode.
+ *
+ * Add, Sub, Mul, And, Or and Eor operate lane-wise on values of a vector
+ * mode, Load and Store access the elements at consecutive addresses. Vector
+ * modes have no tarvals, so there are no vector Consts. Use a Splat node to
+ * replicate a scalar into all lanes instead.
+ */
+FIRM_API ir_mode *new_vector_mode(ir_mode *element_mode, unsigned n_elements);
+
 /** Returns the ident* of the mode */
 FIRM_API ident *get_mode_ident(const ir_mode *mode);
 
@@ -115,6 +126,12 @@ FIRM_API unsigned get_mode_size_bytes(const ir_mode *mode);
 /** Returns the arithmetic of a mode */
 FIRM_API ir_mode_arithmetic get_mode_arithmetic(const ir_mode *mode);
 
+/** Returns the mode of the elements of the vector mode @p mode. */
+FIRM_API ir_mode *get_mode_vector_element_mode(const ir_mode *mode);
+
+/** Returns the number of elements of the vector mode @p mode. */
+FIRM_API unsigned get_mode_n_vector_elements(const ir_mode *mode);
+
 /** Returns the modulo shift attribute.
  *
  *  Attribute modulo shift specifies for modes of kind irms_int_number
@@ -261,6 +278,9 @@ FIRM_API int mode_is_int(const ir_mode *mode);
 /** Returns 1 if @p mode is for references/pointers, 0 otherwise */
 FIRM_API int mode_is_reference(const ir_mode *mode);
 
+/** Returns 1 if @p mode is a vector mode, 0 otherwise */
+FIRM_API int mode_is_vector(const ir_mode *mode);
+
 /**
  * Returns 1 if @p mode is for numeric values, 0 otherwise.
  *
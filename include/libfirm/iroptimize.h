@@ -183,6 +183,32 @@ FIRM_API void optimize_load_store(ir_graph *irg);
  */
 FIRM_API void combine_memops(ir_graph *irg);
 
+/**
+ * Straight-line vectorization: Replaces groups of Stores to adjacent
+ * addresses in a block by a vector Store if the stored values are computed
+ * by isomorphic expressions of Loads from adjacent addresses, identical
+ * values and lane-wise arithmetic.
+ *
+ * Does nothing if the target has no vector registers.
+ *
+ * @param irg  the graph
+ */
+FIRM_API void slp_vectorize(ir_graph *irg);
+
+/**
+ * Loop vectorization: Innermost loops, which consist of a test of the
+ * induction variable against a loop invariant bound and a single block of
+ * Loads and Stores to consecutive addresses, lane-wise arithmetic and integer
+ * reductions, get a vector version in front of them. The original loop
+ * executes the remaining iterations. If the accessed memory may overlap, the
+ * vector version is only used after a check at runtime.
+ *
+ * Does nothing if the target has no vector registers.
+ *
+ * @param irg  the graph
+ */
+FIRM_API void loop_vectorize(ir_graph *irg);
+
 /**
  * New experimental alternative to optimize_load_store.
  * Based on a dataflow analysis, so load/stores are moved out of loops
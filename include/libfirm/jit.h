@@ -41,10 +41,41 @@ FIRM_API ir_jit_segment_t *be_new_jit_segment(void);
 
 /**
  * Destroy jit segment \p segment. Invalidates references to functions created in
- * the segment.
+ * the segment and releases their executable memory.
  */
 FIRM_API void be_destroy_jit_segment(ir_jit_segment_t *segment);
 
+/**
+ * Enable or disable lazy compilation for \p segment.
+ *
+ * When a function of \p segment is emitted, functions it references which
+ * have a graph but no address get a small stub as address. The first call
+ * of a stub compiles the graph into \p segment with be_jit_compile(), emits
+ * it with be_jit_emit_executable() and patches the stub to jump to the code
+ * directly. The entity keeps the address of the stub.
+ *
+ * Lazily compiled graphs must already be lowered for the target. A graph
+ * compiled with be_jit_compile() must be emitted before functions calling it,
+ * otherwise it gets a stub and is compiled twice. Stubs are resolved by the
+ * thread that calls them, the library is not thread-safe.
+ *
+ * @return nonzero if the target supports lazy compilation
+ */
+FIRM_API int be_jit_set_lazy(ir_jit_segment_t *segment, int lazy);
+
+/**
+ * Keep the code compiled by be_jit_compile() for \p segment in \p directory
+ * and reuse it in later processes. Passing NULL disables the cache.
+ *
+ * Cache entries are keyed by a fingerprint of the graph, the types and
+ * entities it references, the target and the backend options. A cache hit
+ * skips code generation, the function is only relocated when it is emitted.
+ * Entities the code references are looked up by their linker name, functions
+ * referencing private entities are not cached. The directory must exist.
+ */
+FIRM_API void be_jit_set_cache_dir(ir_jit_segment_t *segment,
+                                   char const *directory);
+
 /**
  * Set absolute address of global entities so relocations in jit compiled
  * code an be resolved.
@@ -72,6 +103,17 @@ FIRM_API unsigned be_get_function_size(ir_jit_function_t const *function);
  */
 FIRM_API void be_emit_function(char *buffer, ir_jit_function_t *function);
 
+/**
+ * Emit \p function into executable memory owned by its segment and return the
+ * address of its code. Later calls return the same address.
+ *
+ * The memory is only writable while the function is copied in, it is
+ * executable afterwards. If the entity of the compiled graph has no address
+ * yet, it gets the address of the code before relocations are resolved, so
+ * recursive calls and calls from functions emitted later resolve to it.
+ */
+FIRM_API void *be_jit_emit_executable(ir_jit_function_t *function);
+
 /** @} */
 
 #include "end.h"
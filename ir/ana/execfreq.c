@@ -24,6 +24,15 @@
  * no path to the end node, which produces undesired results (0, infinite
  * execution frequencies). We alleviate that by adding artificial edges from
  * kept blocks with a path to end.
+ *
+ * For reducible control flow the system is solved along the loop nesting
+ * (Wu and Larus, "Static Branch Frequency and Program Profile Analysis"):
+ * Starting with the innermost loops, the probability to get back to the
+ * header of each loop is computed by propagating the frequencies through the
+ * loop body. The frequency of a loop header is then its entry frequency
+ * divided by the probability to leave the loop. This needs linear space and
+ * time proportional to the number of blocks times the loop depth. Irreducible
+ * control flow is handled by solving the dense system of equations.
  */
 #include "execfreq_t.h"
 
@@ -269,6 +278,11 @@ static double *freqs;
 static double  min_non_zero;
 static double  max_freq;
 
+static int cmp_freq(const void *a, const void *b)
+{
+	return QSORT_CMP(*(const double*)a, *(const double*)b);
+}
+
 static void collect_freqs(ir_node *node, void *data)
 {
 	(void)data;
@@ -293,19 +307,25 @@ void ir_calculate_execfreq_int_factors(ir_execfreq_int_factors *factors,
 	/*
 	 * find the smallest difference of the execution frequencies
 	 * we try to ressolve it with 1 integer.
+	 * Zero frequencies are not considered, they are mapped to 1 anyway. In the
+	 * sorted frequencies the smallest difference of freqs[i] to a larger
+	 * frequency is the one to the first freqs[j] which is not too close, and
+	 * j only increases with i.
 	 */
+	QSORT_ARR(freqs, cmp_freq);
 	size_t n_freqs       = ARR_LEN(freqs);
 	double smallest_diff = 1.0;
-	for (size_t i = 0; i < n_freqs; ++i) {
-		if (freqs[i] <= 0.0)
-			continue;
-
-		for (size_t j = i + 1; j < n_freqs; ++j) {
-			double diff = fabs(freqs[i] - freqs[j]);
-
-			if (!UNDEF(diff))
-				smallest_diff = MIN(diff, smallest_diff);
-		}
+	size_t first         = 0;
+	while (first < n_freqs && freqs[first] <= 0.0)
+		++first;
+	for (size_t i = first, j = first; i < n_freqs; ++i) {
+		if (j <= i)
+			j = i + 1;
+		while (j < n_freqs && UNDEF(freqs[j] - freqs[i]))
+			++j;
+		if (j == n_freqs)
+			break;
+		smallest_diff = MIN(freqs[j] - freqs[i], smallest_diff);
 	}
 
 	double l2 = min_non_zero;
@@ -435,33 +455,21 @@ static void free_properties_and_dfs(ir_graph *const irg, dfs_t *const dfs) {
 	dfs_free(dfs);
 }
 
-void ir_estimate_execfreq(ir_graph *irg)
+/**
+ * Solves the system of equations for the block frequencies with a dense
+ * matrix. This works for arbitrary control flow but needs quadratic space and
+ * cubic time in the number of blocks.
+ *
+ * Returns false when this would result in an invalid frequency.
+ */
+static bool estimate_by_matrix(ir_graph *const irg, dfs_t *const dfs,
+                               double const inv_loop_weight)
 {
-	double loop_weight = 10.0;
-
-	assure_irg_properties(irg,
-		IR_GRAPH_PROPERTY_CONSISTENT_OUT_EDGES
-		| IR_GRAPH_PROPERTY_NO_BADS
-		| IR_GRAPH_PROPERTY_CONSISTENT_LOOPINFO
-		| IR_GRAPH_PROPERTY_NO_UNREACHABLE_CODE);
-
-	/* compute a DFS.
-	 * using a toposort on the CFG (without back edges) will propagate
-	 * the values better for the gauss/seidel iteration.
-	 * => they can "flow" from start to end. */
-	dfs_t *const dfs = dfs_new(irg);
-
 	unsigned       size   = dfs_get_n_nodes(dfs);
 
 	/* It is undesirable to allocate more than 2GB for the matrix */
-	if (size*size*sizeof(double) > 1 << 30) {
-		if (!fallback_loop_weight(dfs, loop_weight)) {
-			fallback_all_ones(dfs);
-		}
-		dfs_free(dfs);
-		return;
-	}
-
+	if (size*size*sizeof(double) > 1 << 30)
+		return false;
 
 	square_matrix *in_fac = mat_create(size);
 	for (unsigned r = 0; r < size; r++) {
@@ -470,32 +478,10 @@ void ir_estimate_execfreq(ir_graph *irg)
 		}
 	}
 
-
 	ir_node *const start_block = get_irg_start_block(irg);
 	ir_node *const end_block   = get_irg_end_block(irg);
 	const int      end_idx     = size - dfs_get_post_num(dfs, end_block) - 1;
 
-	ir_reserve_resources(irg, IR_RESOURCE_BLOCK_VISITED
-	                          | IR_RESOURCE_IRN_VISITED
-	                          | IR_RESOURCE_IRN_LINK);
-	inc_irg_block_visited(irg);
-
-	/* mark all blocks reachable from end_block as (block)visited
-	 * (so we can detect places like endless-loops/noreturn calls which
-	 *  do not reach the End block) */
-	block_walk_no_keeps(end_block);
-	/* mark all kept blocks as (node)visited */
-	inc_irg_visited(irg);
-	const ir_node *end          = get_irg_end(irg);
-	int const      n_keepalives = get_End_n_keepalives(end);
-	for (int k = n_keepalives - 1; k >= 0; --k) {
-		ir_node *keep = get_End_keepalive(end, k);
-		if (is_Block(keep)) {
-			mark_irn_visited(keep);
-		}
-	}
-
-	double const inv_loop_weight = 1.0 / loop_weight;
 	/* lgs_to_mat[i] is the index of the block represented by the
 	 * i-th row/column in the LGS matrix. */
 	int *lgs_to_mat = NEW_ARR_F(int, 0);
@@ -536,6 +522,8 @@ void ir_estimate_execfreq(ir_graph *irg)
 
 	/* add artifical edges from "kept blocks without a path to end"
 	 * to end */
+	const ir_node *end          = get_irg_end(irg);
+	int const      n_keepalives = get_End_n_keepalives(end);
 	for (unsigned k = n_keepalives; k-- > 0; ) {
 		ir_node *keep = get_End_keepalive(end, k);
 		if (!is_Block(keep) || has_path_to_end(keep))
@@ -638,6 +626,289 @@ void ir_estimate_execfreq(ir_graph *irg)
 	}
 
 	DEL_ARR_F(freqs);
+	DEL_ARR_F(lgs_to_mat);
+	DEL_ARR_F(mat_to_lgs);
+	free(in_fac);
+	free(lgs_matrix);
+	DEL_ARR_F(lgs_x);
+	return valid_freq;
+}
+
+/** Per block information of the loop based frequency estimation. */
+typedef struct block_info_t {
+	ir_node  *block;
+	double   *in_prob;   /**< probability of each control flow predecessor
+	                          to branch to this block */
+	double    freq;      /**< frequency relative to the loop processed last */
+	double    cyclic;    /**< probability to get back to this loop header */
+	unsigned  idx;       /**< reverse post order number */
+	unsigned  mark;      /**< last loop body walk which reached this block */
+	bool      is_header; /**< block is the target of a back edge */
+} block_info_t;
+
+static block_info_t *get_block_info(const ir_node *block)
+{
+	return (block_info_t*)get_irn_link(block);
+}
+
+static int cmp_idx(const void *a, const void *b)
+{
+	return QSORT_CMP(*(const unsigned*)a, *(const unsigned*)b);
+}
+
+/**
+ * Collects the natural loop of @p header, i.e. all blocks which reach one of
+ * its back edges without passing the header, into @p body in reverse post
+ * order.
+ *
+ * Returns false if the start block is reached, in which case the header does
+ * not dominate the back edge and the control flow is irreducible.
+ */
+static bool collect_loop_body(block_info_t *const header,
+                              ir_node const *const start_block,
+                              block_info_t ***const stack,
+                              unsigned **const body)
+{
+	unsigned const mark = header->idx + 1;
+	header->mark = mark;
+	ARR_SHRINKLEN(*body, 0);
+	ARR_APP1(unsigned, *body, header->idx);
+
+	ir_node *const block = header->block;
+	for (int i = get_Block_n_cfgpreds(block); i-- > 0; ) {
+		ir_node *const pred = get_Block_cfgpred_block(block, i);
+		if (pred == NULL)
+			continue;
+		block_info_t *const pred_info = get_block_info(pred);
+		if (pred_info->idx >= header->idx && pred_info->mark != mark)
+			ARR_APP1(block_info_t*, *stack, pred_info);
+	}
+
+	while (ARR_LEN(*stack) > 0) {
+		size_t        const top  = ARR_LEN(*stack) - 1;
+		block_info_t *const info = (*stack)[top];
+		ARR_SHRINKLEN(*stack, top);
+		if (info->mark == mark)
+			continue;
+		if (info->block == start_block) {
+			ARR_SHRINKLEN(*stack, 0);
+			return false;
+		}
+		info->mark = mark;
+		ARR_APP1(unsigned, *body, info->idx);
+
+		for (int i = get_Block_n_cfgpreds(info->block); i-- > 0; ) {
+			ir_node *const pred = get_Block_cfgpred_block(info->block, i);
+			if (pred == NULL)
+				continue;
+			block_info_t *const pred_info = get_block_info(pred);
+			if (pred_info->mark != mark)
+				ARR_APP1(block_info_t*, *stack, pred_info);
+		}
+	}
+
+	QSORT_ARR(*body, cmp_idx);
+	return true;
+}
+
+/**
+ * Computes the frequencies of the blocks in @p body, which must be in reverse
+ * post order, from their forward control flow edges. The frequency of
+ * @p header is 1, headers of inner loops get their entry frequency scaled by
+ * the probability to leave the loop.
+ */
+static void propagate_freqs(block_info_t *const infos,
+                            unsigned const *const body,
+                            block_info_t const *const header,
+                            ir_node const *const start_block)
+{
+	for (size_t b = 0, n = ARR_LEN(body); b < n; ++b) {
+		block_info_t *const info = &infos[body[b]];
+		if (info == header) {
+			info->freq = 1.0;
+			continue;
+		}
+
+		ir_node *const block = info->block;
+		/* the start block is entered once by the artificial edge from end */
+		double freq = block == start_block ? 1.0 : 0.0;
+		for (int i = get_Block_n_cfgpreds(block); i-- > 0; ) {
+			ir_node *const pred = get_Block_cfgpred_block(block, i);
+			if (pred == NULL)
+				continue;
+			block_info_t const *const pred_info = get_block_info(pred);
+			if (pred_info->idx < info->idx)
+				freq += pred_info->freq * info->in_prob[i];
+		}
+		if (info->is_header)
+			freq /= 1.0 - info->cyclic;
+		info->freq = freq;
+	}
+}
+
+/**
+ * Computes the block frequencies along the loop nesting.
+ *
+ * Returns false if the control flow is irreducible. Otherwise @p valid is set
+ * to false when this would result in an invalid frequency.
+ */
+static bool estimate_along_loops(ir_graph *const irg, dfs_t *const dfs,
+                                 double const inv_loop_weight,
+                                 bool *const valid)
+{
+	unsigned const size = dfs_get_n_nodes(dfs);
+	block_info_t  *infos = XMALLOCNZ(block_info_t, size);
+
+	size_t n_preds = 0;
+	for (unsigned idx = 0; idx < size; ++idx) {
+		ir_node      *const bb   = dfs_get_post_num_node(dfs, size - idx - 1);
+		block_info_t *const info = &infos[idx];
+		info->block = bb;
+		info->idx   = idx;
+		set_irn_link(bb, info);
+		n_preds += get_Block_n_cfgpreds(bb);
+	}
+
+	double        *const probs   = XMALLOCN(double, n_preds);
+	double              *in_prob = probs;
+	unsigned            *headers = NEW_ARR_F(unsigned, 0);
+	for (unsigned idx = 0; idx < size; ++idx) {
+		block_info_t *const info = &infos[idx];
+		ir_node      *const bb   = info->block;
+		info->in_prob = in_prob;
+		for (int i = 0, n = get_Block_n_cfgpreds(bb); i < n; ++i) {
+			in_prob[i] = get_cf_probability(bb, i, inv_loop_weight);
+
+			ir_node *const pred = get_Block_cfgpred_block(bb, i);
+			if (pred != NULL && get_block_info(pred)->idx >= idx)
+				info->is_header = true;
+		}
+		in_prob += get_Block_n_cfgpreds(bb);
+		if (info->is_header)
+			ARR_APP1(unsigned, headers, idx);
+	}
+
+	/* compute the probability to get back to each loop header, inner loops
+	 * first: they are dominated by the outer loop header and follow it in
+	 * reverse post order */
+	ir_node      *const start_block = get_irg_start_block(irg);
+	ir_node      *const end_block   = get_irg_end_block(irg);
+	block_info_t      **stack       = NEW_ARR_F(block_info_t*, 0);
+	unsigned           *body        = NEW_ARR_F(unsigned, 0);
+	bool                reducible   = true;
+	for (size_t h = ARR_LEN(headers); h-- > 0; ) {
+		block_info_t *const header = &infos[headers[h]];
+		if (!collect_loop_body(header, start_block, &stack, &body)) {
+			reducible = false;
+			break;
+		}
+		propagate_freqs(infos, body, header, start_block);
+
+		double         cyclic = 0.0;
+		ir_node *const block  = header->block;
+		for (int i = get_Block_n_cfgpreds(block); i-- > 0; ) {
+			ir_node *const pred = get_Block_cfgpred_block(block, i);
+			if (pred == NULL)
+				continue;
+			block_info_t const *const pred_info = get_block_info(pred);
+			if (pred_info->idx >= header->idx)
+				cyclic += pred_info->freq * header->in_prob[i];
+		}
+		header->cyclic = cyclic;
+	}
+
+	if (reducible) {
+		/* propagate through the whole graph, the end block is handled last as
+		 * kept blocks may follow it */
+		ARR_SHRINKLEN(body, 0);
+		for (unsigned idx = 0; idx < size; ++idx) {
+			if (infos[idx].block != end_block)
+				ARR_APP1(unsigned, body, idx);
+		}
+		propagate_freqs(infos, body, NULL, start_block);
+
+		block_info_t *const end_info = get_block_info(end_block);
+		double              end_freq = 0.0;
+		for (int i = get_Block_n_cfgpreds(end_block); i-- > 0; ) {
+			ir_node *const pred = get_Block_cfgpred_block(end_block, i);
+			if (pred != NULL)
+				end_freq += get_block_info(pred)->freq * end_info->in_prob[i];
+		}
+
+		/* add artifical edges from "kept blocks without a path to end"
+		 * to end */
+		const ir_node *end = get_irg_end(irg);
+		for (int k = get_End_n_keepalives(end); k-- > 0; ) {
+			ir_node *keep = get_End_keepalive(end, k);
+			if (!is_Block(keep) || has_path_to_end(keep))
+				continue;
+
+			double sum = get_sum_succ_factors(keep, inv_loop_weight);
+			end_freq += get_block_info(keep)->freq * KEEP_FAC / sum;
+		}
+		end_info->freq = end_freq;
+
+		/* normalize to an end block frequency of 1 */
+		double const norm = end_freq != 0.0 ? 1.0 / end_freq : 1.0;
+		*valid = true;
+		for (unsigned idx = 0; idx < size; ++idx) {
+			double const freq = infos[idx].freq * norm;
+			/* Check for inf, nan and negative values. */
+			if (isinf(freq) || !(freq >= 0)) {
+				*valid = false;
+				break;
+			}
+			set_block_execfreq(infos[idx].block, freq);
+		}
+	}
+
+	DEL_ARR_F(body);
+	DEL_ARR_F(stack);
+	DEL_ARR_F(headers);
+	free(probs);
+	free(infos);
+	return reducible;
+}
+
+void ir_estimate_execfreq(ir_graph *irg)
+{
+	double loop_weight = 10.0;
+
+	assure_irg_properties(irg,
+		IR_GRAPH_PROPERTY_CONSISTENT_OUT_EDGES
+		| IR_GRAPH_PROPERTY_NO_BADS
+		| IR_GRAPH_PROPERTY_CONSISTENT_LOOPINFO
+		| IR_GRAPH_PROPERTY_NO_UNREACHABLE_CODE);
+
+	/* compute a DFS.
+	 * using a toposort on the CFG (without back edges) will propagate
+	 * the values better for the gauss/seidel iteration.
+	 * => they can "flow" from start to end. */
+	dfs_t *const dfs = dfs_new(irg);
+
+	ir_reserve_resources(irg, IR_RESOURCE_BLOCK_VISITED
+	                          | IR_RESOURCE_IRN_VISITED
+	                          | IR_RESOURCE_IRN_LINK);
+	inc_irg_block_visited(irg);
+
+	/* mark all blocks reachable from end_block as (block)visited
+	 * (so we can detect places like endless-loops/noreturn calls which
+	 *  do not reach the End block) */
+	block_walk_no_keeps(get_irg_end_block(irg));
+	/* mark all kept blocks as (node)visited */
+	inc_irg_visited(irg);
+	const ir_node *end = get_irg_end(irg);
+	for (int k = get_End_n_keepalives(end); k-- > 0; ) {
+		ir_node *keep = get_End_keepalive(end, k);
+		if (is_Block(keep)) {
+			mark_irn_visited(keep);
+		}
+	}
+
+	double const inv_loop_weight = 1.0 / loop_weight;
+	bool         valid_freq;
+	if (!estimate_along_loops(irg, dfs, inv_loop_weight, &valid_freq))
+		valid_freq = estimate_by_matrix(irg, dfs, inv_loop_weight);
 
 	/* Fallbacks in case some frequencies were invalid */
 	if (!valid_freq && !fallback_loop_weight(dfs, loop_weight)) {
@@ -645,9 +916,4 @@ void ir_estimate_execfreq(ir_graph *irg)
 	}
 
 	free_properties_and_dfs(irg, dfs);
-	DEL_ARR_F(lgs_to_mat);
-	DEL_ARR_F(mat_to_lgs);
-	free(in_fac);
-	free(lgs_matrix);
-	DEL_ARR_F(lgs_x);
 }
@@ -24,6 +24,7 @@
 struct ir_heights_t {
 	ir_nodemap      data;
 	unsigned        visited;
+	unsigned      (*latency)(const ir_node *node);
 	hook_entry_t   *dump_handle;
 	struct obstack  obst;
 };
@@ -134,12 +135,13 @@ static unsigned compute_height(ir_heights_t *h, ir_node *irn, const ir_node *bl)
 	ih->visited = h->visited;
 	ih->height  = 0;
 
+	unsigned latency = h->latency != NULL ? h->latency(irn) : 1;
 	foreach_out_edge(irn, edge) {
 		ir_node *dep = get_edge_src_irn(edge);
 
 		if (!is_Block(dep) && !is_Phi(dep) && get_nodes_block(dep) == bl) {
 			unsigned dep_height = compute_height(h, dep, bl);
-			ih->height          = MAX(ih->height, dep_height+1);
+			ih->height          = MAX(ih->height, dep_height + latency);
 		}
 	}
 
@@ -191,8 +193,15 @@ unsigned heights_recompute_block(ir_heights_t *h, ir_node *block)
 }
 
 ir_heights_t *heights_new(ir_graph *irg)
+{
+	return heights_new_weighted(irg, NULL);
+}
+
+ir_heights_t *heights_new_weighted(ir_graph *irg,
+                                   unsigned (*latency)(const ir_node *node))
 {
 	ir_heights_t *res = XMALLOCZ(ir_heights_t);
+	res->latency = latency;
 	ir_nodemap_init(&res->data, irg);
 	obstack_init(&res->obst);
 	res->dump_handle = dump_add_node_info_callback(height_dump_cb, res);
@@ -572,13 +572,16 @@ static void reset_backedges(ir_node *n)
 static void loop_reset_node(ir_node *n, void *env)
 {
 	(void)env;
-	set_irn_loop(n, NULL);
 	reset_backedges(n);
 }
 
 void free_loop_information(ir_graph *irg)
 {
 	irg_walk_graph(irg, loop_reset_node, NULL, NULL);
+	if (irg->idx_loops != NULL) {
+		DEL_ARR_F(irg->idx_loops);
+		irg->idx_loops = NULL;
+	}
 	set_irg_loop(irg, NULL);
 	clear_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_LOOPINFO);
 	/* We cannot free the loop nodes, they are on the obstack. */
@@ -11,8 +11,10 @@
  */
 #include "irloop_t.h"
 
+#include "array.h"
 #include "irprog_t.h"
 #include <stdlib.h>
+#include <string.h>
 
 void add_loop_son(ir_loop *loop, ir_loop *son)
 {
@@ -79,7 +81,21 @@ loop_element get_loop_element(const ir_loop *loop, size_t pos)
 
 void set_irn_loop(ir_node *n, ir_loop *loop)
 {
-	n->loop = loop;
+	ir_graph *const irg = get_irn_irg(n);
+	unsigned  const idx = get_irn_idx(n);
+	if (irg->idx_loops == NULL) {
+		if (loop == NULL)
+			return;
+		irg->idx_loops = NEW_ARR_FZ(ir_loop*, irg->last_node_idx);
+	}
+	size_t const len = ARR_LEN(irg->idx_loops);
+	if (idx >= len) {
+		if (loop == NULL)
+			return;
+		ARR_RESIZE(ir_loop*, irg->idx_loops, idx + 1);
+		memset(&irg->idx_loops[len], 0, (idx + 1 - len) * sizeof(ir_loop*));
+	}
+	irg->idx_loops[idx] = loop;
 }
 
 ir_loop *(get_irn_loop)(const ir_node *n)
@@ -107,7 +107,11 @@ static inline unsigned _get_loop_depth(const ir_loop *loop)
 /* Uses temporary information to get the loop */
 static inline ir_loop *_get_irn_loop(const ir_node *n)
 {
-	return n->loop;
+	ir_graph const *const irg = get_irn_irg(n);
+	unsigned        const idx = get_irn_idx(n);
+	if (irg->idx_loops == NULL || idx >= ARR_LEN(irg->idx_loops))
+		return NULL;
+	return irg->idx_loops[idx];
 }
 
 #endif
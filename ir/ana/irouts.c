@@ -11,29 +11,45 @@
  */
 #include "irouts_t.h"
 
+#include "array.h"
 #include "ircons.h"
 #include "irgraph_t.h"
 #include "irgwalk.h"
 #include "irnode_t.h"
 #include "irprog_t.h"
 #include "xmalloc.h"
+#include <string.h>
 
 unsigned get_irn_n_outs(const ir_node *node)
 {
-	return node->o.out->n_edges;
+	return get_irn_out_edges(node)->n_edges;
 }
 
 ir_node *get_irn_out(const ir_node *def, unsigned pos)
 {
 	assert(pos < get_irn_n_outs(def));
-	return def->o.out->edges[pos].use;
+	return get_irn_out_edges(def)->edges[pos].use;
 }
 
 ir_node *get_irn_out_ex(const ir_node *def, unsigned pos, int *in_pos)
 {
 	assert(pos < get_irn_n_outs(def));
-	*in_pos = def->o.out->edges[pos].pos;
-	return def->o.out->edges[pos].use;
+	ir_def_use_edge const *const edge = &get_irn_out_edges(def)->edges[pos];
+	*in_pos = edge->pos;
+	return edge->use;
+}
+
+void set_irn_out_edges(ir_node *const node, ir_def_use_edges *const edges)
+{
+	ir_graph *const irg = get_irn_irg(node);
+	unsigned  const idx = get_irn_idx(node);
+	assert(irg->idx_outs != NULL);
+	size_t const len = ARR_LEN(irg->idx_outs);
+	if (idx >= len) {
+		ARR_RESIZE(irn_outs_t, irg->idx_outs, idx + 1);
+		memset(&irg->idx_outs[len], 0, (idx + 1 - len) * sizeof(irn_outs_t));
+	}
+	irg->idx_outs[idx].out = edges;
 }
 
 unsigned get_Block_n_cfg_outs(const ir_node *bl)
@@ -234,13 +250,13 @@ static void count_outs_node(ir_node *n)
 		return;
 
 	/* initialize our counter */
-	n->o.n_outs = 0;
+	get_irn_outs_slot(n)->n_outs = 0;
 
 	int start = is_Block(n) ? 0 : -1;
 	for (int i = start, irn_arity = get_irn_arity(n); i < irn_arity; ++i) {
 		ir_node *def = get_irn_n(n, i);
 		count_outs_node(def);
-		++def->o.n_outs;
+		++get_irn_outs_slot(def)->n_outs;
 	}
 }
 
@@ -254,7 +270,7 @@ static void count_outs(ir_graph *irg)
 	foreach_irn_in(get_irg_anchor(irg), i, n) {
 		if (irn_visited_else_mark(n))
 			continue;
-		n->o.n_outs = 0;
+		get_irn_outs_slot(n)->n_outs = 0;
 	}
 }
 
@@ -264,9 +280,11 @@ static void set_out_edges_node(ir_node *node, struct obstack *obst)
 		return;
 
 	/* Allocate my array */
-	unsigned n_outs = node->o.n_outs;
-	node->o.out          = OALLOCF(obst, ir_def_use_edges, edges, n_outs);
-	node->o.out->n_edges = 0;
+	irn_outs_t       *const slot   = get_irn_outs_slot(node);
+	unsigned          const n_outs = slot->n_outs;
+	ir_def_use_edges *const out    = OALLOCF(obst, ir_def_use_edges, edges, n_outs);
+	out->n_edges = 0;
+	slot->out    = out;
 
 	/* add def->use edges from my predecessors to me */
 	int start = is_Block(node) ? 0 : -1;
@@ -277,9 +295,10 @@ static void set_out_edges_node(ir_node *node, struct obstack *obst)
 		set_out_edges_node(def, obst);
 
 		/* Remember this Def-Use edge */
-		unsigned pos = def->o.out->n_edges++;
-		def->o.out->edges[pos].use = node;
-		def->o.out->edges[pos].pos = i;
+		ir_def_use_edges *const def_out = get_irn_out_edges(def);
+		unsigned          const pos     = def_out->n_edges++;
+		def_out->edges[pos].use = node;
+		def_out->edges[pos].pos = i;
 	}
 }
 
@@ -294,14 +313,16 @@ static void set_out_edges(ir_graph *irg)
 	foreach_irn_in(get_irg_anchor(irg), i, n) {
 		if (irn_visited_else_mark(n))
 			continue;
-		n->o.out          = OALLOCF(obst, ir_def_use_edges, edges, 0);
-		n->o.out->n_edges = 0;
+		ir_def_use_edges *const out = OALLOCF(obst, ir_def_use_edges, edges, 0);
+		out->n_edges = 0;
+		get_irn_outs_slot(n)->out = out;
 	}
 }
 
 void compute_irg_outs(ir_graph *irg)
 {
 	free_irg_outs(irg);
+	irg->idx_outs = NEW_ARR_FZ(irn_outs_t, irg->last_node_idx);
 
 	/* This first iteration counts the overall number of out edges and the
 	   number of out edges for each node. */
@@ -320,15 +341,6 @@ void assure_irg_outs(ir_graph *irg)
 		compute_irg_outs(irg);
 }
 
-#ifdef DEBUG_libfirm
-/** Clear the outs of a node */
-static void reset_outs(ir_node *node, void *unused)
-{
-	(void)unused;
-	node->o.out = NULL;
-}
-#endif
-
 void free_irg_outs(ir_graph *irg)
 {
 	if (irg->out_obst_allocated) {
@@ -336,9 +348,8 @@ void free_irg_outs(ir_graph *irg)
 		irg->out_obst_allocated = false;
 	}
 
-#ifdef DEBUG_libfirm
-	/* when debugging, *always* reset all nodes' outs!  irg->outs might
-	   have been lying to us */
-	irg_walk_graph(irg, reset_outs, NULL, NULL);
-#endif
+	if (irg->idx_outs != NULL) {
+		DEL_ARR_F(irg->idx_outs);
+		irg->idx_outs = NULL;
+	}
 }
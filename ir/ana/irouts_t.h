@@ -7,6 +7,29 @@
 #define FIRM_ANA_IROUTS_T_H
 
 #include "irouts.h"
+#include "irgraph_t.h"
+
+static inline irn_outs_t *get_irn_outs_slot(const ir_node *node)
+{
+	ir_graph *const irg = get_irn_irg(node);
+	unsigned  const idx = get_irn_idx(node);
+	assert(irg->idx_outs != NULL && idx < ARR_LEN(irg->idx_outs));
+	return &irg->idx_outs[idx];
+}
+
+/**
+ * Returns the Def-Use edges of @p node. Requires consistent outs.
+ */
+static inline ir_def_use_edges *get_irn_out_edges(const ir_node *node)
+{
+	return get_irn_outs_slot(node)->out;
+}
+
+/**
+ * Replaces the Def-Use edges of @p node. This may be used for nodes created
+ * after the outs were computed.
+ */
+void set_irn_out_edges(ir_node *node, ir_def_use_edges *edges);
 
 #define foreach_irn_out(irn, idx, succ) \
 	for (bool succ##__b = true; succ##__b;) \
@@ -6,6 +6,7 @@
 #include "amd64_architecture.h"
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
 
 #include "lc_opts_enum.h"
@@ -20,6 +21,8 @@ static cpu_arch_features arch;
 static cpu_arch_features opt_arch;
 static bool              use_red_zone         = false;
 static bool              use_scalar_fma3      = false;
+/** arch and opt_arch without padding, see amd64_get_resolved_config() */
+static uint32_t          resolved_config[4];
 
 /* instruction set architectures. */
 static const lc_opt_enum_int_items_t arch_items[] = {
@@ -122,6 +125,18 @@ void amd64_setup_cg_config(void)
 	amd64_code_gen_config_t *const c = &amd64_cg_config;
 	memset(c, 0, sizeof(*c));
 	c->use_scalar_fma3      = feature_flags(arch, arch_feature_fma) && use_scalar_fma3;
+	c->machine              = x86_get_machine_model(opt_arch);
+
+	resolved_config[0] = arch.arch;
+	resolved_config[1] = arch.features;
+	resolved_config[2] = opt_arch.arch;
+	resolved_config[3] = opt_arch.features;
+}
+
+void const *amd64_get_resolved_config(size_t *const size)
+{
+	*size = sizeof(resolved_config);
+	return resolved_config;
 }
 
 void amd64_init_architecture(void)
@@ -7,15 +7,19 @@
 #define FIRM_BE_AMD64_ARCHITECTURE_H
 
 #include <stdbool.h>
+#include <stddef.h>
 
 #include "firm_types.h"
 #include "irarch.h"
+#include "x86_architecture.h"
 
 typedef struct {
 	/** gcc compatibility */
 	bool use_red_zone:1;
 	/** use FMA3 instructions */
 	bool use_scalar_fma3:1;
+	/** machine model of the CPU to optimize for */
+	x86_machine_model const *machine;
 } amd64_code_gen_config_t;
 
 extern amd64_code_gen_config_t amd64_cg_config;
@@ -25,4 +29,8 @@ void amd64_init_architecture(void);
 
 /** Setup the amd64_cg_config structure by inspecting current user settings. */
 void amd64_setup_cg_config(void);
+
+/** Returns the CPU architectures and features amd64_setup_cg_config()
+ * settled on, including autodetected ones. */
+void const *amd64_get_resolved_config(size_t *size);
 #endif
@@ -407,9 +407,12 @@ static void amd64_collect_frame_entity_nodes(ir_node *node, void *data)
 /**
  * prepare graph and perform code selection.
  */
-static void amd64_select_instructions(ir_graph *irg)
+static void amd64_select_instructions(ir_graph *irg, bool jit)
 {
-	amd64_adjust_pic(irg);
+	if (jit)
+		amd64_adjust_jit_addresses(irg);
+	else
+		amd64_adjust_pic(irg);
 
 	be_timer_push(T_CODEGEN);
 	amd64_transform_graph(irg);
@@ -600,7 +603,7 @@ int amd64_get_sp_change(ir_node *const node)
 /**
  * Called immediately before emit phase.
  */
-static void amd64_finish_and_emit(ir_graph *irg)
+static void amd64_before_emit(ir_graph *irg)
 {
 	amd64_irg_data_t const *const irg_data = amd64_get_irg_data(irg);
 	bool                    const omit_fp  = irg_data->omit_fp;
@@ -633,11 +636,6 @@ static void amd64_finish_and_emit(ir_graph *irg)
 	amd64_simulate_graph_x87(irg);
 
 	amd64_peephole_optimization(irg);
-
-	/* emit code */
-	be_timer_push(T_EMIT);
-	amd64_emit_function(irg);
-	be_timer_pop(T_EMIT);
 }
 
 static void amd64_finish(void)
@@ -652,6 +650,31 @@ static const regalloc_if_t amd64_regalloc_if = {
 	.new_reload  = amd64_new_reload,
 };
 
+static bool lower_for_emit(ir_graph *const irg, const unsigned *const sp_is_non_ssa,
+                           bool const jit)
+{
+	if (!be_step_first(irg))
+		return false;
+
+	struct obstack *obst = be_get_be_obst(irg);
+	be_birg_from_irg(irg)->isa_link = OALLOCZ(obst, amd64_irg_data_t);
+
+	be_birg_from_irg(irg)->non_ssa_regs = sp_is_non_ssa;
+	amd64_select_instructions(irg, jit);
+
+	be_step_schedule(irg);
+
+	be_timer_push(T_RA_PREPARATION);
+	be_sched_fix_flags(irg, &amd64_reg_classes[CLASS_amd64_flags], NULL,
+	                   NULL, NULL);
+	be_timer_pop(T_RA_PREPARATION);
+
+	be_step_regalloc(irg, &amd64_regalloc_if);
+
+	amd64_before_emit(irg);
+	return true;
+}
+
 static void amd64_generate_code(FILE *output, const char *cup_name)
 {
 	amd64_constants = pmap_create();
@@ -660,33 +683,72 @@ static void amd64_generate_code(FILE *output, const char *cup_name)
 	rbitset_set(sp_is_non_ssa, REG_RSP);
 
 	foreach_irp_irg(i, irg) {
-		if (!be_step_first(irg))
+		if (!lower_for_emit(irg, sp_is_non_ssa, false))
 			continue;
 
-		struct obstack *obst = be_get_be_obst(irg);
-		be_birg_from_irg(irg)->isa_link = OALLOCZ(obst, amd64_irg_data_t);
+		be_timer_push(T_EMIT);
+		amd64_emit_function(irg);
+		be_timer_pop(T_EMIT);
 
-		be_birg_from_irg(irg)->non_ssa_regs = sp_is_non_ssa;
-		amd64_select_instructions(irg);
+		be_step_last(irg);
+	}
 
-		be_step_schedule(irg);
+	be_finish();
+	pmap_destroy(amd64_constants);
+}
 
-		be_timer_push(T_RA_PREPARATION);
-		be_sched_fix_flags(irg, &amd64_reg_classes[CLASS_amd64_flags], NULL,
-		                   NULL, NULL);
-		be_timer_pop(T_RA_PREPARATION);
+static void amd64_generate_object(FILE *output, const char *cup_name)
+{
+	amd64_constants = pmap_create();
+	be_begin(NULL, cup_name);
+	unsigned *const sp_is_non_ssa = rbitset_alloca(N_AMD64_REGISTERS);
+	rbitset_set(sp_is_non_ssa, REG_RSP);
 
-		be_step_regalloc(irg, &amd64_regalloc_if);
+	/* The code is encoded like in the jit and then relocated into the text
+	 * section with relocations for the linker. */
+	be_elf_writer_t  *const elf     = amd64_new_elf_writer();
+	ir_jit_segment_t *const segment = be_new_jit_segment();
+	foreach_irp_irg(i, irg) {
+		if (!lower_for_emit(irg, sp_is_non_ssa, false))
+			continue;
 
-		amd64_finish_and_emit(irg);
+		be_timer_push(T_EMIT);
+		amd64_emit_object_function(elf, segment, irg);
+		be_timer_pop(T_EMIT);
 
 		be_step_last(irg);
 	}
+	be_elf_add_globals(elf);
 
 	be_finish();
+	be_elf_write(elf, output);
+	be_elf_free(elf);
+	be_destroy_jit_segment(segment);
 	pmap_destroy(amd64_constants);
 }
 
+static ir_jit_function_t *amd64_jit_compile(ir_jit_segment_t *const segment,
+                                            ir_graph *const irg)
+{
+	unsigned *const sp_is_non_ssa = rbitset_alloca(N_AMD64_REGISTERS);
+	rbitset_set(sp_is_non_ssa, REG_RSP);
+
+	/* Floating point constants of the function become literals emitted
+	 * behind its code. */
+	amd64_constants = pmap_create();
+	ir_jit_function_t *res = NULL;
+	if (lower_for_emit(irg, sp_is_non_ssa, true)) {
+		be_timer_push(T_EMIT);
+		res = amd64_emit_jit(segment, irg);
+		be_timer_pop(T_EMIT);
+
+		be_step_last(irg);
+	}
+	pmap_destroy(amd64_constants);
+	amd64_constants = NULL;
+	return res;
+}
+
 static const ir_settings_arch_dep_t amd64_arch_dep = {
 	.replace_muls         = true,
 	.replace_divs         = true,
@@ -768,6 +830,27 @@ static void amd64_init_types(void)
 	ir_platform.va_list_type = amd64_build_va_list_type();
 }
 
+static bool amd64_allow_vector(ir_op const *const op,
+                               ir_mode const *const mode)
+{
+	if (get_mode_size_bits(mode) != 128)
+		return false;
+	if (op == op_Load || op == op_Store || op == op_Splat)
+		return true;
+
+	ir_mode *const elem = get_mode_vector_element_mode(mode);
+	if (mode_is_float(elem)) {
+		unsigned const bits = get_mode_size_bits(elem);
+		if (bits != 32 && bits != 64)
+			return false;
+		return op == op_Add || op == op_Sub || op == op_Mul;
+	}
+	if (op == op_Mul)
+		return get_mode_size_bits(elem) == 16;
+	return op == op_Add || op == op_Sub || op == op_And || op == op_Or
+	    || op == op_Eor;
+}
+
 static void amd64_init(void)
 {
 	amd64_setup_cg_config();
@@ -780,6 +863,8 @@ static void amd64_init(void)
 	ir_target.experimental = "the amd64 backend is experimental and unfinished (consider the ia32 backend)";
 	ir_target.fast_unaligned_memaccess = true;
 	ir_target.float_int_overflow       = ir_overflow_indefinite;
+	ir_target.allow_vector             = amd64_allow_vector;
+	ir_target.vector_size              = 16;
 }
 
 static unsigned amd64_get_op_estimated_cost(const ir_node *node)
@@ -788,6 +873,125 @@ static unsigned amd64_get_op_estimated_cost(const ir_node *node)
 	return 1;
 }
 
+static x86_insn_class amd64_get_insn_class(const ir_node *node)
+{
+	switch ((amd64_opcodes)get_amd64_irn_opcode(node)) {
+	case iro_amd64_div:
+	case iro_amd64_idiv:
+		return x86_insn_div;
+	case iro_amd64_imul:
+	case iro_amd64_imul_1op:
+	case iro_amd64_mul:
+		return x86_insn_imul;
+	case iro_amd64_sar:
+	case iro_amd64_shl:
+	case iro_amd64_shr:
+		return x86_insn_shift;
+	case iro_amd64_lea:
+		return x86_insn_lea;
+	case iro_amd64_fisttp:
+	case iro_amd64_fst:
+	case iro_amd64_fstp:
+	case iro_amd64_mov_store:
+	case iro_amd64_movdqu_store:
+	case iro_amd64_movs_store_xmm:
+	case iro_amd64_push_am:
+	case iro_amd64_push_reg:
+		return x86_insn_store;
+	case iro_amd64_call:
+	case iro_amd64_ijmp:
+	case iro_amd64_jcc:
+	case iro_amd64_jmp:
+	case iro_amd64_jmp_switch:
+	case iro_amd64_ret:
+		return x86_insn_branch;
+	case iro_amd64_addpd:
+	case iro_amd64_addps:
+	case iro_amd64_adds:
+	case iro_amd64_fadd:
+	case iro_amd64_fsub:
+	case iro_amd64_haddpd:
+	case iro_amd64_paddb:
+	case iro_amd64_paddd:
+	case iro_amd64_paddq:
+	case iro_amd64_paddw:
+	case iro_amd64_psubb:
+	case iro_amd64_psubd:
+	case iro_amd64_psubq:
+	case iro_amd64_psubw:
+	case iro_amd64_subpd:
+	case iro_amd64_subps:
+	case iro_amd64_subs:
+	case iro_amd64_ucomis:
+	case iro_amd64_cvtsd2ss:
+	case iro_amd64_cvtsi2sd:
+	case iro_amd64_cvtsi2ss:
+	case iro_amd64_cvtss2sd:
+	case iro_amd64_cvttsd2si:
+	case iro_amd64_cvttss2si:
+		return x86_insn_fp_add;
+	case iro_amd64_fmul:
+	case iro_amd64_mulpd:
+	case iro_amd64_mulps:
+	case iro_amd64_muls:
+	case iro_amd64_pmullw:
+	case iro_amd64_vfmadd132s:
+	case iro_amd64_vfmadd213s:
+	case iro_amd64_vfmadd231s:
+		return x86_insn_fp_mul;
+	case iro_amd64_divs:
+	case iro_amd64_fdiv:
+		return x86_insn_fp_div;
+	case iro_amd64_movd_gp_xmm:
+	case iro_amd64_movd_xmm_gp:
+	case iro_amd64_movdqa:
+	case iro_amd64_movdqu:
+	case iro_amd64_movs_xmm:
+	case iro_amd64_pand:
+	case iro_amd64_por:
+	case iro_amd64_punpcklbw:
+	case iro_amd64_punpckldq:
+	case iro_amd64_punpcklqdq:
+	case iro_amd64_punpcklwd:
+	case iro_amd64_pxor:
+	case iro_amd64_pxor_0:
+	case iro_amd64_xorp:
+	case iro_amd64_xorp_0:
+		return x86_insn_fp_mov;
+	default:
+		return x86_insn_alu;
+	}
+}
+
+static unsigned amd64_get_sched_info(const ir_node *node, be_sched_info_t *info)
+{
+	x86_machine_model const *const machine = amd64_cg_config.machine;
+	x86_insn_timing   const *const load    = &machine->insns[x86_insn_load];
+	if (!is_amd64_irn(node)) {
+		x86_insn_timing const *const alu = &machine->insns[x86_insn_alu];
+		info->latency    = be_is_Keep(node) ? 0 : alu->latency;
+		info->throughput = alu->throughput;
+		info->ports      = alu->ports;
+		return machine->issue_width;
+	}
+
+	x86_insn_class         const cls    = amd64_get_insn_class(node);
+	x86_insn_timing const *const timing = &machine->insns[cls];
+	info->latency    = timing->latency;
+	info->throughput = timing->throughput;
+	info->ports      = timing->ports;
+	if (amd64_loads(node)) {
+		/* a load or an operation with a memory operand */
+		if (cls == x86_insn_alu || cls == x86_insn_fp_mov) {
+			info->latency = load->latency;
+			info->ports   = load->ports;
+		} else {
+			info->latency += load->latency;
+		}
+	}
+	return machine->issue_width;
+}
+
 /** we don't have a concept of aliasing registers, so enumerate them
  * manually for the asm nodes. */
 static be_register_name_t const amd64_additional_reg_names[] = {
@@ -824,10 +1028,17 @@ arch_isa_if_t const amd64_isa_if = {
 	.init                  = amd64_init,
 	.finish                = amd64_finish,
 	.generate_code         = amd64_generate_code,
+	.generate_object       = amd64_generate_object,
+	.jit_compile           = amd64_jit_compile,
+	.emit_function         = amd64_emit_jit_function,
+	.emit_jit_stub         = amd64_emit_jit_stub,
+	.emit_jit_resolver     = amd64_emit_jit_resolver,
+	.get_resolved_config   = amd64_get_resolved_config,
 	.lower_for_target      = amd64_lower_for_target,
 	.additional_reg_names  = amd64_additional_reg_names,
 	.handle_intrinsics     = amd64_handle_intrinsics,
 	.get_op_estimated_cost = amd64_get_op_estimated_cost,
+	.get_sched_info        = amd64_get_sched_info,
 };
 
 BE_REGISTER_MODULE_CONSTRUCTOR(be_init_arch_amd64)
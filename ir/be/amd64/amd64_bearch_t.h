@@ -48,6 +48,12 @@ void amd64_cconv_init(void);
 
 void amd64_adjust_pic(ir_graph *irg);
 
+/**
+ * Loads the addresses of data entities from the address slots of the jit
+ * instead of using them as 32bit displacements.
+ */
+void amd64_adjust_jit_addresses(ir_graph *irg);
+
 void amd64_simulate_graph_x87(ir_graph *irg);
 
 #endif
@@ -221,12 +221,13 @@ static void amd64_emit_immediate64(const amd64_imm64_t *const imm)
 {
 	if (imm->kind == X86_IMM_VALUE) {
 		assert(imm->entity == NULL);
-		be_emit_irprintf("0x%" PRIX64, imm->offset);
+		be_emit_cstring("0x");
+		be_emit_hex((uint64_t)imm->offset, 0, true);
 		return;
 	}
 	x86_emit_relocation_no_offset(imm->kind, imm->entity);
 	if (imm->offset != 0)
-		be_emit_irprintf("%+" PRId64, imm->offset);
+		be_emit_signed(imm->offset, true);
 }
 
 static void amd64_emit_am(const ir_node *const node, bool indirect_star)
@@ -328,7 +329,9 @@ static void emit_shiftop(const ir_node *const node)
 
 	switch (attr->base.op_mode) {
 	case AMD64_OP_SHIFT_IMM: {
-		be_emit_irprintf("$%u, ", attr->immediate);
+		be_emit_char('$');
+		be_emit_unsigned(attr->immediate);
+		be_emit_cstring(", ");
 		const arch_register_t *reg = arch_get_irn_register_in(node, 0);
 		emit_register_mode(reg, attr->base.size);
 		return;
@@ -867,6 +870,9 @@ void amd64_emit_function(ir_graph *irg)
 	ir_reserve_resources(irg, IR_RESOURCE_IRN_LINK);
 
 	be_emit_init_cf_links(blk_sched);
+	ir_node *const cold_block = be_gas_get_cold_block(irg);
+	if (cold_block != NULL)
+		be_emit_disable_fallthrough(cold_block);
 
 	amd64_irg_data_t const *const irg_data = amd64_get_irg_data(irg);
 	omit_fp = irg_data->omit_fp;
@@ -886,6 +892,8 @@ void amd64_emit_function(ir_graph *irg)
 
 	for (size_t i = 0, n = ARR_LEN(blk_sched); i < n; ++i) {
 		ir_node *block = blk_sched[i];
+		if (block == cold_block)
+			be_gas_begin_cold_code(entity);
 		amd64_gen_block(block);
 	}
 	ir_free_resources(irg, IR_RESOURCE_IRN_LINK);
@@ -0,0 +1,1888 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2016 University of Karlsruhe.
+ */
+
+/**
+ * @file
+ * @brief       amd64 binary encoding/emission
+ */
+#include "amd64_encode.h"
+
+#include "amd64_bearch_t.h"
+#include "amd64_emitter.h"
+#include "amd64_new_nodes.h"
+#include "array.h"
+#include "beblocksched.h"
+#include "bedwarf.h"
+#include "beelf.h"
+#include "beemithlp.h"
+#include "begnuas.h"
+#include "bejit.h"
+#include "besched.h"
+#include "entity_t.h"
+#include "gen_amd64_emitter.h"
+#include "gen_amd64_regalloc_if.h"
+#include "irnodehashmap.h"
+#include "platform_t.h"
+#include "pmap.h"
+#include "tv.h"
+#include <stdint.h>
+#include <string.h>
+
+static ir_nodehashmap_t block_fragmentnum;
+static unsigned         n_block_fragments;
+/** Fragment numbers of the literals referenced by the current function. */
+static pmap            *literal_fragmentnum;
+/** Fragment numbers of the address slots of the current function. */
+static pmap            *slot_fragmentnum;
+
+/**
+ * Data emitted behind the code of a function: either the value of a
+ * literal or the absolute address of an entity.
+ */
+typedef struct literal_t {
+	ir_entity *entity;
+	bool       address_slot;
+} literal_t;
+
+/** The literals and address slots in the order of their fragment numbers. */
+static literal_t       *literals;
+
+/** Object file the code is emitted into, NULL when compiling for the jit. */
+static be_elf_writer_t *object_writer;
+
+/** A jump table, whose entries are the addresses of block fragments. */
+typedef struct jump_table_t {
+	ir_entity     *entity;
+	unsigned      *fragment_nums;
+	unsigned long  length;
+} jump_table_t;
+
+/** Jump tables of the current function in object files. */
+static jump_table_t    *jump_tables;
+
+/** A change of the call frame offset, when the frame pointer is omitted. */
+typedef struct cfa_change_t {
+	unsigned position; /**< Code position as by be_jit_get_code_position(). */
+	int      offset;
+} cfa_change_t;
+
+/** Call frame changes of the current function, if frame info is emitted. */
+static cfa_change_t    *cfa_changes;
+
+/** ELF relocation types of amd64. */
+enum {
+	R_X86_64_64       = 1,
+	R_X86_64_PC32     = 2,
+	R_X86_64_PLT32    = 4,
+	R_X86_64_GOTPCREL = 9,
+	R_X86_64_32       = 10,
+	R_X86_64_32S      = 11,
+};
+
+/** Returns the encoding for a pnc field. */
+static unsigned char pnc2cc(x86_condition_code_t cc)
+{
+	return cc & 0xf;
+}
+
+enum OpSize {
+	OP_8          = 0x00, /* 8bit operation. */
+	OP_16_32_64   = 0x01, /* 16/32/64bit operation. */
+	OP_MEM_SRC    = 0x02, /* The memory operand is in the source position. */
+	OP_IMM8       = 0x02, /* 8bit immediate, which gets sign extended. */
+	OP_16_32_IMM8 = 0x03, /* 16/32/64bit operation with sign extended 8bit immediate. */
+	OP_EAX        = 0x04, /* Short form of instruction with al/ax/eax/rax as operand. */
+};
+
+/** The mod encoding of the ModR/M */
+enum Mod {
+	MOD_IND          = 0x00, /**< [reg1] */
+	MOD_IND_BYTE_OFS = 0x40, /**< [reg1 + byte ofs] */
+	MOD_IND_WORD_OFS = 0x80, /**< [reg1 + word ofs] */
+	MOD_REG          = 0xC0  /**< reg1 */
+};
+
+/** Bits of the REX prefix */
+enum Rex {
+	REX   = 0x40,
+	REX_W = 0x08, /**< 64bit operand size */
+	REX_R = 0x04, /**< extension of the ModR/M reg field */
+	REX_X = 0x02, /**< extension of the SIB index field */
+	REX_B = 0x01, /**< extension of the ModR/M r/m or SIB base field */
+};
+
+typedef enum enc_flags_t {
+	ENC_NONE = 0,
+	ENC_W    = 1U << 0, /**< 64bit operand size */
+	ENC_BYTE = 1U << 1, /**< registers are accessed as 8bit registers */
+} enc_flags_t;
+ENUM_BITSET(enc_flags_t)
+
+/** create R/M encoding for ModR/M */
+static uint8_t ENC_RM(unsigned const regnum)
+{
+	return regnum & 7;
+}
+
+/** create REG encoding for ModR/M */
+static uint8_t ENC_REG(unsigned const regnum)
+{
+	return (regnum & 7) << 3;
+}
+
+/** create encoding for a SIB byte */
+static uint8_t ENC_SIB(uint8_t scale, unsigned index, unsigned base)
+{
+	return scale << 6 | (index & 7) << 3 | (base & 7);
+}
+
+static bool amd64_is_8bit_val(int64_t const v)
+{
+	return -128 <= v && v < 128;
+}
+
+static bool amd64_is_8bit_imm(x86_imm32_t const *const imm)
+{
+	return !imm->entity && amd64_is_8bit_val(imm->offset);
+}
+
+static enc_flags_t get_gp_flags(x86_insn_size_t const size)
+{
+	switch (size) {
+	case X86_SIZE_8:  return ENC_BYTE;
+	case X86_SIZE_16:
+	case X86_SIZE_32: return ENC_NONE;
+	case X86_SIZE_64: return ENC_W;
+	case X86_SIZE_80:
+	case X86_SIZE_128:
+		break;
+	}
+	panic("invalid insn mode");
+}
+
+static unsigned get_imm_size(x86_insn_size_t const size)
+{
+	switch (size) {
+	case X86_SIZE_8:  return 1;
+	case X86_SIZE_16: return 2;
+	case X86_SIZE_32:
+	case X86_SIZE_64: return 4;
+	case X86_SIZE_80:
+	case X86_SIZE_128:
+		break;
+	}
+	panic("invalid insn mode");
+}
+
+static void enc_size_prefix(x86_insn_size_t const size)
+{
+	if (size == X86_SIZE_16)
+		be_emit8(0x66);
+}
+
+/** Returns the mandatory prefix of the scalar SSE instructions. */
+static uint8_t get_scalar_prefix(x86_insn_size_t const size)
+{
+	switch (size) {
+	case X86_SIZE_32: return 0xF3;
+	case X86_SIZE_64: return 0xF2;
+	default:          break;
+	}
+	panic("invalid insn mode");
+}
+
+static void enc_prefix(uint8_t const prefix)
+{
+	if (prefix != 0)
+		be_emit8(prefix);
+}
+
+static void enc_segment_prefix(x86_segment_selector_t const segment)
+{
+	switch (segment) {
+	case X86_SEGMENT_DEFAULT:                  return;
+	case X86_SEGMENT_CS:      be_emit8(0x2E); return;
+	case X86_SEGMENT_SS:      be_emit8(0x36); return;
+	case X86_SEGMENT_DS:      be_emit8(0x3E); return;
+	case X86_SEGMENT_ES:      be_emit8(0x26); return;
+	case X86_SEGMENT_FS:      be_emit8(0x64); return;
+	case X86_SEGMENT_GS:      be_emit8(0x65); return;
+	}
+	panic("invalid segment");
+}
+
+/** spl, bpl, sil and dil are only accessible with a REX prefix. */
+static bool needs_rex_for_byte(enc_flags_t const flags,
+                               arch_register_t const *const reg)
+{
+	return (flags & ENC_BYTE) && reg != NULL
+	    && reg->encoding >= 4 && reg->encoding < 8;
+}
+
+/** Emits a REX prefix if the instruction needs one. */
+static void enc_rex(enc_flags_t const flags, unsigned const r,
+                    unsigned const x, unsigned const b, bool const force)
+{
+	uint8_t rex = 0;
+	if (flags & ENC_W)
+		rex |= REX_W;
+	if (r & 8)
+		rex |= REX_R;
+	if (x & 8)
+		rex |= REX_X;
+	if (b & 8)
+		rex |= REX_B;
+	if (rex != 0 || force)
+		be_emit8(REX | rex);
+}
+
+/** Emits a one, two (0x0Fxx) or three (0x0F38xx) byte opcode. */
+static void enc_opcode(unsigned const opcode)
+{
+	if (opcode > 0xFFFF)
+		be_emit8(opcode >> 16);
+	if (opcode > 0xFF)
+		be_emit8(opcode >> 8);
+	be_emit8(opcode);
+}
+
+/**
+ * Emits the opcode and a ModR/M byte with two register operands. The reg
+ * field contains @p reg or the opcode extension @p ext if @p reg is NULL.
+ */
+static void enc_rr(enc_flags_t const flags, unsigned const opcode,
+                   arch_register_t const *const reg, unsigned const ext,
+                   arch_register_t const *const rm)
+{
+	unsigned const reg_enc = reg ? reg->encoding : ext;
+	bool     const force   = needs_rex_for_byte(flags, reg)
+	                      || needs_rex_for_byte(flags, rm);
+	enc_rex(flags, reg_enc, 0, rm->encoding, force);
+	enc_opcode(opcode);
+	be_emit8(MOD_REG | ENC_REG(reg_enc) | ENC_RM(rm->encoding));
+}
+
+/** Emits an opcode, which contains the register number in its low bits. */
+static void enc_opreg(enc_flags_t const flags, uint8_t const opcode,
+                      arch_register_t const *const reg)
+{
+	enc_rex(flags, 0, 0, reg->encoding, needs_rex_for_byte(flags, reg));
+	be_emit8(opcode + ENC_RM(reg->encoding));
+}
+
+/**
+ * Private constant entities, which got no address from the user, are
+ * emitted behind the function code and addressed relative to the
+ * instruction pointer. This covers the floating point constants of the
+ * backend.
+ */
+bool amd64_is_jit_literal(ir_entity const *const entity)
+{
+	if (get_entity_kind(entity) != IR_ENTITY_NORMAL
+	 || get_entity_visibility(entity) != ir_visibility_private
+	 || !(get_entity_linkage(entity) & IR_LINKAGE_CONSTANT)
+	 || be_jit_get_entity_addr(entity) != (void const*)-1)
+		return false;
+	ir_initializer_t const *const initializer
+		= get_entity_initializer(entity);
+	return initializer != NULL
+	    && get_initializer_kind(initializer) == IR_INITIALIZER_TARVAL;
+}
+
+static bool is_literal(ir_entity const *const entity)
+{
+	/* object files contain the constants as regular data */
+	return object_writer == NULL && amd64_is_jit_literal(entity);
+}
+
+static unsigned get_fragment_num(pmap *const map, ir_entity *const entity,
+                                 bool const address_slot)
+{
+	void *const num = pmap_get(void, map, entity);
+	if (num != NULL)
+		return PTR_TO_INT(num) - 1;
+
+	unsigned  const res     = n_block_fragments + ARR_LEN(literals);
+	literal_t const literal = { entity, address_slot };
+	ARR_APP1(literal_t, literals, literal);
+	pmap_insert(map, entity, INT_TO_PTR(res + 1));
+	return res;
+}
+
+static unsigned get_literal_fragment_num(ir_entity *const entity)
+{
+	return get_fragment_num(literal_fragmentnum, entity, false);
+}
+
+/**
+ * Returns the fragment of an 8 byte slot containing the address of
+ * @p entity. Code and entity may be further apart than 32bit displacements
+ * reach, so calls and GOT accesses go through such a slot.
+ */
+static unsigned get_slot_fragment_num(ir_entity *const entity)
+{
+	return get_fragment_num(slot_fragmentnum, entity, true);
+}
+
+static void enc_relocation(x86_imm32_t const *const imm)
+{
+	ir_entity *const entity = imm->entity;
+	int32_t    const offset = imm->offset;
+	if (entity == NULL) {
+		be_emit32(offset);
+		return;
+	}
+
+	if (imm->kind != X86_IMM_ADDR)
+		panic("relocation kind %s not supported in jit mode",
+		      x86_get_immediate_kind_str(imm->kind));
+	be_emit_reloc_entity(4, X86_IMM_ADDR, entity, offset);
+}
+
+/**
+ * Emits a displacement relative to the instruction pointer. @p imm_size
+ * bytes of immediate follow the displacement.
+ */
+static void enc_rip_relocation(x86_imm32_t const *const imm,
+                               unsigned const imm_size)
+{
+	ir_entity *const entity = imm->entity;
+	int32_t    const offset = imm->offset - 4 - imm_size;
+	if (entity == NULL)
+		panic("instruction pointer relative address without entity");
+
+	if (is_literal(entity)) {
+		unsigned const fragment_num = get_literal_fragment_num(entity);
+		be_emit_reloc_fragment(4, AMD64_RELOCATION_RELJUMP, fragment_num,
+		                       offset);
+		return;
+	}
+
+	switch (imm->kind) {
+	case X86_IMM_ADDR:
+	case X86_IMM_PCREL:
+	case X86_IMM_PLT:
+		be_emit_reloc_entity(4, X86_IMM_PCREL, entity, offset);
+		return;
+	case X86_IMM_GOTPCREL: {
+		if (object_writer != NULL) {
+			be_emit_reloc_entity(4, X86_IMM_GOTPCREL, entity, offset);
+			return;
+		}
+		/* the address slot takes the role of the GOT entry */
+		unsigned const fragment_num = get_slot_fragment_num(entity);
+		be_emit_reloc_fragment(4, AMD64_RELOCATION_RELJUMP, fragment_num,
+		                       -4 - (int32_t)imm_size);
+		return;
+	}
+	default:
+		break;
+	}
+	panic("relocation kind %s not supported in jit mode",
+	      x86_get_immediate_kind_str(imm->kind));
+}
+
+static arch_register_t const *get_addr_base(ir_node const *const node,
+                                            x86_addr_t const *const addr)
+{
+	if (!x86_addr_variant_has_base(addr->variant))
+		return NULL;
+	return arch_get_irn_register_in(node, addr->base_input);
+}
+
+static arch_register_t const *get_addr_index(ir_node const *const node,
+                                             x86_addr_t const *const addr)
+{
+	if (!x86_addr_variant_has_index(addr->variant))
+		return NULL;
+	return arch_get_irn_register_in(node, addr->index_input);
+}
+
+static bool is_rip_relative(x86_addr_t const *const addr)
+{
+	x86_addr_variant_t const variant = addr->variant;
+	if (variant == X86_ADDR_RIP)
+		return true;
+	/* absolute addresses of literals are turned into RIP relative ones */
+	ir_entity const *const entity = addr->immediate.entity;
+	return variant == X86_ADDR_JUST_IMM && entity != NULL
+	    && is_literal(entity);
+}
+
+/**
+ * Emit an address mode.
+ *
+ * @param reg       content of the reg field: either a register index or an
+ *                  opcode extension
+ * @param imm_size  size of an immediate following the address
+ */
+static void enc_mod_addr(unsigned const reg, ir_node const *const node,
+                         x86_addr_t const *const addr, unsigned const imm_size)
+{
+	x86_imm32_t const *const imm = &addr->immediate;
+	if (is_rip_relative(addr)) {
+		be_emit8(MOD_IND | ENC_REG(reg) | ENC_RM(0x05));
+		enc_rip_relocation(imm, imm_size);
+		return;
+	}
+
+	arch_register_t const *const base  = get_addr_base(node, addr);
+	arch_register_t const *const index = get_addr_index(node, addr);
+	if (base == NULL) {
+		/* Without base register there is always a 32bit offset. The
+		 * encoding of rbp as base means no base register in the SIB byte. */
+		unsigned const index_enc = index ? index->encoding : 0x04;
+		be_emit8(MOD_IND | ENC_REG(reg) | ENC_RM(0x04));
+		be_emit8(ENC_SIB(addr->log_scale, index_enc, 0x05));
+		enc_relocation(imm);
+		return;
+	}
+
+	/* set the mod part depending on displacement */
+	int32_t  const offset   = imm->offset;
+	unsigned const base_enc = base->encoding;
+	uint8_t        modrm;
+	unsigned       emitoffs;
+	if (imm->entity) {
+		modrm    = MOD_IND_WORD_OFS;
+		emitoffs = 32;
+	} else if (offset == 0 && ENC_RM(base_enc) != 0x05) {
+		/* rbp and r13 without offset is the encoding for RIP relative
+		 * addresses, so they need an 8bit offset */
+		modrm    = MOD_IND;
+		emitoffs = 0;
+	} else if (amd64_is_8bit_val(offset)) {
+		modrm    = MOD_IND_BYTE_OFS;
+		emitoffs = 8;
+	} else {
+		modrm    = MOD_IND_WORD_OFS;
+		emitoffs = 32;
+	}
+
+	modrm |= ENC_REG(reg);
+	if (index != NULL) {
+		be_emit8(modrm | ENC_RM(0x04));
+		be_emit8(ENC_SIB(addr->log_scale, index->encoding, base_enc));
+	} else if (ENC_RM(base_enc) == 0x04) {
+		/* r/m set to rsp means SIB, so rsp and r12 as base need a SIB byte
+		 * without index register */
+		be_emit8(modrm | ENC_RM(0x04));
+		be_emit8(ENC_SIB(0, 0x04, base_enc));
+	} else {
+		be_emit8(modrm | ENC_RM(base_enc));
+	}
+
+	/* emit displacement */
+	if (emitoffs == 8) {
+		be_emit8((uint8_t)offset);
+	} else if (emitoffs == 32) {
+		enc_relocation(imm);
+	}
+}
+
+/**
+ * Emits the opcode, ModR/M, SIB and displacement for a memory operand. The
+ * reg field contains @p reg or the opcode extension @p ext if @p reg is NULL.
+ */
+static void enc_rm(enc_flags_t const flags, unsigned const opcode,
+                   arch_register_t const *const reg, unsigned const ext,
+                   ir_node const *const node, x86_addr_t const *const addr,
+                   unsigned const imm_size)
+{
+	enc_segment_prefix((x86_segment_selector_t)addr->segment);
+
+	unsigned const reg_enc = reg ? reg->encoding : ext;
+	unsigned       x       = 0;
+	unsigned       b       = 0;
+	if (!is_rip_relative(addr)) {
+		arch_register_t const *const base  = get_addr_base(node, addr);
+		arch_register_t const *const index = get_addr_index(node, addr);
+		if (base != NULL)
+			b = base->encoding;
+		if (index != NULL)
+			x = index->encoding;
+	}
+	enc_rex(flags, reg_enc, x, b, needs_rex_for_byte(flags, reg));
+	enc_opcode(opcode);
+	enc_mod_addr(reg_enc, node, addr, imm_size);
+}
+
+/** Emits the source operand of an instruction with a register or an address
+ * operand. */
+static void enc_am(enc_flags_t const flags, unsigned const opcode,
+                   arch_register_t const *const reg, unsigned const ext,
+                   ir_node const *const node)
+{
+	amd64_addr_attr_t const *const attr = get_amd64_addr_attr_const(node);
+	x86_addr_t        const *const addr = &attr->addr;
+	switch ((amd64_op_mode_t)attr->base.op_mode) {
+	case AMD64_OP_REG: {
+		arch_register_t const *const rm
+			= arch_get_irn_register_in(node, addr->base_input);
+		enc_rr(flags, opcode, reg, ext, rm);
+		return;
+	}
+	case AMD64_OP_ADDR:
+		enc_rm(flags, opcode, reg, ext, node, addr, 0);
+		return;
+	default:
+		break;
+	}
+	panic("invalid op_mode");
+}
+
+static void enc_imm(x86_imm32_t const *const imm, x86_insn_size_t const size)
+{
+	switch (size) {
+	case X86_SIZE_8:  be_emit8(imm->offset);  return;
+	case X86_SIZE_16: be_emit16(imm->offset); return;
+	case X86_SIZE_32:
+	case X86_SIZE_64: enc_relocation(imm);    return;
+	case X86_SIZE_80:
+	case X86_SIZE_128:
+		break;
+	}
+	panic("Invalid size");
+}
+
+static void enc_jmp_destination(ir_node const *const cfop)
+{
+	assert(get_irn_mode(cfop) == mode_X);
+	ir_node const *const dest_block = be_emit_get_cfop_target(cfop);
+	unsigned const fragment_num
+		= PTR_TO_INT(ir_nodehashmap_get(void, &block_fragmentnum, dest_block));
+	be_emit_reloc_fragment(4, AMD64_RELOCATION_RELJUMP, fragment_num, -4);
+}
+
+/* end emit routines, all emitters following here should only use the functions
+   above. */
+
+void amd64_enc_simple(uint8_t const opcode)
+{
+	be_emit8(opcode);
+}
+
+void amd64_enc_binop(ir_node const *const node, uint8_t const code)
+{
+	amd64_binop_addr_attr_t const *const attr
+		= get_amd64_binop_addr_attr_const(node);
+	x86_addr_t      const *const addr  = &attr->base.addr;
+	x86_insn_size_t        const size  = attr->base.base.size;
+	enc_flags_t            const flags = get_gp_flags(size);
+	uint8_t                      op    = size == X86_SIZE_8 ? OP_8 : OP_16_32_64;
+
+	enc_size_prefix(size);
+	switch ((amd64_op_mode_t)attr->base.base.op_mode) {
+	case AMD64_OP_REG_REG: {
+		arch_register_t const *const dst
+			= arch_get_irn_register_in(node, addr->base_input);
+		arch_register_t const *const src = arch_get_irn_register_in(node, 1);
+		enc_rr(flags, code << 3 | op, src, 0, dst);
+		return;
+	}
+	case AMD64_OP_REG_ADDR: {
+		arch_register_t const *const dst
+			= arch_get_irn_register_in(node, attr->u.reg_input);
+		enc_rm(flags, code << 3 | OP_MEM_SRC | op, dst, 0, node, addr, 0);
+		return;
+	}
+	case AMD64_OP_ADDR_REG: {
+		arch_register_t const *const src
+			= arch_get_irn_register_in(node, attr->u.reg_input);
+		enc_rm(flags, code << 3 | op, src, 0, node, addr, 0);
+		return;
+	}
+	case AMD64_OP_REG_IMM: {
+		arch_register_t const *const dst
+			= arch_get_irn_register_in(node, addr->base_input);
+		x86_imm32_t const *const imm      = &attr->u.immediate;
+		x86_insn_size_t          imm_size = size;
+		/* Try to use the short form with 8bit sign extended immediate. */
+		if (op != OP_8 && amd64_is_8bit_imm(imm)) {
+			op       = OP_16_32_IMM8;
+			imm_size = X86_SIZE_8;
+		}
+		if (op != OP_16_32_IMM8 && dst->index == REG_GP_RAX) {
+			enc_opreg(flags, code << 3 | OP_EAX | op, dst);
+		} else {
+			enc_rr(flags, 0x80 | op, NULL, code, dst);
+		}
+		enc_imm(imm, imm_size);
+		return;
+	}
+	case AMD64_OP_ADDR_IMM: {
+		x86_imm32_t const *const imm      = &attr->u.immediate;
+		x86_insn_size_t          imm_size = size;
+		if (op != OP_8 && amd64_is_8bit_imm(imm)) {
+			op       = OP_16_32_IMM8;
+			imm_size = X86_SIZE_8;
+		}
+		enc_rm(flags, 0x80 | op, NULL, code, node, addr,
+		       get_imm_size(imm_size));
+		enc_imm(imm, imm_size);
+		return;
+	}
+	default:
+		break;
+	}
+	panic("invalid op_mode");
+}
+
+void amd64_enc_unop(ir_node const *const node, uint8_t const code,
+                    uint8_t const ext)
+{
+	x86_insn_size_t const size = get_amd64_attr_const(node)->size;
+	enc_size_prefix(size);
+	uint8_t const op = size == X86_SIZE_8 ? OP_8 : OP_16_32_64;
+	enc_am(get_gp_flags(size), code | op, NULL, ext, node);
+}
+
+void amd64_enc_shiftop(ir_node const *const node, uint8_t const ext)
+{
+	amd64_shift_attr_t const *const attr = get_amd64_shift_attr_const(node);
+	x86_insn_size_t        const size  = attr->base.size;
+	enc_flags_t            const flags = get_gp_flags(size);
+	uint8_t                const op    = size == X86_SIZE_8 ? OP_8 : OP_16_32_64;
+	arch_register_t const *const reg   = arch_get_irn_register_in(node, 0);
+
+	enc_size_prefix(size);
+	switch (attr->base.op_mode) {
+	case AMD64_OP_SHIFT_IMM:
+		if (attr->immediate == 1) {
+			enc_rr(flags, 0xD0 | op, NULL, ext, reg);
+		} else {
+			enc_rr(flags, 0xC0 | op, NULL, ext, reg);
+			be_emit8(attr->immediate);
+		}
+		return;
+	case AMD64_OP_SHIFT_REG:
+		enc_rr(flags, 0xD2 | op, NULL, ext, reg);
+		return;
+	default:
+		break;
+	}
+	panic("invalid op_mode for shiftop");
+}
+
+void amd64_enc_0f_unop_reg(ir_node const *const node, uint8_t const code)
+{
+	x86_insn_size_t const size = get_amd64_attr_const(node)->size;
+	arch_register_t const *const out = arch_get_irn_register_out(node, 0);
+	enc_size_prefix(size);
+	enc_am(get_gp_flags(size), 0x0F00 | code, out, 0, node);
+}
+
+static void enc_xmm_binop(ir_node const *const node, uint8_t const prefix,
+                          uint8_t const code)
+{
+	amd64_binop_addr_attr_t const *const attr
+		= get_amd64_binop_addr_attr_const(node);
+	x86_addr_t const *const addr = &attr->base.addr;
+	enc_prefix(prefix);
+	switch ((amd64_op_mode_t)attr->base.base.op_mode) {
+	case AMD64_OP_REG_REG: {
+		arch_register_t const *const dst
+			= arch_get_irn_register_in(node, addr->base_input);
+		arch_register_t const *const src = arch_get_irn_register_in(node, 1);
+		enc_rr(ENC_NONE, 0x0F00 | code, dst, 0, src);
+		return;
+	}
+	case AMD64_OP_REG_ADDR: {
+		arch_register_t const *const dst
+			= arch_get_irn_register_in(node, attr->u.reg_input);
+		enc_rm(ENC_NONE, 0x0F00 | code, dst, 0, node, addr, 0);
+		return;
+	}
+	default:
+		break;
+	}
+	panic("invalid op_mode");
+}
+
+void amd64_enc_xmm_scalar(ir_node const *const node, uint8_t const code)
+{
+	x86_insn_size_t const size = get_amd64_attr_const(node)->size;
+	enc_xmm_binop(node, get_scalar_prefix(size), code);
+}
+
+void amd64_enc_xmm_binop(ir_node const *const node, uint8_t const prefix,
+                         uint8_t const code)
+{
+	enc_xmm_binop(node, prefix, code);
+}
+
+static void enc_xmm_unop(ir_node const *const node, uint8_t const prefix,
+                         enc_flags_t const flags, uint8_t const code)
+{
+	arch_register_t const *const out = arch_get_irn_register_out(node, 0);
+	enc_prefix(prefix);
+	enc_am(flags, 0x0F00 | code, out, 0, node);
+}
+
+void amd64_enc_xmm_unop(ir_node const *const node, uint8_t const prefix,
+                        uint8_t const code)
+{
+	enc_xmm_unop(node, prefix, ENC_NONE, code);
+}
+
+void amd64_enc_xmm_conv(ir_node const *const node, uint8_t const prefix,
+                        uint8_t const code)
+{
+	x86_insn_size_t const size  = get_amd64_attr_const(node)->size;
+	enc_flags_t     const flags = size == X86_SIZE_64 ? ENC_W : ENC_NONE;
+	enc_xmm_unop(node, prefix, flags, code);
+}
+
+static void enc_mov(arch_register_t const *const src,
+                    arch_register_t const *const dst)
+{
+	enc_rr(ENC_W, 0x88 | OP_16_32_64, src, 0, dst); // movq %src, %dst
+}
+
+static void enc_copy(ir_node const *const node)
+{
+	arch_register_t const *const in  = arch_get_irn_register_in(node, 0);
+	arch_register_t const *const out = arch_get_irn_register_out(node, 0);
+	if (in == out)
+		return;
+
+	arch_register_class_t const *const cls = out->cls;
+	if (cls == &amd64_reg_classes[CLASS_amd64_gp]) {
+		enc_mov(in, out);
+	} else if (cls == &amd64_reg_classes[CLASS_amd64_xmm]) {
+		be_emit8(0x66); // movapd %in, %out
+		enc_rr(ENC_NONE, 0x0F28, out, 0, in);
+	} else if (cls == &amd64_reg_classes[CLASS_amd64_x87]) {
+		/* nothing to do */
+	} else {
+		panic("move not supported for this register class");
+	}
+}
+
+static void enc_pxor(arch_register_t const *const src,
+                     arch_register_t const *const dst)
+{
+	be_emit8(0x66);
+	enc_rr(ENC_NONE, 0x0FEF, dst, 0, src); // pxor %src, %dst
+}
+
+static void enc_perm(ir_node const *const node)
+{
+	arch_register_t const *const reg0 = arch_get_irn_register_out(node, 0);
+	arch_register_t const *const reg1 = arch_get_irn_register_out(node, 1);
+
+	arch_register_class_t const *const cls = reg0->cls;
+	assert(cls == reg1->cls && "Register class mismatch at Perm");
+
+	if (cls == &amd64_reg_classes[CLASS_amd64_gp]) {
+		if (reg0->index == REG_GP_RAX) {
+			enc_opreg(ENC_W, 0x90, reg1); // xchgq %rax, %reg1
+		} else if (reg1->index == REG_GP_RAX) {
+			enc_opreg(ENC_W, 0x90, reg0); // xchgq %reg0, %rax
+		} else {
+			enc_rr(ENC_W, 0x86 | OP_16_32_64, reg0, 0, reg1);
+		}
+	} else if (cls == &amd64_reg_classes[CLASS_amd64_xmm]) {
+		enc_pxor(reg0, reg1);
+		enc_pxor(reg1, reg0);
+		enc_pxor(reg0, reg1);
+	} else {
+		panic("unexpected register class in be_Perm (%+F)", node);
+	}
+}
+
+static void enc_incsp(ir_node const *const node)
+{
+	int offs = be_get_IncSP_offset(node);
+	if (offs == 0)
+		return;
+
+	unsigned ext;
+	if (offs > 0) {
+		ext = 5; /* sub */
+	} else {
+		ext = 0; /* add */
+		offs = -offs;
+	}
+
+	arch_register_t const *const reg   = arch_get_irn_register_out(node, 0);
+	bool                   const imm8b = amd64_is_8bit_val(offs);
+	enc_rr(ENC_W, 0x80 | (imm8b ? OP_16_32_IMM8 : OP_16_32_64), NULL, ext, reg);
+	if (imm8b) {
+		be_emit8(offs);
+	} else {
+		be_emit32(offs);
+	}
+}
+
+static void enc_push_am(ir_node const *const node)
+{
+	amd64_addr_attr_t const *const attr = get_amd64_addr_attr_const(node);
+	enc_size_prefix(attr->base.size);
+	enc_rm(ENC_NONE, 0xFF, NULL, 6, node, &attr->addr, 0);
+}
+
+static void enc_push_reg(ir_node const *const node)
+{
+	enc_size_prefix(get_amd64_attr_const(node)->size);
+	enc_opreg(ENC_NONE, 0x50, arch_get_irn_register_in(node, 2));
+}
+
+static void enc_pop_am(ir_node const *const node)
+{
+	amd64_addr_attr_t const *const attr = get_amd64_addr_attr_const(node);
+	enc_size_prefix(attr->base.size);
+	enc_rm(ENC_NONE, 0x8F, NULL, 0, node, &attr->addr, 0);
+}
+
+static void enc_sub_sp(ir_node const *const node)
+{
+	/* subq %in, %rsp */
+	amd64_enc_binop(node, 5);
+	/* movq %rsp, %out */
+	arch_register_t const *const out
+		= arch_get_irn_register_out(node, pn_amd64_sub_sp_addr);
+	enc_mov(&amd64_registers[REG_RSP], out);
+}
+
+static void enc_cqto(ir_node const *const node)
+{
+	(void)node;
+	be_emit8(REX | REX_W);
+	be_emit8(0x99);
+}
+
+static void enc_imul(ir_node const *const node)
+{
+	amd64_binop_addr_attr_t const *const attr
+		= get_amd64_binop_addr_attr_const(node);
+	x86_addr_t      const *const addr  = &attr->base.addr;
+	x86_insn_size_t        const size  = attr->base.base.size;
+	enc_flags_t            const flags = get_gp_flags(size);
+
+	enc_size_prefix(size);
+	switch ((amd64_op_mode_t)attr->base.base.op_mode) {
+	case AMD64_OP_REG_REG: {
+		arch_register_t const *const dst
+			= arch_get_irn_register_in(node, addr->base_input);
+		arch_register_t const *const src = arch_get_irn_register_in(node, 1);
+		enc_rr(flags, 0x0FAF, dst, 0, src);
+		return;
+	}
+	case AMD64_OP_REG_ADDR: {
+		arch_register_t const *const dst
+			= arch_get_irn_register_in(node, attr->u.reg_input);
+		enc_rm(flags, 0x0FAF, dst, 0, node, addr, 0);
+		return;
+	}
+	case AMD64_OP_REG_IMM: {
+		arch_register_t const *const dst
+			= arch_get_irn_register_in(node, addr->base_input);
+		x86_imm32_t const *const imm  = &attr->u.immediate;
+		bool               const imm8 = amd64_is_8bit_imm(imm);
+		enc_rr(flags, 0x69 | (imm8 ? OP_IMM8 : 0), dst, 0, dst);
+		enc_imm(imm, imm8 ? X86_SIZE_8 : size);
+		return;
+	}
+	default:
+		break;
+	}
+	panic("invalid op_mode");
+}
+
+static void enc_test(ir_node const *const node)
+{
+	amd64_binop_addr_attr_t const *const attr
+		= get_amd64_binop_addr_attr_const(node);
+	x86_addr_t      const *const addr  = &attr->base.addr;
+	x86_insn_size_t        const size  = attr->base.base.size;
+	enc_flags_t            const flags = get_gp_flags(size);
+	uint8_t                const op    = size == X86_SIZE_8 ? OP_8 : OP_16_32_64;
+
+	enc_size_prefix(size);
+	switch ((amd64_op_mode_t)attr->base.base.op_mode) {
+	case AMD64_OP_REG_REG: {
+		arch_register_t const *const left
+			= arch_get_irn_register_in(node, addr->base_input);
+		arch_register_t const *const right = arch_get_irn_register_in(node, 1);
+		enc_rr(flags, 0x84 | op, right, 0, left);
+		return;
+	}
+	case AMD64_OP_REG_ADDR:
+	case AMD64_OP_ADDR_REG: {
+		arch_register_t const *const reg
+			= arch_get_irn_register_in(node, attr->u.reg_input);
+		enc_rm(flags, 0x84 | op, reg, 0, node, addr, 0);
+		return;
+	}
+	case AMD64_OP_REG_IMM: {
+		arch_register_t const *const reg
+			= arch_get_irn_register_in(node, addr->base_input);
+		if (reg->index == REG_GP_RAX) {
+			enc_opreg(flags, 0xA8 | op, reg);
+		} else {
+			enc_rr(flags, 0xF6 | op, NULL, 0, reg);
+		}
+		enc_imm(&attr->u.immediate, size);
+		return;
+	}
+	case AMD64_OP_ADDR_IMM:
+		enc_rm(flags, 0xF6 | op, NULL, 0, node, addr, get_imm_size(size));
+		enc_imm(&attr->u.immediate, size);
+		return;
+	default:
+		break;
+	}
+	panic("invalid op_mode");
+}
+
+static void enc_xor_0(ir_node const *const node)
+{
+	arch_register_t const *const out = arch_get_irn_register_out(node, 0);
+	enc_rr(ENC_NONE, 0x30 | OP_16_32_64, out, 0, out); // xorl %out, %out
+}
+
+static void enc_mov_imm(ir_node const *const node)
+{
+	amd64_movimm_attr_t const *const attr = get_amd64_movimm_attr_const(node);
+	amd64_imm64_t       const *const imm  = &attr->immediate;
+	arch_register_t     const *const out  = arch_get_irn_register_out(node, 0);
+	if (imm->entity != NULL) {
+		/* the address may not fit into 32 bits */
+		assert(imm->kind == X86_IMM_ADDR);
+		enc_opreg(ENC_W, 0xB8, out); // movabsq $imm, %out
+		be_emit_reloc_entity(8, AMD64_RELOCATION_ABS64, imm->entity,
+		                     imm->offset);
+		return;
+	}
+
+	uint64_t const val = imm->offset;
+	if (attr->base.size != X86_SIZE_64 || val <= UINT32_MAX) {
+		enc_opreg(ENC_NONE, 0xB8, out); // movl $imm, %out
+		be_emit32(val);
+	} else if ((int64_t)val == (int32_t)val) {
+		enc_rr(ENC_W, 0xC6 | OP_16_32_64, NULL, 0, out); // movq $imm, %out
+		be_emit32(val);
+	} else {
+		enc_opreg(ENC_W, 0xB8, out); // movabsq $imm, %out
+		be_emit32(val);
+		be_emit32(val >> 32);
+	}
+}
+
+static void enc_movs(ir_node const *const node)
+{
+	arch_register_t const *const out  = arch_get_irn_register_out(node, 0);
+	x86_insn_size_t        const size = get_amd64_attr_const(node)->size;
+	switch (size) {
+	case X86_SIZE_8:  enc_am(ENC_W, 0x0FBE, out, 0, node); return;
+	case X86_SIZE_16: enc_am(ENC_W, 0x0FBF, out, 0, node); return;
+	case X86_SIZE_32: enc_am(ENC_W, 0x63,   out, 0, node); return;
+	case X86_SIZE_64:
+	case X86_SIZE_80:
+	case X86_SIZE_128:
+		break;
+	}
+	panic("invalid insn mode");
+}
+
+static void enc_mov_gp(ir_node const *const node)
+{
+	arch_register_t const *const out  = arch_get_irn_register_out(node, 0);
+	x86_insn_size_t        const size = get_amd64_attr_const(node)->size;
+	switch (size) {
+	case X86_SIZE_8:  enc_am(ENC_BYTE, 0x0FB6, out, 0, node); return;
+	case X86_SIZE_16: enc_am(ENC_NONE, 0x0FB7, out, 0, node); return;
+	case X86_SIZE_32: enc_am(ENC_NONE, 0x8B,   out, 0, node); return;
+	case X86_SIZE_64: enc_am(ENC_W,    0x8B,   out, 0, node); return;
+	case X86_SIZE_80:
+	case X86_SIZE_128:
+		break;
+	}
+	panic("invalid insn mode");
+}
+
+static void enc_mov_store(ir_node const *const node)
+{
+	amd64_binop_addr_attr_t const *const attr
+		= get_amd64_binop_addr_attr_const(node);
+	x86_addr_t      const *const addr  = &attr->base.addr;
+	x86_insn_size_t        const size  = attr->base.base.size;
+	enc_flags_t            const flags = get_gp_flags(size);
+	uint8_t                const op    = size == X86_SIZE_8 ? OP_8 : OP_16_32_64;
+
+	enc_size_prefix(size);
+	switch ((amd64_op_mode_t)attr->base.base.op_mode) {
+	case AMD64_OP_ADDR_REG: {
+		arch_register_t const *const val
+			= arch_get_irn_register_in(node, attr->u.reg_input);
+		enc_rm(flags, 0x88 | op, val, 0, node, addr, 0);
+		return;
+	}
+	case AMD64_OP_ADDR_IMM:
+		enc_rm(flags, 0xC6 | op, NULL, 0, node, addr, get_imm_size(size));
+		enc_imm(&attr->u.immediate, size);
+		return;
+	default:
+		break;
+	}
+	panic("invalid op_mode");
+}
+
+static void enc_lea(ir_node const *const node)
+{
+	amd64_addr_attr_t const *const attr = get_amd64_addr_attr_const(node);
+	arch_register_t   const *const out  = arch_get_irn_register_out(node, 0);
+	x86_insn_size_t          const size = attr->base.size;
+	enc_size_prefix(size);
+	enc_rm(get_gp_flags(size), 0x8D, out, 0, node, &attr->addr, 0);
+}
+
+static void enc_setcc(ir_node const *const node)
+{
+	x86_condition_code_t   const cc  = get_amd64_cc_attr_const(node)->cc;
+	arch_register_t const *const out = arch_get_irn_register_out(node, 0);
+	enc_rr(ENC_BYTE, 0x0F90 | pnc2cc(cc), NULL, 0, out);
+}
+
+static void enc_cmpxchg(ir_node const *const node)
+{
+	amd64_binop_addr_attr_t const *const attr
+		= get_amd64_binop_addr_attr_const(node);
+	x86_insn_size_t        const size = attr->base.base.size;
+	arch_register_t const *const val
+		= arch_get_irn_register_in(node, attr->u.reg_input);
+	assert(attr->base.base.op_mode == AMD64_OP_ADDR_REG);
+
+	be_emit8(0xF0); // lock
+	enc_size_prefix(size);
+	enc_rm(get_gp_flags(size), 0x0FB0 | (size == X86_SIZE_8 ? OP_8 : OP_16_32_64),
+	       val, 0, node, &attr->base.addr, 0);
+}
+
+static void enc_call_or_jmp(ir_node const *const node, uint8_t const ext)
+{
+	amd64_addr_attr_t const *const attr = get_amd64_addr_attr_const(node);
+	if (attr->base.op_mode == AMD64_OP_IMM32) {
+		x86_imm32_t const *const imm = &attr->addr.immediate;
+		if (imm->entity == NULL || imm->offset != 0)
+			panic("unexpected call destination in %+F", node);
+		if (object_writer != NULL) {
+			/* the linker redirects the call through the PLT if needed */
+			be_emit8(ext == 2 ? 0xE8 : 0xE9); // call/jmp rel32
+			be_emit_reloc_entity(4, X86_IMM_PLT, imm->entity, -4);
+			return;
+		}
+		/* The destination may be out of reach of a 32bit displacement, so
+		 * jump indirectly through an address slot. */
+		unsigned const fragment_num = get_slot_fragment_num(imm->entity);
+		be_emit8(0xFF);
+		be_emit8(MOD_IND | ENC_REG(ext) | ENC_RM(0x05));
+		be_emit_reloc_fragment(4, AMD64_RELOCATION_RELJUMP, fragment_num, -4);
+	} else {
+		enc_am(ENC_NONE, 0xFF, NULL, ext, node);
+	}
+}
+
+static void enc_call(ir_node const *const node)
+{
+	enc_call_or_jmp(node, 2);
+}
+
+static void enc_ijmp(ir_node const *const node)
+{
+	enc_call_or_jmp(node, 4);
+}
+
+static void enc_jmp(ir_node const *const cfop)
+{
+	be_emit8(0xE9);
+	enc_jmp_destination(cfop);
+}
+
+static void enc_jump(ir_node const *const node)
+{
+	if (!be_is_fallthrough(node))
+		enc_jmp(node);
+}
+
+static void enc_jcc(x86_condition_code_t const cc, ir_node const *const cfop)
+{
+	be_emit8(0x0F);
+	be_emit8(0x80 | pnc2cc(cc));
+	enc_jmp_destination(cfop);
+}
+
+static x86_condition_code_t determine_final_cc(ir_node const *const flags,
+                                               x86_condition_code_t cc)
+{
+	if (is_amd64_fucomi(flags)) {
+		amd64_x87_attr_t const *const attr = get_amd64_x87_attr_const(flags);
+		if (attr->x87.reverse)
+			cc = x86_invert_condition_code(cc);
+	}
+	return cc;
+}
+
+static void enc_amd64_jcc(ir_node const *const node)
+{
+	ir_node         const *const flags = get_irn_n(node, n_amd64_jcc_flags);
+	amd64_cc_attr_t const *const attr  = get_amd64_cc_attr_const(node);
+	x86_condition_code_t         cc    = determine_final_cc(flags, attr->cc);
+
+	be_cond_branch_projs_t projs = be_get_cond_branch_projs(node);
+	if (be_is_fallthrough(projs.t)) {
+		/* exchange both proj's so the second one can be omitted */
+		ir_node *const t = projs.t;
+		projs.t = projs.f;
+		projs.f = t;
+		cc      = x86_negate_condition_code(cc);
+	}
+
+	if (cc & x86_cc_float_parity_cases) {
+		/* Some floating point comparisons require a test of the parity flag,
+		 * which indicates that the result is unordered */
+		enc_jcc(x86_cc_parity, cc & x86_cc_negated ? projs.t : projs.f);
+	}
+	enc_jcc(cc, projs.t);
+
+	/* the second Proj might be a fallthrough */
+	enc_jump(projs.f);
+}
+
+static void enc_copyb_prolog(unsigned const size)
+{
+	if (size & 1)
+		be_emit8(0xA4); // movsb
+	if (size & 2) {
+		be_emit8(0x66);
+		be_emit8(0xA5); // movsw
+	}
+	if (size & 4)
+		be_emit8(0xA5); // movsl
+}
+
+static void enc_copyb(ir_node const *const node)
+{
+	enc_copyb_prolog(get_amd64_copyb_attr_const(node)->size);
+	be_emit8(0xF3);
+	be_emit8(0xA5); // rep movsl
+}
+
+static void enc_copyb_i(ir_node const *const node)
+{
+	unsigned size = get_amd64_copyb_attr_const(node)->size;
+	enc_copyb_prolog(size);
+	for (size >>= 3; size-- > 0;) {
+		be_emit8(REX | REX_W);
+		be_emit8(0xA5); // movsq
+	}
+}
+
+static void enc_xorp(ir_node const *const node)
+{
+	x86_insn_size_t const size = get_amd64_attr_const(node)->size;
+	enc_xmm_binop(node, size == X86_SIZE_64 ? 0x66 : 0, 0x57);
+}
+
+static void enc_xorp_0(ir_node const *const node)
+{
+	x86_insn_size_t        const size = get_amd64_attr_const(node)->size;
+	arch_register_t const *const out  = arch_get_irn_register_out(node, 0);
+	enc_prefix(size == X86_SIZE_64 ? 0x66 : 0);
+	enc_rr(ENC_NONE, 0x0F57, out, 0, out);
+}
+
+static void enc_pxor_0(ir_node const *const node)
+{
+	arch_register_t const *const out = arch_get_irn_register_out(node, 0);
+	enc_pxor(out, out);
+}
+
+static void enc_ucomis(ir_node const *const node)
+{
+	x86_insn_size_t const size = get_amd64_attr_const(node)->size;
+	enc_xmm_binop(node, size == X86_SIZE_64 ? 0x66 : 0, 0x2E);
+}
+
+static void enc_movs_xmm(ir_node const *const node)
+{
+	x86_insn_size_t const size = get_amd64_attr_const(node)->size;
+	enc_xmm_unop(node, get_scalar_prefix(size), ENC_NONE, 0x10);
+}
+
+static void enc_xmm_store(ir_node const *const node, uint8_t const prefix,
+                          uint8_t const code)
+{
+	amd64_addr_attr_t const *const attr = get_amd64_addr_attr_const(node);
+	arch_register_t   const *const val  = arch_get_irn_register_in(node, 0);
+	enc_prefix(prefix);
+	enc_rm(ENC_NONE, 0x0F00 | code, val, 0, node, &attr->addr, 0);
+}
+
+static void enc_movs_store_xmm(ir_node const *const node)
+{
+	x86_insn_size_t const size = get_amd64_attr_const(node)->size;
+	enc_xmm_store(node, get_scalar_prefix(size), 0x11);
+}
+
+static void enc_movdqu_store(ir_node const *const node)
+{
+	enc_xmm_store(node, 0xF3, 0x7F);
+}
+
+static void enc_movd_xmm_gp(ir_node const *const node)
+{
+	x86_insn_size_t        const size = get_amd64_attr_const(node)->size;
+	arch_register_t const *const in   = arch_get_irn_register_in(node, 0);
+	arch_register_t const *const out  = arch_get_irn_register_out(node, 0);
+	be_emit8(0x66);
+	enc_rr(size == X86_SIZE_64 ? ENC_W : ENC_NONE, 0x0F7E, in, 0, out);
+}
+
+static void enc_movd_gp_xmm(ir_node const *const node)
+{
+	x86_insn_size_t        const size = get_amd64_attr_const(node)->size;
+	arch_register_t const *const in   = arch_get_irn_register_in(node, 0);
+	arch_register_t const *const out  = arch_get_irn_register_out(node, 0);
+	be_emit8(0x66);
+	enc_rr(size == X86_SIZE_64 ? ENC_W : ENC_NONE, 0x0F6E, out, 0, in);
+}
+
+void amd64_enc_fsimple(uint8_t const opcode)
+{
+	be_emit8(0xD9);
+	be_emit8(opcode);
+}
+
+void amd64_enc_fbinop(ir_node const *const node, uint8_t const op_fwd,
+                      uint8_t const op_rev)
+{
+	x87_attr_t const *const x87 = amd64_get_x87_attr_const(node);
+	uint8_t           const op  = x87->reverse ? op_rev : op_fwd;
+	assert(!x87->pop || x87->res_in_reg);
+
+	uint8_t op0 = 0xD8;
+	if (x87->res_in_reg) op0 |= 0x04;
+	if (x87->pop)        op0 |= 0x02;
+	be_emit8(op0);
+	be_emit8(MOD_REG | ENC_REG(op) | ENC_RM(x87->reg->encoding));
+}
+
+void amd64_enc_fop_reg(ir_node const *const node, uint8_t const op0,
+                       uint8_t const op1)
+{
+	be_emit8(op0);
+	be_emit8(op1 + amd64_get_x87_attr_const(node)->reg->encoding);
+}
+
+static void enc_fucomi(ir_node const *const node)
+{
+	x87_attr_t const *const x87 = amd64_get_x87_attr_const(node);
+	be_emit8(x87->pop ? 0xDF : 0xDB); // fucom[p]i
+	be_emit8(0xE8 + x87->reg->encoding);
+}
+
+static void enc_x87_mem(ir_node const *const node, uint8_t const opcode,
+                        uint8_t const ext)
+{
+	amd64_addr_attr_t const *const attr = get_amd64_addr_attr_const(node);
+	enc_rm(ENC_NONE, opcode, NULL, ext, node, &attr->addr, 0);
+}
+
+static void enc_fld(ir_node const *const node)
+{
+	x86_insn_size_t const size = get_amd64_attr_const(node)->size;
+	switch (size) {
+	case X86_SIZE_32: enc_x87_mem(node, 0xD9, 0); return; // flds
+	case X86_SIZE_64: enc_x87_mem(node, 0xDD, 0); return; // fldl
+	case X86_SIZE_80: enc_x87_mem(node, 0xDB, 5); return; // fldt
+	case X86_SIZE_8:
+	case X86_SIZE_16:
+	case X86_SIZE_128:
+		break;
+	}
+	panic("unexpected mode size");
+}
+
+static void enc_fild(ir_node const *const node)
+{
+	x86_insn_size_t const size = get_amd64_attr_const(node)->size;
+	switch (size) {
+	case X86_SIZE_16: enc_x87_mem(node, 0xDF, 0); return; // filds
+	case X86_SIZE_32: enc_x87_mem(node, 0xDB, 0); return; // fildl
+	case X86_SIZE_64: enc_x87_mem(node, 0xDF, 5); return; // fildll
+	case X86_SIZE_8:
+	case X86_SIZE_80:
+	case X86_SIZE_128:
+		break;
+	}
+	panic("unexpected mode size");
+}
+
+static void enc_fisttp(ir_node const *const node)
+{
+	x86_insn_size_t const size = get_amd64_attr_const(node)->size;
+	switch (size) {
+	case X86_SIZE_16: enc_x87_mem(node, 0xDF, 1); return; // fisttps
+	case X86_SIZE_32: enc_x87_mem(node, 0xDB, 1); return; // fisttpl
+	case X86_SIZE_64: enc_x87_mem(node, 0xDD, 1); return; // fisttpll
+	case X86_SIZE_8:
+	case X86_SIZE_80:
+	case X86_SIZE_128:
+		break;
+	}
+	panic("unexpected mode size");
+}
+
+static void enc_fst_pop(ir_node const *const node, bool const pop)
+{
+	x86_insn_size_t const size = get_amd64_attr_const(node)->size;
+	switch (size) {
+	case X86_SIZE_32: enc_x87_mem(node, 0xD9, pop ? 3 : 2); return; // fst[p]s
+	case X86_SIZE_64: enc_x87_mem(node, 0xDD, pop ? 3 : 2); return; // fst[p]l
+	case X86_SIZE_80:
+		/* There is only a pop variant for long double store. */
+		assert(pop);
+		enc_x87_mem(node, 0xDB, 7); // fstpt
+		return;
+	case X86_SIZE_8:
+	case X86_SIZE_16:
+	case X86_SIZE_128:
+		break;
+	}
+	panic("unexpected mode size");
+}
+
+static void enc_fst(ir_node const *const node)
+{
+	enc_fst_pop(node, amd64_get_x87_attr_const(node)->pop);
+}
+
+static void enc_fstp(ir_node const *const node)
+{
+	enc_fst_pop(node, true);
+}
+
+static void enc_unsupported(ir_node const *const node)
+{
+	panic("%+F not supported in jit mode", node);
+}
+
+static unsigned get_block_fragment_num(ir_node const *const block)
+{
+	return PTR_TO_INT(ir_nodehashmap_get(void, &block_fragmentnum, block));
+}
+
+static void enc_jmp_switch(ir_node const *const node)
+{
+	/* the jump table is only placed in object files */
+	if (object_writer == NULL)
+		enc_unsupported(node);
+
+	amd64_switch_jmp_attr_t const *const attr
+		= get_amd64_switch_jmp_attr_const(node);
+	enc_am(ENC_NONE, 0xFF, NULL, 4, node); // jmp *AM
+
+	unsigned long         length;
+	ir_node const **const targets
+		= be_get_jump_table_targets(node, &attr->swtch, &length);
+	jump_table_t const table = {
+		.entity        = (ir_entity*)attr->swtch.table_entity,
+		.fragment_nums = XMALLOCN(unsigned, length),
+		.length        = length,
+	};
+	for (unsigned long i = 0; i < length; ++i) {
+		table.fragment_nums[i]
+			= get_block_fragment_num(be_emit_get_cfop_target(targets[i]));
+	}
+	free(targets);
+	ARR_APP1(jump_table_t, jump_tables, table);
+}
+
+static void amd64_register_binary_emitters(void)
+{
+	be_init_emitters();
+
+	amd64_register_spec_binary_emitters();
+
+	be_set_emitter(op_amd64_call,           enc_call);
+	be_set_emitter(op_amd64_cmpxchg,        enc_cmpxchg);
+	be_set_emitter(op_amd64_copyB,          enc_copyb);
+	be_set_emitter(op_amd64_copyB_i,        enc_copyb_i);
+	be_set_emitter(op_amd64_cqto,           enc_cqto);
+	be_set_emitter(op_amd64_fild,           enc_fild);
+	be_set_emitter(op_amd64_fisttp,         enc_fisttp);
+	be_set_emitter(op_amd64_fld,            enc_fld);
+	be_set_emitter(op_amd64_fst,            enc_fst);
+	be_set_emitter(op_amd64_fstp,           enc_fstp);
+	be_set_emitter(op_amd64_fucomi,         enc_fucomi);
+	be_set_emitter(op_amd64_ijmp,           enc_ijmp);
+	be_set_emitter(op_amd64_imul,           enc_imul);
+	be_set_emitter(op_amd64_jcc,            enc_amd64_jcc);
+	be_set_emitter(op_amd64_jmp,            enc_jump);
+	be_set_emitter(op_amd64_jmp_switch,     enc_jmp_switch);
+	be_set_emitter(op_amd64_lea,            enc_lea);
+	be_set_emitter(op_amd64_mov_gp,         enc_mov_gp);
+	be_set_emitter(op_amd64_mov_imm,        enc_mov_imm);
+	be_set_emitter(op_amd64_mov_store,      enc_mov_store);
+	be_set_emitter(op_amd64_movd_gp_xmm,    enc_movd_gp_xmm);
+	be_set_emitter(op_amd64_movd_xmm_gp,    enc_movd_xmm_gp);
+	be_set_emitter(op_amd64_movdqu_store,   enc_movdqu_store);
+	be_set_emitter(op_amd64_movs,           enc_movs);
+	be_set_emitter(op_amd64_movs_store_xmm, enc_movs_store_xmm);
+	be_set_emitter(op_amd64_movs_xmm,       enc_movs_xmm);
+	be_set_emitter(op_amd64_pop_am,         enc_pop_am);
+	be_set_emitter(op_amd64_push_am,        enc_push_am);
+	be_set_emitter(op_amd64_push_reg,       enc_push_reg);
+	be_set_emitter(op_amd64_pxor_0,         enc_pxor_0);
+	be_set_emitter(op_amd64_setcc,          enc_setcc);
+	be_set_emitter(op_amd64_sub_sp,         enc_sub_sp);
+	be_set_emitter(op_amd64_test,           enc_test);
+	be_set_emitter(op_amd64_ucomis,         enc_ucomis);
+	be_set_emitter(op_amd64_vfmadd132s,     enc_unsupported);
+	be_set_emitter(op_amd64_vfmadd213s,     enc_unsupported);
+	be_set_emitter(op_amd64_vfmadd231s,     enc_unsupported);
+	be_set_emitter(op_amd64_xor_0,          enc_xor_0);
+	be_set_emitter(op_amd64_xorp,           enc_xorp);
+	be_set_emitter(op_amd64_xorp_0,         enc_xorp_0);
+	be_set_emitter(op_be_Asm,               enc_unsupported);
+	be_set_emitter(op_be_Copy,              enc_copy);
+	be_set_emitter(op_be_CopyKeep,          enc_copy);
+	be_set_emitter(op_be_IncSP,             enc_incsp);
+	be_set_emitter(op_be_Perm,              enc_perm);
+}
+
+static void assign_block_fragment_num(ir_node *const block, unsigned const num)
+{
+	assert(ir_nodehashmap_get(void, &block_fragmentnum, block) == NULL);
+	ir_nodehashmap_insert(&block_fragmentnum, block, INT_TO_PTR(num));
+}
+
+static void add_cfa_change(int const offset)
+{
+	cfa_change_t const change = {
+		.position = be_jit_get_code_position(),
+		.offset   = offset,
+	};
+	ARR_APP1(cfa_change_t, cfa_changes, change);
+}
+
+static void gen_binary_block(ir_node *const block)
+{
+	unsigned fragment_num = be_begin_fragment(0, 0);
+	assert(fragment_num
+	       == (unsigned)PTR_TO_INT(ir_nodehashmap_get(void, &block_fragmentnum, block)));
+	(void)fragment_num;
+
+	/* Track the call frame like amd64_gen_block() does when the frame
+	 * pointer is omitted. */
+	int callframe_offset = 0;
+	if (cfa_changes != NULL) {
+		ir_graph *const irg = get_irn_irg(block);
+		callframe_offset = 8; /* 8 bytes for the return address */
+		if (block != get_irg_start_block(irg))
+			callframe_offset += get_type_size(get_irg_frame_type(irg));
+		add_cfa_change(callframe_offset);
+	}
+
+	/* emit the contents of the block */
+	sched_foreach(block, node) {
+		be_emit_node(node);
+
+		if (cfa_changes != NULL) {
+			int const sp_change = -amd64_get_sp_change(node);
+			if (sp_change != 0) {
+				callframe_offset += sp_change;
+				add_cfa_change(callframe_offset);
+			}
+		}
+	}
+
+	be_finish_fragment();
+}
+
+static void gen_address_slot(ir_entity *const entity)
+{
+	be_begin_fragment(3, 7);
+	be_emit_reloc_entity(8, AMD64_RELOCATION_ABS64, entity, 0);
+	be_finish_fragment();
+}
+
+static void gen_literal(ir_entity const *const entity)
+{
+	ir_initializer_t const *const initializer = get_entity_initializer(entity);
+	ir_tarval              *const tv          = get_initializer_tarval_value(initializer);
+	ir_mode                *const mode        = get_tarval_mode(tv);
+	unsigned                const size        = get_mode_size_bytes(mode);
+	unsigned                const bytes       = (get_mode_size_bits(mode) + 7) / 8;
+
+	uint8_t p2align = 0;
+	while (p2align < 4 && (1u << p2align) < size)
+		++p2align;
+	be_begin_fragment(p2align, (1u << p2align) - 1);
+	for (unsigned i = 0; i < size; ++i)
+		be_emit8(i < bytes ? get_tarval_sub_bits(tv, i) : 0);
+	be_finish_fragment();
+}
+
+ir_jit_function_t *amd64_emit_jit(ir_jit_segment_t *const segment,
+                                  ir_graph *const irg)
+{
+	amd64_register_binary_emitters();
+
+	ir_node **const blk_sched = be_create_block_schedule(irg);
+
+	be_jit_begin_function(segment);
+
+	/* we use links to point to target blocks */
+	ir_reserve_resources(irg, IR_RESOURCE_IRN_LINK);
+
+	be_emit_init_cf_links(blk_sched);
+
+	ir_nodehashmap_init(&block_fragmentnum);
+	literal_fragmentnum = pmap_create();
+	slot_fragmentnum    = pmap_create();
+	literals            = NEW_ARR_F(literal_t, 0);
+	size_t n = ARR_LEN(blk_sched);
+	n_block_fragments = n;
+	for (size_t i = 0; i < n; ++i) {
+		ir_node *block = blk_sched[i];
+		assign_block_fragment_num(block, (unsigned)i);
+	}
+	for (size_t i = 0; i < n; ++i) {
+		ir_node *block = blk_sched[i];
+		gen_binary_block(block);
+	}
+	/* the literals follow the code in the order of their fragment numbers */
+	for (size_t i = 0, n_literals = ARR_LEN(literals); i < n_literals; ++i) {
+		literal_t const *const literal = &literals[i];
+		if (literal->address_slot) {
+			gen_address_slot(literal->entity);
+		} else {
+			gen_literal(literal->entity);
+		}
+	}
+	ir_free_resources(irg, IR_RESOURCE_IRN_LINK);
+	ir_nodehashmap_destroy(&block_fragmentnum);
+	pmap_destroy(literal_fragmentnum);
+	pmap_destroy(slot_fragmentnum);
+	DEL_ARR_F(literals);
+
+	return be_jit_finish_function();
+}
+
+static void enc_nop_callback(char *buffer, unsigned size)
+{
+	memset(buffer, 0, size);
+	while (size > 0) {
+		switch (size) {
+		case 1: buffer[0] = 0x90; return;
+		case 2:
+			buffer[0] = 0x66;
+			++buffer;
+			--size;
+			continue;
+		case 3:
+		sequence_0f1f:
+			buffer[0] = 0x0F;
+			buffer[1] = 0x1F;
+			return;
+		case 4: buffer[2] = 0x40; goto sequence_0f1f;
+		case 5: buffer[2] = 0x44; goto sequence_0f1f;
+		case 6:
+			buffer[0] = 0x66;
+			++buffer;
+			--size;
+			continue;
+		case 7: buffer[2] = 0x80; goto sequence_0f1f;
+		case 8: buffer[2] = 0x84; goto sequence_0f1f;
+		default:
+			buffer[0] = 0x66;
+			buffer[1] = 0x0F;
+			buffer[2] = 0x1F;
+			buffer[3] = 0x84;
+			buffer += 9;
+			size   -= 9;
+			continue;
+		}
+	}
+}
+
+static unsigned enc_relocation_callback(char *const buffer,
+                                        uint8_t const be_kind,
+                                        ir_entity *const entity,
+                                        int32_t const offset)
+{
+	if (entity == NULL) {
+		assert(be_kind == AMD64_RELOCATION_RELJUMP);
+		uint32_t const value = (uint32_t)offset;
+		memcpy(buffer, &value, 4);
+		return 4;
+	}
+
+	intptr_t const entity_addr = (intptr_t)be_jit_get_entity_addr(entity);
+	if (entity_addr == (intptr_t)-1)
+		panic("Could not resolve address of entity %+F", entity);
+	intptr_t addr = entity_addr + offset;
+	if (be_kind == AMD64_RELOCATION_ABS64) {
+		uint64_t const value = (uint64_t)addr;
+		memcpy(buffer, &value, 8);
+		return 8;
+	}
+
+	if (be_kind == X86_IMM_PCREL)
+		addr -= (intptr_t)buffer;
+	int32_t const value = (int32_t)addr;
+	if ((intptr_t)value != addr)
+		panic("Overflow in relocation to %+F", entity);
+	memcpy(buffer, &value, 4);
+	return 4;
+}
+
+void amd64_emit_jit_function(char *const buffer,
+                             ir_jit_function_t *const function)
+{
+	static const be_jit_emit_interface_t jit_emit_interface = {
+		.nops       = enc_nop_callback,
+		.relocation = enc_relocation_callback,
+	};
+	be_jit_emit_memory(buffer, function, &jit_emit_interface);
+}
+
+static unsigned enc_object_relocation_callback(char *const buffer,
+                                               uint8_t const be_kind,
+                                               ir_entity *const entity,
+                                               int32_t const offset)
+{
+	if (entity == NULL)
+		return enc_relocation_callback(buffer, be_kind, entity, offset);
+
+	uint32_t type;
+	unsigned size = 4;
+	switch (be_kind) {
+	case AMD64_RELOCATION_ABS64: type = R_X86_64_64; size = 8; break;
+	case X86_IMM_ADDR:           type = R_X86_64_32S;          break;
+	case X86_IMM_PCREL:          type = R_X86_64_PC32;         break;
+	case X86_IMM_PLT:            type = R_X86_64_PLT32;        break;
+	case X86_IMM_GOTPCREL:       type = R_X86_64_GOTPCREL;     break;
+	default:
+		panic("relocation kind %s not supported in object files",
+		      x86_get_immediate_kind_str((x86_immediate_kind_t)be_kind));
+	}
+	/* The addend of pc relative relocations already accounts for the
+	 * distance between the relocation and the end of the instruction. */
+	memset(buffer, 0, size);
+	be_elf_add_text_relocation(object_writer, buffer, type, entity, offset);
+	return size;
+}
+
+static void cfa_uleb128(uint8_t **const instructions, unsigned value)
+{
+	do {
+		uint8_t const byte = value & 0x7F;
+		value >>= 7;
+		ARR_APP1(uint8_t, *instructions, value != 0 ? byte | 0x80 : byte);
+	} while (value != 0);
+}
+
+static void cfa_advance(uint8_t **const instructions, unsigned const delta)
+{
+	if (delta == 0) {
+		return;
+	} else if (delta < 0x40) {
+		ARR_APP1(uint8_t, *instructions, DW_CFA_advance_loc | delta);
+	} else if (delta <= UINT8_MAX) {
+		ARR_APP1(uint8_t, *instructions, DW_CFA_advance_loc1);
+		ARR_APP1(uint8_t, *instructions, delta);
+	} else if (delta <= UINT16_MAX) {
+		ARR_APP1(uint8_t, *instructions, DW_CFA_advance_loc2);
+		ARR_APP1(uint8_t, *instructions, delta);
+		ARR_APP1(uint8_t, *instructions, delta >> 8);
+	} else {
+		ARR_APP1(uint8_t, *instructions, DW_CFA_advance_loc4);
+		for (unsigned i = 0; i < 4; ++i)
+			ARR_APP1(uint8_t, *instructions, delta >> (8 * i));
+	}
+}
+
+/**
+ * Adds the frame description of a function to the object file. It describes
+ * the same call frame as the .cfi directives of amd64_emit_function().
+ */
+static void add_fde(ir_jit_function_t const *const function,
+                    uint64_t const begin, bool const omit_fp)
+{
+	uint8_t *instructions = NEW_ARR_F(uint8_t, 0);
+	if (omit_fp) {
+		ARR_APP1(uint8_t, instructions, DW_CFA_def_cfa_register);
+		cfa_uleb128(&instructions, amd64_registers[REG_RSP].dwarf_number);
+		unsigned address = 0;
+		for (size_t i = 0, n = ARR_LEN(cfa_changes); i < n; ++i) {
+			cfa_change_t const *const change = &cfa_changes[i];
+			unsigned const change_address
+				= be_jit_get_code_address(function, change->position);
+			cfa_advance(&instructions, change_address - address);
+			address = change_address;
+			ARR_APP1(uint8_t, instructions, DW_CFA_def_cfa_offset);
+			cfa_uleb128(&instructions, change->offset);
+		}
+	} else {
+		unsigned const rbp = amd64_registers[REG_RBP].dwarf_number;
+		ARR_APP1(uint8_t, instructions, DW_CFA_def_cfa_register);
+		cfa_uleb128(&instructions, rbp);
+		ARR_APP1(uint8_t, instructions, DW_CFA_def_cfa_offset);
+		cfa_uleb128(&instructions, 16);
+		ARR_APP1(uint8_t, instructions, DW_CFA_offset | rbp);
+		cfa_uleb128(&instructions, 16 / 8);
+	}
+	be_elf_add_fde(object_writer, begin, be_get_function_size(function),
+	               instructions, ARR_LEN(instructions));
+	DEL_ARR_F(instructions);
+}
+
+static void add_jump_tables(ir_jit_function_t const *const function,
+                            uint64_t const begin)
+{
+	bool const relative = ir_platform.pic_style != BE_PIC_NONE;
+	for (size_t i = 0, n = ARR_LEN(jump_tables); i < n; ++i) {
+		jump_table_t const *const table   = &jump_tables[i];
+		uint64_t           *const targets = XMALLOCN(uint64_t, table->length);
+		for (unsigned long e = 0; e < table->length; ++e) {
+			targets[e] = begin + be_jit_get_fragment_address(
+				function, table->fragment_nums[e]);
+		}
+		be_elf_add_jump_table(object_writer, table->entity, targets,
+		                      table->length, relative);
+		free(targets);
+		free(table->fragment_nums);
+	}
+}
+
+void amd64_emit_object_function(be_elf_writer_t *const elf,
+                                ir_jit_segment_t *const segment,
+                                ir_graph *const irg)
+{
+	bool const omit_fp = amd64_get_irg_data(irg)->omit_fp;
+	object_writer = elf;
+	jump_tables   = NEW_ARR_F(jump_table_t, 0);
+	cfa_changes   = be_dwarf_has_frameinfo() && omit_fp
+		? NEW_ARR_F(cfa_change_t, 0) : NULL;
+
+	ir_jit_function_t *const function = amd64_emit_jit(segment, irg);
+
+	static const be_jit_emit_interface_t object_emit_interface = {
+		.nops       = enc_nop_callback,
+		.relocation = enc_object_relocation_callback,
+	};
+	ir_entity *const entity = get_irg_entity(irg);
+	unsigned   const size   = be_get_function_size(function);
+	char      *const buffer = be_elf_begin_function(elf, entity, size, 4);
+	be_jit_emit_memory(buffer, function, &object_emit_interface);
+
+	uint64_t const begin = be_elf_get_text_offset(elf, buffer);
+	add_jump_tables(function, begin);
+	if (be_dwarf_has_frameinfo())
+		add_fde(function, begin, omit_fp);
+
+	if (cfa_changes != NULL)
+		DEL_ARR_F(cfa_changes);
+	DEL_ARR_F(jump_tables);
+	cfa_changes   = NULL;
+	jump_tables   = NULL;
+	object_writer = NULL;
+}
+
+be_elf_writer_t *amd64_new_elf_writer(void)
+{
+	static const uint8_t cie_instructions[] = {
+		DW_CFA_def_cfa, 7 /* rsp */, 8,
+		DW_CFA_offset | 16 /* rip */, 1,
+	};
+	static const be_elf_target_t amd64_elf_target = {
+		.machine            = 62, /* EM_X86_64 */
+		.reloc_abs32        = R_X86_64_32,
+		.reloc_abs64        = R_X86_64_64,
+		.reloc_pc32         = R_X86_64_PC32,
+		.ra_register        = 16,
+		.data_align         = -8,
+		.cie_instructions   = cie_instructions,
+		.n_cie_instructions = ARRAY_SIZE(cie_instructions),
+		.nops               = enc_nop_callback,
+	};
+	return be_elf_new(&amd64_elf_target);
+}
+
+/** Appends @p size bytes to @p buffer unless it is NULL. */
+static unsigned put_bytes(char *const buffer, unsigned const pos,
+                          void const *const bytes, unsigned const size)
+{
+	if (buffer != NULL)
+		memcpy(buffer + pos, bytes, size);
+	return pos + size;
+}
+
+static unsigned put_movabs_r11(char *const buffer, unsigned const pos,
+                               void const *const value)
+{
+	static const uint8_t movabs_r11[] = { 0x49, 0xBB }; // movabsq $value, %r11
+	uint64_t const imm = (uint64_t)(uintptr_t)value;
+	unsigned const p   = put_bytes(buffer, pos, movabs_r11, sizeof(movabs_r11));
+	return put_bytes(buffer, p, &imm, sizeof(imm));
+}
+
+unsigned amd64_emit_jit_stub(char *const buffer, void *const *const target)
+{
+	static const uint8_t jmp_r11[] = { 0x41, 0xFF, 0x23 }; // jmp *(%r11)
+	unsigned const pos = put_movabs_r11(buffer, 0, target);
+	return put_bytes(buffer, pos, jmp_r11, sizeof(jmp_r11));
+}
+
+unsigned amd64_emit_jit_resolver(char *const buffer,
+                                 void *(*const resolve)(void *const *target))
+{
+	/* The stub jumps here with the address of its target slot in %r11.  All
+	 * argument registers are preserved; the return address plus 9 pushes keep
+	 * the stack 16 byte aligned for the call. */
+	static const uint8_t prolog[] = {
+		0x55,                                     // pushq %rbp
+		0x48, 0x89, 0xE5,                         // movq %rsp, %rbp
+		0x57, 0x56, 0x52, 0x51,                   // pushq %rdi, %rsi, %rdx, %rcx
+		0x41, 0x50, 0x41, 0x51, 0x50, 0x41, 0x52, // pushq %r8, %r9, %rax, %r10
+		0x48, 0x81, 0xEC, 0x80, 0x00, 0x00, 0x00, // subq $128, %rsp
+	};
+	static const uint8_t call[] = {
+		0x4C, 0x89, 0xDF,                         // movq %r11, %rdi
+		0x49, 0xBB,                               // movabsq $resolve, %r11
+	};
+	static const uint8_t call_r11[] = {
+		0x41, 0xFF, 0xD3,                         // call *%r11
+		0x49, 0x89, 0xC3,                         // movq %rax, %r11
+	};
+	static const uint8_t epilog[] = {
+		0x48, 0x81, 0xC4, 0x80, 0x00, 0x00, 0x00, // addq $128, %rsp
+		0x41, 0x5A, 0x58, 0x41, 0x59, 0x41, 0x58, // popq %r10, %rax, %r9, %r8
+		0x59, 0x5A, 0x5E, 0x5F,                   // popq %rcx, %rdx, %rsi, %rdi
+		0x5D,                                     // popq %rbp
+		0x41, 0xFF, 0xE3,                         // jmp *%r11
+	};
+
+	unsigned pos = put_bytes(buffer, 0, prolog, sizeof(prolog));
+	for (uint8_t i = 0; i < 8; ++i) {
+		/* movdqu %xmmi, 16*i(%rsp) */
+		uint8_t const store[] = { 0xF3, 0x0F, 0x7F, 0x44 | i << 3, 0x24, i * 16 };
+		pos = put_bytes(buffer, pos, store, sizeof(store));
+	}
+	pos = put_bytes(buffer, pos, call, sizeof(call));
+	uint64_t const resolve_addr = (uint64_t)(uintptr_t)resolve;
+	pos = put_bytes(buffer, pos, &resolve_addr, sizeof(resolve_addr));
+	pos = put_bytes(buffer, pos, call_r11, sizeof(call_r11));
+	for (uint8_t i = 0; i < 8; ++i) {
+		/* movdqu 16*i(%rsp), %xmmi */
+		uint8_t const load[] = { 0xF3, 0x0F, 0x6F, 0x44 | i << 3, 0x24, i * 16 };
+		pos = put_bytes(buffer, pos, load, sizeof(load));
+	}
+	return put_bytes(buffer, pos, epilog, sizeof(epilog));
+}
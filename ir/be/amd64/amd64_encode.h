@@ -0,0 +1,83 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2016 University of Karlsruhe.
+ */
+
+/**
+ * @file
+ * @brief       amd64 binary encoding/emission
+ */
+#ifndef FIRM_BE_AMD64_AMD64_ENCODE_H
+#define FIRM_BE_AMD64_AMD64_ENCODE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "beelf.h"
+#include "firm_types.h"
+#include "jit.h"
+
+enum {
+	/** 32bit offset relative to the end of the relocation to a fragment */
+	AMD64_RELOCATION_RELJUMP = 128,
+	/** 64bit absolute address of an entity */
+	AMD64_RELOCATION_ABS64,
+};
+
+ir_jit_function_t *amd64_emit_jit(ir_jit_segment_t *segment, ir_graph *irg);
+
+/**
+ * Returns whether the jit emits @p entity as a literal behind the code of
+ * the function, which is addressed relative to the instruction pointer.
+ */
+bool amd64_is_jit_literal(ir_entity const *entity);
+
+void amd64_emit_jit_function(char *buffer, ir_jit_function_t *function);
+
+/**
+ * Encodes @p irg into the text section of @p elf. The code fragments are
+ * collected in @p segment.
+ */
+void amd64_emit_object_function(be_elf_writer_t *elf, ir_jit_segment_t *segment,
+                                ir_graph *irg);
+
+/** Creates an object file writer for amd64. */
+be_elf_writer_t *amd64_new_elf_writer(void);
+
+/**
+ * Writes a lazy compilation stub jumping through @p target.
+ * With a NULL @p buffer only the size is returned.
+ */
+unsigned amd64_emit_jit_stub(char *buffer, void *const *target);
+
+/**
+ * Writes the common resolver entered by the lazy compilation stubs.
+ * With a NULL @p buffer only the size is returned.
+ */
+unsigned amd64_emit_jit_resolver(char *buffer,
+                                 void *(*resolve)(void *const *target));
+
+void amd64_enc_simple(uint8_t opcode);
+
+void amd64_enc_binop(ir_node const *node, uint8_t code);
+
+void amd64_enc_unop(ir_node const *node, uint8_t code, uint8_t ext);
+
+void amd64_enc_shiftop(ir_node const *node, uint8_t ext);
+
+void amd64_enc_0f_unop_reg(ir_node const *node, uint8_t code);
+
+void amd64_enc_xmm_scalar(ir_node const *node, uint8_t code);
+
+void amd64_enc_xmm_binop(ir_node const *node, uint8_t prefix, uint8_t code);
+
+void amd64_enc_xmm_unop(ir_node const *node, uint8_t prefix, uint8_t code);
+
+void amd64_enc_xmm_conv(ir_node const *node, uint8_t prefix, uint8_t code);
+
+void amd64_enc_fsimple(uint8_t opcode);
+
+void amd64_enc_fbinop(ir_node const *node, uint8_t op_fwd, uint8_t op_rev);
+
+void amd64_enc_fop_reg(ir_node const *node, uint8_t op0, uint8_t op1);
+
+#endif
@@ -9,6 +9,7 @@
  * @author      Matthias Braun
  */
 #include "amd64_bearch_t.h"
+#include "amd64_encode.h"
 #include "amd64_new_nodes.h"
 #include "beutil.h"
 #include "entity_t.h"
@@ -118,3 +119,31 @@ void amd64_adjust_pic(ir_graph *irg)
 	}
 	be_dump(DUMP_BE, irg, "pic");
 }
+
+static void fix_address_jit(ir_node *const node, void *const data)
+{
+	(void)data;
+	foreach_irn_in(node, i, pred) {
+		if (!is_Address(pred))
+			continue;
+		/* calls are already encoded through the address slots */
+		if (i == n_Call_ptr && is_Call(node))
+			continue;
+		ir_entity *const entity = get_Address_entity(pred);
+		if (is_tls_entity(entity) || amd64_is_jit_literal(entity))
+			continue;
+
+		dbg_info *const dbgi = get_irn_dbg_info(pred);
+		ir_graph *const irg  = get_irn_irg(node);
+		set_irn_n(node, i, create_gotpcrel_load(dbgi, irg, entity));
+	}
+}
+
+void amd64_adjust_jit_addresses(ir_graph *irg)
+{
+	/* The code arena may be further away from the data than 32bit
+	 * displacements reach. The encoder turns GOT accesses into loads from
+	 * the 8 byte address slots behind the function. */
+	irg_walk_graph(irg, fix_address_jit, NULL, NULL);
+	be_dump(DUMP_BE, irg, "jit-addresses");
+}
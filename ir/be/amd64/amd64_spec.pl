@@ -9,22 +9,22 @@ $mode_x87   = "x86_mode_E";
 	gp => {
 		mode => $mode_gp,
 		registers => [
-			{ name => "rax", dwarf =>  0 },
-			{ name => "rcx", dwarf =>  2 },
-			{ name => "rdx", dwarf =>  1 },
-			{ name => "rsi", dwarf =>  4 },
-			{ name => "rdi", dwarf =>  5 },
-			{ name => "rbx", dwarf =>  3 },
-			{ name => "rbp", dwarf =>  6 },
-			{ name => "rsp", dwarf =>  7 },
-			{ name => "r8",  dwarf =>  8 },
-			{ name => "r9",  dwarf =>  9 },
-			{ name => "r10", dwarf => 10 },
-			{ name => "r11", dwarf => 11 },
-			{ name => "r12", dwarf => 12 },
-			{ name => "r13", dwarf => 13 },
-			{ name => "r14", dwarf => 14 },
-			{ name => "r15", dwarf => 15 },
+			{ name => "rax", encoding =>  0, dwarf =>  0 },
+			{ name => "rcx", encoding =>  1, dwarf =>  2 },
+			{ name => "rdx", encoding =>  2, dwarf =>  1 },
+			{ name => "rsi", encoding =>  6, dwarf =>  4 },
+			{ name => "rdi", encoding =>  7, dwarf =>  5 },
+			{ name => "rbx", encoding =>  3, dwarf =>  3 },
+			{ name => "rbp", encoding =>  5, dwarf =>  6 },
+			{ name => "rsp", encoding =>  4, dwarf =>  7 },
+			{ name => "r8",  encoding =>  8, dwarf =>  8 },
+			{ name => "r9",  encoding =>  9, dwarf =>  9 },
+			{ name => "r10", encoding => 10, dwarf => 10 },
+			{ name => "r11", encoding => 11, dwarf => 11 },
+			{ name => "r12", encoding => 12, dwarf => 12 },
+			{ name => "r13", encoding => 13, dwarf => 13 },
+			{ name => "r14", encoding => 14, dwarf => 14 },
+			{ name => "r15", encoding => 15, dwarf => 15 },
 		]
 	},
 	flags => {
@@ -368,16 +368,24 @@ leave => {
 	fixed     => "amd64_op_mode_t op_mode = AMD64_OP_NONE;\n"
 	            ."x86_insn_size_t size    = X86_SIZE_64;\n",
 	emit      => "leave",
+	encode    => "amd64_enc_simple(0xC9)",
 },
 
-add => { template => $binop_commutative },
+add => {
+	template => $binop_commutative,
+	encode   => "amd64_enc_binop(node, 0)",
+},
 
-and => { template => $binop_commutative },
+and => {
+	template => $binop_commutative,
+	encode   => "amd64_enc_binop(node, 4)",
+},
 
 cltd => {
 	template => $sextop,
 	fixed    => "amd64_op_mode_t op_mode = AMD64_OP_NONE;\n"
 	           ."x86_insn_size_t size    = X86_SIZE_32;\n",
+	encode   => "amd64_enc_simple(0x99)",
 },
 
 cqto => {
@@ -386,39 +394,74 @@ cqto => {
 	           ."x86_insn_size_t size    = X86_SIZE_64;\n",
 },
 
-div => { template => $divop },
+div => {
+	template => $divop,
+	encode   => "amd64_enc_unop(node, 0xF6, 6)",
+},
 
-idiv => { template => $divop },
+idiv => {
+	template => $divop,
+	encode   => "amd64_enc_unop(node, 0xF6, 7)",
+},
 
 imul => { template => $binop_commutative },
 
 imul_1op => {
 	template => $mulop,
 	name     => "imul",
+	encode   => "amd64_enc_unop(node, 0xF6, 5)",
 },
 
-mul => { template => $mulop },
+mul => {
+	template => $mulop,
+	encode   => "amd64_enc_unop(node, 0xF6, 4)",
+},
 
-or => { template => $binop_commutative },
+or => {
+	template => $binop_commutative,
+	encode   => "amd64_enc_binop(node, 1)",
+},
 
-shl => { template => $shiftop },
+shl => {
+	template => $shiftop,
+	encode   => "amd64_enc_shiftop(node, 4)",
+},
 
-shr => { template => $shiftop },
+shr => {
+	template => $shiftop,
+	encode   => "amd64_enc_shiftop(node, 5)",
+},
 
-sar => { template => $shiftop },
+sar => {
+	template => $shiftop,
+	encode   => "amd64_enc_shiftop(node, 7)",
+},
 
 sub => {
 	template  => $binop,
 	irn_flags => [ "modify_flags", "rematerializable" ],
+	encode    => "amd64_enc_binop(node, 5)",
 },
 
-sbb => { template => $binop },
+sbb => {
+	template => $binop,
+	encode   => "amd64_enc_binop(node, 3)",
+},
 
-neg => { template => $unop },
+neg => {
+	template => $unop,
+	encode   => "amd64_enc_unop(node, 0xF6, 3)",
+},
 
-not => { template => $unop },
+not => {
+	template => $unop,
+	encode   => "amd64_enc_unop(node, 0xF6, 2)",
+},
 
-xor => { template => $binop_commutative },
+xor => {
+	template => $binop_commutative,
+	encode   => "amd64_enc_binop(node, 6)",
+},
 
 xor_0 => {
 	op_flags  => [ "constlike" ],
@@ -479,7 +522,10 @@ jmp => {
 	            ."x86_insn_size_t size    = X86_SIZE_64;\n",
 },
 
-cmp => { template => $cmpop },
+cmp => {
+	template => $cmpop,
+	encode   => "amd64_enc_binop(node, 7)",
+},
 
 test => { template => $cmpop },
 
@@ -570,19 +616,30 @@ ret => {
 	fixed    => "amd64_op_mode_t op_mode = AMD64_OP_NONE;\n"
 	           ."x86_insn_size_t size    = X86_SIZE_64;\n",
 	emit     => "ret",
+	encode   => "amd64_enc_simple(0xC3)",
 },
 
-bsf => { template => $unop_out },
+bsf => {
+	template => $unop_out,
+	encode   => "amd64_enc_0f_unop_reg(node, 0xBC)",
+},
 
-bsr => { template => $unop_out },
+bsr => {
+	template => $unop_out,
+	encode   => "amd64_enc_0f_unop_reg(node, 0xBD)",
+},
 
 # SSE
 
-adds => { template => $binopx_commutative },
+adds => {
+	template => $binopx_commutative,
+	encode   => "amd64_enc_xmm_scalar(node, 0x58)",
+},
 
 divs => {
 	template => $binopx,
 	emit     => "divs%MX %AM",
+	encode   => "amd64_enc_xmm_scalar(node, 0x5E)",
 },
 
 movs_xmm => {
@@ -591,7 +648,10 @@ movs_xmm => {
 	emit     => "movs%MX %AM, %D0",
 },
 
-muls => { template => $binopx_commutative },
+muls => {
+	template => $binopx_commutative,
+	encode   => "amd64_enc_xmm_scalar(node, 0x59)",
+},
 
 movs_store_xmm => {
 	op_flags  => [ "uses_memory" ],
@@ -607,6 +667,7 @@ movs_store_xmm => {
 subs => {
 	template => $binopx,
 	emit     => "subs%MX %AM",
+	encode   => "amd64_enc_xmm_scalar(node, 0x5C)",
 },
 
 ucomis => {
@@ -666,35 +727,54 @@ pxor_0 => {
 
 # Conversion operations
 
-cvtss2sd => { template => $cvtop2x },
+cvtss2sd => {
+	template => $cvtop2x,
+	encode   => "amd64_enc_xmm_unop(node, 0xF3, 0x5A)",
+},
 
 cvtsd2ss => {
 	template => $cvtop2x,
 	attr     => "amd64_op_mode_t op_mode, x86_addr_t addr",
 	fixed    => "x86_insn_size_t size = X86_SIZE_64;\n",
+	encode   => "amd64_enc_xmm_unop(node, 0xF2, 0x5A)",
 },
 
-cvttsd2si => { template => $cvtopx2i },
+cvttsd2si => {
+	template => $cvtopx2i,
+	encode   => "amd64_enc_xmm_conv(node, 0xF2, 0x2C)",
+},
 
-cvttss2si => { template => $cvtopx2i },
+cvttss2si => {
+	template => $cvtopx2i,
+	encode   => "amd64_enc_xmm_conv(node, 0xF3, 0x2C)",
+},
 
-cvtsi2ss => { template => $cvtop2x },
+cvtsi2ss => {
+	template => $cvtop2x,
+	encode   => "amd64_enc_xmm_conv(node, 0xF3, 0x2A)",
+},
 
-cvtsi2sd => { template => $cvtop2x },
+cvtsi2sd => {
+	template => $cvtop2x,
+	encode   => "amd64_enc_xmm_conv(node, 0xF2, 0x2A)",
+},
 
 movd => {
 	template => $movopx,
 	fixed    => "x86_insn_size_t size = X86_SIZE_64;\n",
+	encode   => "amd64_enc_xmm_conv(node, 0x66, 0x6E)",
 },
 
 movdqa => {
 	template => $movopx,
 	fixed    => "x86_insn_size_t size = X86_SIZE_128;\n",
+	encode   => "amd64_enc_xmm_unop(node, 0x66, 0x6F)",
 },
 
 movdqu => {
 	template => $movopx,
 	fixed    => "x86_insn_size_t size = X86_SIZE_128;\n",
+	encode   => "amd64_enc_xmm_unop(node, 0xF3, 0x6F)",
 },
 
 movdqu_store => {
@@ -752,15 +832,142 @@ l_haddpd => {
 	mode      => $mode_xmm,
 },
 
-punpckldq => { template => $binopx },
+punpckldq => {
+	template => $binopx,
+	encode   => "amd64_enc_xmm_binop(node, 0x66, 0x62)",
+},
+
+subpd => {
+	template => $binopx,
+	encode   => "amd64_enc_xmm_binop(node, 0x66, 0x5C)",
+},
+
+haddpd => {
+	template => $binopx,
+	encode   => "amd64_enc_xmm_binop(node, 0x66, 0x7C)",
+},
+
+addps => {
+	template => $binopx_commutative,
+	emit     => "{name} %AM",
+	encode   => "amd64_enc_xmm_binop(node, 0, 0x58)",
+},
+
+addpd => {
+	template => $binopx_commutative,
+	emit     => "{name} %AM",
+	encode   => "amd64_enc_xmm_binop(node, 0x66, 0x58)",
+},
+
+subps => {
+	template => $binopx,
+	encode   => "amd64_enc_xmm_binop(node, 0, 0x5C)",
+},
+
+mulps => {
+	template => $binopx_commutative,
+	emit     => "{name} %AM",
+	encode   => "amd64_enc_xmm_binop(node, 0, 0x59)",
+},
+
+mulpd => {
+	template => $binopx_commutative,
+	emit     => "{name} %AM",
+	encode   => "amd64_enc_xmm_binop(node, 0x66, 0x59)",
+},
+
+paddb => {
+	template => $binopx_commutative,
+	emit     => "{name} %AM",
+	encode   => "amd64_enc_xmm_binop(node, 0x66, 0xFC)",
+},
+
+paddw => {
+	template => $binopx_commutative,
+	emit     => "{name} %AM",
+	encode   => "amd64_enc_xmm_binop(node, 0x66, 0xFD)",
+},
+
+paddd => {
+	template => $binopx_commutative,
+	emit     => "{name} %AM",
+	encode   => "amd64_enc_xmm_binop(node, 0x66, 0xFE)",
+},
+
+paddq => {
+	template => $binopx_commutative,
+	emit     => "{name} %AM",
+	encode   => "amd64_enc_xmm_binop(node, 0x66, 0xD4)",
+},
+
+psubb => {
+	template => $binopx,
+	encode   => "amd64_enc_xmm_binop(node, 0x66, 0xF8)",
+},
+
+psubw => {
+	template => $binopx,
+	encode   => "amd64_enc_xmm_binop(node, 0x66, 0xF9)",
+},
+
+psubd => {
+	template => $binopx,
+	encode   => "amd64_enc_xmm_binop(node, 0x66, 0xFA)",
+},
+
+psubq => {
+	template => $binopx,
+	encode   => "amd64_enc_xmm_binop(node, 0x66, 0xFB)",
+},
 
-subpd => { template => $binopx },
+pmullw => {
+	template => $binopx_commutative,
+	emit     => "{name} %AM",
+	encode   => "amd64_enc_xmm_binop(node, 0x66, 0xD5)",
+},
 
-haddpd => { template => $binopx },
+pand => {
+	template => $binopx_commutative,
+	emit     => "{name} %AM",
+	encode   => "amd64_enc_xmm_binop(node, 0x66, 0xDB)",
+},
 
-fldz => { template => $x87const },
+por => {
+	template => $binopx_commutative,
+	emit     => "{name} %AM",
+	encode   => "amd64_enc_xmm_binop(node, 0x66, 0xEB)",
+},
 
-fld1 => { template => $x87const },
+pxor => {
+	template => $binopx_commutative,
+	emit     => "{name} %AM",
+	encode   => "amd64_enc_xmm_binop(node, 0x66, 0xEF)",
+},
+
+punpcklbw => {
+	template => $binopx,
+	encode   => "amd64_enc_xmm_binop(node, 0x66, 0x60)",
+},
+
+punpcklwd => {
+	template => $binopx,
+	encode   => "amd64_enc_xmm_binop(node, 0x66, 0x61)",
+},
+
+punpcklqdq => {
+	template => $binopx,
+	encode   => "amd64_enc_xmm_binop(node, 0x66, 0x6C)",
+},
+
+fldz => {
+	template => $x87const,
+	encode   => "amd64_enc_fsimple(0xEE)",
+},
+
+fld1 => {
+	template => $x87const,
+	encode   => "amd64_enc_fsimple(0xE8)",
+},
 
 fld => {
 	irn_flags => [ "rematerializable" ],
@@ -804,24 +1011,31 @@ fstp => {
 fadd => {
 	template => $x87binop,
 	emit     => "fadd%FP %AF",
+	encode   => "amd64_enc_fbinop(node, 0, 0)",
 },
 
 fdiv => {
 	template => $x87binop,
 	emit     => "fdiv%FR%FP %AF",
+	encode   => "amd64_enc_fbinop(node, 6, 7)",
 },
 
 fmul => {
 	template => $x87binop,
 	emit     => "fmul%FP %AF",
+	encode   => "amd64_enc_fbinop(node, 1, 1)",
 },
 
 fsub => {
 	template => $x87binop,
 	emit     => "fsub%FR%FP %AF",
+	encode   => "amd64_enc_fbinop(node, 4, 5)",
 },
 
-fchs => { template => $x87unop },
+fchs => {
+	template => $x87unop,
+	encode   => "amd64_enc_fsimple(0xE0)",
+},
 
 fucomi => {
 	irn_flags => [ "rematerializable" ],
@@ -842,6 +1056,7 @@ fdup => {
 	attr        => "const arch_register_t *reg",
 	init        => "attr->x87.reg = reg;",
 	emit        => "fld %F0",
+	encode      => "amd64_enc_fop_reg(node, 0xD9, 0xC0)",
 },
 
 fxch => {
@@ -852,6 +1067,7 @@ fxch => {
 	attr        => "const arch_register_t *reg",
 	init        => "attr->x87.reg = reg;",
 	emit        => "fxch %F0",
+	encode      => "amd64_enc_fop_reg(node, 0xD9, 0xC8)",
 },
 
 fpop => {
@@ -862,6 +1078,7 @@ fpop => {
 	attr        => "const arch_register_t *reg",
 	init        => "attr->x87.reg = reg;",
 	emit        => "fstp %F0",
+	encode      => "amd64_enc_fop_reg(node, 0xDD, 0xD8)",
 },
 
 # FMA instructions
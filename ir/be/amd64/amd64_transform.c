@@ -936,6 +936,88 @@ static ir_node *gen_binop_xmm(ir_node *node, ir_node *op0, ir_node *op1,
 	return be_new_Proj(new_node, pn_amd64_subs_res);
 }
 
+/**
+ * Returns the constructor of the packed SSE instruction computing the
+ * vector binop @p node.
+ */
+static construct_binop_func get_vector_binop_func(ir_node const *const node)
+{
+	ir_mode *const elem  = get_mode_vector_element_mode(get_irn_mode(node));
+	unsigned const bytes = get_mode_size_bytes(elem);
+	if (mode_is_float(elem)) {
+		bool const single = bytes == 4;
+		switch (get_irn_opcode(node)) {
+		case iro_Add: return single ? new_bd_amd64_addps : new_bd_amd64_addpd;
+		case iro_Sub: return single ? new_bd_amd64_subps : new_bd_amd64_subpd;
+		case iro_Mul: return single ? new_bd_amd64_mulps : new_bd_amd64_mulpd;
+		default:      break;
+		}
+	} else {
+		switch (get_irn_opcode(node)) {
+		case iro_Add:
+			switch (bytes) {
+			case 1: return new_bd_amd64_paddb;
+			case 2: return new_bd_amd64_paddw;
+			case 4: return new_bd_amd64_paddd;
+			case 8: return new_bd_amd64_paddq;
+			}
+			break;
+		case iro_Sub:
+			switch (bytes) {
+			case 1: return new_bd_amd64_psubb;
+			case 2: return new_bd_amd64_psubw;
+			case 4: return new_bd_amd64_psubd;
+			case 8: return new_bd_amd64_psubq;
+			}
+			break;
+		case iro_Mul:
+			if (bytes == 2)
+				return new_bd_amd64_pmullw;
+			break;
+		case iro_And: return new_bd_amd64_pand;
+		case iro_Or:  return new_bd_amd64_por;
+		case iro_Eor: return new_bd_amd64_pxor;
+		default:      break;
+		}
+	}
+	panic("unsupported vector operation %+F", node);
+}
+
+static ir_node *gen_vector_binop(ir_node *const node, ir_node *const op0,
+                                 ir_node *const op1)
+{
+	/* packed memory operands must be 16 byte aligned, so do not match AM */
+	return gen_binop_xmm(node, op0, op1, get_vector_binop_func(node), 0);
+}
+
+/**
+ * Creates an SSE binop with the already transformed operands @p op0 and
+ * @p op1 in registers.
+ */
+static ir_node *new_xmm_binop_reg(dbg_info *const dbgi, ir_node *const block,
+                                  ir_node *const op0, ir_node *const op1,
+                                  construct_binop_func const make_node)
+{
+	amd64_binop_addr_attr_t const attr = {
+		.base = {
+			.base = {
+				.op_mode = AMD64_OP_REG_REG,
+				.size    = X86_SIZE_64,
+			},
+			.addr = {
+				.variant    = X86_ADDR_REG,
+				.base_input = 0,
+			},
+		},
+		.u.reg_input = 1,
+	};
+	ir_node *const in[]     = { op0, op1 };
+	ir_node *const new_node = make_node(dbgi, block, ARRAY_SIZE(in), in,
+	                                    amd64_xmm_xmm_reqs, &attr);
+	arch_set_irn_register_req_out(new_node, 0, &amd64_requirement_xmm_same_0);
+	return be_new_Proj(new_node, pn_amd64_subs_res);
+}
+
 typedef ir_node *(*construct_x87_binop_func)(
 		dbg_info *dbgi, ir_node *block, ir_node *op0, ir_node *op1);
 
@@ -1128,6 +1210,8 @@ static ir_node *gen_Add(ir_node *const node)
 	ir_mode *const mode  = get_irn_mode(node);
 	ir_node *const block = get_nodes_block(node);
 
+	if (mode_is_vector(mode))
+		return gen_vector_binop(node, op1, op2);
 	if (mode_is_float(mode)) {
 		if (mode == x86_mode_E)
 			return gen_binop_x87(node, op1, op2, new_bd_amd64_fadd);
@@ -1171,6 +1255,8 @@ static ir_node *gen_Sub(ir_node *const node)
 	ir_node *const op2  = get_Sub_right(node);
 	ir_mode *const mode = get_irn_mode(node);
 
+	if (mode_is_vector(mode))
+		return gen_vector_binop(node, op1, op2);
 	if (mode_is_float(mode)) {
 		if (mode == x86_mode_E)
 			return gen_binop_x87(node, op1, op2, new_bd_amd64_fsub);
@@ -1194,6 +1280,8 @@ static ir_node *gen_And(ir_node *const node)
 {
 	ir_node *const op1 = get_And_left(node);
 	ir_node *const op2 = get_And_right(node);
+	if (mode_is_vector(get_irn_mode(node)))
+		return gen_vector_binop(node, op1, op2);
 
 	/* Is it a zero extension? */
 	if (is_Const(op2)) {
@@ -1224,6 +1312,8 @@ static ir_node *gen_Eor(ir_node *const node)
 {
 	ir_node *const op1 = get_Eor_left(node);
 	ir_node *const op2 = get_Eor_right(node);
+	if (mode_is_vector(get_irn_mode(node)))
+		return gen_vector_binop(node, op1, op2);
 	return gen_binop_am(node, op1, op2, new_bd_amd64_xor, pn_amd64_xor_res,
 	                    match_immediate | match_am | match_mode_neutral
 	                    | match_commutative);
@@ -1233,6 +1323,8 @@ static ir_node *gen_Or(ir_node *const node)
 {
 	ir_node *const op1 = get_Or_left(node);
 	ir_node *const op2 = get_Or_right(node);
+	if (mode_is_vector(get_irn_mode(node)))
+		return gen_vector_binop(node, op1, op2);
 	return gen_binop_am(node, op1, op2, new_bd_amd64_or, pn_amd64_or_res,
 	                    match_immediate | match_am | match_mode_neutral
 	                    | match_commutative);
@@ -1244,7 +1336,9 @@ static ir_node *gen_Mul(ir_node *const node)
 	ir_node *const op2  = get_Mul_right(node);
 	ir_mode *const mode = get_irn_mode(node);
 
-	if (get_mode_size_bits(mode) < 16) {
+	if (mode_is_vector(mode)) {
+		return gen_vector_binop(node, op1, op2);
+	} else if (get_mode_size_bits(mode) < 16) {
 		/* imulb only supports rax - reg form */
 		ir_node *new_node
 			= gen_binop_rax(node, op1, op2, new_bd_amd64_imul_1op,
@@ -1886,7 +1980,10 @@ static ir_node *make_store_for_mode(ir_mode *const mode, dbg_info *const dbgi, i
 {
 	construct_binop_func               cons;
 	arch_register_req_t const **const *reqs;
-	if (!mode_is_float(mode)) {
+	if (mode_is_vector(mode)) {
+		cons = &new_bd_amd64_movdqu_store;
+		reqs = xmm_am_reqs;
+	} else if (!mode_is_float(mode)) {
 		cons = &new_bd_amd64_mov_store;
 		reqs = gp_am_reqs;
 	} else if (mode == x86_mode_E) {
@@ -2290,6 +2387,8 @@ static ir_node *gen_Phi(ir_node *const node)
 		req = mode == x86_mode_E
 		    ? &amd64_class_reg_req_x87
 		    : &amd64_class_reg_req_xmm;
+	} else if (mode_is_vector(mode)) {
+		req = &amd64_class_reg_req_xmm;
 	} else {
 		req = arch_memory_req;
 	}
@@ -2880,6 +2979,13 @@ static ir_node *gen_Load(ir_node *const node)
 	in[arity++]      = new_mem;
 	assert((size_t)arity <= ARRAY_SIZE(in));
 
+	if (mode_is_vector(mode)) {
+		ir_node *const new_load = new_bd_amd64_movdqu(dbgi, block, arity, in,
+		                                              reqs, AMD64_OP_ADDR, addr);
+		set_irn_pinned(new_load, get_irn_pinned(node));
+		return new_load;
+	}
+
 	create_mov_func   const cons      =
 		mode_is_float(mode)                                   ?
 			(mode == x86_mode_E ? new_bd_amd64_fld : &new_bd_amd64_movs_xmm) :
@@ -2953,6 +3059,13 @@ static ir_node *gen_Proj_Load(ir_node *const node)
 			return be_new_Proj(new_load, pn_amd64_fld_M);
 		}
 		break;
+	case iro_amd64_movdqu:
+		if (pn == pn_Load_res) {
+			return be_new_Proj(new_load, pn_amd64_movdqu_res);
+		} else if (pn == pn_Load_M) {
+			return be_new_Proj(new_load, pn_amd64_movdqu_M);
+		}
+		break;
 	case iro_amd64_add:
 	case iro_amd64_and:
 	case iro_amd64_cmp:
@@ -3351,6 +3464,39 @@ static ir_node *gen_Bitcast(ir_node *const node)
 	}
 }
 
+static ir_node *gen_Splat(ir_node *const node)
+{
+	dbg_info *const dbgi   = get_irn_dbg_info(node);
+	ir_node  *const block  = be_transform_nodes_block(node);
+	ir_node  *const op     = get_Splat_op(node);
+	ir_mode  *const elem   = get_irn_mode(op);
+	unsigned  const bits   = get_mode_size_bits(elem);
+	ir_node  *const new_op = be_transform_node(op);
+
+	/* bring the value into the lowest element of an xmm register */
+	ir_node *res;
+	if (mode_is_float(elem)) {
+		res = new_op;
+	} else {
+		x86_addr_t const addr = {
+			.base_input = 0,
+			.variant    = X86_ADDR_REG,
+		};
+		x86_insn_size_t const size = bits == 64 ? X86_SIZE_64 : X86_SIZE_32;
+		res = new_bd_amd64_movd_gp_xmm(dbgi, block, new_op, size, AMD64_OP_REG,
+		                               addr);
+	}
+
+	/* then double the number of copies in the low half until it is full */
+	if (bits <= 8)
+		res = new_xmm_binop_reg(dbgi, block, res, res, new_bd_amd64_punpcklbw);
+	if (bits <= 16)
+		res = new_xmm_binop_reg(dbgi, block, res, res, new_bd_amd64_punpcklwd);
+	if (bits <= 32)
+		res = new_xmm_binop_reg(dbgi, block, res, res, new_bd_amd64_punpckldq);
+	return new_xmm_binop_reg(dbgi, block, res, res, new_bd_amd64_punpcklqdq);
+}
+
 static ir_node *gen_amd64_l_punpckldq(ir_node *const node)
 {
 	ir_node *const op0 = get_irn_n(node, n_amd64_l_punpckldq_arg0);
@@ -3407,6 +3553,7 @@ static void amd64_register_transformers(void)
 	be_set_transform_function(op_Shl,               gen_Shl);
 	be_set_transform_function(op_Shr,               gen_Shr);
 	be_set_transform_function(op_Shrs,              gen_Shrs);
+	be_set_transform_function(op_Splat,             gen_Splat);
 	be_set_transform_function(op_Start,             gen_Start);
 	be_set_transform_function(op_Store,             gen_Store);
 	be_set_transform_function(op_Sub,               gen_Sub);
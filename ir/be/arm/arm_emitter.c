@@ -448,12 +448,12 @@ static void emit_arm_asm_operand(ir_node const *const node, char const modifier,
 				be_emit_char('~');
 			be_gas_emit_entity(op->ent);
 			if (op->val != 0)
-				be_emit_irprintf("%+" PRId32, op->val);
+				be_emit_signed(op->val, true);
 		} else {
 			int32_t val = op->val;
 			if (modifier == 'B')
 				val = ~val;
-			be_emit_irprintf("%" PRId32, val);
+			be_emit_signed(val, false);
 		}
 		return;
 
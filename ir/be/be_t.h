@@ -142,6 +142,10 @@ bool be_set_arch(char const *arch);
  * @defgroup beconvenience Convenience Function for driving code generation.
  * @{
  */
+/**
+ * Begins code generation for the current program. With a NULL @p output no
+ * assembly is written, the target writes an object file instead.
+ */
 void be_begin(FILE *output, const char *cup_name);
 void be_finish(void);
 
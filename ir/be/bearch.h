@@ -256,6 +256,15 @@ static inline bool reg_req_has_constraint(const arch_register_req_t *req)
 	return req->limited || req->must_be_different != 0 || req->ignore || req->width != 1;
 }
 
+/**
+ * Scheduling properties of an instruction on the selected CPU.
+ */
+typedef struct be_sched_info_t {
+	unsigned latency;    /**< cycles until the result is available */
+	unsigned throughput; /**< cycles an execution port is busy */
+	unsigned ports;      /**< bitset of the ports able to execute it */
+} be_sched_info_t;
+
 /**
  * Architecture interface.
  */
@@ -291,10 +300,39 @@ struct arch_isa_if_t {
 	 */
 	void (*generate_code)(FILE *output, const char *cup_name);
 
+	/**
+	 * Writes the current firm program as relocatable object file. May be
+	 * NULL if the target only emits assembly.
+	 */
+	void (*generate_object)(FILE *output, const char *cup_name);
+
 	ir_jit_function_t* (*jit_compile)(ir_jit_segment_t *segment, ir_graph *irg);
 
 	void (*emit_function)(char *buffer, ir_jit_function_t *function);
 
+	/**
+	 * Writes a lazy compilation stub to @p buffer. The stub jumps to the
+	 * address stored at @p target and passes @p target in a scratch register.
+	 * Returns the size of the stub, only the size is computed if @p buffer is
+	 * NULL.
+	 */
+	unsigned (*emit_jit_stub)(char *buffer, void *const *target);
+
+	/**
+	 * Writes the code unresolved stubs jump to. It calls @p resolve with the
+	 * value passed by the stub, keeps the argument registers and continues at
+	 * the returned address. Returns the size like emit_jit_stub.
+	 */
+	unsigned (*emit_jit_resolver)(char *buffer,
+	                              void *(*resolve)(void *const *target));
+
+	/**
+	 * Returns the code generation settings the target derived from its
+	 * options and the host CPU as @p *size bytes without pointers. May be
+	 * NULL if the options determine the generated code.
+	 */
+	void const *(*get_resolved_config)(size_t *size);
+
 	/**
 	 * lowers current program for target. See the documentation for
 	 * be_lower_for_target() for details.
@@ -322,6 +360,13 @@ struct arch_isa_if_t {
 	 * number of cycles necessary to execute the instruction.
 	 */
 	unsigned (*get_op_estimated_cost)(const ir_node *irn);
+
+	/**
+	 * Get the scheduling properties of node @p irn from the machine model of
+	 * the selected CPU. Returns the number of instructions issued per cycle.
+	 * May be NULL if there is no machine model.
+	 */
+	unsigned (*get_sched_info)(const ir_node *irn, be_sched_info_t *info);
 };
 
 static inline bool arch_irn_is_ignore(const ir_node *irn)
@@ -18,6 +18,11 @@
  * to change as many edges to fallthroughs as possible, this is done by setting
  * a next and prev pointers on blocks. The greedy algorithm sorts the edges by
  * execution frequencies and tries to transform them to fallthroughs in this order
+ *
+ * The Ext-TSP algorithm (Newell, Pupyrev: Improved Basic Block Reordering)
+ * additionally rewards short forward and backward jumps and merges whole chains
+ * of blocks, possibly splitting one of them. Rarely executed chains are placed
+ * at the end of the function and may be emitted into a separate section.
  */
 #include "beblocksched.h"
 
@@ -31,11 +36,22 @@
 #include "irgmod.h"
 #include "irgwalk.h"
 #include "irnode_t.h"
+#include "irtools.h"
+#include "lc_opts.h"
+#include "lc_opts_enum.h"
 #include "pdeq.h"
 #include "util.h"
 
 DEBUG_ONLY(static firm_dbg_module_t *dbg = NULL;)
 
+typedef enum blocksched_algo_t {
+	BLOCKSCHED_GREEDY,
+	BLOCKSCHED_EXTTSP,
+} blocksched_algo_t;
+
+static int  algo         = BLOCKSCHED_EXTTSP;
+static bool cold_section = false;
+
 static bool blocks_removed;
 
 /**
@@ -142,6 +158,7 @@ struct blocksched_entry_t {
 	ir_node            *block;
 	blocksched_entry_t *next;
 	blocksched_entry_t *prev;
+	unsigned            index; /**< index in the Ext-TSP layout */
 };
 
 typedef struct edge_t edge_t;
@@ -161,6 +178,7 @@ typedef struct blocksched_env_t blocksched_env_t;
 struct blocksched_env_t {
 	ir_graph       *irg;
 	struct obstack  obst;
+	ir_node       **blocks;
 	edge_t         *edges;
 	deq_t           worklist;
 	unsigned        blockcount;
@@ -189,6 +207,7 @@ static void collect_egde_frequency(ir_node *block, void *data)
 	blocksched_entry_t *entry = OALLOCZ(&env->obst, blocksched_entry_t);
 	entry->block = block;
 	set_irn_link(block, entry);
+	ARR_APP1(ir_node*, env->blocks, block);
 
 	int arity = get_Block_n_cfgpreds(block);
 	if (arity == 0) {
@@ -532,10 +551,504 @@ static ir_node **create_blocksched_array(blocksched_env_t *const env)
 	return block_list;
 }
 
+/** Score of a fallthrough of a conditional jump. */
+#define FALLTHROUGH_WEIGHT 1.0
+/**
+ * Score of a fallthrough of an unconditional jump. Missing it costs an
+ * additional jump instruction, so it is worth more than a conditional one;
+ * this makes loops end with their conditional latch instead of a jump back
+ * to the header.
+ */
+#define FALLTHROUGH_UNCOND_WEIGHT 1.5
+/** Score of a forward jump of distance 0. */
+#define FORWARD_WEIGHT     0.1
+/** Score of a backward jump of distance 0. */
+#define BACKWARD_WEIGHT    0.1
+/** Maximal distance (bytes) of a forward jump which still scores. */
+#define FORWARD_DISTANCE   1024
+/** Maximal distance (bytes) of a backward jump which still scores. */
+#define BACKWARD_DISTANCE  640
+/** Minimal score improvement of a merge. */
+#define MIN_GAIN           1e-9
+/** Chains longer than this are not split while merging. */
+#define MAX_SPLIT_LENGTH   128
+/** Blocks executed at most this often per function call are cold. */
+#define COLD_FREQ          1e-3
+/** Estimated size of an instruction in bytes. */
+#define INSN_SIZE          4
+
+typedef struct layout_edge_t {
+	unsigned src;    /**< index of the source block */
+	unsigned dst;    /**< index of the destination block */
+	double   weight; /**< execution frequency of the edge */
+	bool     uncond; /**< the source block has no other successor */
+} layout_edge_t;
+
+typedef struct layout_chain_t {
+	unsigned *blocks;  /**< block indices in layout order */
+	unsigned *edges;   /**< edges with at least one endpoint in the chain */
+	double    score;   /**< Ext-TSP score of the chain */
+	double    freq;    /**< sum of the block frequencies */
+	unsigned  size;    /**< estimated size in bytes */
+	bool      cold;    /**< all blocks are rarely executed */
+	bool      dead;    /**< the chain has been merged into another one */
+} layout_chain_t;
+
+typedef enum merge_kind_t {
+	MERGE_X_Y,
+	MERGE_Y_X,
+	MERGE_X1_Y_X2,
+	MERGE_Y_X2_X1,
+	MERGE_X2_X1_Y,
+} merge_kind_t;
+
+typedef struct merge_t {
+	unsigned     x;     /**< chain which might be split */
+	unsigned     y;     /**< chain which is inserted */
+	unsigned     split; /**< split position in x */
+	merge_kind_t kind;
+	double       gain;  /**< score improvement */
+} merge_t;
+
+typedef struct layout_env_t {
+	unsigned        n_blocks;
+	ir_node       **blocks;
+	double         *freqs;
+	unsigned       *sizes;
+	unsigned       *chain_of;  /**< chain index of each block */
+	unsigned       *addr;      /**< scratch: address of each block */
+	unsigned       *mark;      /**< scratch: visit marks of blocks */
+	unsigned       *seq;       /**< scratch: merged block sequence */
+	unsigned       *edge_mark; /**< scratch: visit marks of edges */
+	unsigned       *chain_mark;/**< scratch: visit marks of chains */
+	unsigned        visited;
+	layout_edge_t  *edges;
+	layout_chain_t *chains;
+	merge_t        *merges;
+} layout_env_t;
+
+static double ext_tsp_score(unsigned src_end, unsigned dst,
+                            layout_edge_t const *edge)
+{
+	double const weight = edge->weight;
+	if (src_end == dst)
+		return weight * (edge->uncond ? FALLTHROUGH_UNCOND_WEIGHT
+		                              : FALLTHROUGH_WEIGHT);
+	if (src_end < dst) {
+		unsigned const dist = dst - src_end;
+		if (dist <= FORWARD_DISTANCE)
+			return weight * FORWARD_WEIGHT
+			     * (1.0 - (double)dist / FORWARD_DISTANCE);
+	} else {
+		unsigned const dist = src_end - dst;
+		if (dist <= BACKWARD_DISTANCE)
+			return weight * BACKWARD_WEIGHT
+			     * (1.0 - (double)dist / BACKWARD_DISTANCE);
+	}
+	return 0.0;
+}
+
+/**
+ * Computes the score of the block sequence @p seq. Only the edges in the
+ * lists @p edges0 and @p edges1 (which may be NULL) are considered.
+ */
+static double score_sequence(layout_env_t *env, unsigned const *seq,
+                             unsigned len, unsigned const *edges0,
+                             unsigned const *edges1)
+{
+	unsigned const visited = ++env->visited;
+	unsigned       addr    = 0;
+	for (unsigned i = 0; i < len; ++i) {
+		unsigned const b = seq[i];
+		env->addr[b] = addr;
+		env->mark[b] = visited;
+		addr += env->sizes[b];
+	}
+
+	double score = 0.0;
+	for (unsigned l = 0; l < 2; ++l) {
+		unsigned const *const list = l == 0 ? edges0 : edges1;
+		if (list == NULL)
+			continue;
+		for (size_t i = 0, n = ARR_LEN(list); i < n; ++i) {
+			unsigned const e = list[i];
+			if (env->edge_mark[e] == visited)
+				continue;
+			env->edge_mark[e] = visited;
+			layout_edge_t const *const edge = &env->edges[e];
+			if (env->mark[edge->src] != visited
+			 || env->mark[edge->dst] != visited)
+				continue;
+			unsigned const src_end = env->addr[edge->src] + env->sizes[edge->src];
+			score += ext_tsp_score(src_end, env->addr[edge->dst], edge);
+		}
+	}
+	return score;
+}
+
+static unsigned append_blocks(unsigned *seq, unsigned len,
+                              unsigned const *blocks, unsigned from,
+                              unsigned to)
+{
+	for (unsigned i = from; i < to; ++i)
+		seq[len++] = blocks[i];
+	return len;
+}
+
+/** Writes the sequence resulting from merge @p m to env->seq. */
+static unsigned build_sequence(layout_env_t *env, merge_t const *m)
+{
+	unsigned const *const x     = env->chains[m->x].blocks;
+	unsigned const *const y     = env->chains[m->y].blocks;
+	unsigned        const x_len = ARR_LEN(x);
+	unsigned        const y_len = ARR_LEN(y);
+	unsigned        const split = m->split;
+	unsigned       *const seq   = env->seq;
+	unsigned              len   = 0;
+	switch (m->kind) {
+	case MERGE_X_Y:
+		len = append_blocks(seq, len, x, 0, x_len);
+		len = append_blocks(seq, len, y, 0, y_len);
+		return len;
+	case MERGE_Y_X:
+		len = append_blocks(seq, len, y, 0, y_len);
+		len = append_blocks(seq, len, x, 0, x_len);
+		return len;
+	case MERGE_X1_Y_X2:
+		len = append_blocks(seq, len, x, 0, split);
+		len = append_blocks(seq, len, y, 0, y_len);
+		len = append_blocks(seq, len, x, split, x_len);
+		return len;
+	case MERGE_Y_X2_X1:
+		len = append_blocks(seq, len, y, 0, y_len);
+		len = append_blocks(seq, len, x, split, x_len);
+		len = append_blocks(seq, len, x, 0, split);
+		return len;
+	case MERGE_X2_X1_Y:
+		len = append_blocks(seq, len, x, split, x_len);
+		len = append_blocks(seq, len, x, 0, split);
+		len = append_blocks(seq, len, y, 0, y_len);
+		return len;
+	}
+	panic("invalid merge kind");
+}
+
+/** Evaluates merge @p m and updates @p best if it is better. */
+static void try_merge(layout_env_t *env, merge_t *m, merge_t *best)
+{
+	/* the start block (index 0) has to stay in front */
+	unsigned const len         = build_sequence(env, m);
+	unsigned const entry_chain = env->chain_of[0];
+	if (env->seq[0] != 0 && (entry_chain == m->x || entry_chain == m->y))
+		return;
+
+	layout_chain_t const *const x = &env->chains[m->x];
+	layout_chain_t const *const y = &env->chains[m->y];
+	m->gain = score_sequence(env, env->seq, len, x->edges, y->edges)
+	        - x->score - y->score;
+	if (m->gain > best->gain)
+		*best = *m;
+}
+
+/** Finds the best way to merge chain @p y into chain @p x. */
+static void find_merge(layout_env_t *env, unsigned x_idx, unsigned y_idx,
+                       merge_t *best)
+{
+	merge_t m = { .x = x_idx, .y = y_idx, .split = 0 };
+	m.kind = MERGE_X_Y;
+	try_merge(env, &m, best);
+	m.kind = MERGE_Y_X;
+	try_merge(env, &m, best);
+
+	layout_chain_t const *const x     = &env->chains[x_idx];
+	layout_chain_t const *const y     = &env->chains[y_idx];
+	unsigned              const x_len = ARR_LEN(x->blocks);
+	if (x_len < 2 || x_len > MAX_SPLIT_LENGTH)
+		return;
+
+	/* only split x next to blocks connected with y, other splits cannot
+	 * create new fallthroughs */
+	bool *const splits = ALLOCANZ(bool, x_len);
+	for (unsigned i = 0; i < x_len; ++i)
+		env->addr[x->blocks[i]] = i;
+	for (size_t i = 0, n = ARR_LEN(y->edges); i < n; ++i) {
+		layout_edge_t const *const edge = &env->edges[y->edges[i]];
+		unsigned split;
+		if (env->chain_of[edge->src] == x_idx)
+			split = env->addr[edge->src] + 1;
+		else if (env->chain_of[edge->dst] == x_idx)
+			split = env->addr[edge->dst];
+		else
+			continue;
+		if (split < x_len)
+			splits[split] = true;
+	}
+
+	for (unsigned split = 1; split < x_len; ++split) {
+		if (!splits[split])
+			continue;
+		m.split = split;
+		m.kind  = MERGE_X1_Y_X2;
+		try_merge(env, &m, best);
+		m.kind  = MERGE_Y_X2_X1;
+		try_merge(env, &m, best);
+		m.kind  = MERGE_X2_X1_Y;
+		try_merge(env, &m, best);
+	}
+}
+
+/** Adds the best merges of chain @p c with its neighbours. */
+static void add_merges(layout_env_t *env, unsigned c)
+{
+	layout_chain_t const *const chain   = &env->chains[c];
+	unsigned              const visited = ++env->visited;
+	env->chain_mark[c] = visited;
+	for (size_t i = 0, n = ARR_LEN(chain->edges); i < n; ++i) {
+		layout_edge_t const *const edge  = &env->edges[chain->edges[i]];
+		unsigned             const other = env->chain_of[edge->src] == c
+			? env->chain_of[edge->dst] : env->chain_of[edge->src];
+		if (env->chain_mark[other] == visited)
+			continue;
+		env->chain_mark[other] = visited;
+		/* never mix hot and cold code */
+		if (env->chains[other].cold != chain->cold)
+			continue;
+
+		merge_t best = { .gain = MIN_GAIN };
+		find_merge(env, c, other, &best);
+		find_merge(env, other, c, &best);
+		if (best.gain > MIN_GAIN)
+			ARR_APP1(merge_t, env->merges, best);
+	}
+}
+
+static void apply_merge(layout_env_t *env, merge_t const *m)
+{
+	layout_chain_t *const x = &env->chains[m->x];
+	layout_chain_t *const y = &env->chains[m->y];
+	DB((dbg, LEVEL_2, "merge chains %u and %u (kind %d, split %u, gain %.3g)\n",
+	    m->x, m->y, m->kind, m->split, m->gain));
+
+	unsigned const len = build_sequence(env, m);
+	ARR_RESIZE(unsigned, x->blocks, len);
+	MEMCPY(x->blocks, env->seq, len);
+	for (size_t i = 0, n = ARR_LEN(y->blocks); i < n; ++i)
+		env->chain_of[y->blocks[i]] = m->x;
+
+	/* merge the edge lists, dropping duplicates */
+	unsigned const visited = ++env->visited;
+	for (size_t i = 0, n = ARR_LEN(x->edges); i < n; ++i)
+		env->edge_mark[x->edges[i]] = visited;
+	for (size_t i = 0, n = ARR_LEN(y->edges); i < n; ++i) {
+		unsigned const e = y->edges[i];
+		if (env->edge_mark[e] != visited)
+			ARR_APP1(unsigned, x->edges, e);
+	}
+
+	x->score += y->score + m->gain;
+	x->freq  += y->freq;
+	x->size  += y->size;
+	y->dead   = true;
+	DEL_ARR_F(y->blocks);
+	DEL_ARR_F(y->edges);
+
+	/* drop the merges of the old chains */
+	size_t n_merges = 0;
+	for (size_t i = 0, n = ARR_LEN(env->merges); i < n; ++i) {
+		merge_t const *const other = &env->merges[i];
+		if (other->x == m->x || other->x == m->y
+		 || other->y == m->x || other->y == m->y)
+			continue;
+		env->merges[n_merges++] = *other;
+	}
+	ARR_SHRINKLEN(env->merges, n_merges);
+}
+
+static void merge_chains(layout_env_t *env)
+{
+	env->merges = NEW_ARR_F(merge_t, 0);
+	for (unsigned c = 0; c < env->n_blocks; ++c)
+		add_merges(env, c);
+
+	for (;;) {
+		merge_t const *best = NULL;
+		for (size_t i = 0, n = ARR_LEN(env->merges); i < n; ++i) {
+			merge_t const *const m = &env->merges[i];
+			if (best == NULL || m->gain > best->gain)
+				best = m;
+		}
+		if (best == NULL)
+			break;
+
+		merge_t const m = *best;
+		apply_merge(env, &m);
+		add_merges(env, m.x);
+	}
+	DEL_ARR_F(env->merges);
+}
+
+static layout_env_t *cmp_env;
+
+static int cmp_chains(const void *d1, const void *d2)
+{
+	unsigned       const c1 = *(const unsigned*)d1;
+	unsigned       const c2 = *(const unsigned*)d2;
+	layout_chain_t const *const chain1 = &cmp_env->chains[c1];
+	layout_chain_t const *const chain2 = &cmp_env->chains[c2];
+	/* the chain with the start block comes first, cold chains last */
+	if (chain1->blocks[0] == 0 || chain2->blocks[0] == 0)
+		return chain1->blocks[0] == 0 ? -1 : 1;
+	if (chain1->cold != chain2->cold)
+		return chain1->cold ? 1 : -1;
+	/* then by decreasing density */
+	double const density1 = chain1->freq / chain1->size;
+	double const density2 = chain2->freq / chain2->size;
+	if (density1 != density2)
+		return density1 > density2 ? -1 : 1;
+	return QSORT_CMP(chain1->blocks[0], chain2->blocks[0]);
+}
+
+static unsigned get_block_size(ir_node *block)
+{
+	unsigned n_insns = 0;
+	sched_foreach(block, node) {
+		if (!is_Phi(node))
+			++n_insns;
+	}
+	return MAX(n_insns, 1) * INSN_SIZE;
+}
+
+/** Converts the collected cfg edges to edges between layout blocks. */
+static void collect_layout_edges(layout_env_t *env, blocksched_env_t *benv)
+{
+	env->edges = NEW_ARR_F(layout_edge_t, 0);
+	for (size_t i = 0, n = ARR_LEN(benv->edges); i < n; ++i) {
+		edge_t  const *const edge  = &benv->edges[i];
+		ir_node const *const block = edge->block;
+		if (is_Bad(get_Block_cfgpred(block, 0)))
+			continue;
+		ir_node const *const pred = get_Block_cfgpred(block, edge->pos);
+		if (is_Bad(pred))
+			continue;
+		layout_edge_t const layout_edge = {
+			.src    = get_blocksched_entry(get_nodes_block(pred))->index,
+			.dst    = get_blocksched_entry(block)->index,
+			.weight = edge->execfreq,
+			.uncond = !is_Proj(pred),
+		};
+		ARR_APP1(layout_edge_t, env->edges, layout_edge);
+	}
+}
+
+static ir_node **create_exttsp_schedule(blocksched_env_t *const benv)
+{
+	ir_graph *const irg         = benv->irg;
+	ir_node  *const start_block = get_irg_start_block(irg);
+
+	/* collect the remaining blocks, start block first */
+	layout_env_t env;
+	memset(&env, 0, sizeof(env));
+	env.blocks = NEW_ARR_F(ir_node*, 0);
+	ARR_APP1(ir_node*, env.blocks, start_block);
+	for (size_t i = 0, n = ARR_LEN(benv->blocks); i < n; ++i) {
+		ir_node *const block = benv->blocks[i];
+		if (block != start_block && !is_Bad(get_Block_cfgpred(block, 0)))
+			ARR_APP1(ir_node*, env.blocks, block);
+	}
+	unsigned const n_blocks = ARR_LEN(env.blocks);
+	env.n_blocks   = n_blocks;
+	env.freqs      = XMALLOCN(double, n_blocks);
+	env.sizes      = XMALLOCN(unsigned, n_blocks);
+	env.chain_of   = XMALLOCN(unsigned, n_blocks);
+	env.addr       = XMALLOCN(unsigned, n_blocks);
+	env.mark       = XMALLOCNZ(unsigned, n_blocks);
+	env.seq        = XMALLOCN(unsigned, n_blocks);
+	env.chain_mark = XMALLOCNZ(unsigned, n_blocks);
+	env.chains     = XMALLOCNZ(layout_chain_t, n_blocks);
+	for (unsigned i = 0; i < n_blocks; ++i) {
+		ir_node *const block = env.blocks[i];
+		get_blocksched_entry(block)->index = i;
+		env.freqs[i]    = get_block_execfreq(block);
+		env.sizes[i]    = get_block_size(block);
+		env.chain_of[i] = i;
+	}
+
+	collect_layout_edges(&env, benv);
+	env.edge_mark = XMALLOCNZ(unsigned, ARR_LEN(env.edges));
+
+	/* every block starts in its own chain */
+	double const entry_freq = env.freqs[0];
+	for (unsigned i = 0; i < n_blocks; ++i) {
+		layout_chain_t *const chain = &env.chains[i];
+		chain->blocks = NEW_ARR_F(unsigned, 1);
+		chain->blocks[0] = i;
+		chain->edges  = NEW_ARR_F(unsigned, 0);
+		chain->freq   = env.freqs[i];
+		chain->size   = env.sizes[i];
+		chain->cold   = i != 0 && env.freqs[i] <= COLD_FREQ * entry_freq;
+	}
+	for (size_t e = 0, n = ARR_LEN(env.edges); e < n; ++e) {
+		layout_edge_t const *const edge = &env.edges[e];
+		ARR_APP1(unsigned, env.chains[edge->src].edges, e);
+		if (edge->dst != edge->src)
+			ARR_APP1(unsigned, env.chains[edge->dst].edges, e);
+	}
+	for (unsigned i = 0; i < n_blocks; ++i) {
+		layout_chain_t *const chain = &env.chains[i];
+		chain->score = score_sequence(&env, chain->blocks, 1, chain->edges, NULL);
+	}
+
+	merge_chains(&env);
+
+	/* order the chains */
+	unsigned *order = NEW_ARR_F(unsigned, 0);
+	for (unsigned i = 0; i < n_blocks; ++i) {
+		if (!env.chains[i].dead)
+			ARR_APP1(unsigned, order, i);
+	}
+	cmp_env = &env;
+	QSORT_ARR(order, cmp_chains);
+
+	struct obstack *const obst       = be_get_be_obst(irg);
+	ir_node       **const block_list = NEW_ARR_D(ir_node*, obst, n_blocks);
+	be_irg_t       *const birg       = be_birg_from_irg(irg);
+	unsigned              pos        = 0;
+	birg->cold_block = NULL;
+	DB((dbg, LEVEL_1, "Blockschedule:\n"));
+	for (size_t c = 0, n = ARR_LEN(order); c < n; ++c) {
+		layout_chain_t *const chain = &env.chains[order[c]];
+		for (size_t i = 0, n_chain = ARR_LEN(chain->blocks); i < n_chain; ++i) {
+			ir_node *const block = env.blocks[chain->blocks[i]];
+			if (chain->cold && cold_section && birg->cold_block == NULL)
+				birg->cold_block = block;
+			block_list[pos++] = block;
+			DB((dbg, LEVEL_1, "\t%+F%s\n", block, chain->cold ? " (cold)" : ""));
+		}
+		DEL_ARR_F(chain->blocks);
+		DEL_ARR_F(chain->edges);
+	}
+	assert(pos == n_blocks);
+
+	DEL_ARR_F(order);
+	free(env.edge_mark);
+	DEL_ARR_F(env.edges);
+	free(env.chains);
+	free(env.chain_mark);
+	free(env.seq);
+	free(env.mark);
+	free(env.addr);
+	free(env.chain_of);
+	free(env.sizes);
+	free(env.freqs);
+	DEL_ARR_F(env.blocks);
+	return block_list;
+}
+
 ir_node **be_create_block_schedule(ir_graph *irg)
 {
 	blocksched_env_t env = {
 		.irg        = irg,
+		.blocks     = NEW_ARR_F(ir_node*, 0),
 		.edges      = NEW_ARR_F(edge_t, 0),
 		.blockcount = 0,
 	};
@@ -549,19 +1062,45 @@ ir_node **be_create_block_schedule(ir_graph *irg)
 
 	remove_empty_blocks(irg);
 
-	coalesce_blocks(&env);
-
-	ir_node **const block_list = create_blocksched_array(&env);
+	ir_node **block_list;
+	if (algo == BLOCKSCHED_EXTTSP) {
+		block_list = create_exttsp_schedule(&env);
+	} else {
+		coalesce_blocks(&env);
+		block_list = create_blocksched_array(&env);
+		be_birg_from_irg(irg)->cold_block = NULL;
+	}
 	ir_free_resources(irg, IR_RESOURCE_IRN_LINK);
 
 	DEL_ARR_F(env.edges);
+	DEL_ARR_F(env.blocks);
 	obstack_free(&env.obst, NULL);
 
 	return block_list;
 }
 
+static const lc_opt_enum_int_items_t algo_items[] = {
+	{ "greedy", BLOCKSCHED_GREEDY },
+	{ "exttsp", BLOCKSCHED_EXTTSP },
+	{ NULL,     0 }
+};
+
+static lc_opt_enum_int_var_t algo_var = {
+	&algo, algo_items
+};
+
+static const lc_opt_table_entry_t be_blocksched_options[] = {
+	LC_OPT_ENT_ENUM_INT("algo",        "block scheduling algorithm",                      &algo_var),
+	LC_OPT_ENT_BOOL    ("coldsection", "emit rarely executed blocks into .text.unlikely", &cold_section),
+	LC_OPT_LAST
+};
+
 BE_REGISTER_MODULE_CONSTRUCTOR(be_init_blocksched)
 void be_init_blocksched(void)
 {
+	lc_opt_entry_t *be_grp         = lc_opt_get_grp(firm_opt_get_root(), "be");
+	lc_opt_entry_t *blocksched_grp = lc_opt_get_grp(be_grp, "blocksched");
+
+	lc_opt_add_table(blocksched_grp, be_blocksched_options);
 	FIRM_DBG_REGISTER(dbg, "firm.be.blocksched");
 }
@@ -316,6 +316,11 @@ void be_dwarf_location(dbg_info *dbgi)
 	be_emit_write_line();
 }
 
+bool be_dwarf_has_frameinfo(void)
+{
+	return debug_level >= LEVEL_FRAMEINFO;
+}
+
 void be_dwarf_callframe_register(const arch_register_t *reg)
 {
 	if (debug_level < LEVEL_FRAMEINFO)
@@ -11,6 +11,8 @@
 #ifndef FIRM_BE_BEDWARF_H
 #define FIRM_BE_BEDWARF_H
 
+#include <stdbool.h>
+
 #include "be_types.h"
 
 typedef struct parameter_dbg_info_t {
@@ -47,6 +49,9 @@ void be_dwarf_variable(const ir_entity *ent);
  * assembly instructions */
 void be_dwarf_location(dbg_info *dbgi);
 
+/** Returns whether call frame information is generated. */
+bool be_dwarf_has_frameinfo(void);
+
 /** set base register that points to callframe */
 void be_dwarf_callframe_register(const arch_register_t *reg);
 
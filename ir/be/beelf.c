@@ -0,0 +1,1112 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2012 University of Karlsruhe.
+ */
+
+/**
+ * @file
+ * @brief       Writer for ELF64 relocatable object files.
+ *
+ * The sections and symbols mirror what the GNU assembler produces for the
+ * assembly written by begnuas.c: functions go to .text, global variables to
+ * .data, .rodata, .data.rel.ro or .bss and merged external variables become
+ * common symbols. Relocations are always written as RELA entries.
+ */
+#include "beelf.h"
+
+#include "array.h"
+#include "bitfiddle.h"
+#include "entity_t.h"
+#include "irnode_t.h"
+#include "irprog_t.h"
+#include "obst.h"
+#include "panic.h"
+#include "platform_t.h"
+#include "pmap.h"
+#include "target_t.h"
+#include "tv.h"
+#include "util.h"
+#include "xmalloc.h"
+#include <string.h>
+
+enum {
+	ELFCLASS64    = 2,
+	ELFDATA2LSB   = 1,
+	EV_CURRENT    = 1,
+	ET_REL        = 1,
+	SHT_NULL      = 0,
+	SHT_PROGBITS  = 1,
+	SHT_SYMTAB    = 2,
+	SHT_STRTAB    = 3,
+	SHT_RELA      = 4,
+	SHT_NOBITS    = 8,
+	SHF_WRITE     = 0x1,
+	SHF_ALLOC     = 0x2,
+	SHF_EXECINSTR = 0x4,
+	SHF_INFO_LINK = 0x40,
+	SHN_UNDEF     = 0,
+	SHN_COMMON    = 0xFFF2,
+	STB_LOCAL     = 0,
+	STB_GLOBAL    = 1,
+	STB_WEAK      = 2,
+	STT_NOTYPE    = 0,
+	STT_OBJECT    = 1,
+	STT_FUNC      = 2,
+	STT_SECTION   = 3,
+	STV_DEFAULT   = 0,
+	STV_HIDDEN    = 2,
+	STV_PROTECTED = 3,
+};
+
+typedef struct elf64_ehdr_t {
+	uint8_t  ident[16];
+	uint16_t type;
+	uint16_t machine;
+	uint32_t version;
+	uint64_t entry;
+	uint64_t phoff;
+	uint64_t shoff;
+	uint32_t flags;
+	uint16_t ehsize;
+	uint16_t phentsize;
+	uint16_t phnum;
+	uint16_t shentsize;
+	uint16_t shnum;
+	uint16_t shstrndx;
+} elf64_ehdr_t;
+
+typedef struct elf64_shdr_t {
+	uint32_t name;
+	uint32_t type;
+	uint64_t flags;
+	uint64_t addr;
+	uint64_t offset;
+	uint64_t size;
+	uint32_t link;
+	uint32_t info;
+	uint64_t addralign;
+	uint64_t entsize;
+} elf64_shdr_t;
+
+typedef struct elf64_sym_t {
+	uint32_t name;
+	uint8_t  info;
+	uint8_t  other;
+	uint16_t shndx;
+	uint64_t value;
+	uint64_t size;
+} elf64_sym_t;
+
+typedef struct elf64_rela_t {
+	uint64_t offset;
+	uint64_t info;
+	int64_t  addend;
+} elf64_rela_t;
+
+typedef enum elf_section_t {
+	ELF_SECTION_TEXT,
+	ELF_SECTION_DATA,
+	ELF_SECTION_RODATA,
+	ELF_SECTION_REL_RO_LOCAL,
+	ELF_SECTION_REL_RO,
+	ELF_SECTION_BSS,
+	ELF_SECTION_CTORS,
+	ELF_SECTION_DTORS,
+	ELF_SECTION_JCR,
+	ELF_SECTION_EH_FRAME,
+	ELF_SECTION_LAST = ELF_SECTION_EH_FRAME,
+	/** Pseudo section of undefined symbols. */
+	ELF_SECTION_UNDEFINED,
+	/** Pseudo section of common symbols. */
+	ELF_SECTION_COMMON,
+} elf_section_t;
+
+typedef struct elf_sectioninfo_t {
+	char const *name;
+	uint32_t    type;
+	uint32_t    flags;
+} elf_sectioninfo_t;
+
+static const elf_sectioninfo_t elf_sectioninfos[] = {
+	[ELF_SECTION_TEXT]         = { ".text",              SHT_PROGBITS, SHF_ALLOC | SHF_EXECINSTR },
+	[ELF_SECTION_DATA]         = { ".data",              SHT_PROGBITS, SHF_ALLOC | SHF_WRITE     },
+	[ELF_SECTION_RODATA]       = { ".rodata",            SHT_PROGBITS, SHF_ALLOC                 },
+	[ELF_SECTION_REL_RO_LOCAL] = { ".data.rel.ro.local", SHT_PROGBITS, SHF_ALLOC | SHF_WRITE     },
+	[ELF_SECTION_REL_RO]       = { ".data.rel.ro",       SHT_PROGBITS, SHF_ALLOC | SHF_WRITE     },
+	[ELF_SECTION_BSS]          = { ".bss",               SHT_NOBITS,   SHF_ALLOC | SHF_WRITE     },
+	[ELF_SECTION_CTORS]        = { ".ctors",             SHT_PROGBITS, SHF_ALLOC | SHF_WRITE     },
+	[ELF_SECTION_DTORS]        = { ".dtors",             SHT_PROGBITS, SHF_ALLOC | SHF_WRITE     },
+	[ELF_SECTION_JCR]          = { ".jcr",               SHT_PROGBITS, SHF_ALLOC | SHF_WRITE     },
+	[ELF_SECTION_EH_FRAME]     = { ".eh_frame",          SHT_PROGBITS, SHF_ALLOC                 },
+};
+
+typedef struct elf_symbol_t {
+	ir_entity    *entity;  /**< The entity, NULL for section symbols. */
+	elf_section_t section;
+	uint64_t      value;
+	uint64_t      size;
+	uint32_t      index;   /**< Index in the symbol table. */
+} elf_symbol_t;
+
+typedef struct elf_relocation_t {
+	uint64_t      offset;
+	uint32_t      type;
+	elf_symbol_t *symbol;
+	int64_t       addend;
+} elf_relocation_t;
+
+typedef struct elf_section_data_t {
+	char             *data;        /**< Contents, NULL for .bss. */
+	uint64_t          size;
+	unsigned          alignment;
+	elf_relocation_t *relocations;
+	elf_symbol_t      symbol;      /**< The section symbol. */
+	uint16_t          index;       /**< Index in the section header table. */
+} elf_section_data_t;
+
+struct be_elf_writer_t {
+	be_elf_target_t const *target;
+	elf_section_data_t     sections[ELF_SECTION_LAST + 1];
+	pmap                  *symbols;     /**< Maps entities to symbols. */
+	elf_symbol_t         **symbol_list; /**< Symbols in creation order. */
+	struct obstack         obst;
+	uint64_t               function;    /**< Text offset of the function. */
+	uint64_t               cie_offset;
+	bool                   has_cie;
+};
+
+be_elf_writer_t *be_elf_new(be_elf_target_t const *const target)
+{
+	if (ir_target_big_endian())
+		panic("object files are only supported for little endian targets");
+
+	be_elf_writer_t *const elf = XMALLOCZ(be_elf_writer_t);
+	elf->target      = target;
+	elf->symbols     = pmap_create();
+	elf->symbol_list = NEW_ARR_F(elf_symbol_t*, 0);
+	obstack_init(&elf->obst);
+	for (elf_section_t s = ELF_SECTION_TEXT; s <= ELF_SECTION_LAST; ++s) {
+		elf_section_data_t *const section = &elf->sections[s];
+		if (elf_sectioninfos[s].type != SHT_NOBITS)
+			section->data = NEW_ARR_F(char, 0);
+		section->alignment      = 1;
+		section->relocations    = NEW_ARR_F(elf_relocation_t, 0);
+		section->symbol.section = s;
+	}
+	elf->sections[ELF_SECTION_EH_FRAME].alignment = 8;
+	return elf;
+}
+
+void be_elf_free(be_elf_writer_t *const elf)
+{
+	for (elf_section_t s = ELF_SECTION_TEXT; s <= ELF_SECTION_LAST; ++s) {
+		elf_section_data_t *const section = &elf->sections[s];
+		if (section->data != NULL)
+			DEL_ARR_F(section->data);
+		DEL_ARR_F(section->relocations);
+	}
+	DEL_ARR_F(elf->symbol_list);
+	pmap_destroy(elf->symbols);
+	obstack_free(&elf->obst, NULL);
+	free(elf);
+}
+
+static elf_symbol_t *get_symbol(be_elf_writer_t *const elf,
+                                ir_entity *const entity)
+{
+	elf_symbol_t *symbol = pmap_get(elf_symbol_t, elf->symbols, entity);
+	if (symbol == NULL) {
+		symbol          = OALLOCZ(&elf->obst, elf_symbol_t);
+		symbol->entity  = entity;
+		symbol->section = ELF_SECTION_UNDEFINED;
+		pmap_insert(elf->symbols, entity, symbol);
+		ARR_APP1(elf_symbol_t*, elf->symbol_list, symbol);
+	}
+	return symbol;
+}
+
+/**
+ * Appends @p size zero bytes aligned to @p alignment to @p section and
+ * returns their offset. Alignment padding in .text is filled with nops.
+ */
+static uint64_t reserve(be_elf_writer_t *const elf, elf_section_t const s,
+                        uint64_t const size, unsigned const alignment)
+{
+	elf_section_data_t *const section = &elf->sections[s];
+	uint64_t const begin  = section->size;
+	uint64_t const offset = (begin + alignment - 1) & ~(uint64_t)(alignment - 1);
+	uint64_t const end    = offset + size;
+	section->size = end;
+	if (alignment > section->alignment)
+		section->alignment = alignment;
+	if (section->data == NULL)
+		return offset;
+
+	ARR_RESIZE(char, section->data, end);
+	memset(section->data + begin, 0, end - begin);
+	if (s == ELF_SECTION_TEXT && offset > begin && elf->target->nops != NULL)
+		elf->target->nops(section->data + begin, offset - begin);
+	return offset;
+}
+
+static void add_relocation(be_elf_writer_t *const elf, elf_section_t const s,
+                           uint64_t const offset, uint32_t const type,
+                           elf_symbol_t *const symbol, int64_t const addend)
+{
+	elf_relocation_t const relocation = {
+		.offset = offset,
+		.type   = type,
+		.symbol = symbol,
+		.addend = addend,
+	};
+	ARR_APP1(elf_relocation_t, elf->sections[s].relocations, relocation);
+}
+
+static void define_symbol(be_elf_writer_t *const elf, ir_entity *const entity,
+                          elf_section_t const section, uint64_t const value,
+                          uint64_t const size)
+{
+	elf_symbol_t *const symbol = get_symbol(elf, entity);
+	if (symbol->section != ELF_SECTION_UNDEFINED)
+		panic("%+F defined twice", entity);
+	symbol->section = section;
+	symbol->value   = value;
+	symbol->size    = size;
+}
+
+char *be_elf_begin_function(be_elf_writer_t *const elf,
+                            ir_entity *const entity, unsigned const size,
+                            unsigned const p2align)
+{
+	uint64_t const offset = reserve(elf, ELF_SECTION_TEXT, size, 1u << p2align);
+	define_symbol(elf, entity, ELF_SECTION_TEXT, offset, size);
+	elf->function = offset;
+	return elf->sections[ELF_SECTION_TEXT].data + offset;
+}
+
+uint64_t be_elf_get_text_offset(be_elf_writer_t const *const elf,
+                                char const *const location)
+{
+	char const *const text = elf->sections[ELF_SECTION_TEXT].data;
+	assert(location >= text && location <= text + ARR_LEN(text));
+	return location - text;
+}
+
+void be_elf_add_text_relocation(be_elf_writer_t *const elf,
+                                char const *const location,
+                                uint32_t const type, ir_entity *const entity,
+                                int64_t const addend)
+{
+	uint64_t const offset = be_elf_get_text_offset(elf, location);
+	assert(offset >= elf->function);
+	add_relocation(elf, ELF_SECTION_TEXT, offset, type,
+	               get_symbol(elf, entity), addend);
+}
+
+static void append_bytes(be_elf_writer_t *const elf, elf_section_t const s,
+                         void const *const bytes, size_t const size)
+{
+	uint64_t const offset = reserve(elf, s, size, 1);
+	memcpy(elf->sections[s].data + offset, bytes, size);
+}
+
+static void append_u8(be_elf_writer_t *const elf, elf_section_t const s,
+                      uint8_t const value)
+{
+	append_bytes(elf, s, &value, sizeof(value));
+}
+
+static void append_u32(be_elf_writer_t *const elf, elf_section_t const s,
+                       uint32_t const value)
+{
+	append_bytes(elf, s, &value, sizeof(value));
+}
+
+static void append_leb128(be_elf_writer_t *const elf, elf_section_t const s,
+                          int64_t value, bool const is_signed)
+{
+	for (;;) {
+		uint8_t byte = value & 0x7F;
+		value >>= 7;
+		bool const done = is_signed
+			? (value == 0 && !(byte & 0x40)) || (value == -1 && (byte & 0x40))
+			: (uint64_t)value == 0;
+		if (!done)
+			byte |= 0x80;
+		append_u8(elf, s, byte);
+		if (done)
+			return;
+	}
+}
+
+/** Pads the current .eh_frame record with nops and patches its length. */
+static void finish_eh_record(be_elf_writer_t *const elf, uint64_t const begin)
+{
+	elf_section_t const s = ELF_SECTION_EH_FRAME;
+	while (elf->sections[s].size % 8 != 0)
+		append_u8(elf, s, DW_CFA_nop);
+	uint32_t const length = elf->sections[s].size - begin - 4;
+	memcpy(elf->sections[s].data + begin, &length, sizeof(length));
+}
+
+static void add_cie(be_elf_writer_t *const elf)
+{
+	elf_section_t          const s      = ELF_SECTION_EH_FRAME;
+	be_elf_target_t const *const target = elf->target;
+	uint64_t               const begin  = elf->sections[s].size;
+	elf->cie_offset = begin;
+	elf->has_cie    = true;
+
+	append_u32(elf, s, 0);            /* length */
+	append_u32(elf, s, 0);            /* CIE id */
+	append_u8(elf, s, 1);             /* version */
+	append_bytes(elf, s, "zR", 3);    /* augmentation */
+	append_leb128(elf, s, 1, false);  /* code alignment factor */
+	append_leb128(elf, s, target->data_align, true);
+	append_u8(elf, s, target->ra_register);
+	append_leb128(elf, s, 1, false);  /* augmentation data length */
+	append_u8(elf, s, 0x1B);          /* FDE encoding: pcrel sdata4 */
+	append_bytes(elf, s, target->cie_instructions,
+	             target->n_cie_instructions);
+	finish_eh_record(elf, begin);
+}
+
+void be_elf_add_fde(be_elf_writer_t *const elf, uint64_t const begin,
+                    uint64_t const size, uint8_t const *const instructions,
+                    unsigned const n_instructions)
+{
+	if (!elf->has_cie)
+		add_cie(elf);
+
+	elf_section_t const s      = ELF_SECTION_EH_FRAME;
+	uint64_t      const record = elf->sections[s].size;
+	append_u32(elf, s, 0); /* length */
+	append_u32(elf, s, record + 4 - elf->cie_offset);
+	uint64_t const pc_begin = elf->sections[s].size;
+	append_u32(elf, s, 0);
+	add_relocation(elf, s, pc_begin, elf->target->reloc_pc32,
+	               &elf->sections[ELF_SECTION_TEXT].symbol, begin);
+	append_u32(elf, s, size);
+	append_leb128(elf, s, 0, false); /* augmentation data length */
+	append_bytes(elf, s, instructions, n_instructions);
+	finish_eh_record(elf, record);
+}
+
+void be_elf_add_jump_table(be_elf_writer_t *const elf,
+                           ir_entity *const entity,
+                           uint64_t const *const targets, unsigned long const n,
+                           bool const relative)
+{
+	elf_section_t const s          = ELF_SECTION_RODATA;
+	unsigned      const entry_size = relative ? 4 : 8;
+	uint64_t      const offset     = reserve(elf, s, n * entry_size, entry_size);
+	define_symbol(elf, entity, s, offset, n * entry_size);
+
+	be_elf_target_t const *const target = elf->target;
+	elf_symbol_t          *const text   = &elf->sections[ELF_SECTION_TEXT].symbol;
+	for (unsigned long i = 0; i < n; ++i) {
+		uint64_t const entry = offset + i * entry_size;
+		if (relative) {
+			/* the entry is relative to the table, not to itself */
+			add_relocation(elf, s, entry, target->reloc_pc32, text,
+			               targets[i] + i * entry_size);
+		} else {
+			add_relocation(elf, s, entry, target->reloc_abs64, text,
+			               targets[i]);
+		}
+	}
+}
+
+static bool initializer_is_null(ir_initializer_t const *const initializer)
+{
+	switch (get_initializer_kind(initializer)) {
+	case IR_INITIALIZER_NULL:
+		return true;
+	case IR_INITIALIZER_TARVAL:
+		return tarval_is_null(get_initializer_tarval_value(initializer));
+	case IR_INITIALIZER_CONST: {
+		ir_node *const value = get_initializer_const_value(initializer);
+		return is_Const(value) && is_Const_null(value);
+	}
+	case IR_INITIALIZER_COMPOUND:
+		for (size_t i = 0, n = get_initializer_compound_n_entries(initializer);
+		     i < n; ++i) {
+			if (!initializer_is_null(
+					get_initializer_compound_value(initializer, i)))
+				return false;
+		}
+		return true;
+	}
+	panic("invalid initializer");
+}
+
+static bool entity_is_zero_initialized(ir_entity const *const entity)
+{
+	if (is_alias_entity(entity))
+		return false;
+	ir_initializer_t const *const initializer = get_entity_initializer(entity);
+	return initializer != NULL && initializer_is_null(initializer);
+}
+
+/** Returns whether @p node references non-local symbols. */
+static bool has_global_relocations(ir_node const *const node, bool *const any)
+{
+	switch (get_irn_opcode(node)) {
+	case iro_Conv:
+		return has_global_relocations(get_Conv_op(node), any);
+	case iro_Address: {
+		ir_visibility const visibility
+			= get_entity_visibility(get_Address_entity(node));
+		*any = true;
+		return visibility != ir_visibility_local
+		    && visibility != ir_visibility_private;
+	}
+	case iro_Add:
+	case iro_Sub:
+	case iro_Mul: {
+		bool const left  = has_global_relocations(get_binop_left(node), any);
+		bool const right = has_global_relocations(get_binop_right(node), any);
+		return left || right;
+	}
+	default:
+		return false;
+	}
+}
+
+static bool initializer_has_global_relocations(
+		ir_initializer_t const *const initializer, bool *const any)
+{
+	switch (get_initializer_kind(initializer)) {
+	case IR_INITIALIZER_NULL:
+	case IR_INITIALIZER_TARVAL:
+		return false;
+	case IR_INITIALIZER_CONST:
+		return has_global_relocations(get_initializer_const_value(initializer),
+		                              any);
+	case IR_INITIALIZER_COMPOUND: {
+		bool res = false;
+		for (size_t i = 0, n = get_initializer_compound_n_entries(initializer);
+		     i < n; ++i) {
+			res |= initializer_has_global_relocations(
+				get_initializer_compound_value(initializer, i), any);
+		}
+		return res;
+	}
+	}
+	panic("invalid initializer");
+}
+
+static elf_section_t determine_section(ir_entity const *const entity)
+{
+	ir_type *const owner = get_entity_owner(entity);
+	if (owner == get_segment_type(IR_SEGMENT_CONSTRUCTORS))
+		return ELF_SECTION_CTORS;
+	if (owner == get_segment_type(IR_SEGMENT_DESTRUCTORS))
+		return ELF_SECTION_DTORS;
+	if (owner == get_segment_type(IR_SEGMENT_JCR))
+		return ELF_SECTION_JCR;
+	if (owner == get_segment_type(IR_SEGMENT_THREAD_LOCAL))
+		panic("thread local %+F not supported in object files", entity);
+
+	if (get_entity_linkage(entity) & IR_LINKAGE_CONSTANT) {
+		if (ir_platform.pic_style != BE_PIC_NONE) {
+			bool any = false;
+			bool const global = initializer_has_global_relocations(
+				get_entity_initializer(entity), &any);
+			if (global)
+				return ELF_SECTION_REL_RO;
+			if (any)
+				return ELF_SECTION_REL_RO_LOCAL;
+		}
+		return ELF_SECTION_RODATA;
+	}
+	if (entity_is_zero_initialized(entity))
+		return ELF_SECTION_BSS;
+	return ELF_SECTION_DATA;
+}
+
+static size_t get_initializer_size(ir_initializer_t const *const initializer,
+                                   ir_type *const type)
+{
+	if (get_initializer_kind(initializer) != IR_INITIALIZER_COMPOUND)
+		return get_type_size(type);
+
+	if (is_Array_type(type)) {
+		if (get_array_size(type) != 0)
+			return get_type_size(type);
+		ir_type *const element_type  = get_array_element_type(type);
+		unsigned const element_size  = get_type_size(element_type);
+		unsigned const element_align = get_type_alignment(element_type);
+		return get_initializer_compound_n_entries(initializer)
+		     * round_up2(element_size, element_align);
+	}
+
+	/* The last member may be an array of flexible size. */
+	size_t       size = get_type_size(type);
+	size_t const n    = get_initializer_compound_n_entries(initializer);
+	if (n != 0) {
+		ir_type *const last_type
+			= get_entity_type(get_compound_member(type, n - 1));
+		if (is_Array_type(last_type) && get_array_size(last_type) == 0)
+			size += get_initializer_size(
+				get_initializer_compound_value(initializer, n - 1), last_type);
+	}
+	return size;
+}
+
+static unsigned get_effective_entity_alignment(ir_entity const *const entity)
+{
+	unsigned const alignment = get_entity_alignment(entity);
+	if (alignment != 0)
+		return alignment;
+	return get_type_alignment(get_entity_type(entity));
+}
+
+static void write_tarval(char *const dst, ir_tarval *const tv,
+                         size_t const size)
+{
+	unsigned const n_bytes = (get_mode_size_bits(get_tarval_mode(tv)) + 7) / 8;
+	for (size_t i = 0; i < size && i < n_bytes; ++i)
+		dst[i] = get_tarval_sub_bits(tv, i);
+}
+
+/**
+ * Evaluates a constant expression to an entity plus an offset. @p entity
+ * is set to NULL for plain numbers.
+ */
+static int64_t eval_expression(ir_node *const node, ir_entity **const entity)
+{
+	switch (get_irn_opcode(node)) {
+	case iro_Conv:
+		return eval_expression(get_Conv_op(node), entity);
+	case iro_Const: {
+		ir_tarval *const tv      = get_Const_tarval(node);
+		unsigned   const n_bytes = MIN(get_mode_size_bytes(get_tarval_mode(tv)),
+		                               8);
+		uint64_t value = 0;
+		for (unsigned i = 0; i < n_bytes; ++i)
+			value |= (uint64_t)get_tarval_sub_bits(tv, i) << (8 * i);
+		/* sign extend */
+		if (n_bytes < 8 && mode_is_signed(get_tarval_mode(tv))
+		 && (value >> (8 * n_bytes - 1)) & 1)
+			value |= ~UINT64_C(0) << (8 * n_bytes);
+		return (int64_t)value;
+	}
+	case iro_Address:
+		if (*entity != NULL)
+			panic("initializer %+F references several entities", node);
+		*entity = get_Address_entity(node);
+		return 0;
+	case iro_Offset:
+		return get_entity_offset(get_Offset_entity(node));
+	case iro_Align:
+		return get_type_alignment(get_Align_type(node));
+	case iro_Size:
+		return get_type_size(get_Size_type(node));
+	case iro_Add:
+		return eval_expression(get_Add_left(node), entity)
+		     + eval_expression(get_Add_right(node), entity);
+	case iro_Sub: {
+		int64_t    const left  = eval_expression(get_Sub_left(node), entity);
+		ir_entity       *right_entity = NULL;
+		int64_t    const right = eval_expression(get_Sub_right(node),
+		                                         &right_entity);
+		if (right_entity != NULL)
+			panic("difference of addresses in %+F not supported", node);
+		return left - right;
+	}
+	case iro_Mul: {
+		ir_entity *left_entity  = NULL;
+		ir_entity *right_entity = NULL;
+		int64_t const left  = eval_expression(get_Mul_left(node), &left_entity);
+		int64_t const right = eval_expression(get_Mul_right(node),
+		                                      &right_entity);
+		if (left_entity != NULL || right_entity != NULL)
+			panic("product of addresses in %+F not supported", node);
+		return left * right;
+	}
+	case iro_Unknown:
+		return 0;
+	default:
+		panic("unsupported IR-node %+F in initializer", node);
+	}
+}
+
+static void write_node(be_elf_writer_t *const elf, elf_section_t const s,
+                       uint64_t const offset, ir_node *const node,
+                       ir_type *const type)
+{
+	char  *const dst  = elf->sections[s].data + offset;
+	size_t const size = get_type_size(type);
+	if (is_Const(node)) {
+		write_tarval(dst, get_Const_tarval(node), size);
+		return;
+	}
+
+	ir_entity *entity = NULL;
+	int64_t    value  = eval_expression(node, &entity);
+	if (entity != NULL) {
+		uint32_t type_reloc;
+		if (size == 8) {
+			type_reloc = elf->target->reloc_abs64;
+		} else if (size == 4) {
+			type_reloc = elf->target->reloc_abs32;
+		} else {
+			panic("address in initializer of size %zu", size);
+		}
+		add_relocation(elf, s, offset, type_reloc, get_symbol(elf, entity),
+		               value);
+		value = 0;
+	}
+	for (size_t i = 0; i < size && i < 8; ++i)
+		dst[i] = (char)(value >> (8 * i));
+}
+
+static void write_bitfield(be_elf_writer_t *const elf, elf_section_t const s,
+                           uint64_t const offset, unsigned const offset_bits,
+                           unsigned const bitfield_size,
+                           ir_initializer_t const *const initializer)
+{
+	ir_tarval *tv;
+	switch (get_initializer_kind(initializer)) {
+	case IR_INITIALIZER_NULL:
+		return;
+	case IR_INITIALIZER_TARVAL:
+		tv = get_initializer_tarval_value(initializer);
+		break;
+	case IR_INITIALIZER_CONST: {
+		ir_node *const node = get_initializer_const_value(initializer);
+		if (!is_Const(node))
+			panic("bitfield initializer not a Const node");
+		tv = get_Const_tarval(node);
+		break;
+	}
+	default:
+		panic("bitfield initializer is compound");
+	}
+
+	char *const dst = elf->sections[s].data + offset;
+	for (unsigned bit = 0; bit < bitfield_size; ++bit) {
+		unsigned const src_byte = get_tarval_sub_bits(tv, bit / 8);
+		if ((src_byte >> (bit % 8)) & 1) {
+			unsigned const dst_bit = offset_bits + bit;
+			dst[dst_bit / 8] |= 1 << (dst_bit % 8);
+		}
+	}
+}
+
+static void write_initializer(be_elf_writer_t *const elf,
+                              elf_section_t const s, uint64_t const offset,
+                              ir_initializer_t const *const initializer,
+                              ir_type *const type)
+{
+	switch (get_initializer_kind(initializer)) {
+	case IR_INITIALIZER_NULL:
+		return;
+	case IR_INITIALIZER_TARVAL:
+		write_tarval(elf->sections[s].data + offset,
+		             get_initializer_tarval_value(initializer),
+		             get_type_size(type));
+		return;
+	case IR_INITIALIZER_CONST:
+		write_node(elf, s, offset, get_initializer_const_value(initializer),
+		           type);
+		return;
+	case IR_INITIALIZER_COMPOUND:
+		if (is_Array_type(type)) {
+			ir_type *const element_type = get_array_element_type(type);
+			unsigned const stride = round_up2(get_type_size(element_type),
+			                                  get_type_alignment(element_type));
+			for (size_t i = 0, n = get_initializer_compound_n_entries(initializer);
+			     i < n; ++i) {
+				write_initializer(elf, s, offset + i * stride,
+				                  get_initializer_compound_value(initializer, i),
+				                  element_type);
+			}
+		} else {
+			for (size_t i = 0, n = get_compound_n_members(type); i < n; ++i) {
+				ir_entity *const member = get_compound_member(type, i);
+				uint64_t   const member_offset
+					= offset + get_entity_offset(member);
+				ir_initializer_t const *const sub
+					= get_initializer_compound_value(initializer, i);
+				unsigned const bitfield_size = get_entity_bitfield_size(member);
+				if (bitfield_size > 0) {
+					write_bitfield(elf, s, member_offset,
+					               get_entity_bitfield_offset(member),
+					               bitfield_size, sub);
+				} else {
+					write_initializer(elf, s, member_offset, sub,
+					                  get_entity_type(member));
+				}
+			}
+		}
+		return;
+	}
+	panic("invalid initializer");
+}
+
+static void add_global(be_elf_writer_t *const elf, ir_entity *const entity)
+{
+	ir_entity_kind const kind = get_entity_kind(entity);
+	/* functions are added with their code, aliases once all symbols exist */
+	if (kind == IR_ENTITY_LABEL || kind == IR_ENTITY_METHOD
+	 || kind == IR_ENTITY_ALIAS)
+		return;
+
+	ir_visibility const visibility = get_entity_visibility(entity);
+	ir_linkage    const linkage    = get_entity_linkage(entity);
+	bool          const zero_init  = entity_is_zero_initialized(entity);
+	ir_initializer_t const *const initializer = get_entity_initializer(entity);
+	ir_type *const type      = get_entity_type(entity);
+	unsigned const alignment = get_effective_entity_alignment(entity);
+	size_t         size      = initializer != NULL
+		? get_initializer_size(initializer, type) : get_type_size(type);
+	if (size == 0)
+		size = 1;
+
+	if (linkage & IR_LINKAGE_MERGE || zero_init) {
+		bool const is_external = visibility != ir_visibility_local
+		                      && visibility != ir_visibility_private;
+		if (is_external && linkage & IR_LINKAGE_MERGE) {
+			/* common symbols keep their alignment in the value */
+			define_symbol(elf, entity, ELF_SECTION_COMMON, alignment, size);
+			return;
+		} else if (!is_external && !(linkage & IR_LINKAGE_CONSTANT)) {
+			uint64_t const offset = reserve(elf, ELF_SECTION_BSS, size,
+			                                alignment);
+			define_symbol(elf, entity, ELF_SECTION_BSS, offset, size);
+			return;
+		}
+	}
+
+	if (!entity_has_definition(entity))
+		return;
+
+	elf_section_t const s = determine_section(entity);
+	if (!is_po2_or_zero(alignment))
+		panic("alignment not a power of 2");
+	uint64_t const offset = reserve(elf, s, size, MAX(alignment, 1));
+	define_symbol(elf, entity, s, offset, size);
+	if (!zero_init)
+		write_initializer(elf, s, offset, initializer, type);
+}
+
+static void add_globals_of(be_elf_writer_t *const elf, ir_type *const segment)
+{
+	for (size_t i = 0, n = get_compound_n_members(segment); i < n; ++i) {
+		ir_entity *const entity = get_compound_member(segment, i);
+		if (!(get_entity_linkage(entity) & IR_LINKAGE_NO_CODEGEN))
+			add_global(elf, entity);
+	}
+}
+
+static void add_aliases_of(be_elf_writer_t *const elf, ir_type *const segment)
+{
+	for (size_t i = 0, n = get_compound_n_members(segment); i < n; ++i) {
+		ir_entity *const entity = get_compound_member(segment, i);
+		if (!is_alias_entity(entity)
+		 || get_entity_linkage(entity) & IR_LINKAGE_NO_CODEGEN)
+			continue;
+		elf_symbol_t const *const target
+			= get_symbol(elf, get_entity_alias(entity));
+		if (target->section == ELF_SECTION_UNDEFINED
+		 || target->section == ELF_SECTION_COMMON)
+			panic("alias %+F of a symbol not defined here", entity);
+		define_symbol(elf, entity, target->section, target->value,
+		              target->size);
+	}
+}
+
+void be_elf_add_globals(be_elf_writer_t *const elf)
+{
+	ir_type *const tls = get_tls_type();
+	for (size_t i = 0, n = get_compound_n_members(tls); i < n; ++i) {
+		ir_entity *const entity = get_compound_member(tls, i);
+		if (!(get_entity_linkage(entity) & IR_LINKAGE_NO_CODEGEN))
+			panic("thread local %+F not supported in object files", entity);
+	}
+
+	static const ir_segment_t segments[] = {
+		IR_SEGMENT_GLOBAL, IR_SEGMENT_CONSTRUCTORS, IR_SEGMENT_DESTRUCTORS,
+		IR_SEGMENT_JCR,
+	};
+	for (size_t i = 0; i < ARRAY_SIZE(segments); ++i)
+		add_globals_of(elf, get_segment_type(segments[i]));
+	for (size_t i = 0; i < ARRAY_SIZE(segments); ++i)
+		add_aliases_of(elf, get_segment_type(segments[i]));
+}
+
+static bool is_local_symbol(elf_symbol_t const *const symbol)
+{
+	if (symbol->entity == NULL)
+		return true;
+	ir_visibility const visibility = get_entity_visibility(symbol->entity);
+	return symbol->section != ELF_SECTION_UNDEFINED
+	    && (visibility == ir_visibility_local
+	     || visibility == ir_visibility_private);
+}
+
+static uint8_t get_symbol_info(elf_symbol_t const *const symbol)
+{
+	ir_entity const *const entity = symbol->entity;
+	uint8_t binding;
+	if (is_local_symbol(symbol)) {
+		binding = STB_LOCAL;
+	} else if (get_entity_linkage(entity) & IR_LINKAGE_WEAK
+	        || (symbol->section != ELF_SECTION_UNDEFINED
+	         && symbol->section != ELF_SECTION_COMMON
+	         && get_entity_linkage(entity) & IR_LINKAGE_MERGE)) {
+		/* mergeable definitions are made weak instead of using COMDAT
+		 * groups */
+		binding = STB_WEAK;
+	} else {
+		binding = STB_GLOBAL;
+	}
+
+	uint8_t type;
+	if (entity == NULL) {
+		type = STT_SECTION;
+	} else if (symbol->section == ELF_SECTION_UNDEFINED) {
+		type = STT_NOTYPE;
+	} else {
+		ir_entity const *const target = is_alias_entity(entity)
+			? get_entity_alias(entity) : entity;
+		type = is_method_entity(target) ? STT_FUNC : STT_OBJECT;
+	}
+	return binding << 4 | type;
+}
+
+static uint8_t get_symbol_other(elf_symbol_t const *const symbol)
+{
+	if (symbol->entity == NULL || symbol->section == ELF_SECTION_UNDEFINED)
+		return STV_DEFAULT;
+	switch (get_entity_visibility(symbol->entity)) {
+	case ir_visibility_external_private:   return STV_HIDDEN;
+	case ir_visibility_external_protected: return STV_PROTECTED;
+	default:                               return STV_DEFAULT;
+	}
+}
+
+static uint32_t add_string(char **const strtab, char const *const str)
+{
+	uint32_t const offset = ARR_LEN(*strtab);
+	size_t   const len    = strlen(str) + 1;
+	ARR_RESIZE(char, *strtab, offset + len);
+	memcpy(*strtab + offset, str, len);
+	return offset;
+}
+
+static void write_padding(FILE *const output, uint64_t *const pos,
+                          uint64_t const alignment)
+{
+	while (*pos % alignment != 0) {
+		fputc(0, output);
+		++*pos;
+	}
+}
+
+static void write_data(FILE *const output, uint64_t *const pos,
+                       void const *const data, size_t const size)
+{
+	if (size > 0 && fwrite(data, 1, size, output) != size)
+		panic("could not write object file");
+	*pos += size;
+}
+
+void be_elf_write(be_elf_writer_t *const elf, FILE *const output)
+{
+	/* Sections: null, the used allocated sections, .note.GNU-stack, the
+	 * relocation sections, .symtab, .strtab, .shstrtab */
+	elf64_shdr_t *shdr_list = NEW_ARR_FZ(elf64_shdr_t, 1);
+	char         *shstrtab  = NEW_ARR_F(char, 0);
+	char         *strtab    = NEW_ARR_F(char, 0);
+	add_string(&shstrtab, "");
+	add_string(&strtab, "");
+
+	for (elf_section_t s = ELF_SECTION_TEXT; s <= ELF_SECTION_LAST; ++s) {
+		elf_section_data_t *const section = &elf->sections[s];
+		if (section->size == 0 && s != ELF_SECTION_TEXT)
+			continue;
+		elf_sectioninfo_t const *const info = &elf_sectioninfos[s];
+		elf64_shdr_t const shdr = {
+			.name      = add_string(&shstrtab, info->name),
+			.type      = info->type,
+			.flags     = info->flags,
+			.size      = section->size,
+			.addralign = section->alignment,
+		};
+		section->index = ARR_LEN(shdr_list);
+		ARR_APP1(elf64_shdr_t, shdr_list, shdr);
+	}
+	elf64_shdr_t const note = {
+		.name      = add_string(&shstrtab, ".note.GNU-stack"),
+		.type      = SHT_PROGBITS,
+		.addralign = 1,
+	};
+	ARR_APP1(elf64_shdr_t, shdr_list, note);
+
+	/* Symbols: null, section symbols, local symbols and global symbols. */
+	elf64_sym_t *syms = NEW_ARR_FZ(elf64_sym_t, 1);
+	for (elf_section_t s = ELF_SECTION_TEXT; s <= ELF_SECTION_LAST; ++s) {
+		elf_section_data_t *const section = &elf->sections[s];
+		if (section->index == 0)
+			continue;
+		section->symbol.index = ARR_LEN(syms);
+		elf64_sym_t const sym = {
+			.info  = STB_LOCAL << 4 | STT_SECTION,
+			.shndx = section->index,
+		};
+		ARR_APP1(elf64_sym_t, syms, sym);
+	}
+	uint32_t first_global = 0;
+	for (int global = 0; global < 2; ++global) {
+		if (global)
+			first_global = ARR_LEN(syms);
+		for (size_t i = 0, n = ARR_LEN(elf->symbol_list); i < n; ++i) {
+			elf_symbol_t *const symbol = elf->symbol_list[i];
+			if (is_local_symbol(symbol) == (global != 0))
+				continue;
+			uint16_t shndx;
+			switch (symbol->section) {
+			case ELF_SECTION_UNDEFINED: shndx = SHN_UNDEF;  break;
+			case ELF_SECTION_COMMON:    shndx = SHN_COMMON; break;
+			default: shndx = elf->sections[symbol->section].index; break;
+			}
+			symbol->index = ARR_LEN(syms);
+			elf64_sym_t const sym = {
+				.name  = add_string(&strtab,
+				                    get_entity_ld_name(symbol->entity)),
+				.info  = get_symbol_info(symbol),
+				.other = get_symbol_other(symbol),
+				.shndx = shndx,
+				.value = symbol->value,
+				.size  = symbol->size,
+			};
+			ARR_APP1(elf64_sym_t, syms, sym);
+		}
+	}
+
+	/* the symbol table follows the relocation sections */
+	size_t const n_alloc_shdrs = ARR_LEN(shdr_list);
+	size_t       n_relas       = 0;
+	for (elf_section_t s = ELF_SECTION_TEXT; s <= ELF_SECTION_LAST; ++s) {
+		if (elf->sections[s].index != 0
+		 && ARR_LEN(elf->sections[s].relocations) > 0)
+			++n_relas;
+	}
+	uint32_t const symtab_index = n_alloc_shdrs + n_relas;
+	for (elf_section_t s = ELF_SECTION_TEXT; s <= ELF_SECTION_LAST; ++s) {
+		elf_section_data_t const *const section = &elf->sections[s];
+		size_t const n = ARR_LEN(section->relocations);
+		if (section->index == 0 || n == 0)
+			continue;
+		char name[64];
+		snprintf(name, sizeof(name), ".rela%s", elf_sectioninfos[s].name);
+		elf64_shdr_t const shdr = {
+			.name      = add_string(&shstrtab, name),
+			.type      = SHT_RELA,
+			.flags     = SHF_INFO_LINK,
+			.size      = n * sizeof(elf64_rela_t),
+			.link      = symtab_index,
+			.info      = section->index,
+			.addralign = 8,
+			.entsize   = sizeof(elf64_rela_t),
+		};
+		ARR_APP1(elf64_shdr_t, shdr_list, shdr);
+	}
+	elf64_shdr_t const symtab = {
+		.name      = add_string(&shstrtab, ".symtab"),
+		.type      = SHT_SYMTAB,
+		.size      = ARR_LEN(syms) * sizeof(elf64_sym_t),
+		.link      = symtab_index + 1,
+		.info      = first_global,
+		.addralign = 8,
+		.entsize   = sizeof(elf64_sym_t),
+	};
+	ARR_APP1(elf64_shdr_t, shdr_list, symtab);
+	elf64_shdr_t const strtab_shdr = {
+		.name      = add_string(&shstrtab, ".strtab"),
+		.type      = SHT_STRTAB,
+		.addralign = 1,
+	};
+	ARR_APP1(elf64_shdr_t, shdr_list, strtab_shdr);
+	elf64_shdr_t const shstrtab_shdr = {
+		.name      = add_string(&shstrtab, ".shstrtab"),
+		.type      = SHT_STRTAB,
+		.addralign = 1,
+	};
+	ARR_APP1(elf64_shdr_t, shdr_list, shstrtab_shdr);
+	size_t const n_shdrs = ARR_LEN(shdr_list);
+	shdr_list[n_shdrs - 2].size = ARR_LEN(strtab);
+	shdr_list[n_shdrs - 1].size = ARR_LEN(shstrtab);
+
+	/* Lay out the file: header, section contents, section headers. */
+	uint64_t pos = sizeof(elf64_ehdr_t);
+	for (size_t i = 1; i < n_shdrs; ++i) {
+		elf64_shdr_t *const shdr = &shdr_list[i];
+		if (shdr->type == SHT_NOBITS) {
+			shdr->offset = pos;
+			continue;
+		}
+		uint64_t const align = shdr->addralign > 0 ? shdr->addralign : 1;
+		pos = (pos + align - 1) & ~(align - 1);
+		shdr->offset = pos;
+		pos += shdr->size;
+	}
+	uint64_t const shoff = (pos + 7) & ~UINT64_C(7);
+
+	elf64_ehdr_t const ehdr = {
+		.ident     = { 0x7F, 'E', 'L', 'F', ELFCLASS64, ELFDATA2LSB,
+		               EV_CURRENT },
+		.type      = ET_REL,
+		.machine   = elf->target->machine,
+		.version   = EV_CURRENT,
+		.shoff     = shoff,
+		.ehsize    = sizeof(elf64_ehdr_t),
+		.shentsize = sizeof(elf64_shdr_t),
+		.shnum     = n_shdrs,
+		.shstrndx  = n_shdrs - 1,
+	};
+	pos = 0;
+	write_data(output, &pos, &ehdr, sizeof(ehdr));
+	size_t rela_shdr = n_alloc_shdrs;
+	for (elf_section_t s = ELF_SECTION_TEXT; s <= ELF_SECTION_LAST; ++s) {
+		elf_section_data_t const *const section = &elf->sections[s];
+		if (section->index == 0 || section->data == NULL)
+			continue;
+		write_padding(output, &pos, shdr_list[section->index].addralign);
+		write_data(output, &pos, section->data, section->size);
+	}
+	for (elf_section_t s = ELF_SECTION_TEXT; s <= ELF_SECTION_LAST; ++s) {
+		elf_section_data_t const *const section = &elf->sections[s];
+		size_t const n = ARR_LEN(section->relocations);
+		if (section->index == 0 || n == 0)
+			continue;
+		write_padding(output, &pos, 8);
+		assert(pos == shdr_list[rela_shdr].offset);
+		++rela_shdr;
+		for (size_t r = 0; r < n; ++r) {
+			elf_relocation_t const *const relocation = &section->relocations[r];
+			elf64_rela_t const rela = {
+				.offset = relocation->offset,
+				.info   = (uint64_t)relocation->symbol->index << 32
+				        | relocation->type,
+				.addend = relocation->addend,
+			};
+			write_data(output, &pos, &rela, sizeof(rela));
+		}
+	}
+	write_padding(output, &pos, 8);
+	write_data(output, &pos, syms, ARR_LEN(syms) * sizeof(elf64_sym_t));
+	write_data(output, &pos, strtab, ARR_LEN(strtab));
+	write_data(output, &pos, shstrtab, ARR_LEN(shstrtab));
+	write_padding(output, &pos, 8);
+	assert(pos == shoff);
+	write_data(output, &pos, shdr_list, n_shdrs * sizeof(elf64_shdr_t));
+
+	DEL_ARR_F(shdr_list);
+	DEL_ARR_F(syms);
+	DEL_ARR_F(strtab);
+	DEL_ARR_F(shstrtab);
+}
@@ -0,0 +1,95 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2012 University of Karlsruhe.
+ */
+
+/**
+ * @file
+ * @brief       Writer for ELF64 relocatable object files.
+ */
+#ifndef FIRM_BE_BEELF_H
+#define FIRM_BE_BEELF_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "firm_types.h"
+
+/** Call frame instructions used in .eh_frame. */
+enum {
+	DW_CFA_nop                = 0x00,
+	DW_CFA_advance_loc1       = 0x02,
+	DW_CFA_advance_loc2       = 0x03,
+	DW_CFA_advance_loc4       = 0x04,
+	DW_CFA_def_cfa            = 0x0C,
+	DW_CFA_def_cfa_register   = 0x0D,
+	DW_CFA_def_cfa_offset     = 0x0E,
+	DW_CFA_advance_loc        = 0x40,
+	DW_CFA_offset             = 0x80,
+};
+
+/** Description of the target architecture of an object file. */
+typedef struct be_elf_target_t {
+	uint16_t machine;       /**< The e_machine field. */
+	uint32_t reloc_abs32;   /**< Relocation for 32bit absolute data. */
+	uint32_t reloc_abs64;   /**< Relocation for 64bit absolute data. */
+	uint32_t reloc_pc32;    /**< Relocation for 32bit PC relative data. */
+	uint8_t  ra_register;   /**< DWARF number of the return address. */
+	int8_t   data_align;    /**< Data alignment factor of the CIE. */
+	/** Call frame instructions describing the state at function entry. */
+	uint8_t const *cie_instructions;
+	unsigned       n_cie_instructions;
+	/** Fills @p size bytes of padding in the code section. */
+	void (*nops)(char *buffer, unsigned size);
+} be_elf_target_t;
+
+typedef struct be_elf_writer_t be_elf_writer_t;
+
+be_elf_writer_t *be_elf_new(be_elf_target_t const *target);
+
+void be_elf_free(be_elf_writer_t *elf);
+
+/**
+ * Reserves @p size bytes for the code of function @p entity in the text
+ * section and returns the buffer to emit it into. The buffer stays valid
+ * until the next function is begun.
+ */
+char *be_elf_begin_function(be_elf_writer_t *elf, ir_entity *entity,
+                            unsigned size, unsigned p2align);
+
+/** Returns the offset of @p location in the text section. */
+uint64_t be_elf_get_text_offset(be_elf_writer_t const *elf,
+                                char const *location);
+
+/**
+ * Records a relocation of type @p type for the code at @p location, which
+ * must be in the buffer of the current function.
+ */
+void be_elf_add_text_relocation(be_elf_writer_t *elf, char const *location,
+                                uint32_t type, ir_entity *entity,
+                                int64_t addend);
+
+/**
+ * Adds a frame description entry for the code at [@p begin, @p begin +
+ * @p size) in the text section.
+ */
+void be_elf_add_fde(be_elf_writer_t *elf, uint64_t begin, uint64_t size,
+                    uint8_t const *instructions, unsigned n_instructions);
+
+/**
+ * Adds the jump table @p entity with @p n entries to the read-only data.
+ * Entry i holds the address of offset @p targets[i] in the text section or,
+ * if @p relative is set, its 32bit distance from the table.
+ */
+void be_elf_add_jump_table(be_elf_writer_t *elf, ir_entity *entity,
+                           uint64_t const *targets, unsigned long n,
+                           bool relative);
+
+/** Adds the global variables and aliases of the program. */
+void be_elf_add_globals(be_elf_writer_t *elf);
+
+/** Writes the object file to @p output. */
+void be_elf_write(be_elf_writer_t *elf, FILE *output);
+
+#endif
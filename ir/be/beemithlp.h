@@ -71,6 +71,17 @@ static inline ir_node *be_emit_get_prev_block(ir_node const *const block)
 	return (ir_node*)get_irn_link(block);
 }
 
+/**
+ * Prevents a fallthrough into @p block, e.g. because it is emitted into another
+ * section than its predecessor in the block schedule.
+ * Requires a prior call to be_emit_init_cf_links().
+ */
+static inline void be_emit_disable_fallthrough(ir_node *const block)
+{
+	assert(is_Block(block));
+	set_irn_link(block, NULL);
+}
+
 typedef struct be_cond_branch_projs_t {
 	ir_node *f;
 	ir_node *t;
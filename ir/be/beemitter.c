@@ -13,18 +13,53 @@
 
 #include "irprintf.h"
 #include "panic.h"
+#include "xmalloc.h"
+#include <stddef.h>
+#include <string.h>
+
+/** Size of the output buffer, finished lines are written to the file in
+ * chunks of this size. */
+#define EMIT_OUTPUT_SIZE (64 * 1024)
 
 static FILE    *emit_file;
+static char    *emit_output;
+static size_t   emit_output_len;
 struct obstack  emit_obst;
 
+static void flush_output(void)
+{
+	if (emit_output_len > 0) {
+		fwrite(emit_output, 1, emit_output_len, emit_file);
+		emit_output_len = 0;
+	}
+}
+
+static void write_output(char const *const text, size_t const len)
+{
+	if (emit_output_len + len > EMIT_OUTPUT_SIZE) {
+		flush_output();
+		if (len >= EMIT_OUTPUT_SIZE) {
+			fwrite(text, 1, len, emit_file);
+			return;
+		}
+	}
+	memcpy(emit_output + emit_output_len, text, len);
+	emit_output_len += len;
+}
+
 void be_emit_init(FILE *file)
 {
-	emit_file = file;
+	emit_file       = file;
+	emit_output     = XMALLOCN(char, EMIT_OUTPUT_SIZE);
+	emit_output_len = 0;
 	obstack_init(&emit_obst);
 }
 
 void be_emit_exit(void)
 {
+	flush_output();
+	free(emit_output);
+	emit_output = NULL;
 	obstack_free(&emit_obst, NULL);
 }
 
@@ -43,8 +78,49 @@ void be_emit_irprintf(const char *fmt, ...)
 
 void be_emit_write_line(void)
 {
-	size_t const len  = obstack_object_size(&emit_obst);
-	char  *const line = (char*)obstack_finish(&emit_obst);
-	fwrite(line, 1, len, emit_file);
-	obstack_free(&emit_obst, line);
+	/* the line is the only object on emit_obst, so it is simply reset
+	 * instead of being finished and freed */
+	size_t     const len  = obstack_object_size(&emit_obst);
+	char const *const line = (char const*)obstack_base(&emit_obst);
+	write_output(line, len);
+	obstack_blank_fast(&emit_obst, -(ptrdiff_t)len);
+}
+
+void be_emit_unsigned(unsigned long long value)
+{
+	char  buf[24];
+	char *p = buf + sizeof(buf);
+	do {
+		*--p   = '0' + value % 10;
+		value /= 10;
+	} while (value != 0);
+	be_emit_string_len(p, buf + sizeof(buf) - p);
+}
+
+void be_emit_signed(long long const value, bool const force_sign)
+{
+	/* negate in unsigned arithmetic, so LLONG_MIN works */
+	unsigned long long magnitude = value;
+	if (value < 0) {
+		be_emit_char('-');
+		magnitude = -magnitude;
+	} else if (force_sign) {
+		be_emit_char('+');
+	}
+	be_emit_unsigned(magnitude);
+}
+
+void be_emit_hex(unsigned long long value, unsigned const min_digits,
+                 bool const upper)
+{
+	char const *const digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+	char        buf[16];
+	char       *p = buf + sizeof(buf);
+	do {
+		*--p    = digits[value & 0xF];
+		value >>= 4;
+	} while (value != 0);
+	for (size_t n = buf + sizeof(buf) - p; n < min_digits; ++n)
+		be_emit_char('0');
+	be_emit_string_len(p, buf + sizeof(buf) - p);
 }
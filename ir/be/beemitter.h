@@ -15,6 +15,7 @@
 #ifndef FIRM_BE_BEEMITTER_H
 #define FIRM_BE_BEEMITTER_H
 
+#include <stdbool.h>
 #include <stdio.h>
 #include "obst.h"
 
@@ -59,6 +60,23 @@ static inline void be_emit_string(const char *str)
 #define be_emit_cstring(str) \
 	be_emit_string_len(str, sizeof(str) - 1)
 
+/**
+ * Emit @p value in decimal. Faster than be_emit_irprintf("%llu").
+ */
+void be_emit_unsigned(unsigned long long value);
+
+/**
+ * Emit @p value in decimal, with a '+' sign for non-negative values if
+ * @p force_sign is set.
+ */
+void be_emit_signed(long long value, bool force_sign);
+
+/**
+ * Emit @p value in hexadecimal without prefix, padded with zeros to
+ * @p min_digits digits.
+ */
+void be_emit_hex(unsigned long long value, unsigned min_digits, bool upper);
+
 /**
  * Initializes an emitter environment.
  *
@@ -86,7 +104,8 @@ void be_emit_irprintf(const char *fmt, ...);
 void be_emit_irvprintf(const char *fmt, va_list args);
 
 /**
- * Flush the line in the current line buffer to the emitter file.
+ * Flush the line in the current line buffer to the emitter file. Lines are
+ * collected and written in large chunks, be_emit_exit() writes the rest.
  */
 void be_emit_write_line(void);
 
@@ -0,0 +1,318 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2012 University of Karlsruhe.
+ */
+
+/**
+ * @file
+ * @brief       Profile guided function ordering.
+ *
+ * Implements call-chain clustering (C3) as described in
+ * G. Ottoni, B. Maher: "Optimizing Function Placement for Large-Scale
+ * Data-Center Applications", CGO 2017:
+ *
+ * Every function starts in its own cluster. The functions are visited in
+ * order of decreasing hotness and the cluster of each one is appended to the
+ * cluster of its most frequent caller, unless the result gets too big or the
+ * caller's cluster is much colder. Finally the clusters are sorted by
+ * decreasing density (samples per byte), so the hot code is packed into few
+ * pages and callers are placed right in front of their callees.
+ *
+ * The hottest clusters are put into .text.hot and functions which were never
+ * executed into .text.unlikely.
+ */
+#include "befuncorder.h"
+
+#include "array.h"
+#include "beirg.h"
+#include "bemodule.h"
+#include "debug.h"
+#include "entity_t.h"
+#include "irgwalk.h"
+#include "irnode_t.h"
+#include "irprofile.h"
+#include "irprog_t.h"
+#include "irtools.h"
+#include "lc_opts.h"
+#include "util.h"
+#include "xmalloc.h"
+
+DEBUG_ONLY(static firm_dbg_module_t *dbg;)
+
+static bool reorder      = true;
+static bool use_sections = true;
+
+/** Clusters are not grown beyond this size in bytes. */
+#define MAX_CLUSTER_SIZE (1U << 20)
+/** A cluster is not appended to a cluster which is that many times less
+ * dense. */
+#define MAX_DEGRADE      8.0
+/** The densest clusters covering this fraction of all samples are hot. */
+#define HOT_FRACTION     0.99
+/** Estimated size of an instruction in bytes. */
+#define INSN_SIZE        4
+
+typedef struct func_t {
+	ir_graph *irg;
+	double    samples;       /**< estimated number of executed instructions */
+	unsigned  size;          /**< estimated code size in bytes */
+	uint32_t  entry_count;   /**< number of invocations */
+	unsigned  cluster;       /**< index of the containing cluster */
+	unsigned  caller;        /**< index of the most frequent caller */
+	double    caller_weight; /**< number of calls from this caller */
+} func_t;
+
+typedef struct call_t {
+	unsigned caller;
+	unsigned callee;
+	double   weight;
+} call_t;
+
+typedef struct cluster_t {
+	unsigned *funcs;   /**< function indices in layout order, NULL if merged */
+	double    samples;
+	unsigned  size;
+} cluster_t;
+
+typedef struct order_env_t {
+	func_t    *funcs;
+	unsigned  *func_of_idx; /**< function index of each graph index */
+	call_t    *calls;
+	cluster_t *clusters;
+	unsigned   cur;         /**< function currently being walked */
+} order_env_t;
+
+static order_env_t const *cmp_env;
+
+static void collect_walker(ir_node *node, void *data)
+{
+	if (is_Block(node))
+		return;
+
+	order_env_t *const env   = (order_env_t*)data;
+	func_t      *const func  = &env->funcs[env->cur];
+	uint32_t     const count = ir_profile_get_block_execcount(get_nodes_block(node));
+	func->samples += count;
+	func->size    += INSN_SIZE;
+
+	if (!is_Call(node) || count == 0)
+		return;
+	ir_entity const *const callee = get_Call_callee(node);
+	if (callee == NULL)
+		return;
+	ir_graph const *const callee_irg = get_entity_linktime_irg(callee);
+	if (callee_irg == NULL)
+		return;
+	call_t const call = {
+		.caller = env->cur,
+		.callee = env->func_of_idx[get_irg_idx(callee_irg)],
+		.weight = count,
+	};
+	ARR_APP1(call_t, env->calls, call);
+}
+
+static int cmp_calls(void const *const a, void const *const b)
+{
+	call_t const *const ca = (call_t const*)a;
+	call_t const *const cb = (call_t const*)b;
+	if (ca->callee != cb->callee)
+		return QSORT_CMP(ca->callee, cb->callee);
+	return QSORT_CMP(ca->caller, cb->caller);
+}
+
+/** Determines the most frequent caller of each function. */
+static void find_callers(order_env_t *const env)
+{
+	call_t *const calls = env->calls;
+	QSORT_ARR(calls, cmp_calls);
+	for (size_t i = 0, n = ARR_LEN(calls); i < n;) {
+		unsigned const caller = calls[i].caller;
+		unsigned const callee = calls[i].callee;
+		double         weight = 0.0;
+		for (; i < n && calls[i].caller == caller && calls[i].callee == callee; ++i)
+			weight += calls[i].weight;
+
+		func_t *const func = &env->funcs[callee];
+		if (caller != callee && weight > func->caller_weight) {
+			func->caller        = caller;
+			func->caller_weight = weight;
+		}
+	}
+}
+
+static double get_density(cluster_t const *const cluster)
+{
+	return cluster->samples / MAX(cluster->size, 1U);
+}
+
+static int cmp_hotness(void const *const a, void const *const b)
+{
+	unsigned const fa = *(unsigned const*)a;
+	unsigned const fb = *(unsigned const*)b;
+	double   const sa = cmp_env->funcs[fa].samples;
+	double   const sb = cmp_env->funcs[fb].samples;
+	if (sa != sb)
+		return QSORT_CMP(sb, sa);
+	return QSORT_CMP(fa, fb);
+}
+
+static int cmp_clusters(void const *const a, void const *const b)
+{
+	cluster_t const *const ca = &cmp_env->clusters[*(unsigned const*)a];
+	cluster_t const *const cb = &cmp_env->clusters[*(unsigned const*)b];
+	double           const da = get_density(ca);
+	double           const db = get_density(cb);
+	if (da != db)
+		return QSORT_CMP(db, da);
+	return QSORT_CMP(ca->funcs[0], cb->funcs[0]);
+}
+
+static void merge_clusters(order_env_t *const env, func_t const *const func)
+{
+	unsigned   const c_caller = env->funcs[func->caller].cluster;
+	unsigned   const c_callee = func->cluster;
+	cluster_t *const caller   = &env->clusters[c_caller];
+	cluster_t *const callee   = &env->clusters[c_callee];
+	if (c_caller == c_callee
+	 || caller->size + callee->size > MAX_CLUSTER_SIZE
+	 || get_density(caller) * MAX_DEGRADE < get_density(callee))
+		return;
+
+	DB((dbg, LEVEL_2, "append cluster of %+F to cluster of %+F\n", func->irg,
+	    env->funcs[func->caller].irg));
+	for (size_t i = 0, n = ARR_LEN(callee->funcs); i < n; ++i) {
+		unsigned const f = callee->funcs[i];
+		env->funcs[f].cluster = c_caller;
+		ARR_APP1(unsigned, caller->funcs, f);
+	}
+	caller->samples += callee->samples;
+	caller->size    += callee->size;
+	DEL_ARR_F(callee->funcs);
+	callee->funcs = NULL;
+}
+
+static be_func_placement_t get_placement(func_t const *const func, bool hot)
+{
+	if (func->entry_count == 0)
+		return BE_FUNC_UNLIKELY;
+	return hot ? BE_FUNC_HOT : BE_FUNC_NORMAL;
+}
+
+/** Clusters the functions and assigns their order and placement. */
+static void place_functions(order_env_t *const env, size_t const n_funcs,
+                            double const total)
+{
+	find_callers(env);
+
+	/* visit the functions from hot to cold and cluster them */
+	cmp_env = env;
+	unsigned *const by_hotness = XMALLOCN(unsigned, n_funcs);
+	for (size_t i = 0; i < n_funcs; ++i)
+		by_hotness[i] = i;
+	QSORT(by_hotness, n_funcs, cmp_hotness);
+	for (size_t i = 0; i < n_funcs; ++i) {
+		func_t const *const func = &env->funcs[by_hotness[i]];
+		if (func->samples == 0.0)
+			break;
+		if (func->caller_weight > 0.0)
+			merge_clusters(env, func);
+	}
+	free(by_hotness);
+
+	unsigned *order = NEW_ARR_F(unsigned, 0);
+	for (size_t i = 0; i < n_funcs; ++i) {
+		if (env->clusters[i].funcs != NULL)
+			ARR_APP1(unsigned, order, i);
+	}
+	QSORT_ARR(order, cmp_clusters);
+
+	/* place the functions */
+	double hot_samples = 0.0;
+	size_t pos         = 0;
+	DB((dbg, LEVEL_1, "Function order:\n"));
+	for (size_t c = 0, n_clusters = ARR_LEN(order); c < n_clusters; ++c) {
+		cluster_t const *const cluster = &env->clusters[order[c]];
+		bool             const hot     = cluster->samples > 0.0
+		                              && hot_samples < HOT_FRACTION * total;
+		hot_samples += cluster->samples;
+		for (size_t i = 0, n = ARR_LEN(cluster->funcs); i < n; ++i) {
+			func_t             *const func      = &env->funcs[cluster->funcs[i]];
+			ir_graph           *const irg       = func->irg;
+			be_func_placement_t const placement = get_placement(func, hot);
+			DB((dbg, LEVEL_1, "\t%+F samples %.0f size %u placement %d\n",
+			    irg, func->samples, func->size, (int)placement));
+			if (reorder)
+				set_irp_irg(pos++, irg);
+			be_irg_t *const birg = be_birg_from_irg(irg);
+			if (use_sections && birg != NULL)
+				birg->placement = placement;
+		}
+	}
+	assert(!reorder || pos == n_funcs);
+	DEL_ARR_F(order);
+}
+
+void be_order_functions(void)
+{
+	if (!reorder && !use_sections)
+		return;
+
+	size_t const n_funcs = get_irp_n_irgs();
+	if (n_funcs == 0)
+		return;
+
+	order_env_t env;
+	env.funcs       = XMALLOCNZ(func_t, n_funcs);
+	env.func_of_idx = XMALLOCN(unsigned, get_irp_last_idx());
+	env.calls       = NEW_ARR_F(call_t, 0);
+	env.clusters    = XMALLOCN(cluster_t, n_funcs);
+	foreach_irp_irg(i, irg) {
+		env.funcs[i].irg = irg;
+		env.func_of_idx[get_irg_idx(irg)] = i;
+	}
+
+	/* gather samples, sizes and calls */
+	double total = 0.0;
+	for (size_t i = 0; i < n_funcs; ++i) {
+		func_t   *const func = &env.funcs[i];
+		ir_graph *const irg  = func->irg;
+		env.cur = i;
+		irg_walk_graph(irg, NULL, collect_walker, &env);
+		func->entry_count = ir_profile_get_block_execcount(get_irg_start_block(irg));
+		func->cluster     = i;
+		total += func->samples;
+
+		cluster_t *const cluster = &env.clusters[i];
+		cluster->funcs    = NEW_ARR_F(unsigned, 1);
+		cluster->funcs[0] = i;
+		cluster->samples  = func->samples;
+		cluster->size     = func->size;
+	}
+	if (total > 0.0)
+		place_functions(&env, n_funcs, total);
+
+	for (size_t i = 0; i < n_funcs; ++i) {
+		if (env.clusters[i].funcs != NULL)
+			DEL_ARR_F(env.clusters[i].funcs);
+	}
+	free(env.clusters);
+	DEL_ARR_F(env.calls);
+	free(env.func_of_idx);
+	free(env.funcs);
+}
+
+static const lc_opt_table_entry_t be_funcorder_options[] = {
+	LC_OPT_ENT_BOOL("reorder",  "order functions by the profiled call graph", &reorder),
+	LC_OPT_ENT_BOOL("sections", "place hot and unlikely functions into separate sections", &use_sections),
+	LC_OPT_LAST
+};
+
+BE_REGISTER_MODULE_CONSTRUCTOR(be_init_funcorder)
+void be_init_funcorder(void)
+{
+	lc_opt_entry_t *be_grp        = lc_opt_get_grp(firm_opt_get_root(), "be");
+	lc_opt_entry_t *funcorder_grp = lc_opt_get_grp(be_grp, "funcorder");
+
+	lc_opt_add_table(funcorder_grp, be_funcorder_options);
+	FIRM_DBG_REGISTER(dbg, "firm.be.funcorder");
+}
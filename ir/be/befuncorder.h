@@ -0,0 +1,24 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2012 University of Karlsruhe.
+ */
+
+/**
+ * @file
+ * @brief       Profile guided function ordering.
+ */
+#ifndef FIRM_BE_BEFUNCORDER_H
+#define FIRM_BE_BEFUNCORDER_H
+
+/**
+ * Reorders the graphs of the program so that functions calling each other
+ * frequently are placed next to each other, and classifies each function as
+ * hot, normal or unlikely executed.
+ *
+ * Uses the block execution counts of the currently loaded profile, so it must
+ * be called between ir_profile_read() and ir_profile_free(). Only graphs
+ * with an initialized backend irg are classified.
+ */
+void be_order_functions(void);
+
+#endif
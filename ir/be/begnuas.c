@@ -15,6 +15,7 @@
 #include "bearch.h"
 #include "beemithlp.h"
 #include "beemitter.h"
+#include "beirg.h"
 #include "bemodule.h"
 #include "betranshlp.h"
 #include "dbginfo.h"
@@ -36,6 +37,10 @@ bool                   be_gas_emit_types    = true;
 char                   be_gas_elf_type_char = '@';
 
 static be_gas_section_t current_section = (be_gas_section_t) -1;
+/** section and entity of the code of the current function */
+static be_gas_section_t code_section = GAS_SECTION_TEXT;
+static ir_entity const *code_entity;
+static bool             in_cold_code;
 static pmap            *block_numbers;
 static unsigned         next_block_nr;
 
@@ -137,6 +142,8 @@ static const elf_sectioninfo_t elf_sectioninfos[] = {
 	[GAS_SECTION_DEBUG_LINE]     = { "debug_line",        "progbits", ""   },
 	[GAS_SECTION_DEBUG_PUBNAMES] = { "debug_pubnames",    "progbits", ""   },
 	[GAS_SECTION_DEBUG_FRAME]    = { "debug_frame",       "progbits", ""   },
+	[GAS_SECTION_TEXT_UNLIKELY]  = { "text.unlikely",     "progbits", "ax" },
+	[GAS_SECTION_TEXT_HOT]       = { "text.hot",          "progbits", "ax" },
 };
 
 static void emit_section_sparc(be_gas_section_t section,
@@ -260,6 +267,18 @@ static void emit_section(be_gas_section_t const section, ir_entity const *const
 	}
 }
 
+/**
+ * Switches to the section of the code of a function, other sections like
+ * the one of jump tables return there afterwards.
+ */
+static void emit_code_section(be_gas_section_t const section,
+                              ir_entity const *const entity)
+{
+	code_section = section;
+	code_entity  = entity;
+	emit_section(section, entity);
+}
+
 void be_gas_emit_switch_section(be_gas_section_t section)
 {
 	/* you have to produce a switch_section call with entity manually
@@ -516,6 +535,29 @@ static be_gas_section_t determine_section(be_main_env_t const *const main_env, i
 	panic("couldn't determine section for %+F", entity);
 }
 
+/**
+ * Determines the section of the code of function @p entity, which takes the
+ * placement of the function according to profile data into account.
+ */
+static be_gas_section_t determine_function_section(ir_entity const *const entity)
+{
+	be_gas_section_t const section = determine_section(NULL, entity);
+	if (section != GAS_SECTION_TEXT
+	 || ir_platform.object_format != OBJECT_FORMAT_ELF)
+		return section;
+
+	ir_graph const *const irg  = get_entity_irg(entity);
+	be_irg_t const *const birg = irg != NULL ? be_birg_from_irg(irg) : NULL;
+	if (birg == NULL)
+		return section;
+	switch (birg->placement) {
+	case BE_FUNC_NORMAL:   return GAS_SECTION_TEXT;
+	case BE_FUNC_HOT:      return GAS_SECTION_TEXT_HOT;
+	case BE_FUNC_UNLIKELY: return GAS_SECTION_TEXT_UNLIKELY;
+	}
+	panic("invalid placement for %+F", entity);
+}
+
 static void emit_symbol_directive(const char *directive,
                                   const ir_entity *entity)
 {
@@ -597,8 +639,8 @@ void be_gas_emit_function_prolog(const ir_entity *entity, unsigned po2alignment,
 {
 	be_dwarf_function_before(entity, parameter_infos);
 
-	be_gas_section_t const section = determine_section(NULL, entity);
-	emit_section(section, entity);
+	be_gas_section_t const section = determine_function_section(entity);
+	emit_code_section(section, entity);
 
 	/* write the begin line (makes the life easier for scripts parsing the
 	 * assembler) */
@@ -644,8 +686,56 @@ void be_gas_emit_function_prolog(const ir_entity *entity, unsigned po2alignment,
 	be_dwarf_function_begin();
 }
 
+ir_node *be_gas_get_cold_block(ir_graph const *const irg)
+{
+	ir_node *const cold_block = be_birg_from_irg(irg)->cold_block;
+	if (cold_block == NULL)
+		return NULL;
+	/* we cannot describe the call frame of the cold part, and for comdat
+	 * functions the cold part would need its own group. Functions which are
+	 * unlikely executed as a whole need no split. */
+	be_gas_section_t const section = determine_function_section(get_irg_entity(irg));
+	if (ir_platform.object_format != OBJECT_FORMAT_ELF
+	 || be_gas_elf_variant != ELF_VARIANT_NORMAL
+	 || be_dwarf_has_frameinfo()
+	 || (section != GAS_SECTION_TEXT && section != GAS_SECTION_TEXT_HOT))
+		return NULL;
+	return cold_block;
+}
+
+static void emit_cold_entity(ir_entity const *const entity)
+{
+	be_gas_emit_entity(entity);
+	be_emit_cstring(".cold");
+}
+
+void be_gas_begin_cold_code(ir_entity const *const entity)
+{
+	assert(!in_cold_code);
+	emit_code_section(GAS_SECTION_TEXT_UNLIKELY, entity);
+	be_emit_cstring("\t.type\t");
+	emit_cold_entity(entity);
+	be_emit_irprintf(", %cfunction\n", be_gas_elf_type_char);
+	emit_cold_entity(entity);
+	be_emit_cstring(":\n");
+	be_emit_write_line();
+	in_cold_code = true;
+}
+
 void be_gas_emit_function_epilog(ir_entity const *const entity)
 {
+	if (in_cold_code) {
+		be_emit_cstring("\t.size\t");
+		emit_cold_entity(entity);
+		be_emit_cstring(", .-");
+		emit_cold_entity(entity);
+		be_emit_char('\n');
+		be_emit_write_line();
+		/* the size of the function is computed in its own section */
+		emit_code_section(determine_function_section(entity), entity);
+		in_cold_code = false;
+	}
+
 	be_dwarf_function_end();
 
 	if (ir_platform.object_format == OBJECT_FORMAT_ELF) {
@@ -682,7 +772,7 @@ static void emit_tv(ir_tarval *const tv, unsigned const offset, unsigned const n
 {
 	be_emit_cstring("0x");
 	for (unsigned i = n; i-- != 0;) {
-		be_emit_irprintf("%02x", get_tarval_sub_bits(tv, offset + i));
+		be_emit_hex(get_tarval_sub_bits(tv, offset + i), 2, false);
 	}
 }
 
@@ -721,15 +811,15 @@ static void emit_init_expression(ir_node *const init)
 		return;
 
 	case iro_Offset:
-		be_emit_irprintf("%d", get_entity_offset(get_Offset_entity(init)));
+		be_emit_signed(get_entity_offset(get_Offset_entity(init)), false);
 		return;
 
 	case iro_Align:
-		be_emit_irprintf("%u", get_type_alignment(get_Align_type(init)));
+		be_emit_unsigned(get_type_alignment(get_Align_type(init)));
 		return;
 
 	case iro_Size:
-		be_emit_irprintf("%u", get_type_size(get_Size_type(init)));
+		be_emit_unsigned(get_type_size(get_Size_type(init)));
 		return;
 
 	case iro_Add:
@@ -1297,7 +1387,9 @@ void be_gas_emit_entity(const ir_entity *entity)
 {
 	if (entity->kind == IR_ENTITY_LABEL) {
 		ir_label_t label = get_entity_label(entity);
-		be_emit_irprintf("%s_%lu", be_gas_get_private_prefix(), label);
+		be_emit_string(be_gas_get_private_prefix());
+		be_emit_char('_');
+		be_emit_unsigned(label);
 		return;
 	}
 
@@ -1326,7 +1418,8 @@ void be_gas_emit_block_name(const ir_node *block)
 		} else {
 			nr = PTR_TO_INT(nr_val) - 1;
 		}
-		be_emit_irprintf("%s%d", be_gas_get_private_prefix(), nr);
+		be_emit_string(be_gas_get_private_prefix());
+		be_emit_signed(nr, false);
 	}
 }
 
@@ -1544,7 +1637,7 @@ static void emit_global_decls(be_main_env_t const *const main_env)
 	}
 }
 
-void be_emit_jump_table(ir_node const *const node, be_switch_attr_t const *const swtch, ir_mode *const entry_mode, emit_target_func const emit_target)
+ir_node const **be_get_jump_table_targets(ir_node const *const node, be_switch_attr_t const *const swtch, unsigned long *const length_out)
 {
 	/* go over all proj's and collect their jump targets */
 	unsigned        n_outs  = arch_get_irn_n_outs(node);
@@ -1603,6 +1696,20 @@ void be_emit_jump_table(ir_node const *const node, be_switch_attr_t const *const
 			}
 		}
 	}
+	for (unsigned long i = 0; i < length; ++i) {
+		if (labels[i] == NULL)
+			labels[i] = targets[0];
+	}
+
+	free(targets);
+	*length_out = length;
+	return labels;
+}
+
+void be_emit_jump_table(ir_node const *const node, be_switch_attr_t const *const swtch, ir_mode *const entry_mode, emit_target_func const emit_target)
+{
+	unsigned long         length;
+	ir_node const **const labels = be_get_jump_table_targets(node, swtch, &length);
 
 	/* emit table */
 	unsigned         const pointer_size = get_mode_size_bytes(entry_mode);
@@ -1616,20 +1723,16 @@ void be_emit_jump_table(ir_node const *const node, be_switch_attr_t const *const
 	}
 
 	for (unsigned long i = 0; i < length; ++i) {
-		ir_node const *target = labels[i];
-		if (target == NULL)
-			target = targets[0];
 		emit_size_type(pointer_size);
-		emit_target(entity, target);
+		emit_target(entity, labels[i]);
 		be_emit_char('\n');
 		be_emit_write_line();
 	}
 
 	if (entity && !is_macho())
-		be_gas_emit_switch_section(GAS_SECTION_TEXT);
+		emit_section(code_section, code_entity);
 
 	free(labels);
-	free(targets);
 }
 
 static void emit_global_asms(void)
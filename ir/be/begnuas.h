@@ -35,6 +35,8 @@ typedef enum {
 	GAS_SECTION_DEBUG_LINE,      /**< dwarf debug line */
 	GAS_SECTION_DEBUG_PUBNAMES,  /**< dwarf pub names */
 	GAS_SECTION_DEBUG_FRAME,     /**< dwarf callframe infos */
+	GAS_SECTION_TEXT_UNLIKELY,   /**< rarely executed program code */
+	GAS_SECTION_TEXT_HOT,        /**< frequently executed program code */
 	GAS_SECTION_TYPE_MASK    = 0xFF,
 
 	GAS_SECTION_FLAG_TLS     = 1 << 8,  /**< thread local flag */
@@ -72,6 +74,19 @@ void be_gas_emit_function_prolog(const ir_entity *entity,
 
 void be_gas_emit_function_epilog(const ir_entity *entity);
 
+/**
+ * Returns the first block of the block schedule of @p irg which should be
+ * emitted into the section for rarely executed code or NULL if the function
+ * is not split.
+ */
+ir_node *be_gas_get_cold_block(ir_graph const *irg);
+
+/**
+ * Continues the function @p entity in the section for rarely executed code.
+ * The rest of the function is emitted into this section.
+ */
+void be_gas_begin_cold_code(const ir_entity *entity);
+
 char const *be_gas_get_private_prefix(void);
 
 /**
@@ -122,6 +137,13 @@ void be_gas_end_compilation_unit(const be_main_env_t *env);
  */
 const char *be_gas_insn_label_prefix(void);
 
+/**
+ * Returns the Proj of @p node for each selector value of the jump table.
+ * Values without a case use the default Proj. The array has @p *length
+ * entries and must be freed with free().
+ */
+ir_node const **be_get_jump_table_targets(ir_node const *node, be_switch_attr_t const *swtch, unsigned long *length);
+
 typedef void (*emit_target_func)(ir_entity const *table, ir_node const *proj_x);
 
 /**
@@ -22,13 +22,51 @@
 #include "lc_opts_enum.h"
 #include "timing.h"
 #include "xmalloc.h"
+#include "raw_bitset.h"
+#include "util.h"
 #include <stdlib.h>
 
+/** Largest number of bits of the triangular adjacency matrix, larger graphs
+ * use adjacency vectors. */
+#define IFG_MAX_MATRIX_BITS (1u << 24)
+
+#define IFG_NONE (~0u)
+
 void be_ifg_free(be_ifg_t *self)
 {
+	if (self->nodes != NULL) {
+		if (self->adj != NULL) {
+			for (unsigned i = 0; i < self->n_nodes; ++i)
+				DEL_ARR_F(self->adj[i]);
+			free(self->adj);
+		}
+		free(self->matrix);
+		free(self->degrees);
+		free(self->node_nr);
+		DEL_ARR_F(self->nodes);
+	}
 	free(self);
 }
 
+static unsigned get_node_nr(be_ifg_t const *const ifg, ir_node const *const irn)
+{
+	unsigned const idx = get_irn_idx(irn);
+	return idx < ifg->n_node_nr ? ifg->node_nr[idx] : IFG_NONE;
+}
+
+/** Index of the first bit of row @p nr of the triangular matrix. */
+static size_t matrix_row(unsigned const nr)
+{
+	return (size_t)nr * (nr - 1) / 2;
+}
+
+static bool matrix_has_edge(be_ifg_t const *const ifg, unsigned const a,
+                            unsigned const b)
+{
+	return a > b ? rbitset_is_set(ifg->matrix, matrix_row(a) + b)
+	             : rbitset_is_set(ifg->matrix, matrix_row(b) + a);
+}
+
 static void nodes_walker(ir_node *bl, void *data)
 {
 	nodes_iter_t     *it   = (nodes_iter_t*)data;
@@ -45,11 +83,19 @@ static void nodes_walker(ir_node *bl, void *data)
 nodes_iter_t be_ifg_nodes_begin(be_ifg_t const *const ifg)
 {
 	nodes_iter_t iter;
-	obstack_init(&iter.obst);
 	iter.n    = 0;
 	iter.curr = 0;
 	iter.env  = ifg->env;
 
+	if (ifg->nodes != NULL) {
+		iter.own_nodes = false;
+		iter.n         = ifg->n_real;
+		iter.nodes     = ifg->nodes;
+		return iter;
+	}
+	iter.own_nodes = true;
+	obstack_init(&iter.obst);
+
 	irg_block_walk_graph(ifg->env->irg, nodes_walker, NULL, &iter);
 	obstack_ptr_grow(&iter.obst, NULL);
 	iter.nodes = (ir_node**)obstack_finish(&iter.obst);
@@ -61,7 +107,8 @@ ir_node *be_ifg_nodes_next(nodes_iter_t *const it)
 	if (it->curr < it->n) {
 		return it->nodes[it->curr++];
 	} else {
-		obstack_free(&it->obst, NULL);
+		if (it->own_nodes)
+			obstack_free(&it->obst, NULL);
 		return NULL;
 	}
 }
@@ -99,8 +146,14 @@ static void find_neighbour_walker(ir_node *block, void *data)
 static void find_neighbours(const be_ifg_t *ifg, neighbours_iter_t *it, const ir_node *irn)
 {
 	it->env         = ifg->env;
+	it->ifg         = ifg;
 	it->irn         = irn;
 	it->valid       = 1;
+	if (ifg->nodes != NULL) {
+		it->nr  = get_node_nr(ifg, irn);
+		it->pos = 0;
+		return;
+	}
 	ir_nodeset_init(&it->neighbours);
 
 	dom_tree_walk(get_nodes_block(irn), find_neighbour_walker, NULL, it);
@@ -112,12 +165,38 @@ static inline void neighbours_break(neighbours_iter_t *it, int force)
 {
 	(void) force;
 	assert(it->valid == 1);
-	ir_nodeset_destroy(&it->neighbours);
+	if (it->ifg->nodes == NULL)
+		ir_nodeset_destroy(&it->neighbours);
 	it->valid = 0;
 }
 
+static ir_node *get_next_explicit_neighbour(neighbours_iter_t *it)
+{
+	be_ifg_t const *const ifg = it->ifg;
+	unsigned        const nr  = it->nr;
+	if (nr == IFG_NONE)
+		return NULL;
+
+	if (ifg->adj != NULL) {
+		unsigned const *const adj = ifg->adj[nr];
+		if (it->pos < ARR_LEN(adj))
+			return ifg->nodes[adj[it->pos++]];
+		return NULL;
+	}
+
+	for (unsigned n = ifg->n_nodes; it->pos < n;) {
+		unsigned const other = it->pos++;
+		if (other != nr && matrix_has_edge(ifg, nr, other))
+			return ifg->nodes[other];
+	}
+	return NULL;
+}
+
 static ir_node *get_next_neighbour(neighbours_iter_t *it)
 {
+	if (it->ifg->nodes != NULL)
+		return get_next_explicit_neighbour(it);
+
 	ir_node *res = ir_nodeset_iterator_next(&it->iter);
 
 	if (res == NULL) {
@@ -242,6 +321,11 @@ void be_ifg_cliques_break(cliques_iter_t *iter)
 
 int be_ifg_degree(const be_ifg_t *ifg, const ir_node *irn)
 {
+	if (ifg->nodes != NULL) {
+		unsigned const nr = get_node_nr(ifg, irn);
+		return nr != IFG_NONE ? (int)ifg->degrees[nr] : 0;
+	}
+
 	neighbours_iter_t it;
 	int degree;
 	find_neighbours(ifg, &it, irn);
@@ -250,10 +334,151 @@ int be_ifg_degree(const be_ifg_t *ifg, const ir_node *irn)
 	return degree;
 }
 
-be_ifg_t *be_create_ifg(const be_chordal_env_t *env)
+static void number_node(be_ifg_t *const ifg, ir_node *const irn)
+{
+	unsigned *const nr = &ifg->node_nr[get_irn_idx(irn)];
+	if (*nr == IFG_NONE) {
+		*nr = ifg->n_nodes++;
+		ARR_APP1(ir_node*, ifg->nodes, irn);
+	}
+}
+
+static void number_real_walker(ir_node *const block, void *const data)
+{
+	be_ifg_t         *const ifg  = (be_ifg_t*)data;
+	struct list_head *const head = get_block_border_head(ifg->env, block);
+	foreach_border_head(head, b) {
+		if (b->is_def && b->is_real)
+			number_node(ifg, b->irn);
+	}
+}
+
+static void number_other_walker(ir_node *const block, void *const data)
+{
+	be_ifg_t         *const ifg  = (be_ifg_t*)data;
+	struct list_head *const head = get_block_border_head(ifg->env, block);
+	foreach_border_head(head, b) {
+		number_node(ifg, b->irn);
+	}
+}
+
+static void add_edge(be_ifg_t *const ifg, unsigned const a, unsigned const b)
+{
+	if (ifg->matrix != NULL) {
+		size_t const bit = a > b ? matrix_row(a) + b : matrix_row(b) + a;
+		if (rbitset_is_set(ifg->matrix, bit))
+			return;
+		rbitset_set(ifg->matrix, bit);
+		++ifg->degrees[a];
+		++ifg->degrees[b];
+	} else {
+		ARR_APP1(unsigned, ifg->adj[a], b);
+		ARR_APP1(unsigned, ifg->adj[b], a);
+	}
+}
+
+typedef struct build_env_t {
+	be_ifg_t *ifg;
+	unsigned *living;     /**< Numbers of the currently living nodes. */
+	unsigned  n_living;
+	unsigned *living_pos; /**< Position in living by node number. */
+} build_env_t;
+
+/**
+ * Adds the edges of a block. Live ranges of SSA values interfere iff one of
+ * them is live at the definition of the other, so edges are only added at
+ * real definitions. Values live in at the block were already connected at
+ * their definitions.
+ */
+static void build_edges_walker(ir_node *const block, void *const data)
+{
+	build_env_t      *const env  = (build_env_t*)data;
+	be_ifg_t         *const ifg  = env->ifg;
+	struct list_head *const head = get_block_border_head(ifg->env, block);
+	foreach_border_head(head, b) {
+		unsigned const nr = get_node_nr(ifg, b->irn);
+		if (b->is_def) {
+			if (b->is_real) {
+				for (unsigned i = 0; i < env->n_living; ++i)
+					add_edge(ifg, nr, env->living[i]);
+			}
+			env->living_pos[nr]           = env->n_living;
+			env->living[env->n_living++] = nr;
+		} else {
+			unsigned const pos  = env->living_pos[nr];
+			unsigned const last = env->living[--env->n_living];
+			env->living[pos]       = last;
+			env->living_pos[last]  = pos;
+		}
+	}
+	assert(env->n_living == 0);
+}
+
+static int cmp_unsigned(void const *const a, void const *const b)
+{
+	unsigned const ua = *(unsigned const*)a;
+	unsigned const ub = *(unsigned const*)b;
+	return (ua > ub) - (ua < ub);
+}
+
+/**
+ * Builds the explicit graph with one pass over the border lists.
+ */
+static void build_graph(be_ifg_t *const ifg)
+{
+	ir_graph *const irg = ifg->env->irg;
+	ifg->n_node_nr = get_irg_last_idx(irg);
+	ifg->node_nr   = XMALLOCN(unsigned, ifg->n_node_nr);
+	memset(ifg->node_nr, 0xFF, ifg->n_node_nr * sizeof(*ifg->node_nr));
+
+	/* Number the nodes in the order be_ifg_foreach_node always used. */
+	ifg->nodes = NEW_ARR_F(ir_node*, 0);
+	irg_block_walk_graph(irg, number_real_walker, NULL, ifg);
+	ifg->n_real = ifg->n_nodes;
+	irg_block_walk_graph(irg, number_other_walker, NULL, ifg);
+
+	unsigned const n = ifg->n_nodes;
+	ifg->degrees = XMALLOCNZ(unsigned, MAX(n, 1));
+	if (matrix_row(n) <= IFG_MAX_MATRIX_BITS) {
+		ifg->matrix = rbitset_malloc(MAX(matrix_row(n), 1));
+	} else {
+		ifg->adj = XMALLOCN(unsigned*, n);
+		for (unsigned i = 0; i < n; ++i)
+			ifg->adj[i] = NEW_ARR_F(unsigned, 0);
+	}
+
+	build_env_t env = {
+		.ifg        = ifg,
+		.living     = XMALLOCN(unsigned, MAX(n, 1)),
+		.n_living   = 0,
+		.living_pos = XMALLOCN(unsigned, MAX(n, 1)),
+	};
+	irg_block_walk_graph(irg, build_edges_walker, NULL, &env);
+	free(env.living_pos);
+	free(env.living);
+
+	if (ifg->adj != NULL) {
+		for (unsigned i = 0; i < n; ++i) {
+			unsigned *const adj = ifg->adj[i];
+			size_t    const len = ARR_LEN(adj);
+			qsort(adj, len, sizeof(*adj), cmp_unsigned);
+			size_t n_unique = 0;
+			for (size_t j = 0; j < len; ++j) {
+				if (n_unique == 0 || adj[n_unique - 1] != adj[j])
+					adj[n_unique++] = adj[j];
+			}
+			ARR_SHRINKLEN(adj, n_unique);
+			ifg->degrees[i] = n_unique;
+		}
+	}
+}
+
+be_ifg_t *be_create_ifg(const be_chordal_env_t *env, bool build)
 {
-	be_ifg_t *ifg = XMALLOC(be_ifg_t);
+	be_ifg_t *ifg = XMALLOCZ(be_ifg_t);
 	ifg->env = env;
+	if (build)
+		build_graph(ifg);
 
 	return ifg;
 }
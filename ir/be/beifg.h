@@ -20,11 +20,23 @@
 
 struct be_ifg_t {
 	const be_chordal_env_t *env;
+
+	/* The explicit graph, only present if nodes != NULL. Otherwise the
+	 * neighbours are recomputed from the border lists for every query. */
+	ir_node  **nodes;     /**< The nodes by number, real definitions first. */
+	unsigned   n_nodes;
+	unsigned   n_real;    /**< Number of nodes with a real definition. */
+	unsigned  *node_nr;   /**< Node numbers by node index. */
+	unsigned   n_node_nr;
+	unsigned  *degrees;   /**< Degrees by node number. */
+	unsigned  *matrix;    /**< Lower triangular adjacency bitset (small graphs). */
+	unsigned **adj;       /**< Sorted adjacency vectors (large graphs). */
 };
 
 typedef struct nodes_iter_t {
 	const be_chordal_env_t *env;
 	struct obstack         obst;
+	bool                   own_nodes;
 	int                    n;
 	int                    curr;
 	ir_node                **nodes;
@@ -32,8 +44,11 @@ typedef struct nodes_iter_t {
 
 typedef struct neighbours_iter_t {
 	const be_chordal_env_t *env;
+	const be_ifg_t       *ifg;
 	const ir_node        *irn;
 	int                   valid;
+	unsigned              nr;  /**< Node number in the explicit graph. */
+	unsigned              pos; /**< Next candidate in the explicit graph. */
 	ir_nodeset_t          neighbours;
 	ir_nodeset_iterator_t iter;
 } neighbours_iter_t;
@@ -82,6 +97,13 @@ typedef struct {
 
 void be_ifg_stat(ir_graph *irg, be_ifg_t *ifg, be_ifg_stat_t *stat);
 
-be_ifg_t *be_create_ifg(const be_chordal_env_t *env);
+/**
+ * Creates the interference graph of a register class.
+ *
+ * @param env       the chordal environment with valid border lists
+ * @param build     if true build the graph explicitly, otherwise answer the
+ *                  queries by walking the border lists
+ */
+be_ifg_t *be_create_ifg(const be_chordal_env_t *env, bool build);
 
 #endif
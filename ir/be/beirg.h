@@ -36,6 +36,13 @@ void be_invalidate_live_chk(ir_graph *irg);
  */
 void be_free_birg(ir_graph *irg);
 
+/** Placement of the code of a function according to profile data. */
+typedef enum be_func_placement_t {
+	BE_FUNC_NORMAL,   /**< no profile data or neither hot nor unlikely */
+	BE_FUNC_HOT,      /**< accounts for most of the profiled execution time */
+	BE_FUNC_UNLIKELY, /**< never executed in the profiling run */
+} be_func_placement_t;
+
 /**
  * An ir_graph with additional analysis data about this irg. Also includes some
  * backend structures
@@ -54,7 +61,14 @@ typedef struct be_irg_t {
 	struct obstack    obst;
 	/** Architecture specific per-graph data */
 	void             *isa_link;
+	/** CSE setting to restore after code generation of this graph */
+	int               saved_cse;
 	bool              has_returns_twice_call;
+	/** first block of the block schedule to be emitted into the section for
+	 * rarely executed code, NULL if the function is not split */
+	ir_node          *cold_block;
+	/** section placement of the function, see be_order_functions() */
+	be_func_placement_t placement;
 } be_irg_t;
 
 static inline be_irg_t *be_birg_from_irg(const ir_graph *irg)
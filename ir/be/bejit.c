@@ -9,6 +9,8 @@
  * @author      Matthias Braun
  * @date        12.03.2007
  */
+/* MAP_ANONYMOUS is not part of C99/POSIX */
+#define _DEFAULT_SOURCE
 #include "bejit.h"
 
 #include "array.h"
@@ -18,9 +20,29 @@
 #include "compiler.h"
 #include "entity_t.h"
 #include "obst.h"
+#include "irgraph_t.h"
+#include "irprog.h"
 #include "panic.h"
+#include "target_t.h"
+#include "xmalloc.h"
 #include <assert.h>
 #include <limits.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+/** Smallest size of an executable memory chunk. */
+#define EXEC_CHUNK_SIZE     (64 * 1024)
+/** Alignment of functions in executable memory. */
+#define EXEC_FUNCTION_ALIGN 16
+/** Maximum number of unused chunks kept for later segments. */
+#define EXEC_MAX_FREE       8
 
 typedef enum reloc_dest_kind_t {
 	RELOC_DEST_CODE_FRAGMENT,
@@ -47,22 +69,185 @@ typedef struct fragment_info_t {
 	relocation_t relocations[];
 } fragment_info_t;
 
+/**
+ * A mapping of executable memory. Functions are allocated from its start,
+ * the pages they occupy are only writable while a function is copied in.
+ */
+typedef struct exec_chunk_t exec_chunk_t;
+struct exec_chunk_t {
+	exec_chunk_t *next;
+	char         *base;
+	size_t        size;
+	size_t        used;
+};
+
 struct ir_jit_segment_t {
 	struct obstack code_obst;
 	struct obstack fragment_info_obst;
 	struct obstack fragment_info_arr_obst;
+	struct obstack stub_obst;
+	exec_chunk_t  *chunks;   /**< Executable memory, the current chunk first. */
+	ir_entity    **entities; /**< Entities with an address in chunks. */
+	bool           lazy;     /**< Compile callees on their first call. */
+	char          *resolver; /**< Code all unresolved stubs jump to. */
+	char          *cache_dir; /**< Directory of the code cache or NULL. */
 };
 
+/**
+ * A lazy compilation stub. Its code jumps to target, which is the resolver
+ * until the function has been compiled.
+ */
+typedef struct jit_stub_t {
+	void             *target; /**< Must be the first member. */
+	ir_jit_segment_t *segment;
+	ir_entity        *entity;
+} jit_stub_t;
+
 struct ir_jit_function_t {
 	unsigned          size;
 	unsigned          n_fragments;
 	char const       *code;
 	fragment_info_t **fragment_infos;
+	ir_jit_segment_t *segment;
+	ir_entity        *entity; /**< Entity of the function, may be NULL. */
+	void             *executable; /**< Address in executable memory. */
 };
 
-struct obstack        *code_obst;
-static struct obstack *fragment_info_obst;
-static struct obstack *fragment_info_arr_obst;
+struct obstack          *code_obst;
+static struct obstack   *fragment_info_obst;
+static struct obstack   *fragment_info_arr_obst;
+static ir_jit_segment_t *current_segment;
+
+/** Chunks of destroyed segments, kept to avoid remapping memory. */
+static exec_chunk_t *free_chunks;
+static unsigned      n_free_chunks;
+
+static size_t get_page_size(void)
+{
+	static size_t page_size;
+	if (page_size == 0) {
+#ifdef _WIN32
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		page_size = info.dwPageSize;
+#else
+		long const size = sysconf(_SC_PAGESIZE);
+		page_size = size > 0 ? (size_t)size : 4096;
+#endif
+	}
+	return page_size;
+}
+
+static char *map_memory(size_t const size)
+{
+#ifdef _WIN32
+	void *const res = VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT,
+	                               PAGE_READWRITE);
+	if (res == NULL)
+		panic("could not allocate executable memory");
+#else
+	void *const res = mmap(NULL, size, PROT_READ | PROT_WRITE,
+	                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (res == MAP_FAILED)
+		panic("could not allocate executable memory");
+#endif
+	return (char*)res;
+}
+
+static void unmap_memory(char *const base, size_t const size)
+{
+#ifdef _WIN32
+	(void)size;
+	VirtualFree(base, 0, MEM_RELEASE);
+#else
+	munmap(base, size);
+#endif
+}
+
+/** Switches the pages of [begin, begin+size) between writable and
+ * executable. */
+static void protect_memory(char *const begin, size_t const size,
+                           bool const executable)
+{
+	size_t     const page_size = get_page_size();
+	uintptr_t  const first     = (uintptr_t)begin & ~(page_size - 1);
+	uintptr_t  const last      = (uintptr_t)begin + size;
+	char      *const base      = (char*)first;
+	size_t     const len       = last - first;
+#ifdef _WIN32
+	DWORD old;
+	if (!VirtualProtect(base, len,
+	                    executable ? PAGE_EXECUTE_READ : PAGE_READWRITE, &old))
+		panic("could not change protection of executable memory");
+	if (executable)
+		FlushInstructionCache(GetCurrentProcess(), begin, size);
+#else
+	int const prot = executable ? PROT_READ | PROT_EXEC
+	                            : PROT_READ | PROT_WRITE;
+	if (mprotect(base, len, prot) != 0)
+		panic("could not change protection of executable memory");
+	if (executable)
+		__builtin___clear_cache(begin, begin + size);
+#endif
+}
+
+/** Returns a chunk with at least @p size bytes. */
+static exec_chunk_t *new_exec_chunk(size_t const size)
+{
+	for (exec_chunk_t **anchor = &free_chunks, *chunk; (chunk = *anchor);
+	     anchor = &chunk->next) {
+		if (chunk->size >= size) {
+			*anchor = chunk->next;
+			--n_free_chunks;
+			chunk->used = 0;
+			return chunk;
+		}
+	}
+
+	size_t const page_size  = get_page_size();
+	size_t const min_size   = size > EXEC_CHUNK_SIZE ? size : EXEC_CHUNK_SIZE;
+	size_t const chunk_size = (min_size + page_size - 1) & ~(page_size - 1);
+
+	exec_chunk_t *const chunk = XMALLOC(exec_chunk_t);
+	chunk->next = NULL;
+	chunk->base = map_memory(chunk_size);
+	chunk->size = chunk_size;
+	chunk->used = 0;
+	return chunk;
+}
+
+static void free_exec_chunk(exec_chunk_t *const chunk)
+{
+	if (n_free_chunks >= EXEC_MAX_FREE) {
+		unmap_memory(chunk->base, chunk->size);
+		free(chunk);
+		return;
+	}
+	/* functions of the destroyed segment must not be executed anymore */
+	protect_memory(chunk->base, chunk->size, false);
+	chunk->next = free_chunks;
+	free_chunks = chunk;
+	++n_free_chunks;
+}
+
+/** Allocates @p size bytes of executable memory in @p segment. */
+static char *alloc_exec_memory(ir_jit_segment_t *const segment,
+                               size_t const size)
+{
+	exec_chunk_t *chunk = segment->chunks;
+	if (chunk == NULL || chunk->size - chunk->used < size) {
+		exec_chunk_t *const fresh = new_exec_chunk(size);
+		fresh->next     = chunk;
+		segment->chunks = fresh;
+		chunk           = fresh;
+	}
+	char *const res = chunk->base + chunk->used;
+	chunk->used = (chunk->used + size + EXEC_FUNCTION_ALIGN - 1)
+	            & ~(size_t)(EXEC_FUNCTION_ALIGN - 1);
+	if (chunk->used > chunk->size)
+		chunk->used = chunk->size;
+	return res;
+}
 
 ir_jit_segment_t *be_new_jit_segment(void)
 {
@@ -70,17 +255,49 @@ ir_jit_segment_t *be_new_jit_segment(void)
 	obstack_init(&segment->code_obst);
 	obstack_init(&segment->fragment_info_obst);
 	obstack_init(&segment->fragment_info_arr_obst);
+	obstack_init(&segment->stub_obst);
+	segment->entities = NEW_ARR_F(ir_entity*, 0);
 	return segment;
 }
 
 void be_destroy_jit_segment(ir_jit_segment_t *segment)
 {
+	for (size_t i = 0, n = ARR_LEN(segment->entities); i < n; ++i)
+		be_jit_set_entity_addr(segment->entities[i], (void const*)-1);
+	DEL_ARR_F(segment->entities);
+	for (exec_chunk_t *chunk = segment->chunks, *next; chunk; chunk = next) {
+		next = chunk->next;
+		free_exec_chunk(chunk);
+	}
 	obstack_free(&segment->code_obst, NULL);
 	obstack_free(&segment->fragment_info_obst, NULL);
 	obstack_free(&segment->fragment_info_arr_obst, NULL);
+	obstack_free(&segment->stub_obst, NULL);
+	free(segment->cache_dir);
 	free(segment);
 }
 
+int be_jit_set_lazy(ir_jit_segment_t *const segment, int const lazy)
+{
+	if (lazy && (ir_target.isa->emit_jit_stub == NULL
+	          || ir_target.isa->emit_jit_resolver == NULL))
+		return false;
+	segment->lazy = lazy;
+	return true;
+}
+
+void be_jit_set_cache_dir(ir_jit_segment_t *const segment,
+                          char const *const directory)
+{
+	free(segment->cache_dir);
+	segment->cache_dir = directory != NULL ? xstrdup(directory) : NULL;
+}
+
+char const *be_jit_get_cache_dir(ir_jit_segment_t const *const segment)
+{
+	return segment->cache_dir;
+}
+
 void be_jit_set_entity_addr(ir_entity *entity, void const *address)
 {
 	assert(is_global_entity(entity));
@@ -101,6 +318,7 @@ void be_jit_begin_function(ir_jit_segment_t *const segment)
 	code_obst              = &segment->code_obst;
 	fragment_info_obst     = &segment->fragment_info_obst;
 	fragment_info_arr_obst = &segment->fragment_info_arr_obst;
+	current_segment        = segment;
 }
 
 static void layout_fragments(ir_jit_function_t *const function,
@@ -150,6 +368,7 @@ ir_jit_function_t *be_jit_finish_function(void)
 	res->n_fragments    = n_fragments;
 	res->fragment_infos = fragment_infos;
 	res->code           = obstack_finish(code_obst);
+	res->segment        = current_segment;
 
 	layout_fragments(res, code_size);
 
@@ -157,6 +376,7 @@ ir_jit_function_t *be_jit_finish_function(void)
 	code_obst              = NULL;
 	fragment_info_obst     = NULL;
 	fragment_info_arr_obst = NULL;
+	current_segment        = NULL;
 #endif
 
 	return res;
@@ -167,6 +387,117 @@ unsigned be_get_function_size(ir_jit_function_t const *const function)
 	return function->size;
 }
 
+void be_jit_set_function_entity(ir_jit_function_t *const function,
+                                ir_entity *const entity)
+{
+	function->entity = entity;
+}
+
+ir_jit_segment_t *be_jit_get_function_segment(
+		ir_jit_function_t const *const function)
+{
+	return function->segment;
+}
+
+/** Called by the resolver, when a stub is executed for the first time. */
+static void *resolve_stub(void *const *const target)
+{
+	jit_stub_t *const stub = (jit_stub_t*)target;
+	ir_entity  *const entity = stub->entity;
+	ir_graph   *const irg    = get_entity_irg(entity);
+
+	/* The entity keeps the address of the stub, so function pointers taken
+	 * before and after compilation compare equal. */
+	ir_jit_function_t *const function = be_jit_compile(stub->segment, irg);
+	if (function == NULL)
+		panic("could not compile %+F lazily", entity);
+	void *const code = be_jit_emit_executable(function);
+	stub->target = code;
+	return code;
+}
+
+/** Copies @p size bytes of code created by @p emit into executable memory. */
+static char *new_exec_code(ir_jit_segment_t *const segment,
+                           unsigned (*const emit)(char *buffer, void *data),
+                           void *const data)
+{
+	unsigned const size   = emit(NULL, data);
+	char    *const buffer = alloc_exec_memory(segment, size);
+	protect_memory(buffer, size, false);
+	emit(buffer, data);
+	protect_memory(buffer, size, true);
+	return buffer;
+}
+
+static unsigned emit_resolver(char *const buffer, void *const data)
+{
+	(void)data;
+	return ir_target.isa->emit_jit_resolver(buffer, resolve_stub);
+}
+
+static unsigned emit_stub(char *const buffer, void *const data)
+{
+	return ir_target.isa->emit_jit_stub(buffer, (void *const*)data);
+}
+
+/**
+ * Gives functions referenced by @p function, which have a graph but no
+ * address yet, the address of a new stub.
+ */
+static void create_lazy_stubs(ir_jit_function_t const *const function)
+{
+	ir_jit_segment_t *const segment = function->segment;
+	if (segment == NULL || !segment->lazy)
+		return;
+
+	for (unsigned i = 0, n = function->n_fragments; i < n; ++i) {
+		fragment_info_t const *const fragment = function->fragment_infos[i];
+		for (unsigned r = 0, n_r = fragment->n_relocations; r < n_r; ++r) {
+			relocation_t const *const relocation = &fragment->relocations[r];
+			if (relocation->dest_kind != RELOC_DEST_ENTITY)
+				continue;
+			ir_entity *const entity = relocation->dest.entity;
+			if (!is_method_entity(entity) || get_entity_irg(entity) == NULL
+			 || be_jit_get_entity_addr(entity) != (void const*)-1)
+				continue;
+
+			if (segment->resolver == NULL)
+				segment->resolver = new_exec_code(segment, emit_resolver, NULL);
+			jit_stub_t *const stub = OALLOC(&segment->stub_obst, jit_stub_t);
+			stub->target  = segment->resolver;
+			stub->segment = segment;
+			stub->entity  = entity;
+			char *const code = new_exec_code(segment, emit_stub, stub);
+			be_jit_set_entity_addr(entity, code);
+			ARR_APP1(ir_entity*, segment->entities, entity);
+		}
+	}
+}
+
+void *be_jit_emit_executable(ir_jit_function_t *const function)
+{
+	if (function->executable != NULL)
+		return function->executable;
+
+	unsigned const size   = function->size;
+	char    *const buffer = alloc_exec_memory(function->segment, size);
+	/* Set the address first, so recursive calls resolve. */
+	ir_entity *const entity = function->entity;
+	if (entity != NULL && be_jit_get_entity_addr(entity) == (void const*)-1) {
+		be_jit_set_entity_addr(entity, buffer);
+		ARR_APP1(ir_entity*, function->segment->entities, entity);
+	}
+	/* stubs are created before the function's memory is writable */
+	create_lazy_stubs(function);
+
+	protect_memory(buffer, size, false);
+	be_emit_function(buffer, function);
+	protect_memory(buffer, size, true);
+
+	function->executable = buffer;
+	return buffer;
+}
+
 unsigned be_begin_fragment(uint8_t const p2align, uint8_t const max_skip)
 {
 	assert(obstack_object_size(fragment_info_obst) == 0);
@@ -203,6 +534,32 @@ void be_finish_fragment(void)
 #endif
 }
 
+unsigned be_jit_get_code_position(void)
+{
+	return obstack_object_size(code_obst);
+}
+
+unsigned be_jit_get_code_address(ir_jit_function_t const *const function,
+                                  unsigned const position)
+{
+	unsigned orig_address = 0;
+	for (unsigned i = 0, n = function->n_fragments; i < n; ++i) {
+		fragment_info_t const *const fragment = function->fragment_infos[i];
+		if (position < orig_address + fragment->len)
+			return fragment->address + (position - orig_address);
+		orig_address += fragment->len;
+	}
+	assert(position == orig_address);
+	return function->size;
+}
+
+unsigned be_jit_get_fragment_address(ir_jit_function_t const *const function,
+                                     unsigned const fragment_num)
+{
+	assert(fragment_num < function->n_fragments);
+	return function->fragment_infos[fragment_num]->address;
+}
+
 static void be_emit_relocation(unsigned const len, relocation_t *const relocation)
 {
 	fragment_info_t *const fragment = obstack_base(fragment_info_obst);
@@ -275,7 +632,9 @@ static void emit_bytes_as_asm(char const *const begin, char const *const end)
 {
 	assert(begin <= end);
 	for (char const *b = begin; b < end; ++b) {
-		be_emit_irprintf("\t.byte 0x%02X\n", (uint8_t)*b);
+		be_emit_cstring("\t.byte 0x");
+		be_emit_hex((uint8_t)*b, 2, true);
+		be_emit_char('\n');
 		be_emit_write_line();
 	}
 }
@@ -353,6 +712,8 @@ static void emit_fragment(ir_jit_function_t const *const function,
 void be_jit_emit_memory(char *const buffer, ir_jit_function_t *const function,
                         be_jit_emit_interface_t const *const emitter)
 {
+	create_lazy_stubs(function);
+
 	/* Copy fragments and resolve relocations. */
 	char const *const code         = function->code;
 	unsigned          orig_address = 0;
@@ -360,7 +721,7 @@ void be_jit_emit_memory(char *const buffer, ir_jit_function_t *const function,
 	for (size_t i = 0, n = function->n_fragments; i < n; ++i) {
 		fragment_info_t const *const fragment  = function->fragment_infos[i];
 		unsigned               const address   = fragment->address;
-		unsigned               const nop_bytes = last_address - address;
+		unsigned               const nop_bytes = address - last_address;
 		assert(address >= last_address);
 		if (nop_bytes > 0)
 			emitter->nops(buffer + last_address, nop_bytes);
@@ -372,3 +733,195 @@ void be_jit_emit_memory(char *const buffer, ir_jit_function_t *const function,
 		last_address = address + fragment->len;
 	}
 }
+
+/*
+ * Functions are stored in the code cache as the code of all fragments
+ * followed by the fragments and their relocations. Entities are referenced
+ * by their linker name.
+ */
+typedef struct cached_function_t {
+	uint32_t n_fragments;
+	uint32_t code_size;
+} cached_function_t;
+
+typedef struct cached_fragment_t {
+	uint32_t len;
+	uint8_t  p2align;
+	uint8_t  max_skip;
+	uint16_t n_relocations;
+} cached_fragment_t;
+
+typedef struct cached_relocation_t {
+	uint8_t  be_kind;
+	uint8_t  dest_kind;
+	uint16_t offset;
+	int32_t  dest_offset;
+	uint16_t fragment_num;
+	uint16_t name_len; /**< Length of the entity name following. */
+} cached_relocation_t;
+
+typedef struct cache_reader_t {
+	char const *pos;
+	char const *end;
+} cache_reader_t;
+
+/** Returns whether @p entity is found by its name in another process. */
+static bool is_cacheable_entity(ir_entity *const entity)
+{
+	return is_global_entity(entity)
+	    && ir_get_global(get_entity_ld_ident(entity)) == entity;
+}
+
+bool be_jit_write_function(FILE *const out,
+                           ir_jit_function_t const *const function)
+{
+	unsigned const n_fragments = function->n_fragments;
+	unsigned       code_size   = 0;
+	for (unsigned i = 0; i < n_fragments; ++i) {
+		fragment_info_t const *const fragment = function->fragment_infos[i];
+		code_size += fragment->len;
+		for (unsigned r = 0, n = fragment->n_relocations; r < n; ++r) {
+			relocation_t const *const relocation = &fragment->relocations[r];
+			if (relocation->dest_kind == RELOC_DEST_ENTITY
+			 && !is_cacheable_entity(relocation->dest.entity))
+				return false;
+		}
+	}
+
+	cached_function_t const header = {
+		.n_fragments = n_fragments,
+		.code_size   = code_size,
+	};
+	if (fwrite(&header, sizeof(header), 1, out) != 1
+	 || fwrite(function->code, 1, code_size, out) != code_size)
+		return false;
+
+	for (unsigned i = 0; i < n_fragments; ++i) {
+		fragment_info_t const *const fragment = function->fragment_infos[i];
+		cached_fragment_t const cached = {
+			.len           = fragment->len,
+			.p2align       = fragment->p2align,
+			.max_skip      = fragment->max_skip,
+			.n_relocations = fragment->n_relocations,
+		};
+		if (fwrite(&cached, sizeof(cached), 1, out) != 1)
+			return false;
+
+		for (unsigned r = 0, n = fragment->n_relocations; r < n; ++r) {
+			relocation_t const *const relocation = &fragment->relocations[r];
+			cached_relocation_t cached_reloc = {
+				.be_kind     = relocation->be_kind,
+				.dest_kind   = relocation->dest_kind,
+				.offset      = relocation->offset,
+				.dest_offset = relocation->dest_offset,
+			};
+			char const *name = NULL;
+			if (relocation->dest_kind == RELOC_DEST_ENTITY) {
+				name = get_entity_ld_name(relocation->dest.entity);
+				size_t const len = strlen(name);
+				if (len > UINT16_MAX)
+					return false;
+				cached_reloc.name_len = len;
+			} else {
+				cached_reloc.fragment_num = relocation->dest.fragment_num;
+			}
+			if (fwrite(&cached_reloc, sizeof(cached_reloc), 1, out) != 1
+			 || (name != NULL && fwrite(name, 1, cached_reloc.name_len, out)
+			                     != cached_reloc.name_len))
+				return false;
+		}
+	}
+	return true;
+}
+
+static char const *read_data(cache_reader_t *const reader, size_t const size)
+{
+	char const *const res = reader->pos;
+	if ((size_t)(reader->end - res) < size)
+		return NULL;
+	reader->pos += size;
+	return res;
+}
+
+/**
+ * Parses a cached function. Without @p build, it only checks that the
+ * data is complete and all entities exist.
+ */
+static bool read_function(cache_reader_t reader, bool const build)
+{
+	cached_function_t header;
+	char const *const header_data = read_data(&reader, sizeof(header));
+	if (header_data == NULL)
+		return false;
+	memcpy(&header, header_data, sizeof(header));
+	char const *const code = read_data(&reader, header.code_size);
+	if (code == NULL)
+		return false;
+
+	unsigned orig_address = 0;
+	for (unsigned i = 0; i < header.n_fragments; ++i) {
+		cached_fragment_t fragment;
+		char const *const fragment_data = read_data(&reader, sizeof(fragment));
+		if (fragment_data == NULL)
+			return false;
+		memcpy(&fragment, fragment_data, sizeof(fragment));
+		if (fragment.len > header.code_size - orig_address)
+			return false;
+
+		if (build) {
+			be_begin_fragment(fragment.p2align, fragment.max_skip);
+			obstack_grow(code_obst, code + orig_address, fragment.len);
+		}
+		for (unsigned r = 0; r < fragment.n_relocations; ++r) {
+			cached_relocation_t cached;
+			char const *const reloc_data = read_data(&reader, sizeof(cached));
+			if (reloc_data == NULL)
+				return false;
+			memcpy(&cached, reloc_data, sizeof(cached));
+			if (cached.offset >= fragment.len)
+				return false;
+
+			relocation_t relocation = {
+				.be_kind     = cached.be_kind,
+				.dest_kind   = (reloc_dest_kind_t)cached.dest_kind,
+				.offset      = cached.offset,
+				.dest_offset = cached.dest_offset,
+			};
+			if (cached.dest_kind == RELOC_DEST_ENTITY) {
+				char const *const name = read_data(&reader, cached.name_len);
+				if (name == NULL)
+					return false;
+				ident     *const id     = new_id_from_chars(name,
+				                                            cached.name_len);
+				ir_entity *const entity = ir_get_global(id);
+				if (entity == NULL)
+					return false;
+				relocation.dest.entity = entity;
+			} else if (cached.dest_kind == RELOC_DEST_CODE_FRAGMENT
+			        && cached.fragment_num < header.n_fragments) {
+				relocation.dest.fragment_num = cached.fragment_num;
+			} else {
+				return false;
+			}
+			if (build)
+				obstack_grow(fragment_info_obst, &relocation,
+				             sizeof(relocation));
+		}
+		if (build)
+			be_finish_fragment();
+		orig_address += fragment.len;
+	}
+	return orig_address == header.code_size && reader.pos == reader.end;
+}
+
+ir_jit_function_t *be_jit_read_function(ir_jit_segment_t *const segment,
+                                        char const *const data,
+                                        size_t const size)
+{
+	cache_reader_t const reader = { data, data + size };
+	if (!read_function(reader, false))
+		return NULL;
+	be_jit_begin_function(segment);
+	read_function(reader, true);
+	return be_jit_finish_function();
+}
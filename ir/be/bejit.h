@@ -12,7 +12,9 @@
 #ifndef FIRM_BE_BEEMITTER_BINARY_H
 #define FIRM_BE_BEEMITTER_BINARY_H
 
+#include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>
 
 #include "firm_types.h"
 #include "jit.h"
@@ -38,9 +40,46 @@ void be_jit_emit_as_asm(ir_jit_function_t *function, emit_relocation_func emit);
 void be_jit_begin_function(ir_jit_segment_t *segment);
 ir_jit_function_t *be_jit_finish_function(void);
 
+/** Set the entity, whose address is set by be_jit_emit_executable(). */
+void be_jit_set_function_entity(ir_jit_function_t *function, ir_entity *entity);
+
+ir_jit_segment_t *be_jit_get_function_segment(
+		ir_jit_function_t const *function);
+
+/** Returns the directory of the code cache of @p segment or NULL. */
+char const *be_jit_get_cache_dir(ir_jit_segment_t const *segment);
+
+/**
+ * Writes @p function to @p out. Fails, if the function references an entity
+ * that cannot be found by name.
+ */
+bool be_jit_write_function(FILE *out, ir_jit_function_t const *function);
+
+/**
+ * Reads a function written by be_jit_write_function() from the @p size bytes
+ * at @p data into @p segment. Returns NULL if the data is damaged or
+ * references an unknown entity.
+ */
+ir_jit_function_t *be_jit_read_function(ir_jit_segment_t *segment,
+                                        char const *data, size_t size);
+
 unsigned be_begin_fragment(uint8_t p2align, uint8_t max_skip);
 void be_finish_fragment(void);
 
+/** Returns the position of the next byte emitted into the current function. */
+unsigned be_jit_get_code_position(void);
+
+/**
+ * Returns the address relative to the begin of @p function, which code
+ * emitted at @p position by be_jit_get_code_position() ends up at.
+ */
+unsigned be_jit_get_code_address(ir_jit_function_t const *function,
+                                  unsigned position);
+
+/** Returns the address of fragment @p fragment_num in @p function. */
+unsigned be_jit_get_fragment_address(ir_jit_function_t const *function,
+                                     unsigned fragment_num);
+
 extern struct obstack *code_obst;
 
 /** Append a byte to the current fragment */
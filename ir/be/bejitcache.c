@@ -0,0 +1,516 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2012 University of Karlsruhe.
+ */
+
+/**
+ * @file
+ * @brief       Persistent cache of just in time compiled functions.
+ *
+ * Every cache entry is a file named after the fingerprint of the compiled
+ * graph. It holds the code bytes, the fragment layout and the relocations
+ * of the function, entities are referenced by their linker name. Loading
+ * an entry skips code generation, the function is only relocated when it
+ * is emitted. A checksum in the header rejects damaged entries.
+ */
+#include "bejitcache.h"
+
+#include "array.h"
+#include "bejit.h"
+#include "entity_t.h"
+#include "irgraph_t.h"
+#include "irgwalk.h"
+#include "irnode_t.h"
+#include "irtools.h"
+#include "lc_opts.h"
+#include "target_t.h"
+#include "tv.h"
+#include "typerep.h"
+#include "util.h"
+#include "xmalloc.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+/** Identifies cache files, the last byte is the version of the format. */
+static const char cache_magic[4] = { 'F', 'J', 'I', 2 };
+
+/** Maximum depth up to which referenced types are hashed. */
+#define MAX_TYPE_DEPTH 3
+
+#define FNV64_OFFSET_BASIS UINT64_C(14695981039346656037)
+#define FNV64_PRIME        UINT64_C(1099511628211)
+
+typedef struct cache_header_t {
+	char     magic[sizeof(cache_magic)];
+	uint32_t pointer_size;
+	uint64_t fingerprint;
+	uint64_t checksum; /**< Hash of the data following the header. */
+} cache_header_t;
+
+typedef struct fingerprint_env_t {
+	uint64_t   hash;
+	ir_node  **nodes;
+} fingerprint_env_t;
+
+static void hash_bytes(uint64_t *const hash, void const *const data,
+                       size_t const size)
+{
+	unsigned char const *const bytes = (unsigned char const*)data;
+	uint64_t h = *hash;
+	for (size_t i = 0; i < size; ++i) {
+		h ^= bytes[i];
+		h *= FNV64_PRIME;
+	}
+	*hash = h;
+}
+
+static void hash_u64(uint64_t *const hash, uint64_t const value)
+{
+	hash_bytes(hash, &value, sizeof(value));
+}
+
+static void hash_string(uint64_t *const hash, char const *const str)
+{
+	if (str == NULL) {
+		hash_u64(hash, 0);
+		return;
+	}
+	/* including the terminator keeps consecutive strings apart */
+	hash_bytes(hash, str, strlen(str) + 1);
+}
+
+static void hash_ident(uint64_t *const hash, ident *const id)
+{
+	hash_string(hash, id != NULL ? get_id_str(id) : NULL);
+}
+
+static void hash_mode(uint64_t *const hash, ir_mode const *const mode)
+{
+	hash_string(hash, mode != NULL ? get_mode_name(mode) : NULL);
+}
+
+static void hash_tarval(uint64_t *const hash, ir_tarval const *const tv)
+{
+	ir_mode *const mode = get_tarval_mode(tv);
+	hash_mode(hash, mode);
+	if (mode == mode_b) {
+		hash_u64(hash, tarval_is_null(tv));
+		return;
+	}
+	unsigned const n_bytes = (get_mode_size_bits(mode) + 7) / 8;
+	for (unsigned i = 0; i < n_bytes; ++i)
+		hash_u64(hash, get_tarval_sub_bits(tv, i));
+}
+
+static void hash_type(uint64_t *const hash, ir_type const *const type,
+                      unsigned const depth)
+{
+	if (type == NULL) {
+		hash_u64(hash, 0);
+		return;
+	}
+	tp_opcode const opcode = get_type_opcode(type);
+	hash_string(hash, get_type_opcode_name(opcode));
+	hash_mode(hash, get_type_mode(type));
+	if (depth == 0)
+		return;
+
+	switch (opcode) {
+	case tpo_method:
+		hash_u64(hash, get_method_calling_convention(type));
+		hash_u64(hash, get_method_additional_properties(type));
+		hash_u64(hash, is_method_variadic(type));
+		for (size_t i = 0, n = get_method_n_params(type); i < n; ++i)
+			hash_type(hash, get_method_param_type(type, i), depth - 1);
+		hash_u64(hash, get_method_n_ress(type));
+		for (size_t i = 0, n = get_method_n_ress(type); i < n; ++i)
+			hash_type(hash, get_method_res_type(type, i), depth - 1);
+		return;
+	case tpo_pointer:
+		hash_type(hash, get_pointer_points_to_type(type), depth - 1);
+		return;
+	case tpo_array:
+		hash_u64(hash, get_type_size(type));
+		hash_type(hash, get_array_element_type(type), depth - 1);
+		return;
+	case tpo_class:
+	case tpo_struct:
+	case tpo_union:
+	case tpo_segment:
+		hash_u64(hash, get_type_size(type));
+		hash_u64(hash, get_type_alignment(type));
+		for (size_t i = 0, n = get_compound_n_members(type); i < n; ++i) {
+			ir_entity const *const member = get_compound_member(type, i);
+			if (is_entity_compound_member(member)) {
+				hash_u64(hash, get_entity_offset(member));
+				hash_u64(hash, get_entity_bitfield_offset(member));
+				hash_u64(hash, get_entity_bitfield_size(member));
+			}
+			hash_type(hash, get_entity_type(member), depth - 1);
+		}
+		return;
+	case tpo_primitive:
+	case tpo_code:
+	case tpo_unknown:
+	case tpo_uninitialized:
+		return;
+	}
+	panic("invalid type %+F", type);
+}
+
+static void hash_entity(uint64_t *const hash, ir_entity const *const entity)
+{
+	if (entity == NULL) {
+		hash_u64(hash, 0);
+		return;
+	}
+	ir_entity_kind const kind = get_entity_kind(entity);
+	hash_u64(hash, kind);
+	hash_u64(hash, get_entity_visibility(entity));
+	hash_u64(hash, get_entity_linkage(entity));
+	hash_u64(hash, get_entity_volatility(entity));
+	hash_u64(hash, get_entity_alignment(entity));
+	hash_type(hash, get_entity_type(entity), MAX_TYPE_DEPTH - 1);
+
+	switch (kind) {
+	case IR_ENTITY_COMPOUND_MEMBER:
+		hash_u64(hash, get_entity_offset(entity));
+		hash_u64(hash, get_entity_bitfield_offset(entity));
+		hash_u64(hash, get_entity_bitfield_size(entity));
+		return;
+	case IR_ENTITY_PARAMETER:
+		hash_u64(hash, get_entity_parameter_number(entity));
+		return;
+	case IR_ENTITY_NORMAL: {
+		/* The backend may place the value of private constants into the
+		 * code, depending on whether the user gave them an address. */
+		hash_ident(hash, get_entity_ld_ident(entity));
+		bool const has_addr
+			= be_jit_get_entity_addr(entity) != (void const*)-1;
+		hash_u64(hash, has_addr);
+		ir_initializer_t const *const initializer
+			= get_entity_initializer(entity);
+		if (!has_addr && initializer != NULL
+		 && get_initializer_kind(initializer) == IR_INITIALIZER_TARVAL)
+			hash_tarval(hash, get_initializer_tarval_value(initializer));
+		return;
+	}
+	case IR_ENTITY_METHOD:
+	case IR_ENTITY_ALIAS:
+		hash_ident(hash, get_entity_ld_ident(entity));
+		return;
+	case IR_ENTITY_LABEL:
+	case IR_ENTITY_UNKNOWN:
+	case IR_ENTITY_SPILLSLOT:
+		return;
+	}
+	panic("invalid entity %+F", entity);
+}
+
+static void hash_node_attrs(uint64_t *const hash, ir_node const *const node)
+{
+	switch (get_irn_opcode(node)) {
+	case iro_Address:
+		hash_entity(hash, get_Address_entity(node));
+		return;
+	case iro_Offset:
+		hash_entity(hash, get_Offset_entity(node));
+		return;
+	case iro_Align:
+		hash_type(hash, get_Align_type(node), MAX_TYPE_DEPTH);
+		return;
+	case iro_Size:
+		hash_type(hash, get_Size_type(node), MAX_TYPE_DEPTH);
+		return;
+	case iro_Alloc:
+		hash_u64(hash, get_Alloc_alignment(node));
+		return;
+	case iro_ASM: {
+		hash_ident(hash, get_ASM_text(node));
+		ir_asm_constraint const *const constraints = get_ASM_constraints(node);
+		for (size_t i = 0, n = get_ASM_n_constraints(node); i < n; ++i) {
+			hash_u64(hash, (uint64_t)constraints[i].in_pos);
+			hash_u64(hash, (uint64_t)constraints[i].out_pos);
+			hash_ident(hash, constraints[i].constraint);
+			hash_mode(hash, constraints[i].mode);
+		}
+		ident **const clobbers = get_ASM_clobbers(node);
+		for (size_t i = 0, n = get_ASM_n_clobbers(node); i < n; ++i)
+			hash_ident(hash, clobbers[i]);
+		return;
+	}
+	case iro_Builtin:
+		hash_u64(hash, get_Builtin_kind(node));
+		hash_type(hash, get_Builtin_type(node), MAX_TYPE_DEPTH);
+		return;
+	case iro_Call:
+		hash_type(hash, get_Call_type(node), MAX_TYPE_DEPTH);
+		return;
+	case iro_Cmp:
+		hash_u64(hash, get_Cmp_relation(node));
+		return;
+	case iro_Cond:
+		hash_u64(hash, get_Cond_jmp_pred(node));
+		return;
+	case iro_Confirm:
+		hash_u64(hash, get_Confirm_relation(node));
+		return;
+	case iro_Const:
+		hash_tarval(hash, get_Const_tarval(node));
+		return;
+	case iro_CopyB:
+		hash_type(hash, get_CopyB_type(node), MAX_TYPE_DEPTH);
+		hash_u64(hash, get_CopyB_volatility(node));
+		return;
+	case iro_Div:
+		hash_mode(hash, get_Div_resmode(node));
+		hash_u64(hash, get_Div_no_remainder(node));
+		return;
+	case iro_Load:
+		hash_mode(hash, get_Load_mode(node));
+		hash_type(hash, get_Load_type(node), MAX_TYPE_DEPTH);
+		hash_u64(hash, get_Load_volatility(node));
+		hash_u64(hash, get_Load_unaligned(node));
+		return;
+	case iro_Member:
+		hash_entity(hash, get_Member_entity(node));
+		return;
+	case iro_Mod:
+		hash_mode(hash, get_Mod_resmode(node));
+		return;
+	case iro_Phi:
+		hash_u64(hash, get_Phi_loop(node));
+		return;
+	case iro_Proj:
+		hash_u64(hash, get_Proj_num(node));
+		return;
+	case iro_Sel:
+		hash_type(hash, get_Sel_type(node), MAX_TYPE_DEPTH);
+		return;
+	case iro_Store:
+		hash_type(hash, get_Store_type(node), MAX_TYPE_DEPTH);
+		hash_u64(hash, get_Store_volatility(node));
+		hash_u64(hash, get_Store_unaligned(node));
+		return;
+	case iro_Switch: {
+		hash_u64(hash, get_Switch_n_outs(node));
+		ir_switch_table const *const table = get_Switch_table(node);
+		for (size_t i = 0, n = ir_switch_table_get_n_entries(table); i < n;
+		     ++i) {
+			ir_tarval const *const min = ir_switch_table_get_min(table, i);
+			if (min == NULL)
+				continue;
+			hash_tarval(hash, min);
+			hash_tarval(hash, ir_switch_table_get_max(table, i));
+			hash_u64(hash, ir_switch_table_get_pn(table, i));
+		}
+		return;
+	}
+	default:
+		return;
+	}
+}
+
+static void hash_option(void *const data, char const *const name,
+                        char const *const value)
+{
+	uint64_t *const hash = (uint64_t*)data;
+	hash_string(hash, name);
+	hash_string(hash, value);
+}
+
+/**
+ * Hashes everything besides the graph, which determines the generated code:
+ * the cache format, the library version, the target and the current value of
+ * every option, however it was set, and the settings the target derived from
+ * the host CPU.
+ */
+static void hash_config(uint64_t *const hash)
+{
+	hash_bytes(hash, cache_magic, sizeof(cache_magic));
+	hash_u64(hash, ir_get_version_major());
+	hash_u64(hash, ir_get_version_minor());
+	hash_u64(hash, ir_get_version_micro());
+	hash_string(hash, ir_get_version_revision());
+	hash_string(hash, ir_get_version_build());
+	hash_u64(hash, ir_target.triple_hash);
+	hash_u64(hash, ir_target_pointer_size());
+	lc_opt_visit_values(firm_opt_get_root(), hash_option, hash);
+	arch_isa_if_t const *const isa = ir_target.isa;
+	if (isa->get_resolved_config != NULL) {
+		size_t            size;
+		void const *const config = isa->get_resolved_config(&size);
+		hash_bytes(hash, config, size);
+	}
+}
+
+/** Numbers nodes in walk order, which only depends on the graph structure. */
+static void number_node(ir_node *const node, void *const data)
+{
+	fingerprint_env_t *const env = (fingerprint_env_t*)data;
+	set_irn_link(node, INT_TO_PTR(ARR_LEN(env->nodes)));
+	ARR_APP1(ir_node*, env->nodes, node);
+}
+
+static uint64_t get_node_number(ir_node const *const node)
+{
+	return PTR_TO_INT(get_irn_link(node));
+}
+
+static void hash_node(uint64_t *const hash, ir_node const *const node)
+{
+	hash_string(hash, get_irn_opname(node));
+	hash_mode(hash, get_irn_mode(node));
+	hash_u64(hash, get_irn_pinned(node));
+	if (is_fragile_op(node))
+		hash_u64(hash, ir_throws_exception(node));
+	if (!is_Block(node))
+		hash_u64(hash, get_node_number(get_nodes_block(node)));
+	int const arity = get_irn_arity(node);
+	hash_u64(hash, (uint64_t)arity);
+	for (int i = 0; i < arity; ++i)
+		hash_u64(hash, get_node_number(get_irn_n(node, i)));
+	hash_node_attrs(hash, node);
+}
+
+uint64_t be_jit_fingerprint(ir_graph *const irg)
+{
+	fingerprint_env_t env = {
+		.hash  = FNV64_OFFSET_BASIS,
+		.nodes = NEW_ARR_F(ir_node*, 0),
+	};
+
+	hash_config(&env.hash);
+	hash_type(&env.hash, get_entity_type(get_irg_entity(irg)),
+	          MAX_TYPE_DEPTH);
+	hash_type(&env.hash, get_irg_frame_type(irg), MAX_TYPE_DEPTH);
+
+	ir_reserve_resources(irg, IR_RESOURCE_IRN_LINK);
+	irg_walk_graph(irg, NULL, number_node, &env);
+	for (size_t i = 0, n = ARR_LEN(env.nodes); i < n; ++i)
+		hash_node(&env.hash, env.nodes[i]);
+	ir_free_resources(irg, IR_RESOURCE_IRN_LINK);
+
+	DEL_ARR_F(env.nodes);
+	return env.hash;
+}
+
+/** Returns the name of the cache file of @p fingerprint, free() it. */
+static char *get_cache_path(char const *const directory,
+                            uint64_t const fingerprint)
+{
+	size_t const size = strlen(directory) + 32;
+	char  *const path = XMALLOCN(char, size);
+	snprintf(path, size, "%s/%016llx.fjit", directory,
+	         (unsigned long long)fingerprint);
+	return path;
+}
+
+/**
+ * Reads the rest of @p in into a buffer, which is returned in @p data and
+ * must be freed. Returns the number of bytes read.
+ */
+static size_t read_rest(FILE *const in, char **const data)
+{
+	char  *buffer = NULL;
+	size_t size   = 0;
+	for (size_t capacity = 4096;; capacity *= 2) {
+		buffer = XREALLOC(buffer, char, capacity);
+		size  += fread(buffer + size, 1, capacity - size, in);
+		if (size < capacity)
+			break;
+	}
+	*data = buffer;
+	return size;
+}
+
+static uint64_t get_checksum(char const *const data, size_t const size)
+{
+	uint64_t hash = FNV64_OFFSET_BASIS;
+	hash_bytes(&hash, data, size);
+	return hash;
+}
+
+ir_jit_function_t *be_jit_cache_load(ir_jit_segment_t *const segment,
+                                     uint64_t const fingerprint)
+{
+	char const *const directory = be_jit_get_cache_dir(segment);
+	if (directory == NULL)
+		return NULL;
+
+	char *const path = get_cache_path(directory, fingerprint);
+	FILE *const in   = fopen(path, "rb");
+	free(path);
+	if (in == NULL)
+		return NULL;
+
+	ir_jit_function_t *res = NULL;
+	cache_header_t     header;
+	if (fread(&header, sizeof(header), 1, in) == 1
+	 && memcmp(header.magic, cache_magic, sizeof(cache_magic)) == 0
+	 && header.pointer_size == sizeof(void*)
+	 && header.fingerprint == fingerprint) {
+		char        *data;
+		size_t const size = read_rest(in, &data);
+		if (!ferror(in) && get_checksum(data, size) == header.checksum)
+			res = be_jit_read_function(segment, data, size);
+		free(data);
+	}
+	fclose(in);
+	return res;
+}
+
+void be_jit_cache_store(ir_jit_function_t const *const function,
+                        uint64_t const fingerprint)
+{
+	char const *const directory
+		= be_jit_get_cache_dir(be_jit_get_function_segment(function));
+	if (directory == NULL)
+		return;
+
+	/* Write to a file private to this process first, so concurrent readers
+	 * never see a partial entry. */
+	char  *const path     = get_cache_path(directory, fingerprint);
+	size_t const tmp_size = strlen(path) + 32;
+	char  *const tmp_path = XMALLOCN(char, tmp_size);
+	snprintf(tmp_path, tmp_size, "%s.%ld.tmp", path, (long)getpid());
+
+	FILE *const out = fopen(tmp_path, "w+b");
+	if (out != NULL) {
+		cache_header_t header = {
+			.pointer_size = sizeof(void*),
+			.fingerprint  = fingerprint,
+		};
+		memcpy(header.magic, cache_magic, sizeof(cache_magic));
+		bool ok = fwrite(&header, sizeof(header), 1, out) == 1
+		       && be_jit_write_function(out, function);
+		/* read the function back to fill in the checksum */
+		if (ok && fseek(out, sizeof(header), SEEK_SET) == 0) {
+			char        *data;
+			size_t const size = read_rest(out, &data);
+			header.checksum = get_checksum(data, size);
+			free(data);
+			ok = !ferror(out) && fseek(out, 0, SEEK_SET) == 0
+			  && fwrite(&header, sizeof(header), 1, out) == 1;
+		} else {
+			ok = false;
+		}
+		ok &= fclose(out) == 0;
+#ifdef _WIN32
+		/* rename() does not replace existing files on windows */
+		if (ok)
+			remove(path);
+#endif
+		if (!ok || rename(tmp_path, path) != 0)
+			remove(tmp_path);
+	}
+	free(tmp_path);
+	free(path);
+}
@@ -0,0 +1,41 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2012 University of Karlsruhe.
+ */
+
+/**
+ * @file
+ * @brief       Persistent cache of just in time compiled functions.
+ */
+#ifndef FIRM_BE_BEJITCACHE_H
+#define FIRM_BE_BEJITCACHE_H
+
+#include <stdint.h>
+
+#include "firm_types.h"
+#include "jit.h"
+
+/**
+ * Computes a fingerprint of @p irg, which does not depend on node numbers
+ * or addresses and is thus stable across processes. It covers the graph
+ * structure, node attributes, the types and entities the graph references
+ * and the target configuration.
+ */
+uint64_t be_jit_fingerprint(ir_graph *irg);
+
+/**
+ * Loads the function with fingerprint @p fingerprint from the cache of
+ * @p segment. Returns NULL if there is no usable cache entry.
+ */
+ir_jit_function_t *be_jit_cache_load(ir_jit_segment_t *segment,
+                                     uint64_t fingerprint);
+
+/**
+ * Stores @p function in the cache of its segment under @p fingerprint.
+ * Functions referencing entities, which cannot be found by name in another
+ * process, are not stored.
+ */
+void be_jit_cache_store(ir_jit_function_t const *function,
+                        uint64_t fingerprint);
+
+#endif
@@ -0,0 +1,903 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2012 University of Karlsruhe.
+ */
+
+/**
+ * @file
+ * @brief       Linear scan register allocator.
+ *
+ * A register allocator for situations where compile time matters more than
+ * code quality, e.g. just in time compilation. It works on the existing
+ * schedule and handles one register class after the other:
+ *
+ * 1. The blocks are numbered in reverse postorder, which gives every value a
+ *    lifetime interval with a sorted list of use positions. Values flowing
+ *    along a loop back edge get an additional use at the end of the loop.
+ *
+ * 2. The spiller walks the blocks once and keeps at most as many values in
+ *    registers as there are allocatable registers. When it runs out of
+ *    registers it evicts the value whose next use is furthest away, which
+ *    gets a second chance by being reloaded in front of its next use. The
+ *    block borders are repaired with reloads on the control flow edges.
+ *    Spills and reloads are placed by the spill environment.
+ *
+ * 3. The assignment walks the blocks in the same order and picks a free
+ *    register for every definition. Constraints are resolved by moving only
+ *    the conflicting values and mismatches at block borders are repaired by
+ *    permutations in the predecessor.
+ *
+ * In contrast to the chordal allocator no interference graph is built and no
+ * copy minimization is done.
+ */
+#include "be_t.h"
+#include "bechordal_t.h"
+#include "beirg.h"
+#include "belive.h"
+#include "bemodule.h"
+#include "benode.h"
+#include "bera.h"
+#include "beraassign.h"
+#include "besched.h"
+#include "bespillutil.h"
+#include "beutil.h"
+#include "beverify.h"
+#include "debug.h"
+#include "iredges_t.h"
+#include "irgwalk.h"
+#include "irnode_t.h"
+#include "irtools.h"
+#include "obst.h"
+#include "panic.h"
+#include "raw_bitset.h"
+#include "statev.h"
+#include "target_t.h"
+#include "util.h"
+
+DEBUG_ONLY(static firm_dbg_module_t *dbg = NULL;)
+
+/** Marks a value without further uses. */
+#define NO_USE UINT_MAX
+/** Clobber marker of values which are live at the end of the block. */
+#define LIVE_OUT UINT_MAX
+
+static struct obstack               obst;
+static ir_graph                    *irg;
+static const arch_register_class_t *cls;
+static be_lv_t                     *lv;
+static unsigned                     n_regs;
+static unsigned                    *normal_regs;
+/** registers overwritten by some instruction, e.g. caller saved registers */
+static unsigned                    *clobbered_regs;
+static bool                         has_clobbers;
+/** the blocks in postorder */
+static ir_node                    **blocklist;
+
+/*
+ * Spilling
+ */
+
+typedef struct use_pos_t {
+	unsigned idx; /**< index of the used value */
+	unsigned pos; /**< position of the use */
+} use_pos_t;
+
+/** The uses of a value, a range of the sorted use array. */
+typedef struct value_uses_t {
+	unsigned cur;     /**< first use after the current position */
+	unsigned end;     /**< end of the range */
+	unsigned used_at; /**< position of the last processed use */
+} value_uses_t;
+
+typedef struct spill_block_t {
+	unsigned  start;     /**< position of the block begin */
+	unsigned  end;       /**< position of the block end */
+	unsigned  n_start;
+	unsigned  n_end;
+	ir_node **start_set; /**< values in registers at the block begin */
+	ir_node **end_set;   /**< values in registers at the block end, NULL if
+	                          the block was not processed yet */
+} spill_block_t;
+
+typedef struct start_cand_t {
+	ir_node  *value;
+	unsigned  prio;     /**< lower values are taken first */
+	unsigned  next_use;
+} start_cand_t;
+
+/** priorities of start set candidates */
+enum {
+	PRIO_KEEP,   /**< available in all predecessors or not spillable */
+	PRIO_NORMAL, /**< choose by next use */
+	PRIO_NEVER,  /**< not available in any predecessor or dead */
+};
+
+static spill_env_t   *senv;
+static use_pos_t     *uses;
+static value_uses_t  *value_uses;
+static start_cand_t  *start_cands;
+/** values currently in registers */
+static ir_node      **active;
+static unsigned       n_active;
+/** number of allocatable registers */
+static unsigned       n_slots;
+
+static spill_block_t *get_spill_block(ir_node const *const block)
+{
+	return (spill_block_t*)get_irn_link(block);
+}
+
+static void add_use(ir_node const *const value, unsigned const pos)
+{
+	use_pos_t const use = { .idx = get_irn_idx(value), .pos = pos };
+	ARR_APP1(use_pos_t, uses, use);
+}
+
+static int cmp_use_pos(void const *const a, void const *const b)
+{
+	use_pos_t const *const ua = (use_pos_t const*)a;
+	use_pos_t const *const ub = (use_pos_t const*)b;
+	if (ua->idx != ub->idx)
+		return QSORT_CMP(ua->idx, ub->idx);
+	return QSORT_CMP(ua->pos, ub->pos);
+}
+
+/**
+ * Numbers the blocks in reverse postorder and their instructions in schedule
+ * order and collects the use positions of all values.
+ */
+static void number_blocks(void)
+{
+	unsigned pos = 0;
+	for (size_t i = ARR_LEN(blocklist); i-- > 0;) {
+		ir_node       *const block = blocklist[i];
+		spill_block_t *const info  = OALLOCZ(&obst, spill_block_t);
+		set_irn_link(block, info);
+
+		info->start = pos++;
+		sched_foreach_non_phi(block, node) {
+			++pos;
+			be_foreach_use(node, cls, in_req, value, value_req,
+				add_use(value, pos);
+			);
+			be_foreach_definition(node, cls, value, req,
+				if (req->limited != NULL && get_irn_n_edges(value) == 0) {
+					rbitset_or(clobbered_regs, req->limited, n_regs);
+					has_clobbers = true;
+				}
+			);
+		}
+		info->end = pos++;
+	}
+
+	/* phi operands are used at the end of the predecessor, values live around
+	 * a loop are used again at the end of the loop */
+	for (size_t i = ARR_LEN(blocklist); i-- > 0;) {
+		ir_node             *const block = blocklist[i];
+		spill_block_t const *const info  = get_spill_block(block);
+		for (int p = 0, n = get_Block_n_cfgpreds(block); p < n; ++p) {
+			ir_node             *const pred      = get_Block_cfgpred_block(block, p);
+			spill_block_t const *const pred_info = get_spill_block(pred);
+			if (pred_info == NULL)
+				continue;
+			sched_foreach_phi(block, phi) {
+				if (!arch_irn_consider_in_reg_alloc(cls, phi))
+					continue;
+				ir_node *const op = get_Phi_pred(phi, p);
+				if (arch_irn_consider_in_reg_alloc(cls, op))
+					add_use(op, pred_info->end);
+			}
+			if (pred_info->end > info->start) {
+				be_lv_foreach_cls(lv, block, be_lv_state_in, cls, value) {
+					add_use(value, pred_info->end);
+				}
+			}
+		}
+	}
+
+	QSORT_ARR(uses, cmp_use_pos);
+	value_uses = XMALLOCNZ(value_uses_t, get_irg_last_idx(irg));
+	for (size_t i = 0, n = ARR_LEN(uses); i < n;) {
+		value_uses_t *const vu = &value_uses[uses[i].idx];
+		vu->cur = i;
+		while (i < n && uses[i].idx == uses[vu->cur].idx)
+			++i;
+		vu->end = i;
+	}
+}
+
+/**
+ * Returns the position of the first use of @p value after @p pos.
+ * The positions must be queried in ascending order.
+ */
+static unsigned get_next_use(ir_node const *const value, unsigned const pos)
+{
+	value_uses_t *const vu = &value_uses[get_irn_idx(value)];
+	while (vu->cur < vu->end && uses[vu->cur].pos <= pos)
+		++vu->cur;
+	return vu->cur < vu->end ? uses[vu->cur].pos : NO_USE;
+}
+
+static bool is_dont_spill(ir_node const *const value)
+{
+	return arch_get_irn_flags(skip_Proj_const(value)) & arch_irn_flag_dont_spill;
+}
+
+static bool set_contains(ir_node *const *const set, unsigned const n,
+                         ir_node const *const value)
+{
+	for (unsigned i = 0; i < n; ++i) {
+		if (set[i] == value)
+			return true;
+	}
+	return false;
+}
+
+static bool is_active(ir_node const *const value)
+{
+	return set_contains(active, n_active, value);
+}
+
+static void deactivate(ir_node const *const value)
+{
+	for (unsigned i = 0; i < n_active; ++i) {
+		if (active[i] == value) {
+			active[i] = active[--n_active];
+			return;
+		}
+	}
+}
+
+/**
+ * Evicts values from the registers until @p demand registers are free.
+ * The value whose next use is furthest away is evicted first.
+ *
+ * @param protect  do not evict the values used at @p pos
+ */
+static void make_room(unsigned const demand, unsigned const pos,
+                      bool const protect)
+{
+	while (n_active + demand > n_slots) {
+		unsigned best      = NO_REG;
+		unsigned best_dist = 0;
+		for (unsigned i = 0; i < n_active; ++i) {
+			ir_node const *const value = active[i];
+			if (protect && value_uses[get_irn_idx(value)].used_at == pos)
+				continue;
+			unsigned const dist = is_dont_spill(value) ? 0
+			                    : get_next_use(value, pos);
+			if (best == NO_REG || dist > best_dist) {
+				best      = i;
+				best_dist = dist;
+			}
+		}
+		if (best == NO_REG)
+			panic("not enough registers for instruction at position %u", pos);
+		DB((dbg, LEVEL_3, "    evict %+F\n", active[best]));
+		active[best] = active[--n_active];
+	}
+}
+
+static int cmp_start_cands(void const *const a, void const *const b)
+{
+	start_cand_t const *const ca = (start_cand_t const*)a;
+	start_cand_t const *const cb = (start_cand_t const*)b;
+	if (ca->prio != cb->prio)
+		return QSORT_CMP(ca->prio, cb->prio);
+	if (ca->next_use != cb->next_use)
+		return QSORT_CMP(ca->next_use, cb->next_use);
+	return QSORT_CMP(get_irn_idx(ca->value), get_irn_idx(cb->value));
+}
+
+static void add_start_cand(ir_node *const block, spill_block_t const *const info,
+                           ir_node *const value, bool const is_local_phi,
+                           bool const all_preds_known)
+{
+	start_cand_t cand = {
+		.value    = value,
+		.prio     = PRIO_NORMAL,
+		.next_use = get_next_use(value, info->start),
+	};
+	if (is_dont_spill(value)) {
+		cand.prio = PRIO_KEEP;
+	} else if (cand.next_use == NO_USE) {
+		cand.prio = PRIO_NEVER;
+	} else if (all_preds_known) {
+		/* prefer values which are in registers in the predecessors */
+		bool available = false;
+		bool missing   = false;
+		for (int p = 0, n = get_Block_n_cfgpreds(block); p < n; ++p) {
+			ir_node             *const pred      = get_Block_cfgpred_block(block, p);
+			spill_block_t const *const pred_info = get_spill_block(pred);
+			ir_node             *const op        = is_local_phi ? get_Phi_pred(value, p) : value;
+			if (set_contains(pred_info->end_set, pred_info->n_end, op))
+				available = true;
+			else
+				missing = true;
+		}
+		cand.prio = !missing ? PRIO_KEEP : available ? PRIO_NORMAL : PRIO_NEVER;
+	}
+	ARR_APP1(start_cand_t, start_cands, cand);
+}
+
+/**
+ * Decides which of the phis and live-in values of a block start in
+ * registers. Phis which do not start in a register are spilled.
+ */
+static void decide_start_set(ir_node *const block, spill_block_t *const info)
+{
+	bool all_preds_known = true;
+	for (int p = 0, n = get_Block_n_cfgpreds(block); p < n; ++p) {
+		ir_node             *const pred      = get_Block_cfgpred_block(block, p);
+		spill_block_t const *const pred_info = get_spill_block(pred);
+		if (pred_info == NULL || pred_info->end_set == NULL)
+			all_preds_known = false;
+	}
+
+	ARR_SHRINKLEN(start_cands, 0);
+	sched_foreach_phi(block, phi) {
+		if (arch_irn_consider_in_reg_alloc(cls, phi))
+			add_start_cand(block, info, phi, true, all_preds_known);
+	}
+	be_lv_foreach_cls(lv, block, be_lv_state_in, cls, value) {
+		add_start_cand(block, info, value, false, all_preds_known);
+	}
+	QSORT_ARR(start_cands, cmp_start_cands);
+
+	n_active = 0;
+	for (size_t i = 0, n = ARR_LEN(start_cands); i < n; ++i) {
+		start_cand_t const *const cand = &start_cands[i];
+		if (cand->prio != PRIO_NEVER && n_active < n_slots) {
+			active[n_active++] = cand->value;
+		} else if (is_Phi(cand->value) && get_nodes_block(cand->value) == block) {
+			DB((dbg, LEVEL_2, "  spill phi %+F\n", cand->value));
+			be_spill_phi(senv, cand->value);
+		}
+	}
+
+	info->n_start   = n_active;
+	info->start_set = OALLOCN(&obst, ir_node*, n_active);
+	MEMCPY(info->start_set, active, n_active);
+}
+
+/**
+ * Decides for every use in a block whether it is served from a register or
+ * needs a reload.
+ */
+static void spill_block(ir_node *const block)
+{
+	spill_block_t *const info = get_spill_block(block);
+	DB((dbg, LEVEL_2, "Spill %+F\n", block));
+	decide_start_set(block, info);
+
+	unsigned pos = info->start;
+	sched_foreach_non_phi(block, node) {
+		++pos;
+
+		/* the used values must be in registers */
+		unsigned n_reloads = 0;
+		be_foreach_use(node, cls, in_req, value, value_req,
+			value_uses_t *const vu = &value_uses[get_irn_idx(value)];
+			if (vu->used_at == pos)
+				continue;
+			vu->used_at = pos;
+			if (!is_active(value))
+				++n_reloads;
+		);
+		be_add_pressure_t const add_pressure = arch_get_additional_pressure(node, cls);
+		make_room(n_reloads + MAX(add_pressure, 0), pos, true);
+		be_foreach_use(node, cls, in_req, value, value_req,
+			if (!is_active(value)) {
+				DB((dbg, LEVEL_3, "    reload %+F before %+F\n", value, node));
+				be_add_reload(senv, value, node);
+				active[n_active++] = value;
+			}
+		);
+
+		/* values used for the last time free their register */
+		be_foreach_use(node, cls, in_req, value, value_req,
+			if (get_next_use(value, pos) > info->end
+			 && !be_is_live_end(lv, block, value))
+				deactivate(value);
+		);
+
+		/* the definitions need registers, even if they are unused */
+		unsigned n_defs = 0;
+		be_foreach_definition(node, cls, value, req,
+			(void)value;
+			assert(req->width == 1);
+			++n_defs;
+		);
+		make_room(n_defs + MAX(-add_pressure, 0), pos, false);
+		be_foreach_definition(node, cls, value, req,
+			if (get_next_use(value, pos) <= info->end
+			 || be_is_live_end(lv, block, value))
+				active[n_active++] = value;
+		);
+	}
+
+	info->n_end   = n_active;
+	info->end_set = OALLOCN(&obst, ir_node*, n_active);
+	MEMCPY(info->end_set, active, n_active);
+}
+
+/**
+ * Reloads values on the incoming edges of a block if they are expected in a
+ * register but are not in a register at the end of the predecessor.
+ */
+static void fix_block_borders(ir_node *const block)
+{
+	spill_block_t const *const info = get_spill_block(block);
+	for (int p = 0, n = get_Block_n_cfgpreds(block); p < n; ++p) {
+		ir_node             *const pred      = get_Block_cfgpred_block(block, p);
+		spill_block_t const *const pred_info = get_spill_block(pred);
+		if (pred_info == NULL)
+			continue;
+
+		for (unsigned i = 0; i < info->n_start; ++i) {
+			ir_node *value = info->start_set[i];
+			if (is_Phi(value) && get_nodes_block(value) == block) {
+				value = get_Phi_pred(value, p);
+				if (!arch_irn_consider_in_reg_alloc(cls, value))
+					continue;
+			}
+			if (!set_contains(pred_info->end_set, pred_info->n_end, value)) {
+				DB((dbg, LEVEL_3, "  reload %+F on edge %+F -> %+F\n", value,
+				    pred, block));
+				be_add_reload_on_edge(senv, value, block, p);
+			}
+		}
+	}
+}
+
+static void spill(const regalloc_if_t *regif)
+{
+	be_timer_push(T_RA_SPILL);
+	be_assure_live_sets(irg);
+	lv = be_get_irg_liveness(irg);
+	ir_reserve_resources(irg, IR_RESOURCE_IRN_LINK);
+	irg_block_walk_graph(irg, firm_clear_link, NULL, NULL);
+
+	n_slots     = be_get_n_allocatable_regs(irg, cls);
+	senv        = be_new_spill_env(irg, regif);
+	uses        = NEW_ARR_F(use_pos_t, 0);
+	start_cands = NEW_ARR_F(start_cand_t, 0);
+	active      = XMALLOCN(ir_node*, n_slots);
+	number_blocks();
+
+	for (size_t i = ARR_LEN(blocklist); i-- > 0;) {
+		spill_block(blocklist[i]);
+	}
+	for (size_t i = ARR_LEN(blocklist); i-- > 0;) {
+		fix_block_borders(blocklist[i]);
+	}
+	ir_free_resources(irg, IR_RESOURCE_IRN_LINK);
+
+	be_insert_spills_reloads(senv);
+
+	free(active);
+	DEL_ARR_F(start_cands);
+	free(value_uses);
+	DEL_ARR_F(uses);
+	be_delete_spill_env(senv);
+	obstack_free(&obst, NULL);
+	obstack_init(&obst);
+	be_timer_pop(T_RA_SPILL);
+
+	be_timer_push(T_RA_SPILL_APPLY);
+	check_for_memory_operands(irg, regif);
+	be_timer_pop(T_RA_SPILL_APPLY);
+
+	be_dump(DUMP_RA, irg, "spill");
+}
+
+/*
+ * Register assignment
+ */
+
+typedef struct allocation_info_t {
+	be_ra_value_t  value;           /**< copies of the value, first member */
+	unsigned      *last_uses;       /**< bitset indicating last uses (input
+	                                     pos) */
+	unsigned       live_mark;       /**< live marker of the block analysis */
+	unsigned       clobber_mark;    /**< clobbering instructions after last
+	                                     use */
+	unsigned       hint;            /**< register required by the next use */
+	bool           crosses_clobber; /**< value lives through a clobbering
+	                                     instruction */
+} allocation_info_t;
+
+/** the assignment state of the current register class */
+static be_ra_assign_env_t ra;
+static unsigned           live_stamp;
+
+static allocation_info_t *get_allocation_info(ir_node *const node)
+{
+	allocation_info_t *info = (allocation_info_t*)get_irn_link(node);
+	if (info == NULL) {
+		info = OALLOCZ(&obst, allocation_info_t);
+		info->value.current_value  = node;
+		info->value.original_value = node;
+		info->hint                 = NO_REG;
+		set_irn_link(node, info);
+	}
+	return info;
+}
+
+static allocation_info_t *try_get_allocation_info(ir_node const *const node)
+{
+	return (allocation_info_t*)get_irn_link(node);
+}
+
+static be_ra_value_t *get_ra_value(ir_node *const node)
+{
+	return &get_allocation_info(node)->value;
+}
+
+/**
+ * Determines the last uses in a block, register hints from constrained uses
+ * and which values live through clobbering instructions.
+ */
+static void analyze_block(ir_node *const block)
+{
+	unsigned const stamp = ++live_stamp;
+	be_lv_foreach_cls(lv, block, be_lv_state_end, cls, node) {
+		allocation_info_t *const info = get_allocation_info(node);
+		info->live_mark    = stamp;
+		info->clobber_mark = LIVE_OUT;
+	}
+
+	unsigned n_clobbers = 0;
+	sched_foreach_non_phi_reverse(block, node) {
+		bool clobbers = false;
+		be_foreach_definition(node, cls, value, req,
+			allocation_info_t *const info = get_allocation_info(value);
+			info->crosses_clobber = info->live_mark == stamp
+				&& (info->clobber_mark == LIVE_OUT || n_clobbers > info->clobber_mark);
+			info->live_mark = 0;
+			if (req->limited != NULL && get_irn_n_edges(value) == 0)
+				clobbers = true;
+		);
+		if (clobbers)
+			++n_clobbers;
+
+		allocation_info_t *node_info = NULL;
+		foreach_irn_in(node, i, op) {
+			if (!arch_irn_consider_in_reg_alloc(cls, op))
+				continue;
+
+			allocation_info_t         *const info = get_allocation_info(op);
+			arch_register_req_t const *const req  = arch_get_irn_register_req_in(node, i);
+			if (req->limited != NULL && rbitset_popcount(req->limited, n_regs) == 1)
+				info->hint = rbitset_next(req->limited, 0, true);
+			if (info->live_mark == stamp)
+				continue;
+
+			/* last use of the value */
+			info->live_mark    = stamp;
+			info->clobber_mark = n_clobbers;
+			if (node_info == NULL) {
+				node_info = get_allocation_info(node);
+				node_info->last_uses = rbitset_obstack_alloc(&obst, get_irn_arity(node));
+			}
+			rbitset_set(node_info->last_uses, i);
+		}
+	}
+}
+
+static void free_last_uses(ir_node *const node, unsigned const *const last_uses)
+{
+	if (last_uses == NULL)
+		return;
+	foreach_irn_in(node, i, op) {
+		if (rbitset_is_set(last_uses, i))
+			be_ra_free_reg_of_value(&ra, op);
+	}
+}
+
+/**
+ * Returns a free register out of @p allowed, or NO_REG. Values living
+ * through clobbering instructions prefer registers which are not clobbered,
+ * all other values prefer the clobbered ones.
+ */
+static unsigned find_free_reg(unsigned const *const allowed,
+                              bool const crosses_clobber)
+{
+	unsigned fallback = NO_REG;
+	rbitset_foreach(allowed, n_regs, r) {
+		if (ra.assignments[r] != NULL || !rbitset_is_set(normal_regs, r))
+			continue;
+		if (!has_clobbers
+		 || rbitset_is_set(clobbered_regs, r) != crosses_clobber)
+			return r;
+		if (fallback == NO_REG)
+			fallback = r;
+	}
+	return fallback;
+}
+
+static bool is_free_reg(unsigned const *const allowed, unsigned const r)
+{
+	return r != NO_REG && ra.assignments[r] == NULL
+	    && rbitset_is_set(allowed, r) && rbitset_is_set(normal_regs, r);
+}
+
+/**
+ * Determines a register for a definition. Registers of dying should_be_same
+ * inputs, of constrained uses and of phis using the value are preferred.
+ */
+static void assign_reg(ir_node *const value, arch_register_req_t const *const req)
+{
+	arch_register_t const *const preassigned = arch_get_irn_register(value);
+	if (preassigned != NULL) {
+		be_ra_use_reg(&ra, value, preassigned->index, 1);
+		return;
+	}
+	assert(!req->ignore);
+	assert(req->width == 1);
+
+	unsigned const *const allowed = req->limited != NULL ? req->limited
+	                                                     : normal_regs;
+	if (req->should_be_same != 0) {
+		ir_node *const insn = skip_Proj(value);
+		foreach_irn_in(insn, i, in) {
+			if (!rbitset_is_set(&req->should_be_same, i)
+			 || !arch_irn_consider_in_reg_alloc(cls, in))
+				continue;
+			unsigned const r = arch_get_irn_register(in)->index;
+			if (is_free_reg(allowed, r)) {
+				be_ra_use_reg(&ra, value, r, 1);
+				return;
+			}
+		}
+	}
+
+	allocation_info_t const *const info = get_allocation_info(value);
+	unsigned                 const hint = info->hint;
+	if (is_free_reg(allowed, hint)
+	 && !(info->crosses_clobber && rbitset_is_set(clobbered_regs, hint))) {
+		be_ra_use_reg(&ra, value, hint, 1);
+		return;
+	}
+
+	foreach_out_edge(value, edge) {
+		ir_node *const user = get_edge_src_irn(edge);
+		if (!is_Phi(user))
+			continue;
+		arch_register_t const *const reg = arch_get_irn_register(user);
+		if (reg != NULL && is_free_reg(allowed, reg->index)) {
+			be_ra_use_reg(&ra, value, reg->index, 1);
+			return;
+		}
+	}
+
+	unsigned const r = find_free_reg(allowed, info->crosses_clobber);
+	if (r == NO_REG)
+		panic("no register left for %+F", value);
+	be_ra_use_reg(&ra, value, r, 1);
+}
+
+/**
+ * Assigns registers to the live-in values and phis of a block. Live-in values
+ * which arrive in different copies get a new phi.
+ */
+static void assign_block_start(ir_node *const block)
+{
+	int             const n_preds    = get_Block_n_cfgpreds(block);
+	be_ra_block_t **const pred_infos = ALLOCAN(be_ra_block_t*, n_preds);
+	ir_node       **const phi_ins    = ALLOCAN(ir_node*, n_preds);
+	int                   first_pred = -1;
+	for (int p = 0; p < n_preds; ++p) {
+		pred_infos[p] = be_ra_get_block(&ra, get_Block_cfgpred_block(block, p));
+		if (first_pred < 0 && pred_infos[p]->processed)
+			first_pred = p;
+	}
+
+	/* the phis of the program, the created ones are added in front of them */
+	ir_node **phis = NEW_ARR_F(ir_node*, 0);
+	sched_foreach_phi(block, phi) {
+		if (arch_irn_consider_in_reg_alloc(cls, phi))
+			ARR_APP1(ir_node*, phis, phi);
+	}
+
+	be_lv_foreach(lv, block, be_lv_state_in, node) {
+		arch_register_req_t const *const req = arch_get_irn_register_req(node);
+		if (req->cls != cls)
+			continue;
+
+		if (req->ignore) {
+			get_allocation_info(node)->value.current_value = node;
+			be_ra_use_reg(&ra, node, arch_get_irn_register(node)->index, 1);
+			continue;
+		}
+
+		assert(first_pred >= 0);
+		bool need_phi = false;
+		for (int p = 0; p < n_preds; ++p) {
+			if (!pred_infos[p]->processed) {
+				/* fixed when the predecessor is processed */
+				phi_ins[p] = node;
+				need_phi   = true;
+			} else {
+				int const a = be_ra_find_value_in_block(&ra, pred_infos[p], node);
+				assert(a >= 0);
+				phi_ins[p] = pred_infos[p]->assignments[a];
+				if (p > 0 && phi_ins[p - 1] != phi_ins[p])
+					need_phi = true;
+			}
+		}
+
+		unsigned const r = arch_get_irn_register(phi_ins[first_pred])->index;
+		if (need_phi) {
+			ir_node *const phi = be_new_Phi(block, n_preds, phi_ins, cls->class_req);
+			DB((dbg, LEVEL_3, "  create %+F for %+F\n", phi, node));
+			be_ra_mark_as_copy_of(&ra, phi, node);
+			sched_add_after(block, phi);
+			be_ra_use_reg(&ra, phi, r, 1);
+		} else {
+			get_allocation_info(node)->value.current_value = phi_ins[0];
+			be_ra_use_reg(&ra, phi_ins[0], r, 1);
+		}
+	}
+
+	for (size_t i = 0, n = ARR_LEN(phis); i < n; ++i) {
+		ir_node *const phi = phis[i];
+		unsigned       r   = NO_REG;
+		if (first_pred >= 0) {
+			ir_node *const op = get_Phi_pred(phi, first_pred);
+			int      const a  = be_ra_find_value_in_block(&ra, pred_infos[first_pred], op);
+			if (a >= 0 && is_free_reg(normal_regs, (unsigned)a))
+				r = a;
+		}
+		if (r == NO_REG)
+			r = find_free_reg(normal_regs, true);
+		if (r == NO_REG)
+			panic("no register left for %+F", phi);
+		be_ra_use_reg(&ra, phi, r, 1);
+	}
+	DEL_ARR_F(phis);
+}
+
+static void assign_block(ir_node *const block)
+{
+	DB((dbg, LEVEL_2, "Assign %+F\n", block));
+	be_ra_block_t *const block_info = be_ra_get_block(&ra, block);
+	ra.assignments = block_info->assignments;
+	analyze_block(block);
+	assign_block_start(block);
+
+	sched_foreach_non_phi(block, node) {
+		allocation_info_t const *const info      = try_get_allocation_info(node);
+		unsigned const          *const last_uses = info != NULL ? info->last_uses : NULL;
+
+		be_ra_rewire_inputs(node);
+		be_ra_enforce_constraints(&ra, node, last_uses);
+		be_ra_rewire_inputs(node);
+		free_last_uses(node, last_uses);
+
+		/* constrained definitions first, they have less choice */
+		be_foreach_definition_(node, cls, value, req,
+			if (req->limited != NULL)
+				assign_reg(value, req);
+		);
+		be_foreach_definition_(node, cls, value, req,
+			if (req->limited == NULL)
+				assign_reg(value, req);
+		);
+		be_foreach_definition_(node, cls, value, req,
+			(void)req;
+			if (get_irn_n_edges(value) == 0)
+				be_ra_free_reg_of_value(&ra, value);
+		);
+	}
+
+	ra.assignments        = NULL;
+	block_info->processed = true;
+
+	/* permute values at end of predecessor blocks in case of phi-nodes */
+	int const n_preds = get_Block_n_cfgpreds(block);
+	if (n_preds > 1) {
+		for (int p = 0; p < n_preds; ++p) {
+			be_ra_add_phi_permutations(&ra, block, p);
+		}
+	}
+
+	/* a successor processed before (loop header) gets its phi operands now */
+	if (get_irn_n_edges_kind(block, EDGE_KIND_BLOCK) == 1) {
+		ir_edge_t const *const edge = get_irn_out_edge_first_kind(block, EDGE_KIND_BLOCK);
+		ir_node         *const succ = get_edge_src_irn(edge);
+		if (be_ra_get_block(&ra, succ)->processed)
+			be_ra_add_phi_permutations(&ra, succ, get_edge_src_pos(edge));
+	}
+}
+
+static void assign_registers(void)
+{
+	be_timer_push(T_RA_COLOR);
+	be_assure_live_sets(irg);
+	lv = be_get_irg_liveness(irg);
+	ir_reserve_resources(irg, IR_RESOURCE_IRN_LINK);
+	irg_walk_graph(irg, firm_clear_link, NULL, NULL);
+
+	for (size_t i = ARR_LEN(blocklist); i-- > 0;) {
+		assign_block(blocklist[i]);
+	}
+
+	ir_free_resources(irg, IR_RESOURCE_IRN_LINK);
+	obstack_free(&obst, NULL);
+	obstack_init(&obst);
+	be_timer_pop(T_RA_COLOR);
+}
+
+/**
+ * The linear scan register allocator for a whole procedure.
+ */
+static void be_linearscan(ir_graph *const new_irg, const regalloc_if_t *const regif)
+{
+	/* disable optimization callbacks as we cannot deal with same-input phis
+	 * getting optimized away. */
+	int const last_opt_state = get_optimize();
+	set_optimize(0);
+
+	irg = new_irg;
+	obstack_init(&obst);
+
+	be_spill_prepare_for_constraints(irg);
+	blocklist = be_get_cfgpostorder(irg);
+
+	arch_register_class_t const *const reg_classes
+		= ir_target.isa->register_classes;
+	for (int c = 0, n_cls = ir_target.isa->n_register_classes; c < n_cls; ++c) {
+		cls = &reg_classes[c];
+		if (cls->manual_ra)
+			continue;
+
+		stat_ev_ctx_push_str("regcls", cls->name);
+
+		n_regs         = cls->n_regs;
+		normal_regs    = rbitset_malloc(n_regs);
+		clobbered_regs = rbitset_malloc(n_regs);
+		has_clobbers   = false;
+		be_get_allocatable_regs(irg, cls, normal_regs);
+		ra = (be_ra_assign_env_t) {
+			.obst        = &obst,
+			.cls         = cls,
+			.n_regs      = n_regs,
+			.normal_regs = normal_regs,
+			.get_value   = get_ra_value,
+		};
+
+		spill(regif);
+
+		/* verify schedule and register pressure */
+		if (be_options.do_verify) {
+			be_timer_push(T_VERIFY);
+			bool check_schedule = be_verify_schedule(irg);
+			be_check_verify_result(check_schedule, irg);
+			bool check_pressure = be_verify_register_pressure(irg, cls);
+			be_check_verify_result(check_pressure, irg);
+			be_timer_pop(T_VERIFY);
+		}
+
+		assign_registers();
+
+		/* we constructed new Phis so liveness info is invalid now */
+		be_invalidate_live_sets(irg);
+		free(clobbered_regs);
+		free(normal_regs);
+
+		stat_ev_ctx_pop("regcls");
+	}
+
+	DEL_ARR_F(blocklist);
+	obstack_free(&obst, NULL);
+
+	set_optimize(last_opt_state);
+}
+
+BE_REGISTER_MODULE_CONSTRUCTOR(be_init_linearscan)
+void be_init_linearscan(void)
+{
+	be_register_allocator("linearscan", be_linearscan);
+	FIRM_DBG_REGISTER(dbg, "firm.be.linearscan");
+}
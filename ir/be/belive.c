@@ -18,6 +18,10 @@
 #include "irprintf.h"
 #include "irdump_t.h"
 #include "irnodeset.h"
+#include "irtools.h"
+#include "lc_opts.h"
+#include "lc_opts_enum.h"
+#include "util.h"
 
 #include "statev_t.h"
 #include "be_t.h"
@@ -30,6 +34,29 @@ DEBUG_ONLY(static firm_dbg_module_t *dbg = NULL;)
 
 #define LV_STD_SIZE             63
 
+/** Largest number of set elements of the bitset representation, graphs
+ * needing more use the arrays. */
+#define LV_MAX_BITSET_ELEMS     (16u << 20)
+
+static int  lv_repr  = be_lv_repr_bitsets;
+static bool lv_check = false;
+
+static const lc_opt_enum_int_items_t lv_repr_items[] = {
+	{ "arrays",  be_lv_repr_arrays  },
+	{ "bitsets", be_lv_repr_bitsets },
+	{ NULL,      0                  }
+};
+
+static lc_opt_enum_int_var_t lv_repr_var = {
+	&lv_repr, lv_repr_items
+};
+
+static const lc_opt_table_entry_t be_live_options[] = {
+	LC_OPT_ENT_ENUM_INT("repr",  "representation of the liveness sets", &lv_repr_var),
+	LC_OPT_ENT_BOOL    ("check", "compare the liveness sets with the liveness check", &lv_check),
+	LC_OPT_LAST
+};
+
 static unsigned _be_liveness_bsearch(be_lv_info_t const *const arr, ir_node const *const node)
 {
 	unsigned const n = arr->n_members;
@@ -126,6 +153,105 @@ static be_lv_info_node_t *be_lv_get_or_set(be_lv_t *li, ir_node *bl,
 	return res;
 }
 
+/**
+ * Grows a map indexed by node index to contain index @p idx. New entries are
+ * BE_LV_NONE.
+ */
+static unsigned *grow_map(unsigned *map, unsigned *size, unsigned idx)
+{
+	unsigned const old_size = *size;
+	unsigned const new_size = MAX(idx + 1, old_size + old_size / 2);
+	map = XREALLOC(map, unsigned, new_size);
+	memset(&map[old_size], 0xFF, (new_size - old_size) * sizeof(*map));
+	*size = new_size;
+	return map;
+}
+
+/**
+ * Reallocates the sets of the bitset representation.
+ */
+static void resize_bits(be_lv_t *lv, size_t n_elems, unsigned max_slots)
+{
+	size_t    const old_elems = lv->n_elems;
+	unsigned *const bits      = XMALLOCNZ(unsigned, (size_t)max_slots * 3 * n_elems);
+	for (size_t set = 0, n = (size_t)lv->n_slots * 3; set < n; ++set)
+		MEMCPY(&bits[set * n_elems], &lv->bits[set * old_elems], old_elems);
+	free(lv->bits);
+	lv->bits      = bits;
+	lv->n_elems   = n_elems;
+	lv->max_slots = max_slots;
+}
+
+static unsigned *get_sets(be_lv_t const *lv, unsigned slot)
+{
+	return &lv->bits[(size_t)slot * 3 * lv->n_elems];
+}
+
+static unsigned get_or_add_slot(be_lv_t *lv, ir_node const *block)
+{
+	unsigned const idx = get_irn_idx(block);
+	if (idx >= lv->n_block_slot)
+		lv->block_slot = grow_map(lv->block_slot, &lv->n_block_slot, idx);
+
+	unsigned slot = lv->block_slot[idx];
+	if (slot == BE_LV_NONE) {
+		if (lv->n_slots == lv->max_slots)
+			resize_bits(lv, lv->n_elems, MAX(16, lv->max_slots * 2));
+		slot = lv->n_slots++;
+		lv->block_slot[idx] = slot;
+	}
+	return slot;
+}
+
+static unsigned get_or_add_value_nr(be_lv_t *lv, ir_node *irn)
+{
+	unsigned const idx = get_irn_idx(irn);
+	if (idx >= lv->n_value_nr)
+		lv->value_nr = grow_map(lv->value_nr, &lv->n_value_nr, idx);
+
+	unsigned nr = lv->value_nr[idx];
+	if (nr == BE_LV_NONE) {
+		nr = ARR_LEN(lv->values);
+		ARR_APP1(ir_node*, lv->values, irn);
+		if (nr >= lv->n_elems * BITS_PER_ELEM)
+			resize_bits(lv, MAX(4, lv->n_elems * 2), lv->max_slots);
+		lv->value_nr[idx] = nr;
+	}
+	return nr;
+}
+
+/**
+ * Adds the liveness states @p state of @p irn at @p block.
+ *
+ * @return the states before
+ */
+static be_lv_state_t lv_add_state(be_lv_t *lv, ir_node *block, ir_node *irn,
+                                  be_lv_state_t state)
+{
+	if (lv->repr == be_lv_repr_arrays) {
+		be_lv_info_node_t *const n      = be_lv_get_or_set(lv, block, irn);
+		be_lv_state_t      const before = n->flags;
+		n->flags |= state;
+		return before;
+	}
+
+	assert(get_irn_mode(irn) != mode_T);
+	unsigned const slot = get_or_add_slot(lv, block);
+	unsigned const nr   = get_or_add_value_nr(lv, irn);
+
+	unsigned     *const sets   = get_sets(lv, slot);
+	be_lv_state_t const before = be_lv_bits_get(lv, sets, nr);
+	size_t        const elem   = nr / BITS_PER_ELEM;
+	unsigned      const mask   = 1u << (nr % BITS_PER_ELEM);
+	if (state & be_lv_state_in)
+		sets[elem] |= mask;
+	if (state & be_lv_state_end)
+		sets[lv->n_elems + elem] |= mask;
+	if (state & be_lv_state_out)
+		sets[2 * lv->n_elems + elem] |= mask;
+	return before;
+}
+
 typedef struct lv_remove_walker_t {
 	be_lv_t       *lv;
 	ir_node const *irn;
@@ -136,8 +262,20 @@ typedef struct lv_remove_walker_t {
  */
 static void lv_remove_irn_walker(ir_node *const bl, void *const data)
 {
-	lv_remove_walker_t *const w        = (lv_remove_walker_t*)data;
-	be_lv_info_t       *const irn_live = ir_nodehashmap_get(be_lv_info_t, &w->lv->map, bl);
+	lv_remove_walker_t *const w = (lv_remove_walker_t*)data;
+	if (w->lv->repr == be_lv_repr_bitsets) {
+		unsigned *const sets = (unsigned*)be_lv_get_sets(w->lv, bl);
+		if (sets == NULL)
+			return;
+		unsigned const nr      = be_lv_get_value_nr(w->lv, w->irn);
+		size_t   const n_elems = w->lv->n_elems;
+		rbitset_clear(sets, nr);
+		rbitset_clear(&sets[n_elems], nr);
+		rbitset_clear(&sets[2 * n_elems], nr);
+		return;
+	}
+
+	be_lv_info_t *const irn_live = ir_nodehashmap_get(be_lv_info_t, &w->lv->map, bl);
 	if (irn_live == NULL)
 		return;
 
@@ -174,13 +312,15 @@ static struct {
  */
 static void live_end_at_block(ir_node *const block, be_lv_state_t const state)
 {
-	be_lv_info_node_t *const n      = be_lv_get_or_set(re.lv, block, re.def);
-	be_lv_state_t      const before = n->flags;
-
 	assert(state == be_lv_state_end || state == (be_lv_state_end | be_lv_state_out));
 	DBG((dbg, LEVEL_2, "marking %+F live %s at %+F\n", re.def,
 	     state & be_lv_state_out ? "end+out" : "end", block));
-	n->flags |= state;
+
+	/* A value is live in at every block it is live at, except for the block
+	 * of its definition. */
+	bool          const is_def_block = re.def_block == block;
+	be_lv_state_t const add          = is_def_block ? state : state | be_lv_state_in;
+	be_lv_state_t const before       = lv_add_state(re.lv, block, re.def, add);
 
 	/* There is no need to recurse further, if we where here before (i.e., any
 	 * live state bits were set before). */
@@ -188,11 +328,10 @@ static void live_end_at_block(ir_node *const block, be_lv_state_t const state)
 		return;
 
 	/* Stop going up further, if this is the block of the definition. */
-	if (re.def_block == block)
+	if (is_def_block)
 		return;
 
 	DBG((dbg, LEVEL_2, "marking %+F live in at %+F\n", re.def, block));
-	n->flags |= be_lv_state_in;
 
 	for (unsigned i = get_Block_n_cfgpreds(block); i-- > 0;) {
 		ir_node *const pred_block = get_Block_cfgpred_block(block, i);
@@ -235,9 +374,8 @@ static void liveness_for_node(ir_node *irn)
 		} else if (def_block != use_block) {
 			/* Else, the value is live in at this block. Mark it and call live
 			 * out on the predecessors. */
-			be_lv_info_node_t *const n = be_lv_get_or_set(re.lv, use_block, irn);
 			DBG((dbg, LEVEL_2, "marking %+F live in at %+F\n", irn, use_block));
-			n->flags |= be_lv_state_in;
+			lv_add_state(re.lv, use_block, irn, be_lv_state_in);
 
 			for (unsigned i = get_Block_n_cfgpreds(use_block); i-- > 0; ) {
 				ir_node *pred_block = get_Block_cfgpred_block(use_block, i);
@@ -258,14 +396,197 @@ static void collect_liveness_nodes(ir_node *irn, void *data)
 		nodes[get_irn_idx(irn)] = irn;
 }
 
+/**
+ * Walker, collect all blocks in post order.
+ */
+static void collect_block(ir_node *block, void *data)
+{
+	ir_node ***const blocks = (ir_node***)data;
+	ARR_APP1(ir_node*, *blocks, block);
+}
+
+/**
+ * Returns whether @p irn is used by a Phi or in another block than its own,
+ * i.e. whether it can be live at any block border.
+ */
+static bool is_global_value(ir_node const *irn)
+{
+	ir_node const *const block = get_nodes_block(irn);
+	foreach_out_edge(irn, edge) {
+		ir_node const *const use = get_edge_src_irn(edge);
+		if (!is_liveness_node(use))
+			continue;
+		if (is_Phi(use) || get_nodes_block(use) != block)
+			return true;
+	}
+	return false;
+}
+
+static unsigned get_slot(be_lv_t const *lv, ir_node const *block)
+{
+	return lv->block_slot[get_irn_idx(block)];
+}
+
+/**
+ * dst |= src
+ *
+ * @return true if dst changed
+ */
+static bool or_changed(unsigned *dst, unsigned const *src, size_t n_elems)
+{
+	unsigned diff = 0;
+	for (size_t i = 0; i < n_elems; ++i) {
+		diff   |= src[i] & ~dst[i];
+		dst[i] |= src[i];
+	}
+	return diff != 0;
+}
+
+/**
+ * Computes the bitset representation by an iterative backward dataflow
+ * analysis over all blocks, which works on whole words of the sets instead
+ * of following the uses of each value separately.
+ *
+ * @return false if the sets would be too large
+ */
+static bool compute_sets_bitsets(be_lv_t *lv, ir_node *const *nodes,
+                                 unsigned n)
+{
+	ir_graph *const irg    = lv->irg;
+	ir_node **      blocks = NEW_ARR_F(ir_node*, 0);
+	irg_block_walk_graph(irg, NULL, collect_block, &blocks);
+	unsigned const n_blocks = ARR_LEN(blocks);
+
+	/* Only values live across a block border get a number, local values
+	 * would only enlarge the sets. */
+	unsigned n_values = 0;
+	for (unsigned i = 0; i < n; ++i) {
+		if (nodes[i] != NULL && is_global_value(nodes[i]))
+			++n_values;
+	}
+	size_t const n_elems = MAX(1, BITSET_SIZE_ELEMS(n_values));
+	if ((size_t)n_blocks * 3 * n_elems > LV_MAX_BITSET_ELEMS) {
+		DEL_ARR_F(blocks);
+		return false;
+	}
+
+	lv->values       = NEW_ARR_F(ir_node*, 0);
+	lv->n_block_slot = get_irg_last_idx(irg);
+	lv->block_slot   = XMALLOCN(unsigned, lv->n_block_slot);
+	lv->n_value_nr   = lv->n_block_slot;
+	lv->value_nr     = XMALLOCN(unsigned, lv->n_value_nr);
+	memset(lv->block_slot, 0xFF, lv->n_block_slot * sizeof(*lv->block_slot));
+	memset(lv->value_nr,   0xFF, lv->n_value_nr   * sizeof(*lv->value_nr));
+	resize_bits(lv, n_elems, MAX(16, n_blocks));
+	for (unsigned b = 0; b < n_blocks; ++b)
+		get_or_add_slot(lv, blocks[b]);
+
+	/* Number the values and count the definitions per block. */
+	unsigned *const kill_begin = XMALLOCNZ(unsigned, n_blocks + 1);
+	for (unsigned i = 0; i < n; ++i) {
+		ir_node *const irn = nodes[i];
+		if (irn == NULL || !is_global_value(irn))
+			continue;
+		get_or_add_value_nr(lv, irn);
+		++kill_begin[get_slot(lv, get_nodes_block(irn)) + 1];
+	}
+
+	/* The successor lists in compressed form. */
+	unsigned *const succ_begin = XMALLOCNZ(unsigned, n_blocks + 1);
+	for (unsigned b = 0; b < n_blocks; ++b) {
+		ir_node *const block = blocks[b];
+		for (unsigned i = get_Block_n_cfgpreds(block); i-- > 0;) {
+			ir_node *const pred = get_Block_cfgpred_block(block, i);
+			if (pred != NULL)
+				++succ_begin[get_slot(lv, pred) + 1];
+		}
+	}
+	for (unsigned s = 0; s < n_blocks; ++s) {
+		succ_begin[s + 1] += succ_begin[s];
+		kill_begin[s + 1] += kill_begin[s];
+	}
+	unsigned *const succs    = XMALLOCN(unsigned, succ_begin[n_blocks]);
+	unsigned *const succ_pos = XMALLOCN(unsigned, n_blocks);
+	MEMCPY(succ_pos, succ_begin, n_blocks);
+	for (unsigned b = 0; b < n_blocks; ++b) {
+		ir_node *const block = blocks[b];
+		for (unsigned i = get_Block_n_cfgpreds(block); i-- > 0;) {
+			ir_node *const pred = get_Block_cfgpred_block(block, i);
+			if (pred != NULL)
+				succs[succ_pos[get_slot(lv, pred)]++] = b;
+		}
+	}
+
+	/* The numbers of the values defined in each block, ascending. */
+	unsigned *const kills    = XMALLOCN(unsigned, kill_begin[n_blocks]);
+	unsigned *const kill_pos = succ_pos;
+	MEMCPY(kill_pos, kill_begin, n_blocks);
+	for (unsigned nr = 0, n_nrs = ARR_LEN(lv->values); nr < n_nrs; ++nr) {
+		ir_node *const block = get_nodes_block(lv->values[nr]);
+		kills[kill_pos[get_slot(lv, block)]++] = nr;
+	}
+
+	/* The initial sets: the uses. */
+	for (unsigned nr = 0, n_nrs = ARR_LEN(lv->values); nr < n_nrs; ++nr) {
+		ir_node *const irn       = lv->values[nr];
+		ir_node *const def_block = get_nodes_block(irn);
+		foreach_out_edge(irn, edge) {
+			ir_node *const use = get_edge_src_irn(edge);
+			if (!is_liveness_node(use))
+				continue;
+			ir_node *const use_block = get_nodes_block(use);
+			if (is_Phi(use)) {
+				ir_node *const pred = get_Block_cfgpred_block(use_block, edge->pos);
+				if (pred != NULL)
+					rbitset_set(&get_sets(lv, get_slot(lv, pred))[n_elems], nr);
+			} else if (use_block != def_block) {
+				rbitset_set(get_sets(lv, get_slot(lv, use_block)), nr);
+			}
+		}
+	}
+
+	/* Iterate until nothing changes, visiting successors before their
+	 * predecessors (blocks are in post order):
+	 *   out = union of in of the successors
+	 *   end = end | out
+	 *   in  = in | (end - defined here) */
+	unsigned *const live = XMALLOCN(unsigned, n_elems);
+	bool changed;
+	do {
+		changed = false;
+		for (unsigned b = n_blocks; b-- > 0;) {
+			unsigned *const in  = get_sets(lv, b);
+			unsigned *const end = &in[n_elems];
+			unsigned *const out = &in[2 * n_elems];
+			for (unsigned s = succ_begin[b]; s < succ_begin[b + 1]; ++s)
+				or_changed(out, get_sets(lv, succs[s]), n_elems);
+			or_changed(end, out, n_elems);
+
+			MEMCPY(live, end, n_elems);
+			for (unsigned k = kill_begin[b]; k < kill_begin[b + 1]; ++k)
+				rbitset_clear(live, kills[k]);
+			changed |= or_changed(in, live, n_elems);
+		}
+	} while (changed);
+
+	free(live);
+	free(kills);
+	free(succ_pos);
+	free(succs);
+	free(succ_begin);
+	free(kill_begin);
+	DEL_ARR_F(blocks);
+	return true;
+}
+
+static void be_live_chk_compare(be_lv_t *lv, lv_chk_t *lvc);
+
 void be_liveness_compute_sets(be_lv_t *lv)
 {
 	if (lv->sets_valid)
 		return;
 
 	be_timer_push(T_LIVE);
-	ir_nodehashmap_init(&lv->map);
-	obstack_init(&lv->obst);
 
 	ir_graph *irg = lv->irg;
 	unsigned n = get_irg_last_idx(irg);
@@ -278,14 +599,25 @@ void be_liveness_compute_sets(be_lv_t *lv)
 
 	re.lv = lv;
 
-	for (unsigned i = 0; i < n; ++i) {
-		if (nodes[i] != NULL)
-			liveness_for_node(nodes[i]);
+	lv->repr = (be_lv_repr_t)lv_repr;
+	if (lv->repr != be_lv_repr_bitsets || !compute_sets_bitsets(lv, nodes, n)) {
+		lv->repr = be_lv_repr_arrays;
+		ir_nodehashmap_init(&lv->map);
+		obstack_init(&lv->obst);
+		for (unsigned i = 0; i < n; ++i) {
+			if (nodes[i] != NULL)
+				liveness_for_node(nodes[i]);
+		}
 	}
 
 	DEL_ARR_F(nodes);
 	lv->sets_valid = true;
 	be_timer_pop(T_LIVE);
+
+	if (lv_check) {
+		be_liveness_compute_chk(lv);
+		be_live_chk_compare(lv, lv->lvc);
+	}
 }
 
 void be_liveness_compute_chk(be_lv_t *lv)
@@ -299,8 +631,24 @@ void be_liveness_invalidate_sets(be_lv_t *lv)
 {
 	if (!lv->sets_valid)
 		return;
-	obstack_free(&lv->obst, NULL);
-	ir_nodehashmap_destroy(&lv->map);
+	if (lv->repr == be_lv_repr_bitsets) {
+		free(lv->bits);
+		free(lv->block_slot);
+		free(lv->value_nr);
+		DEL_ARR_F(lv->values);
+		lv->bits         = NULL;
+		lv->n_elems      = 0;
+		lv->n_slots      = 0;
+		lv->max_slots    = 0;
+		lv->block_slot   = NULL;
+		lv->n_block_slot = 0;
+		lv->value_nr     = NULL;
+		lv->n_value_nr   = 0;
+		lv->values       = NULL;
+	} else {
+		obstack_free(&lv->obst, NULL);
+		ir_nodehashmap_destroy(&lv->map);
+	}
 	lv->sets_valid = false;
 }
 
@@ -331,6 +679,8 @@ void be_liveness_free(be_lv_t *lv)
 void be_liveness_remove(be_lv_t *lv, const ir_node *irn)
 {
 	assert(lv->sets_valid);
+	if (lv->repr == be_lv_repr_bitsets && be_lv_get_value_nr(lv, irn) == BE_LV_NONE)
+		return;
 
 	/* Removes a single irn from the liveness information.
 	 * Since an irn can only be live at blocks dominated by the block of its
@@ -533,7 +883,7 @@ static void be_live_chk_compare(be_lv_t *lv, lv_chk_t *lvc)
 	stat_ev_ctx_push("be_lv_chk_compare");
 	for (unsigned j = 0; nodes[j] != NULL; ++j) {
 		const ir_node *irn = nodes[j];
-		if (is_Block(irn))
+		if (!is_liveness_node(irn))
 			continue;
 
 		for (unsigned i = 0; blocks[i] != NULL; ++i) {
@@ -564,6 +914,9 @@ static void be_live_chk_compare(be_lv_t *lv, lv_chk_t *lvc)
 BE_REGISTER_MODULE_CONSTRUCTOR(be_init_live)
 void be_init_live(void)
 {
-	(void)be_live_chk_compare;
+	lc_opt_entry_t *be_grp = lc_opt_get_grp(firm_opt_get_root(), "be");
+	lc_opt_entry_t *lv_grp = lc_opt_get_grp(be_grp, "liveness");
+	lc_opt_add_table(lv_grp, be_live_options);
+
 	FIRM_DBG_REGISTER(dbg, "firm.be.liveness");
 }
@@ -13,6 +13,7 @@
 #define FIRM_BE_BELIVE_H
 
 #include "be_types.h"
+#include "bitfiddle.h"
 #include "irnodeset.h"
 #include "irnodehashmap.h"
 #include "irlivechk.h"
@@ -26,6 +27,16 @@ typedef enum be_lv_state_t {
 } be_lv_state_t;
 ENUM_BITSET(be_lv_state_t)
 
+/**
+ * Representation of the per block liveness sets.
+ */
+typedef enum be_lv_repr_t {
+	/** sorted arrays of live nodes with their states */
+	be_lv_repr_arrays,
+	/** bitsets over the values live anywhere, one per block and state */
+	be_lv_repr_bitsets,
+} be_lv_repr_t;
+
 /**
  * Compute the inter block liveness for a graph.
  * @param irg The graph.
@@ -133,8 +144,22 @@ struct be_lv_t {
 	ir_nodehashmap_t map;
 	struct obstack   obst;
 	bool             sets_valid;
+	be_lv_repr_t     repr;
 	ir_graph        *irg;
 	lv_chk_t        *lvc;
+
+	/* The bitset representation: Every value live somewhere gets a number.
+	 * The live in, end and out sets of a block are stored one after another,
+	 * each with n_elems elements. */
+	unsigned        *bits;
+	size_t           n_elems;      /**< elements of each set */
+	unsigned         n_slots;      /**< number of blocks with sets */
+	unsigned         max_slots;    /**< blocks with allocated sets */
+	unsigned        *block_slot;   /**< block slots indexed by node index */
+	unsigned         n_block_slot;
+	unsigned        *value_nr;     /**< value numbers indexed by node index */
+	unsigned         n_value_nr;
+	ir_node        **values;       /**< the values by number */
 };
 
 typedef struct be_lv_info_node_t be_lv_info_node_t;
@@ -152,14 +177,67 @@ struct be_lv_info_t {
 be_lv_info_node_t *be_lv_get(const be_lv_t *li, const ir_node *block,
                              const ir_node *irn);
 
+/** Marks the absence of a block slot or value number. */
+#define BE_LV_NONE (~0u)
+
+/**
+ * Returns the liveness sets of a block in the bitset representation or NULL
+ * if it has none.
+ */
+static inline unsigned const *be_lv_get_sets(be_lv_t const *const lv,
+                                             ir_node const *const block)
+{
+	unsigned const idx = get_irn_idx(block);
+	if (idx >= lv->n_block_slot || lv->block_slot[idx] == BE_LV_NONE)
+		return NULL;
+	return &lv->bits[(size_t)lv->block_slot[idx] * 3 * lv->n_elems];
+}
+
+/**
+ * Returns the number of a value in the bitset representation or BE_LV_NONE
+ * if it is not live anywhere.
+ */
+static inline unsigned be_lv_get_value_nr(be_lv_t const *const lv,
+                                          ir_node const *const irn)
+{
+	unsigned const idx = get_irn_idx(irn);
+	return idx < lv->n_value_nr ? lv->value_nr[idx] : BE_LV_NONE;
+}
+
+/**
+ * Returns the states of the value with number @p nr in the sets @p sets.
+ */
+static inline be_lv_state_t be_lv_bits_get(be_lv_t const *const lv,
+                                           unsigned const *const sets,
+                                           unsigned const nr)
+{
+	size_t        const elem  = nr / BITS_PER_ELEM;
+	unsigned      const mask  = 1u << (nr % BITS_PER_ELEM);
+	be_lv_state_t       state = be_lv_state_none;
+	if (sets[elem] & mask)
+		state |= be_lv_state_in;
+	if (sets[lv->n_elems + elem] & mask)
+		state |= be_lv_state_end;
+	if (sets[2 * lv->n_elems + elem] & mask)
+		state |= be_lv_state_out;
+	return state;
+}
+
 static inline be_lv_state_t be_get_live_state(be_lv_t const *const li, ir_node const *const block, ir_node const *const irn)
 {
-	if (li->sets_valid) {
-		be_lv_info_node_t *info = be_lv_get(li, block, irn);
-		return info ? info->flags : be_lv_state_none;
-	} else {
+	if (!li->sets_valid)
 		return lv_chk_bl_xxx(li->lvc, block, irn);
+
+	if (li->repr == be_lv_repr_bitsets) {
+		unsigned const *const sets = be_lv_get_sets(li, block);
+		unsigned        const nr   = be_lv_get_value_nr(li, irn);
+		if (sets == NULL || nr == BE_LV_NONE)
+			return be_lv_state_none;
+		return be_lv_bits_get(li, sets, nr);
 	}
+
+	be_lv_info_node_t *info = be_lv_get(li, block, irn);
+	return info ? info->flags : be_lv_state_none;
 }
 
 /**
@@ -200,8 +278,10 @@ static inline bool be_is_live_end(const be_lv_t *li, const ir_node *block,
 
 typedef struct lv_iterator_t
 {
-	be_lv_info_t *info;
-	size_t        i;
+	be_lv_info_t   *info;
+	be_lv_t const  *lv;   /**< the liveness for the bitset representation */
+	unsigned const *sets; /**< the block's sets in the bitset representation */
+	size_t          i;
 } lv_iterator_t;
 
 static inline lv_iterator_t be_lv_iteration_begin(const be_lv_t *lv,
@@ -209,14 +289,58 @@ static inline lv_iterator_t be_lv_iteration_begin(const be_lv_t *lv,
 {
 	assert(lv->sets_valid);
 	lv_iterator_t res;
-	res.info  = ir_nodehashmap_get(be_lv_info_t, &lv->map, block);
-	res.i     = res.info ? res.info->n_members : 0;
+	res.lv = lv;
+	if (lv->repr == be_lv_repr_bitsets) {
+		res.info = NULL;
+		res.sets = be_lv_get_sets(lv, block);
+		res.i    = res.sets ? ARR_LEN(lv->values) : 0;
+	} else {
+		res.info = ir_nodehashmap_get(be_lv_info_t, &lv->map, block);
+		res.sets = NULL;
+		res.i    = res.info ? res.info->n_members : 0;
+	}
 	return res;
 }
 
+/**
+ * Returns the live value with the next smaller number having one of the
+ * states @p flags in the bitset representation. Whole set elements are
+ * skipped at once.
+ */
+static inline ir_node *be_lv_bits_next(lv_iterator_t *iterator,
+                                       be_lv_state_t flags)
+{
+	be_lv_t  const *const lv   = iterator->lv;
+	unsigned const *const sets = iterator->sets;
+	size_t                pos  = iterator->i;
+	while (pos != 0) {
+		size_t   const elem = (pos - 1) / BITS_PER_ELEM;
+		unsigned       bits = 0;
+		if (flags & be_lv_state_in)
+			bits |= sets[elem];
+		if (flags & be_lv_state_end)
+			bits |= sets[lv->n_elems + elem];
+		if (flags & be_lv_state_out)
+			bits |= sets[2 * lv->n_elems + elem];
+		bits &= ~0u >> (BITS_PER_ELEM - 1 - (pos - 1) % BITS_PER_ELEM);
+		if (bits != 0) {
+			size_t const nr = elem * BITS_PER_ELEM + log2_floor(bits);
+			iterator->i = nr;
+			assert(get_irn_mode(lv->values[nr]) != mode_T);
+			return lv->values[nr];
+		}
+		pos = elem * BITS_PER_ELEM;
+	}
+	iterator->i = 0;
+	return NULL;
+}
+
 static inline ir_node *be_lv_iteration_next(lv_iterator_t *iterator,
                                             be_lv_state_t flags)
 {
+	if (iterator->sets != NULL)
+		return be_lv_bits_next(iterator, flags);
+
 	while (iterator->i != 0) {
 		be_lv_info_node_t const *const node = &iterator->info->nodes[--iterator->i];
 		assert(get_irn_mode(node->node) != mode_T);
@@ -230,6 +354,15 @@ static inline ir_node *be_lv_iteration_cls_next(lv_iterator_t *iterator,
                                                 be_lv_state_t flags,
                                                 const arch_register_class_t *cls)
 {
+	if (iterator->sets != NULL) {
+		ir_node *node;
+		while ((node = be_lv_bits_next(iterator, flags)) != NULL) {
+			if (arch_irn_consider_in_reg_alloc(cls, node))
+				return node;
+		}
+		return NULL;
+	}
+
 	while (iterator->i != 0) {
 		be_lv_info_node_t const *const lnode = &iterator->info->nodes[--iterator->i];
 		assert(get_irn_mode(lnode->node) != mode_T);
@@ -14,9 +14,12 @@
 #include "bechordal_t.h"
 #include "bediagnostic.h"
 #include "beemitter.h"
+#include "befuncorder.h"
 #include "begnuas.h"
 #include "beifg.h"
 #include "beirg.h"
+#include "bejit.h"
+#include "bejitcache.h"
 #include "belistsched.h"
 #include "belive.h"
 #include "belower.h"
@@ -46,6 +49,8 @@
 #include "lc_opts.h"
 #include "lc_opts_enum.h"
 #include "obst.h"
+#include "panic.h"
+#include "platform_t.h"
 #include "statev.h"
 #include "target_t.h"
 #include "util.h"
@@ -53,6 +58,8 @@
 
 static struct obstack obst;
 static be_main_env_t  env;
+/** Whether be_begin() started an assembly file. */
+static bool           emit_assembly;
 
 /* options visible for anyone */
 be_options_t be_options = {
@@ -294,6 +301,7 @@ static ir_graph *be_prepare_profile(const char *const cup_name)
 			be_warningf(NULL, "could not read profile data '%s'", prof_filename);
 		} else {
 			ir_create_execfreqs_from_profile();
+			be_order_functions();
 			ir_profile_free();
 			have_profile = true;
 		}
@@ -382,7 +390,13 @@ void be_begin(FILE *file_handle, const char *cup_name)
 	if (prof_init_irg != NULL)
 		initialize_birg(&birgs[num_birgs++], prof_init_irg, &env);
 
-	be_gas_begin_compilation_unit(&env);
+	/* without output file the target writes an object file */
+	emit_assembly = file_handle != NULL;
+	if (emit_assembly) {
+		be_gas_begin_compilation_unit(&env);
+	} else if (get_irp_n_asms() > 0) {
+		panic("global assembler code not supported in object files");
+	}
 }
 
 void firm_be_finish(void)
@@ -457,8 +471,6 @@ void be_lower_for_target(void)
 	}
 }
 
-static int cse_setting;
-
 bool be_step_first(ir_graph *irg)
 {
 	ir_entity *const entity = get_irg_entity(irg);
@@ -471,7 +483,8 @@ bool be_step_first(ir_graph *irg)
 		stat_ev_ull("bemain_insns_start", be_count_insns(irg));
 		stat_ev_ull("bemain_blocks_start", be_count_blocks(irg));
 	}
-	cse_setting = get_opt_cse();
+	be_irg_t *const birg = be_birg_from_irg(irg);
+	birg->saved_cse = get_opt_cse();
 	return true;
 }
 
@@ -543,15 +556,18 @@ void be_step_last(ir_graph *irg)
 		}
 	}
 
+	be_irg_t *const birg = be_birg_from_irg(irg);
+	set_opt_cse(birg->saved_cse);
 	be_free_birg(irg);
 	stat_ev_ctx_pop("bemain_irg");
-
-	set_opt_cse(cse_setting);
 }
 
 void be_finish(void)
 {
-	be_gas_end_compilation_unit(&env);
+	if (emit_assembly)
+		be_gas_end_compilation_unit(&env);
+	/* write the remaining output before the timing report */
+	be_emit_exit();
 
 	if (be_options.timing) {
 		ir_timer_stop(bemain_timer);
@@ -568,7 +584,6 @@ void be_finish(void)
 		stat_ev_ctx_pop("bemain_compilation_unit");
 	}
 
-	be_emit_exit();
 	be_info_free();
 
 	pmap_destroy(env.ent_trampoline_map);
@@ -583,24 +598,50 @@ void be_main(FILE *file_handle, const char *cup_name)
 	ir_target.isa->generate_code(file_handle, cup_name);
 }
 
+int be_main_object(FILE *const output, const char *const cup_name)
+{
+	if (ir_target.isa->generate_object == NULL
+	 || ir_platform.object_format != OBJECT_FORMAT_ELF)
+		return false;
+	ir_target.isa->generate_object(output, cup_name);
+	return true;
+}
+
 ir_jit_function_t *be_jit_compile(ir_jit_segment_t *const segment,
                                   ir_graph *const irg)
 {
 	if (ir_target.isa->jit_compile == NULL)
 		return NULL;
 
-	obstack_init(&obst);
-
 	ir_entity *entity = get_irg_entity(irg);
 	if (get_entity_linkage(entity) & IR_LINKAGE_NO_CODEGEN)
 		return NULL;
+
+	/* The fingerprint is taken before the backend modifies the graph. */
+	bool     const cached      = be_jit_get_cache_dir(segment) != NULL;
+	uint64_t const fingerprint = cached ? be_jit_fingerprint(irg) : 0;
+	if (cached) {
+		ir_jit_function_t *const res = be_jit_cache_load(segment, fingerprint);
+		if (res != NULL) {
+			be_jit_set_function_entity(res, entity);
+			return res;
+		}
+	}
+
+	obstack_init(&obst);
 	be_irg_t *const birg = OALLOCZ(&obst, be_irg_t);
 	initialize_birg(birg, irg, &env);
 	if (ir_target.isa->handle_intrinsics)
 		ir_target.isa->handle_intrinsics(irg);
 	be_dump(DUMP_INITIAL, irg, "prepared");
 
-	return ir_target.isa->jit_compile(segment, irg);
+	ir_jit_function_t *const res = ir_target.isa->jit_compile(segment, irg);
+	if (res != NULL) {
+		be_jit_set_function_entity(res, entity);
+		if (cached)
+			be_jit_cache_store(res, fingerprint);
+	}
+	return res;
 }
 
 void be_emit_function(char *const buffer, ir_jit_function_t *const function)
@@ -39,6 +39,8 @@ void be_init_copynone(void);
 void be_init_copyopt(void);
 void be_init_daemelspill(void);
 void be_init_dwarf(void);
+void be_init_funcorder(void);
+void be_init_linearscan(void);
 void be_init_listsched(void);
 void be_init_live(void);
 void be_init_loopana(void);
@@ -47,8 +49,10 @@ void be_init_pbqp_coloring(void);
 void be_init_peephole(void);
 void be_init_pref_alloc(void);
 void be_init_ra(void);
+void be_init_raassign(void);
 void be_init_sched(void);
 void be_init_sched_normal(void);
+void be_init_sched_latency(void);
 void be_init_sched_rand(void);
 void be_init_sched_trivial(void);
 void be_init_spill(void);
@@ -77,10 +81,12 @@ void be_init_modules(void)
 	be_init_chordal_common();
 	be_init_copyopt();
 	be_init_dwarf();
+	be_init_funcorder();
 	be_init_live();
 	be_init_loopana();
 	be_init_peephole();
 	be_init_ra();
+	be_init_raassign();
 	be_init_sched();
 	be_init_spill();
 	be_init_spilloptions();
@@ -99,11 +105,13 @@ void be_init_modules(void)
 
 	be_init_listsched();
 	be_init_sched_normal();
+	be_init_sched_latency();
 	be_init_sched_rand();
 	be_init_sched_trivial();
 
 	be_init_chordal_main();
 	be_init_pref_alloc();
+	be_init_linearscan();
 
 	be_init_chordal();
 	be_init_pbqp_coloring();
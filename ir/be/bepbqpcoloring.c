@@ -60,6 +60,7 @@
 
 static bool use_exec_freq     = true;
 static bool use_late_decision = false;
+static int  num_threads       = 1;
 
 typedef struct be_pbqp_alloc_env_t {
 	pbqp_t                      *pbqp_inst;         /**< PBQP instance for register allocation */
@@ -83,6 +84,7 @@ typedef struct be_pbqp_alloc_env_t {
 static const lc_opt_table_entry_t options[] = {
 	LC_OPT_ENT_BOOL("exec_freq", "use exec_freq",  &use_exec_freq),
 	LC_OPT_ENT_BOOL("late_decision", "use late decision for register allocation",  &use_late_decision),
+	LC_OPT_ENT_INT ("threads", "threads solving independent parts of the PBQP",  &num_threads),
 	LC_OPT_LAST
 };
 
@@ -564,6 +566,7 @@ static void be_pbqp_coloring(be_chordal_env_t *env)
 	pbqp_alloc_env.ife_edge_num     = XMALLOCNZ(unsigned, get_irg_last_idx(irg));
 	pbqp_alloc_env.env              = env;
 	deq_init(&pbqp_alloc_env.rpeo);
+	set_num_threads(pbqp_alloc_env.pbqp_inst, num_threads > 0 ? (unsigned)num_threads : 1);
 
 	unsigned const colors_n = cls->n_regs;
 	/* create costs matrix template for interference edges */
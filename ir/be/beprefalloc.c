@@ -20,7 +20,7 @@
  *    add copies and split live-ranges.
  *
  * TODO:
- *  - make use of free registers in the permute_values code
+ *  - make use of free registers in the be_ra_permute_values code
  */
 #include "be.h"
 #include "bechordal_t.h"
@@ -29,6 +29,7 @@
 #include "bemodule.h"
 #include "benode.h"
 #include "bera.h"
+#include "beraassign.h"
 #include "besched.h"
 #include "bespill.h"
 #include "bespillutil.h"
@@ -79,19 +80,17 @@ static int                         *congruence_classes;
 static ir_node                    **block_order;
 static size_t                       n_block_order;
 
-/** currently active assignments (while processing a basic block)
- * maps registers to values(their current copies) */
-static ir_node **assignments;
+/** the assignment state of the current register class */
+static be_ra_assign_env_t ra;
 
 /**
  * allocation information: last_uses, register preferences
  * the information is per firm-node.
  */
 struct allocation_info_t {
-	unsigned  last_uses[2];   /**< bitset indicating last uses (input pos) */
-	ir_node  *current_value;  /**< copy of the value that should be used */
-	ir_node  *original_value; /**< for copies point to original value */
-	float     prefs[];        /**< register preferences */
+	be_ra_value_t value;        /**< copies of the value, first member */
+	unsigned      last_uses[2]; /**< bitset indicating last uses (input pos) */
+	float         prefs[];      /**< register preferences */
 };
 typedef struct allocation_info_t allocation_info_t;
 
@@ -102,13 +101,6 @@ struct reg_pref_t {
 };
 typedef struct reg_pref_t reg_pref_t;
 
-/** per basic-block information */
-struct block_info_t {
-	bool     processed;       /**< indicate whether block is processed */
-	ir_node *assignments[];   /**< register assignments at end of block */
-};
-typedef struct block_info_t block_info_t;
-
 /**
  * Get the allocation info for a node.
  * The info is allocated on the first visit of a node.
@@ -118,62 +110,29 @@ static allocation_info_t *get_allocation_info(ir_node *node)
 	allocation_info_t *info = (allocation_info_t*)get_irn_link(node);
 	if (info == NULL) {
 		info = OALLOCFZ(&obst, allocation_info_t, prefs, n_regs);
-		info->current_value  = node;
-		info->original_value = node;
+		info->value.current_value  = node;
+		info->value.original_value = node;
 		set_irn_link(node, info);
 	}
 
 	return info;
 }
 
-static allocation_info_t *try_get_allocation_info(const ir_node *node)
+static be_ra_value_t *get_ra_value(ir_node *node)
 {
-	return (allocation_info_t*) get_irn_link(node);
-}
-
-/**
- * Get allocation information for a basic block
- */
-static block_info_t *get_block_info(ir_node *block)
-{
-	block_info_t *info = (block_info_t*)get_irn_link(block);
-
-	assert(is_Block(block));
-	if (info == NULL) {
-		info = OALLOCFZ(&obst, block_info_t, assignments, n_regs);
-		set_irn_link(block, info);
-	}
-
-	return info;
+	return &get_allocation_info(node)->value;
 }
 
 /**
- * Link the allocation info of a node to a copy.
- * Afterwards, both nodes uses the same allocation info.
- * Copy must not have an allocation info assigned yet.
+ * Copy the register preferences of a value to a copy.
  *
- * @param copy   the node that gets the allocation info assigned
+ * @param copy   the copy
  * @param value  the original node
  */
-static void mark_as_copy_of(ir_node *copy, ir_node *value)
+static void mark_copy(ir_node *copy, ir_node *value)
 {
 	allocation_info_t *info      = get_allocation_info(value);
 	allocation_info_t *copy_info = get_allocation_info(copy);
-
-	/* find original value */
-	ir_node *original = info->original_value;
-	if (original != value) {
-		info = get_allocation_info(original);
-	}
-
-	assert(info->original_value == original);
-	info->current_value = copy;
-
-	/* the copy should not be linked to something else yet */
-	assert(copy_info->original_value == copy);
-	copy_info->original_value = original;
-
-	/* copy over allocation preferences */
 	MEMCPY(copy_info->prefs, info->prefs, n_regs);
 }
 
@@ -471,46 +430,6 @@ static void combine_congruence_classes(void)
 }
 
 
-static void register_assignment(ir_node *const node, unsigned const reg_idx, unsigned const width)
-{
-	for (unsigned r0 = reg_idx; r0 < reg_idx + width; ++r0)
-		assignments[r0] = node;
-}
-
-/**
- * Assign register reg to the given node.
- *
- * @param node  the node
- * @param reg   the register
- */
-static void use_reg(ir_node *node, const arch_register_t *reg, unsigned width)
-{
-	register_assignment(node, reg->index, width);
-	arch_set_irn_register(node, reg);
-}
-
-static void use_reg_idx(ir_node *const node, unsigned const reg_idx, unsigned const width)
-{
-	register_assignment(node, reg_idx, width);
-	arch_set_irn_register_idx(node, reg_idx);
-}
-
-static void free_reg_of_value(ir_node *node)
-{
-	if (!arch_irn_consider_in_reg_alloc(cls, node))
-		return;
-
-	const arch_register_t     *reg = arch_get_irn_register(node);
-	const arch_register_req_t *req = arch_get_irn_register_req(node);
-	unsigned                   r   = reg->index;
-	/* assignment->value may be NULL if a value is used at 2 inputs
-	 * so it gets freed twice. */
-	for (unsigned r0 = r; r0 < r + req->width; ++r0) {
-		assert(assignments[r0] == node || assignments[r0] == NULL);
-		assignments[r0] = NULL;
-	}
-}
-
 /**
  * Compare two register preferences in decreasing order.
  */
@@ -549,7 +468,7 @@ static bool try_optimistic_split(ir_node *to_split, ir_node *before,
 	/* stupid hack: don't optimistically split don't spill nodes...
 	 * (so we don't split away the values produced because of
 	 *  must_be_different constraints) */
-	ir_node *original_insn = skip_Proj(info->original_value);
+	ir_node *original_insn = skip_Proj(info->value.original_value);
 	if (arch_get_irn_flags(original_insn) & arch_irn_flag_dont_spill)
 		return false;
 
@@ -585,7 +504,7 @@ static bool try_optimistic_split(ir_node *to_split, ir_node *before,
 		}
 
 		/* if the register is free then we can do the split */
-		if (assignments[r] == NULL)
+		if (ra.assignments[r] == NULL)
 			break;
 
 		/* otherwise we might try recursively calling optimistic_split */
@@ -601,7 +520,7 @@ static bool try_optimistic_split(ir_node *to_split, ir_node *before,
 		bool old_source_state = rbitset_is_set(forbidden_regs, from_r);
 		rbitset_set(forbidden_regs, from_r);
 		/* try recursive split */
-		bool res = try_optimistic_split(assignments[r], before, apref,
+		bool res = try_optimistic_split(ra.assignments[r], before, apref,
 		                              apref_delta, forbidden_regs, recursion+1);
 		/* restore our destination */
 		if (old_source_state) {
@@ -618,11 +537,11 @@ static bool try_optimistic_split(ir_node *to_split, ir_node *before,
 
 	ir_node *const copy  = be_new_Copy(block, to_split);
 	unsigned const width = 1;
-	mark_as_copy_of(copy, to_split);
+	be_ra_mark_as_copy_of(&ra, copy, to_split);
 	/* hacky, but correct here */
-	if (assignments[from_reg->index] == to_split)
-		free_reg_of_value(to_split);
-	use_reg_idx(copy, r, width);
+	if (ra.assignments[from_reg->index] == to_split)
+		be_ra_free_reg_of_value(&ra, to_split);
+	be_ra_use_reg(&ra, copy, r, width);
 	sched_add_before(before, copy);
 
 	DB((dbg, LEVEL_3,
@@ -642,7 +561,7 @@ static void assign_reg(ir_node const *const block, ir_node *const node, arch_reg
 	unsigned               const width     = req->width;
 	if (final_reg != NULL) {
 		DB((dbg, LEVEL_2, "Preassignment %+F -> %s\n", node, final_reg->name));
-		use_reg(node, final_reg, width);
+		be_ra_use_reg(&ra, node, final_reg->index, width);
 		return;
 	}
 
@@ -665,7 +584,7 @@ static void assign_reg(ir_node const *const block, ir_node *const node, arch_reg
 
 			/* if the value didn't die here then we should not propagate the
 			 * should_be_same info */
-			if (assignments[reg_index] == in)
+			if (ra.assignments[reg_index] == in)
 				continue;
 
 			info->prefs[reg_index] += weight * AFF_SHOULD_BE_SAME;
@@ -702,7 +621,7 @@ static void assign_reg(ir_node const *const block, ir_node *const node, arch_reg
 				continue;
 			bool fine = true;
 			for (unsigned r0 = r+1; r0 < r+width; ++r0) {
-				if (assignments[r0] != NULL)
+				if (ra.assignments[r0] != NULL)
 					fine = false;
 			}
 			/* TODO: attempt optimistic split here */
@@ -710,13 +629,13 @@ static void assign_reg(ir_node const *const block, ir_node *const node, arch_reg
 				continue;
 		}
 
-		if (assignments[final_reg_index] == NULL)
+		if (ra.assignments[final_reg_index] == NULL)
 			break;
 		float    pref   = reg_prefs[r].pref;
 		float    delta  = r+1 < n_regs ? pref - reg_prefs[r+1].pref : 0;
 		ir_node *before = skip_Proj(node);
 		bool     res
-			= try_optimistic_split(assignments[final_reg_index], before, pref,
+			= try_optimistic_split(ra.assignments[final_reg_index], before, pref,
 			                       delta, forbidden_regs, 0);
 		if (res)
 			break;
@@ -727,172 +646,10 @@ static void assign_reg(ir_node const *const block, ir_node *const node, arch_reg
 		panic("no register left for %+F", node);
 	}
 
-	use_reg_idx(node, final_reg_index, width);
+	be_ra_use_reg(&ra, node, final_reg_index, width);
 	DB((dbg, LEVEL_2, "Assign %+F -> %s\n", node, arch_get_irn_register(node)->name));
 }
 
-/**
- * Add an permutation in front of a node and change the assignments
- * due to this permutation.
- *
- * To understand this imagine a permutation like this:
- *
- * 1 -> 2
- * 2 -> 3
- * 3 -> 1, 5
- * 4 -> 6
- * 5
- * 6
- * 7 -> 7
- *
- * First we count how many destinations a single value has. At the same time
- * we can be sure that each destination register has at most 1 source register
- * (it can have 0 which means we don't care what value is in it).
- * We ignore all fulfilled permuations (like 7->7)
- * In a first pass we create as much copy instructions as possible as they
- * are generally cheaper than exchanges. We do this by counting into how many
- * destinations a register has to be copied (in the example it's 2 for register
- * 3, or 1 for the registers 1,2,4 and 7).
- * We can then create a copy into every destination register when the usecount
- * of that register is 0 (= noone else needs the value in the register).
- *
- * After this step we should only have cycles left. We implement a cyclic
- * permutation of n registers with n-1 transpositions.
- *
- * @param live_nodes   the set of live nodes, updated due to live range split
- * @param before       the node before we add the permutation
- * @param permutation  the permutation array indices are the destination
- *                     registers, the values in the array are the source
- *                     registers.
- */
-static void permute_values(ir_nodeset_t *live_nodes, ir_node *before,
-                           unsigned *permutation)
-{
-	unsigned *n_used = ALLOCANZ(unsigned, n_regs);
-
-	/* determine how often each source register needs to be read */
-	for (unsigned r = 0; r < n_regs; ++r) {
-		unsigned  old_reg = permutation[r];
-		ir_node  *value;
-
-		value = assignments[old_reg];
-		if (value == NULL) {
-			/* nothing to do here, reg is not live. Mark it as fixpoint
-			 * so we ignore it in the next steps */
-			permutation[r] = r;
-			continue;
-		}
-
-		++n_used[old_reg];
-	}
-
-	ir_node *block = get_nodes_block(before);
-
-	/* step1: create copies where immediately possible */
-	for (unsigned r = 0; r < n_regs; /* empty */) {
-		unsigned old_r = permutation[r];
-
-		/* - no need to do anything for fixed points.
-		   - we can't copy if the value in the dest reg is still needed */
-		if (old_r == r || n_used[r] > 0) {
-			++r;
-			continue;
-		}
-
-		/* create a copy */
-		ir_node *src  = assignments[old_r];
-		ir_node *copy = be_new_Copy(block, src);
-		sched_add_before(before, copy);
-		mark_as_copy_of(copy, src);
-		unsigned width = 1; /* TODO */
-		use_reg_idx(copy, r, width);
-		DB((dbg, LEVEL_2, "Copy %+F (from %+F, before %+F) -> %s\n", copy, src, before, arch_get_irn_register(copy)->name));
-
-		if (live_nodes != NULL) {
-			ir_nodeset_insert(live_nodes, copy);
-		}
-
-		/* old register has 1 user less, permutation is resolved */
-		assert(arch_get_irn_register(src)->index == old_r);
-		permutation[r] = r;
-
-		assert(n_used[old_r] > 0);
-		--n_used[old_r];
-		if (n_used[old_r] == 0) {
-			if (live_nodes != NULL) {
-				ir_nodeset_remove(live_nodes, src);
-			}
-			free_reg_of_value(src);
-		}
-
-		/* advance or jump back (if this copy enabled another copy) */
-		if (old_r < r && n_used[old_r] == 0) {
-			r = old_r;
-		} else {
-			++r;
-		}
-	}
-
-	/* at this point we only have "cycles" left which we have to resolve with
-	 * perm instructions
-	 * TODO: if we have free registers left, then we should really use copy
-	 * instructions for any cycle longer than 2 registers...
-	 * (this is probably architecture dependent, there might be archs where
-	 *  copies are preferable even for 2-cycles) */
-
-	/* create perms with the rest */
-	for (unsigned r = 0; r < n_regs; /* empty */) {
-		unsigned old_r = permutation[r];
-
-		if (old_r == r) {
-			++r;
-			continue;
-		}
-
-		/* we shouldn't have copies from 1 value to multiple destinations left*/
-		assert(n_used[old_r] == 1);
-
-		/* exchange old_r and r2; after that old_r is a fixed point */
-		unsigned r2 = permutation[old_r];
-
-		ir_node *const in[] = { assignments[r2], assignments[old_r] };
-		ir_node *const perm = be_new_Perm(block, ARRAY_SIZE(in), in);
-		sched_add_before(before, perm);
-		DB((dbg, LEVEL_2, "Perm %+F (perm %+F,%+F, before %+F)\n",
-		    perm, in[0], in[1], before));
-
-		unsigned width = 1; /* TODO */
-
-		ir_node *const proj0 = be_new_Proj(perm, 0);
-		mark_as_copy_of(proj0, in[0]);
-		use_reg_idx(proj0, old_r, width);
-
-		ir_node *const proj1 = be_new_Proj(perm, 1);
-		mark_as_copy_of(proj1, in[1]);
-		use_reg_idx(proj1, r2, width);
-
-		/* 1 value is now in the correct register */
-		permutation[old_r] = old_r;
-		/* the source of r changed to r2 */
-		permutation[r] = r2;
-
-		/* if we have reached a fixpoint update data structures */
-		if (live_nodes != NULL) {
-			ir_nodeset_remove(live_nodes, in[0]);
-			ir_nodeset_remove(live_nodes, in[1]);
-			ir_nodeset_remove(live_nodes, proj0);
-			ir_nodeset_insert(live_nodes, proj1);
-		}
-	}
-
-#ifndef NDEBUG
-	/* now we should only have fixpoints left */
-	for (unsigned r = 0; r < n_regs; ++r) {
-		assert(permutation[r] == r);
-	}
-#endif
-}
-
 /**
  * Free regs for values last used.
  *
@@ -909,29 +666,11 @@ static void free_last_uses(ir_nodeset_t *live_nodes, ir_node *node)
 		if (!rbitset_is_set(last_uses, i))
 			continue;
 
-		free_reg_of_value(op);
+		be_ra_free_reg_of_value(&ra, op);
 		ir_nodeset_remove(live_nodes, op);
 	}
 }
 
-/**
- * change inputs of a node to the current value (copies/perms)
- */
-static void rewire_inputs(ir_node *node)
-{
-	foreach_irn_in(node, i, op) {
-		allocation_info_t *info = try_get_allocation_info(op);
-
-		if (info == NULL)
-			continue;
-
-		info = get_allocation_info(info->original_value);
-		if (info->current_value != op) {
-			set_irn_n(node, i, info->current_value);
-		}
-	}
-}
-
 /**
  * Create a bitset of registers occupied with value living through an
  * instruction
@@ -942,7 +681,7 @@ static void determine_live_through_regs(unsigned *bitset, ir_node *node)
 
 	/* mark all used registers as potentially live-through */
 	for (unsigned r = 0; r < n_regs; ++r) {
-		if (assignments[r] == NULL)
+		if (ra.assignments[r] == NULL)
 			continue;
 		if (!rbitset_is_set(normal_regs, r))
 			continue;
@@ -1081,7 +820,7 @@ static void solve_lpp(ir_nodeset_t *live_nodes, ir_node *node,
 	}
 	fprintf(stderr, "\n");
 	fflush(stdout);
-	permute_values(live_nodes, node, assignment);
+	be_ra_permute_values(&ra, live_nodes, node, assignment);
 	lpp_free(lpp);
 }
 
@@ -1210,105 +949,7 @@ static void enforce_constraints(ir_nodeset_t *live_nodes, ir_node *node,
 
 	hungarian_free(bp);
 
-	permute_values(live_nodes, node, assignment);
-}
-
-/** test whether a node @p n is a copy of the value of node @p of */
-static bool is_copy_of(ir_node *value, ir_node *test_value)
-{
-	if (value == test_value)
-		return true;
-
-	allocation_info_t *info      = get_allocation_info(value);
-	allocation_info_t *test_info = get_allocation_info(test_value);
-	return test_info->original_value == info->original_value;
-}
-
-/**
- * find a value in the end-assignment of a basic block
- * @returns the index into the assignment array if found
- *          -1 if not found
- */
-static int find_value_in_block_info(block_info_t *info, ir_node *value)
-{
-	ir_node  **end_assignments = info->assignments;
-	for (unsigned r = 0; r < n_regs; ++r) {
-		ir_node *a_value = end_assignments[r];
-
-		if (a_value == NULL)
-			continue;
-		if (is_copy_of(a_value, value))
-			return (int) r;
-	}
-
-	return -1;
-}
-
-/**
- * Create the necessary permutations at the end of a basic block to fullfill
- * the register assignment for phi-nodes in the next block
- */
-static void add_phi_permutations(ir_node *block, int p)
-{
-	ir_node      *pred      = get_Block_cfgpred_block(block, p);
-	block_info_t *pred_info = get_block_info(pred);
-
-	/* predecessor not processed yet? nothing to do */
-	if (!pred_info->processed)
-		return;
-
-	unsigned *permutation = ALLOCAN(unsigned, n_regs);
-	for (unsigned r = 0; r < n_regs; ++r) {
-		permutation[r] = r;
-	}
-
-	/* check phi nodes */
-	bool need_permutation = false;
-	sched_foreach_phi(block, phi) {
-		if (!arch_irn_consider_in_reg_alloc(cls, phi))
-			continue;
-
-		ir_node *phi_pred = get_Phi_pred(phi, p);
-		int      a        = find_value_in_block_info(pred_info, phi_pred);
-		assert(a >= 0);
-
-		const arch_register_t *reg  = arch_get_irn_register(phi);
-		int                    regn = reg->index;
-		/* same register? nothing to do */
-		if (regn == a)
-			continue;
-
-		ir_node               *op     = pred_info->assignments[a];
-		const arch_register_t *op_reg = arch_get_irn_register(op);
-		/* Virtual registers are ok, too. */
-		if (op_reg->is_virtual)
-			continue;
-
-		permutation[regn] = a;
-		need_permutation  = true;
-	}
-
-	if (need_permutation) {
-		/* permute values at end of predecessor */
-		ir_node **old_assignments = assignments;
-		assignments     = pred_info->assignments;
-		permute_values(NULL, be_get_end_of_block_insertion_point(pred),
-		               permutation);
-		assignments = old_assignments;
-	}
-
-	/* change phi nodes to use the copied values */
-	sched_foreach_phi(block, phi) {
-		if (!arch_irn_consider_in_reg_alloc(cls, phi))
-			continue;
-
-		/* we have permuted all values into the correct registers so we can
-		   simply query which value occupies the phis register in the
-		   predecessor */
-		int      a  = arch_get_irn_register(phi)->index;
-		ir_node *op = pred_info->assignments[a];
-		set_Phi_pred(phi, p, op);
-	}
+	be_ra_permute_values(&ra, live_nodes, node, assignment);
 }
 
 /**
@@ -1329,7 +970,7 @@ static void adapt_phi_prefs(ir_node *phi)
 		 * assigned, otherwise we only see a dummy value
 		 * and any conclusions about its register are useless */
 		ir_node      *pred_block      = get_Block_cfgpred_block(block, i);
-		block_info_t *pred_block_info = get_block_info(pred_block);
+		be_ra_block_t *pred_block_info = be_ra_get_block(&ra, pred_block);
 		if (!pred_block_info->processed)
 			continue;
 
@@ -1431,7 +1072,7 @@ static void assign_phi_registers(ir_node *block)
 
 		unsigned r = assignment[n++];
 		assert(rbitset_is_set(normal_regs, r));
-		use_reg_idx(node, r, req->width);
+		be_ra_use_reg(&ra, node, r, req->width);
 		DB((dbg, LEVEL_2, "Assign %+F -> %s\n", node, arch_get_irn_register(node)->name));
 
 		/* adapt preferences for phi inputs */
@@ -1449,18 +1090,18 @@ static void allocate_coalesce_block(ir_node *block, void *data)
 	DB((dbg, LEVEL_2, "* Block %+F\n", block));
 
 	/* clear assignments */
-	block_info_t *block_info  = get_block_info(block);
-	assignments = block_info->assignments;
+	be_ra_block_t *block_info  = be_ra_get_block(&ra, block);
+	ra.assignments = block_info->assignments;
 
 	ir_nodeset_t live_nodes;
 	ir_nodeset_init(&live_nodes);
 
 	/* gather regalloc infos of predecessor blocks */
 	int            n_preds          = get_Block_n_cfgpreds(block);
-	block_info_t **pred_block_infos = ALLOCAN(block_info_t*, n_preds);
+	be_ra_block_t **pred_block_infos = ALLOCAN(be_ra_block_t*, n_preds);
 	for (int i = 0; i < n_preds; ++i) {
 		ir_node      *pred      = get_Block_cfgpred_block(block, i);
-		block_info_t *pred_info = get_block_info(pred);
+		be_ra_block_t *pred_info = be_ra_get_block(&ra, pred);
 		pred_block_infos[i]     = pred_info;
 	}
 
@@ -1474,11 +1115,11 @@ static void allocate_coalesce_block(ir_node *block, void *data)
 
 		if (req->ignore) {
 			allocation_info_t *info = get_allocation_info(node);
-			info->current_value = node;
+			info->value.current_value = node;
 
 			const arch_register_t *reg = arch_get_irn_register(node);
 			assert(reg != NULL); /* ignore values must be preassigned */
-			use_reg(node, reg, req->width);
+			be_ra_use_reg(&ra, node, reg->index, req->width);
 			continue;
 		}
 
@@ -1487,14 +1128,14 @@ static void allocate_coalesce_block(ir_node *block, void *data)
 		   (we collect the potential phi inputs here) */
 		bool need_phi = false;
 		for (int p = 0; p < n_preds; ++p) {
-			block_info_t *pred_info = pred_block_infos[p];
+			be_ra_block_t *pred_info = pred_block_infos[p];
 
 			if (!pred_info->processed) {
 				/* use node for now, it will get fixed later */
 				phi_ins[p] = node;
 				need_phi   = true;
 			} else {
-				int a = find_value_in_block_info(pred_info, node);
+				int a = be_ra_find_value_in_block(&ra, pred_info, node);
 
 				/* must live out of predecessor */
 				assert(a >= 0);
@@ -1519,13 +1160,13 @@ static void allocate_coalesce_block(ir_node *block, void *data)
 			}
 			DB((dbg, LEVEL_3, "\n"));
 #endif
-			mark_as_copy_of(phi, node);
+			be_ra_mark_as_copy_of(&ra, phi, node);
 			sched_add_after(block, phi);
 
 			node = phi;
 		} else {
 			allocation_info_t *info = get_allocation_info(node);
-			info->current_value = phi_ins[0];
+			info->value.current_value = phi_ins[0];
 
 			/* Grab 1 of the inputs we constructed (might not be the same as
 			 * "node" as we could see the same copy of the value in all
@@ -1536,7 +1177,7 @@ static void allocate_coalesce_block(ir_node *block, void *data)
 		/* if the node already has a register assigned use it */
 		const arch_register_t *reg = arch_get_irn_register(node);
 		if (reg != NULL) {
-			use_reg(node, reg, req->width);
+			be_ra_use_reg(&ra, node, reg->index, req->width);
 		}
 
 		/* remember that this node is live at the beginning of the block */
@@ -1559,13 +1200,13 @@ static void allocate_coalesce_block(ir_node *block, void *data)
 
 	/* assign instructions in the block, phis are already assigned */
 	sched_foreach_non_phi(block, node) {
-		rewire_inputs(node);
+		be_ra_rewire_inputs(node);
 
 		/* enforce use constraints */
 		rbitset_clear_all(forbidden_regs, n_regs);
 		enforce_constraints(&live_nodes, node, forbidden_regs);
 
-		rewire_inputs(node);
+		be_ra_rewire_inputs(node);
 
 		/* we may not use registers used for inputs for optimistic splits */
 		be_foreach_use(node, cls, in_req, op, op_req,
@@ -1583,14 +1224,14 @@ static void allocate_coalesce_block(ir_node *block, void *data)
 	}
 
 	ir_nodeset_destroy(&live_nodes);
-	assignments = NULL;
+	ra.assignments = NULL;
 
 	block_info->processed = true;
 
 	/* permute values at end of predecessor blocks in case of phi-nodes */
 	if (n_preds > 1) {
 		for (int p = 0; p < n_preds; ++p) {
-			add_phi_permutations(block, p);
+			be_ra_add_phi_permutations(&ra, block, p);
 		}
 	}
 
@@ -1601,10 +1242,10 @@ static void allocate_coalesce_block(ir_node *block, void *data)
 			= get_irn_out_edge_first_kind(block, EDGE_KIND_BLOCK);
 		ir_node      *succ      = get_edge_src_irn(edge);
 		int           p         = get_edge_src_pos(edge);
-		block_info_t *succ_info = get_block_info(succ);
+		be_ra_block_t *succ_info = be_ra_get_block(&ra, succ);
 
 		if (succ_info->processed) {
-			add_phi_permutations(succ, p);
+			be_ra_add_phi_permutations(&ra, succ, p);
 		}
 	}
 }
@@ -1801,6 +1442,14 @@ static void be_pref_alloc(ir_graph *new_irg, const regalloc_if_t *regif)
 		n_regs      = cls->n_regs;
 		normal_regs = rbitset_malloc(n_regs);
 		be_get_allocatable_regs(irg, cls, normal_regs);
+		ra = (be_ra_assign_env_t) {
+			.obst        = &obst,
+			.cls         = cls,
+			.n_regs      = n_regs,
+			.normal_regs = normal_regs,
+			.get_value   = get_ra_value,
+			.mark_copy   = mark_copy,
+		};
 
 		spill(regif);
 
@@ -0,0 +1,436 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2012 University of Karlsruhe.
+ */
+
+/**
+ * @file
+ * @brief       Common functions for register assignment.
+ */
+#include "beraassign.h"
+
+#include "bearch.h"
+#include "bemodule.h"
+#include "benode.h"
+#include "besched.h"
+#include "bespillutil.h"
+#include "beutil.h"
+#include "debug.h"
+#include "iredges_t.h"
+#include "irnode_t.h"
+#include "panic.h"
+#include "raw_bitset.h"
+#include "util.h"
+
+DEBUG_ONLY(static firm_dbg_module_t *dbg = NULL;)
+
+be_ra_block_t *be_ra_get_block(be_ra_assign_env_t const *const env,
+                               ir_node *const block)
+{
+	assert(is_Block(block));
+	be_ra_block_t *info = (be_ra_block_t*)get_irn_link(block);
+	if (info == NULL) {
+		info = OALLOCFZ(env->obst, be_ra_block_t, assignments, env->n_regs);
+		set_irn_link(block, info);
+	}
+	return info;
+}
+
+void be_ra_mark_as_copy_of(be_ra_assign_env_t const *const env,
+                           ir_node *const copy, ir_node *const value)
+{
+	ir_node       *const original  = env->get_value(value)->original_value;
+	be_ra_value_t *const info      = env->get_value(original);
+	be_ra_value_t *const copy_info = env->get_value(copy);
+	assert(info->original_value == original);
+	info->current_value = copy;
+
+	/* the copy should not be linked to something else yet */
+	assert(copy_info->original_value == copy);
+	copy_info->original_value = original;
+
+	if (env->mark_copy != NULL)
+		env->mark_copy(copy, original);
+}
+
+void be_ra_use_reg(be_ra_assign_env_t const *const env, ir_node *const node,
+                   unsigned const r, unsigned const width)
+{
+	for (unsigned r0 = r; r0 < r + width; ++r0)
+		env->assignments[r0] = node;
+	arch_set_irn_register_idx(node, r);
+}
+
+void be_ra_free_reg_of_value(be_ra_assign_env_t const *const env,
+                             ir_node *const node)
+{
+	if (!arch_irn_consider_in_reg_alloc(env->cls, node))
+		return;
+
+	arch_register_req_t const *const req = arch_get_irn_register_req(node);
+	unsigned                   const r   = arch_get_irn_register(node)->index;
+	/* the value may be freed twice if it is used at 2 inputs */
+	for (unsigned r0 = r; r0 < r + req->width; ++r0) {
+		assert(env->assignments[r0] == node || env->assignments[r0] == NULL);
+		env->assignments[r0] = NULL;
+	}
+}
+
+static bool is_copy_of(be_ra_assign_env_t const *const env,
+                       ir_node *const value, ir_node *const test_value)
+{
+	return value == test_value
+	    || env->get_value(value)->original_value
+	    == env->get_value(test_value)->original_value;
+}
+
+int be_ra_find_value_in_block(be_ra_assign_env_t const *const env,
+                              be_ra_block_t const *const info,
+                              ir_node *const value)
+{
+	for (unsigned r = 0, n_regs = env->n_regs; r < n_regs; ++r) {
+		ir_node *const a_value = info->assignments[r];
+		if (a_value != NULL && is_copy_of(env, a_value, value))
+			return (int)r;
+	}
+	return -1;
+}
+
+/*
+ * To understand this imagine a permutation like this:
+ *
+ * 1 -> 2
+ * 2 -> 3
+ * 3 -> 1, 5
+ * 4 -> 6
+ * 5
+ * 6
+ * 7 -> 7
+ *
+ * First we count how many destinations a single value has. At the same time
+ * we can be sure that each destination register has at most 1 source register
+ * (it can have 0 which means we don't care what value is in it).
+ * We ignore all fulfilled permuations (like 7->7)
+ * In a first pass we create as much copy instructions as possible as they
+ * are generally cheaper than exchanges. We do this by counting into how many
+ * destinations a register has to be copied (in the example it's 2 for register
+ * 3, or 1 for the registers 1,2,4 and 7).
+ * We can then create a copy into every destination register when the usecount
+ * of that register is 0 (= noone else needs the value in the register).
+ *
+ * After this step we should only have cycles left. We implement a cyclic
+ * permutation of n registers with n-1 transpositions.
+ */
+void be_ra_permute_values(be_ra_assign_env_t const *const env,
+                          ir_nodeset_t *const live_nodes,
+                          ir_node *const before, unsigned *const permutation)
+{
+	unsigned   const n_regs      = env->n_regs;
+	ir_node  **const assignments = env->assignments;
+	unsigned  *const n_used      = ALLOCANZ(unsigned, n_regs);
+
+	/* determine how often each source register needs to be read */
+	for (unsigned r = 0; r < n_regs; ++r) {
+		unsigned const src = permutation[r];
+		if (src == NO_REG)
+			continue;
+		if (assignments[src] == NULL) {
+			permutation[r] = NO_REG;
+			continue;
+		}
+		++n_used[src];
+	}
+
+	/* create copies where the destination register is not needed anymore */
+	ir_node *const block = get_nodes_block(before);
+	for (unsigned r = 0; r < n_regs;) {
+		unsigned const src = permutation[r];
+		if (src == NO_REG || src == r || n_used[r] > 0) {
+			++r;
+			continue;
+		}
+
+		ir_node *const value = assignments[src];
+		ir_node *const copy  = be_new_Copy(block, value);
+		sched_add_before(before, copy);
+		be_ra_mark_as_copy_of(env, copy, value);
+		be_ra_use_reg(env, copy, r, 1);
+		DB((dbg, LEVEL_2, "Copy %+F (from %+F, before %+F) -> %s\n", copy,
+		    value, before, arch_get_irn_register(copy)->name));
+		if (live_nodes != NULL)
+			ir_nodeset_insert(live_nodes, copy);
+		permutation[r] = r;
+
+		assert(n_used[src] > 0);
+		if (--n_used[src] == 0) {
+			if (live_nodes != NULL)
+				ir_nodeset_remove(live_nodes, value);
+			be_ra_free_reg_of_value(env, value);
+		}
+
+		/* this copy may have enabled an earlier one */
+		if (src < r && n_used[src] == 0) {
+			r = src;
+		} else {
+			++r;
+		}
+	}
+
+	/* only cycles are left, resolve them with Perms */
+	for (unsigned r = 0; r < n_regs;) {
+		unsigned const src = permutation[r];
+		if (src == NO_REG || src == r) {
+			++r;
+			continue;
+		}
+		/* we shouldn't have copies from 1 value to multiple destinations left */
+		assert(n_used[src] == 1);
+
+		/* exchange src and src2, afterwards src is a fixed point */
+		unsigned const src2 = permutation[src];
+		ir_node *const in[] = { assignments[src2], assignments[src] };
+		ir_node *const perm = be_new_Perm(block, ARRAY_SIZE(in), in);
+		sched_add_before(before, perm);
+		DB((dbg, LEVEL_2, "Perm %+F (perm %+F,%+F, before %+F)\n", perm, in[0],
+		    in[1], before));
+
+		ir_node *const proj0 = be_new_Proj(perm, 0);
+		be_ra_mark_as_copy_of(env, proj0, in[0]);
+		be_ra_use_reg(env, proj0, src, 1);
+
+		ir_node *const proj1 = be_new_Proj(perm, 1);
+		be_ra_mark_as_copy_of(env, proj1, in[1]);
+		be_ra_use_reg(env, proj1, src2, 1);
+
+		permutation[src] = src;
+		permutation[r]   = src2;
+
+		if (live_nodes != NULL) {
+			ir_nodeset_remove(live_nodes, in[0]);
+			ir_nodeset_remove(live_nodes, in[1]);
+			ir_nodeset_remove(live_nodes, proj0);
+			ir_nodeset_insert(live_nodes, proj1);
+		}
+	}
+
+#ifndef NDEBUG
+	/* now we should only have fixpoints left */
+	for (unsigned r = 0; r < n_regs; ++r) {
+		assert(permutation[r] == r || permutation[r] == NO_REG);
+	}
+#endif
+}
+
+void be_ra_rewire_inputs(ir_node *const node)
+{
+	foreach_irn_in(node, i, op) {
+		be_ra_value_t const *info = (be_ra_value_t const*)get_irn_link(op);
+		if (info == NULL)
+			continue;
+		info = (be_ra_value_t const*)get_irn_link(info->original_value);
+		if (info->current_value != op)
+			set_irn_n(node, i, info->current_value);
+	}
+}
+
+static bool dies_at(ir_node const *const node, unsigned const *const last_uses,
+                    ir_node const *const value)
+{
+	if (last_uses == NULL)
+		return false;
+	foreach_irn_in(node, i, op) {
+		if (op == value && rbitset_is_set(last_uses, i))
+			return true;
+	}
+	return false;
+}
+
+/** Returns the row of register @p r in a bitset matrix with one row of
+ * registers per register. */
+static unsigned *get_row(unsigned *const matrix, unsigned const n_regs,
+                         unsigned const r)
+{
+	return &matrix[r * BITSET_SIZE_ELEMS(n_regs)];
+}
+
+typedef struct match_env_t {
+	unsigned  n_regs;
+	unsigned *allowed;  /**< allowed registers of the value in each
+	                         register */
+	unsigned *dest_of;  /**< destination of the value in each register */
+	unsigned *owner;    /**< source register of each destination */
+	unsigned *visited;
+} match_env_t;
+
+/** Finds a destination for the value in register @p src by augmenting the
+ * matching, free registers are tried first. */
+static bool augment(match_env_t *const env, unsigned const src)
+{
+	unsigned const        n_regs  = env->n_regs;
+	unsigned const *const allowed = get_row(env->allowed, n_regs, src);
+	rbitset_foreach(allowed, n_regs, r) {
+		if (env->owner[r] == NO_REG && !rbitset_is_set(env->visited, r)) {
+			env->owner[r]     = src;
+			env->dest_of[src] = r;
+			return true;
+		}
+	}
+	rbitset_foreach(allowed, n_regs, r) {
+		if (rbitset_is_set(env->visited, r))
+			continue;
+		rbitset_set(env->visited, r);
+		if (env->owner[r] == NO_REG || augment(env, env->owner[r])) {
+			env->owner[r]     = src;
+			env->dest_of[src] = r;
+			return true;
+		}
+	}
+	return false;
+}
+
+void be_ra_enforce_constraints(be_ra_assign_env_t const *const env,
+                               ir_node *const node,
+                               unsigned const *const last_uses)
+{
+	arch_register_class_t const *const cls         = env->cls;
+	unsigned                     const n_regs      = env->n_regs;
+	unsigned const              *const normal_regs = env->normal_regs;
+	ir_node                    **const assignments = env->assignments;
+
+	unsigned *const out_regs   = rbitset_alloca(n_regs);
+	bool            out_limits = false;
+	be_foreach_definition(node, cls, value, req,
+		(void)value;
+		if (req->limited != NULL) {
+			rbitset_or(out_regs, req->limited, n_regs);
+			out_limits = true;
+		}
+	);
+
+	bool good = true;
+	be_foreach_use(node, cls, req, op, op_req,
+		if (req->limited != NULL
+		 && !rbitset_is_set(req->limited, arch_get_irn_register(op)->index))
+			good = false;
+	);
+	if (good && out_limits) {
+		rbitset_foreach(out_regs, n_regs, r) {
+			ir_node const *const value = assignments[r];
+			if (value != NULL && rbitset_is_set(normal_regs, r)
+			 && !dies_at(node, last_uses, value)) {
+				good = false;
+				break;
+			}
+		}
+	}
+	if (good)
+		return;
+
+	DB((dbg, LEVEL_2, "enforce constraints of %+F\n", node));
+	unsigned *const allowed = ALLOCANZ(unsigned, n_regs * BITSET_SIZE_ELEMS(n_regs));
+	for (unsigned r = 0; r < n_regs; ++r) {
+		ir_node const *const value = assignments[r];
+		if (value == NULL || !rbitset_is_set(normal_regs, r))
+			continue;
+		unsigned *const value_allowed = get_row(allowed, n_regs, r);
+		rbitset_copy(value_allowed, normal_regs, n_regs);
+		if (!dies_at(node, last_uses, value))
+			rbitset_andnot(value_allowed, out_regs, n_regs);
+	}
+	be_foreach_use(node, cls, req, op, op_req,
+		if (req->limited != NULL) {
+			unsigned const r = arch_get_irn_register(op)->index;
+			rbitset_and(get_row(allowed, n_regs, r), req->limited, n_regs);
+		}
+	);
+
+	match_env_t match = {
+		.n_regs  = n_regs,
+		.allowed = allowed,
+		.dest_of = ALLOCAN(unsigned, n_regs),
+		.owner   = ALLOCAN(unsigned, n_regs),
+		.visited = rbitset_alloca(n_regs),
+	};
+	for (unsigned r = 0; r < n_regs; ++r) {
+		match.dest_of[r] = NO_REG;
+		match.owner[r]   = NO_REG;
+	}
+	/* values stay where they are if possible */
+	for (unsigned r = 0; r < n_regs; ++r) {
+		if (assignments[r] != NULL && rbitset_is_set(normal_regs, r)
+		 && rbitset_is_set(get_row(allowed, n_regs, r), r)) {
+			match.owner[r]   = r;
+			match.dest_of[r] = r;
+		}
+	}
+	for (unsigned r = 0; r < n_regs; ++r) {
+		if (assignments[r] == NULL || !rbitset_is_set(normal_regs, r)
+		 || match.dest_of[r] != NO_REG)
+			continue;
+		rbitset_clear_all(match.visited, n_regs);
+		if (!augment(&match, r))
+			panic("cannot fulfill register constraints of %+F", node);
+	}
+
+	be_ra_permute_values(env, NULL, node, match.owner);
+}
+
+void be_ra_add_phi_permutations(be_ra_assign_env_t *const env,
+                                ir_node *const block, int const p)
+{
+	ir_node       *const pred      = get_Block_cfgpred_block(block, p);
+	be_ra_block_t *const pred_info = be_ra_get_block(env, pred);
+
+	/* predecessor not processed yet? nothing to do */
+	if (!pred_info->processed)
+		return;
+
+	unsigned const  n_regs      = env->n_regs;
+	unsigned *const permutation = ALLOCAN(unsigned, n_regs);
+	for (unsigned r = 0; r < n_regs; ++r) {
+		permutation[r] = r;
+	}
+
+	bool need_permutation = false;
+	sched_foreach_phi(block, phi) {
+		if (!arch_irn_consider_in_reg_alloc(env->cls, phi))
+			continue;
+
+		ir_node *const op = get_Phi_pred(phi, p);
+		int      const a  = be_ra_find_value_in_block(env, pred_info, op);
+		assert(a >= 0);
+
+		/* same register? nothing to do. Virtual registers are ok, too. */
+		unsigned const r = arch_get_irn_register(phi)->index;
+		if (r == (unsigned)a
+		 || arch_get_irn_register(pred_info->assignments[a])->is_virtual)
+			continue;
+
+		permutation[r]   = a;
+		need_permutation = true;
+	}
+
+	if (need_permutation) {
+		/* permute values at end of predecessor */
+		ir_node **const old_assignments = env->assignments;
+		env->assignments = pred_info->assignments;
+		be_ra_permute_values(env, NULL,
+		                     be_get_end_of_block_insertion_point(pred),
+		                     permutation);
+		env->assignments = old_assignments;
+	}
+
+	/* the phi operands are in the phi registers now */
+	sched_foreach_phi(block, phi) {
+		if (!arch_irn_consider_in_reg_alloc(env->cls, phi))
+			continue;
+		unsigned const r = arch_get_irn_register(phi)->index;
+		set_Phi_pred(phi, p, pred_info->assignments[r]);
+	}
+}
+
+BE_REGISTER_MODULE_CONSTRUCTOR(be_init_raassign)
+void be_init_raassign(void)
+{
+	FIRM_DBG_REGISTER(dbg, "firm.be.raassign");
+}
@@ -0,0 +1,127 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2012 University of Karlsruhe.
+ */
+
+/**
+ * @file
+ * @brief       Common functions for register assignment.
+ *
+ * Used by the register allocators which assign registers block by block on
+ * the existing schedule and repair the assignment with copies and Perms,
+ * i.e. the preference guided and the linear scan allocator.
+ *
+ * The allocators keep their allocation info of a node in its link, the info
+ * starts with a be_ra_value_t. The info of a block is a be_ra_block_t.
+ */
+#ifndef FIRM_BE_BERAASSIGN_H
+#define FIRM_BE_BERAASSIGN_H
+
+#include <limits.h>
+#include <stdbool.h>
+
+#include "be_types.h"
+#include "firm_types.h"
+#include "irnodeset.h"
+#include "obst.h"
+
+/** Marks a register without a value. */
+#define NO_REG UINT_MAX
+
+/** Copy information of a value, first member of the allocation infos. */
+typedef struct be_ra_value_t {
+	ir_node *current_value;  /**< copy of the value that should be used */
+	ir_node *original_value; /**< for copies point to original value */
+} be_ra_value_t;
+
+/** Per basic block information. */
+typedef struct be_ra_block_t {
+	bool     processed;     /**< indicate whether block is processed */
+	ir_node *assignments[]; /**< register assignments at end of block */
+} be_ra_block_t;
+
+/** The state of the register assignment of one register class. */
+typedef struct be_ra_assign_env_t {
+	struct obstack              *obst;        /**< holds the block infos */
+	arch_register_class_t const *cls;
+	unsigned                     n_regs;
+	unsigned const              *normal_regs; /**< allocatable registers */
+	/** currently active assignments, maps registers to values */
+	ir_node                    **assignments;
+	/** Returns the allocation info of @p node, created on the first call. */
+	be_ra_value_t *(*get_value)(ir_node *node);
+	/** Called after @p copy became a copy of @p value, may be NULL. */
+	void (*mark_copy)(ir_node *copy, ir_node *value);
+} be_ra_assign_env_t;
+
+/**
+ * Returns the information of @p block, created on the first call.
+ */
+be_ra_block_t *be_ra_get_block(be_ra_assign_env_t const *env, ir_node *block);
+
+/**
+ * Links the allocation info of @p copy to the original value of @p value and
+ * makes the copy the current value. Copy must not be linked to another
+ * value yet.
+ */
+void be_ra_mark_as_copy_of(be_ra_assign_env_t const *env, ir_node *copy,
+                           ir_node *value);
+
+/**
+ * Assigns the @p width registers starting at @p r to @p node.
+ */
+void be_ra_use_reg(be_ra_assign_env_t const *env, ir_node *node, unsigned r,
+                   unsigned width);
+
+/**
+ * Frees the registers of @p node. A value may be freed twice if it is used
+ * at 2 inputs.
+ */
+void be_ra_free_reg_of_value(be_ra_assign_env_t const *env, ir_node *node);
+
+/**
+ * Returns the register holding a copy of @p value at the end of the block
+ * with the information @p info or -1 if there is none.
+ */
+int be_ra_find_value_in_block(be_ra_assign_env_t const *env,
+                              be_ra_block_t const *info, ir_node *value);
+
+/**
+ * Moves values between registers in front of @p before. Copies are used
+ * where possible, cycles are resolved with Perms.
+ *
+ * @param live_nodes   the set of live nodes, updated due to live range
+ *                     splits, may be NULL
+ * @param permutation  maps the destination registers to the source
+ *                     registers, NO_REG for destinations which receive no
+ *                     value. Values whose register is no destination are
+ *                     discarded.
+ */
+void be_ra_permute_values(be_ra_assign_env_t const *env,
+                          ir_nodeset_t *live_nodes, ir_node *before,
+                          unsigned *permutation);
+
+/**
+ * Changes the inputs of @p node to the current copies of the values.
+ */
+void be_ra_rewire_inputs(ir_node *node);
+
+/**
+ * Moves values so the register constraints of @p node are met: Constrained
+ * operands must be in their allowed registers and values living through the
+ * node must not occupy registers written by the node. Only the conflicting
+ * values are moved.
+ *
+ * @param last_uses  bitset of the inputs which are last uses, may be NULL
+ */
+void be_ra_enforce_constraints(be_ra_assign_env_t const *env, ir_node *node,
+                               unsigned const *last_uses);
+
+/**
+ * Creates the necessary permutations at the end of the predecessor @p p of
+ * @p block so the phi operands are in the registers of the phis.
+ */
+void be_ra_add_phi_permutations(be_ra_assign_env_t *env, ir_node *block,
+                                int p);
+
+#endif
@@ -0,0 +1,441 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2012 University of Karlsruhe.
+ */
+
+/**
+ * @file
+ * @brief   List scheduler using the machine model of the target CPU.
+ *
+ * The scheduler simulates the issue of instructions cycle by cycle: Each node
+ * has a latency, a throughput and a set of execution ports, which the backend
+ * takes from the machine model of the selected CPU. Among the ready nodes, the
+ * one which can start first is selected and ties are broken by the length of
+ * the critical path to the end of the block. So long latency operations like
+ * loads and divisions are started as early as possible and independent work is
+ * scheduled into their shadow.
+ *
+ * Hoisting operations increases register pressure. If the values defined in
+ * the block would exceed the allocatable registers of a class, nodes reducing
+ * the pressure are preferred instead.
+ */
+#include "belistsched.h"
+
+#include "be_t.h"
+#include "bearch.h"
+#include "bemodule.h"
+#include "benode.h"
+#include "besched.h"
+#include "debug.h"
+#include "heights.h"
+#include "iredges_t.h"
+#include "irgwalk.h"
+#include "irnode_t.h"
+#include "target_t.h"
+#include "util.h"
+
+DEBUG_ONLY(static firm_dbg_module_t *dbg = NULL;)
+
+/** Maximal number of execution ports of a machine model. */
+#define MAX_PORTS      32
+/** Number of registers kept free by the register pressure guard. */
+#define RESERVED_REGS  2
+
+typedef struct latency_node_t {
+	unsigned latency;    /**< cycles until the result is available */
+	unsigned throughput; /**< cycles an execution port is busy */
+	unsigned ports;      /**< bitset of the ports able to execute it */
+	unsigned done;       /**< cycle in which the result is available */
+	unsigned n_users;    /**< unscheduled users in the block */
+	bool     live_out;   /**< value is used outside of the block */
+	bool     defined;    /**< value counts towards the register pressure */
+} latency_node_t;
+
+typedef struct latency_env_t {
+	ir_graph       *irg;
+	ir_node        *block;
+	latency_node_t *nodes;
+	ir_heights_t   *heights;
+	unsigned        issue_width;
+	unsigned        cycle;                /**< the current cycle */
+	unsigned        n_issued;             /**< nodes issued in this cycle */
+	unsigned        port_free[MAX_PORTS]; /**< cycle each port is free */
+	unsigned       *pressure;             /**< live values per class */
+	unsigned       *max_pressure;         /**< guard limit per class */
+} latency_env_t;
+
+/** Fills @p info from the machine model and returns the issue width. */
+static unsigned get_sched_info(const ir_node *node, be_sched_info_t *info)
+{
+	if (ir_target.isa->get_sched_info != NULL)
+		return ir_target.isa->get_sched_info(node, info);
+	info->latency    = be_is_Keep(node) ? 0 : 1;
+	info->throughput = 1;
+	info->ports      = 1;
+	return 1;
+}
+
+static unsigned get_latency(const ir_node *node)
+{
+	if (is_Proj(node) || is_Phi(node))
+		return 0;
+	be_sched_info_t info;
+	get_sched_info(node, &info);
+	return info.latency;
+}
+
+static latency_node_t *get_latency_node(const latency_env_t *env,
+                                        const ir_node *node)
+{
+	return &env->nodes[get_irn_idx(node)];
+}
+
+/** Returns the register class of the value @p node or NULL. */
+static const arch_register_class_t *get_value_class(const ir_node *node)
+{
+	ir_mode *mode = get_irn_mode(node);
+	if (mode == mode_T || mode == mode_M || mode == mode_X)
+		return NULL;
+	const arch_register_req_t *req = arch_get_irn_register_req(node);
+	if (req->cls == NULL || req->ignore || req->cls->manual_ra)
+		return NULL;
+	return req->cls;
+}
+
+/** Returns whether @p node issues no instruction. */
+static bool is_free(const ir_node *node)
+{
+	return is_Phi(node) || be_is_Keep(node);
+}
+
+static void init_value(latency_env_t *env, ir_node *value)
+{
+	latency_node_t *lnode = get_latency_node(env, value);
+	lnode->n_users  = 0;
+	lnode->live_out = false;
+	lnode->defined  = false;
+	foreach_out_edge(value, edge) {
+		ir_node *user = get_edge_src_irn(edge);
+		if (is_Block(user))
+			continue;
+		if (get_nodes_block(user) != env->block || is_Phi(user))
+			lnode->live_out = true;
+		else
+			++lnode->n_users;
+	}
+}
+
+static void init_block(latency_env_t *env, ir_node *block)
+{
+	const arch_isa_if_t *isa = ir_target.isa;
+	env->block    = block;
+	env->cycle    = 0;
+	env->n_issued = 0;
+	memset(env->port_free, 0, sizeof(env->port_free));
+	memset(env->pressure, 0, isa->n_register_classes * sizeof(*env->pressure));
+
+	/* live-in values occupy registers for the whole block */
+	unsigned *live_in = ALLOCANZ(unsigned, isa->n_register_classes);
+	foreach_out_edge(block, edge) {
+		ir_node *node = get_edge_src_irn(edge);
+		if (is_Proj(node))
+			continue;
+
+		be_sched_info_t info;
+		unsigned issue_width = get_sched_info(node, &info);
+		env->issue_width = MAX(issue_width, 1);
+
+		latency_node_t *lnode = get_latency_node(env, node);
+		lnode->latency    = is_free(node) ? 0 : info.latency;
+		lnode->throughput = info.throughput;
+		lnode->ports      = info.ports;
+		lnode->done       = 0;
+		if (get_irn_mode(node) == mode_T) {
+			foreach_out_edge(node, proj_edge) {
+				ir_node *proj = get_edge_src_irn(proj_edge);
+				if (is_Proj(proj))
+					init_value(env, proj);
+			}
+		} else {
+			init_value(env, node);
+		}
+
+		if (is_Phi(node))
+			continue;
+		foreach_irn_in(node, i, op) {
+			if (is_Block(op) || get_nodes_block(op) == block)
+				continue;
+			const arch_register_class_t *cls = get_value_class(op);
+			if (cls != NULL)
+				++live_in[cls->index];
+		}
+	}
+
+	for (unsigned c = 0; c < isa->n_register_classes; ++c) {
+		const arch_register_class_t *cls = &isa->register_classes[c];
+		if (cls->manual_ra) {
+			env->max_pressure[c] = UINT_MAX;
+			continue;
+		}
+		unsigned n_regs = be_get_n_allocatable_regs(env->irg, cls);
+		unsigned used   = live_in[c] + RESERVED_REGS;
+		env->max_pressure[c] = n_regs > used ? n_regs - used : 1;
+	}
+}
+
+/** Returns the cycle in which all operands of @p node are available. */
+static unsigned get_ready_cycle(const latency_env_t *env, const ir_node *node)
+{
+	unsigned ready = 0;
+	if (is_Phi(node))
+		return ready;
+	foreach_irn_in(node, i, op) {
+		const ir_node *pred = is_Proj(op) ? get_Proj_pred(op) : op;
+		if (is_Block(pred) || get_nodes_block(pred) != env->block)
+			continue;
+		ready = MAX(ready, get_latency_node(env, pred)->done);
+	}
+	return ready;
+}
+
+/** Returns the first cycle in which @p node can be issued. */
+static unsigned get_start_cycle(const latency_env_t *env, const ir_node *node,
+                                unsigned *port)
+{
+	unsigned start = MAX(env->cycle, get_ready_cycle(env, node));
+	if (is_free(node))
+		return start;
+
+	const latency_node_t *lnode = get_latency_node(env, node);
+	unsigned port_start = UINT_MAX;
+	for (unsigned p = 0; p < MAX_PORTS; ++p) {
+		if ((lnode->ports & (1u << p)) && env->port_free[p] < port_start) {
+			port_start = env->port_free[p];
+			*port      = p;
+		}
+	}
+	if (port_start != UINT_MAX)
+		start = MAX(start, port_start);
+	if (start == env->cycle && env->n_issued >= env->issue_width)
+		++start;
+	return start;
+}
+
+static void add_pressure(latency_env_t *env, ir_node *value, int *delta)
+{
+	const arch_register_class_t *cls = get_value_class(value);
+	if (cls == NULL)
+		return;
+	const latency_node_t *lnode = get_latency_node(env, value);
+	if (lnode->n_users > 0 || lnode->live_out)
+		++delta[cls->index];
+}
+
+/**
+ * Computes the change of the register pressure per class if @p node is
+ * scheduled now.
+ */
+static void get_pressure_delta(latency_env_t *env, ir_node *node, int *delta)
+{
+	memset(delta, 0, ir_target.isa->n_register_classes * sizeof(*delta));
+	if (get_irn_mode(node) == mode_T) {
+		foreach_out_edge(node, edge) {
+			ir_node *proj = get_edge_src_irn(edge);
+			if (is_Proj(proj))
+				add_pressure(env, proj, delta);
+		}
+	} else {
+		add_pressure(env, node, delta);
+	}
+
+	if (is_Phi(node))
+		return;
+	foreach_irn_in(node, i, op) {
+		if (is_Block(op) || get_nodes_block(op) != env->block)
+			continue;
+		const arch_register_class_t *cls = get_value_class(op);
+		if (cls == NULL)
+			continue;
+		/* count each operand once, at its last occurrence */
+		bool last = true;
+		for (int j = i + 1, arity = get_irn_arity(node); j < arity; ++j) {
+			if (get_irn_n(node, j) == op) {
+				last = false;
+				break;
+			}
+		}
+		if (!last)
+			continue;
+		unsigned uses = 0;
+		foreach_irn_in(node, j, other) {
+			if (other == op)
+				++uses;
+		}
+		const latency_node_t *lnode = get_latency_node(env, op);
+		if (lnode->defined && !lnode->live_out && lnode->n_users == uses)
+			--delta[cls->index];
+	}
+}
+
+/** Returns whether the block already uses all registers of a class. */
+static bool pressure_exceeded(const latency_env_t *env)
+{
+	for (unsigned c = 0; c < ir_target.isa->n_register_classes; ++c) {
+		if (env->pressure[c] >= env->max_pressure[c])
+			return true;
+	}
+	return false;
+}
+
+static int get_pressure_sum(const int *delta)
+{
+	int sum = 0;
+	for (unsigned c = 0; c < ir_target.isa->n_register_classes; ++c)
+		sum += delta[c];
+	return sum;
+}
+
+static ir_node *latency_select(latency_env_t *env, ir_nodeset_t *ready_set)
+{
+	bool     guard      = pressure_exceeded(env);
+	int     *delta      = ALLOCAN(int, ir_target.isa->n_register_classes);
+	ir_node *best       = NULL;
+	unsigned best_start = 0;
+	unsigned best_port  = 0;
+	unsigned best_height = 0;
+	int      best_delta = 0;
+	foreach_ir_nodeset(ready_set, node, iter) {
+		unsigned port   = 0;
+		unsigned start  = get_start_cycle(env, node, &port);
+		unsigned height = get_irn_height(env->heights, node);
+		int      d      = 0;
+		if (guard) {
+			get_pressure_delta(env, node, delta);
+			d = get_pressure_sum(delta);
+		}
+
+		if (best != NULL) {
+			if (d != best_delta) {
+				if (d > best_delta)
+					continue;
+			} else if (start != best_start) {
+				if (start > best_start)
+					continue;
+			} else if (height != best_height) {
+				if (height < best_height)
+					continue;
+			} else if (get_irn_idx(node) > get_irn_idx(best)) {
+				continue;
+			}
+		}
+		best        = node;
+		best_start  = start;
+		best_port   = port;
+		best_height = height;
+		best_delta  = d;
+	}
+
+	/* issue the node */
+	latency_node_t *lnode = get_latency_node(env, best);
+	if (best_start > env->cycle) {
+		env->cycle    = best_start;
+		env->n_issued = 0;
+	}
+	lnode->done = best_start + lnode->latency;
+	if (!is_free(best)) {
+		if (lnode->ports != 0)
+			env->port_free[best_port] = best_start + lnode->throughput;
+		if (++env->n_issued >= env->issue_width) {
+			++env->cycle;
+			env->n_issued = 0;
+		}
+	}
+	DB((dbg, LEVEL_2, "\tcycle %u: %+F (height %u, done %u)\n", best_start,
+	    best, best_height, lnode->done));
+	return best;
+}
+
+static void define_value(latency_env_t *env, ir_node *value)
+{
+	latency_node_t *lnode = get_latency_node(env, value);
+	if (lnode->n_users == 0 && !lnode->live_out)
+		return;
+	const arch_register_class_t *cls = get_value_class(value);
+	if (cls == NULL)
+		return;
+	lnode->defined = true;
+	++env->pressure[cls->index];
+}
+
+/** Updates the register pressure after @p node has been scheduled. */
+static void update_pressure(latency_env_t *env, ir_node *node)
+{
+	if (get_irn_mode(node) == mode_T) {
+		foreach_out_edge(node, edge) {
+			ir_node *proj = get_edge_src_irn(edge);
+			if (is_Proj(proj))
+				define_value(env, proj);
+		}
+	} else {
+		define_value(env, node);
+	}
+
+	if (is_Phi(node))
+		return;
+	foreach_irn_in(node, i, op) {
+		if (is_Block(op) || get_nodes_block(op) != env->block)
+			continue;
+		/* values of nodes scheduled outside of this scheduler (Start,
+		 * not scheduled nodes) are not tracked */
+		latency_node_t *lnode = get_latency_node(env, op);
+		if (lnode->n_users == 0)
+			continue;
+		if (--lnode->n_users == 0 && !lnode->live_out && lnode->defined) {
+			lnode->defined = false;
+			--env->pressure[get_value_class(op)->index];
+		}
+	}
+}
+
+static void sched_block(ir_node *block, void *data)
+{
+	latency_env_t *env = (latency_env_t*)data;
+	init_block(env, block);
+
+	ir_nodeset_t *cands = be_list_sched_begin_block(block);
+	while (ir_nodeset_size(cands) > 0) {
+		ir_node *node = latency_select(env, cands);
+		update_pressure(env, node);
+		be_list_sched_schedule(node);
+	}
+	be_list_sched_end_block();
+}
+
+static void sched_latency(ir_graph *irg)
+{
+	unsigned n_classes = ir_target.isa->n_register_classes;
+
+	latency_env_t env;
+	memset(&env, 0, sizeof(env));
+	env.irg          = irg;
+	env.pressure     = XMALLOCN(unsigned, n_classes);
+	env.max_pressure = XMALLOCN(unsigned, n_classes);
+
+	be_list_sched_begin(irg);
+	env.nodes   = XMALLOCNZ(latency_node_t, get_irg_last_idx(irg));
+	env.heights = heights_new_weighted(irg, get_latency);
+	irg_block_walk_graph(irg, sched_block, NULL, &env);
+	heights_free(env.heights);
+	be_list_sched_finish();
+
+	free(env.nodes);
+	free(env.max_pressure);
+	free(env.pressure);
+}
+
+BE_REGISTER_MODULE_CONSTRUCTOR(be_init_sched_latency)
+void be_init_sched_latency(void)
+{
+	be_register_scheduler("latency", sched_latency);
+	FIRM_DBG_REGISTER(dbg, "firm.be.sched.latency");
+}
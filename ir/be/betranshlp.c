@@ -27,6 +27,7 @@
 #include "irgraph_t.h"
 #include "irgwalk.h"
 #include "irhooks.h"
+#include "irloop.h"
 #include "irnode_t.h"
 #include "irnodemap.h"
 #include "irop_t.h"
@@ -324,6 +325,9 @@ void be_transform_graph(ir_graph *irg, arch_pretrans_nodes *func)
 	obstack_init(&irg->obst);
 	irg->last_node_idx = 0;
 
+	/* node indices are handed out anew, drop analysis data indexed by them */
+	free_irg_outs(irg);
+	free_loop_information(irg);
 	free_vrp_data(irg);
 
 	/* create new value table for CSE */
@@ -467,27 +467,40 @@ static const char *lv_flags_to_str(unsigned flags)
 	return states[flags & 7];
 }
 
+#define LV_ALL_STATES (be_lv_state_in | be_lv_state_end | be_lv_state_out)
+
+static unsigned lv_count_live(be_lv_t const *const lv, ir_node const *const bl)
+{
+	unsigned n = 0;
+	be_lv_foreach(lv, bl, LV_ALL_STATES, node) {
+		(void)node;
+		++n;
+	}
+	return n;
+}
+
+static void lv_dump_live(be_lv_t const *const lv, ir_node const *const bl)
+{
+	unsigned i = 0;
+	be_lv_foreach(lv, bl, LV_ALL_STATES, node) {
+		be_lv_state_t const flags = be_get_live_state(lv, bl, node);
+		ir_fprintf(stderr, "%+F %u %+F %s\n", bl, i++, node, lv_flags_to_str(flags));
+	}
+}
+
 static void lv_check_walker(ir_node *bl, void *data)
 {
-	lv_walker_t    *const w       = (lv_walker_t*)data;
-	be_lv_info_t   *const curr    = ir_nodehashmap_get(be_lv_info_t, &w->given->map, bl);
-	be_lv_info_t   *const fresh   = ir_nodehashmap_get(be_lv_info_t, &w->fresh->map, bl);
-	unsigned const        n_curr  = curr  ? curr->n_members  : 0;
-	unsigned const        n_fresh = fresh ? fresh->n_members : 0;
+	lv_walker_t *const w       = (lv_walker_t*)data;
+	unsigned     const n_curr  = lv_count_live(w->given, bl);
+	unsigned     const n_fresh = lv_count_live(w->fresh, bl);
 	if (n_curr != n_fresh) {
 		ir_fprintf(stderr, "%+F: liveness set sizes differ. curr %d, correct %d\n", bl, n_curr, n_fresh);
 
 		ir_fprintf(stderr, "current:\n");
-		for (unsigned i = 0; i < n_curr; ++i) {
-			be_lv_info_node_t *const n = &curr->nodes[i];
-			ir_fprintf(stderr, "%+F %u %+F %s\n", bl, i, n->node, lv_flags_to_str(n->flags));
-		}
+		lv_dump_live(w->given, bl);
 
 		ir_fprintf(stderr, "correct:\n");
-		for (unsigned i = 0; i < n_fresh; ++i) {
-			be_lv_info_node_t *const n = &fresh->nodes[i];
-			ir_fprintf(stderr, "%+F %u %+F %s\n", bl, i, n->node, lv_flags_to_str(n->flags));
-		}
+		lv_dump_live(w->fresh, bl);
 	}
 }
 
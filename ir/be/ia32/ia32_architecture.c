@@ -495,6 +495,7 @@ void ia32_setup_cg_config(void)
 		arch_flags(opt_arch, arch_i386 | arch_i486) || opt_size ? 0 :
 		arch_flags(opt_arch, arch_all_amd) ? 3 :
 		2;
+	c->machine = x86_get_machine_model(opt_arch);
 }
 
 void ia32_init_architecture(void)
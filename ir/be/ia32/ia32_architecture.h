@@ -15,6 +15,7 @@
 
 #include "firm_types.h"
 #include "irarch.h"
+#include "x86_architecture.h"
 
 typedef struct {
 	/** optimize for size */
@@ -93,6 +94,8 @@ typedef struct {
 	/** if a blocks execfreq is factor higher than its predecessor then align
 	 *  the blocks label (0 switches off label alignment) */
 	double label_alignment_factor;
+	/** machine model of the CPU to optimize for */
+	x86_machine_model const *machine;
 } ia32_code_gen_config_t;
 
 extern ia32_code_gen_config_t ia32_cg_config;
@@ -265,6 +265,112 @@ static unsigned ia32_get_op_estimated_cost(ir_node const *const irn)
 	return cost;
 }
 
+static x86_insn_class ia32_get_insn_class(const ir_node *node)
+{
+	switch ((ia32_opcodes)get_ia32_irn_opcode(node)) {
+	case iro_ia32_Div:
+	case iro_ia32_IDiv:
+		return x86_insn_div;
+	case iro_ia32_IMul:
+	case iro_ia32_IMul1OP:
+	case iro_ia32_IMulImm:
+	case iro_ia32_Mul:
+		return x86_insn_imul;
+	case iro_ia32_Rol:
+	case iro_ia32_Ror:
+	case iro_ia32_Sar:
+	case iro_ia32_Shl:
+	case iro_ia32_ShlD:
+	case iro_ia32_Shr:
+	case iro_ia32_ShrD:
+		return x86_insn_shift;
+	case iro_ia32_Lea:
+		return x86_insn_lea;
+	case iro_ia32_Load:
+	case iro_ia32_Pop:
+	case iro_ia32_fild:
+	case iro_ia32_fld:
+	case iro_ia32_xLoad:
+	case iro_ia32_xxLoad:
+		return x86_insn_load;
+	case iro_ia32_PopMem:
+	case iro_ia32_Push:
+	case iro_ia32_Store:
+	case iro_ia32_fist:
+	case iro_ia32_fistp:
+	case iro_ia32_fisttp:
+	case iro_ia32_fst:
+	case iro_ia32_fstp:
+	case iro_ia32_xStore:
+	case iro_ia32_xxStore:
+		return x86_insn_store;
+	case iro_ia32_Call:
+	case iro_ia32_IJmp:
+	case iro_ia32_Jcc:
+	case iro_ia32_Jmp:
+	case iro_ia32_Ret:
+	case iro_ia32_SwitchJmp:
+		return x86_insn_branch;
+	case iro_ia32_Adds:
+	case iro_ia32_Conv_FP2FP:
+	case iro_ia32_Conv_FP2I:
+	case iro_ia32_Conv_I2FP:
+	case iro_ia32_CvtSI2SD:
+	case iro_ia32_CvtSI2SS:
+	case iro_ia32_Maxs:
+	case iro_ia32_Mins:
+	case iro_ia32_Subs:
+	case iro_ia32_Ucomis:
+	case iro_ia32_fadd:
+	case iro_ia32_fsub:
+		return x86_insn_fp_add;
+	case iro_ia32_Muls:
+	case iro_ia32_fmul:
+		return x86_insn_fp_mul;
+	case iro_ia32_Divs:
+	case iro_ia32_fdiv:
+		return x86_insn_fp_div;
+	case iro_ia32_Andnp:
+	case iro_ia32_Andp:
+	case iro_ia32_Movd:
+	case iro_ia32_Orp:
+	case iro_ia32_Pslld:
+	case iro_ia32_Psllq:
+	case iro_ia32_Psrld:
+	case iro_ia32_Xorp:
+	case iro_ia32_xAllOnes:
+	case iro_ia32_xPzero:
+	case iro_ia32_xZero:
+		return x86_insn_fp_mov;
+	default:
+		return x86_insn_alu;
+	}
+}
+
+static unsigned ia32_get_sched_info(ir_node const *const node,
+                                    be_sched_info_t *const info)
+{
+	x86_machine_model const *const machine = ia32_cg_config.machine;
+	if (!is_ia32_irn(node)) {
+		x86_insn_timing const *const alu = &machine->insns[x86_insn_alu];
+		info->latency    = be_is_Keep(node) ? 0 : alu->latency;
+		info->throughput = alu->throughput;
+		info->ports      = alu->ports;
+		return machine->issue_width;
+	}
+
+	x86_insn_class         const cls    = ia32_get_insn_class(node);
+	x86_insn_timing const *const timing = &machine->insns[cls];
+	info->latency    = timing->latency;
+	info->throughput = timing->throughput;
+	info->ports      = timing->ports;
+	/* operations with a memory operand load it first */
+	if (cls != x86_insn_load && cls != x86_insn_store
+	    && get_ia32_op_type(node) != ia32_Normal)
+		info->latency += machine->insns[x86_insn_load].latency;
+	return machine->issue_width;
+}
+
 /**
  * Check if irn can load its operand at position i from memory (source addressmode).
  * @param irn    The irn to be checked
@@ -1672,6 +1778,7 @@ arch_isa_if_t const ia32_isa_if = {
 	.lower_for_target      = ia32_lower_for_target,
 	.additional_reg_names  = ia32_additional_reg_names,
 	.get_op_estimated_cost = ia32_get_op_estimated_cost,
+	.get_sched_info        = ia32_get_sched_info,
 };
 
 BE_REGISTER_MODULE_CONSTRUCTOR(be_init_arch_ia32)
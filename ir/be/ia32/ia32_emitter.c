@@ -587,7 +587,7 @@ x86_condition_code_t ia32_determine_final_cc(ir_node const *const node,
 static void ia32_emit_exc_label(const ir_node *node)
 {
 	be_emit_string(be_gas_insn_label_prefix());
-	be_emit_irprintf("%lu", get_ia32_exc_label_id(node));
+	be_emit_unsigned(get_ia32_exc_label_id(node));
 }
 
 static void emit_jmp(ir_node const *const node, ir_node const *const target)
@@ -1392,9 +1392,14 @@ static void emit_function_text(ir_graph *const irg, exc_entry **const exc_list)
 	irg_block_walk_graph(irg, ia32_gen_labels, NULL, exc_list);
 
 	be_emit_init_cf_links(blk_sched);
+	ir_node *const cold_block = be_gas_get_cold_block(irg);
+	if (cold_block != NULL)
+		be_emit_disable_fallthrough(cold_block);
 
 	for (size_t i = 0, n = ARR_LEN(blk_sched); i < n; ++i) {
 		ir_node *const block = blk_sched[i];
+		if (block == cold_block)
+			be_gas_begin_cold_code(get_irg_entity(irg));
 		ia32_gen_block(block);
 	}
 	ir_free_resources(irg, IR_RESOURCE_IRN_LINK);
@@ -1439,7 +1444,7 @@ static unsigned emit_jit_entity_relocation_asm(char *const buffer,
 	}
 	x86_emit_relocation_no_offset(be_kind, entity);
 	if (offset != 0)
-		be_emit_irprintf("%+"PRId32, offset);
+		be_emit_signed(offset, true);
 	be_emit_char('\n');
 	be_emit_write_line();
 	return res;
@@ -589,3 +589,192 @@ bool feature_flags(cpu_arch_features features, x86_cpu_features flags)
 {
 	return (features.features & flags) != 0;
 }
+
+#define P(n) (1u << (n))
+
+/* Latencies and reciprocal throughputs of 32bit operations with register
+ * operands, mostly from Agner Fog's instruction tables. The port numbers follow
+ * the vendor documentation of each microarchitecture. */
+
+/** Out-of-order core with a wide issue, used if nothing else is known. */
+static x86_machine_model const model_generic = {
+	.name        = "generic",
+	.issue_width = 4,
+	.insns = {
+		[x86_insn_alu]    = {  1,  1, P(0) | P(1) | P(2) },
+		[x86_insn_shift]  = {  1,  1, P(0) | P(2) },
+		[x86_insn_lea]    = {  1,  1, P(0) | P(1) },
+		[x86_insn_imul]   = {  3,  1, P(1) },
+		[x86_insn_div]    = { 26, 10, P(0) },
+		[x86_insn_load]   = {  4,  1, P(3) | P(4) },
+		[x86_insn_store]  = {  1,  1, P(5) },
+		[x86_insn_branch] = {  1,  1, P(2) },
+		[x86_insn_fp_add] = {  3,  1, P(1) },
+		[x86_insn_fp_mul] = {  5,  1, P(0) },
+		[x86_insn_fp_div] = { 20, 10, P(0) },
+		[x86_insn_fp_mov] = {  1,  1, P(0) | P(1) | P(2) },
+	},
+};
+
+/** In-order cores: i386 to Pentium, K6, Geode, Bonnell. */
+static x86_machine_model const model_inorder = {
+	.name        = "inorder",
+	.issue_width = 2,
+	.insns = {
+		[x86_insn_alu]    = {  1,  1, P(0) | P(1) },
+		[x86_insn_shift]  = {  1,  1, P(0) },
+		[x86_insn_lea]    = {  1,  1, P(1) },
+		[x86_insn_imul]   = {  5,  2, P(0) },
+		[x86_insn_div]    = { 50, 50, P(0) },
+		[x86_insn_load]   = {  3,  1, P(0) },
+		[x86_insn_store]  = {  1,  1, P(0) },
+		[x86_insn_branch] = {  1,  1, P(1) },
+		[x86_insn_fp_add] = {  5,  1, P(1) },
+		[x86_insn_fp_mul] = {  5,  2, P(0) },
+		[x86_insn_fp_div] = { 31, 31, P(0) },
+		[x86_insn_fp_mov] = {  1,  1, P(0) | P(1) },
+	},
+};
+
+/** Silvermont, Goldmont and Tremont. */
+static x86_machine_model const model_silvermont = {
+	.name        = "silvermont",
+	.issue_width = 2,
+	.insns = {
+		[x86_insn_alu]    = {  1,  1, P(0) | P(1) },
+		[x86_insn_shift]  = {  1,  1, P(0) },
+		[x86_insn_lea]    = {  1,  1, P(1) },
+		[x86_insn_imul]   = {  3,  1, P(0) },
+		[x86_insn_div]    = { 25, 25, P(0) },
+		[x86_insn_load]   = {  3,  1, P(2) },
+		[x86_insn_store]  = {  1,  1, P(2) },
+		[x86_insn_branch] = {  1,  1, P(1) },
+		[x86_insn_fp_add] = {  3,  1, P(4) },
+		[x86_insn_fp_mul] = {  5,  2, P(3) },
+		[x86_insn_fp_div] = { 27, 25, P(3) },
+		[x86_insn_fp_mov] = {  1,  1, P(3) | P(4) },
+	},
+};
+
+/** Core2 and Nehalem. */
+static x86_machine_model const model_core2 = {
+	.name        = "core2",
+	.issue_width = 4,
+	.insns = {
+		[x86_insn_alu]    = {  1,  1, P(0) | P(1) | P(5) },
+		[x86_insn_shift]  = {  1,  1, P(0) | P(5) },
+		[x86_insn_lea]    = {  1,  1, P(0) },
+		[x86_insn_imul]   = {  3,  1, P(1) },
+		[x86_insn_div]    = { 25, 20, P(0) },
+		[x86_insn_load]   = {  4,  1, P(2) },
+		[x86_insn_store]  = {  1,  1, P(3) | P(4) },
+		[x86_insn_branch] = {  1,  1, P(5) },
+		[x86_insn_fp_add] = {  3,  1, P(1) },
+		[x86_insn_fp_mul] = {  5,  1, P(0) },
+		[x86_insn_fp_div] = { 20, 14, P(0) },
+		[x86_insn_fp_mov] = {  1,  1, P(0) | P(1) | P(5) },
+	},
+};
+
+/** Sandy Bridge to Sunny Cove. */
+static x86_machine_model const model_sandybridge = {
+	.name        = "sandybridge",
+	.issue_width = 4,
+	.insns = {
+		[x86_insn_alu]    = {  1,  1, P(0) | P(1) | P(5) | P(6) },
+		[x86_insn_shift]  = {  1,  1, P(0) | P(6) },
+		[x86_insn_lea]    = {  1,  1, P(1) | P(5) },
+		[x86_insn_imul]   = {  3,  1, P(1) },
+		[x86_insn_div]    = { 26,  6, P(0) },
+		[x86_insn_load]   = {  5,  1, P(2) | P(3) },
+		[x86_insn_store]  = {  1,  1, P(4) },
+		[x86_insn_branch] = {  1,  1, P(0) | P(6) },
+		[x86_insn_fp_add] = {  4,  1, P(0) | P(1) },
+		[x86_insn_fp_mul] = {  4,  1, P(0) | P(1) },
+		[x86_insn_fp_div] = { 14,  4, P(0) },
+		[x86_insn_fp_mov] = {  1,  1, P(0) | P(1) | P(5) },
+	},
+};
+
+/** K8 and K10. */
+static x86_machine_model const model_k8 = {
+	.name        = "k8",
+	.issue_width = 3,
+	.insns = {
+		[x86_insn_alu]    = {  1,  1, P(0) | P(1) | P(2) },
+		[x86_insn_shift]  = {  1,  1, P(0) | P(1) | P(2) },
+		[x86_insn_lea]    = {  1,  1, P(0) | P(1) | P(2) },
+		[x86_insn_imul]   = {  3,  1, P(0) },
+		[x86_insn_div]    = { 40, 40, P(0) },
+		[x86_insn_load]   = {  3,  1, P(3) | P(4) },
+		[x86_insn_store]  = {  1,  1, P(3) | P(4) },
+		[x86_insn_branch] = {  1,  1, P(2) },
+		[x86_insn_fp_add] = {  4,  1, P(5) },
+		[x86_insn_fp_mul] = {  4,  1, P(6) },
+		[x86_insn_fp_div] = { 20, 17, P(6) },
+		[x86_insn_fp_mov] = {  2,  1, P(5) | P(6) | P(7) },
+	},
+};
+
+/** Bobcat, Bulldozer and Jaguar. */
+static x86_machine_model const model_bulldozer = {
+	.name        = "bulldozer",
+	.issue_width = 2,
+	.insns = {
+		[x86_insn_alu]    = {  1,  1, P(0) | P(1) },
+		[x86_insn_shift]  = {  1,  1, P(0) | P(1) },
+		[x86_insn_lea]    = {  1,  1, P(0) | P(1) },
+		[x86_insn_imul]   = {  4,  2, P(1) },
+		[x86_insn_div]    = { 40, 40, P(0) },
+		[x86_insn_load]   = {  4,  1, P(2) | P(3) },
+		[x86_insn_store]  = {  1,  1, P(2) | P(3) },
+		[x86_insn_branch] = {  1,  1, P(1) },
+		[x86_insn_fp_add] = {  5,  1, P(4) | P(5) },
+		[x86_insn_fp_mul] = {  5,  1, P(4) | P(5) },
+		[x86_insn_fp_div] = { 27, 20, P(4) | P(5) },
+		[x86_insn_fp_mov] = {  2,  1, P(4) | P(5) | P(6) | P(7) },
+	},
+};
+
+/** Zen to Zen 3. */
+static x86_machine_model const model_zen = {
+	.name        = "zen",
+	.issue_width = 5,
+	.insns = {
+		[x86_insn_alu]    = {  1,  1, P(0) | P(1) | P(2) | P(3) },
+		[x86_insn_shift]  = {  1,  1, P(1) | P(2) },
+		[x86_insn_lea]    = {  1,  1, P(0) | P(1) | P(2) | P(3) },
+		[x86_insn_imul]   = {  3,  1, P(1) },
+		[x86_insn_div]    = { 25, 15, P(2) },
+		[x86_insn_load]   = {  4,  1, P(4) | P(5) },
+		[x86_insn_store]  = {  1,  1, P(4) },
+		[x86_insn_branch] = {  1,  1, P(0) | P(3) },
+		[x86_insn_fp_add] = {  3,  1, P(8) | P(9) },
+		[x86_insn_fp_mul] = {  3,  1, P(6) | P(7) },
+		[x86_insn_fp_div] = { 13,  5, P(9) },
+		[x86_insn_fp_mov] = {  1,  1, P(6) | P(7) | P(8) | P(9) },
+	},
+};
+
+#undef P
+
+x86_machine_model const *x86_get_machine_model(cpu_arch_features features)
+{
+	if (arch_flags(features, arch_i386 | arch_i486 | arch_pentium | arch_atom
+	                       | arch_k6 | arch_geode))
+		return &model_inorder;
+	if (arch_flags(features, arch_atom_plus))
+		return &model_silvermont;
+	if (arch_flags(features, arch_ppro | arch_netburst | arch_nocona
+	                       | arch_core2 | arch_nehalem))
+		return &model_core2;
+	if (arch_flags(features, arch_core2_plus))
+		return &model_sandybridge;
+	if (arch_flags(features, arch_athlon | arch_k8 | arch_k10))
+		return &model_k8;
+	if (arch_flags(features, arch_amdfam14h | arch_amdfam15h | arch_amdfam16h))
+		return &model_bulldozer;
+	if (arch_flags(features, arch_amdfam17h | arch_amdfam19h))
+		return &model_zen;
+	return &model_generic;
+}
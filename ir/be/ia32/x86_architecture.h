@@ -194,4 +194,40 @@ bool arch_flags(cpu_arch_features arch_features, x86_cpu_architectures flags);
 
 bool feature_flags(cpu_arch_features arch_features, x86_cpu_features flags);
 
+/** Instruction classes with distinct timing in the machine models. */
+typedef enum x86_insn_class {
+	x86_insn_alu,    /**< simple integer arithmetic and moves */
+	x86_insn_shift,  /**< shifts and rotates */
+	x86_insn_lea,    /**< address computation */
+	x86_insn_imul,   /**< integer multiplication */
+	x86_insn_div,    /**< integer division */
+	x86_insn_load,   /**< load from memory */
+	x86_insn_store,  /**< store to memory */
+	x86_insn_branch, /**< jumps, calls and returns */
+	x86_insn_fp_add, /**< floating point and vector addition */
+	x86_insn_fp_mul, /**< floating point and vector multiplication */
+	x86_insn_fp_div, /**< floating point division */
+	x86_insn_fp_mov, /**< floating point and vector moves and logic */
+	x86_insn_max
+} x86_insn_class;
+
+/** Timing of an instruction class. */
+typedef struct x86_insn_timing {
+	unsigned char  latency;    /**< cycles until the result is available */
+	unsigned char  throughput; /**< cycles a port is busy */
+	unsigned short ports;      /**< bitset of the ports executing it */
+} x86_insn_timing;
+
+/** Machine model of a CPU microarchitecture used for scheduling. */
+typedef struct x86_machine_model {
+	const char      *name;
+	unsigned         issue_width; /**< instructions issued per cycle */
+	x86_insn_timing  insns[x86_insn_max];
+} x86_machine_model;
+
+/**
+ * Returns the machine model for the microarchitecture of @p arch_features.
+ */
+x86_machine_model const *x86_get_machine_model(cpu_arch_features arch_features);
+
 #endif
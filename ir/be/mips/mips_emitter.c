@@ -29,11 +29,11 @@ static void emit_immediate_val(char const *const prefix, ir_entity *const ent, i
 			be_emit_irprintf("%s(", prefix);
 		be_gas_emit_entity(ent);
 		if (val != 0)
-			be_emit_irprintf("%+" PRId32, val);
+			be_emit_signed(val, true);
 		if (prefix)
 			be_emit_char(')');
 	} else {
-		be_emit_irprintf("%" PRId32, val);
+		be_emit_signed(val, false);
 	}
 }
 
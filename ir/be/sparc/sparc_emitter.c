@@ -47,7 +47,7 @@ static bool emitting_delay_slot;
 static void sparc_emit_immediate(int32_t value, ir_entity *entity)
 {
 	if (entity == NULL) {
-		be_emit_irprintf("%"PRId32, value);
+		be_emit_signed(value, false);
 	} else {
 		if (is_tls_entity(entity)) {
 			be_emit_cstring("%tle_lox10(");
@@ -56,7 +56,7 @@ static void sparc_emit_immediate(int32_t value, ir_entity *entity)
 		}
 		be_gas_emit_entity(entity);
 		if (value != 0) {
-			be_emit_irprintf("%+"PRId32, value);
+			be_emit_signed(value, true);
 		}
 		be_emit_char(')');
 	}
@@ -69,7 +69,9 @@ static void sparc_emit_high_immediate(ir_node const *node)
 
 	if (entity == NULL) {
 		uint32_t value = (uint32_t) attr->immediate_value;
-		be_emit_irprintf("%%hi(0x%X)", value);
+		be_emit_cstring("%hi(0x");
+		be_emit_hex(value, 0, true);
+		be_emit_char(')');
 	} else {
 		if (is_tls_entity(entity)) {
 			be_emit_cstring("%tle_hix22(");
@@ -78,7 +80,7 @@ static void sparc_emit_high_immediate(ir_node const *node)
 		}
 		be_gas_emit_entity(entity);
 		if (attr->immediate_value != 0) {
-			be_emit_irprintf("%+"PRId32, attr->immediate_value);
+			be_emit_signed(attr->immediate_value, true);
 		}
 		be_emit_char(')');
 	}
@@ -119,7 +121,7 @@ static void sparc_emit_offset(const ir_node *node, int offset_node_pos)
 		int32_t offset = attr->base.immediate_value;
 		if (offset != 0) {
 			assert(sparc_is_value_imm_encodeable(offset));
-			be_emit_irprintf("%+"PRId32, offset);
+			be_emit_signed(offset, true);
 		}
 	} else if (attr->base.immediate_value != 0
 	           || attr->base.immediate_value_entity != NULL) {
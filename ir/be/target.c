@@ -14,6 +14,18 @@
 
 target_info_t ir_target;
 
+/** Continues the 64 bit FNV-1a hash @p hash with @p str and its
+ * terminator. */
+static uint64_t hash_str64(uint64_t hash, char const *const str)
+{
+	for (char const *c = str;; ++c) {
+		hash ^= (unsigned char)*c;
+		hash *= UINT64_C(1099511628211);
+		if (*c == '\0')
+			return hash;
+	}
+}
+
 int ir_target_set_triple(ir_machine_triple_t const *machine)
 {
 	memset(&ir_target, 0, sizeof(ir_target));
@@ -21,6 +33,12 @@ int ir_target_set_triple(ir_machine_triple_t const *machine)
 
 	const char *const cpu          = ir_triple_get_cpu_type(machine);
 	const char *const manufacturer = ir_triple_get_manufacturer(machine);
+	const char *const os           = ir_triple_get_operating_system(machine);
+	uint64_t triple_hash = UINT64_C(14695981039346656037);
+	triple_hash = hash_str64(triple_hash, cpu);
+	triple_hash = hash_str64(triple_hash, manufacturer);
+	triple_hash = hash_str64(triple_hash, os);
+	ir_target.triple_hash = triple_hash;
 	char          const *arch      = NULL;
 	arch_isa_if_t const *isa;
 	if (ir_is_cpu_x86_32(cpu)) {
@@ -13,14 +13,26 @@
 #include "iroptimize.h"
 #include <assert.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 #define ir_target_big_endian()   ir_target_big_endian_()
 
+/**
+ * Decides whether nodes of opcode @p op may be built in the vector mode
+ * @p mode for the current architecture.
+ */
+typedef bool (*arch_allow_vector_func)(ir_op const *op, ir_mode const *mode);
+
 typedef struct target_info_t {
 	arch_isa_if_t   const *isa;
 	char const            *experimental;
 	arch_allow_ifconv_func allow_ifconv;
 	ir_mode               *mode_float_arithmetic;
+	arch_allow_vector_func allow_vector;
+	/** Size of the vector registers in bytes, 0 if there are none. */
+	unsigned               vector_size;
+	/** 64 bit hash of the machine triple. */
+	uint64_t               triple_hash;
 	bool isa_initialized          : 1;
 	bool fast_unaligned_memaccess : 1;
 	ENUMBF(float_int_conversion_overflow_style_t) float_int_overflow : 2;
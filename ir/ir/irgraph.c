@@ -77,6 +77,8 @@ static void free_graph(ir_graph *irg)
 	for (ir_edge_kind_t i = EDGE_KIND_FIRST; i <= EDGE_KIND_LAST; ++i)
 		edges_deactivate_kind(irg, i);
 	DEL_ARR_F(irg->idx_irn_map);
+	if (irg->idx_loops != NULL)
+		DEL_ARR_F(irg->idx_loops);
 	free(irg);
 }
 
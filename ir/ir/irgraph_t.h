@@ -20,6 +20,7 @@
 #include "irloop.h"
 #include "irnodemap.h"
 #include "irprog.h"
+#include "irvaluetable.h"
 #include "list.h"
 #include "obst.h"
 #include "pset.h"
@@ -138,12 +139,14 @@ struct ir_graph {
 	ir_node *current_block;    /**< Block for new_*()ly created nodes. */
 
 	/** Hash table for global value numbering (CSE) */
-	pset               *value_table;
+	ir_valuetable_t    *value_table;
 	struct obstack      out_obst;    /**< Space for the Def-Use arrays. */
 	bool                out_obst_allocated;
+	union irn_outs_t   *idx_outs;    /**< Def-Use arrays by node index. */
 	ir_bitinfo          bitinfo;     /**< bit info */
 	ir_vrp_info         vrp;         /**< vrp info */
 	ir_loop            *loop;        /**< The outermost loop for this graph. */
+	ir_loop           **idx_loops;   /**< Loops of the blocks by node index. */
 	ir_dom_front_info_t domfront;    /**< dominance frontier analysis data */
 	irg_edges_info_t    edge_info;   /**< edge info for automatic outs */
 	ir_graph          **callers;     /**< Callgraph: list of callers. */
@@ -468,6 +471,11 @@ static inline void irg_kill_node(ir_graph *irg, ir_node *n)
 	if (idx + 1 == irg->last_node_idx)
 		--irg->last_node_idx;
 	irg->idx_irn_map[idx] = NULL;
+	/* the index is handed out again, do not leave stale side table data */
+	if (irg->idx_outs != NULL && idx < ARR_LEN(irg->idx_outs))
+		irg->idx_outs[idx].out = NULL;
+	if (irg->idx_loops != NULL && idx < ARR_LEN(irg->idx_loops))
+		irg->idx_loops[idx] = NULL;
 	obstack_free(&irg->obst, n);
 }
 
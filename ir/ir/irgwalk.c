@@ -24,52 +24,140 @@
 #include "irnodeset.h"
 #include "panic.h"
 #include "pset_new.h"
+#include "xmalloc.h"
 #include <stdlib.h>
+#include <string.h>
 
 /**
- * specialized version of irg_walk_2, called if only pre callback exists
+ * An entry of the explicit walker stack. It stands for a pending recursive
+ * invocation of a walker on @c node.
  */
-static void irg_walk_2_pre(ir_node *node, irg_walk_func *pre, void *env)
+typedef struct walk_frame_t {
+	ir_node *node;
+	int      pos;   /**< next predecessor to visit, see WALK_POS_* */
+} walk_frame_t;
+
+/** The block of the node has not been visited yet. */
+#define WALK_POS_BLOCK -2
+/** The block has been visited, the inputs have not been started. */
+#define WALK_POS_INS   -1
+
+/** Number of frames kept on the C stack before switching to the heap. */
+#define WALK_STACK_LOCAL 64
+
+typedef struct walk_stack_t {
+	walk_frame_t *frames;
+	size_t        len;
+	size_t        size;
+	walk_frame_t  local[WALK_STACK_LOCAL];
+} walk_stack_t;
+
+static void walk_stack_init(walk_stack_t *const stack)
 {
-	ir_graph    *irg     = get_irn_irg(node);
-	ir_visited_t visited = irg->visited;
-
-	set_irn_visited(node, visited);
+	stack->frames = stack->local;
+	stack->len    = 0;
+	stack->size   = WALK_STACK_LOCAL;
+}
 
-	pre(node, env);
+static void walk_stack_free(walk_stack_t *const stack)
+{
+	if (stack->frames != stack->local)
+		free(stack->frames);
+}
 
-	if (!is_Block(node)) {
-		ir_node *pred = get_nodes_block(node);
-		if (pred->visited < visited)
-			irg_walk_2_pre(pred, pre, env);
-	}
-	foreach_irn_in_r(node, i, pred) {
-		if (pred->visited < visited)
-			irg_walk_2_pre(pred, pre, env);
+static void walk_stack_grow(walk_stack_t *const stack)
+{
+	size_t const size = stack->size * 2;
+	if (stack->frames == stack->local) {
+		walk_frame_t *const frames = XMALLOCN(walk_frame_t, size);
+		memcpy(frames, stack->local, sizeof(stack->local));
+		stack->frames = frames;
+	} else {
+		stack->frames = XREALLOC(stack->frames, walk_frame_t, size);
 	}
+	stack->size = size;
+}
+
+static inline void walk_stack_push(walk_stack_t *const stack,
+                                   ir_node *const node, int const pos)
+{
+	if (stack->len == stack->size)
+		walk_stack_grow(stack);
+	walk_frame_t *const frame = &stack->frames[stack->len++];
+	frame->node = node;
+	frame->pos  = pos;
 }
 
 /**
- * specialized version of irg_walk_2, called if only post callback exists
+ * Walks the graph with an explicit stack instead of recursion. The visit
+ * order is the one of the recursive formulation: The block of a node is
+ * visited first, then the predecessors from the last to the first one. Inputs
+ * are read when they are reached, so callbacks may still change the inputs of
+ * nodes whose predecessors have not been visited yet.
+ *
+ * Called with constant @p pre or @p post, so the compiler can specialize it.
  */
-static void irg_walk_2_post(ir_node *node, irg_walk_func *post, void *env)
+static inline void irg_walk_2_iter(ir_node *const start,
+                                   irg_walk_func *const pre,
+                                   irg_walk_func *const post, void *const env)
 {
-	ir_graph    *irg     = get_irn_irg(node);
+	ir_graph    *irg     = get_irn_irg(start);
 	ir_visited_t visited = irg->visited;
 
-	set_irn_visited(node, visited);
+	walk_stack_t stack;
+	walk_stack_init(&stack);
 
-	if (!is_Block(node)) {
-		ir_node *pred = get_nodes_block(node);
-		if (pred->visited < visited)
-			irg_walk_2_post(pred, post, env);
-	}
-	foreach_irn_in_r(node, i, pred) {
-		if (pred->visited < visited)
-			irg_walk_2_post(pred, post, env);
+	set_irn_visited(start, visited);
+	if (pre != NULL)
+		pre(start, env);
+	walk_stack_push(&stack, start, WALK_POS_BLOCK);
+
+	while (stack.len > 0) {
+		walk_frame_t *const frame = &stack.frames[stack.len - 1];
+		ir_node      *const node  = frame->node;
+		ir_node            *pred;
+		if (frame->pos >= 1) {
+			pred = get_irn_n(node, --frame->pos);
+		} else if (frame->pos == WALK_POS_BLOCK) {
+			frame->pos = WALK_POS_INS;
+			if (is_Block(node))
+				continue;
+			pred = get_nodes_block(node);
+		} else if (frame->pos == WALK_POS_INS) {
+			frame->pos = get_irn_arity(node);
+			continue;
+		} else {
+			--stack.len;
+			if (post != NULL)
+				post(node, env);
+			continue;
+		}
+
+		if (pred->visited < visited) {
+			set_irn_visited(pred, visited);
+			if (pre != NULL)
+				pre(pred, env);
+			walk_stack_push(&stack, pred, WALK_POS_BLOCK);
+		}
 	}
 
-	post(node, env);
+	walk_stack_free(&stack);
+}
+
+/**
+ * specialized version of irg_walk_2, called if only pre callback exists
+ */
+static void irg_walk_2_pre(ir_node *node, irg_walk_func *pre, void *env)
+{
+	irg_walk_2_iter(node, pre, NULL, env);
+}
+
+/**
+ * specialized version of irg_walk_2, called if only post callback exists
+ */
+static void irg_walk_2_post(ir_node *node, irg_walk_func *post, void *env)
+{
+	irg_walk_2_iter(node, NULL, post, env);
 }
 
 /**
@@ -78,24 +166,7 @@ static void irg_walk_2_post(ir_node *node, irg_walk_func *post, void *env)
 static void irg_walk_2_both(ir_node *node, irg_walk_func *pre,
                                 irg_walk_func *post, void *env)
 {
-	ir_graph    *irg     = get_irn_irg(node);
-	ir_visited_t visited = irg->visited;
-
-	set_irn_visited(node, visited);
-
-	pre(node, env);
-
-	if (!is_Block(node)) {
-		ir_node *pred = get_nodes_block(node);
-		if (pred->visited < visited)
-			irg_walk_2_both(pred, pre, post, env);
-	}
-	foreach_irn_in_r(node, i, pred) {
-		if (pred->visited < visited)
-			irg_walk_2_both(pred, pre, post, env);
-	}
-
-	post(node, env);
+	irg_walk_2_iter(node, pre, post, env);
 }
 
 void irg_walk_2(ir_node *node, irg_walk_func *pre, irg_walk_func *post,
@@ -145,22 +216,7 @@ void all_irg_walk(irg_walk_func *pre, irg_walk_func *post, void *env)
 static void irg_walk_in_or_dep_2_pre(ir_node *node, irg_walk_func *pre,
                                      void *env)
 {
-	ir_graph    *irg     = get_irn_irg(node);
-	ir_visited_t visited = irg->visited;
-
-	set_irn_visited(node, visited);
-
-	pre(node, env);
-
-	if (!is_Block(node)) {
-		ir_node *pred = get_nodes_block(node);
-		if (pred->visited < visited)
-			irg_walk_in_or_dep_2_pre(pred, pre, env);
-	}
-	foreach_irn_in_r(node, i, pred) {
-		if (pred->visited < visited)
-			irg_walk_in_or_dep_2_pre(pred, pre, env);
-	}
+	irg_walk_2_iter(node, pre, NULL, env);
 }
 
 /**
@@ -169,22 +225,7 @@ static void irg_walk_in_or_dep_2_pre(ir_node *node, irg_walk_func *pre,
 static void irg_walk_in_or_dep_2_post(ir_node *node, irg_walk_func *post,
                                       void *env)
 {
-	ir_graph    *irg     = get_irn_irg(node);
-	ir_visited_t visited = irg->visited;
-
-	set_irn_visited(node, visited);
-
-	if (!is_Block(node)) {
-		ir_node *pred = get_nodes_block(node);
-		if (pred->visited < visited)
-			irg_walk_in_or_dep_2_post(pred, post, env);
-	}
-	foreach_irn_in_r(node, i, pred) {
-		if (pred->visited < visited)
-			irg_walk_in_or_dep_2_post(pred, post, env);
-	}
-
-	post(node, env);
+	irg_walk_2_iter(node, NULL, post, env);
 }
 
 /**
@@ -193,24 +234,7 @@ static void irg_walk_in_or_dep_2_post(ir_node *node, irg_walk_func *post,
 static void irg_walk_in_or_dep_2_both(ir_node *node, irg_walk_func *pre,
                                       irg_walk_func *post, void *env)
 {
-	ir_graph    *irg     = get_irn_irg(node);
-	ir_visited_t visited = irg->visited;
-
-	set_irn_visited(node, visited);
-
-	pre(node, env);
-
-	if (!is_Block(node)) {
-		ir_node *pred = get_nodes_block(node);
-		if (pred->visited < visited)
-			irg_walk_in_or_dep_2_both(pred, pre, post, env);
-	}
-	foreach_irn_in_r(node, i, pred) {
-		if (pred->visited < visited)
-			irg_walk_in_or_dep_2_both(pred, pre, post, env);
-	}
-
-	post(node, env);
+	irg_walk_2_iter(node, pre, post, env);
 }
 
 /**
@@ -245,45 +269,68 @@ void irg_walk_in_or_dep_graph(ir_graph *irg, irg_walk_func *pre,
 	irg_walk_in_or_dep(get_irg_end(irg), pre, post, env);
 }
 
-static void walk_topo_helper(ir_node *irn, ir_nodeset_t *walker_called, irg_walk_func *walker, void *env)
+static void walk_topo_call(ir_node *const irn, ir_nodeset_t *const walker_called,
+                           irg_walk_func *const walker, void *const env)
+{
+	if (!ir_nodeset_contains(walker_called, irn)) {
+		walker(irn, env);
+		ir_nodeset_insert(walker_called, irn);
+	}
+}
+
+/**
+ * Visits @p irn from a predecessor position: Either handles an already
+ * visited node right away or pushes a new frame for it.
+ */
+static void walk_topo_enter(walk_stack_t *const stack, ir_node *const irn,
+                            ir_nodeset_t *const walker_called,
+                            irg_walk_func *const walker, void *const env)
 {
 	if (irn_visited(irn)) {
-		if (!ir_nodeset_contains(walker_called, irn)) {
-			/* We have already visited this node, but not
-			 * yet called the walker with it. Now, we are
-			 * seeing it a second time, therefore we have
-			 * gone around a loop and are now seeing the
-			 * loop breaker. We must call the walker now
-			 * or the node one recursion above us will be
-			 * called before one of its arguments. */
-			walker(irn, env);
-			ir_nodeset_insert(walker_called, irn);
-		}
+		/* We have already visited this node, but maybe not yet called the
+		 * walker with it. Now, we are seeing it a second time, therefore we
+		 * have gone around a loop and are now seeing the loop breaker. We must
+		 * call the walker now or the node one level above us will be called
+		 * before one of its arguments. */
+		walk_topo_call(irn, walker_called, walker, env);
 		return;
 	}
 
-	/* Break loops at phi/block nodes. Mark them visited, so
-	 * recursion will stop, but don't call the walker yet. */
+	/* Break loops at phi/block nodes. Mark them visited, so the walk will
+	 * stop, but don't call the walker yet. */
 	const bool is_loop_breaker = is_Phi(irn) || is_Block(irn);
 	if (is_loop_breaker)
 		mark_irn_visited(irn);
 
-	if (!is_Block(irn)) {
-		ir_node *const block = get_nodes_block(irn);
-		walk_topo_helper(block, walker_called, walker, env);
-	}
-
-	for (int i = 0; i < get_irn_arity(irn); ++i) {
-		ir_node *const pred = get_irn_n(irn, i);
-		walk_topo_helper(pred, walker_called, walker, env);
-	}
+	walk_stack_push(stack, irn, WALK_POS_BLOCK);
+}
 
-	if (!ir_nodeset_contains(walker_called, irn)) {
-		walker(irn, env);
-		ir_nodeset_insert(walker_called, irn);
+static void walk_topo_helper(ir_node *start, ir_nodeset_t *walker_called, irg_walk_func *walker, void *env)
+{
+	walk_stack_t stack;
+	walk_stack_init(&stack);
+
+	walk_topo_enter(&stack, start, walker_called, walker, env);
+	while (stack.len > 0) {
+		walk_frame_t *const frame = &stack.frames[stack.len - 1];
+		ir_node      *const irn   = frame->node;
+		if (frame->pos == WALK_POS_BLOCK) {
+			frame->pos = 0;
+			if (!is_Block(irn)) {
+				ir_node *const block = get_nodes_block(irn);
+				walk_topo_enter(&stack, block, walker_called, walker, env);
+			}
+		} else if (frame->pos < get_irn_arity(irn)) {
+			ir_node *const pred = get_irn_n(irn, frame->pos++);
+			walk_topo_enter(&stack, pred, walker_called, walker, env);
+		} else {
+			--stack.len;
+			walk_topo_call(irn, walker_called, walker, env);
+			mark_irn_visited(irn);
+		}
 	}
 
-	mark_irn_visited(irn);
+	walk_stack_free(&stack);
 }
 
 void irg_walk_topological(ir_graph *irg, irg_walk_func *walker, void *env)
@@ -304,28 +351,45 @@ static ir_node *get_cf_op(ir_node *n)
 	return n;
 }
 
-static void irg_block_walk_2(ir_node *node, irg_walk_func *pre,
+static void irg_block_walk_2(ir_node *start, irg_walk_func *pre,
                              irg_walk_func *post, void *env)
 {
-	if (Block_block_visited(node))
+	if (Block_block_visited(start))
 		return;
-	mark_Block_block_visited(node);
+	mark_Block_block_visited(start);
 
 	if (pre != NULL)
-		pre(node, env);
+		pre(start, env);
+
+	walk_stack_t stack;
+	walk_stack_init(&stack);
+	walk_stack_push(&stack, start, get_Block_n_cfgpreds(start));
+
+	while (stack.len > 0) {
+		walk_frame_t *const frame = &stack.frames[stack.len - 1];
+		ir_node      *const node  = frame->node;
+		if (frame->pos == 0) {
+			--stack.len;
+			if (post != NULL)
+				post(node, env);
+			continue;
+		}
 
-	for (int i = get_Block_n_cfgpreds(node); i-- > 0; ) {
 		/* find the corresponding predecessor block. */
-		ir_node *pred_cfop  = get_cf_op(get_Block_cfgpred(node, i));
+		ir_node *pred_cfop = get_cf_op(get_Block_cfgpred(node, --frame->pos));
 		if (is_Bad(pred_cfop))
 			continue;
 		ir_node *pred_block = get_nodes_block(pred_cfop);
-		/* recursion */
-		irg_block_walk_2(pred_block, pre, post, env);
+		if (Block_block_visited(pred_block))
+			continue;
+		mark_Block_block_visited(pred_block);
+
+		if (pre != NULL)
+			pre(pred_block, env);
+		walk_stack_push(&stack, pred_block, get_Block_n_cfgpreds(pred_block));
 	}
 
-	if (post != NULL)
-		post(node, env);
+	walk_stack_free(&stack);
 }
 
 void irg_block_walk(ir_node *node, irg_walk_func *pre, irg_walk_func *post,
@@ -8,6 +8,8 @@
  * @brief   Write textual representation of firm to file.
  * @author  Moritz Kroll, Matthias Braun
  */
+/* fileno() is not part of C99 */
+#define _POSIX_C_SOURCE 200809L
 #include "irio_t.h"
 
 #include "array.h"
@@ -24,12 +26,44 @@
 #include "tv_t.h"
 #include "util.h"
 #include <ctype.h>
+#include <limits.h>
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
 
+#ifndef _WIN32
+#define HAVE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #define SYMERROR ((unsigned) ~0)
 
+/*
+ * The binary format writes the same elements as the textual one, but every
+ * token starts with a tag byte:
+ *
+ *  - BIN_NUMBER followed by a zigzag encoded LEB128 number
+ *  - BIN_STRING followed by the LEB128 index into the string table
+ *  - BIN_NULL
+ *  - '[', ']', '{', '}' and '\n' as in the textual format
+ *
+ * Nodes, types and entities are numbered with dense ids, so the reader can
+ * use arrays instead of hash tables. The index
+ * at the end of the file contains the string table and the location of all
+ * graphs, so that graphs can be read lazily.
+ */
+#define BIN_MAGIC        "\177FIRMIR"
+#define BIN_VERSION      2
+#define BIN_HEADER_SIZE  (sizeof(BIN_MAGIC) - 1 + 1)
+#define BIN_TRAILER_SIZE 8
+#define BIN_NUMBER       '#'
+#define BIN_STRING       '"'
+#define BIN_NULL         'N'
+
 typedef enum typetag_t {
 	tt_align,
 	tt_builtin_kind,
@@ -68,6 +102,7 @@ typedef enum keyword_t {
 	kw_type,
 	kw_typegraph,
 	kw_unknown,
+	kw_vector_mode,
 } keyword_t;
 
 typedef struct symbol_t {
@@ -219,6 +254,7 @@ static void symtbl_init(void)
 	INSERTKEYWORD(type);
 	INSERTKEYWORD(typegraph);
 	INSERTKEYWORD(unknown);
+	INSERTKEYWORD(vector_mode);
 
 	INSERTENUM(tt_align, align_non_aligned);
 	INSERTENUM(tt_align, align_is_aligned);
@@ -318,35 +354,125 @@ static unsigned symbol(const char *str, typetag_t typetag)
 	return entry ? entry->code : SYMERROR;
 }
 
+static void write_byte(write_env_t *env, int c)
+{
+	fputc(c, env->file);
+	++env->offset;
+}
+
+/** Writes an unsigned LEB128 number. */
+static void write_varint(write_env_t *env, unsigned long value)
+{
+	unsigned char buf[(sizeof(value) * CHAR_BIT + 6) / 7];
+	size_t        n = 0;
+	do {
+		unsigned char byte = value & 0x7F;
+		value >>= 7;
+		buf[n++] = byte | (value != 0 ? 0x80 : 0);
+	} while (value != 0);
+	fwrite(buf, 1, n, env->file);
+	env->offset += n;
+}
+
+/** Writes a reference to @p id into the string table of a binary file. */
+static void write_bin_string(write_env_t *env, ident *id)
+{
+	long nr = PTR_TO_INT(pmap_get(void, env->str_ids, id));
+	if (nr == 0) {
+		ARR_APP1(ident*, env->strings, id);
+		nr = ARR_LEN(env->strings);
+		pmap_insert(env->str_ids, id, INT_TO_PTR(nr));
+	}
+	write_byte(env, BIN_STRING);
+	write_varint(env, nr - 1);
+}
+
+/** Returns the binary file id of a type or entity. */
+static long get_bin_id(write_env_t *env, void const *obj)
+{
+	long nr = PTR_TO_INT(pmap_get(void, env->obj_ids, obj));
+	if (nr == 0) {
+		nr = ++env->n_objs;
+		pmap_insert(env->obj_ids, obj, INT_TO_PTR(nr));
+	}
+	return nr - 1;
+}
+
 void write_long(write_env_t *env, long value)
 {
+	if (env->binary) {
+		/* zigzag encoding keeps small negative numbers short */
+		unsigned long const zigzag = value < 0
+			? ~((unsigned long)value << 1) : (unsigned long)value << 1;
+		write_byte(env, BIN_NUMBER);
+		write_varint(env, zigzag);
+		return;
+	}
 	fprintf(env->file, "%ld ", value);
 }
 
 void write_int(write_env_t *env, int value)
 {
+	if (env->binary) {
+		write_long(env, value);
+		return;
+	}
 	fprintf(env->file, "%d ", value);
 }
 
 void write_unsigned(write_env_t *env, unsigned value)
 {
+	if (env->binary) {
+		write_long(env, (long)value);
+		return;
+	}
 	fprintf(env->file, "%u ", value);
 }
 
 void write_size_t(write_env_t *env, size_t value)
 {
+	if (env->binary) {
+		write_long(env, (long)value);
+		return;
+	}
 	ir_fprintf(env->file, "%zu ", value);
 }
 
 void write_symbol(write_env_t *env, const char *symbol)
 {
+	if (env->binary) {
+		write_bin_string(env, new_id_from_str(symbol));
+		return;
+	}
 	fputs(symbol, env->file);
 	fputc(' ', env->file);
 }
 
+/** Starts a new line of the output (ends a record in the binary format). */
+static void write_newline(write_env_t *env)
+{
+	if (env->binary) {
+		write_byte(env, '\n');
+		return;
+	}
+	fputc('\n', env->file);
+}
+
+static void write_indent(write_env_t *env)
+{
+	if (!env->binary)
+		fputc('\t', env->file);
+}
+
+/** Writes the number of a type or entity definition. */
+static void write_obj_nr(write_env_t *env, void const *obj, long nr)
+{
+	write_long(env, env->binary ? get_bin_id(env, obj) : nr);
+}
+
 void write_entity_ref(write_env_t *env, ir_entity *entity)
 {
-	write_long(env, get_entity_nr(entity));
+	write_obj_nr(env, entity, get_entity_nr(entity));
 }
 
 void write_type_ref(write_env_t *env, ir_type *type)
@@ -361,11 +487,15 @@ void write_type_ref(write_env_t *env, ir_type *type)
 	default:
 		break;
 	}
-	write_long(env, get_type_nr(type));
+	write_obj_nr(env, type, get_type_nr(type));
 }
 
 void write_string(write_env_t *env, const char *string)
 {
+	if (env->binary) {
+		write_bin_string(env, new_id_from_str(string));
+		return;
+	}
 	fputc('"', env->file);
 	for (const char *c = string; *c != '\0'; ++c) {
 		switch (*c) {
@@ -388,13 +518,20 @@ void write_string(write_env_t *env, const char *string)
 
 void write_ident(write_env_t *env, ident *id)
 {
+	if (env->binary) {
+		write_bin_string(env, id);
+		return;
+	}
 	write_string(env, get_id_str(id));
 }
 
 void write_ident_null(write_env_t *env, ident *id)
 {
 	if (id == NULL) {
-		fputs("NULL ", env->file);
+		if (env->binary)
+			write_byte(env, BIN_NULL);
+		else
+			fputs("NULL ", env->file);
 	} else {
 		write_ident(env, id);
 	}
@@ -411,26 +548,22 @@ void write_tarval_ref(write_env_t *env, ir_tarval *tv)
 	write_mode_ref(env, mode);
 	char buf[128];
 	const char *ascii = ir_tarval_to_ascii(buf, sizeof(buf), tv);
-	fputs(ascii, env->file);
-	fputc(' ', env->file);
+	write_symbol(env, ascii);
 }
 
 void write_align(write_env_t *env, ir_align align)
 {
-	fputs(get_align_name(align), env->file);
-	fputc(' ', env->file);
+	write_symbol(env, get_align_name(align));
 }
 
 void write_builtin_kind(write_env_t *env, ir_builtin_kind kind)
 {
-	fputs(get_builtin_kind_name(kind), env->file);
-	fputc(' ', env->file);
+	write_symbol(env, get_builtin_kind_name(kind));
 }
 
 void write_cond_jmp_predicate(write_env_t *env, cond_jmp_predicate pred)
 {
-	fputs(get_cond_jmp_predicate_name(pred), env->file);
-	fputc(' ', env->file);
+	write_symbol(env, get_cond_jmp_predicate_name(pred));
 }
 
 void write_relation(write_env_t *env, ir_relation relation)
@@ -450,37 +583,64 @@ void write_loop(write_env_t *env, bool loop)
 
 static void write_list_begin(write_env_t *env)
 {
-	fputs("[", env->file);
+	if (env->binary)
+		write_byte(env, '[');
+	else
+		fputs("[", env->file);
 }
 
 static void write_list_end(write_env_t *env)
 {
-	fputs("] ", env->file);
+	if (env->binary)
+		write_byte(env, ']');
+	else
+		fputs("] ", env->file);
 }
 
 static void write_scope_begin(write_env_t *env)
 {
-	fputs("{\n", env->file);
+	if (env->binary)
+		write_byte(env, '{');
+	else
+		fputs("{\n", env->file);
 }
 
 static void write_scope_end(write_env_t *env)
 {
-	fputs("}\n\n", env->file);
+	if (env->binary)
+		write_byte(env, '}');
+	else
+		fputs("}\n\n", env->file);
+}
+
+/**
+ * Returns the id of a node in the binary format. The ids are handed out in
+ * the order of the first reference, so they are dense and bounded by the
+ * number of node records of the graph.
+ */
+static long get_bin_node_id(write_env_t *env, const ir_node *node)
+{
+	bin_node_ids_t *const ids = get_irn_irg(node) == get_const_code_irg()
+	                            ? &env->const_nodes : &env->nodes;
+	unsigned const idx = get_irn_idx(node);
+	assert(idx < ARR_LEN(ids->ids));
+	if (ids->ids[idx] == 0)
+		ids->ids[idx] = ++ids->n_ids;
+	return ids->ids[idx] - 1;
 }
 
 void write_node_ref(write_env_t *env, const ir_node *node)
 {
-	write_long(env, get_irn_node_nr(node));
+	write_long(env, env->binary ? get_bin_node_id(env, node)
+	                            : get_irn_node_nr(node));
 }
 
 void write_initializer(write_env_t *const env,
                        ir_initializer_t const *const ini)
 {
-	FILE *f = env->file;
 	ir_initializer_kind_t ini_kind = get_initializer_kind(ini);
 
-	fputs(get_initializer_kind_name(ini_kind), f);
-	fputc(' ', f);
+	write_symbol(env, get_initializer_kind_name(ini_kind));
 
 	switch (ini_kind) {
 	case IR_INITIALIZER_CONST:
@@ -507,39 +667,38 @@ void write_initializer(write_env_t *const env,
 
 void write_pin_state(write_env_t *env, op_pin_state state)
 {
-	fputs(get_op_pin_state_name(state), env->file);
-	fputc(' ', env->file);
+	write_symbol(env, get_op_pin_state_name(state));
 }
 
 void write_volatility(write_env_t *env, ir_volatility vol)
 {
-	fputs(get_volatility_name(vol), env->file);
-	fputc(' ', env->file);
+	write_symbol(env, get_volatility_name(vol));
 }
 
 static void write_type_state(write_env_t *env, ir_type_state state)
 {
-	fputs(get_type_state_name(state), env->file);
-	fputc(' ', env->file);
+	write_symbol(env, get_type_state_name(state));
 }
 
 void write_visibility(write_env_t *env, ir_visibility visibility)
 {
-	fputs(get_visibility_name(visibility), env->file);
-	fputc(' ', env->file);
+	write_symbol(env, get_visibility_name(visibility));
 }
 
 static void write_mode_arithmetic(write_env_t *env, ir_mode_arithmetic arithmetic)
 {
-	fputs(get_mode_arithmetic_name(arithmetic), env->file);
-	fputc(' ', env->file);
+	write_symbol(env, get_mode_arithmetic_name(arithmetic));
 }
 
 static void write_type_common(write_env_t *env, ir_type *tp)
 {
-	fputc('\t', env->file);
+	write_indent(env);
 	write_symbol(env, "type");
-	write_long(env, get_type_nr(tp));
+	write_obj_nr(env, tp, get_type_nr(tp));
+	/* the importer recognizes the types created by ir_init() by their
+	 * number */
+	if (env->binary)
+		write_long(env, get_type_nr(tp));
 	write_symbol(env, get_type_opcode_name(get_type_opcode(tp)));
 	write_unsigned(env, get_type_size(tp));
 	write_unsigned(env, get_type_alignment(tp));
@@ -552,7 +711,7 @@ static void write_type(write_env_t *env, ir_type *tp);
 static bool is_internal_mode(ir_mode *mode)
 {
 	return !mode_is_int(mode) && !mode_is_reference(mode)
-	    && !mode_is_float(mode);
+	    && !mode_is_float(mode) && !mode_is_vector(mode);
 }
 
 static bool is_default_mode(ir_mode *mode)
@@ -571,7 +730,7 @@ static void write_type_primitive(write_env_t *env, ir_type *tp)
 
 	write_type_common(env, tp);
 	write_mode_ref(env, mode);
-	fputc('\n', env->file);
+	write_newline(env);
 }
 
 static void write_type_compound(write_env_t *env, ir_type *tp)
@@ -585,7 +744,7 @@ static void write_type_compound(write_env_t *env, ir_type *tp)
 	}
 	write_type_common(env, tp);
 	write_ident_null(env, get_compound_ident(tp));
-	fputc('\n', env->file);
+	write_newline(env);
 
 	for (size_t i = 0, n = get_compound_n_members(tp); i < n; ++i) {
 		ir_entity *member = get_compound_member(tp, i);
@@ -601,7 +760,7 @@ static void write_type_array(write_env_t *env, ir_type *tp)
 	write_type_common(env, tp);
 	write_type_ref(env, element_type);
 	write_unsigned(env, get_array_size(tp));
-	fputc('\n', env->file);
+	write_newline(env);
 }
 
 static void write_type_method(write_env_t *env, ir_type *tp)
@@ -623,7 +782,7 @@ static void write_type_method(write_env_t *env, ir_type *tp)
 		write_type_ref(env, get_method_param_type(tp, i));
 	for (size_t i = 0; i < nresults; i++)
 		write_type_ref(env, get_method_res_type(tp, i));
-	fputc('\n', env->file);
+	write_newline(env);
 }
 
 static void write_type_pointer(write_env_t *env, ir_type *tp)
@@ -634,7 +793,7 @@ static void write_type_pointer(write_env_t *env, ir_type *tp)
 
 	write_type_common(env, tp);
 	write_type_ref(env, points_to);
-	fputc('\n', env->file);
+	write_newline(env);
 }
 
 static void write_type(write_env_t *env, ir_type *tp)
@@ -683,7 +842,7 @@ static void write_entity(write_env_t *env, ir_entity *ent)
 		write_entity(env, aliased);
 	}
 
-	fputc('\t', env->file);
+	write_indent(env);
 	switch ((ir_entity_kind)ent->kind) {
 	case IR_ENTITY_ALIAS:           write_symbol(env, "alias");           break;
 	case IR_ENTITY_NORMAL:          write_symbol(env, "entity");          break;
@@ -693,12 +852,12 @@ static void write_entity(write_env_t *env, ir_entity *ent)
 	case IR_ENTITY_PARAMETER:       write_symbol(env, "parameter");       break;
 	case IR_ENTITY_UNKNOWN:
 		write_symbol(env, "unknown");
-		write_long(env, get_entity_nr(ent));
+		write_obj_nr(env, ent, get_entity_nr(ent));
 		goto end_line;
 	case IR_ENTITY_SPILLSLOT:
 		panic("Unexpected entity %+F", ent); // Should only exist in backend
 	}
-	write_long(env, get_entity_nr(ent));
+	write_obj_nr(env, ent, get_entity_nr(ent));
 
 	if (ent->kind != IR_ENTITY_LABEL && ent->kind != IR_ENTITY_PARAMETER) {
 		write_ident_null(env, get_entity_ident(ent));
@@ -771,7 +930,7 @@ static void write_entity(write_env_t *env, ir_entity *ent)
 	}
 
 end_line:
-	fputc('\n', env->file);
+	write_newline(env);
 }
 
 void write_switch_table_ref(write_env_t *env, const ir_switch_table *table)
@@ -802,7 +961,7 @@ void write_pred_refs(write_env_t *env, const ir_node *node, int from)
 
 void write_node_nr(write_env_t *env, const ir_node *node)
 {
-	write_long(env, get_irn_node_nr(node));
+	write_node_ref(env, node);
 }
 
 static void write_ASM(write_env_t *env, const ir_node *node)
@@ -890,11 +1049,11 @@ static void write_node(const ir_node *node, write_env_t *env)
 	ir_op           *const op   = get_irn_op(node);
 	write_node_func *const func = get_generic_function_ptr(write_node_func, op);
 
-	fputc('\t', env->file);
+	write_indent(env);
 	if (func == NULL)
 		panic("no write_node_func for %+F", node);
 	func(env, node);
-	fputc('\n', env->file);
+	write_newline(env);
 }
 
 static void write_node_recursive(ir_node *node, write_env_t *env);
@@ -957,6 +1116,10 @@ static void write_mode(write_env_t *env, ir_mode *mode)
 		write_unsigned(env, get_mode_exponent_size(mode));
 		write_unsigned(env, get_mode_mantissa_size(mode));
 		write_unsigned(env, get_mode_float_int_overflow(mode));
+	} else if (mode_is_vector(mode)) {
+		write_symbol(env, "vector_mode");
+		write_mode_ref(env, get_mode_vector_element_mode(mode));
+		write_unsigned(env, get_mode_n_vector_elements(mode));
 	} else {
 		panic("cannot write internal modes");
 	}
@@ -965,18 +1128,18 @@ static void write_mode(write_env_t *env, ir_mode *mode)
 static void write_modes(write_env_t *env)
 {
 	write_symbol(env, "modes");
-	fputs("{\n", env->file);
+	write_scope_begin(env);
 
 	for (size_t i = 0, n_modes = ir_get_n_modes(); i < n_modes; i++) {
 		ir_mode *mode = ir_get_mode(i);
 		if (is_internal_mode(mode))
 			continue;
-		fputc('\t', env->file);
+		write_indent(env);
 		write_mode(env, mode);
-		fputc('\n', env->file);
+		write_newline(env);
 	}
 
-	fputs("}\n\n", env->file);
+	write_scope_end(env);
 }
 
 static void write_program(write_env_t *env)
@@ -984,15 +1147,15 @@ static void write_program(write_env_t *env)
 	write_symbol(env, "program");
 	write_scope_begin(env);
 	if (irp_prog_name_is_set()) {
-		fputc('\t', env->file);
+		write_indent(env);
 		write_symbol(env, "name");
 		write_string(env, get_irp_name());
-		fputc('\n', env->file);
+		write_newline(env);
 	}
 
 	for (ir_segment_t s = IR_SEGMENT_FIRST; s <= IR_SEGMENT_LAST; ++s) {
 		ir_type *segment_type = get_segment_type(s);
-		fputc('\t', env->file);
+		write_indent(env);
 		write_symbol(env, "segment_type");
 		write_symbol(env, get_segment_name(s));
 		if (segment_type == NULL) {
@@ -1000,15 +1163,15 @@ static void write_program(write_env_t *env)
 		} else {
 			write_type_ref(env, segment_type);
 		}
-		fputc('\n', env->file);
+		write_newline(env);
 	}
 
 	for (size_t i = 0, n_asms = get_irp_n_asms(); i < n_asms; ++i) {
 		ident *asm_text = get_irp_asm(i);
-		fputc('\t', env->file);
+		write_indent(env);
 		write_symbol(env, "asm");
 		write_ident(env, asm_text);
-		fputc('\n', env->file);
+		write_newline(env);
 	}
 	write_scope_end(env);
 }
@@ -1057,6 +1220,14 @@ static void write_typegraph(write_env_t *env)
 static void write_irg(write_env_t *env, ir_graph *irg)
 {
 	write_symbol(env, "irg");
+	bin_irg_entry_t entry = {
+		.entity = env->binary ? get_bin_id(env, get_irg_entity(irg)) : 0,
+		.begin  = env->offset,
+	};
+	if (env->binary) {
+		env->nodes.ids   = NEW_ARR_FZ(long, get_irg_last_idx(irg));
+		env->nodes.n_ids = 0;
+	}
 	write_entity_ref(env, get_irg_entity(irg));
 	write_type_ref(env, get_irg_frame_type(irg));
 	write_scope_begin(env);
@@ -1070,16 +1241,18 @@ static void write_irg(write_env_t *env, ir_graph *irg)
 	} while (!deq_empty(&env->write_queue));
 	ir_free_resources(irg, IR_RESOURCE_IRN_VISITED);
 	write_scope_end(env);
+
+	if (env->binary) {
+		entry.end     = env->offset;
+		entry.n_nodes = env->nodes.n_ids;
+		ARR_APP1(bin_irg_entry_t, env->irgs, entry);
+		DEL_ARR_F(env->nodes.ids);
+		env->nodes.ids = NULL;
+	}
 }
 
-/* Exports the whole irp to the given file in a textual form. */
-void ir_export_file(FILE *file)
+static void write_irp(write_env_t *env)
 {
-	write_env_t my_env;
-	write_env_t *env = &my_env;
-
-	memset(env, 0, sizeof(*env));
-	env->file         = file;
 	deq_init(&env->write_queue);
 	deq_init(&env->entity_queue);
 
@@ -1104,16 +1277,135 @@ void ir_export_file(FILE *file)
 	deq_free(&env->write_queue);
 }
 
+/* Exports the whole irp to the given file in a textual form. */
+void ir_export_file(FILE *file)
+{
+	write_env_t env;
+	memset(&env, 0, sizeof(env));
+	env.file = file;
+	write_irp(&env);
+}
+
+/**
+ * Writes the index of a binary file: the string table, the number of type and
+ * entity ids and the location of the graphs. The file ends with the offset of
+ * the index.
+ */
+static void write_bin_index(write_env_t *env)
+{
+	uint64_t const index = env->offset;
+
+	size_t const n_strings = ARR_LEN(env->strings);
+	write_varint(env, n_strings);
+	for (size_t i = 0; i < n_strings; ++i) {
+		char const *const str = get_id_str(env->strings[i]);
+		size_t      const len = strlen(str);
+		write_varint(env, len);
+		/* include the terminating 0 so the reader can use the string
+		 * in place */
+		fwrite(str, 1, len + 1, env->file);
+		env->offset += len + 1;
+	}
+
+	write_varint(env, env->n_objs);
+
+	size_t const n_irgs = ARR_LEN(env->irgs);
+	write_varint(env, n_irgs);
+	for (size_t i = 0; i < n_irgs; ++i) {
+		bin_irg_entry_t const *const entry = &env->irgs[i];
+		write_varint(env, entry->entity);
+		write_varint(env, entry->begin);
+		write_varint(env, entry->end);
+		write_varint(env, entry->n_nodes);
+	}
+
+	for (unsigned i = 0; i < BIN_TRAILER_SIZE; ++i)
+		write_byte(env, (index >> (i * 8)) & 0xFF);
+}
+
+void ir_export_binary_file(FILE *file)
+{
+	write_env_t env;
+	memset(&env, 0, sizeof(env));
+	env.file    = file;
+	env.binary  = true;
+	env.obj_ids = pmap_create();
+	env.str_ids = pmap_create();
+	env.strings = NEW_ARR_F(ident*, 0);
+	env.irgs    = NEW_ARR_F(bin_irg_entry_t, 0);
+	env.const_nodes.ids
+		= NEW_ARR_FZ(long, get_irg_last_idx(get_const_code_irg()));
+
+	fwrite(BIN_MAGIC, 1, sizeof(BIN_MAGIC) - 1, file);
+	env.offset = sizeof(BIN_MAGIC) - 1;
+	write_byte(&env, BIN_VERSION);
+
+	write_irp(&env);
+	write_bin_index(&env);
+
+	DEL_ARR_F(env.const_nodes.ids);
+	DEL_ARR_F(env.irgs);
+	DEL_ARR_F(env.strings);
+	pmap_destroy(env.str_ids);
+	pmap_destroy(env.obj_ids);
+}
+
+int ir_export_binary(const char *filename)
+{
+	FILE *file = fopen(filename, "wb");
+	if (file == NULL) {
+		perror(filename);
+		return 1;
+	}
+
+	ir_export_binary_file(file);
+	int res = ferror(file);
+	fclose(file);
+	return res;
+}
+
 
 
 static void read_c(read_env_t *env)
 {
-	int c = fgetc(env->file);
+	int c;
+	if (env->binary) {
+		c = env->pos < env->end ? *env->pos++ : EOF;
+	} else {
+		c = fgetc(env->file);
+	}
 	env->c = c;
 	if (c == '\n')
 		env->line++;
 }
 
+/**
+ * Reads an LEB128 number of the binary format. The tag of the token must
+ * already have been read.
+ */
+static unsigned long read_varint(read_env_t *env)
+{
+	unsigned long res = 0;
+	for (unsigned shift = 0; env->pos < env->end; shift += 7) {
+		if (shift >= sizeof(res) * CHAR_BIT)
+			break;
+		unsigned char const byte = *env->pos++;
+		res |= (unsigned long)(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0)
+			return res;
+	}
+	parse_error(env, "Invalid number\n");
+	exit(1);
+}
+
+/** Skips a token of the binary format. */
+static void skip_bin_token(read_env_t *env)
+{
+	if (env->c == BIN_NUMBER || env->c == BIN_STRING)
+		(void)read_varint(env);
+	read_c(env);
+}
+
 /** Returns the first non-whitespace character or EOF. **/
 static void skip_ws(read_env_t *env)
 {
@@ -1135,7 +1427,10 @@ static void skip_ws(read_env_t *env)
 static void skip_to(read_env_t *env, char to_ch)
 {
 	while (env->c != to_ch && env->c != EOF) {
-		read_c(env);
+		if (env->binary)
+			skip_bin_token(env);
+		else
+			read_c(env);
 	}
 }
 
@@ -1153,8 +1448,50 @@ static bool expect_char(read_env_t *env, char ch)
 
 #define EXPECT(c) if (expect_char(env, (c))) {} else return
 
+/** Reads a string token of the binary format. */
+static bin_string_t *read_bin_string(read_env_t *env)
+{
+	skip_ws(env);
+	if (env->c != BIN_STRING) {
+		parse_error(env, "Expected string, got '%c'\n", env->c);
+		exit(1);
+	}
+	unsigned long const nr = read_varint(env);
+	if (nr >= env->n_strings) {
+		parse_error(env, "Invalid string %lu\n", nr);
+		exit(1);
+	}
+	read_c(env);
+	return &env->strings[nr];
+}
+
+static ident *get_bin_string_ident(bin_string_t *string)
+{
+	if (string->id == NULL)
+		string->id = new_id_from_str(string->str);
+	return string->id;
+}
+
+static char *copy_bin_string(read_env_t *env)
+{
+	char const *const str = read_bin_string(env)->str;
+	return (char*)obstack_copy0(&env->obst, str, strlen(str));
+}
+
+/** Returns true if the next token is a number. */
+static bool at_number(read_env_t *env)
+{
+	skip_ws(env);
+	if (env->binary)
+		return env->c == BIN_NUMBER;
+	return isdigit(env->c) || env->c == '-';
+}
+
 static char *read_word(read_env_t *env)
 {
+	if (env->binary)
+		return copy_bin_string(env);
+
 	skip_ws(env);
 
 	assert(obstack_object_size(&env->obst) == 0);
@@ -1182,6 +1519,9 @@ endofword:
 
 static char *read_string(read_env_t *env)
 {
+	if (env->binary)
+		return copy_bin_string(env);
+
 	skip_ws(env);
 	if (env->c != '"') {
 		parse_error(env, "Expected string, got '%c'\n", env->c);
@@ -1223,6 +1563,9 @@ static char *read_string(read_env_t *env)
 
 static ident *read_ident(read_env_t *env)
 {
+	if (env->binary)
+		return get_bin_string_ident(read_bin_string(env));
+
 	char  *str = read_string(env);
 	ident *res = new_id_from_str(str);
 	obstack_free(&env->obst, str);
@@ -1231,6 +1574,9 @@ static ident *read_ident(read_env_t *env)
 
 static ident *read_symbol(read_env_t *env)
 {
+	if (env->binary)
+		return get_bin_string_ident(read_bin_string(env));
+
 	char  *str = read_word(env);
 	ident *res = new_id_from_str(str);
 	obstack_free(&env->obst, str);
@@ -1243,6 +1589,13 @@ static ident *read_symbol(read_env_t *env)
 static char *read_string_null(read_env_t *env)
 {
 	skip_ws(env);
+	if (env->binary) {
+		if (env->c == BIN_NULL) {
+			read_c(env);
+			return NULL;
+		}
+		return read_string(env);
+	}
 	if (env->c == 'N') {
 		char *str = read_word(env);
 		if (streq(str, "NULL")) {
@@ -1259,6 +1612,15 @@ static char *read_string_null(read_env_t *env)
 
 static ident *read_ident_null(read_env_t *env)
 {
+	if (env->binary) {
+		skip_ws(env);
+		if (env->c == BIN_NULL) {
+			read_c(env);
+			return NULL;
+		}
+		return read_ident(env);
+	}
+
 	char *str = read_string_null(env);
 	if (str == NULL)
 		return NULL;
@@ -1271,6 +1633,15 @@ static ident *read_ident_null(read_env_t *env)
 static long read_long(read_env_t *env)
 {
 	skip_ws(env);
+	if (env->binary) {
+		if (env->c != BIN_NUMBER) {
+			parse_error(env, "Expected number, got '%c'\n", env->c);
+			exit(1);
+		}
+		unsigned long const zigzag = read_varint(env);
+		read_c(env);
+		return zigzag & 1 ? (long)~(zigzag >> 1) : (long)(zigzag >> 1);
+	}
 	if (!isdigit(env->c) && env->c != '-') {
 		parse_error(env, "Expected number, got '%c'\n", env->c);
 		exit(1);
@@ -1318,11 +1689,11 @@ static void expect_list_begin(read_env_t *env)
 
 static bool list_has_next(read_env_t *env)
 {
-	if (feof(env->file)) {
+	skip_ws(env);
+	if (env->c == EOF) {
 		parse_error(env, "Unexpected EOF while reading list");
 		exit(1);
 	}
-	skip_ws(env);
 	if (env->c == ']') {
 		read_c(env);
 		return false;
@@ -1333,6 +1704,12 @@ static bool list_has_next(read_env_t *env)
 
 static void *get_id(read_env_t *env, long id)
 {
+	if (env->binary) {
+		if (id < 0 || (size_t)id >= ARR_LEN(env->objs))
+			return NULL;
+		return env->objs[id];
+	}
+
 	id_entry key;
 	key.id = id;
 
@@ -1343,14 +1720,52 @@ static void *get_id(read_env_t *env, long id)
 
 static void set_id(read_env_t *env, long id, void *elem)
 {
+	if (env->binary) {
+		if (id < 0 || (size_t)id >= ARR_LEN(env->objs)) {
+			parse_error(env, "Invalid id %ld\n", id);
+			return;
+		}
+		/* like set_insert() the first definition wins */
+		if (env->objs[id] == NULL)
+			env->objs[id] = elem;
+		return;
+	}
+
 	id_entry key;
 	key.id   = id;
 	key.elem = elem;
 	(void)set_insert(id_entry, env->idset, &key, sizeof(key), (unsigned) id);
 }
 
+static void set_node(read_env_t *env, long nodenr, ir_node *node)
+{
+	if (!env->binary) {
+		set_id(env, nodenr, node);
+		return;
+	}
+
+	if (nodenr < 0 || (size_t)nodenr >= env->max_nodes) {
+		parse_error(env, "Invalid node id %ld\n", nodenr);
+		return;
+	}
+	size_t const len = ARR_LEN(env->nodes);
+	if ((size_t)nodenr >= len) {
+		ARR_RESIZE(ir_node*, env->nodes, nodenr + 1);
+		memset(&env->nodes[len], 0, (nodenr + 1 - len) * sizeof(env->nodes[0]));
+	}
+	if (env->nodes[nodenr] == NULL)
+		env->nodes[nodenr] = node;
+}
+
 static ir_node *get_node_or_null(read_env_t *env, long nodenr)
 {
+	if (env->binary) {
+		if (env->nodes == NULL || nodenr < 0
+		 || (size_t)nodenr >= ARR_LEN(env->nodes))
+			return NULL;
+		return env->nodes[nodenr];
+	}
+
 	ir_node *node = (ir_node *) get_id(env, nodenr);
 	if (node && node->kind != k_ir_node) {
 		parse_error(env, "Irn ID %ld collides with something else\n",
@@ -1376,18 +1791,21 @@ static ir_type *get_type(read_env_t *env, long typenr)
 
 ir_type *read_type_ref(read_env_t *env)
 {
-	char *str = read_word(env);
+	if (at_number(env))
+		return get_type(env, read_long(env));
+
+	char    *str = read_word(env);
+	ir_type *res;
 	if (streq(str, "unknown")) {
-		obstack_free(&env->obst, str);
-		return get_unknown_type();
+		res = get_unknown_type();
 	} else if (streq(str, "code")) {
-		obstack_free(&env->obst, str);
-		return get_code_type();
+		res = get_code_type();
+	} else {
+		parse_error(env, "Expected type, got \"%s\"\n", str);
+		res = get_unknown_type();
 	}
-	long nr = atol(str);
 	obstack_free(&env->obst, str);
-
-	return get_type(env, nr);
+	return res;
 }
 
 static ir_entity *create_error_entity(void)
@@ -1419,15 +1837,35 @@ ir_entity *read_entity_ref(read_env_t *env)
 	return get_entity(env, nr);
 }
 
-ir_mode *read_mode_ref(read_env_t *env)
+static ir_mode *find_mode(char const *const name)
 {
-	char *str = read_string(env);
 	for (size_t i = 0, n = ir_get_n_modes(); i < n; i++) {
 		ir_mode *mode = ir_get_mode(i);
-		if (streq(str, get_mode_name(mode))) {
-			obstack_free(&env->obst, str);
+		if (streq(name, get_mode_name(mode)))
 			return mode;
+	}
+	return NULL;
+}
+
+ir_mode *read_mode_ref(read_env_t *env)
+{
+	if (env->binary) {
+		bin_string_t *const string = read_bin_string(env);
+		if (string->mode == NULL) {
+			string->mode = find_mode(string->str);
+			if (string->mode == NULL) {
+				parse_error(env, "unknown mode \"%s\"\n", string->str);
+				return mode_ANY;
+			}
 		}
+		return string->mode;
+	}
+
+	char    *str  = read_string(env);
+	ir_mode *mode = find_mode(str);
+	if (mode != NULL) {
+		obstack_free(&env->obst, str);
+		return mode;
 	}
 
 	parse_error(env, "unknown mode \"%s\"\n", str);
@@ -1461,6 +1899,17 @@ static const char *get_typetag_name(typetag_t typetag)
  */
 static unsigned read_enum(read_env_t *env, typetag_t typetag)
 {
+	if (env->binary) {
+		char const *const str  = read_bin_string(env)->str;
+		unsigned    const code = symbol(str, typetag);
+		if (code == SYMERROR) {
+			parse_error(env, "invalid %s: \"%s\"\n",
+			            get_typetag_name(typetag), str);
+			return 0;
+		}
+		return code;
+	}
+
 	char    *str  = read_word(env);
 	unsigned code = symbol(str, typetag);
 
@@ -1545,9 +1994,12 @@ ir_relation read_relation(read_env_t *env)
 
 ir_tarval *read_tarval_ref(read_env_t *env)
 {
-	ir_mode   *tvmode = read_mode_ref(env);
-	char      *str    = read_word(env);
-	ir_tarval *tv     = ir_tarval_from_ascii(str, tvmode);
+	ir_mode *tvmode = read_mode_ref(env);
+	if (env->binary)
+		return ir_tarval_from_ascii(read_bin_string(env)->str, tvmode);
+
+	char      *str = read_word(env);
+	ir_tarval *tv  = ir_tarval_from_ascii(str, tvmode);
 	obstack_free(&env->obst, str);
 
 	return tv;
@@ -1625,7 +2077,8 @@ static bool streq_null(const char *a, const char *b)
 /** Reads a type description and remembers it by its id. */
 static void read_type(read_env_t *env)
 {
-	long           typenr = read_long(env);
+	long           id     = read_long(env);
+	long           typenr = env->binary ? read_long(env) : id;
 	tp_opcode      opcode = (tp_opcode) read_enum(env, tt_tpo);
 	unsigned       size   = (unsigned) read_long(env);
 	unsigned       align  = (unsigned) read_long(env);
@@ -1753,7 +2206,7 @@ finish_type:
 		ARR_APP1(ir_type *, env->fixedtypes, type);
 
 extend_env:
-	set_id(env, typenr, type);
+	set_id(env, id, type);
 }
 
 static void read_unknown_entity(read_env_t *env)
@@ -1848,14 +2301,16 @@ skip_init:
 			entity, (mtp_additional_properties) read_long(env));
 		break;
 	case IR_ENTITY_PARAMETER: {
-		char  *str = read_word(env);
 		size_t parameter_number;
-		if (streq(str, "va_start")) {
-			parameter_number = IR_VA_START_PARAMETER_NUMBER;
+		if (at_number(env)) {
+			parameter_number = read_size_t(env);
 		} else {
-			parameter_number = atol(str);
+			char *str = read_word(env);
+			if (!streq(str, "va_start"))
+				parse_error(env, "expected parameter number got '%s'\n", str);
+			obstack_free(&env->obst, str);
+			parameter_number = IR_VA_START_PARAMETER_NUMBER;
 		}
-		obstack_free(&env->obst, str);
 		entity = new_parameter_entity(owner, parameter_number, type);
 		set_entity_offset(entity, read_int(env));
 		set_entity_bitfield_offset(entity, read_unsigned(env));
@@ -2049,7 +2504,8 @@ static ir_node *read_Anchor(read_env_t *env)
 	return res;
 }
 
-static pmap *node_readers;
+static pmap    *node_readers;
+static unsigned node_readers_users; /**< number of imports in progress */
 
 void register_node_reader(char const *const name, read_node_func *const func)
 {
@@ -2070,12 +2526,14 @@ static ir_node *read_node(read_env_t *env)
 	} else {
 		res = func(env);
 	}
-	set_id(env, nr, res);
+	set_node(env, nr, res);
 	return res;
 }
 
 static void readers_init(void)
 {
+	if (node_readers_users++ > 0)
+		return;
 	assert(node_readers == NULL);
 	node_readers = pmap_create();
 	register_node_reader("Anchor", read_Anchor);
@@ -2193,6 +2651,12 @@ static void read_modes(read_env_t *env)
 			               overflow);
 			break;
 		}
+		case kw_vector_mode: {
+			ir_mode *element_mode = read_mode_ref(env);
+			unsigned n_elements   = read_unsigned(env);
+			new_vector_mode(element_mode, n_elements);
+			break;
+		}
 
 		default:
 			skip_to(env, '\n');
@@ -2232,45 +2696,106 @@ static void read_program(read_env_t *env)
 	}
 }
 
-int ir_import(const char *filename)
+static void readers_free(void)
 {
-	FILE *file = fopen(filename, "rt");
-	if (file == NULL) {
-		perror(filename);
-		return 1;
-	}
-
-	int res = ir_import_file(file, filename);
-	fclose(file);
-	return res;
+	if (--node_readers_users > 0)
+		return;
+	pmap_destroy(node_readers);
+	node_readers = NULL;
 }
 
-int ir_import_file(FILE *input, const char *inputname)
-{
-	read_env_t          myenv;
-	int                 oldoptimize = get_optimize();
-	read_env_t         *env         = &myenv;
+/** A binary file opened for import. */
+struct ir_import_t {
+	read_env_t           env;
+	const unsigned char *data;     /**< the file contents */
+	size_t               size;
+	bool                 mapped;   /**< data is mapped, not allocated */
+	bool                 lazy;     /**< read graphs on demand only */
+	bin_irg_entry_t     *irgs;     /**< the graph index */
+	size_t               next_irg; /**< index entry of the next graph in the
+	                                    file */
+	pmap                *irg_map;  /**< maps entities to their index entry */
+	ir_graph           **read_irgs; /**< graphs read so far, by index entry */
+};
 
+static void read_env_init(read_env_t *env, const char *inputname)
+{
 	readers_init();
 	symtbl_init();
 
 	memset(env, 0, sizeof(*env));
 	obstack_init(&env->obst);
 	obstack_init(&env->preds_obst);
-	env->idset      = new_set(id_cmp, 128);
 	env->fixedtypes = NEW_ARR_F(ir_type *, 0);
 	env->inputname  = inputname;
-	env->file       = input;
 	env->line       = 1;
 	env->delayed_initializers = NEW_ARR_F(delayed_initializer_t, 0);
+}
 
-	/* read first character */
+static int read_env_free(read_env_t *env)
+{
+	if (env->idset != NULL)
+		del_set(env->idset);
+	if (env->objs != NULL)
+		DEL_ARR_F(env->objs);
+	if (env->const_nodes != NULL)
+		DEL_ARR_F(env->const_nodes);
+	free(env->strings);
+
+	obstack_free(&env->preds_obst, NULL);
+	obstack_free(&env->obst, NULL);
+
+	readers_free();
+	return env->read_errors;
+}
+
+/** Reads the graph of an index entry of a binary file. */
+static ir_graph *read_indexed_irg(ir_import_t *import, size_t i)
+{
+	read_env_t            *env   = &import->env;
+	bin_irg_entry_t const *entry = &import->irgs[i];
+
+	env->pos   = import->data + entry->begin;
+	env->end   = import->data + entry->end;
+	env->nodes     = NEW_ARR_FZ(ir_node*, entry->n_nodes);
+	env->max_nodes = entry->n_nodes;
 	read_c(env);
 
-	/* if the first line starts with '#', it contains a comment. */
-	if (env->c == '#')
-		skip_to(env, '\n');
+	ir_graph *irg = read_irg(env);
+	import->read_irgs[i] = irg;
+
+	DEL_ARR_F(env->nodes);
+	env->nodes = NULL;
+	return irg;
+}
+
+/**
+ * Handles a graph in the toplevel of a binary file: Reads it or skips it
+ * for lazy imports.
+ */
+static void read_toplevel_irg(ir_import_t *import)
+{
+	read_env_t *env    = &import->env;
+	size_t      offset = env->pos - 1 - import->data;
+	size_t      i      = import->next_irg++;
+	if (i >= ARR_LEN(import->irgs) || import->irgs[i].begin != offset) {
+		parse_error(env, "graph is missing in the index\n");
+		exit(1);
+	}
+
+	const unsigned char *const end = env->end;
+	if (!import->lazy)
+		read_indexed_irg(import, i);
 
+	env->pos = import->data + import->irgs[i].end;
+	env->end = end;
+	read_c(env);
+}
+
+/** Reads the toplevel elements of a file. */
+static void read_toplevel(read_env_t *env, ir_import_t *import)
+{
+	int oldoptimize = get_optimize();
 	set_optimize(0);
 
 	n_initial_types = get_irp_n_types();
@@ -2294,14 +2819,26 @@ int ir_import_file(FILE *input, const char *inputname)
 			break;
 
 		case kw_irg:
-			read_irg(env);
+			if (import != NULL)
+				read_toplevel_irg(import);
+			else
+				read_irg(env);
 			break;
 
 		case kw_constirg: {
 			ir_graph *constirg = get_const_code_irg();
+			if (env->binary) {
+				/* every node has a record in the rest of the section */
+				env->nodes     = NEW_ARR_FZ(ir_node*, 0);
+				env->max_nodes = env->end - env->pos;
+			}
 			long bodyblockid = read_long(env);
-			set_id(env, bodyblockid, constirg->current_block);
+			set_node(env, bodyblockid, constirg->current_block);
 			read_graph(env, constirg);
+			if (env->binary) {
+				env->const_nodes = env->nodes;
+				env->nodes       = NULL;
+			}
 			break;
 		}
 
@@ -2320,8 +2857,10 @@ int ir_import_file(FILE *input, const char *inputname)
 		set_type_state(env->fixedtypes[i], layout_fixed);
 
 	DEL_ARR_F(env->fixedtypes);
+	env->fixedtypes = NULL;
 
 	/* resolve delayed initializers */
+	env->nodes = env->const_nodes;
 	for (size_t i = 0, n = ARR_LEN(env->delayed_initializers); i < n; ++i) {
 		const delayed_initializer_t *di   = &env->delayed_initializers[i];
 		ir_node                     *node = get_node_or_null(env, di->node_nr);
@@ -2333,18 +2872,291 @@ int ir_import_file(FILE *input, const char *inputname)
 		assert(di->initializer->kind == IR_INITIALIZER_CONST);
 		di->initializer->consti.value = node;
 	}
+	env->nodes = NULL;
 	DEL_ARR_F(env->delayed_initializers);
 	env->delayed_initializers = NULL;
 
-	del_set(env->idset);
-
 	set_optimize(oldoptimize);
+}
 
-	obstack_free(&env->preds_obst, NULL);
-	obstack_free(&env->obst, NULL);
+/** Reads the rest of a stream into memory. */
+static unsigned char *read_stream(FILE *input, size_t *size)
+{
+	size_t         len      = 0;
+	size_t         capacity = 1 << 16;
+	unsigned char *data     = XMALLOCN(unsigned char, capacity);
+	size_t         n_read;
+	while ((n_read = fread(data + len, 1, capacity - len, input)) > 0) {
+		len += n_read;
+		if (len == capacity) {
+			capacity *= 2;
+			data      = XREALLOC(data, unsigned char, capacity);
+		}
+	}
+	*size = len;
+	return data;
+}
 
-	pmap_destroy(node_readers);
-	node_readers = NULL;
+static const unsigned char *map_file(FILE *file, size_t *size, bool *mapped);
+static ir_import_t *import_binary(const char *inputname,
+                                  const unsigned char *data, size_t size,
+                                  bool mapped, bool lazy);
 
-	return env->read_errors;
+int ir_import(const char *filename)
+{
+	FILE *file = fopen(filename, "rb");
+	if (file == NULL) {
+		perror(filename);
+		return 1;
+	}
+
+	int res;
+	int c = getc(file);
+	ungetc(c, file);
+	if (c == BIN_MAGIC[0]) {
+		size_t               size;
+		bool                 mapped;
+		const unsigned char *data   = map_file(file, &size, &mapped);
+		ir_import_t         *import = import_binary(filename, data, size,
+		                                            mapped, false);
+		res = import != NULL ? ir_import_lazy_finish(import) : 1;
+	} else {
+		res = ir_import_file(file, filename);
+	}
+	fclose(file);
+	return res;
+}
+
+int ir_import_file(FILE *input, const char *inputname)
+{
+	int c = getc(input);
+	ungetc(c, input);
+	if (c == BIN_MAGIC[0]) {
+		size_t               size;
+		const unsigned char *data   = read_stream(input, &size);
+		ir_import_t         *import = import_binary(inputname, data, size,
+		                                            false, false);
+		if (import == NULL)
+			return 1;
+		return ir_import_lazy_finish(import);
+	}
+
+	read_env_t  myenv;
+	read_env_t *env = &myenv;
+	read_env_init(env, inputname);
+	env->idset = new_set(id_cmp, 128);
+	env->file  = input;
+
+	/* read first character */
+	read_c(env);
+
+	/* if the first line starts with '#', it contains a comment. */
+	if (env->c == '#')
+		skip_to(env, '\n');
+
+	read_toplevel(env, NULL);
+	return read_env_free(env);
+}
+
+/** Maps a file into memory (or reads it if mapping is not possible). */
+static const unsigned char *map_file(FILE *file, size_t *size, bool *mapped)
+{
+#ifdef HAVE_MMAP
+	struct stat st;
+	int const   fd = fileno(file);
+	if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+		void *const data
+			= mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data != MAP_FAILED) {
+			*size   = st.st_size;
+			*mapped = true;
+			return (const unsigned char*)data;
+		}
+	}
+#endif
+	*mapped = false;
+	return read_stream(file, size);
+}
+
+static void unmap_file(const unsigned char *data, size_t size, bool mapped)
+{
+#ifdef HAVE_MMAP
+	if (mapped) {
+		munmap((void*)data, size);
+		return;
+	}
+#else
+	(void)size;
+	(void)mapped;
+#endif
+	free((void*)data);
+}
+
+/** Reads the index at the end of a binary file. */
+static bool read_bin_index(ir_import_t *import)
+{
+	read_env_t          *env  = &import->env;
+	const unsigned char *data = import->data;
+	size_t const         size = import->size;
+	if (size < BIN_HEADER_SIZE + BIN_TRAILER_SIZE
+	 || memcmp(data, BIN_MAGIC, sizeof(BIN_MAGIC) - 1) != 0) {
+		parse_error(env, "not a binary firm file\n");
+		return false;
+	}
+	if (data[BIN_HEADER_SIZE - 1] != BIN_VERSION) {
+		parse_error(env, "unsupported file version %d\n",
+		            data[BIN_HEADER_SIZE - 1]);
+		return false;
+	}
+
+	uint64_t index = 0;
+	for (unsigned i = BIN_TRAILER_SIZE; i-- > 0;)
+		index = index << 8 | data[size - BIN_TRAILER_SIZE + i];
+	if (index < BIN_HEADER_SIZE || index > size - BIN_TRAILER_SIZE) {
+		parse_error(env, "invalid index offset\n");
+		return false;
+	}
+
+	env->pos = data + index;
+	env->end = data + size - BIN_TRAILER_SIZE;
+
+	size_t const n_strings = read_varint(env);
+	if (n_strings > (size_t)(env->end - env->pos)) {
+		parse_error(env, "invalid string table\n");
+		return false;
+	}
+	env->strings   = XMALLOCNZ(bin_string_t, n_strings);
+	env->n_strings = n_strings;
+	for (size_t i = 0; i < n_strings; ++i) {
+		size_t const len = read_varint(env);
+		if (len >= (size_t)(env->end - env->pos) || env->pos[len] != '\0') {
+			parse_error(env, "invalid string table\n");
+			return false;
+		}
+		env->strings[i].str = (const char*)env->pos;
+		env->pos += len + 1;
+	}
+
+	size_t const n_objs = read_varint(env);
+	if (n_objs > index) {
+		parse_error(env, "invalid number of ids\n");
+		return false;
+	}
+	env->objs = NEW_ARR_FZ(void*, n_objs);
+
+	size_t const n_irgs = read_varint(env);
+	if (n_irgs > index) {
+		parse_error(env, "invalid number of graphs\n");
+		return false;
+	}
+	import->irgs      = NEW_ARR_F(bin_irg_entry_t, n_irgs);
+	import->read_irgs = NEW_ARR_FZ(ir_graph*, n_irgs);
+	for (size_t i = 0; i < n_irgs; ++i) {
+		bin_irg_entry_t *const entry = &import->irgs[i];
+		entry->entity  = read_varint(env);
+		entry->begin   = read_varint(env);
+		entry->end     = read_varint(env);
+		entry->n_nodes = read_varint(env);
+		/* node ids are dense and every node has a record of at least one
+		 * byte, so a larger count can only come from a corrupt index */
+		if (entry->begin < BIN_HEADER_SIZE || entry->begin > entry->end
+		 || entry->end > index
+		 || entry->n_nodes > entry->end - entry->begin) {
+			parse_error(env, "invalid graph index\n");
+			return false;
+		}
+	}
+
+	/* the tokens are between the header and the index */
+	env->pos = data + BIN_HEADER_SIZE;
+	env->end = data + index;
+	return true;
+}
+
+static ir_import_t *import_binary(const char *inputname,
+                                  const unsigned char *data, size_t size,
+                                  bool mapped, bool lazy)
+{
+	ir_import_t *import = XMALLOCZ(ir_import_t);
+	read_env_t  *env    = &import->env;
+	read_env_init(env, inputname);
+	env->binary    = true;
+	import->data   = data;
+	import->size   = size;
+	import->mapped = mapped;
+	import->lazy   = lazy;
+
+	if (!read_bin_index(import)) {
+		ir_import_lazy_finish(import);
+		return NULL;
+	}
+
+	read_c(env);
+	read_toplevel(env, import);
+
+	import->irg_map = pmap_create();
+	for (size_t i = 0, n = ARR_LEN(import->irgs); i < n; ++i) {
+		ir_entity *const entity = get_entity(env, import->irgs[i].entity);
+		pmap_insert(import->irg_map, entity, &import->irgs[i]);
+	}
+	return import;
+}
+
+ir_import_t *ir_import_lazy(const char *filename)
+{
+	FILE *file = fopen(filename, "rb");
+	if (file == NULL) {
+		perror(filename);
+		return NULL;
+	}
+
+	size_t               size;
+	bool                 mapped;
+	const unsigned char *data = map_file(file, &size, &mapped);
+	fclose(file);
+	return import_binary(filename, data, size, mapped, true);
+}
+
+size_t ir_import_lazy_get_n_irgs(const ir_import_t *import)
+{
+	return ARR_LEN(import->irgs);
+}
+
+ir_entity *ir_import_lazy_get_irg_entity(ir_import_t *import, size_t pos)
+{
+	assert(pos < ARR_LEN(import->irgs));
+	return get_entity(&import->env, import->irgs[pos].entity);
+}
+
+ir_graph *ir_import_lazy_get_irg(ir_import_t *import, ir_entity *entity)
+{
+	bin_irg_entry_t *const entry
+		= pmap_get(bin_irg_entry_t, import->irg_map, entity);
+	if (entry == NULL)
+		return NULL;
+
+	size_t const i = entry - import->irgs;
+	if (import->read_irgs[i] != NULL)
+		return import->read_irgs[i];
+
+	int const oldoptimize = get_optimize();
+	set_optimize(0);
+	ir_graph *const irg = read_indexed_irg(import, i);
+	set_optimize(oldoptimize);
+	return irg;
+}
+
+int ir_import_lazy_finish(ir_import_t *import)
+{
+	if (import->irg_map != NULL)
+		pmap_destroy(import->irg_map);
+	if (import->read_irgs != NULL)
+		DEL_ARR_F(import->read_irgs);
+	if (import->irgs != NULL)
+		DEL_ARR_F(import->irgs);
+	unmap_file(import->data, import->size, import->mapped);
+
+	int const res = read_env_free(&import->env);
+	free(import);
+	return res;
 }
@@ -6,6 +6,7 @@
 #include "irnode_t.h"
 #include "obst.h"
 #include "pdeq.h"
+#include "pmap.h"
 #include "set.h"
 #include "type_t.h"
 #include "typerep.h"
@@ -22,8 +23,15 @@ typedef struct delayed_pred_t {
 	long     preds[];
 } delayed_pred_t;
 
+/** A string of the string table of a binary file. */
+typedef struct bin_string_t {
+	const char *str;  /**< the string, points into the file data */
+	ident      *id;   /**< the string as ident, created on first use */
+	ir_mode    *mode; /**< the mode named by the string, found on first use */
+} bin_string_t;
+
 typedef struct read_env_t {
-	int            c;           /**< currently read char */
+	int            c;           /**< currently read char (binary: token tag) */
 	FILE          *file;
 	const char    *inputname;
 	unsigned       line;
@@ -37,12 +45,50 @@ typedef struct read_env_t {
 	struct obstack preds_obst;
 	delayed_initializer_t *delayed_initializers;
 	const delayed_pred_t **delayed_preds;
+
+	bool                 binary;      /**< reading the binary format */
+	const unsigned char *pos;         /**< binary: next byte to read */
+	const unsigned char *end;         /**< binary: end of the current section */
+	bin_string_t        *strings;     /**< binary: the string table */
+	size_t               n_strings;
+	void               **objs;        /**< binary: types and entities by id */
+	ir_node            **nodes;       /**< binary: nodes of the current graph
+	                                       by id */
+	ir_node            **const_nodes; /**< binary: nodes of the const code
+	                                       graph by id */
+	size_t               max_nodes;   /**< binary: bound for the node ids of
+	                                       the current graph */
 } read_env_t;
 
+/** Index entry of a graph in a binary file. */
+typedef struct bin_irg_entry_t {
+	long    entity;  /**< id of the graph entity */
+	size_t  begin;   /**< file offset of the graph data */
+	size_t  end;     /**< file offset after the graph data */
+	size_t  n_nodes; /**< number of node ids used by the graph */
+} bin_irg_entry_t;
+
+/** Dense ids of the nodes of a graph in a binary file. */
+typedef struct bin_node_ids_t {
+	long *ids;   /**< id + 1 of the nodes by node index, 0 if not numbered */
+	long  n_ids; /**< number of ids handed out */
+} bin_node_ids_t;
+
 typedef struct write_env_t {
 	FILE *file;
 	deq_t write_queue;
 	deq_t entity_queue;
+
+	bool             binary;    /**< writing the binary format */
+	size_t           offset;    /**< binary: number of bytes written */
+	pmap            *obj_ids;   /**< binary: ids of types and entities */
+	long             n_objs;
+	pmap            *str_ids;   /**< binary: ids of the strings */
+	ident          **strings;   /**< binary: the string table */
+	bin_irg_entry_t *irgs;      /**< binary: the graph index */
+	bin_node_ids_t   nodes;     /**< binary: node ids of the current graph */
+	bin_node_ids_t   const_nodes; /**< binary: node ids of the const code
+	                                   graph */
 } write_env_t;
 
 void write_align(write_env_t *env, ir_align align);
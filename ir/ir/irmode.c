@@ -34,6 +34,8 @@ static bool modes_are_equal(const ir_mode *m, const ir_mode *n)
 		return false;
 	if (m->sort == irms_auxiliary || m->sort == irms_data)
 		return streq(m->name, n->name);
+	if (m->sort == irms_vector)
+		return m->element_mode == n->element_mode && m->size == n->size;
 	return m->arithmetic        == n->arithmetic
 	    && m->size              == n->size
 	    && m->sign              == n->sign
@@ -206,6 +208,21 @@ ir_mode *new_non_arithmetic_mode(const char *name, unsigned bit_size)
 	return register_mode(result);
 }
 
+ir_mode *new_vector_mode(ir_mode *const element_mode,
+                         unsigned const n_elements)
+{
+	assert(mode_is_int(element_mode) || mode_is_float(element_mode));
+	assert(n_elements > 1);
+	char name[32];
+	snprintf(name, sizeof(name), "V%u%s", n_elements,
+	         get_mode_name(element_mode));
+	ir_mode *result = alloc_mode(name, irms_vector, irma_none,
+	                             n_elements * get_mode_size_bits(element_mode),
+	                             mode_is_signed(element_mode), 0);
+	result->element_mode = element_mode;
+	return register_mode(result);
+}
+
 static ir_mode *new_non_data_mode(const char *name)
 {
 	ir_mode *result = alloc_mode(name, irms_auxiliary, irma_none, 0, 0, 0);
@@ -237,6 +254,18 @@ ir_mode_arithmetic (get_mode_arithmetic)(const ir_mode *mode)
 	return get_mode_arithmetic_(mode);
 }
 
+ir_mode *get_mode_vector_element_mode(const ir_mode *mode)
+{
+	assert(mode_is_vector(mode));
+	return mode->element_mode;
+}
+
+unsigned get_mode_n_vector_elements(const ir_mode *mode)
+{
+	assert(mode_is_vector(mode));
+	return mode->size / mode->element_mode->size;
+}
+
 unsigned int (get_mode_modulo_shift)(const ir_mode *mode)
 {
 	return get_mode_modulo_shift_(mode);
@@ -300,6 +329,11 @@ int (mode_is_reference)(const ir_mode *mode)
 	return mode_is_reference_(mode);
 }
 
+int (mode_is_vector)(const ir_mode *mode)
+{
+	return mode_is_vector_(mode);
+}
+
 int (mode_is_num)(const ir_mode *mode)
 {
 	return mode_is_num_(mode);
@@ -358,6 +392,7 @@ int smaller_mode(const ir_mode *sm, const ir_mode *lm)
 
 		case irms_auxiliary:
 		case irms_data:
+		case irms_vector:
 		case irms_internal_boolean:
 		case irms_reference:
 		case irms_float_number:
@@ -373,6 +408,7 @@ int smaller_mode(const ir_mode *sm, const ir_mode *lm)
 
 	case irms_auxiliary:
 	case irms_data:
+	case irms_vector:
 	case irms_internal_boolean:
 	case irms_reference:
 		/* do exist machines out there with different pointer lengths ?*/
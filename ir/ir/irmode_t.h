@@ -30,6 +30,7 @@
 #define mode_is_reference(mode)        mode_is_reference_(mode)
 #define mode_is_num(mode)              mode_is_num_(mode)
 #define mode_is_data(mode)             mode_is_data_(mode)
+#define mode_is_vector(mode)           mode_is_vector_(mode)
 #define get_type_for_mode(mode)        get_type_for_mode_(mode)
 #define get_mode_mantissa_size(mode)   get_mode_mantissa_size_(mode)
 #define get_mode_exponent_size(mode)   get_mode_exponent_size_(mode)
@@ -50,6 +51,7 @@ typedef enum ir_mode_sort {
 	irms_reference        = 3 | irmsh_is_data,
 	irms_int_number       = 4 | irmsh_is_data | irmsh_is_num,
 	irms_float_number     = 5 | irmsh_is_data | irmsh_is_num,
+	irms_vector           = 6 | irmsh_is_data,
 } ir_mode_sort;
 
 /**
@@ -92,6 +94,8 @@ struct ir_mode {
 	/** For reference modes, a signed integer mode used to add/subtract
 	 * offsets. */
 	ir_mode            *offset_mode;
+	/** For vector modes, the mode of the elements. */
+	ir_mode            *element_mode;
 };
 
 static inline ident *get_mode_ident_(const ir_mode *mode)
@@ -146,6 +150,11 @@ static inline int mode_is_reference_(const ir_mode *mode)
 	return get_mode_sort(mode) == irms_reference;
 }
 
+static inline int mode_is_vector_(const ir_mode *mode)
+{
+	return get_mode_sort(mode) == irms_vector;
+}
+
 static inline int mode_is_num_(const ir_mode *mode)
 {
 	return (get_mode_sort(mode) & irmsh_is_num) != 0;
@@ -286,10 +286,22 @@ typedef struct ir_def_use_edges {
 	ir_def_use_edge edges[];
 } ir_def_use_edges;
 
+/**
+ * Def-Use information of a node, kept in the irg side table idx_outs.
+ */
+typedef union irn_outs_t {
+	ir_def_use_edges *out;    /**< array of def-use edges. */
+	unsigned          n_outs; /**< number of def-use edges (temporarily used
+	                               during construction of data structure) */
+} irn_outs_t;
+
 /**
  * Data of a function graph node.
  */
 struct ir_node {
+	/* The fields touched by most operations come first, so they share a cache
+	 * line. Analysis results which are only valid for a while (outs, loops)
+	 * live in side tables of the graph indexed by node_idx. */
 	firm_kind        kind;     /**< Distinguishes this node from others. */
 	unsigned         node_idx; /**< The node index of this node in its graph. */
 	ir_op           *op;       /**< The Opcode of this node. */
@@ -300,17 +312,11 @@ struct ir_node {
 	void            *link;     /**< To attach additional information to the
 	                                node, e.g. used during optimization to link
 	                                to nodes that shall replace a node. */
-	dbg_info        *dbi;      /**< Information for debug support. */
 	long             node_nr;  /**< Globally unique node number. */
 
-	union {
-		ir_def_use_edges *out;    /**< array of def-use edges. */
-		unsigned          n_outs; /**< number of def-use edges (temporarily used
-		                               during construction of data structure) */
-	} o;
-	ir_loop         *loop;         /**< Loop information. */
 	void            *backend_info;
 	irn_edges_info_t edge_info;    /**< Everlasting out edges. */
+	dbg_info        *dbi;      /**< Information for debug support. */
 
 	/** Attributes of this node. Depends on opcode. Must be last field. */
 	ir_attr attr;
@@ -0,0 +1,95 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2016 University of Karlsruhe.
+ */
+
+/**
+ * @file
+ * @brief   The value table used for common subexpression elimination.
+ */
+#include "irvaluetable.h"
+
+#include "compiler.h"
+#include "xmalloc.h"
+
+/** Smallest number of slots of a value table. */
+#define MIN_BUCKETS 32
+
+/** Number of used slots at which a table of @p n slots is grown (75%). */
+#define GROW_LIMIT(n) ((n) - (n) / 4)
+
+static void init_entries(ir_valuetable_t *table, size_t num_buckets)
+{
+	table->entries     = XMALLOCNZ(ir_valuetable_entry_t, num_buckets);
+	table->num_buckets = num_buckets;
+	table->grow_limit  = GROW_LIMIT(num_buckets);
+}
+
+ir_valuetable_t *ir_valuetable_new(ir_valuetable_cmp_func cmp,
+                                   size_t expected_elements)
+{
+	/* keep the table at most half full for the expected number of nodes */
+	size_t num_buckets = MIN_BUCKETS;
+	while (num_buckets < expected_elements * 2)
+		num_buckets *= 2;
+
+	ir_valuetable_t *table = XMALLOC(ir_valuetable_t);
+	init_entries(table, num_buckets);
+	table->num_elements = 0;
+	table->cmp          = cmp;
+	return table;
+}
+
+void ir_valuetable_del(ir_valuetable_t *table)
+{
+	free(table->entries);
+	free(table);
+}
+
+/**
+ * Doubles the number of slots. As the hash values are cached nothing has to
+ * be recomputed, and as the new table contains no equal nodes we only have
+ * to look for a free slot.
+ */
+static void grow(ir_valuetable_t *table)
+{
+	ir_valuetable_entry_t *const old_entries = table->entries;
+	size_t                 const old_buckets = table->num_buckets;
+
+	init_entries(table, old_buckets * 2);
+
+	ir_valuetable_entry_t *const entries = table->entries;
+	size_t                 const mask    = table->num_buckets - 1;
+	for (size_t i = 0; i < old_buckets; ++i) {
+		ir_valuetable_entry_t const *const entry = &old_entries[i];
+		if (entry->node == NULL)
+			continue;
+		size_t pos = entry->hash & mask;
+		while (entries[pos].node != NULL)
+			pos = (pos + 1) & mask;
+		entries[pos] = *entry;
+	}
+	free(old_entries);
+}
+
+ir_node *ir_valuetable_insert(ir_valuetable_t *table, ir_node *node,
+                              unsigned hash)
+{
+	if (UNLIKELY(table->num_elements >= table->grow_limit))
+		grow(table);
+
+	ir_valuetable_entry_t *const entries = table->entries;
+	size_t                 const mask    = table->num_buckets - 1;
+	for (size_t pos = hash & mask;; pos = (pos + 1) & mask) {
+		ir_valuetable_entry_t *const entry = &entries[pos];
+		ir_node               *const other = entry->node;
+		if (other == NULL) {
+			entry->node = node;
+			entry->hash = hash;
+			++table->num_elements;
+			return node;
+		}
+		if (entry->hash == hash && table->cmp(other, node) == 0)
+			return other;
+	}
+}
@@ -0,0 +1,90 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2016 University of Karlsruhe.
+ */
+
+/**
+ * @file
+ * @brief   The value table used for common subexpression elimination.
+ *
+ * An open addressing hash table of nodes with linear probing. Every slot
+ * caches the hash value of its node, so probing only calls the compare
+ * function for nodes with equal hash and resizing never has to rehash.
+ * Entries are never removed: nodes which are no longer used stay in the table
+ * until it is rebuilt (see new_identities()).
+ */
+#ifndef FIRM_IR_IRVALUETABLE_H
+#define FIRM_IR_IRVALUETABLE_H
+
+#include <stddef.h>
+
+#include "firm_types.h"
+
+/**
+ * Compares two nodes of a value table.
+ *
+ * @param a  the node in the table
+ * @param b  the node looked up
+ * @return 0 if both nodes compute the same value, non-zero else
+ */
+typedef int (*ir_valuetable_cmp_func)(const ir_node *a, const ir_node *b);
+
+/** A slot of the value table. */
+typedef struct ir_valuetable_entry_t {
+	ir_node  *node; /**< the node, NULL for empty slots */
+	unsigned  hash; /**< the cached hash value of node */
+} ir_valuetable_entry_t;
+
+/** The value table. */
+typedef struct ir_valuetable_t {
+	ir_valuetable_entry_t  *entries;      /**< the slots */
+	size_t                  num_buckets;  /**< number of slots, a power of 2 */
+	size_t                  num_elements; /**< number of used slots */
+	size_t                  grow_limit;   /**< grow when reaching this */
+	ir_valuetable_cmp_func  cmp;          /**< the compare function */
+} ir_valuetable_t;
+
+/**
+ * Allocates and initializes a new value table.
+ *
+ * @param cmp                the compare function for nodes
+ * @param expected_elements  number of nodes expected in the table (roughly)
+ */
+ir_valuetable_t *ir_valuetable_new(ir_valuetable_cmp_func cmp,
+                                   size_t expected_elements);
+
+/**
+ * Frees a value table and its memory.
+ */
+void ir_valuetable_del(ir_valuetable_t *table);
+
+/**
+ * Looks up a node equal to @p node and inserts @p node if there is none.
+ *
+ * @param table  the value table
+ * @param node   the node
+ * @param hash   the hash value of @p node
+ * @return the node equal to @p node found in the table or @p node itself
+ */
+ir_node *ir_valuetable_insert(ir_valuetable_t *table, ir_node *node,
+                              unsigned hash);
+
+/**
+ * Returns the number of nodes in a value table.
+ */
+static inline size_t ir_valuetable_size(const ir_valuetable_t *table)
+{
+	return table->num_elements;
+}
+
+/**
+ * Iterates over all nodes of a value table. The table must not be modified
+ * while iterating.
+ */
+#define foreach_ir_valuetable(table, irn) \
+	for (ir_valuetable_entry_t const *irn##__e = (table)->entries, \
+	     *const irn##__end = irn##__e + (table)->num_buckets; \
+	     irn##__e != irn##__end; ++irn##__e) \
+		for (ir_node *irn = irn##__e->node; irn != NULL; irn = NULL)
+
+#endif
@@ -637,11 +637,17 @@ static int verify_node_Call(const ir_node *n)
 	return fine;
 }
 
+/** Returns true if @p mode is numeric or a vector of numbers. */
+static int mode_is_num_or_vector(const ir_mode *mode)
+{
+	return mode_is_num(mode) || mode_is_vector(mode);
+}
+
 static int verify_node_Add(const ir_node *n)
 {
 	bool     fine = true;
 	ir_mode *mode = get_irn_mode(n);
-	if (mode_is_num(mode)) {
+	if (mode_is_num_or_vector(mode)) {
 		fine &= check_mode_same_input(n, n_Add_left, "left");
 		fine &= check_mode_same_input(n, n_Add_right, "right");
 	} else if (mode_is_reference(mode)) {
@@ -669,7 +675,10 @@ static int verify_node_Sub(const ir_node *n)
 {
 	bool     fine = true;
 	ir_mode *mode = get_irn_mode(n);
-	if (mode_is_num(mode)) {
+	if (mode_is_vector(mode)) {
+		fine &= check_mode_same_input(n, n_Sub_left, "left");
+		fine &= check_mode_same_input(n, n_Sub_right, "right");
+	} else if (mode_is_num(mode)) {
 		ir_mode *mode_left = get_irn_mode(get_Sub_left(n));
 		if (mode_is_reference(mode_left)) {
 			fine &= check_input_mode(n, n_Sub_right, "right", mode_left);
@@ -696,7 +705,7 @@ static int verify_node_Minus(const ir_node *n)
 
 static int verify_node_Mul(const ir_node *n)
 {
-	bool fine = check_mode_func(n, mode_is_num, "numeric");
+	bool fine = check_mode_func(n, mode_is_num_or_vector, "numeric or vector");
 	fine &= check_mode_same_input(n, n_Mul_left, "left");
 	fine &= check_mode_same_input(n, n_Mul_right, "right");
 	return fine;
@@ -743,9 +752,17 @@ static int mode_is_intb(const ir_mode *mode)
 	return mode_is_int(mode) || mode == mode_b;
 }
 
+/** Returns true if @p mode is an int mode, mode_b or a vector of ints. */
+static int mode_is_intb_or_vector(const ir_mode *mode)
+{
+	return mode_is_intb(mode) || (mode_is_vector(mode)
+	       && mode_is_int(get_mode_vector_element_mode(mode)));
+}
+
 static int verify_node_And(const ir_node *n)
 {
-	bool fine = check_mode_func(n, mode_is_intb, "int or mode_b");
+	bool fine = check_mode_func(n, mode_is_intb_or_vector,
+	                            "int, mode_b or int vector");
 	fine &= check_mode_same_input(n, n_And_left, "left");
 	fine &= check_mode_same_input(n, n_And_right, "right");
 	return fine;
@@ -753,7 +770,8 @@ static int verify_node_And(const ir_node *n)
 
 static int verify_node_Or(const ir_node *n)
 {
-	bool fine = check_mode_func(n, mode_is_intb, "int or mode_b");
+	bool fine = check_mode_func(n, mode_is_intb_or_vector,
+	                            "int, mode_b or int vector");
 	fine &= check_mode_same_input(n, n_Or_left, "left");
 	fine &= check_mode_same_input(n, n_Or_right, "right");
 	return fine;
@@ -761,7 +779,8 @@ static int verify_node_Or(const ir_node *n)
 
 static int verify_node_Eor(const ir_node *n)
 {
-	bool fine = check_mode_func(n, mode_is_intb, "int or mode_b");
+	bool fine = check_mode_func(n, mode_is_intb_or_vector,
+	                            "int, mode_b or int vector");
 	fine &= check_mode_same_input(n, n_Eor_left, "left");
 	fine &= check_mode_same_input(n, n_Eor_right, "right");
 	return fine;
@@ -847,6 +866,16 @@ static int verify_node_Bitcast(const ir_node *n)
 	return fine;
 }
 
+static int verify_node_Splat(const ir_node *n)
+{
+	bool fine = check_mode_func(n, mode_is_vector, "vector");
+	if (fine) {
+		ir_mode *element_mode = get_mode_vector_element_mode(get_irn_mode(n));
+		fine &= check_input_mode(n, n_Splat_op, "op", element_mode);
+	}
+	return fine;
+}
+
 static int mode_is_dataMb(const ir_mode *mode)
 {
 	return mode_is_data(mode) || mode == mode_M;
@@ -1344,6 +1373,7 @@ void ir_register_verify_node_ops(void)
 	set_op_verify(op_Shr,      verify_node_Shr);
 	set_op_verify(op_Shrs,     verify_node_Shrs);
 	set_op_verify(op_Size,     verify_node_int);
+	set_op_verify(op_Splat,    verify_node_Splat);
 	set_op_verify(op_Start,    verify_node_Start);
 	set_op_verify(op_Store,    verify_node_Store);
 	set_op_verify(op_Sub,      verify_node_Sub);
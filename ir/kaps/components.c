@@ -0,0 +1,331 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2016 University of Karlsruhe.
+ */
+
+/**
+ * @file
+ * @brief   Solving independent connected components of a PBQP.
+ */
+#include "components.h"
+
+#include "adt/array.h"
+#include "adt/xmalloc.h"
+#include "bucket.h"
+#include "kaps.h"
+#include "optimal.h"
+#include "pbqp_edge.h"
+#include "pbqp_edge_t.h"
+#include "pbqp_node.h"
+#include "pbqp_node_t.h"
+#include "pdeq.h"
+#include "vector.h"
+#include <stdlib.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+/** Smallest number of component nodes worth an additional thread. */
+#define MIN_NODES_PER_THREAD 512
+
+/**
+ * A connected component. Its nodes, its part of the rpeo and its edges
+ * waiting for simplification are ranges of the arrays in solve_env_t.
+ */
+typedef struct component_t {
+	unsigned node_begin, node_end;
+	unsigned rpeo_begin, rpeo_end;
+	unsigned edge_begin, edge_end;
+	num      solution;
+} component_t;
+
+typedef struct solve_env_t {
+	component_t           **order;        /**< Components, largest first. */
+	unsigned                n_components;
+	unsigned                next;         /**< Next entry of order to solve. */
+	pbqp_node_t           **nodes;        /**< Nodes in ascending index. */
+	pbqp_node_t           **rpeo;         /**< The rpeo of the caller. */
+	pbqp_edge_t           **edges;        /**< Edges to simplify. */
+	pbqp_component_solver_t solve;
+#ifndef _WIN32
+	pthread_mutex_t         lock;
+#endif
+} solve_env_t;
+
+typedef struct worker_t {
+	solve_env_t *env;
+	pbqp_t      *pbqp;  /**< Instance reducing the worker's components. */
+} worker_t;
+
+/**
+ * Creates an instance sharing the nodes of @p pbqp. Edges and cost vectors
+ * created while reducing go to its own obstack, so every thread can reduce
+ * components in its own instance.
+ */
+static pbqp_t *alloc_sub_pbqp(pbqp_t *pbqp)
+{
+	pbqp_t *sub = alloc_pbqp(0);
+
+	sub->num_nodes = pbqp->num_nodes;
+	sub->nodes     = pbqp->nodes;
+#if KAPS_DUMP
+	sub->dump_file = pbqp->dump_file;
+#endif
+	return sub;
+}
+
+static int cmp_component_size(const void *p1, const void *p2)
+{
+	const component_t *c1 = *(const component_t *const *)p1;
+	const component_t *c2 = *(const component_t *const *)p2;
+	unsigned           l1 = c1->node_end - c1->node_begin;
+	unsigned           l2 = c2->node_end - c2->node_begin;
+
+	if (l1 != l2)
+		return l1 < l2 ? 1 : -1;
+	return c1 < c2 ? -1 : c1 > c2;
+}
+
+static component_t *next_component(solve_env_t *env)
+{
+#ifndef _WIN32
+	pthread_mutex_lock(&env->lock);
+#endif
+	unsigned index = env->next;
+	if (index < env->n_components)
+		++env->next;
+#ifndef _WIN32
+	pthread_mutex_unlock(&env->lock);
+#endif
+	return index < env->n_components ? env->order[index] : NULL;
+}
+
+static void *solve_components_worker(void *data)
+{
+	worker_t    *worker = (worker_t *)data;
+	solve_env_t *env    = worker->env;
+	pbqp_t      *pbqp   = worker->pbqp;
+	deq_t        rpeo;
+
+	deq_init(&rpeo);
+	init_buckets(pbqp);
+	for (component_t *comp; (comp = next_component(env)) != NULL;) {
+		for (unsigned i = comp->edge_begin; i < comp->edge_end; ++i)
+			edge_bucket_insert(&pbqp->edge_bucket, env->edges[i]);
+		for (unsigned i = comp->rpeo_begin; i < comp->rpeo_end; ++i)
+			deq_push_pointer_right(&rpeo, env->rpeo[i]);
+		fill_node_buckets_from(pbqp, &env->nodes[comp->node_begin],
+		                       comp->node_end - comp->node_begin);
+
+		env->solve(pbqp, &rpeo);
+		comp->solution = pbqp->solution;
+
+		clear_buckets(pbqp);
+		while (!deq_empty(&rpeo))
+			deq_pop_pointer_left(pbqp_node_t, &rpeo);
+	}
+	free_buckets(pbqp);
+	deq_free(&rpeo);
+	return NULL;
+}
+
+static void run_workers(pbqp_t *pbqp, solve_env_t *env, unsigned n_threads)
+{
+	worker_t *workers = XMALLOCN(worker_t, n_threads);
+
+	pbqp->sub_pbqps = NEW_ARR_F(pbqp_t *, n_threads);
+	for (unsigned i = 0; i < n_threads; ++i) {
+		workers[i].env     = env;
+		workers[i].pbqp    = alloc_sub_pbqp(pbqp);
+		pbqp->sub_pbqps[i] = workers[i].pbqp;
+	}
+
+#ifndef _WIN32
+	pthread_t *threads   = XMALLOCN(pthread_t, n_threads);
+	unsigned   n_started = 1;
+
+	pthread_mutex_init(&env->lock, NULL);
+	/* The calling thread is the first worker. */
+	while (n_started < n_threads
+	       && pthread_create(&threads[n_started], NULL, solve_components_worker, &workers[n_started]) == 0)
+		++n_started;
+	solve_components_worker(&workers[0]);
+	for (unsigned i = 1; i < n_started; ++i)
+		pthread_join(threads[i], NULL);
+	pthread_mutex_destroy(&env->lock);
+	free(threads);
+#else
+	solve_components_worker(&workers[0]);
+#endif
+	free(workers);
+}
+
+void solve_pbqp_components(pbqp_t *pbqp, deq_t *rpeo,
+                           pbqp_component_solver_t solve)
+{
+	unsigned      node_len = pbqp->num_nodes;
+	unsigned     *comp_of  = XMALLOCN(unsigned, node_len);
+	component_t  *comps    = NEW_ARR_F(component_t, 0);
+	pbqp_node_t **stack    = NEW_ARR_F(pbqp_node_t *, 0);
+	num           solution = 0;
+
+	for (unsigned node_index = 0; node_index < node_len; ++node_index)
+		comp_of[node_index] = UINT_MAX;
+
+	/* Number the components in order of their smallest node index and count
+	 * their nodes. Nodes without edges belong to no component and are solved
+	 * right away. */
+	for (unsigned node_index = 0; node_index < node_len; ++node_index) {
+		pbqp_node_t *node = get_node(pbqp, node_index);
+
+		if (!node || comp_of[node_index] != UINT_MAX)
+			continue;
+
+		if (pbqp_node_get_degree(node) == 0) {
+			node->solution = vector_get_min_index(node->costs);
+			solution       = pbqp_add(solution, node->costs->entries[node->solution].data);
+#if KAPS_STATISTIC
+			pbqp->num_r0++;
+#endif
+			continue;
+		}
+
+		unsigned    nr    = ARR_LEN(comps);
+		component_t empty = { 0, 0, 0, 0, 0, 0, 0 };
+		ARR_APP1(component_t, comps, empty);
+
+		comp_of[node_index] = nr;
+		ARR_APP1(pbqp_node_t *, stack, node);
+		for (size_t len; (len = ARR_LEN(stack)) > 0;) {
+			pbqp_node_t *cur = stack[len - 1];
+			ARR_SHRINKLEN(stack, len - 1);
+			++comps[nr].node_end;
+
+			for (unsigned i = 0, n = pbqp_node_get_degree(cur); i < n; ++i) {
+				pbqp_edge_t *edge  = cur->edges[i];
+				pbqp_node_t *other = edge->src == cur ? edge->tgt : edge->src;
+
+				if (comp_of[other->index] == UINT_MAX) {
+					comp_of[other->index] = nr;
+					ARR_APP1(pbqp_node_t *, stack, other);
+				}
+			}
+		}
+	}
+	DEL_ARR_F(stack);
+
+	unsigned n_components = ARR_LEN(comps);
+	unsigned n_rpeo       = 0;
+	unsigned n_edges      = 0;
+
+	deq_foreach_pointer(rpeo, pbqp_node_t, node) {
+		unsigned nr = comp_of[node->index];
+		if (nr != UINT_MAX) {
+			++comps[nr].rpeo_end;
+			++n_rpeo;
+		}
+	}
+
+	pbqp_edge_t **bucket     = pbqp->edge_bucket;
+	unsigned      bucket_len = edge_bucket_get_length(bucket);
+	for (unsigned i = 0; i < bucket_len; ++i) {
+		pbqp_edge_t *edge = bucket[i];
+		if (!is_deleted(edge)) {
+			++comps[comp_of[edge->src->index]].edge_end;
+			++n_edges;
+		}
+	}
+
+	/* Turn the counts into ranges... */
+	unsigned n_nodes   = 0;
+	unsigned rpeo_next = 0;
+	unsigned edge_next = 0;
+	for (unsigned i = 0; i < n_components; ++i) {
+		component_t *comp = &comps[i];
+
+		comp->node_begin = n_nodes;
+		n_nodes         += comp->node_end;
+		comp->node_end   = comp->node_begin;
+		comp->rpeo_begin = rpeo_next;
+		rpeo_next       += comp->rpeo_end;
+		comp->rpeo_end   = comp->rpeo_begin;
+		comp->edge_begin = edge_next;
+		edge_next       += comp->edge_end;
+		comp->edge_end   = comp->edge_begin;
+	}
+
+	/* ... and fill them, keeping the relative order. */
+	solve_env_t env;
+	env.nodes = XMALLOCN(pbqp_node_t *, n_nodes);
+	env.rpeo  = XMALLOCN(pbqp_node_t *, n_rpeo);
+	env.edges = XMALLOCN(pbqp_edge_t *, n_edges);
+
+	for (unsigned node_index = 0; node_index < node_len; ++node_index) {
+		unsigned nr = comp_of[node_index];
+		if (nr != UINT_MAX)
+			env.nodes[comps[nr].node_end++] = get_node(pbqp, node_index);
+	}
+
+	deq_foreach_pointer(rpeo, pbqp_node_t, node) {
+		unsigned nr = comp_of[node->index];
+		if (nr != UINT_MAX)
+			env.rpeo[comps[nr].rpeo_end++] = node;
+	}
+
+	for (unsigned i = 0; i < bucket_len; ++i) {
+		pbqp_edge_t *edge = bucket[i];
+		if (!is_deleted(edge))
+			env.edges[comps[comp_of[edge->src->index]].edge_end++] = edge;
+	}
+	free_buckets(pbqp);
+	free(comp_of);
+
+	unsigned n_threads = n_nodes / MIN_NODES_PER_THREAD;
+	if (n_threads > pbqp->num_threads)
+		n_threads = pbqp->num_threads;
+	if (n_threads > n_components)
+		n_threads = n_components;
+#if KAPS_DUMP || KAPS_STATISTIC
+	/* Keep dumps and statistics in order. */
+	n_threads = 1;
+#endif
+	if (n_threads == 0)
+		n_threads = 1;
+
+	env.order = XMALLOCN(component_t *, n_components);
+	for (unsigned i = 0; i < n_components; ++i)
+		env.order[i] = &comps[i];
+	/* Start with the largest components to balance the threads. */
+	if (n_threads > 1)
+		qsort(env.order, n_components, sizeof(*env.order), cmp_component_size);
+
+	env.n_components = n_components;
+	env.next         = 0;
+	env.solve        = solve;
+	run_workers(pbqp, &env, n_threads);
+
+	for (unsigned i = 0; i < n_components; ++i)
+		solution = pbqp_add(solution, comps[i].solution);
+
+#if KAPS_STATISTIC
+	for (unsigned i = 0; i < n_threads; ++i) {
+		pbqp_t *sub = pbqp->sub_pbqps[i];
+
+		pbqp->num_bf += sub->num_bf;
+		pbqp->num_r0 += sub->num_r0;
+		pbqp->num_r1 += sub->num_r1;
+		pbqp->num_r2 += sub->num_r2;
+		pbqp->num_rm += sub->num_rm;
+		pbqp->num_rn += sub->num_rn;
+	}
+#endif
+
+	free(env.order);
+	free(env.edges);
+	free(env.rpeo);
+	free(env.nodes);
+	DEL_ARR_F(comps);
+
+	pbqp->solution = solution;
+}
@@ -0,0 +1,36 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2016 University of Karlsruhe.
+ */
+
+/**
+ * @file
+ * @brief   Solving independent connected components of a PBQP.
+ */
+#ifndef KAPS_COMPONENTS_H
+#define KAPS_COMPONENTS_H
+
+#include "pbqp_t.h"
+
+#include "deq.h"
+
+/**
+ * Reduces and back propagates one component. The node buckets of the
+ * component are already filled and @p rpeo contains exactly its nodes.
+ * The solver has to store the component's minimum in its solution field.
+ */
+typedef void (*pbqp_component_solver_t)(pbqp_t *component, deq_t *rpeo);
+
+/**
+ * Splits an initially simplified PBQP into its connected components and
+ * solves each one with @p solve, using up to pbqp->num_threads threads.
+ *
+ * The components share no edges, so every component is reduced on its own
+ * and the result does not depend on the number of threads.
+ * Nodes without edges are solved directly. The sum of all minima is stored
+ * in pbqp->solution. @p rpeo is only read.
+ */
+void solve_pbqp_components(pbqp_t *pbqp, deq_t *rpeo,
+                           pbqp_component_solver_t solve);
+
+#endif
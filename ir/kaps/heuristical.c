@@ -32,7 +32,7 @@
 static void apply_RN(pbqp_t *pbqp)
 {
 	/* We want to reduce a node with maximum degree. */
-	pbqp_node_t *node = get_node_with_max_degree();
+	pbqp_node_t *node = get_node_with_max_degree(pbqp);
 	assert(pbqp_node_get_degree(node) > 2);
 
 #if KAPS_DUMP
@@ -60,19 +60,19 @@ static void apply_RN(pbqp_t *pbqp)
 #endif
 
 	/* Now that we found the local minimum set all other costs to infinity. */
-	select_alternative(node, min_index);
+	select_alternative(pbqp, node, min_index);
 }
 
 static void apply_heuristic_reductions(pbqp_t *pbqp)
 {
 	for (;;) {
-		if (edge_bucket_get_length(edge_bucket) > 0) {
+		if (edge_bucket_get_length(pbqp->edge_bucket) > 0) {
 			apply_edge(pbqp);
-		} else if (node_bucket_get_length(node_buckets[1]) > 0) {
+		} else if (node_bucket_get_length(pbqp->node_buckets[1]) > 0) {
 			apply_RI(pbqp);
-		} else if (node_bucket_get_length(node_buckets[2]) > 0) {
+		} else if (node_bucket_get_length(pbqp->node_buckets[2]) > 0) {
 			apply_RII(pbqp);
-		} else if (node_bucket_get_length(node_buckets[3]) > 0) {
+		} else if (node_bucket_get_length(pbqp->node_buckets[3]) > 0) {
 			apply_RN(pbqp);
 		} else {
 			return;
@@ -121,5 +121,5 @@ void solve_pbqp_heuristical(pbqp_t *pbqp)
 	/* Solve reduced nodes. */
 	back_propagate(pbqp);
 
-	free_buckets();
+	free_buckets(pbqp);
 }
@@ -14,6 +14,7 @@
 #include "adt/array.h"
 
 #include "bucket.h"
+#include "components.h"
 #include "heuristical_co.h"
 #include "optimal.h"
 #if KAPS_DUMP
@@ -41,7 +42,7 @@ static void merge_into_RN_node(pbqp_t *pbqp, deq_t *rpeo)
 		/* insert node at the end of rpeo so the rpeo already exits after pbqp
 		 * solving */
 		deq_push_pointer_right(rpeo, node);
-	} while (node_is_reduced(node));
+	} while (node_is_reduced(pbqp, node));
 
 	assert(pbqp_node_get_degree(node) > 2);
 
@@ -51,10 +52,10 @@ static void merge_into_RN_node(pbqp_t *pbqp, deq_t *rpeo)
 
 static void apply_RN_co(pbqp_t *pbqp)
 {
-	pbqp_node_t *node = merged_node;
-	merged_node = NULL;
+	pbqp_node_t *node = pbqp->merged_node;
+	pbqp->merged_node = NULL;
 
-	if (node_is_reduced(node))
+	if (node_is_reduced(pbqp, node))
 		return;
 
 #if KAPS_DUMP
@@ -82,7 +83,7 @@ static void apply_RN_co(pbqp_t *pbqp)
 #endif
 
 	/* Now that we found the local minimum set all other costs to infinity. */
-	select_alternative(node, min_index);
+	select_alternative(pbqp, node, min_index);
 }
 
 static void apply_heuristic_reductions_co(pbqp_t *pbqp, deq_t *rpeo)
@@ -96,7 +97,7 @@ static void apply_heuristic_reductions_co(pbqp_t *pbqp, deq_t *rpeo)
 	#endif
 
 	for (;;) {
-		if (edge_bucket_get_length(edge_bucket) > 0) {
+		if (edge_bucket_get_length(pbqp->edge_bucket) > 0) {
 			#if KAPS_TIMING
 				ir_timer_start(t_edge);
 			#endif
@@ -106,7 +107,7 @@ static void apply_heuristic_reductions_co(pbqp_t *pbqp, deq_t *rpeo)
 			#if KAPS_TIMING
 				ir_timer_stop(t_edge);
 			#endif
-		} else if (node_bucket_get_length(node_buckets[1]) > 0) {
+		} else if (node_bucket_get_length(pbqp->node_buckets[1]) > 0) {
 			#if KAPS_TIMING
 				ir_timer_start(t_r1);
 			#endif
@@ -116,7 +117,7 @@ static void apply_heuristic_reductions_co(pbqp_t *pbqp, deq_t *rpeo)
 			#if KAPS_TIMING
 				ir_timer_stop(t_r1);
 			#endif
-		} else if (node_bucket_get_length(node_buckets[2]) > 0) {
+		} else if (node_bucket_get_length(pbqp->node_buckets[2]) > 0) {
 			#if KAPS_TIMING
 				ir_timer_start(t_r2);
 			#endif
@@ -126,7 +127,7 @@ static void apply_heuristic_reductions_co(pbqp_t *pbqp, deq_t *rpeo)
 			#if KAPS_TIMING
 				ir_timer_stop(t_r2);
 			#endif
-		} else if (merged_node != NULL) {
+		} else if (pbqp->merged_node != NULL) {
 			#if KAPS_TIMING
 				ir_timer_start(t_rn);
 			#endif
@@ -136,7 +137,7 @@ static void apply_heuristic_reductions_co(pbqp_t *pbqp, deq_t *rpeo)
 			#if KAPS_TIMING
 				ir_timer_stop(t_rn);
 			#endif
-		} else if (node_bucket_get_length(node_buckets[3]) > 0) {
+		} else if (node_bucket_get_length(pbqp->node_buckets[3]) > 0) {
 			#if KAPS_TIMING
 				ir_timer_start(t_rn);
 			#endif
@@ -159,6 +160,16 @@ static void apply_heuristic_reductions_co(pbqp_t *pbqp, deq_t *rpeo)
 	}
 }
 
+static void solve_component_co(pbqp_t *pbqp, deq_t *rpeo)
+{
+	apply_heuristic_reductions_co(pbqp, rpeo);
+
+	pbqp->solution = determine_solution(pbqp);
+
+	/* Solve reduced nodes. */
+	back_propagate(pbqp);
+}
+
 void solve_pbqp_heuristical_co(pbqp_t *pbqp, deq_t *rpeo)
 {
 #ifndef NDEBUG
@@ -171,18 +182,14 @@ void solve_pbqp_heuristical_co(pbqp_t *pbqp, deq_t *rpeo)
 	/* Reduce nodes degree ... */
 	initial_simplify_edges(pbqp);
 
-	/* ... and put node into bucket representing their degree. */
-	fill_node_buckets(pbqp);
-
 	#if KAPS_STATISTIC
 		FILE *fh = fopen("solutions.pb", "a");
 		fprintf(fh, "Solution");
 		fclose(fh);
 	#endif
 
-	apply_heuristic_reductions_co(pbqp, rpeo);
-
-	pbqp->solution = determine_solution(pbqp);
+	/* ... and solve the connected components independently. */
+	solve_pbqp_components(pbqp, rpeo, solve_component_co);
 
 	#if KAPS_STATISTIC
 		fh = fopen("solutions.pb", "a");
@@ -197,9 +204,4 @@ void solve_pbqp_heuristical_co(pbqp_t *pbqp, deq_t *rpeo)
 		#endif
 		fclose(fh);
 	#endif
-
-	/* Solve reduced nodes. */
-	back_propagate(pbqp);
-
-	free_buckets();
 }
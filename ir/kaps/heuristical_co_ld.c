@@ -8,6 +8,7 @@
 #include "adt/array.h"
 
 #include "bucket.h"
+#include "components.h"
 #include "heuristical_co_ld.h"
 #include "optimal.h"
 #if KAPS_DUMP
@@ -151,10 +152,10 @@ static void back_propagate_ld(pbqp_t *pbqp)
 	}
 #endif
 
-	unsigned node_len = node_bucket_get_length(reduced_bucket);
+	unsigned node_len = node_bucket_get_length(pbqp->reduced_bucket);
 
 	for (unsigned node_index = node_len; node_index-- != 0;) {
-		pbqp_node_t *node = reduced_bucket[node_index];
+		pbqp_node_t *node = pbqp->reduced_bucket[node_index];
 
 		switch (pbqp_node_get_degree(node)) {
 			case 1:
@@ -180,7 +181,7 @@ static void merge_into_RN_node(pbqp_t *pbqp, deq_t *rpeo)
 		/* insert node at the beginning of rpeo so the rpeo already exits after
 		 * pbqp solving */
 		deq_push_pointer_left(rpeo, node);
-	} while (node_is_reduced(node));
+	} while (node_is_reduced(pbqp, node));
 
 	assert(pbqp_node_get_degree(node) > 2);
 
@@ -190,12 +191,10 @@ static void merge_into_RN_node(pbqp_t *pbqp, deq_t *rpeo)
 
 static void apply_RN_co_without_selection(pbqp_t *pbqp)
 {
-	(void)pbqp;
-
-	pbqp_node_t *node = merged_node;
-	merged_node = NULL;
+	pbqp_node_t *node = pbqp->merged_node;
+	pbqp->merged_node = NULL;
 
-	if (node_is_reduced(node))
+	if (node_is_reduced(pbqp, node))
 		return;
 
 #if KAPS_DUMP
@@ -223,14 +222,14 @@ static void apply_RN_co_without_selection(pbqp_t *pbqp)
 			continue;
 
 		disconnect_edge(neighbor, edge);
-		reorder_node_after_edge_deletion(neighbor);
+		reorder_node_after_edge_deletion(pbqp, neighbor);
 	}
 
 	/* Remove node from old bucket */
-	node_bucket_remove(&node_buckets[3], node);
+	node_bucket_remove(&pbqp->node_buckets[3], node);
 
 	/* Add node to back propagation list. */
-	node_bucket_insert(&reduced_bucket, node);
+	node_bucket_insert(&pbqp->reduced_bucket, node);
 }
 
 static void apply_heuristic_reductions_co(pbqp_t *pbqp, deq_t *rpeo)
@@ -244,7 +243,7 @@ static void apply_heuristic_reductions_co(pbqp_t *pbqp, deq_t *rpeo)
 	#endif
 
 	for (;;) {
-		if (edge_bucket_get_length(edge_bucket) > 0) {
+		if (edge_bucket_get_length(pbqp->edge_bucket) > 0) {
 			#if KAPS_TIMING
 				ir_timer_start(t_edge);
 			#endif
@@ -254,7 +253,7 @@ static void apply_heuristic_reductions_co(pbqp_t *pbqp, deq_t *rpeo)
 			#if KAPS_TIMING
 				ir_timer_stop(t_edge);
 			#endif
-		} else if (node_bucket_get_length(node_buckets[1]) > 0) {
+		} else if (node_bucket_get_length(pbqp->node_buckets[1]) > 0) {
 			#if KAPS_TIMING
 				ir_timer_start(t_r1);
 			#endif
@@ -264,7 +263,7 @@ static void apply_heuristic_reductions_co(pbqp_t *pbqp, deq_t *rpeo)
 			#if KAPS_TIMING
 				ir_timer_stop(t_r1);
 			#endif
-		} else if (node_bucket_get_length(node_buckets[2]) > 0) {
+		} else if (node_bucket_get_length(pbqp->node_buckets[2]) > 0) {
 			#if KAPS_TIMING
 				ir_timer_start(t_r2);
 			#endif
@@ -274,7 +273,7 @@ static void apply_heuristic_reductions_co(pbqp_t *pbqp, deq_t *rpeo)
 			#if KAPS_TIMING
 				ir_timer_stop(t_r2);
 			#endif
-		} else if (merged_node != NULL) {
+		} else if (pbqp->merged_node != NULL) {
 			#if KAPS_TIMING
 				ir_timer_start(t_rn);
 			#endif
@@ -284,7 +283,7 @@ static void apply_heuristic_reductions_co(pbqp_t *pbqp, deq_t *rpeo)
 			#if KAPS_TIMING
 				ir_timer_stop(t_rn);
 			#endif
-		} else if (node_bucket_get_length(node_buckets[3]) > 0) {
+		} else if (node_bucket_get_length(pbqp->node_buckets[3]) > 0) {
 			#if KAPS_TIMING
 				ir_timer_start(t_rn);
 			#endif
@@ -307,6 +306,16 @@ static void apply_heuristic_reductions_co(pbqp_t *pbqp, deq_t *rpeo)
 	}
 }
 
+static void solve_component_co_ld(pbqp_t *pbqp, deq_t *rpeo)
+{
+	apply_heuristic_reductions_co(pbqp, rpeo);
+
+	pbqp->solution = determine_solution(pbqp);
+
+	/* Solve reduced nodes. */
+	back_propagate_ld(pbqp);
+}
+
 void solve_pbqp_heuristical_co_ld(pbqp_t *pbqp, deq_t *rpeo)
 {
 #ifndef NDEBUG
@@ -319,18 +328,14 @@ void solve_pbqp_heuristical_co_ld(pbqp_t *pbqp, deq_t *rpeo)
 	/* Reduce nodes degree ... */
 	initial_simplify_edges(pbqp);
 
-	/* ... and put node into bucket representing their degree. */
-	fill_node_buckets(pbqp);
-
 	#if KAPS_STATISTIC
 		FILE *fh = fopen("solutions.pb", "a");
 		fprintf(fh, "Solution");
 		fclose(fh);
 	#endif
 
-	apply_heuristic_reductions_co(pbqp, rpeo);
-
-	pbqp->solution = determine_solution(pbqp);
+	/* ... and solve the connected components independently. */
+	solve_pbqp_components(pbqp, rpeo, solve_component_co_ld);
 
 	#if KAPS_STATISTIC
 		fh = fopen("solutions.pb", "a");
@@ -345,9 +350,4 @@ void solve_pbqp_heuristical_co_ld(pbqp_t *pbqp, deq_t *rpeo)
 		#endif
 		fclose(fh);
 	#endif
-
-	/* Solve reduced nodes. */
-	back_propagate_ld(pbqp);
-
-	free_buckets();
 }
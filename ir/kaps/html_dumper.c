@@ -144,7 +144,7 @@ void pbqp_dump_graph(pbqp_t *pbqp)
 	for (unsigned src_index = 0; src_index < pbqp->num_nodes; ++src_index) {
 		pbqp_node_t *node = get_node(pbqp, src_index);
 
-		if (node && !node_is_reduced(node)) {
+		if (node && !node_is_reduced(pbqp, node)) {
 			fprintf(pbqp->dump_file, "\t n%u;\n", src_index);
 		}
 	}
@@ -155,7 +155,7 @@ void pbqp_dump_graph(pbqp_t *pbqp)
 		if (!node)
 			continue;
 
-		if (node_is_reduced(node))
+		if (node_is_reduced(pbqp, node))
 			continue;
 
 		unsigned len = ARR_LEN(node->edges);
@@ -164,7 +164,7 @@ void pbqp_dump_graph(pbqp_t *pbqp)
 			pbqp_node_t *tgt_node  = node->edges[edge_index]->tgt;
 			unsigned     tgt_index = tgt_node->index;
 
-			if (node_is_reduced(tgt_node))
+			if (node_is_reduced(pbqp, tgt_node))
 				continue;
 
 			if (src_index < tgt_index) {
@@ -66,6 +66,15 @@ pbqp_t *alloc_pbqp(unsigned number_nodes)
 	pbqp->dump_file    = NULL;
 #endif
 	pbqp->nodes        = OALLOCNZ(&pbqp->obstack, pbqp_node_t*, number_nodes);
+	pbqp->edge_bucket    = NULL;
+	pbqp->rm_bucket      = NULL;
+	pbqp->reduced_bucket = NULL;
+	pbqp->merged_node    = NULL;
+	pbqp->buckets_filled = 0;
+	for (int i = 0; i < 4; ++i)
+		pbqp->node_buckets[i] = NULL;
+	pbqp->num_threads    = 1;
+	pbqp->sub_pbqps      = NULL;
 #if KAPS_STATISTIC
 	pbqp->num_bf       = 0;
 	pbqp->num_edges    = 0;
@@ -81,6 +90,11 @@ pbqp_t *alloc_pbqp(unsigned number_nodes)
 
 void free_pbqp(pbqp_t *pbqp)
 {
+	if (pbqp->sub_pbqps) {
+		for (size_t i = 0, n = ARR_LEN(pbqp->sub_pbqps); i < n; ++i)
+			free_pbqp(pbqp->sub_pbqps[i]);
+		DEL_ARR_F(pbqp->sub_pbqps);
+	}
 	obstack_free(&pbqp->obstack, NULL);
 	free(pbqp);
 }
@@ -145,6 +159,11 @@ num get_solution(pbqp_t *pbqp)
 	return pbqp->solution;
 }
 
+void set_num_threads(pbqp_t *pbqp, unsigned num_threads)
+{
+	pbqp->num_threads = num_threads > 0 ? num_threads : 1;
+}
+
 #if KAPS_DUMP
 void set_dumpfile(pbqp_t *pbqp, FILE *f)
 {
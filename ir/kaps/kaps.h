@@ -41,6 +41,12 @@ pbqp_node_t *get_node(pbqp_t *pbqp, unsigned index);
 num get_node_solution(pbqp_t *pbqp, unsigned node_index);
 num get_solution(pbqp_t *pbqp);
 
+/**
+ * Set the number of threads the co solvers use for independent connected
+ * components. The solution does not depend on it.
+ */
+void set_num_threads(pbqp_t *pbqp, unsigned num_threads);
+
 void set_dumpfile(pbqp_t *pbqp, FILE *f);
 
 #endif
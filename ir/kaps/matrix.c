@@ -16,6 +16,21 @@
 #include <assert.h>
 #include <string.h>
 
+/**
+ * Returns INF_COSTS if @p flag is INF_COSTS and @p elem otherwise. For
+ * unsigned costs this is a bit mask, which the compiler vectorizes more
+ * reliably than a select.
+ */
+static inline num mask_inf(num elem, num flag)
+{
+#if KAPS_USE_UNSIGNED
+	/* INF_COSTS has all bits set. */
+	return elem | (num)-(num)(flag == INF_COSTS);
+#else
+	return flag == INF_COSTS ? INF_COSTS : elem;
+#endif
+}
+
 pbqp_matrix_t *pbqp_matrix_alloc(pbqp_t *pbqp, unsigned rows, unsigned cols)
 {
 	assert(cols > 0);
@@ -77,7 +92,7 @@ void pbqp_matrix_add(pbqp_matrix_t *sum, pbqp_matrix_t *summand)
 	unsigned len = sum->rows * sum->cols;
 
 	for (unsigned i = 0; i < len; ++i) {
-		sum->entries[i] = pbqp_add(sum->entries[i], summand->entries[i]);
+		sum->entries[i] = pbqp_add_sat(sum->entries[i], summand->entries[i]);
 	}
 }
 
@@ -96,10 +111,11 @@ void pbqp_matrix_set_row_value(pbqp_matrix_t *mat, unsigned row, num value)
 {
 	assert(row < mat->rows);
 
-	unsigned col_len = mat->cols;
+	unsigned   col_len = mat->cols;
+	num *const entries = &mat->entries[row * col_len];
 
 	for (unsigned col_index = 0; col_index < col_len; ++col_index) {
-		mat->entries[row * mat->cols + col_index] = value;
+		entries[col_index] = value;
 	}
 }
 
@@ -121,16 +137,77 @@ num pbqp_matrix_get_col_min(pbqp_matrix_t *matrix, unsigned col_index, vector_t
 
 	for (unsigned row_index = 0; row_index < row_len; ++row_index) {
 		/* Ignore virtual deleted columns. */
+		num const flag = flags->entries[row_index].data;
+		num const elem = matrix->entries[row_index * col_len + col_index];
+		num const cand = mask_inf(elem, flag);
+
+		min = cand < min ? cand : min;
+	}
+
+	return min;
+}
+
+void pbqp_matrix_get_col_mins(pbqp_matrix_t *matrix, vector_t *flags, num *mins)
+{
+	unsigned col_len = matrix->cols;
+	unsigned row_len = matrix->rows;
+
+	assert(row_len == flags->len);
+
+	for (unsigned col_index = 0; col_index < col_len; ++col_index) {
+		mins[col_index] = INF_COSTS;
+	}
+
+	/* Walk the matrix row by row instead of each column separately. */
+	for (unsigned row_index = 0; row_index < row_len; ++row_index) {
+		/* Ignore virtual deleted rows. */
 		if (flags->entries[row_index].data == INF_COSTS) continue;
 
-		num elem = matrix->entries[row_index * col_len + col_index];
+		num const *const row = &matrix->entries[row_index * col_len];
+		for (unsigned col_index = 0; col_index < col_len; ++col_index) {
+			num const elem = row[col_index];
+			mins[col_index] = elem < mins[col_index] ? elem : mins[col_index];
+		}
+	}
+}
 
-		if (elem < min) {
-			min = elem;
+void pbqp_matrix_get_col_mins_plus(pbqp_matrix_t *matrix, vector_t *vec, num *mins)
+{
+	unsigned col_len = matrix->cols;
+	unsigned row_len = matrix->rows;
+
+	assert(row_len == vec->len);
+
+	for (unsigned col_index = 0; col_index < col_len; ++col_index) {
+		mins[col_index] = INF_COSTS;
+	}
+
+	for (unsigned row_index = 0; row_index < row_len; ++row_index) {
+		num        const value = vec->entries[row_index].data;
+		num const *const row   = &matrix->entries[row_index * col_len];
+		for (unsigned col_index = 0; col_index < col_len; ++col_index) {
+			num const sum = pbqp_add_sat(value, row[col_index]);
+			mins[col_index] = sum < mins[col_index] ? sum : mins[col_index];
 		}
 	}
+}
 
-	return min;
+void pbqp_matrix_get_row_mins_plus(pbqp_matrix_t *matrix, vector_t *vec, num *mins)
+{
+	unsigned col_len = matrix->cols;
+	unsigned row_len = matrix->rows;
+
+	assert(col_len == vec->len);
+
+	for (unsigned row_index = 0; row_index < row_len; ++row_index) {
+		num const *const row = &matrix->entries[row_index * col_len];
+		num              min = INF_COSTS;
+		for (unsigned col_index = 0; col_index < col_len; ++col_index) {
+			num const sum = pbqp_add_sat(vec->entries[col_index].data, row[col_index]);
+			min = sum < min ? sum : min;
+		}
+		mins[row_index] = min;
+	}
 }
 
 unsigned pbqp_matrix_get_col_min_index(pbqp_matrix_t *matrix, unsigned col_index, vector_t *flags)
@@ -178,6 +255,34 @@ void pbqp_matrix_sub_col_value(pbqp_matrix_t *matrix, unsigned col_index,
 	}
 }
 
+void pbqp_matrix_sub_col_values(pbqp_matrix_t *matrix, vector_t *flags,
+                                num const *values)
+{
+	unsigned col_len = matrix->cols;
+	unsigned row_len = matrix->rows;
+
+	assert(row_len == flags->len);
+
+	for (unsigned row_index = 0; row_index < row_len; ++row_index) {
+		num *const row = &matrix->entries[row_index * col_len];
+
+		if (flags->entries[row_index].data == INF_COSTS) {
+			for (unsigned col_index = 0; col_index < col_len; ++col_index) {
+				row[col_index] = values[col_index] != 0 ? 0 : row[col_index];
+			}
+			continue;
+		}
+
+		for (unsigned col_index = 0; col_index < col_len; ++col_index) {
+			num const elem  = row[col_index];
+			num const value = values[col_index];
+			/* inf - x = inf if x < inf */
+			row[col_index] = elem == INF_COSTS && value != INF_COSTS
+				? elem : elem - value;
+		}
+	}
+}
+
 num pbqp_matrix_get_row_min(pbqp_matrix_t *matrix, unsigned row_index, vector_t *flags)
 {
 	num      min = INF_COSTS;
@@ -185,15 +290,12 @@ num pbqp_matrix_get_row_min(pbqp_matrix_t *matrix, unsigned row_index, vector_t
 
 	assert(matrix->cols == len);
 
+	num const *const row = &matrix->entries[row_index * len];
 	for (unsigned col_index = 0; col_index < len; ++col_index) {
 		/* Ignore virtual deleted columns. */
-		if (flags->entries[col_index].data == INF_COSTS) continue;
-
-		num elem = matrix->entries[row_index * len + col_index];
+		num const cand = mask_inf(row[col_index], flags->entries[col_index].data);
 
-		if (elem < min) {
-			min = elem;
-		}
+		min = cand < min ? cand : min;
 	}
 
 	return min;
@@ -229,16 +331,13 @@ void pbqp_matrix_sub_row_value(pbqp_matrix_t *matrix, unsigned row_index,
 
 	assert(col_len == flags->len);
 
+	num *const row = &matrix->entries[row_index * col_len];
 	for (unsigned col_index = 0; col_index < col_len; ++col_index) {
-		if (flags->entries[col_index].data == INF_COSTS) {
-			matrix->entries[row_index * col_len + col_index] = 0;
-			continue;
-		}
+		num const elem = row[col_index];
 		/* inf - x = inf if x < inf */
-		if (matrix->entries[row_index * col_len + col_index] == INF_COSTS
-		    && value != INF_COSTS)
-			continue;
-		matrix->entries[row_index * col_len + col_index] -= value;
+		num const res  = elem == INF_COSTS && value != INF_COSTS
+			? elem : elem - value;
+		row[col_index] = flags->entries[col_index].data == INF_COSTS ? 0 : res;
 	}
 }
 
@@ -275,10 +374,11 @@ void pbqp_matrix_add_to_all_cols(pbqp_matrix_t *mat, vector_t *vec)
 	assert(row_len == vec->len);
 
 	for (unsigned row_index = 0; row_index < row_len; ++row_index) {
-		num value = vec->entries[row_index].data;
+		num const  value = vec->entries[row_index].data;
+		num *const row   = &mat->entries[row_index * col_len];
 
 		for (unsigned col_index = 0; col_index < col_len; ++col_index) {
-			mat->entries[row_index * col_len + col_index] = pbqp_add(mat->entries[row_index * col_len + col_index], value);
+			row[col_index] = pbqp_add_sat(row[col_index], value);
 		}
 	}
 }
@@ -291,10 +391,10 @@ void pbqp_matrix_add_to_all_rows(pbqp_matrix_t *mat, vector_t *vec)
 	assert(col_len == vec->len);
 
 	for (unsigned row_index = 0; row_index < row_len; ++row_index) {
-		for (unsigned col_index = 0; col_index < col_len; ++col_index) {
-			num value = vec->entries[col_index].data;
+		num *const row = &mat->entries[row_index * col_len];
 
-			mat->entries[row_index * col_len + col_index] = pbqp_add(mat->entries[row_index * col_len + col_index], value);
+		for (unsigned col_index = 0; col_index < col_len; ++col_index) {
+			row[col_index] = pbqp_add_sat(row[col_index], vec->entries[col_index].data);
 		}
 	}
 }
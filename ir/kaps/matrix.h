@@ -31,6 +31,26 @@ void pbqp_matrix_set(pbqp_matrix_t *mat, unsigned row, unsigned col, num value);
 num pbqp_matrix_get_col_min(pbqp_matrix_t *matrix, unsigned col_index, vector_t *flags);
 num pbqp_matrix_get_row_min(pbqp_matrix_t *matrix, unsigned row_index, vector_t *flags);
 
+/**
+ * Computes the minima of all columns ignoring the rows whose flag is
+ * INF_COSTS, like pbqp_matrix_get_col_min() for each column, in a single
+ * pass over the rows.
+ */
+void pbqp_matrix_get_col_mins(pbqp_matrix_t *matrix, vector_t *flags, num *mins);
+
+/**
+ * Computes for each column the minimum of @p vec plus the column, like
+ * vector_get_min() after vector_add_matrix_col(), in a single pass over the
+ * rows.
+ */
+void pbqp_matrix_get_col_mins_plus(pbqp_matrix_t *matrix, vector_t *vec, num *mins);
+
+/**
+ * Computes for each row the minimum of @p vec plus the row, like
+ * vector_get_min() after vector_add_matrix_row().
+ */
+void pbqp_matrix_get_row_mins_plus(pbqp_matrix_t *matrix, vector_t *vec, num *mins);
+
 unsigned pbqp_matrix_get_col_min_index(pbqp_matrix_t *matrix, unsigned col_index, vector_t *flags);
 unsigned pbqp_matrix_get_row_min_index(pbqp_matrix_t *matrix, unsigned row_index, vector_t *flags);
 
@@ -42,6 +62,14 @@ void pbqp_matrix_sub_col_value(pbqp_matrix_t *matrix, unsigned col_index,
 void pbqp_matrix_sub_row_value(pbqp_matrix_t *matrix, unsigned row_index,
                                vector_t *flags, num value);
 
+/**
+ * Like pbqp_matrix_sub_col_value() for each column with a non-zero value in
+ * @p values, but in a single pass over the rows. Columns with value 0 are left
+ * untouched.
+ */
+void pbqp_matrix_sub_col_values(pbqp_matrix_t *matrix, vector_t *flags,
+                                num const *values);
+
 int pbqp_matrix_is_zero(pbqp_matrix_t *mat, vector_t *src_vec, vector_t *tgt_vec);
 
 void pbqp_matrix_add_to_all_cols(pbqp_matrix_t *mat, vector_t *vec);
@@ -45,6 +45,14 @@ struct pbqp_t {
 	size_t         num_nodes;          /* Number of PBQP nodes. */
 	pbqp_node_t  **nodes;              /* Nodes of PBQP. */
 	FILE          *dump_file;          /* File to dump in. */
+	pbqp_edge_t  **edge_bucket;        /* Edges to simplify. */
+	pbqp_edge_t  **rm_bucket;          /* Edges to merge in RM. */
+	pbqp_node_t  **node_buckets[4];    /* Unreduced nodes by degree. */
+	pbqp_node_t  **reduced_bucket;     /* Nodes to back propagate. */
+	pbqp_node_t   *merged_node;        /* Node to reduce by RN next. */
+	int            buckets_filled;     /* Node buckets track degrees. */
+	unsigned       num_threads;        /* Threads solving components. */
+	pbqp_t       **sub_pbqps;          /* Instances that solved components. */
 #if KAPS_STATISTIC
 	unsigned       num_bf;             /* Number of brute force reductions. */
 	unsigned       num_edges;          /* Number of independent edges. */
@@ -64,7 +64,7 @@ void vector_add(vector_t *sum, vector_t *summand)
 	assert(len == summand->len);
 
 	for (unsigned i = 0; i < len; ++i) {
-		sum->entries[i].data = pbqp_add(sum->entries[i].data, summand->entries[i].data);
+		sum->entries[i].data = pbqp_add_sat(sum->entries[i].data, summand->entries[i].data);
 	}
 }
 
@@ -87,7 +87,7 @@ void vector_add_value(vector_t *vec, num value)
 	unsigned len = vec->len;
 
 	for (unsigned index = 0; index < len; ++index) {
-		vec->entries[index].data = pbqp_add(vec->entries[index].data, value);
+		vec->entries[index].data = pbqp_add_sat(vec->entries[index].data, value);
 	}
 }
 
@@ -99,7 +99,7 @@ void vector_add_matrix_col(vector_t *vec, pbqp_matrix_t *mat, unsigned col_index
 	assert(col_index < mat->cols);
 
 	for (unsigned index = 0; index < len; ++index) {
-		vec->entries[index].data = pbqp_add(vec->entries[index].data, mat->entries[index * mat->cols + col_index]);
+		vec->entries[index].data = pbqp_add_sat(vec->entries[index].data, mat->entries[index * mat->cols + col_index]);
 	}
 }
 
@@ -111,8 +111,9 @@ void vector_add_matrix_row(vector_t *vec, pbqp_matrix_t *mat, unsigned row_index
 	assert(row_index < mat->rows);
 
 
+	num const *const row = &mat->entries[row_index * mat->cols];
 	for (unsigned index = 0; index < len; ++index) {
-		vec->entries[index].data = pbqp_add(vec->entries[index].data, mat->entries[row_index * mat->cols + index]);
+		vec->entries[index].data = pbqp_add_sat(vec->entries[index].data, row[index]);
 	}
 }
 
@@ -13,9 +13,27 @@
 #define KAPS_VECTOR_H
 
 #include "vector_t.h"
+#include <assert.h>
 
 num pbqp_add(num x, num y);
 
+/**
+ * Adds two costs like pbqp_add(). For unsigned costs this has no branches, so
+ * loops using it can be vectorized.
+ */
+static inline num pbqp_add_sat(num x, num y)
+{
+#if KAPS_USE_UNSIGNED
+	num const res = x + y;
+	assert(x == INF_COSTS || y == INF_COSTS || (res >= x && res < INF_COSTS));
+	/* Adding anything but 0 to INF_COSTS overflows, and INF_COSTS has all
+	 * bits set. */
+	return res | (num)-(num)(res < x);
+#else
+	return pbqp_add(x, y);
+#endif
+}
+
 vector_t *vector_alloc(pbqp_t *pbqp, unsigned length);
 
 /* Copy the given vector. */
@@ -475,6 +475,30 @@ void lc_opt_print_help_for_entry(lc_opt_entry_t *ent, char separator, FILE *f)
 	lc_opt_print_help_rec(ent, separator, ent, f);
 }
 
+static void lc_opt_visit_values_rec(lc_opt_entry_t *ent, lc_opt_entry_t *stop_ent,
+                                    lc_opt_visit_t *visit, void *data)
+{
+	lc_grp_special_t *s = lc_get_grp_special(ent);
+	char name[512];
+	char value[256];
+
+	list_for_each_entry(lc_opt_entry_t, e, &s->opts, list) {
+		value[0] = '\0';
+		lc_opt_print_grp_path(name, sizeof(name), e, '-', stop_ent);
+		lc_opt_value_to_string(value, sizeof(value), e);
+		visit(data, name, value);
+	}
+
+	list_for_each_entry(lc_opt_entry_t, e, &s->grps, list) {
+		lc_opt_visit_values_rec(e, stop_ent, visit, data);
+	}
+}
+
+void lc_opt_visit_values(lc_opt_entry_t *grp, lc_opt_visit_t *visit, void *data)
+{
+	lc_opt_visit_values_rec(grp, grp, visit, data);
+}
+
 int lc_opt_from_single_arg(const lc_opt_entry_t *root, const char *arg)
 {
 	const lc_opt_entry_t *grp = root;
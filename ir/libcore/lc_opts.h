@@ -188,6 +188,21 @@ void lc_opt_print_help_for_entry(lc_opt_entry_t *ent, char separator, FILE *f);
 
 bool lc_opt_add_table(lc_opt_entry_t *grp, const lc_opt_table_entry_t *table);
 
+/**
+ * Called by lc_opt_visit_values() for every option.
+ * @param data   The data passed to lc_opt_visit_values().
+ * @param name   The path of the option below the visited group.
+ * @param value  The current value of the option.
+ */
+typedef void (lc_opt_visit_t)(void *data, const char *name, const char *value);
+
+/**
+ * Calls @p visit for every option in @p grp and its subgroups. Options and
+ * groups are visited in the order they were added.
+ */
+void lc_opt_visit_values(lc_opt_entry_t *grp, lc_opt_visit_t *visit,
+                         void *data);
+
 /**
  * Set options from a single (command line) argument.
  * @param root          The root group we start resolving from.
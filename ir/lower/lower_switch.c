@@ -7,8 +7,17 @@
  * @file
  * @brief   Lowering of Switches if necessary or advantageous.
  * @author  Moritz Kroll
+ *
+ * Switches, which are too sparse for a single jump table, are split into
+ * clusters of cases: dense clusters become smaller jump tables, clusters
+ * with few targets in a small range become bit tests and the remaining cases
+ * are compared one by one. A binary search tree selects the cluster. If
+ * execution frequencies are available, the tree is balanced by frequency
+ * instead of by the number of cases, so hot cases are reached with fewer
+ * compares.
  */
 #include "array.h"
+#include "execfreq.h"
 #include "ircons.h"
 #include "irgopt.h"
 #include "irgwalk.h"
@@ -18,6 +27,8 @@
 #include "lowering.h"
 #include "panic.h"
 #include "util.h"
+#include <limits.h>
+#include <math.h>
 #include <stdbool.h>
 
 typedef struct walk_env_t {
@@ -29,11 +40,25 @@ typedef struct walk_env_t {
 } walk_env_t;
 
 typedef struct target_t {
-	ir_node *block;     /**< block that is targetted */
-	uint16_t n_entries; /**< number of table entries targetting this block */
-	uint16_t i;
+	ir_node  *block;     /**< block that is targetted */
+	ir_node **preds;     /**< the new control flow predecessors of block */
+	unsigned  n_entries; /**< number of table entries targetting this block */
 } target_t;
 
+typedef enum cluster_kind_t {
+	CLUSTER_CASE,    /**< a single table entry */
+	CLUSTER_TABLE,   /**< a dense range of entries, lowered to a Switch */
+	CLUSTER_BITTEST, /**< entries with few targets in a small range */
+} cluster_kind_t;
+
+/** A range of consecutive entries of the sorted switch table. */
+typedef struct cluster_t {
+	cluster_kind_t               kind;
+	const ir_switch_table_entry *entries;
+	unsigned                     n_entries;
+	double                       weight;  /**< expected frequency */
+} cluster_t;
+
 typedef struct switch_info_t {
 	ir_node     *switchn;
 	ir_tarval   *switch_min;
@@ -42,8 +67,22 @@ typedef struct switch_info_t {
 	unsigned     num_cases;
 	target_t    *targets;
 	ir_node    **defusers;    /**< the Projs pointing to the default case */
+	walk_env_t  *env;
+	bool         have_freq;   /**< execution frequencies are available */
 } switch_info_t;
 
+/** A target of a bit test cluster. */
+typedef struct bittest_target_t {
+	unsigned   pn;
+	ir_tarval *mask;   /**< the values reaching the target */
+	double     weight; /**< expected frequency */
+} bittest_target_t;
+
+/** Maximal number of targets of a bit test cluster. */
+#define MAX_BITTEST_TARGETS 3
+/** Minimal percentage of values with a case of a jump table cluster. */
+#define MIN_TABLE_DENSITY   40
+
 /**
  * analyze enough to decide if we should lower the switch
  */
@@ -91,6 +130,7 @@ static void analyse_switch1(switch_info_t *info)
 		assert((unsigned)pn < n_outs);
 		assert(targets[(unsigned)pn].block == NULL);
 		targets[(unsigned)pn].block = target;
+		targets[(unsigned)pn].preds = NEW_ARR_F(ir_node*, 0);
 	}
 
 	const ir_switch_table *table = get_Switch_table(switchn);
@@ -284,64 +324,418 @@ static ir_node *create_case_cond(const ir_switch_table_entry *entry,
 	if (entry->min == entry->max) {
 		cmp = new_rd_Cmp(dbgi, block, selector, minconst, ir_relation_equal);
 	} else {
-		ir_tarval *adjusted_max = tarval_sub(entry->max, entry->min);
+		/* compare unsigned, so values below min are out of range, too */
+		ir_mode   *umode        = find_unsigned_mode(get_irn_mode(selector));
+		ir_tarval *adjusted_max = tarval_convert_to(
+			tarval_sub(entry->max, entry->min), umode);
 		ir_node   *sub          = new_rd_Sub(dbgi, block, selector, minconst);
+		if (get_irn_mode(sub) != umode)
+			sub = new_rd_Conv(dbgi, block, sub, umode);
 		ir_node   *maxconst     = new_r_Const(irg, adjusted_max);
 		cmp = new_rd_Cmp(dbgi, block, sub, maxconst, ir_relation_less_equal);
 	}
 	return new_rd_Cond(dbgi, block, cmp);
 }
 
-static void connect_to_target(target_t *target, ir_node *cf)
+/**
+ * Returns the number of values in [min, max] or 0 if it does not fit into
+ * a long.
+ */
+static unsigned long get_range_size(ir_tarval *min, ir_tarval *max,
+                                    ir_mode *mode)
 {
-	ir_node *block     = target->block;
-	unsigned n_entries = target->n_entries;
-	if (get_Block_n_cfgpreds(block) != (int)n_entries) {
-		ir_node **new_in = ALLOCAN(ir_node*, n_entries);
-		ir_graph *irg    = get_irn_irg(block);
-		ir_node  *dummy  = new_r_Dummy(irg, mode_X);
-		for (unsigned i = 0; i < n_entries; ++i) {
-			new_in[i] = dummy;
+	ir_mode   *umode = find_unsigned_mode(mode);
+	ir_tarval *diff  = tarval_sub(tarval_convert_to(max, umode),
+	                              tarval_convert_to(min, umode));
+	if (!tarval_is_long(diff))
+		return 0;
+	long d = get_tarval_long(diff);
+	return d < LONG_MAX ? (unsigned long)d + 1 : 0;
+}
+
+/**
+ * Returns the expected frequency of the table entry @p entry, which is the
+ * frequency of its target shared among all entries with this target.
+ */
+static double get_entry_weight(const switch_info_t *info,
+                               const ir_switch_table_entry *entry)
+{
+	if (!info->have_freq)
+		return 1.0;
+	const target_t *target = &info->targets[entry->pn];
+	return get_block_execfreq(target->block) / target->n_entries;
+}
+
+static bool is_table_cluster(const switch_info_t *info, unsigned n_entries,
+                             unsigned long n_values, unsigned long range)
+{
+	return n_entries > info->env->small_switch
+	    && range - n_values < info->env->spare_size
+	    && n_values * 100 >= range * MIN_TABLE_DENSITY;
+}
+
+static bool is_bittest_cluster(const switch_info_t *info,
+                               const ir_switch_table_entry *entries,
+                               unsigned n_entries, unsigned long range)
+{
+	if (range > get_mode_size_bits(info->env->selector_mode))
+		return false;
+	unsigned pns[MAX_BITTEST_TARGETS];
+	unsigned n_pns = 0;
+	for (unsigned e = 0; e < n_entries; ++e) {
+		unsigned i = 0;
+		while (i < n_pns && pns[i] != entries[e].pn)
+			++i;
+		if (i == n_pns) {
+			if (n_pns == MAX_BITTEST_TARGETS)
+				return false;
+			pns[n_pns++] = entries[e].pn;
 		}
-		set_irn_in(block, n_entries, new_in);
-		assert(target->i == 0);
 	}
-	assert(target->i < n_entries);
-	set_Block_cfgpred(target->block, target->i++, cf);
+	/* the bit test must save enough compares: a range check and one test
+	 * per target replace one compare per entry */
+	static const unsigned min_entries[] = { 0, 3, 5, 6 };
+	return n_entries >= min_entries[n_pns];
 }
 
 /**
- * Creates an if cascade realizing binary search.
+ * Partitions the sorted table entries into as few clusters as possible.
+ */
+static cluster_t *create_clusters(const switch_info_t *info,
+                                  const ir_switch_table_entry *entries,
+                                  unsigned n_entries)
+{
+	ir_mode        *mode      = get_irn_mode(get_Switch_selector(info->switchn));
+	unsigned long   max_range = get_mode_size_bits(info->env->selector_mode);
+	unsigned       *best      = XMALLOCN(unsigned, n_entries + 1);
+	unsigned       *end       = XMALLOCN(unsigned, n_entries);
+	cluster_kind_t *kind      = XMALLOCN(cluster_kind_t, n_entries);
+
+	best[n_entries] = 0;
+	for (unsigned i = n_entries; i-- > 0;) {
+		best[i] = best[i + 1] + 1;
+		end[i]  = i + 1;
+		kind[i] = CLUSTER_CASE;
+
+		unsigned long n_values = get_range_size(entries[i].min,
+		                                        entries[i].max, mode);
+		for (unsigned j = i + 1; j < n_entries && n_values != 0; ++j) {
+			unsigned long size  = get_range_size(entries[j].min,
+			                                     entries[j].max, mode);
+			unsigned long range = get_range_size(entries[i].min,
+			                                     entries[j].max, mode);
+			if (size == 0 || range == 0)
+				break;
+			n_values += size;
+			if (range - n_values >= info->env->spare_size && range > max_range)
+				break;
+
+			unsigned n = j - i + 1;
+			cluster_kind_t k;
+			if (is_bittest_cluster(info, &entries[i], n, range))
+				k = CLUSTER_BITTEST;
+			else if (is_table_cluster(info, n, n_values, range))
+				k = CLUSTER_TABLE;
+			else
+				continue;
+			if (best[j + 1] + 1 <= best[i]) {
+				best[i] = best[j + 1] + 1;
+				end[i]  = j + 1;
+				kind[i] = k;
+			}
+		}
+	}
+
+	cluster_t *clusters = NEW_ARR_F(cluster_t, 0);
+	for (unsigned i = 0; i < n_entries; i = end[i]) {
+		cluster_t cluster = {
+			.kind      = kind[i],
+			.entries   = &entries[i],
+			.n_entries = end[i] - i,
+			.weight    = 0,
+		};
+		for (unsigned e = i; e < end[i]; ++e)
+			cluster.weight += get_entry_weight(info, &entries[e]);
+		ARR_APP1(cluster_t, clusters, cluster);
+	}
+
+	free(kind);
+	free(end);
+	free(best);
+	return clusters;
+}
+
+static ir_tarval *get_cluster_min(const cluster_t *cluster)
+{
+	return cluster->entries[0].min;
+}
+
+static ir_tarval *get_cluster_max(const cluster_t *cluster)
+{
+	return cluster->entries[cluster->n_entries - 1].max;
+}
+
+static void add_pred(switch_info_t *info, unsigned pn, ir_node *cf)
+{
+	ARR_APP1(ir_node*, info->targets[pn].preds, cf);
+}
+
+/**
+ * Returns the selector minus the minimum of @p cluster in the unsigned mode.
+ * If the selector is not known to be inside the cluster, a range check is
+ * created and @p block is updated to the block after the check.
+ */
+static ir_node *create_cluster_selector(switch_info_t *info,
+                                        const cluster_t *cluster,
+                                        ir_node **block, ir_tarval *lo,
+                                        ir_tarval *hi)
+{
+	ir_graph  *irg      = get_irn_irg(*block);
+	dbg_info  *dbgi     = get_irn_dbg_info(info->switchn);
+	ir_node   *selector = get_Switch_selector(info->switchn);
+	ir_mode   *mode     = get_irn_mode(selector);
+	ir_mode   *umode    = find_unsigned_mode(mode);
+	ir_tarval *min      = get_cluster_min(cluster);
+	ir_tarval *max      = get_cluster_max(cluster);
+
+	ir_node *sel = selector;
+	if (!tarval_is_null(min))
+		sel = new_rd_Sub(dbgi, *block, sel, new_r_Const(irg, min));
+	if (umode != mode)
+		sel = new_rd_Conv(dbgi, *block, sel, umode);
+
+	if ((tarval_cmp(lo, min) & ir_relation_less)
+	 || (tarval_cmp(hi, max) & ir_relation_greater)) {
+		ir_tarval *range = tarval_convert_to(tarval_sub(max, min), umode);
+		ir_node   *cmp   = new_rd_Cmp(dbgi, *block, sel,
+		                              new_r_Const(irg, range),
+		                              ir_relation_less_equal);
+		ir_node   *cond  = new_rd_Cond(dbgi, *block, cmp);
+		ir_node   *in[]  = { new_r_Proj(cond, mode_X, pn_Cond_true) };
+		ARR_APP1(ir_node*, info->defusers,
+		         new_r_Proj(cond, mode_X, pn_Cond_false));
+		*block = new_r_Block(irg, ARRAY_SIZE(in), in);
+	}
+	return sel;
+}
+
+/**
+ * Creates a Switch with a table covering only the entries of @p cluster.
+ */
+static void create_table(switch_info_t *info, const cluster_t *cluster,
+                         ir_node *block, ir_tarval *lo, ir_tarval *hi)
+{
+	ir_node   *sel           = create_cluster_selector(info, cluster, &block,
+	                                                   lo, hi);
+	ir_graph  *irg           = get_irn_irg(block);
+	dbg_info  *dbgi          = get_irn_dbg_info(info->switchn);
+	ir_mode   *selector_mode = info->env->selector_mode;
+	ir_tarval *delta         = get_cluster_min(cluster);
+	if (get_irn_mode(sel) != selector_mode)
+		sel = new_rd_Conv(dbgi, block, sel, selector_mode);
+
+	/* number the targets of the cluster, 0 is the default */
+	unsigned  n_entries = cluster->n_entries;
+	unsigned *new_pns   = XMALLOCNZ(unsigned, get_Switch_n_outs(info->switchn));
+	unsigned *old_pns   = XMALLOCN(unsigned, n_entries + 1);
+	unsigned  n_outs    = 1;
+	for (unsigned e = 0; e < n_entries; ++e) {
+		unsigned pn = cluster->entries[e].pn;
+		if (new_pns[pn] == 0) {
+			new_pns[pn]       = n_outs;
+			old_pns[n_outs++] = pn;
+		}
+	}
+
+	ir_mode         *umode = find_unsigned_mode(get_tarval_mode(delta));
+	ir_switch_table *table = ir_new_switch_table(irg, n_entries);
+	for (unsigned e = 0; e < n_entries; ++e) {
+		const ir_switch_table_entry *entry = &cluster->entries[e];
+		ir_tarval *min = tarval_convert_to(tarval_sub(entry->min, delta), umode);
+		ir_tarval *max = tarval_convert_to(tarval_sub(entry->max, delta), umode);
+		ir_switch_table_set(table, e, tarval_convert_to(min, selector_mode),
+		                    tarval_convert_to(max, selector_mode),
+		                    new_pns[entry->pn]);
+	}
+
+	ir_node *switchn = new_rd_Switch(dbgi, block, sel, n_outs, table);
+	/* the block walker may still visit the new blocks */
+	ir_nodeset_insert(&info->env->processed, switchn);
+	ARR_APP1(ir_node*, info->defusers,
+	         new_r_Proj(switchn, mode_X, pn_Switch_default));
+	for (unsigned pn = 1; pn < n_outs; ++pn)
+		add_pred(info, old_pns[pn], new_r_Proj(switchn, mode_X, pn));
+
+	free(old_pns);
+	free(new_pns);
+}
+
+/**
+ * Creates tests of a bit mask, which has a bit for each value of
+ * @p cluster reaching a target.
+ */
+static void create_bittest(switch_info_t *info, const cluster_t *cluster,
+                           ir_node *block, ir_tarval *lo, ir_tarval *hi)
+{
+	ir_node  *sel   = create_cluster_selector(info, cluster, &block, lo, hi);
+	ir_graph *irg   = get_irn_irg(block);
+	dbg_info *dbgi  = get_irn_dbg_info(info->switchn);
+	ir_mode  *mode  = info->env->selector_mode;
+	ir_mode  *smode = get_irn_mode(get_Switch_selector(info->switchn));
+
+	/* collect the masks of the targets */
+	bittest_target_t targets[MAX_BITTEST_TARGETS];
+	unsigned         n_targets = 0;
+	ir_tarval       *delta     = get_cluster_min(cluster);
+	for (unsigned e = 0; e < cluster->n_entries; ++e) {
+		const ir_switch_table_entry *entry = &cluster->entries[e];
+		unsigned i = 0;
+		while (i < n_targets && targets[i].pn != entry->pn)
+			++i;
+		if (i == n_targets) {
+			targets[i].pn     = entry->pn;
+			targets[i].mask   = get_mode_null(mode);
+			targets[i].weight = 0;
+			++n_targets;
+		}
+		unsigned long first = get_range_size(delta, entry->min, smode) - 1;
+		unsigned long size  = get_range_size(entry->min, entry->max, smode);
+		for (unsigned long b = first; b < first + size; ++b) {
+			ir_tarval *bit = tarval_shl_unsigned(get_mode_one(mode), b);
+			targets[i].mask = tarval_or(targets[i].mask, bit);
+		}
+		targets[i].weight += get_entry_weight(info, entry);
+	}
+
+	/* test the most frequent targets first */
+	ir_tarval *all = get_mode_null(mode);
+	for (unsigned i = 0; i < n_targets; ++i) {
+		for (unsigned j = i + 1; j < n_targets; ++j) {
+			if (targets[j].weight > targets[i].weight) {
+				bittest_target_t tmp = targets[i];
+				targets[i] = targets[j];
+				targets[j] = tmp;
+			}
+		}
+		all = tarval_or(all, targets[i].mask);
+	}
+	unsigned long range = get_range_size(delta, get_cluster_max(cluster),
+	                                     smode);
+	ir_tarval *full = range == get_mode_size_bits(mode)
+		? get_mode_all_one(mode)
+		: tarval_sub(tarval_shl_unsigned(get_mode_one(mode), range),
+		             get_mode_one(mode));
+
+	ir_node *one  = new_r_Const(irg, get_mode_one(mode));
+	ir_node *bit  = new_rd_Shl(dbgi, block, one, sel);
+	ir_node *zero = new_r_Const(irg, get_mode_null(mode));
+	for (unsigned i = 0; i < n_targets; ++i) {
+		unsigned pn = targets[i].pn;
+		/* if all values reach a target, the last test is not needed */
+		if (i == n_targets - 1 && all == full) {
+			add_pred(info, pn, new_r_Jmp(block));
+			return;
+		}
+		ir_node *and  = new_rd_And(dbgi, block, bit,
+		                           new_r_Const(irg, targets[i].mask));
+		ir_node *cmp  = new_rd_Cmp(dbgi, block, and, zero,
+		                           ir_relation_less_greater);
+		ir_node *cond = new_rd_Cond(dbgi, block, cmp);
+		add_pred(info, pn, new_r_Proj(cond, mode_X, pn_Cond_true));
+		ir_node *in[] = { new_r_Proj(cond, mode_X, pn_Cond_false) };
+		block = new_r_Block(irg, ARRAY_SIZE(in), in);
+	}
+	ARR_APP1(ir_node*, info->defusers, new_r_Jmp(block));
+}
+
+/**
+ * Creates the code for a single cluster. The selector is known to be in the
+ * range [lo, hi].
+ */
+static void create_cluster(switch_info_t *info, const cluster_t *cluster,
+                           ir_node *block, ir_tarval *lo, ir_tarval *hi)
+{
+	switch (cluster->kind) {
+	case CLUSTER_TABLE:
+		create_table(info, cluster, block, lo, hi);
+		return;
+	case CLUSTER_BITTEST:
+		create_bittest(info, cluster, block, lo, hi);
+		return;
+	case CLUSTER_CASE: {
+		const ir_switch_table_entry *entry = cluster->entries;
+		if (lo == entry->min && hi == entry->max) {
+			add_pred(info, entry->pn, new_r_Jmp(block));
+			return;
+		}
+		dbg_info *dbgi      = get_irn_dbg_info(info->switchn);
+		ir_node  *selector  = get_Switch_selector(info->switchn);
+		ir_node  *cond      = create_case_cond(entry, dbgi, block, selector);
+		ir_node  *trueproj  = new_r_Proj(cond, mode_X, pn_Cond_true);
+		ir_node  *falseproj = new_r_Proj(cond, mode_X, pn_Cond_false);
+		add_pred(info, entry->pn, trueproj);
+		ARR_APP1(ir_node*, info->defusers, falseproj);
+		return;
+	}
+	}
+	panic("invalid cluster kind");
+}
+
+/**
+ * Returns the index of the first cluster of the right half of a search tree
+ * over @p clusters, which splits the expected frequency in halves.
+ */
+static unsigned find_split(const cluster_t *clusters, unsigned n_clusters)
+{
+	double total = 0;
+	for (unsigned c = 0; c < n_clusters; ++c)
+		total += clusters[c].weight;
+	if (total <= 0)
+		return n_clusters / 2;
+
+	unsigned best      = 1;
+	double   best_diff = total;
+	double   left      = 0;
+	for (unsigned c = 1; c < n_clusters; ++c) {
+		left += clusters[c - 1].weight;
+		double diff = fabs(2 * left - total);
+		if (diff < best_diff) {
+			best      = c;
+			best_diff = diff;
+		}
+	}
+	return best;
+}
+
+/**
+ * Creates an if cascade realizing binary search over the clusters. The
+ * selector is known to be in the range [lo, hi].
  */
 static void create_if_cascade(switch_info_t *info, ir_node *block,
-                              ir_switch_table_entry *curcases,
-                              unsigned numcases)
+                              cluster_t *clusters, unsigned n_clusters,
+                              ir_tarval *lo, ir_tarval *hi)
 {
 	ir_graph      *irg      = get_irn_irg(block);
 	const ir_node *switchn  = info->switchn;
 	dbg_info      *dbgi     = get_irn_dbg_info(switchn);
 	ir_node       *selector = get_Switch_selector(switchn);
 
-	if (numcases == 0) {
+	if (n_clusters == 0) {
 		/* zero cases: "goto default;" */
 		ARR_APP1(ir_node*, info->defusers, new_r_Jmp(block));
-	} else if (numcases == 1) {
-		/*only one case: "if (sel == val) goto target else goto default;"*/
-		const ir_switch_table_entry *entry = &curcases[0];
-		ir_node *cond      = create_case_cond(entry, dbgi, block, selector);
-		ir_node *trueproj  = new_r_Proj(cond, mode_X, pn_Cond_true);
-		ir_node *falseproj = new_r_Proj(cond, mode_X, pn_Cond_false);
-
-		connect_to_target(&info->targets[entry->pn], trueproj);
-		ARR_APP1(ir_node*, info->defusers, falseproj);
-	} else if (numcases == 2) {
-		/* only two cases: "if (sel == val[0]) goto target[0];" */
-		const ir_switch_table_entry *entry0 = &curcases[0];
-		const ir_switch_table_entry *entry1 = &curcases[1];
+	} else if (n_clusters == 1) {
+		create_cluster(info, &clusters[0], block, lo, hi);
+	} else if (n_clusters == 2 && clusters[0].kind == CLUSTER_CASE
+	           && clusters[1].kind == CLUSTER_CASE) {
+		/* only two cases: "if (sel == val[0]) goto target[0];", test the more
+		 * frequent one first */
+		unsigned first = clusters[1].weight > clusters[0].weight;
+		const ir_switch_table_entry *entry0 = clusters[first].entries;
+		const ir_switch_table_entry *entry1 = clusters[1 - first].entries;
 		ir_node *cond      = create_case_cond(entry0, dbgi, block, selector);
 		ir_node *trueproj  = new_r_Proj(cond, mode_X, pn_Cond_true);
 		ir_node *falseproj = new_r_Proj(cond, mode_X, pn_Cond_false);
-		connect_to_target(&info->targets[entry0->pn], trueproj);
+		add_pred(info, entry0->pn, trueproj);
 
 		ir_node *in[]    = { falseproj };
 		ir_node *neblock = new_r_Block(irg, ARRAY_SIZE(in), in);
@@ -350,15 +744,16 @@ static void create_if_cascade(switch_info_t *info, ir_node *block,
 		ir_node *cond1      = create_case_cond(entry1, dbgi, neblock, selector);
 		ir_node *trueproj1  = new_r_Proj(cond1, mode_X, pn_Cond_true);
 		ir_node *falseproj1 = new_r_Proj(cond1, mode_X, pn_Cond_false);
-		connect_to_target(&info->targets[entry1->pn], trueproj1);
+		add_pred(info, entry1->pn, trueproj1);
 		ARR_APP1(ir_node*, info->defusers, falseproj1);
 	} else {
-		/* recursive case: split cases in the middle */
-		unsigned midcase = numcases / 2;
-		const ir_switch_table_entry *entry = &curcases[midcase];
-		ir_node *val = new_r_Const(irg, entry->min);
-		ir_node *cmp = new_rd_Cmp(dbgi, block, selector, val, ir_relation_less);
-		ir_node *cond = new_rd_Cond(dbgi, block, cmp);
+		/* recursive case: split clusters at the median frequency */
+		unsigned   midcase = find_split(clusters, n_clusters);
+		ir_tarval *mid     = get_cluster_min(&clusters[midcase]);
+		ir_node   *val     = new_r_Const(irg, mid);
+		ir_node   *cmp     = new_rd_Cmp(dbgi, block, selector, val,
+		                                 ir_relation_less);
+		ir_node   *cond    = new_rd_Cond(dbgi, block, cmp);
 
 		ir_node *ltin[]  = { new_r_Proj(cond, mode_X, pn_Cond_true) };
 		ir_node *ltblock = new_r_Block(irg, ARRAY_SIZE(ltin), ltin);
@@ -366,8 +761,10 @@ static void create_if_cascade(switch_info_t *info, ir_node *block,
 		ir_node *gein[]  = { new_r_Proj(cond, mode_X, pn_Cond_false) };
 		ir_node *geblock = new_r_Block(irg, ARRAY_SIZE(gein), gein);
 
-		create_if_cascade(info, ltblock, curcases, midcase);
-		create_if_cascade(info, geblock, curcases + midcase, numcases - midcase);
+		ir_tarval *left_hi = tarval_sub(mid, get_mode_one(get_tarval_mode(mid)));
+		create_if_cascade(info, ltblock, clusters, midcase, lo, left_hi);
+		create_if_cascade(info, geblock, clusters + midcase,
+		                  n_clusters - midcase, mid, hi);
 	}
 }
 
@@ -423,15 +820,35 @@ static void find_switch_nodes(ir_node *block, void *ctx)
 	analyse_switch1(&info);
 
 	/* Now create the if cascade */
-	env->changed  = true;
-	info.defusers = NEW_ARR_F(ir_node*, 0);
-	block         = get_nodes_block(switchn);
-	ir_switch_table *table = get_Switch_table(switchn);
-	create_if_cascade(&info, block, table->entries, table->n_entries);
-
-	/* Connect new default case users */
+	env->changed   = true;
+	info.env       = env;
+	info.defusers  = NEW_ARR_F(ir_node*, 0);
+	block          = get_nodes_block(switchn);
+	ir_graph *irg  = get_irn_irg(block);
+	info.have_freq = get_block_execfreq(get_irg_start_block(irg)) > 0;
+	ir_switch_table *table    = get_Switch_table(switchn);
+	cluster_t       *clusters = create_clusters(&info, table->entries,
+	                                            table->n_entries);
+	create_if_cascade(&info, block, clusters, ARR_LEN(clusters),
+	                  get_mode_min(selector_mode), get_mode_max(selector_mode));
+
+	/* Connect new case and default users */
+	unsigned n_outs = get_Switch_n_outs(switchn);
+	for (unsigned pn = 0; pn < n_outs; ++pn) {
+		target_t *target = &info.targets[pn];
+		if (target->block == NULL)
+			continue;
+		if (pn != pn_Switch_default) {
+			/* a target without table entries is unreachable now */
+			if (ARR_LEN(target->preds) == 0)
+				ARR_APP1(ir_node*, target->preds, new_r_Bad(irg, mode_X));
+			set_irn_in(target->block, ARR_LEN(target->preds), target->preds);
+		}
+		DEL_ARR_F(target->preds);
+	}
 	set_irn_in(info.default_block, ARR_LEN(info.defusers), info.defusers);
 
+	DEL_ARR_F(clusters);
 	DEL_ARR_F(info.defusers);
 	free(info.targets);
 }
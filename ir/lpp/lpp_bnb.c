@@ -0,0 +1,1131 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2016 University of Karlsruhe.
+ */
+
+/**
+ * @file
+ * @brief   Built-in branch and bound solver for problems with continuous and
+ *          binary variables.
+ *
+ * The LP relaxations are solved with a bounded dual simplex method on the
+ * sparse constraint matrix. The basis inverse is kept in product form (a
+ * sequence of eta columns) and rebuilt every REFACTOR_INTERVAL pivots. Fixing
+ * a variable keeps the optimal basis of a relaxation dual feasible, so every
+ * node of the search is warm started from the basis of the node solved
+ * before.
+ *
+ * The search is depth first and fixes the most fractional binary variable to
+ * its nearest value first. Start values given with lpp_set_start_value() are
+ * the initial incumbent if they are feasible, and the search stops as soon as
+ * the incumbent reaches a bound given with lpp_set_bound().
+ *
+ * Internally the objective is always minimized, and every constraint row i
+ * gets a logical variable s_i, so that the constraints read A x + s = b with
+ *   - less equal:    s_i in [0, inf]
+ *   - greater equal: s_i in [-inf, 0]
+ *   - equal:         s_i in [0, 0]
+ */
+#include "lpp_bnb.h"
+
+#include "array.h"
+#include "timing.h"
+#include "util.h"
+#include "xmalloc.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** Tolerance for bound violations of variables. */
+#define PRIMAL_TOL        1e-7
+/** Tolerance for reduced costs with the wrong sign. */
+#define DUAL_TOL          1e-7
+/** Smallest absolute value accepted as pivot element. */
+#define PIVOT_TOL         1e-7
+/** Entries of transformed vectors below this are dropped. */
+#define DROP_TOL          1e-12
+/** Tolerance for values of binary variables. */
+#define INT_TOL           1e-6
+/** Value used for nonbasic variables at an infinite bound. */
+#define ARTIFICIAL_BOUND  1e7
+/** Number of basis changes after which the basis inverse is rebuilt. */
+#define REFACTOR_INTERVAL 64
+/** Number of simplex iterations between checks of time limit and cutoff. */
+#define CHECK_INTERVAL    64
+
+typedef enum var_status_t {
+	AT_LB,  /**< nonbasic at its lower bound */
+	AT_UB,  /**< nonbasic at its upper bound */
+	BASIC,  /**< basic */
+} var_status_t;
+
+typedef enum lp_status_t {
+	LP_OPTIMAL,
+	LP_INFEASIBLE,
+	LP_UNBOUNDED,
+	LP_CUTOFF,  /**< the objective reached the cutoff */
+	LP_ABORTED, /**< time limit reached or numerical trouble */
+} lp_status_t;
+
+/** An eta column of the product form of the basis inverse. */
+typedef struct eta_t {
+	int    row;   /**< the pivot row */
+	double pivot; /**< the pivot element */
+	size_t begin; /**< first off-pivot entry in eta_idx and eta_val */
+	size_t end;   /**< end of the off-pivot entries */
+} eta_t;
+
+/** A branching decision on the path of the depth first search. */
+typedef struct decision_t {
+	int    var;   /**< the branching variable */
+	double value; /**< the value the variable is fixed to */
+	double bound; /**< objective of the parent relaxation */
+	bool   last;  /**< the other value has been tried already */
+} decision_t;
+
+/** A basic structural variable while rebuilding the basis inverse. */
+typedef struct basic_col_t {
+	int var; /**< the variable */
+	int len; /**< number of nonzeros of its column */
+} basic_col_t;
+
+typedef struct bnb_t {
+	lpp_t        *lpp;
+	int           n_structs;  /**< number of structural variables */
+	int           n_rows;     /**< number of constraints */
+	int           n_vars;     /**< number of structural and logical variables */
+
+	/* the constraint matrix of the structural variables by column and row */
+	int          *col_begin;
+	int          *col_row;
+	double       *col_val;
+	int          *row_begin;
+	int          *row_col;
+	double       *row_val;
+
+	double       *cost;       /**< the objective, negated for maximization */
+	double       *rhs;        /**< right hand side of the constraints */
+	double       *lb;         /**< current lower bounds of all variables */
+	double       *ub;         /**< current upper bounds of all variables */
+	bool         *is_binary;
+	double        gap;        /**< minimal improvement of a new incumbent */
+
+	/* the current basis */
+	int          *head;       /**< the basic variable of each row */
+	var_status_t *status;
+	double       *x;          /**< values of all variables */
+	double       *d;          /**< reduced costs of all variables */
+	eta_t        *etas;       /**< the eta file */
+	int          *eta_idx;
+	double       *eta_val;
+	unsigned      n_updates;  /**< basis changes since the last rebuild */
+
+	/* work arrays */
+	double       *col_work;
+	double       *rho;
+	double       *alpha;
+	int          *alpha_idx;  /**< nonzero entries of alpha */
+	bool         *alpha_mark;
+	int          *nz_idx;     /**< nonzero entries of col_work in refactor() */
+	bool         *nz_mark;
+	int          *row_eta;    /**< eta column pivoting each row in refactor() */
+	int          *eta_heap;   /**< eta columns to apply in ftran_sparse() */
+	bool         *row_taken;
+	basic_col_t  *basic_cols;
+
+	/* the search */
+	decision_t   *decisions;  /**< the path to the current node */
+	double       *best_x;     /**< values of the incumbent */
+	double        incumbent;  /**< objective of the incumbent */
+	bool          has_incumbent;
+	ir_timer_t   *timer;
+	bool          timeout;
+	unsigned      iterations;
+	unsigned      n_nodes;
+} bnb_t;
+
+static bool is_structural(const bnb_t *bnb, int var)
+{
+	return var < bnb->n_structs;
+}
+
+/**
+ * Returns the value of a nonbasic variable. Variables at an infinite bound
+ * are put at an artificial one.
+ */
+static double get_nonbasic_value(const bnb_t *bnb, int var)
+{
+	if (bnb->status[var] == AT_UB)
+		return bnb->ub[var] != HUGE_VAL ? bnb->ub[var] : ARTIFICIAL_BOUND;
+	return bnb->lb[var] != -HUGE_VAL ? bnb->lb[var] : -ARTIFICIAL_BOUND;
+}
+
+/**
+ * Returns true if a nonbasic variable is at an artificial bound.
+ */
+static bool is_at_artificial_bound(const bnb_t *bnb, int var)
+{
+	return bnb->status[var] == AT_UB ? bnb->ub[var] == HUGE_VAL
+	                                 : bnb->lb[var] == -HUGE_VAL;
+}
+
+/**
+ * Loads the column of variable @p var into the dense vector @p v.
+ */
+static void load_column(const bnb_t *bnb, int var, double *v)
+{
+	memset(v, 0, bnb->n_rows * sizeof(*v));
+	if (!is_structural(bnb, var)) {
+		v[var - bnb->n_structs] = 1.0;
+		return;
+	}
+	for (int k = bnb->col_begin[var]; k < bnb->col_begin[var + 1]; ++k)
+		v[bnb->col_row[k]] = bnb->col_val[k];
+}
+
+/**
+ * Computes B^-1 v in place.
+ */
+static void ftran(const bnb_t *bnb, double *v)
+{
+	for (size_t e = 0, n = ARR_LEN(bnb->etas); e < n; ++e) {
+		eta_t const *const eta = &bnb->etas[e];
+		if (v[eta->row] == 0.0)
+			continue;
+		double const val = v[eta->row] / eta->pivot;
+		v[eta->row] = val;
+		for (size_t k = eta->begin; k < eta->end; ++k)
+			v[bnb->eta_idx[k]] -= bnb->eta_val[k] * val;
+	}
+}
+
+static void heap_push(int **heap, int val)
+{
+	size_t pos = ARR_LEN(*heap);
+	ARR_APP1(int, *heap, val);
+	while (pos > 0) {
+		size_t const parent = (pos - 1) / 2;
+		if ((*heap)[parent] <= val)
+			break;
+		(*heap)[pos] = (*heap)[parent];
+		pos          = parent;
+	}
+	(*heap)[pos] = val;
+}
+
+static int heap_pop(int **heap)
+{
+	int    const res  = (*heap)[0];
+	size_t const len  = ARR_LEN(*heap) - 1;
+	int    const last = (*heap)[len];
+	ARR_SHRINKLEN(*heap, len);
+	size_t pos = 0;
+	for (;;) {
+		size_t child = 2 * pos + 1;
+		if (child >= len)
+			break;
+		if (child + 1 < len && (*heap)[child + 1] < (*heap)[child])
+			++child;
+		if (last <= (*heap)[child])
+			break;
+		(*heap)[pos] = (*heap)[child];
+		pos          = child;
+	}
+	if (len > 0)
+		(*heap)[pos] = last;
+	return res;
+}
+
+/**
+ * Records that entry @p row of the vector transformed in refactor() is
+ * nonzero. Its eta column has to be applied if it comes after the eta
+ * column @p cur.
+ */
+static void mark_nonzero(bnb_t *bnb, int row, int cur)
+{
+	if (bnb->nz_mark[row])
+		return;
+	bnb->nz_mark[row] = true;
+	ARR_APP1(int, bnb->nz_idx, row);
+	if (bnb->row_eta[row] > cur)
+		heap_push(&bnb->eta_heap, bnb->row_eta[row]);
+}
+
+/**
+ * Computes B^-1 v in place for a sparse vector @p v while rebuilding the
+ * basis inverse, whose nonzero entries are listed in nz_idx. Every row is
+ * the pivot row of at most one eta column then, so only the eta columns
+ * of nonzero rows are applied.
+ */
+static void ftran_sparse(bnb_t *bnb, double *v)
+{
+	while (ARR_LEN(bnb->eta_heap) > 0) {
+		int          const e   = heap_pop(&bnb->eta_heap);
+		eta_t const *const eta = &bnb->etas[e];
+		if (v[eta->row] == 0.0)
+			continue;
+		double const val = v[eta->row] / eta->pivot;
+		v[eta->row] = val;
+		for (size_t k = eta->begin; k < eta->end; ++k) {
+			int const idx = bnb->eta_idx[k];
+			mark_nonzero(bnb, idx, e);
+			v[idx] -= bnb->eta_val[k] * val;
+		}
+	}
+}
+
+/**
+ * Computes v^T B^-1 in place.
+ */
+static void btran(const bnb_t *bnb, double *v)
+{
+	for (size_t e = ARR_LEN(bnb->etas); e-- > 0;) {
+		eta_t const *const eta = &bnb->etas[e];
+		double             sum = v[eta->row];
+		for (size_t k = eta->begin; k < eta->end; ++k)
+			sum -= bnb->eta_val[k] * v[bnb->eta_idx[k]];
+		v[eta->row] = sum / eta->pivot;
+	}
+}
+
+/**
+ * Appends the eta column which replaces the basic variable of row @p row by
+ * a variable with the transformed column @p v = B^-1 a.
+ */
+static void add_eta(bnb_t *bnb, const double *v, int row)
+{
+	size_t const begin = ARR_LEN(bnb->eta_idx);
+	for (int i = 0; i < bnb->n_rows; ++i) {
+		if (i == row || fabs(v[i]) < DROP_TOL)
+			continue;
+		ARR_APP1(int,    bnb->eta_idx, i);
+		ARR_APP1(double, bnb->eta_val, v[i]);
+	}
+	eta_t const eta = { row, v[row], begin, ARR_LEN(bnb->eta_idx) };
+	ARR_APP1(eta_t, bnb->etas, eta);
+}
+
+/**
+ * Computes the values of the basic variables from the nonbasic ones.
+ */
+static void compute_primal(bnb_t *bnb)
+{
+	double *const v = bnb->col_work;
+	MEMCPY(v, bnb->rhs, bnb->n_rows);
+	for (int j = 0; j < bnb->n_vars; ++j) {
+		if (bnb->status[j] == BASIC)
+			continue;
+		double const val = get_nonbasic_value(bnb, j);
+		bnb->x[j] = val;
+		if (val == 0.0)
+			continue;
+		if (!is_structural(bnb, j)) {
+			v[j - bnb->n_structs] -= val;
+			continue;
+		}
+		for (int k = bnb->col_begin[j]; k < bnb->col_begin[j + 1]; ++k)
+			v[bnb->col_row[k]] -= bnb->col_val[k] * val;
+	}
+	ftran(bnb, v);
+	for (int i = 0; i < bnb->n_rows; ++i)
+		bnb->x[bnb->head[i]] = v[i];
+}
+
+/**
+ * Computes the reduced costs of the nonbasic variables.
+ */
+static void compute_dual(bnb_t *bnb)
+{
+	double *const y = bnb->rho;
+	for (int i = 0; i < bnb->n_rows; ++i)
+		y[i] = bnb->cost[bnb->head[i]];
+	btran(bnb, y);
+	for (int j = 0; j < bnb->n_vars; ++j) {
+		if (bnb->status[j] == BASIC) {
+			bnb->d[j] = 0.0;
+		} else if (!is_structural(bnb, j)) {
+			bnb->d[j] = -y[j - bnb->n_structs];
+		} else {
+			double dj = bnb->cost[j];
+			for (int k = bnb->col_begin[j]; k < bnb->col_begin[j + 1]; ++k)
+				dj -= bnb->col_val[k] * y[bnb->col_row[k]];
+			bnb->d[j] = dj;
+		}
+	}
+}
+
+/**
+ * Puts every nonbasic variable at the bound matching the sign of its reduced
+ * cost, which makes the basis dual feasible. Variables without reduced cost
+ * prefer a finite bound.
+ */
+static void make_dual_feasible(bnb_t *bnb)
+{
+	for (int j = 0; j < bnb->n_vars; ++j) {
+		if (bnb->status[j] == BASIC)
+			continue;
+		double const dj = bnb->d[j];
+		if (bnb->lb[j] == bnb->ub[j] || dj > DUAL_TOL) {
+			bnb->status[j] = AT_LB;
+		} else if (dj < -DUAL_TOL) {
+			bnb->status[j] = AT_UB;
+		} else if (is_at_artificial_bound(bnb, j)) {
+			bnb->status[j] = bnb->status[j] == AT_LB ? AT_UB : AT_LB;
+		}
+	}
+}
+
+static int cmp_basic_col(const void *a, const void *b)
+{
+	basic_col_t const *const ca = (basic_col_t const*)a;
+	basic_col_t const *const cb = (basic_col_t const*)b;
+	if (ca->len != cb->len)
+		return QSORT_CMP(ca->len, cb->len);
+	return QSORT_CMP(ca->var, cb->var);
+}
+
+/**
+ * Rebuilds the basis inverse from scratch and recomputes the primal and dual
+ * values. Basic structural variables which turn out to be linearly dependent
+ * are replaced by logical ones.
+ */
+static void refactor(bnb_t *bnb)
+{
+	int  const n_rows = bnb->n_rows;
+	bool      *taken  = bnb->row_taken;
+
+	ARR_SHRINKLEN(bnb->etas, 0);
+	ARR_SHRINKLEN(bnb->eta_idx, 0);
+	ARR_SHRINKLEN(bnb->eta_val, 0);
+	bnb->n_updates = 0;
+
+	/* basic logicals keep their rows, the structural columns are pivoted in
+	 * sparsest first to keep the eta file small */
+	size_t n_cols = 0;
+	for (int i = 0; i < n_rows; ++i) {
+		int const var = bnb->head[i];
+		bnb->row_eta[i] = -1;
+		taken[i]        = !is_structural(bnb, var);
+		if (taken[i])
+			continue;
+		basic_col_t *const col = &bnb->basic_cols[n_cols++];
+		col->var = var;
+		col->len = bnb->col_begin[var + 1] - bnb->col_begin[var];
+		bnb->head[i] = -1;
+	}
+	qsort(bnb->basic_cols, n_cols, sizeof(*bnb->basic_cols), cmp_basic_col);
+
+	double *const v = bnb->col_work;
+	memset(v, 0, n_rows * sizeof(*v));
+	for (size_t c = 0; c < n_cols; ++c) {
+		int const var = bnb->basic_cols[c].var;
+		for (int k = bnb->col_begin[var]; k < bnb->col_begin[var + 1]; ++k) {
+			int const idx = bnb->col_row[k];
+			mark_nonzero(bnb, idx, -1);
+			v[idx] = bnb->col_val[k];
+		}
+		ftran_sparse(bnb, v);
+
+		size_t const n_nz = ARR_LEN(bnb->nz_idx);
+		int          row  = -1;
+		double       max  = PIVOT_TOL;
+		for (size_t k = 0; k < n_nz; ++k) {
+			int const idx = bnb->nz_idx[k];
+			if (!taken[idx] && fabs(v[idx]) > max) {
+				max = fabs(v[idx]);
+				row = idx;
+			}
+		}
+		if (row >= 0) {
+			size_t const begin = ARR_LEN(bnb->eta_idx);
+			for (size_t k = 0; k < n_nz; ++k) {
+				int const idx = bnb->nz_idx[k];
+				if (idx == row || fabs(v[idx]) < DROP_TOL)
+					continue;
+				ARR_APP1(int,    bnb->eta_idx, idx);
+				ARR_APP1(double, bnb->eta_val, v[idx]);
+			}
+			eta_t const eta = { row, v[row], begin, ARR_LEN(bnb->eta_idx) };
+			ARR_APP1(eta_t, bnb->etas, eta);
+			bnb->row_eta[row] = ARR_LEN(bnb->etas) - 1;
+			bnb->head[row]    = var;
+			taken[row]        = true;
+		} else {
+			/* linearly dependent on the columns before */
+			bnb->status[var] = bnb->lb[var] != -HUGE_VAL ? AT_LB : AT_UB;
+		}
+
+		for (size_t k = 0; k < n_nz; ++k) {
+			int const idx = bnb->nz_idx[k];
+			v[idx]            = 0.0;
+			bnb->nz_mark[idx] = false;
+		}
+		ARR_SHRINKLEN(bnb->nz_idx, 0);
+	}
+
+	for (int i = 0; i < n_rows; ++i) {
+		if (bnb->head[i] < 0) {
+			int const logical = bnb->n_structs + i;
+			bnb->head[i]         = logical;
+			bnb->status[logical] = BASIC;
+		}
+	}
+
+	compute_dual(bnb);
+	make_dual_feasible(bnb);
+	compute_primal(bnb);
+}
+
+static double get_objective(const bnb_t *bnb)
+{
+	double obj = 0.0;
+	for (int j = 0; j < bnb->n_structs; ++j)
+		obj += bnb->cost[j] * bnb->x[j];
+	return obj;
+}
+
+/**
+ * Returns true if a nonbasic variable is at an artificial bound, so the
+ * objective is no valid bound for the relaxation.
+ */
+static bool has_artificial_bounds(const bnb_t *bnb)
+{
+	for (int j = 0; j < bnb->n_vars; ++j) {
+		if (bnb->status[j] != BASIC && is_at_artificial_bound(bnb, j))
+			return true;
+	}
+	return false;
+}
+
+static bool time_is_up(bnb_t *bnb)
+{
+	double const limit = bnb->lpp->time_limit_secs;
+	if (limit > 0.0 && ir_timer_elapsed_sec(bnb->timer) >= limit)
+		bnb->timeout = true;
+	return bnb->timeout;
+}
+
+/**
+ * Selects the leaving row: the basic variable with the largest bound
+ * violation.
+ *
+ * @param delta  the violation, positive if the upper bound is violated
+ * @return the row or -1 if the basis is primal feasible
+ */
+static int select_leaving_row(const bnb_t *bnb, double *delta)
+{
+	int    row = -1;
+	double max = PRIMAL_TOL;
+	for (int i = 0; i < bnb->n_rows; ++i) {
+		int    const var = bnb->head[i];
+		double const val = bnb->x[var];
+		if (val < bnb->lb[var] - max) {
+			max    = bnb->lb[var] - val;
+			*delta = val - bnb->lb[var];
+			row    = i;
+		} else if (val > bnb->ub[var] + max) {
+			max    = val - bnb->ub[var];
+			*delta = val - bnb->ub[var];
+			row    = i;
+		}
+	}
+	return row;
+}
+
+static void add_to_pivot_row(bnb_t *bnb, int var, double val)
+{
+	if (!bnb->alpha_mark[var]) {
+		bnb->alpha_mark[var] = true;
+		ARR_APP1(int, bnb->alpha_idx, var);
+	}
+	bnb->alpha[var] += val;
+}
+
+/**
+ * Computes the pivot row alpha = e_row^T B^-1 A. Only the variables listed in
+ * alpha_idx have a nonzero entry.
+ */
+static void compute_pivot_row(bnb_t *bnb, int row)
+{
+	double *const rho = bnb->rho;
+	memset(rho, 0, bnb->n_rows * sizeof(*rho));
+	rho[row] = 1.0;
+	btran(bnb, rho);
+
+	for (size_t k = 0, n = ARR_LEN(bnb->alpha_idx); k < n; ++k) {
+		int const var = bnb->alpha_idx[k];
+		bnb->alpha[var]      = 0.0;
+		bnb->alpha_mark[var] = false;
+	}
+	ARR_SHRINKLEN(bnb->alpha_idx, 0);
+
+	for (int i = 0; i < bnb->n_rows; ++i) {
+		double const r = rho[i];
+		if (fabs(r) < DROP_TOL)
+			continue;
+		add_to_pivot_row(bnb, bnb->n_structs + i, r);
+		for (int k = bnb->row_begin[i]; k < bnb->row_begin[i + 1]; ++k)
+			add_to_pivot_row(bnb, bnb->row_col[k], r * bnb->row_val[k]);
+	}
+}
+
+/**
+ * Returns true if variable @p var may enter the basis when the leaving
+ * variable moves in direction @p sign.
+ */
+static bool is_eligible(const bnb_t *bnb, int var, double sign)
+{
+	if (bnb->status[var] == BASIC || bnb->lb[var] == bnb->ub[var])
+		return false;
+	double const a = sign * bnb->alpha[var];
+	return bnb->status[var] == AT_LB ? a > PIVOT_TOL : a < -PIVOT_TOL;
+}
+
+/**
+ * Harris' two pass ratio test selecting the entering variable.
+ *
+ * @param sign  1 if the leaving variable decreases to its upper bound, -1 if
+ *              it increases to its lower bound
+ * @return the entering variable or -1 if the problem is infeasible
+ */
+static int select_entering_var(const bnb_t *bnb, double sign)
+{
+	size_t const n_alpha   = ARR_LEN(bnb->alpha_idx);
+	double       theta_max = HUGE_VAL;
+	for (size_t k = 0; k < n_alpha; ++k) {
+		int const j = bnb->alpha_idx[k];
+		if (!is_eligible(bnb, j, sign))
+			continue;
+		double const a   = sign * bnb->alpha[j];
+		double const tol = bnb->status[j] == AT_LB ? DUAL_TOL : -DUAL_TOL;
+		theta_max = MIN(theta_max, (bnb->d[j] + tol) / a);
+	}
+	if (theta_max == HUGE_VAL)
+		return -1;
+
+	int    entering  = -1;
+	double max_alpha = 0.0;
+	for (size_t k = 0; k < n_alpha; ++k) {
+		int const j = bnb->alpha_idx[k];
+		if (!is_eligible(bnb, j, sign))
+			continue;
+		double const a = sign * bnb->alpha[j];
+		if (bnb->d[j] / a <= theta_max && fabs(a) > max_alpha) {
+			max_alpha = fabs(a);
+			entering  = j;
+		}
+	}
+	return entering;
+}
+
+/**
+ * Moves nonbasic variables at artificial bounds to their finite bound if
+ * possible.
+ *
+ * @return LP_UNBOUNDED if a variable has to stay at an artificial bound,
+ *         LP_OPTIMAL if nothing changed, LP_ABORTED else
+ */
+static lp_status_t remove_artificial_bounds(bnb_t *bnb)
+{
+	lp_status_t res = LP_OPTIMAL;
+	for (int j = 0; j < bnb->n_vars; ++j) {
+		if (bnb->status[j] == BASIC || !is_at_artificial_bound(bnb, j))
+			continue;
+		if (fabs(bnb->d[j]) > DUAL_TOL)
+			return LP_UNBOUNDED;
+		bnb->status[j] = bnb->status[j] == AT_LB ? AT_UB : AT_LB;
+		if (is_at_artificial_bound(bnb, j))
+			return LP_UNBOUNDED;
+		res = LP_ABORTED;
+	}
+	return res;
+}
+
+/**
+ * Runs the dual simplex method from the current dual feasible basis.
+ *
+ * @param cutoff  stop if the objective reaches this value
+ */
+static lp_status_t dual_simplex(bnb_t *bnb, double cutoff)
+{
+	/* guard against cycling */
+	unsigned const max_iter = 100 * (unsigned)bnb->n_vars + 1000;
+	for (unsigned iter = 1; iter <= max_iter; ++iter) {
+		if (iter % CHECK_INTERVAL == 0) {
+			if (time_is_up(bnb))
+				return LP_ABORTED;
+			if (get_objective(bnb) >= cutoff && !has_artificial_bounds(bnb))
+				return LP_CUTOFF;
+		}
+
+		double    delta   = 0.0;
+		int const leaving = select_leaving_row(bnb, &delta);
+		if (leaving < 0) {
+			lp_status_t const res = remove_artificial_bounds(bnb);
+			if (res == LP_UNBOUNDED)
+				return res;
+			if (res == LP_OPTIMAL)
+				return get_objective(bnb) >= cutoff ? LP_CUTOFF : LP_OPTIMAL;
+			compute_primal(bnb);
+			continue;
+		}
+
+		int    const p    = bnb->head[leaving];
+		double const sign = delta > 0 ? 1.0 : -1.0;
+		compute_pivot_row(bnb, leaving);
+		int const q = select_entering_var(bnb, sign);
+		if (q < 0)
+			return LP_INFEASIBLE;
+
+		double *const col = bnb->col_work;
+		load_column(bnb, q, col);
+		ftran(bnb, col);
+		double const alpha_q = bnb->alpha[q];
+		double const pivot   = col[leaving];
+		if (fabs(pivot - alpha_q) > 1e-6 * (1.0 + fabs(pivot))
+		    || fabs(pivot) < PIVOT_TOL) {
+			/* the basis inverse is inaccurate */
+			if (bnb->n_updates == 0)
+				return LP_ABORTED;
+			refactor(bnb);
+			continue;
+		}
+		++bnb->iterations;
+
+		/* update the reduced costs, a wrong sign within the tolerance
+		 * results in a degenerate step */
+		double dq = bnb->d[q];
+		if (sign * alpha_q * dq < 0)
+			dq = 0.0;
+		double const theta_d = dq / alpha_q;
+		for (size_t k = 0, n = ARR_LEN(bnb->alpha_idx); k < n; ++k) {
+			int const j = bnb->alpha_idx[k];
+			if (bnb->status[j] != BASIC)
+				bnb->d[j] -= theta_d * bnb->alpha[j];
+		}
+		bnb->d[q] = 0.0;
+		bnb->d[p] = -theta_d;
+
+		/* update the primal values, the leaving variable ends at its bound */
+		double const theta_p = delta / pivot;
+		for (int i = 0; i < bnb->n_rows; ++i)
+			bnb->x[bnb->head[i]] -= theta_p * col[i];
+		bnb->x[q]          += theta_p;
+		bnb->x[p]           = delta > 0 ? bnb->ub[p] : bnb->lb[p];
+		bnb->status[p]      = delta > 0 ? AT_UB : AT_LB;
+		bnb->status[q]      = BASIC;
+		bnb->head[leaving]  = q;
+
+		add_eta(bnb, col, leaving);
+		if (++bnb->n_updates >= REFACTOR_INTERVAL)
+			refactor(bnb);
+	}
+	return LP_ABORTED;
+}
+
+/**
+ * Solves the relaxation of the current node, starting from the basis of the
+ * node solved before.
+ */
+static lp_status_t solve_relaxation(bnb_t *bnb, double cutoff)
+{
+	++bnb->n_nodes;
+	make_dual_feasible(bnb);
+	compute_primal(bnb);
+	return dual_simplex(bnb, cutoff);
+}
+
+/**
+ * Returns the binary variable with the most fractional value or -1 if all
+ * binary variables are integral.
+ */
+static int select_branching_var(const bnb_t *bnb)
+{
+	int    var  = -1;
+	double best = INT_TOL;
+	for (int j = 0; j < bnb->n_structs; ++j) {
+		if (!bnb->is_binary[j])
+			continue;
+		double const frac = fabs(bnb->x[j] - floor(bnb->x[j] + 0.5));
+		if (frac > best) {
+			best = frac;
+			var  = j;
+		}
+	}
+	return var;
+}
+
+static void set_incumbent(bnb_t *bnb, const double *x, double obj)
+{
+	for (int j = 0; j < bnb->n_structs; ++j) {
+		double val = x[j];
+		if (bnb->is_binary[j])
+			val = floor(val + 0.5);
+		else if (val < 0.0)
+			val = 0.0;
+		bnb->best_x[j] = val;
+	}
+	bnb->incumbent     = obj;
+	bnb->has_incumbent = true;
+}
+
+static double get_cutoff(const bnb_t *bnb)
+{
+	if (!bnb->has_incumbent)
+		return HUGE_VAL;
+	return bnb->incumbent - bnb->gap;
+}
+
+/**
+ * Uses the start values as incumbent if they are a feasible solution.
+ * Variables without start value are taken to be 0.
+ */
+static void check_start_values(bnb_t *bnb)
+{
+	lpp_t  *const lpp = bnb->lpp;
+	double *const x   = XMALLOCNZ(double, bnb->n_structs);
+	bool          any = false;
+	for (int j = 0; j < bnb->n_structs; ++j) {
+		lpp_name_t const *const var = lpp->vars[1 + j];
+		if (var->value_kind != lpp_value_start)
+			continue;
+		double const val = var->value;
+		if (val < -PRIMAL_TOL || val > bnb->ub[j] + PRIMAL_TOL
+		    || (bnb->is_binary[j] && fabs(val - floor(val + 0.5)) > INT_TOL))
+			goto end;
+		x[j] = val;
+		any  = true;
+	}
+	if (!any)
+		goto end;
+
+	for (int i = 0; i < bnb->n_rows; ++i) {
+		double act = 0.0;
+		for (int k = bnb->row_begin[i]; k < bnb->row_begin[i + 1]; ++k)
+			act += bnb->row_val[k] * x[bnb->row_col[k]];
+		double const tol     = 1e-6 * (1.0 + fabs(bnb->rhs[i]));
+		double const slack   = bnb->rhs[i] - act;
+		int    const logical = bnb->n_structs + i;
+		if (slack < bnb->lb[logical] - tol || slack > bnb->ub[logical] + tol)
+			goto end;
+	}
+
+	double obj = 0.0;
+	for (int j = 0; j < bnb->n_structs; ++j)
+		obj += bnb->cost[j] * x[j];
+	set_incumbent(bnb, x, obj);
+
+end:
+	free(x);
+}
+
+/**
+ * Builds the column and row wise matrices and the bounds from the lpp
+ * matrix, which is freed afterwards.
+ */
+static void construct(bnb_t *bnb)
+{
+	lpp_t *const lpp       = bnb->lpp;
+	int    const n_structs = lpp->var_next - 1;
+	int    const n_rows    = lpp->cst_next - 1;
+	int    const n_vars    = n_structs + n_rows;
+	double const sense     = lpp->opt_type == lpp_maximize ? -1.0 : 1.0;
+
+	bnb->n_structs = n_structs;
+	bnb->n_rows    = n_rows;
+	bnb->n_vars    = n_vars;
+	bnb->cost      = XMALLOCNZ(double, n_vars);
+	bnb->rhs       = XMALLOCN(double, n_rows);
+	bnb->lb        = XMALLOCN(double, n_vars);
+	bnb->ub        = XMALLOCN(double, n_vars);
+	bnb->is_binary = XMALLOCNZ(bool, n_structs);
+	bnb->col_begin = XMALLOCN(int, n_structs + 1);
+	bnb->row_begin = XMALLOCNZ(int, n_rows + 1);
+
+	int    *col_row = NEW_ARR_F(int, 0);
+	double *col_val = NEW_ARR_F(double, 0);
+	bool    int_obj = true;
+	for (int j = 0; j < n_structs; ++j) {
+		lpp_name_t const *const var    = lpp->vars[1 + j];
+		bool              const binary = var->type.var_type == lpp_binary;
+		double            const c      = sense * matrix_get(lpp->m, 0, 1 + j);
+		bnb->cost[j]      = c;
+		bnb->is_binary[j] = binary;
+		bnb->lb[j]        = 0.0;
+		bnb->ub[j]        = binary ? 1.0 : HUGE_VAL;
+		if (c != 0.0 && (!binary || c != floor(c)))
+			int_obj = false;
+
+		bnb->col_begin[j] = ARR_LEN(col_row);
+		matrix_foreach_in_col(lpp->m, 1 + j, elem) {
+			if (elem->row == 0 || elem->val == 0.0)
+				continue;
+			ARR_APP1(int,    col_row, elem->row - 1);
+			ARR_APP1(double, col_val, elem->val);
+			++bnb->row_begin[elem->row];
+		}
+	}
+	int const n_elems = ARR_LEN(col_row);
+	bnb->col_begin[n_structs] = n_elems;
+	bnb->col_row = XMALLOCN(int,    n_elems);
+	bnb->col_val = XMALLOCN(double, n_elems);
+	MEMCPY(bnb->col_row, col_row, n_elems);
+	MEMCPY(bnb->col_val, col_val, n_elems);
+	DEL_ARR_F(col_row);
+	DEL_ARR_F(col_val);
+
+	for (int i = 0; i < n_rows; ++i) {
+		lpp_name_t const *const cst     = lpp->csts[1 + i];
+		int               const logical = n_structs + i;
+		bnb->rhs[i] = matrix_get(lpp->m, 1 + i, 0);
+		switch (cst->type.cst_type) {
+		case lpp_less_equal:
+			bnb->lb[logical] = 0.0;
+			bnb->ub[logical] = HUGE_VAL;
+			break;
+		case lpp_greater_equal:
+			bnb->lb[logical] = -HUGE_VAL;
+			bnb->ub[logical] = 0.0;
+			break;
+		default:
+			bnb->lb[logical] = 0.0;
+			bnb->ub[logical] = 0.0;
+			break;
+		}
+	}
+
+	/* build the row wise matrix by counting sort */
+	for (int i = 0; i < n_rows; ++i)
+		bnb->row_begin[i + 1] += bnb->row_begin[i];
+	bnb->row_col = XMALLOCN(int,    n_elems);
+	bnb->row_val = XMALLOCN(double, n_elems);
+	int *const fill = XMALLOCN(int, n_rows + 1);
+	MEMCPY(fill, bnb->row_begin, n_rows + 1);
+	for (int j = 0; j < n_structs; ++j) {
+		for (int k = bnb->col_begin[j]; k < bnb->col_begin[j + 1]; ++k) {
+			int const pos = fill[bnb->col_row[k]]++;
+			bnb->row_col[pos] = j;
+			bnb->row_val[pos] = bnb->col_val[k];
+		}
+	}
+	free(fill);
+
+	/* with an integral objective only improvements by at least 1 count */
+	bnb->gap = int_obj ? 1.0 - 1e-6 : 1e-6;
+
+	lpp_free_matrix(lpp);
+}
+
+static void init_basis(bnb_t *bnb)
+{
+	int const n_structs = bnb->n_structs;
+	int const n_rows    = bnb->n_rows;
+	int const n_vars    = bnb->n_vars;
+	bnb->head       = XMALLOCN(int, n_rows);
+	bnb->status     = XMALLOCN(var_status_t, n_vars);
+	bnb->x          = XMALLOCNZ(double, n_vars);
+	bnb->d          = XMALLOCNZ(double, n_vars);
+	bnb->etas       = NEW_ARR_F(eta_t, 0);
+	bnb->eta_idx    = NEW_ARR_F(int, 0);
+	bnb->eta_val    = NEW_ARR_F(double, 0);
+	bnb->col_work   = XMALLOCN(double, n_rows);
+	bnb->rho        = XMALLOCN(double, n_rows);
+	bnb->alpha      = XMALLOCNZ(double, n_vars);
+	bnb->alpha_idx  = NEW_ARR_F(int, 0);
+	bnb->alpha_mark = XMALLOCNZ(bool, n_vars);
+	bnb->nz_idx     = NEW_ARR_F(int, 0);
+	bnb->nz_mark    = XMALLOCNZ(bool, n_rows);
+	bnb->row_eta    = XMALLOCN(int, n_rows);
+	bnb->eta_heap   = NEW_ARR_F(int, 0);
+	bnb->row_taken  = XMALLOCN(bool, n_rows);
+	bnb->basic_cols = XMALLOCN(basic_col_t, n_rows);
+	bnb->best_x     = XMALLOCNZ(double, n_structs);
+	bnb->decisions  = NEW_ARR_F(decision_t, 0);
+
+	/* start with the basis of all logical variables */
+	for (int j = 0; j < n_structs; ++j)
+		bnb->status[j] = AT_LB;
+	for (int i = 0; i < n_rows; ++i) {
+		bnb->head[i]                = n_structs + i;
+		bnb->status[n_structs + i]  = BASIC;
+	}
+	compute_dual(bnb);
+}
+
+static void free_bnb(bnb_t *bnb)
+{
+	free(bnb->col_begin);
+	free(bnb->col_row);
+	free(bnb->col_val);
+	free(bnb->row_begin);
+	free(bnb->row_col);
+	free(bnb->row_val);
+	free(bnb->cost);
+	free(bnb->rhs);
+	free(bnb->lb);
+	free(bnb->ub);
+	free(bnb->is_binary);
+	free(bnb->head);
+	free(bnb->status);
+	free(bnb->x);
+	free(bnb->d);
+	DEL_ARR_F(bnb->etas);
+	DEL_ARR_F(bnb->eta_idx);
+	DEL_ARR_F(bnb->eta_val);
+	free(bnb->col_work);
+	free(bnb->rho);
+	free(bnb->alpha);
+	DEL_ARR_F(bnb->alpha_idx);
+	free(bnb->alpha_mark);
+	DEL_ARR_F(bnb->nz_idx);
+	free(bnb->nz_mark);
+	free(bnb->row_eta);
+	DEL_ARR_F(bnb->eta_heap);
+	free(bnb->row_taken);
+	free(bnb->basic_cols);
+	free(bnb->best_x);
+	DEL_ARR_F(bnb->decisions);
+}
+
+static void fix_var(bnb_t *bnb, int var, double value)
+{
+	bnb->lb[var] = value;
+	bnb->ub[var] = value;
+}
+
+/**
+ * Moves to the next open node after the current one has been finished.
+ *
+ * @return false if the search is complete
+ */
+static bool backtrack(bnb_t *bnb)
+{
+	double const cutoff = get_cutoff(bnb);
+	while (ARR_LEN(bnb->decisions) > 0) {
+		size_t      const top = ARR_LEN(bnb->decisions) - 1;
+		decision_t *const dec = &bnb->decisions[top];
+		if (!dec->last && dec->bound < cutoff) {
+			dec->value = 1.0 - dec->value;
+			dec->last  = true;
+			fix_var(bnb, dec->var, dec->value);
+			return true;
+		}
+		bnb->lb[dec->var] = 0.0;
+		bnb->ub[dec->var] = 1.0;
+		ARR_SHRINKLEN(bnb->decisions, top);
+	}
+	return false;
+}
+
+/**
+ * Returns the smallest bound of all open nodes, where @p node_bound is the
+ * bound of the current one.
+ */
+static double get_best_bound(const bnb_t *bnb, double node_bound)
+{
+	double bound = node_bound;
+	for (size_t i = 0, n = ARR_LEN(bnb->decisions); i < n; ++i) {
+		decision_t const *const dec = &bnb->decisions[i];
+		if (!dec->last)
+			bound = MIN(bound, dec->bound);
+	}
+	if (bnb->has_incumbent)
+		bound = MIN(bound, bnb->incumbent);
+	return bound;
+}
+
+/**
+ * Runs the depth first search and sets the best bound of the problem.
+ *
+ * @return the state of the solution
+ */
+static lpp_sol_state_t search(bnb_t *bnb)
+{
+	lpp_t *const lpp       = bnb->lpp;
+	double const sense     = lpp->opt_type == lpp_maximize ? -1.0 : 1.0;
+	double const obj_bound = lpp->set_bound ? sense * lpp->bound : -HUGE_VAL;
+	bool         root      = true;
+
+	for (;;) {
+		if (bnb->has_incumbent && bnb->incumbent <= obj_bound + 1e-6) {
+			lpp->best_bound = sense * bnb->incumbent;
+			return lpp_optimal;
+		}
+
+		size_t const depth      = ARR_LEN(bnb->decisions);
+		double const node_bound = depth > 0
+			? bnb->decisions[depth - 1].bound : -HUGE_VAL;
+		lp_status_t const status = solve_relaxation(bnb, get_cutoff(bnb));
+		if (status == LP_ABORTED) {
+			lpp->best_bound = sense * get_best_bound(bnb, node_bound);
+			return bnb->has_incumbent ? lpp_feasible : lpp_unknown;
+		}
+		if (status == LP_UNBOUNDED && root) {
+			lpp->best_bound = -sense * HUGE_VAL;
+			return lpp_unbounded;
+		}
+		root = false;
+
+		if (status == LP_OPTIMAL) {
+			double const obj = get_objective(bnb);
+			int    const var = select_branching_var(bnb);
+			if (var >= 0) {
+				decision_t const dec = {
+					var, floor(bnb->x[var] + 0.5), obj, false
+				};
+				ARR_APP1(decision_t, bnb->decisions, dec);
+				fix_var(bnb, var, dec.value);
+				continue;
+			}
+			set_incumbent(bnb, bnb->x, obj);
+		}
+
+		if (!backtrack(bnb))
+			break;
+	}
+
+	if (!bnb->has_incumbent) {
+		lpp->best_bound = sense * HUGE_VAL;
+		return lpp_infeasible;
+	}
+	lpp->best_bound = sense * bnb->incumbent;
+	return lpp_optimal;
+}
+
+void lpp_solve_bnb(lpp_t *lpp)
+{
+	bnb_t bnb;
+	memset(&bnb, 0, sizeof(bnb));
+	bnb.lpp   = lpp;
+	bnb.timer = ir_timer_new();
+	ir_timer_start(bnb.timer);
+
+	construct(&bnb);
+	init_basis(&bnb);
+	check_start_values(&bnb);
+
+	lpp->sol_state  = search(&bnb);
+	lpp->iterations = bnb.iterations;
+	lpp->sol_time   = ir_timer_elapsed_sec(bnb.timer);
+
+	if (bnb.has_incumbent) {
+		double const sense = lpp->opt_type == lpp_maximize ? -1.0 : 1.0;
+		lpp->objval = sense * bnb.incumbent;
+		for (int j = 0; j < bnb.n_structs; ++j) {
+			lpp_name_t *const var = lpp->vars[1 + j];
+			var->value_kind = lpp_value_solution;
+			var->value      = bnb.best_x[j];
+		}
+	}
+
+	if (lpp->log != NULL) {
+		fprintf(lpp->log, "bnb: %d vars, %d constraints, %u nodes, %u iterations, %.3fs%s\n",
+		        bnb.n_structs, bnb.n_rows, bnb.n_nodes, bnb.iterations,
+		        lpp->sol_time, bnb.timeout ? " (time limit)" : "");
+	}
+
+	ir_timer_stop(bnb.timer);
+	ir_timer_free(bnb.timer);
+	free_bnb(&bnb);
+}
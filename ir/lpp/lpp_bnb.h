@@ -0,0 +1,17 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2016 University of Karlsruhe.
+ */
+
+/**
+ * @file
+ * @brief   Built-in branch and bound solver.
+ */
+#ifndef LPP_LPP_BNB_H
+#define LPP_LPP_BNB_H
+
+#include "lpp.h"
+
+void lpp_solve_bnb(lpp_t *lpp);
+
+#endif
@@ -556,8 +556,8 @@ static void sort_irn_outs(node_t *node)
 {
 	ir_node  *irn    = node->node;
 	unsigned  n_outs = get_irn_n_outs(irn);
-	QSORT(irn->o.out->edges, n_outs, cmp_def_use_edge);
-	node->max_user_input = n_outs > 0 ? irn->o.out->edges[n_outs-1].pos : -1;
+	QSORT(get_irn_out_edges(irn)->edges, n_outs, cmp_def_use_edge);
+	node->max_user_input = n_outs > 0 ? get_irn_out_edges(irn)->edges[n_outs-1].pos : -1;
 }
 
 /**
@@ -802,23 +802,24 @@ static void move_edges_to_leader(node_t *x)
 		node_t  *pred = get_irn_node(pred_irn);
 		ir_node *p    = pred->node;
 		unsigned n    = get_irn_n_outs(p);
+		ir_def_use_edge *const edges = get_irn_out_edges(p)->edges;
 		for (unsigned j = 0; j < pred->n_followers; ++j) {
-			ir_def_use_edge edge = p->o.out->edges[j];
+			ir_def_use_edge edge = edges[j];
 			if (edge.pos == i && edge.use == irn) {
 				/* found a follower edge to x, move it to the leader */
 				/* remove this edge from the follower set */
 				--pred->n_followers;
-				p->o.out->edges[j] = p->o.out->edges[pred->n_followers];
+				edges[j] = edges[pred->n_followers];
 
 				/* sort it into the leader set */
 				unsigned k;
 				for (k = pred->n_followers+1; k < n; ++k) {
-					if (p->o.out->edges[k].pos >= edge.pos)
+					if (edges[k].pos >= edge.pos)
 						break;
-					p->o.out->edges[k-1] = p->o.out->edges[k];
+					edges[k-1] = edges[k];
 				}
 				/* place the new edge here */
-				p->o.out->edges[k-1] = edge;
+				edges[k-1] = edge;
 
 				/* edge found and moved */
 				break;
@@ -992,7 +993,7 @@ static bool step(step_env *env)
 		/* let n be the first node in unwalked */
 		node_t *n = env->unwalked;
 		while (env->index < n->n_followers) {
-			const ir_def_use_edge *edge = &n->node->o.out->edges[env->index];
+			const ir_def_use_edge *edge = &get_irn_out_edges(n->node)->edges[env->index];
 
 			/* let m be n.F.def_use[index] */
 			node_t *m = get_irn_node(edge->use);
@@ -1285,7 +1286,7 @@ static void collect_touched(list_head *list, int idx, environment_t *env)
 
 		/* for all edges in x.L.def_use_{idx} */
 		while (x->next_edge < num_edges) {
-			const ir_def_use_edge *edge = &x->node->o.out->edges[x->next_edge];
+			const ir_def_use_edge *edge = &get_irn_out_edges(x->node)->edges[x->next_edge];
 
 			/* check if we have necessary edges */
 			if (edge->pos > idx)
@@ -1343,7 +1344,7 @@ static void collect_commutative_touched(list_head *list, environment_t *env)
 
 		/* for all edges in x.L.def_use_{idx} */
 		while (x->next_edge < num_edges) {
-			const ir_def_use_edge *edge = &x->node->o.out->edges[x->next_edge];
+			const ir_def_use_edge *edge = &get_irn_out_edges(x->node)->edges[x->next_edge];
 			ir_node               *succ;
 
 			/* check if we have necessary edges */
@@ -2520,13 +2521,14 @@ static void segregate_def_use_chain_1(const ir_node *follower, node_t *leader)
 	   be unsorted. */
 	ir_node *l = leader->node;
 	unsigned n = get_irn_n_outs(l);
+	ir_def_use_edge *const edges = get_irn_out_edges(l)->edges;
 	for (unsigned i = leader->n_followers; i < n; ++i) {
-		if (l->o.out->edges[i].use == follower) {
-			ir_def_use_edge t = l->o.out->edges[i];
+		if (edges[i].use == follower) {
+			ir_def_use_edge t = edges[i];
 
 			for (unsigned j = i; j-- > leader->n_followers; )
-				l->o.out->edges[j+1] = l->o.out->edges[j];
-			l->o.out->edges[leader->n_followers] = t;
+				edges[j+1] = edges[j];
+			edges[leader->n_followers] = t;
 			++leader->n_followers;
 			break;
 		}
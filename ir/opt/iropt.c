@@ -7741,11 +7741,8 @@ void ir_register_opt_node_ops(void)
  * in a graph. */
 #define N_IR_NODES 512
 
-static int identities_cmp(const void *elt, const void *key)
+static int identities_cmp(const ir_node *a, const ir_node *b)
 {
-	ir_node *a = (ir_node *)elt;
-	ir_node *b = (ir_node *)key;
-
 	if (a == b)
 		return 0;
 
@@ -7813,14 +7810,22 @@ unsigned ir_node_hash(const ir_node *node)
 
 void new_identities(ir_graph *irg)
 {
+	/* The new table is usually filled with the nodes of the same graph again
+	 * (after dead node elimination or a transformation), so start with the
+	 * size of the old one and save the resizes. */
+	size_t n_nodes = N_IR_NODES;
+	if (irg->value_table != NULL)
+		n_nodes = MAX(n_nodes, ir_valuetable_size(irg->value_table));
 	del_identities(irg);
-	irg->value_table = new_pset(identities_cmp, N_IR_NODES);
+	irg->value_table = ir_valuetable_new(identities_cmp, n_nodes);
 }
 
 void del_identities(ir_graph *irg)
 {
-	if (irg->value_table != NULL)
-		del_pset(irg->value_table);
+	if (irg->value_table != NULL) {
+		ir_valuetable_del(irg->value_table);
+		irg->value_table = NULL;
+	}
 }
 
 static int cmp_node_nr(const void *a, const void *b)
@@ -7874,15 +7879,15 @@ void ir_normalize_node(ir_node *n)
 
 ir_node *identify_remember(ir_node *n)
 {
-	ir_graph *irg         = get_irn_irg(n);
-	pset     *value_table = irg->value_table;
+	ir_graph        *irg         = get_irn_irg(n);
+	ir_valuetable_t *value_table = irg->value_table;
 
 	if (value_table == NULL)
 		return n;
 
 	ir_normalize_node(n);
 	/* lookup or insert in hash table with given hash key. */
-	ir_node *nn = (ir_node *)pset_insert(value_table, n, ir_node_hash(n));
+	ir_node *nn = ir_valuetable_insert(value_table, n, ir_node_hash(n));
 
 	/* nn is reachable again */
 	if (nn != n)
@@ -7922,11 +7927,20 @@ void add_identities(ir_node *node)
 
 void visit_all_identities(ir_graph *irg, irg_walk_func visit, void *env)
 {
-	foreach_pset(irg->value_table, ir_node, node) {
+	foreach_ir_valuetable(irg->value_table, node) {
 		visit(node, env);
 	}
 }
 
+/**
+ * The local optimizations assume scalar values, lane-wise vector operations
+ * are only subject to CSE.
+ */
+static bool is_vector_binop(const ir_node *n)
+{
+	return is_binop(n) && mode_is_vector(get_irn_mode(n));
+}
+
 ir_node *optimize_node(ir_node *n)
 {
 	ir_node  *oldn = n;
@@ -7936,10 +7950,11 @@ ir_node *optimize_node(ir_node *n)
 	if (!get_optimize() && (iro != iro_Phi))
 		return n;
 
-	ir_graph *irg = get_irn_irg(n);
+	ir_graph  *irg        = get_irn_irg(n);
+	bool const local_opts = !is_vector_binop(n);
 
 	/* constant expression evaluation / constant folding */
-	if (get_opt_constant_folding()) {
+	if (get_opt_constant_folding() && local_opts) {
 		/* neither constants nor Tuple values can be evaluated */
 		if (iro != iro_Const && (get_irn_mode(n) != mode_T)) {
 			/* try to evaluate */
@@ -7971,7 +7986,8 @@ ir_node *optimize_node(ir_node *n)
 	}
 
 	/* remove unnecessary nodes */
-	if (get_opt_algebraic_simplification() || always_optimize(iro))
+	if (local_opts
+	    && (get_opt_algebraic_simplification() || always_optimize(iro)))
 		n = equivalent_node(n);
 
 	/* Common Subexpression Elimination.
@@ -7995,9 +8011,9 @@ ir_node *optimize_node(ir_node *n)
 	/* Some more constant expression evaluation that does not allow to
 	 * free the node. */
 	iro = get_irn_opcode(n);
-	if (get_opt_algebraic_simplification() ||
+	if (local_opts && (get_opt_algebraic_simplification() ||
 		(iro == iro_Cond) ||
-		(iro == iro_Proj)) {    /* Flags tested local. */
+		(iro == iro_Proj))) {    /* Flags tested local. */
 		n = transform_node(n);
 	}
 
@@ -8035,6 +8051,9 @@ ir_node *optimize_in_place_2(ir_node *n)
 		}
 	}
 
+	if (is_vector_binop(n))
+		return n;
+
 	n = transform_node(n);
 
 #ifdef DEBUG_libfirm
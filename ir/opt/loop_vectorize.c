@@ -0,0 +1,972 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2012 University of Karlsruhe.
+ */
+
+/**
+ * @file
+ * @brief   Vectorization of innermost counted loops.
+ *
+ * Handles loops made up of a header, which only tests the induction variable
+ * against a loop invariant bound, and a single body block. Such a loop gets a
+ * vector copy in front of it, which executes as many iterations as possible
+ * in steps of the vector length. The original loop stays in place and
+ * finishes the remaining iterations. If the accessed arrays are not known to
+ * be independent, a check at runtime selects between both versions:
+ *
+ *        entry
+ *          |
+ *        check ----------.
+ *          |             |
+ *       vheader <--.     |
+ *        |    |    |     |
+ *        | vbody --'     |
+ *        |               |
+ *      vexit             |
+ *          \            /
+ *            --merge--
+ *               |
+ *            header <--.
+ *             |   |    |
+ *             |  body -'
+ *            exit
+ */
+#include "array.h"
+#include "debug.h"
+#include "ircons_t.h"
+#include "irflag_t.h"
+#include "iredges_t.h"
+#include "irgmod.h"
+#include "irgraph_t.h"
+#include "irloop_t.h"
+#include "irmemory.h"
+#include "irmode_t.h"
+#include "irnode_t.h"
+#include "irnodeset.h"
+#include "iroptimize.h"
+#include "irtools.h"
+#include "pmap.h"
+#include "target_t.h"
+#include "tv_t.h"
+#include "type_t.h"
+#include "util.h"
+
+DEBUG_ONLY(static firm_dbg_module_t *dbg;)
+
+/** The maximal number of pointer comparisons done at runtime per loop. */
+#define MAX_RUNTIME_CHECKS 8
+
+/** Address of the form base + scale * i + offset. */
+typedef struct linear_t {
+	ir_node *base;   /**< Loop invariant reference or NULL. */
+	long     scale;  /**< Factor of the induction variable. */
+	long     offset; /**< Constant offset. */
+} linear_t;
+
+/** A Load or Store in the loop body. */
+typedef struct access_t {
+	ir_node *memop;
+	ir_node *base;   /**< Loop invariant part of the address. */
+	long     offset; /**< Constant offset from base. */
+} access_t;
+
+/** A value r = Phi(init, r op x), which is only used by the operation. */
+typedef struct reduction_t {
+	ir_node *phi;
+	ir_node *next;  /**< The operation on the back edge. */
+	ir_node *value; /**< The operand x. */
+	ir_node *vphi;  /**< The vector accumulator. */
+} reduction_t;
+
+typedef struct loop_env_t {
+	ir_node      *header;
+	ir_node      *body;
+	int           entry_pos;  /**< Position of the entry in the header. */
+	int           back_pos;   /**< Position of the back edge in the header. */
+	ir_node      *iv;         /**< The induction variable. */
+	ir_node      *bound;      /**< The loop runs while iv < bound. */
+	ir_node      *mem_phi;    /**< The memory Phi of the header or NULL. */
+	ir_node     **memory;     /**< Memory operations and Syncs of the body in
+	                               topological order. */
+	access_t     *accesses;   /**< All Loads and Stores of the body. */
+	reduction_t  *reductions;
+	ir_nodeset_t  values;     /**< Values, which can be vectorized. */
+	ir_nodeset_t  loads;      /**< Loads, which are in accesses. */
+	ir_mode      *mode;       /**< The element mode. */
+	ir_mode      *vmode;
+	unsigned      n_lanes;
+	size_t        checks[MAX_RUNTIME_CHECKS][2]; /**< Pairs of accesses. */
+	unsigned      n_checks;
+	/* construction */
+	ir_node      *check_block;
+	ir_node      *vbody;
+	ir_node      *viv;
+	ir_node      *vmem_phi;
+	pmap         *vectors;    /**< Maps scalar nodes to their vector copy. */
+	pmap         *addresses;  /**< Maps addresses to their copy in vbody. */
+} loop_env_t;
+
+static bool is_invariant(loop_env_t const *const env, ir_node const *const node)
+{
+	ir_node const *const block = get_nodes_block(node);
+	return block != env->header && block != env->body;
+}
+
+static bool get_linear(loop_env_t const *env, ir_node *node, linear_t *res);
+
+static bool get_linear_op(loop_env_t const *const env, ir_node *const node,
+                          linear_t *const res)
+{
+	ir_mode *const mode = get_irn_mode(node);
+	linear_t l;
+	linear_t r;
+	switch (get_irn_opcode(node)) {
+	case iro_Add:
+		if (!get_linear(env, get_Add_left(node), &l)
+		 || !get_linear(env, get_Add_right(node), &r)
+		 || (l.base != NULL && r.base != NULL))
+			return false;
+		*res = (linear_t){ l.base != NULL ? l.base : r.base,
+		                   l.scale + r.scale, l.offset + r.offset };
+		return true;
+
+	case iro_Sub:
+		if (!get_linear(env, get_Sub_left(node), &l)
+		 || !get_linear(env, get_Sub_right(node), &r)
+		 || r.base != NULL)
+			return false;
+		*res = (linear_t){ l.base, l.scale - r.scale, l.offset - r.offset };
+		return true;
+
+	case iro_Mul:
+	case iro_Shl: {
+		ir_node *const right = get_binop_right(node);
+		if (!is_Const(right) || !tarval_is_long(get_Const_tarval(right))
+		 || !get_linear(env, get_binop_left(node), &l) || l.base != NULL)
+			return false;
+		long factor = get_Const_long(right);
+		if (is_Shl(node)) {
+			if (factor < 0 || factor >= 16)
+				return false;
+			factor = 1L << factor;
+		}
+		*res = (linear_t){ NULL, l.scale * factor, l.offset * factor };
+		return true;
+	}
+
+	case iro_Conv: {
+		/* only extensions of the induction variable itself, any other
+		 * expression might wrap around */
+		ir_node *const op      = get_Conv_op(node);
+		ir_mode *const op_mode = get_irn_mode(op);
+		if (!mode_is_int(mode) || !mode_is_int(op_mode)
+		 || get_mode_size_bits(mode) < get_mode_size_bits(op_mode)
+		 || !get_linear(env, op, &l) || l.base != NULL
+		 || (l.scale != 0 && (l.scale != 1 || l.offset != 0)))
+			return false;
+		*res = l;
+		return true;
+	}
+
+	case iro_Sel: {
+		ir_type *const element_type = get_array_element_type(get_Sel_type(node));
+		if (get_type_state(element_type) != layout_fixed
+		 || !get_linear(env, get_Sel_ptr(node), &l)
+		 || !get_linear(env, get_Sel_index(node), &r) || r.base != NULL)
+			return false;
+		long const size = get_type_size(element_type);
+		*res = (linear_t){ l.base, l.scale + r.scale * size,
+		                   l.offset + r.offset * size };
+		return true;
+	}
+
+	case iro_Member: {
+		ir_entity *const entity = get_Member_entity(node);
+		if (get_type_state(get_entity_owner(entity)) != layout_fixed
+		 || !get_linear(env, get_Member_ptr(node), &l))
+			return false;
+		*res = (linear_t){ l.base, l.scale, l.offset + get_entity_offset(entity) };
+		return true;
+	}
+
+	default:
+		return false;
+	}
+}
+
+/**
+ * Decomposes the address @p node. Constant offsets are split off invariant
+ * addresses as well, so that accesses relative to the same base are compared
+ * without runtime checks.
+ */
+static bool get_linear(loop_env_t const *const env, ir_node *const node,
+                       linear_t *const res)
+{
+	if (node == env->iv) {
+		*res = (linear_t){ NULL, 1, 0 };
+		return true;
+	}
+	if (is_Const(node)) {
+		if (!tarval_is_long(get_Const_tarval(node)))
+			return false;
+		*res = (linear_t){ NULL, 0, get_Const_long(node) };
+		return true;
+	}
+	if (!is_invariant(env, node))
+		return get_linear_op(env, node, res);
+	if (!mode_is_reference(get_irn_mode(node)))
+		return false;
+
+	long     offset = 0;
+	ir_node *base   = node;
+	for (;;) {
+		if (is_Add(base) && is_Const(get_Add_right(base))
+		 && tarval_is_long(get_Const_tarval(get_Add_right(base)))) {
+			offset += get_Const_long(get_Add_right(base));
+			base    = get_Add_left(base);
+		} else if (is_Member(base)
+		        && get_type_state(get_entity_owner(get_Member_entity(base)))
+		           == layout_fixed) {
+			offset += get_entity_offset(get_Member_entity(base));
+			base    = get_Member_ptr(base);
+		} else {
+			break;
+		}
+	}
+	*res = (linear_t){ base, 0, offset };
+	return true;
+}
+
+static ir_node *get_memop_ptr(ir_node const *const node)
+{
+	return is_Load(node) ? get_Load_ptr(node) : get_Store_ptr(node);
+}
+
+static ir_mode *get_memop_mode(ir_node const *const node)
+{
+	return is_Load(node) ? get_Load_mode(node)
+	                     : get_irn_mode(get_Store_value(node));
+}
+
+static ir_type *get_memop_type(ir_node const *const node)
+{
+	return is_Load(node) ? get_Load_type(node) : get_Store_type(node);
+}
+
+static bool is_simple_memop(loop_env_t const *const env, ir_node const *const node)
+{
+	if (is_Load(node)) {
+		if (get_Load_volatility(node) == volatility_is_volatile)
+			return false;
+	} else if (is_Store(node)) {
+		if (get_Store_volatility(node) == volatility_is_volatile)
+			return false;
+	} else {
+		return false;
+	}
+	return get_nodes_block(node) == env->body && !ir_throws_exception(node)
+	    && get_memop_mode(node) == env->mode;
+}
+
+/** Records the Load or Store @p node, if its address is consecutive. */
+static bool add_access(loop_env_t *const env, ir_node *const node)
+{
+	linear_t address;
+	if (!get_linear(env, get_memop_ptr(node), &address)
+	 || address.base == NULL
+	 || address.scale != (long)get_mode_size_bytes(env->mode))
+		return false;
+	access_t const access = {
+		.memop  = node,
+		.base   = address.base,
+		.offset = address.offset,
+	};
+	ARR_APP1(access_t, env->accesses, access);
+	return true;
+}
+
+/** Checks that @p mem is available as memory in the vector loop. */
+static bool is_vector_mem(loop_env_t const *const env, ir_node *const mem)
+{
+	if (mem == env->mem_phi || is_invariant(env, mem))
+		return true;
+	ir_node *const pred = is_Proj(mem) ? get_Proj_pred(mem) : mem;
+	for (size_t i = 0, n = ARR_LEN(env->memory); i < n; ++i) {
+		if (env->memory[i] == pred)
+			return true;
+	}
+	return false;
+}
+
+/**
+ * Collects the memory operations and Syncs of the body in front of @p mem.
+ * Returns false if the body contains other nodes producing memory.
+ */
+static bool collect_memory(loop_env_t *const env, ir_node *const mem)
+{
+	if (is_vector_mem(env, mem))
+		return true;
+	if (is_Sync(mem) && get_nodes_block(mem) == env->body) {
+		foreach_irn_in(mem, i, pred) {
+			if (!collect_memory(env, pred))
+				return false;
+		}
+		ARR_APP1(ir_node*, env->memory, mem);
+		return true;
+	}
+	if (!is_Proj(mem))
+		return false;
+	ir_node *const memop = get_Proj_pred(mem);
+	if ((!is_Load(memop) && !is_Store(memop))
+	 || !collect_memory(env, get_memop_mem(memop)))
+		return false;
+	ARR_APP1(ir_node*, env->memory, memop);
+	return true;
+}
+
+static bool is_vector_binop(ir_node const *const node)
+{
+	switch (get_irn_opcode(node)) {
+	case iro_Add:
+	case iro_Sub:
+	case iro_Mul:
+	case iro_And:
+	case iro_Or:
+	case iro_Eor:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/** Checks whether the value @p node can be computed for all lanes. */
+static bool check_value(loop_env_t *const env, ir_node *const node)
+{
+	if (get_irn_mode(node) != env->mode)
+		return false;
+	if (ir_nodeset_contains(&env->values, node))
+		return true;
+
+	if (is_invariant(env, node)) {
+		if (!ir_target.allow_vector(op_Splat, env->vmode))
+			return false;
+	} else if (is_Proj(node)) {
+		ir_node *const load = get_Proj_pred(node);
+		if (get_Proj_num(node) != pn_Load_res || !is_simple_memop(env, load)
+		 || !is_Load(load) || !is_vector_mem(env, get_Load_mem(load)))
+			return false;
+		if (ir_nodeset_insert(&env->loads, load) && !add_access(env, load))
+			return false;
+	} else if (is_vector_binop(node) && get_nodes_block(node) == env->body) {
+		if (!ir_target.allow_vector(get_irn_op(node), env->vmode)
+		 || !check_value(env, get_binop_left(node))
+		 || !check_value(env, get_binop_right(node)))
+			return false;
+	} else {
+		return false;
+	}
+	ir_nodeset_insert(&env->values, node);
+	return true;
+}
+
+/** Checks that @p allowed is the only user of @p node inside the loop. */
+static bool has_only_loop_user(loop_env_t const *const env, ir_node *const node,
+                               ir_node const *const allowed)
+{
+	foreach_out_edge(node, edge) {
+		ir_node *const user = get_edge_src_irn(edge);
+		if (user != allowed && !is_End(user) && !is_invariant(env, user))
+			return false;
+	}
+	return true;
+}
+
+static bool check_reduction(loop_env_t *const env, reduction_t *const red)
+{
+	ir_node *const phi  = red->phi;
+	ir_node *const next = get_irn_n(phi, env->back_pos);
+	if (get_irn_mode(phi) != env->mode || !mode_is_int(env->mode)
+	 || get_nodes_block(next) != env->body)
+		return false;
+	switch (get_irn_opcode(next)) {
+	case iro_Sub:
+		if (get_Sub_left(next) != phi)
+			return false;
+		/* FALLTHROUGH */
+	case iro_Add:
+	case iro_And:
+	case iro_Or:
+	case iro_Eor: {
+		ir_node *const l = get_binop_left(next);
+		ir_node *const r = get_binop_right(next);
+		if (l == phi && r != phi)
+			red->value = r;
+		else if (r == phi && l != phi)
+			red->value = l;
+		else
+			return false;
+		break;
+	}
+	default:
+		return false;
+	}
+	red->next = next;
+	return ir_target.allow_vector(get_irn_op(next), env->vmode)
+	    && has_only_loop_user(env, phi, next)
+	    && has_only_loop_user(env, next, phi)
+	    && check_value(env, red->value);
+}
+
+/**
+ * Checks that the lanes of a vector iteration cannot interfere and records
+ * the pairs of accesses, which have to be checked at runtime.
+ */
+static bool check_dependences(loop_env_t *const env)
+{
+	long const distance = env->n_lanes * get_mode_size_bytes(env->mode);
+	for (size_t i = 0, n = ARR_LEN(env->accesses); i < n; ++i) {
+		access_t const *const a = &env->accesses[i];
+		if (!is_Store(a->memop))
+			continue;
+		for (size_t j = 0; j < n; ++j) {
+			access_t const *const b = &env->accesses[j];
+			if (i == j || (is_Store(b->memop) && j < i))
+				continue;
+			if (a->base == b->base) {
+				long const d = a->offset - b->offset;
+				if (d != 0 && d > -distance && d < distance)
+					return false;
+				continue;
+			}
+			ir_node *const ma = a->memop;
+			ir_node *const mb = b->memop;
+			unsigned const size = get_mode_size_bytes(env->mode);
+			if (get_alias_relation(get_memop_ptr(ma), get_memop_type(ma), size,
+			                       get_memop_ptr(mb), get_memop_type(mb), size)
+			    == ir_no_alias)
+				continue;
+			if (env->n_checks == MAX_RUNTIME_CHECKS)
+				return false;
+			env->checks[env->n_checks][0] = i;
+			env->checks[env->n_checks][1] = j;
+			++env->n_checks;
+		}
+	}
+	return true;
+}
+
+static bool analyze_loop(loop_env_t *const env)
+{
+	ir_node *const header = env->header;
+	ir_node *const body   = env->body;
+	if (get_Block_n_cfgpreds(header) != 2 || get_Block_n_cfgpreds(body) != 1)
+		return false;
+	ir_node *const pred0 = get_Block_cfgpred(header, 0);
+	env->back_pos  = is_Jmp(pred0) && get_nodes_block(pred0) == body ? 0 : 1;
+	env->entry_pos = 1 - env->back_pos;
+	ir_node *const back  = get_Block_cfgpred(header, env->back_pos);
+	ir_node *const entry = get_Block_cfgpred(header, env->entry_pos);
+	if (!is_Jmp(back) || get_nodes_block(back) != body
+	 || !is_invariant(env, entry))
+		return false;
+
+	/* the body is entered, while iv < bound */
+	ir_node *const proj = get_Block_cfgpred(body, 0);
+	if (!is_Proj(proj))
+		return false;
+	ir_node *const cond = get_Proj_pred(proj);
+	if (!is_Cond(cond) || get_nodes_block(cond) != header)
+		return false;
+	ir_node *const cmp = get_Cond_selector(cond);
+	if (!is_Cmp(cmp))
+		return false;
+	ir_relation relation = get_Cmp_relation(cmp);
+	if (get_Proj_num(proj) == pn_Cond_false)
+		relation = get_negated_relation(relation);
+	ir_node *iv    = get_Cmp_left(cmp);
+	ir_node *bound = get_Cmp_right(cmp);
+	if (is_invariant(env, iv)) {
+		ir_node *const tmp = iv;
+		iv       = bound;
+		bound    = tmp;
+		relation = get_inversed_relation(relation);
+	}
+	if (relation != ir_relation_less || !is_Phi(iv)
+	 || get_nodes_block(iv) != header || !mode_is_int(get_irn_mode(iv))
+	 || !is_invariant(env, bound))
+		return false;
+	/* the back edge value must be iv + 1 */
+	ir_node *const iv_next = get_irn_n(iv, env->back_pos);
+	if (!is_Add(iv_next) || get_nodes_block(iv_next) != body)
+		return false;
+	ir_node *const left  = get_Add_left(iv_next);
+	ir_node *const right = get_Add_right(iv_next);
+	if (!(left == iv && is_Const(right) && is_Const_one(right))
+	 && !(right == iv && is_Const(left) && is_Const_one(left)))
+		return false;
+	env->iv    = iv;
+	env->bound = bound;
+
+	/* the header only contains the test and Phis */
+	foreach_out_edge(header, edge) {
+		ir_node *const node = get_edge_src_irn(edge);
+		if (is_End(node) || is_Block(node) || get_nodes_block(node) != header
+		 || node == iv || node == cmp || node == cond)
+			continue;
+		if (is_Proj(node) && get_Proj_pred(node) == cond)
+			continue;
+		if (!is_Phi(node))
+			return false;
+		if (get_irn_mode(node) == mode_M) {
+			if (env->mem_phi != NULL)
+				return false;
+			env->mem_phi = node;
+		} else {
+			reduction_t const red = { .phi = node };
+			ARR_APP1(reduction_t, env->reductions, red);
+		}
+	}
+
+	if (env->mem_phi != NULL
+	 && !collect_memory(env, get_irn_n(env->mem_phi, env->back_pos)))
+		return false;
+
+	for (size_t i = 0, n = ARR_LEN(env->memory); i < n; ++i) {
+		if (!is_Sync(env->memory[i])) {
+			env->mode = get_memop_mode(env->memory[i]);
+			break;
+		}
+	}
+	if (env->mode == NULL && ARR_LEN(env->reductions) > 0)
+		env->mode = get_irn_mode(env->reductions[0].phi);
+	if (env->mode == NULL)
+		return false;
+	unsigned const size = get_mode_size_bytes(env->mode);
+	if ((!mode_is_int(env->mode) && !mode_is_float(env->mode)) || size == 0
+	 || ir_target.vector_size % size != 0 || ir_target.vector_size / size < 2)
+		return false;
+	env->n_lanes = ir_target.vector_size / size;
+	env->vmode   = new_vector_mode(env->mode, env->n_lanes);
+
+	for (size_t i = 0, n = ARR_LEN(env->memory); i < n; ++i) {
+		ir_node *const memop = env->memory[i];
+		if (is_Sync(memop))
+			continue;
+		if (!is_simple_memop(env, memop))
+			return false;
+		if (is_Load(memop)) {
+			if (ir_nodeset_insert(&env->loads, memop) && !add_access(env, memop))
+				return false;
+		} else if (!add_access(env, memop)
+		        || !check_value(env, get_Store_value(memop))) {
+			return false;
+		}
+	}
+	for (size_t i = 0, n = ARR_LEN(env->reductions); i < n; ++i) {
+		if (!check_reduction(env, &env->reductions[i]))
+			return false;
+	}
+	if (ARR_LEN(env->accesses) == 0
+	 || (ARR_LEN(env->accesses) > ir_nodeset_size(&env->loads)
+	     && !ir_target.allow_vector(op_Store, env->vmode))
+	 || (ir_nodeset_size(&env->loads) > 0
+	     && !ir_target.allow_vector(op_Load, env->vmode)))
+		return false;
+	return check_dependences(env);
+}
+
+/** Copies the address @p node into @p block using @p iv as induction variable. */
+static ir_node *copy_address(loop_env_t const *const env, pmap *const map,
+                             ir_node *const node, ir_node *const block,
+                             ir_node *const iv)
+{
+	if (node == env->iv)
+		return iv;
+	if (is_invariant(env, node))
+		return node;
+	ir_node *res = pmap_get(ir_node, map, node);
+	if (res != NULL)
+		return res;
+	res = exact_copy(node);
+	set_nodes_block(res, block);
+	foreach_irn_in(node, i, pred) {
+		set_irn_n(res, i, copy_address(env, map, pred, block, iv));
+	}
+	pmap_insert(map, node, res);
+	return res;
+}
+
+static ir_node *get_vector_mem(loop_env_t const *const env, ir_node *const mem)
+{
+	if (mem == env->mem_phi)
+		return env->vmem_phi;
+	if (is_invariant(env, mem))
+		return mem;
+	ir_node *const res = pmap_get(ir_node, env->vectors, mem);
+	assert(res != NULL);
+	return res;
+}
+
+static ir_node *build_vector(loop_env_t *env, ir_node *node);
+
+static ir_node *new_vector_memop(loop_env_t *const env, ir_node *const memop)
+{
+	dbg_info *const dbgi  = get_irn_dbg_info(memop);
+	ir_node  *const block = env->vbody;
+	ir_node  *const mem   = get_vector_mem(env, get_memop_mem(memop));
+	ir_node  *const ptr   = copy_address(env, env->addresses,
+	                                     get_memop_ptr(memop), block, env->viv);
+	ir_type  *const type  = new_type_array(get_memop_type(memop), env->n_lanes);
+	ir_node  *vmemop;
+	unsigned  pn_M;
+	if (is_Load(memop)) {
+		vmemop = new_rd_Load(dbgi, block, mem, ptr, env->vmode, type,
+		                     cons_unaligned);
+		pn_M   = pn_Load_M;
+		ir_node *const res = get_Proj_for_pn(memop, pn_Load_res);
+		if (res != NULL) {
+			ir_node *const vres = new_r_Proj(vmemop, env->vmode, pn_Load_res);
+			pmap_insert(env->vectors, res, vres);
+		}
+	} else {
+		ir_node *const value = build_vector(env, get_Store_value(memop));
+		vmemop = new_rd_Store(dbgi, block, mem, ptr, value, type,
+		                      cons_unaligned);
+		pn_M   = pn_Store_M;
+	}
+	ir_node *const proj_M = get_Proj_for_pn(memop, pn_M);
+	if (proj_M != NULL)
+		pmap_insert(env->vectors, proj_M, new_r_Proj(vmemop, mode_M, pn_M));
+	return vmemop;
+}
+
+static void new_vector_sync(loop_env_t *const env, ir_node *const sync)
+{
+	int       const arity = get_Sync_n_preds(sync);
+	ir_node **const in    = ALLOCAN(ir_node*, arity);
+	foreach_irn_in(sync, i, pred) {
+		in[i] = get_vector_mem(env, pred);
+	}
+	ir_node *const vsync = new_r_Sync(env->vbody, arity, in);
+	pmap_insert(env->vectors, sync, vsync);
+}
+
+static ir_node *new_binop(dbg_info *const dbgi, unsigned const code,
+                          ir_node *const block, ir_node *const l,
+                          ir_node *const r)
+{
+	switch ((ir_opcode)code) {
+	case iro_Add: return new_rd_Add(dbgi, block, l, r);
+	case iro_Sub: return new_rd_Sub(dbgi, block, l, r);
+	case iro_Mul: return new_rd_Mul(dbgi, block, l, r);
+	case iro_And: return new_rd_And(dbgi, block, l, r);
+	case iro_Or:  return new_rd_Or(dbgi, block, l, r);
+	case iro_Eor: return new_rd_Eor(dbgi, block, l, r);
+	default:      panic("unexpected vector operation");
+	}
+}
+
+static ir_node *build_vector(loop_env_t *const env, ir_node *const node)
+{
+	ir_node *res = pmap_get(ir_node, env->vectors, node);
+	if (res != NULL)
+		return res;
+	if (is_invariant(env, node)) {
+		res = new_rd_Splat(get_irn_dbg_info(node), env->check_block, node,
+		                   env->vmode);
+	} else if (is_Proj(node)) {
+		/* a Load, which is not on the memory cycle */
+		new_vector_memop(env, get_Proj_pred(node));
+		return pmap_get(ir_node, env->vectors, node);
+	} else {
+		ir_node *const l = build_vector(env, get_binop_left(node));
+		ir_node *const r = build_vector(env, get_binop_right(node));
+		res = new_binop(get_irn_dbg_info(node), get_irn_opcode(node),
+		                env->vbody, l, r);
+	}
+	pmap_insert(env->vectors, node, res);
+	return res;
+}
+
+static ir_tarval *get_neutral(ir_node const *const node, ir_mode *const mode)
+{
+	return is_And(node) ? get_mode_all_one(mode) : get_mode_null(mode);
+}
+
+/**
+ * Combines the lanes of the accumulator @p vector and the initial value
+ * @p init of the reduction @p red in @p block.
+ */
+static ir_node *build_horizontal(loop_env_t const *const env,
+                                 reduction_t const *const red,
+                                 ir_node *const block, ir_node *const vector,
+                                 ir_node *const init)
+{
+	ir_graph  *const irg    = get_irn_irg(block);
+	ir_mode   *const mode   = env->mode;
+	ir_type   *const type   = get_type_for_mode(mode);
+	ir_type   *const vtype  = new_type_array(type, env->n_lanes);
+	ir_entity *const entity = new_entity(get_irg_frame_type(irg),
+	                                     id_unique("vreduce"), vtype);
+	ir_node   *const addr   = new_r_Member(block, get_irg_frame(irg), entity);
+	ir_node   *const store  = new_r_Store(block, get_irg_no_mem(irg), addr,
+	                                      vector, vtype, cons_unaligned);
+	ir_node   *const mem    = new_r_Proj(store, mode_M, pn_Store_M);
+	/* the accumulator of a Sub reduction holds the negated sum */
+	unsigned   const code   = is_Sub(red->next) ? (unsigned)iro_Add
+	                                            : get_irn_opcode(red->next);
+	ir_mode   *const mode_offset = get_reference_offset_mode(get_irn_mode(addr));
+	ir_node         *res    = init;
+	for (unsigned i = 0; i < env->n_lanes; ++i) {
+		ir_node *ptr = addr;
+		if (i > 0) {
+			long const offset = i * get_mode_size_bytes(mode);
+			ptr = new_r_Add(block, addr,
+			                new_r_Const_long(irg, mode_offset, offset));
+		}
+		ir_node *const load = new_r_Load(block, mem, ptr, mode, type,
+		                                 cons_none);
+		ir_node *const lane = new_r_Proj(load, mode, pn_Load_res);
+		res = new_binop(NULL, code, block, res, lane);
+	}
+	return res;
+}
+
+/** Builds the condition, under which the vector loop is executed. */
+static ir_node *build_check(loop_env_t const *const env, ir_node *const block)
+{
+	ir_graph *const irg  = get_irn_irg(block);
+	ir_node  *const init = get_irn_n(env->iv, env->entry_pos);
+	ir_node        *res  = new_r_Cmp(block, init, env->bound, ir_relation_less);
+	if (env->n_checks == 0)
+		return res;
+
+	/* the accesses of the vector loop do not overlap, if the distance of the
+	 * addresses is zero or at least the vector size */
+	pmap          *const map      = pmap_create();
+	long           const distance = ir_target.vector_size;
+	for (unsigned i = 0; i < env->n_checks; ++i) {
+		ir_node *const a  = env->accesses[env->checks[i][0]].memop;
+		ir_node *const b  = env->accesses[env->checks[i][1]].memop;
+		ir_node *const pa = copy_address(env, map, get_memop_ptr(a), block,
+		                                 init);
+		ir_node *const pb = copy_address(env, map, get_memop_ptr(b), block,
+		                                 init);
+		ir_mode *const mode  = get_reference_offset_mode(get_irn_mode(pa));
+		ir_mode *const umode = find_unsigned_mode(mode);
+		ir_node *const d     = new_r_Sub(block, pa, pb);
+		ir_node *const zero  = new_r_Const(irg, get_mode_null(mode));
+		ir_node *const same  = new_r_Cmp(block, d, zero, ir_relation_equal);
+		ir_node *const bias  = new_r_Const_long(irg, mode, distance - 1);
+		ir_node *const add   = new_r_Add(block, d, bias);
+		ir_node *const conv  = new_r_Conv(block, add, umode);
+		ir_node *const limit = new_r_Const_long(irg, umode, 2 * distance - 1);
+		ir_node *const far   = new_r_Cmp(block, conv, limit,
+		                                 ir_relation_greater_equal);
+		ir_node *const ok    = new_r_Or(block, same, far);
+		res = new_r_And(block, res, ok);
+	}
+	pmap_destroy(map);
+	return res;
+}
+
+static void build_vector_loop(loop_env_t *const env)
+{
+	ir_node  *const header = env->header;
+	ir_graph *const irg    = get_irn_irg(header);
+	int       const entry  = env->entry_pos;
+	ir_node  *const iv     = env->iv;
+	ir_mode  *const imode  = get_irn_mode(iv);
+	ir_node  *const init   = get_irn_n(iv, entry);
+
+	/* the Phis of the vector header are incomplete during construction */
+	int const rem_opt = get_optimize();
+	set_optimize(0);
+
+	ir_node *const entry_cf = get_Block_cfgpred(header, entry);
+	ir_node *const check    = new_r_Block(irg, 1, &entry_cf);
+	env->check_block = check;
+	ir_node *const cond     = new_r_Cond(check, build_check(env, check));
+	ir_node *const to_loop  = new_r_Proj(cond, mode_X, pn_Cond_true);
+	ir_node *const to_merge = new_r_Proj(cond, mode_X, pn_Cond_false);
+
+	/* the back edges are set after constructing the body */
+	ir_node *const vh_in[]  = { to_loop, to_loop };
+	ir_node *const vheader  = new_r_Block(irg, ARRAY_SIZE(vh_in), vh_in);
+	ir_node *const viv_in[] = { init, init };
+	env->viv = new_r_Phi(vheader, ARRAY_SIZE(viv_in), viv_in, imode);
+	if (env->mem_phi != NULL) {
+		ir_node *const mem  = get_irn_n(env->mem_phi, entry);
+		ir_node *const in[] = { mem, mem };
+		env->vmem_phi = new_r_Phi(vheader, ARRAY_SIZE(in), in, mode_M);
+	}
+	for (size_t i = 0, n = ARR_LEN(env->reductions); i < n; ++i) {
+		reduction_t *const red     = &env->reductions[i];
+		ir_node     *const neutral = new_r_Const(irg,
+		                                         get_neutral(red->next, env->mode));
+		ir_node     *const splat   = new_r_Splat(check, neutral, env->vmode);
+		ir_node     *const in[]    = { splat, splat };
+		red->vphi = new_r_Phi(vheader, ARRAY_SIZE(in), in, env->vmode);
+	}
+
+	/* enter the vector body while at least n_lanes iterations remain */
+	ir_mode *const umode  = find_unsigned_mode(imode);
+	ir_node       *rest   = new_r_Sub(vheader, env->bound, env->viv);
+	if (umode != imode)
+		rest = new_r_Conv(vheader, rest, umode);
+	ir_node *const limit  = new_r_Const_long(irg, umode, env->n_lanes - 1);
+	ir_node *const vcmp   = new_r_Cmp(vheader, rest, limit,
+	                                  ir_relation_greater);
+	ir_node *const vcond  = new_r_Cond(vheader, vcmp);
+	ir_node *const to_vb  = new_r_Proj(vcond, mode_X, pn_Cond_true);
+	ir_node *const to_ve  = new_r_Proj(vcond, mode_X, pn_Cond_false);
+
+	ir_node *const vbody = new_r_Block(irg, 1, &to_vb);
+	env->vbody     = vbody;
+	env->vectors   = pmap_create();
+	env->addresses = pmap_create();
+	for (size_t i = 0, n = ARR_LEN(env->memory); i < n; ++i) {
+		ir_node *const node = env->memory[i];
+		if (is_Sync(node))
+			new_vector_sync(env, node);
+		else
+			new_vector_memop(env, node);
+	}
+	for (size_t i = 0, n = ARR_LEN(env->reductions); i < n; ++i) {
+		reduction_t *const red = &env->reductions[i];
+		ir_node     *const x   = build_vector(env, red->value);
+		ir_node     *const l   = get_binop_left(red->next) == red->phi
+		                         ? red->vphi : x;
+		ir_node     *const r   = l == red->vphi ? x : red->vphi;
+		set_irn_n(red->vphi, 1, new_binop(get_irn_dbg_info(red->next),
+		                                  get_irn_opcode(red->next), vbody,
+		                                  l, r));
+	}
+	ir_node *const step     = new_r_Const_long(irg, imode, env->n_lanes);
+	set_irn_n(env->viv, 1, new_r_Add(vbody, env->viv, step));
+	if (env->mem_phi != NULL) {
+		ir_node *const back = get_irn_n(env->mem_phi, env->back_pos);
+		set_irn_n(env->vmem_phi, 1, get_vector_mem(env, back));
+	}
+	set_irn_n(vheader, 1, new_r_Jmp(vbody));
+
+	/* continue with the scalar loop for the remaining iterations */
+	ir_node *const vexit    = new_r_Block(irg, 1, &to_ve);
+	ir_node *const merge_in[] = { new_r_Jmp(vexit), to_merge };
+	ir_node *const merge    = new_r_Block(irg, ARRAY_SIZE(merge_in), merge_in);
+	ir_node *const iv_in[]  = { env->viv, init };
+	set_irn_n(iv, entry, new_r_Phi(merge, ARRAY_SIZE(iv_in), iv_in, imode));
+	if (env->mem_phi != NULL) {
+		ir_node *const in[] = {
+			env->vmem_phi, get_irn_n(env->mem_phi, entry)
+		};
+		set_irn_n(env->mem_phi, entry,
+		          new_r_Phi(merge, ARRAY_SIZE(in), in, mode_M));
+	}
+	for (size_t i = 0, n = ARR_LEN(env->reductions); i < n; ++i) {
+		reduction_t const *const red  = &env->reductions[i];
+		ir_node           *const rinit = get_irn_n(red->phi, entry);
+		ir_node           *const in[] = {
+			build_horizontal(env, red, vexit, red->vphi, rinit), rinit
+		};
+		set_irn_n(red->phi, entry,
+		          new_r_Phi(merge, ARRAY_SIZE(in), in, env->mode));
+	}
+	set_Block_cfgpred(header, entry, new_r_Jmp(merge));
+
+	pmap_destroy(env->addresses);
+	pmap_destroy(env->vectors);
+	set_optimize(rem_opt);
+}
+
+static bool vectorize_loop(ir_node *const header, ir_node *const body)
+{
+	loop_env_t env;
+	memset(&env, 0, sizeof(env));
+	env.header     = header;
+	env.body       = body;
+	env.memory      = NEW_ARR_F(ir_node*, 0);
+	env.accesses   = NEW_ARR_F(access_t, 0);
+	env.reductions = NEW_ARR_F(reduction_t, 0);
+	ir_nodeset_init(&env.values);
+	ir_nodeset_init(&env.loads);
+
+	bool const ok = analyze_loop(&env);
+	if (ok) {
+		DB((dbg, LEVEL_2, "vectorizing loop %+F with %u lanes, %u checks\n",
+		    header, env.n_lanes, env.n_checks));
+		build_vector_loop(&env);
+	}
+
+	ir_nodeset_destroy(&env.loads);
+	ir_nodeset_destroy(&env.values);
+	DEL_ARR_F(env.reductions);
+	DEL_ARR_F(env.accesses);
+	DEL_ARR_F(env.memory);
+	return ok;
+}
+
+/** Collects the header and body of innermost loops with two blocks. */
+static void collect_loops(ir_loop *const loop, ir_node ***const blocks)
+{
+	ir_node *header = NULL;
+	ir_node *body   = NULL;
+	bool     simple = true;
+	for (size_t i = 0, n = get_loop_n_elements(loop); i < n; ++i) {
+		loop_element const element = get_loop_element(loop, i);
+		if (*element.kind == k_ir_loop) {
+			collect_loops(element.son, blocks);
+			simple = false;
+		} else if (*element.kind == k_ir_node) {
+			ir_node *const block = element.node;
+			if (header == NULL)
+				header = block;
+			else if (body == NULL)
+				body = block;
+			else
+				simple = false;
+		}
+	}
+	if (!simple || body == NULL || get_loop_depth(loop) == 0)
+		return;
+	/* the body has the header as only predecessor */
+	if (get_Block_n_cfgpreds(body) != 1
+	 || get_Block_cfgpred_block(body, 0) != header) {
+		ir_node *const tmp = header;
+		header = body;
+		body   = tmp;
+	}
+	ARR_APP1(ir_node*, *blocks, header);
+	ARR_APP1(ir_node*, *blocks, body);
+}
+
+void loop_vectorize(ir_graph *irg)
+{
+	FIRM_DBG_REGISTER(dbg, "firm.opt.loop-vectorize");
+
+	if (ir_target.vector_size == 0 || ir_target.allow_vector == NULL)
+		return;
+
+	assure_irg_properties(irg, IR_GRAPH_PROPERTY_NO_BADS
+	                         | IR_GRAPH_PROPERTY_NO_TUPLES
+	                         | IR_GRAPH_PROPERTY_CONSISTENT_OUT_EDGES
+	                         | IR_GRAPH_PROPERTY_CONSISTENT_LOOPINFO
+	                         | IR_GRAPH_PROPERTY_CONSISTENT_ENTITY_USAGE);
+	ir_disambiguator_options const opts
+		= get_irg_memory_disambiguator_options(irg);
+	if ((opts & aa_opt_always_alias) == 0)
+		assure_irp_globals_entity_usage_computed();
+
+	ir_node **blocks = NEW_ARR_F(ir_node*, 0);
+	collect_loops(get_irg_loop(irg), &blocks);
+	bool changed = false;
+	for (size_t i = 0, n = ARR_LEN(blocks); i < n; i += 2)
+		changed |= vectorize_loop(blocks[i], blocks[i + 1]);
+	DEL_ARR_F(blocks);
+
+	confirm_irg_properties(irg, changed
+		? IR_GRAPH_PROPERTY_NO_BADS | IR_GRAPH_PROPERTY_NO_TUPLES
+		| IR_GRAPH_PROPERTY_ONE_RETURN | IR_GRAPH_PROPERTY_MANY_RETURNS
+		| IR_GRAPH_PROPERTY_CONSISTENT_OUT_EDGES
+		: IR_GRAPH_PROPERTIES_ALL);
+}
@@ -1430,7 +1430,7 @@ static void reroute_all_mem_users(ir_node *omem, ir_node *nmem)
 	}
 
 	/* all edges previously point to omem now point to nmem */
-	nmem->o.out = omem->o.out;
+	set_irn_out_edges(nmem, get_irn_out_edges(omem));
 }
 
 /**
@@ -1471,7 +1471,7 @@ static void reroute_mem_through(ir_node *omem, ir_node *nmem, ir_node *pass_bl)
 	   temporary obstack here. This should be no problem, as we invalidate the
 	   edges at the end either. */
 	/* first entry is used for the length */
-	nmem->o.out = new_out;
+	set_irn_out_edges(nmem, new_out);
 }
 
 /**
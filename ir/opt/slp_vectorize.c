@@ -0,0 +1,796 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2012 University of Karlsruhe.
+ */
+
+/**
+ * @file
+ * @brief   Straight-line (superword level parallelism) vectorization.
+ *
+ * Groups of Stores to adjacent addresses in a block are the seeds. Starting
+ * at their values the isomorphic expression trees of all lanes are packed
+ * into vector operations: identical lanes become a Splat, Loads from
+ * adjacent addresses become a single vector Load and lane-wise arithmetic
+ * becomes a vector operation. If every lane can be packed, the group is
+ * replaced by one vector Store.
+ */
+#include "array.h"
+#include "debug.h"
+#include "irflag_t.h"
+#include "iredges_t.h"
+#include "irgmod.h"
+#include "irgraph_t.h"
+#include "irgwalk.h"
+#include "irmemory.h"
+#include "irmode_t.h"
+#include "irnode_t.h"
+#include "irnodeset.h"
+#include "iroptimize.h"
+#include "irtools.h"
+#include "obst.h"
+#include "target_t.h"
+#include "type_t.h"
+#include "util.h"
+#include <string.h>
+
+DEBUG_ONLY(static firm_dbg_module_t *dbg;)
+
+/** A Store, which is a candidate for a vector Store. */
+typedef struct store_entry_t {
+	ir_node *store;
+	ir_node *base;   /**< Address without the constant offset. */
+	long     offset; /**< Constant offset from base. */
+} store_entry_t;
+
+typedef enum pack_kind_t {
+	PACK_SPLAT, /**< All lanes are the same value. */
+	PACK_LOAD,  /**< The lanes are results of Loads from adjacent addresses. */
+	PACK_OP,    /**< The lanes are isomorphic binops. */
+} pack_kind_t;
+
+/** A vector value, made up of one scalar node per lane. */
+typedef struct pack_t pack_t;
+struct pack_t {
+	pack_kind_t kind;
+	ir_node   **lanes;  /**< The scalar value of each lane. */
+	pack_t     *ops[2]; /**< Operand packs for PACK_OP. */
+	ir_node    *mem;    /**< Memory of the vector Load for PACK_LOAD. */
+	ir_node    *vector; /**< The constructed vector node. */
+};
+
+typedef struct slp_env_t {
+	struct obstack obst;
+	ir_node       *block;    /**< The block of the current group. */
+	ir_mode       *vmode;    /**< The vector mode of the current group. */
+	unsigned       n_lanes;
+	ir_node      **stores;   /**< The Stores of the group, in lane order. */
+	pack_t       **packs;    /**< All packs of the group. */
+	ir_nodeset_t   scalars;  /**< Lanes of PACK_LOAD and PACK_OP packs. */
+	ir_nodeset_t   removed;  /**< Loads and Stores replaced by the group. */
+	unsigned       n_ops;    /**< Number of PACK_OP and PACK_LOAD packs. */
+	unsigned       n_splats; /**< Number of PACK_SPLAT packs. */
+	bool           changed;
+} slp_env_t;
+
+/** Limits the depth of the packed expression trees. */
+#define MAX_DEPTH 8
+
+static void get_base_and_offset(ir_node *ptr, ir_node **base, long *offset)
+{
+	long     off  = 0;
+	ir_mode *mode = get_irn_mode(ptr);
+	for (;;) {
+		if (is_Add(ptr)) {
+			ir_node *l = get_Add_left(ptr);
+			ir_node *r = get_Add_right(ptr);
+			if (get_irn_mode(l) != mode || !is_Const(r))
+				break;
+			off += get_Const_long(r);
+			ptr  = l;
+		} else if (is_Sub(ptr)) {
+			ir_node *r = get_Sub_right(ptr);
+			if (!is_Const(r))
+				break;
+			off -= get_Const_long(r);
+			ptr  = get_Sub_left(ptr);
+		} else if (is_Sel(ptr)) {
+			ir_node *index = get_Sel_index(ptr);
+			if (!is_Const(index))
+				break;
+			ir_type *type         = get_Sel_type(ptr);
+			ir_type *element_type = get_array_element_type(type);
+			if (get_type_state(element_type) != layout_fixed)
+				break;
+			off += get_type_size(element_type) * get_Const_long(index);
+			ptr  = get_Sel_ptr(ptr);
+		} else if (is_Member(ptr)) {
+			ir_entity *entity = get_Member_entity(ptr);
+			ir_type   *owner  = get_entity_owner(entity);
+			if (get_type_state(owner) != layout_fixed)
+				break;
+			off += get_entity_offset(entity);
+			ptr  = get_Member_ptr(ptr);
+		} else {
+			break;
+		}
+	}
+	*base   = ptr;
+	*offset = off;
+}
+
+static bool is_element_mode(ir_mode const *const mode)
+{
+	return mode_is_int(mode) || mode_is_float(mode);
+}
+
+static void collect_stores(ir_node *node, void *data)
+{
+	if (!is_Store(node)
+	 || get_Store_volatility(node) == volatility_is_volatile
+	 || ir_throws_exception(node))
+		return;
+	ir_mode *const mode  = get_irn_mode(get_Store_value(node));
+	unsigned const bytes = get_mode_size_bytes(mode);
+	if (!is_element_mode(mode) || bytes == 0
+	 || ir_target.vector_size % bytes != 0
+	 || ir_target.vector_size / bytes < 2)
+		return;
+
+	store_entry_t entry = { .store = node };
+	get_base_and_offset(get_Store_ptr(node), &entry.base, &entry.offset);
+	store_entry_t **const entries = (store_entry_t**)data;
+	ARR_APP1(store_entry_t, *entries, entry);
+}
+
+static int cmp_store_entries(void const *const p0, void const *const p1)
+{
+	store_entry_t const *const e0 = (store_entry_t const*)p0;
+	store_entry_t const *const e1 = (store_entry_t const*)p1;
+	long const b0 = get_irn_node_nr(get_nodes_block(e0->store));
+	long const b1 = get_irn_node_nr(get_nodes_block(e1->store));
+	if (b0 != b1)
+		return (b0 > b1) - (b0 < b1);
+	long const base0 = get_irn_node_nr(e0->base);
+	long const base1 = get_irn_node_nr(e1->base);
+	if (base0 != base1)
+		return (base0 > base1) - (base0 < base1);
+	if (e0->offset != e1->offset)
+		return (e0->offset > e1->offset) - (e0->offset < e1->offset);
+	long const n0 = get_irn_node_nr(e0->store);
+	long const n1 = get_irn_node_nr(e1->store);
+	return (n0 > n1) - (n0 < n1);
+}
+
+static ir_node *get_memop_ptr(ir_node const *const node)
+{
+	return is_Load(node) ? get_Load_ptr(node) : get_Store_ptr(node);
+}
+
+static ir_type *get_memop_type(ir_node const *const node)
+{
+	return is_Load(node) ? get_Load_type(node) : get_Store_type(node);
+}
+
+static unsigned get_memop_size(ir_node const *const node)
+{
+	ir_mode *const mode = is_Load(node) ? get_Load_mode(node)
+	                                    : get_irn_mode(get_Store_value(node));
+	return get_mode_size_bytes(mode);
+}
+
+static bool memops_may_alias(ir_node const *const a, ir_node const *const b)
+{
+	return get_alias_relation(get_memop_ptr(a), get_memop_type(a),
+	                          get_memop_size(a), get_memop_ptr(b),
+	                          get_memop_type(b), get_memop_size(b))
+	       != ir_no_alias;
+}
+
+/** Returns the memory output of the memory operation or Sync @p node. */
+static ir_node *get_mem_out(ir_node *const node)
+{
+	if (is_Sync(node))
+		return node;
+	unsigned const pn = is_Load(node) ? (unsigned)pn_Load_M
+	                                  : (unsigned)pn_Store_M;
+	return get_Proj_for_pn(node, pn);
+}
+
+static bool is_load_result(slp_env_t const *const env, ir_node const *const node)
+{
+	if (!is_Proj(node) || get_Proj_num(node) != pn_Load_res)
+		return false;
+	ir_node const *const load = get_Proj_pred(node);
+	return is_Load(load)
+	    && get_nodes_block(load) == env->block
+	    && get_Load_volatility(load) != volatility_is_volatile
+	    && !ir_throws_exception(load);
+}
+
+static bool is_vector_binop(ir_node const *const node)
+{
+	switch (get_irn_opcode(node)) {
+	case iro_Add:
+	case iro_Sub:
+	case iro_Mul:
+	case iro_And:
+	case iro_Or:
+	case iro_Eor:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/** Checks whether @p a and @p b could end up in the same pack. */
+static bool lanes_match(ir_node const *const a, ir_node const *const b)
+{
+	if (get_irn_op(a) != get_irn_op(b))
+		return false;
+	if (is_Proj(a)) {
+		ir_node *const load_a = get_Proj_pred(a);
+		ir_node *const load_b = get_Proj_pred(b);
+		if (!is_Load(load_a) || !is_Load(load_b))
+			return load_a == load_b;
+		ir_node *base_a, *base_b;
+		long     offset_a, offset_b;
+		get_base_and_offset(get_Load_ptr(load_a), &base_a, &offset_a);
+		get_base_and_offset(get_Load_ptr(load_b), &base_b, &offset_b);
+		return base_a == base_b;
+	}
+	return true;
+}
+
+/** Returns the pack with the lanes @p lanes if it was already built. */
+static pack_t *find_pack(slp_env_t const *const env, ir_node *const *const lanes)
+{
+	for (size_t p = 0, n = ARR_LEN(env->packs); p < n; ++p) {
+		pack_t *const pack = env->packs[p];
+		if (memcmp(pack->lanes, lanes, env->n_lanes * sizeof(*lanes)) == 0)
+			return pack;
+	}
+	return NULL;
+}
+
+static pack_t *new_pack(slp_env_t *const env, pack_kind_t const kind,
+                        ir_node **const lanes)
+{
+	pack_t *const pack = OALLOCZ(&env->obst, pack_t);
+	pack->kind  = kind;
+	pack->lanes = lanes;
+	ARR_APP1(pack_t*, env->packs, pack);
+	if (kind == PACK_SPLAT) {
+		++env->n_splats;
+	} else {
+		++env->n_ops;
+		for (unsigned i = 0; i < env->n_lanes; ++i)
+			ir_nodeset_insert(&env->scalars, lanes[i]);
+	}
+	return pack;
+}
+
+static pack_t *build_pack(slp_env_t *const env, ir_node **const lanes,
+                          unsigned const depth)
+{
+	pack_t *const known = find_pack(env, lanes);
+	if (known != NULL)
+		return known;
+
+	unsigned const n_lanes = env->n_lanes;
+	ir_node *const first   = lanes[0];
+	ir_mode *const mode    = get_irn_mode(first);
+	bool           same    = true;
+	for (unsigned i = 1; i < n_lanes; ++i) {
+		if (get_irn_mode(lanes[i]) != mode)
+			return NULL;
+		if (lanes[i] != first)
+			same = false;
+	}
+	if (same) {
+		if (!ir_target.allow_vector(op_Splat, env->vmode))
+			return NULL;
+		return new_pack(env, PACK_SPLAT, lanes);
+	}
+
+	if (is_load_result(env, first)) {
+		ir_node *base0;
+		long     offset0;
+		get_base_and_offset(get_Load_ptr(get_Proj_pred(first)), &base0,
+		                    &offset0);
+		long const bytes = get_mode_size_bytes(mode);
+		for (unsigned i = 1; i < n_lanes; ++i) {
+			if (!is_load_result(env, lanes[i]))
+				return NULL;
+			ir_node *base;
+			long     offset;
+			get_base_and_offset(get_Load_ptr(get_Proj_pred(lanes[i])), &base,
+			                    &offset);
+			if (base != base0 || offset != offset0 + (long)i * bytes)
+				return NULL;
+		}
+		if (!ir_target.allow_vector(op_Load, env->vmode))
+			return NULL;
+		return new_pack(env, PACK_LOAD, lanes);
+	}
+
+	if (depth >= MAX_DEPTH || !is_vector_binop(first)
+	 || get_nodes_block(first) != env->block
+	 || !ir_target.allow_vector(get_irn_op(first), env->vmode))
+		return NULL;
+
+	ir_node **const left  = OALLOCN(&env->obst, ir_node*, n_lanes);
+	ir_node **const right = OALLOCN(&env->obst, ir_node*, n_lanes);
+	bool      const commutative = is_op_commutative(get_irn_op(first));
+	for (unsigned i = 0; i < n_lanes; ++i) {
+		ir_node *const lane = lanes[i];
+		if (get_irn_op(lane) != get_irn_op(first)
+		 || get_nodes_block(lane) != env->block)
+			return NULL;
+		left[i]  = get_binop_left(lane);
+		right[i] = get_binop_right(lane);
+		if (commutative && i > 0 && !lanes_match(left[0], left[i])
+		 && lanes_match(left[0], right[i])) {
+			ir_node *const tmp = left[i];
+			left[i]  = right[i];
+			right[i] = tmp;
+		}
+	}
+
+	pack_t *const l = build_pack(env, left, depth + 1);
+	if (l == NULL)
+		return NULL;
+	pack_t *const r = build_pack(env, right, depth + 1);
+	if (r == NULL)
+		return NULL;
+	pack_t *const pack = new_pack(env, PACK_OP, lanes);
+	pack->ops[0] = l;
+	pack->ops[1] = r;
+	return pack;
+}
+
+/**
+ * Checks that the packed scalars are used only inside the packs or as value
+ * of the grouped Stores, so they become dead after vectorization.
+ */
+static bool scalars_are_private(slp_env_t *const env)
+{
+	/* A splatted scalar stays alive. For a lane of a vector Load this would
+	 * leave a Load without its place in the memory chain. */
+	for (size_t p = 0, n = ARR_LEN(env->packs); p < n; ++p) {
+		pack_t const *const pack = env->packs[p];
+		if (pack->kind == PACK_SPLAT
+		 && ir_nodeset_contains(&env->scalars, pack->lanes[0]))
+			return false;
+	}
+	foreach_ir_nodeset(&env->scalars, node, iter) {
+		foreach_out_edge(node, edge) {
+			ir_node *const user = get_edge_src_irn(edge);
+			if (ir_nodeset_contains(&env->scalars, user))
+				continue;
+			if (is_Store(user) && get_edge_src_pos(edge) == n_Store_value) {
+				for (unsigned i = 0; i < env->n_lanes; ++i) {
+					if (env->stores[i] == user)
+						goto next_edge;
+				}
+			}
+			return false;
+next_edge:;
+		}
+	}
+	return true;
+}
+
+static bool is_group_store(slp_env_t const *const env, ir_node const *const node)
+{
+	for (unsigned i = 0; i < env->n_lanes; ++i) {
+		if (env->stores[i] == node)
+			return true;
+	}
+	return false;
+}
+
+/**
+ * Returns the number of group Stores, which are memory predecessors of
+ * @p store inside the block.
+ */
+static unsigned count_earlier_stores(slp_env_t const *const env,
+                                     ir_node *const store)
+{
+	ir_nodeset_t visited;
+	ir_nodeset_init(&visited);
+	ir_node **worklist = NEW_ARR_F(ir_node*, 0);
+	ARR_APP1(ir_node*, worklist, get_Store_mem(store));
+	unsigned n = 0;
+	while (ARR_LEN(worklist) > 0) {
+		size_t const last = ARR_LEN(worklist) - 1;
+		ir_node     *mem  = worklist[last];
+		ARR_SHRINKLEN(worklist, last);
+		if (is_Proj(mem))
+			mem = get_Proj_pred(mem);
+		if (get_nodes_block(mem) != env->block
+		 || !ir_nodeset_insert(&visited, mem))
+			continue;
+		if (is_Sync(mem)) {
+			foreach_irn_in(mem, i, pred) {
+				ARR_APP1(ir_node*, worklist, pred);
+			}
+		} else if (is_Load(mem)) {
+			ARR_APP1(ir_node*, worklist, get_Load_mem(mem));
+		} else if (is_Store(mem)) {
+			if (is_group_store(env, mem))
+				++n;
+			ARR_APP1(ir_node*, worklist, get_Store_mem(mem));
+		}
+	}
+	DEL_ARR_F(worklist);
+	ir_nodeset_destroy(&visited);
+	return n;
+}
+
+/**
+ * Returns the Sync, which is the only user of the memory of all grouped
+ * Stores, or NULL if there is none. Such independent Stores are left by
+ * opt_parallelize_mem().
+ */
+static ir_node *get_common_sync(slp_env_t const *const env)
+{
+	ir_node *sync = NULL;
+	for (unsigned i = 0; i < env->n_lanes; ++i) {
+		ir_node *const mem = get_Proj_for_pn(env->stores[i], pn_Store_M);
+		if (mem == NULL || get_irn_n_edges(mem) != 1)
+			return NULL;
+		ir_node *const user = get_edge_src_irn(get_irn_out_edge_first(mem));
+		if (!is_Sync(user) || (sync != NULL && user != sync))
+			return NULL;
+		sync = user;
+	}
+	return sync;
+}
+
+/**
+ * Returns the memory before all grouped Stores, which are independent of
+ * each other.
+ */
+static ir_node *get_independent_stores_mem(slp_env_t const *const env)
+{
+	ir_node **const in = ALLOCAN(ir_node*, env->n_lanes);
+	int             n  = 0;
+	for (unsigned i = 0; i < env->n_lanes; ++i) {
+		ir_node *const mem = get_Store_mem(env->stores[i]);
+		for (int j = 0; j < n; ++j) {
+			if (in[j] == mem)
+				goto next;
+		}
+		in[n++] = mem;
+next:;
+	}
+	return n == 1 ? in[0] : new_r_Sync(env->block, n, in);
+}
+
+/** Replaces the memory of the grouped Stores in @p sync by @p mem. */
+static void replace_in_sync(slp_env_t const *const env, ir_node *const sync,
+                            ir_node *const mem)
+{
+	int const       arity = get_Sync_n_preds(sync);
+	ir_node **const in    = ALLOCAN(ir_node*, arity);
+	int             n     = 0;
+	in[n++] = mem;
+	foreach_irn_in(sync, i, pred) {
+		if (!is_Proj(pred) || !is_group_store(env, get_Proj_pred(pred)))
+			in[n++] = pred;
+	}
+	if (n == 1)
+		exchange(sync, mem);
+	else
+		set_irn_in(sync, n, in);
+}
+
+/**
+ * Checks that the effect of @p store can be delayed until @p last: All
+ * memory paths from @p store must lead to @p last and the memory operations
+ * on the way must not touch the memory written by @p store.
+ */
+static bool can_sink_store(slp_env_t const *const env, ir_node *const store,
+                           ir_node *const last)
+{
+	ir_nodeset_t visited;
+	ir_nodeset_init(&visited);
+	ir_node **worklist = NEW_ARR_F(ir_node*, 0);
+	ir_node  *mem_out  = get_mem_out(store);
+	if (mem_out != NULL)
+		ARR_APP1(ir_node*, worklist, mem_out);
+	bool reached = false;
+	bool ok      = true;
+	while (ok && ARR_LEN(worklist) > 0) {
+		size_t   const top = ARR_LEN(worklist) - 1;
+		ir_node *const mem = worklist[top];
+		ARR_SHRINKLEN(worklist, top);
+		foreach_out_edge(mem, edge) {
+			ir_node *const user = get_edge_src_irn(edge);
+			if (user == last) {
+				reached = true;
+				continue;
+			}
+			if (get_nodes_block(user) != env->block) {
+				ok = false;
+				break;
+			}
+			if (!ir_nodeset_insert(&visited, user))
+				continue;
+			if (is_Load(user) || is_Store(user)) {
+				if (!is_group_store(env, user)
+				 && memops_may_alias(store, user)) {
+					ok = false;
+					break;
+				}
+			} else if (!is_Sync(user)) {
+				ok = false;
+				break;
+			}
+			ir_node *const next = get_mem_out(user);
+			if (next != NULL)
+				ARR_APP1(ir_node*, worklist, next);
+		}
+	}
+	DEL_ARR_F(worklist);
+	ir_nodeset_destroy(&visited);
+	return ok && reached;
+}
+
+/**
+ * Determines the memory for the vector Load of @p pack by skipping the
+ * removed memory operations in front of its lanes. Returns NULL if the lanes
+ * do not meet at the same memory or if a skipped Store may alias.
+ */
+static ir_node *get_pack_load_mem(slp_env_t *const env, pack_t const *const pack)
+{
+	ir_node *res = NULL;
+	for (unsigned i = 0; i < env->n_lanes; ++i) {
+		ir_node *const load = get_Proj_pred(pack->lanes[i]);
+		ir_node       *mem  = get_Load_mem(load);
+		while (is_Proj(mem)
+		    && ir_nodeset_contains(&env->removed, get_Proj_pred(mem))) {
+			ir_node *const pred = get_Proj_pred(mem);
+			if (is_Store(pred) && memops_may_alias(pred, load))
+				return NULL;
+			mem = get_memop_mem(pred);
+		}
+		if (res == NULL)
+			res = mem;
+		else if (res != mem)
+			return NULL;
+	}
+	return res;
+}
+
+static ir_node *build_vector(slp_env_t *const env, pack_t *const pack)
+{
+	if (pack->vector != NULL)
+		return pack->vector;
+
+	ir_node  *const first = pack->lanes[0];
+	dbg_info *const dbgi  = get_irn_dbg_info(first);
+	ir_node  *const block = env->block;
+	ir_mode  *const vmode = env->vmode;
+	ir_node  *res;
+	switch (pack->kind) {
+	case PACK_SPLAT:
+		res = new_rd_Splat(dbgi, block, first, vmode);
+		break;
+	case PACK_LOAD: {
+		ir_node *const load  = get_Proj_pred(first);
+		ir_type *const type  = new_type_array(get_Load_type(load),
+		                                      env->n_lanes);
+		ir_node *const vload = new_rd_Load(dbgi, block, pack->mem,
+		                                   get_Load_ptr(load), vmode, type,
+		                                   cons_unaligned);
+		ir_node *const vmem  = new_r_Proj(vload, mode_M, pn_Load_M);
+		/* Accesses ordered after one of the lanes stay ordered after the
+		 * vector Load. */
+		for (unsigned i = 0; i < env->n_lanes; ++i) {
+			ir_node *const lane_load = get_Proj_pred(pack->lanes[i]);
+			ir_node *const lane_mem  = get_Proj_for_pn(lane_load, pn_Load_M);
+			if (lane_mem != NULL)
+				exchange(lane_mem, vmem);
+		}
+		res = new_r_Proj(vload, vmode, pn_Load_res);
+		break;
+	}
+	case PACK_OP: {
+		ir_node *const l = build_vector(env, pack->ops[0]);
+		ir_node *const r = build_vector(env, pack->ops[1]);
+		switch (get_irn_opcode(first)) {
+		case iro_Add: res = new_rd_Add(dbgi, block, l, r); break;
+		case iro_Sub: res = new_rd_Sub(dbgi, block, l, r); break;
+		case iro_Mul: res = new_rd_Mul(dbgi, block, l, r); break;
+		case iro_And: res = new_rd_And(dbgi, block, l, r); break;
+		case iro_Or:  res = new_rd_Or(dbgi, block, l, r);  break;
+		case iro_Eor: res = new_rd_Eor(dbgi, block, l, r); break;
+		default:      panic("unexpected vector operation %+F", first);
+		}
+		break;
+	}
+	default:
+		panic("invalid pack kind");
+	}
+	pack->vector = res;
+	return res;
+}
+
+static bool vectorize_group(slp_env_t *const env, store_entry_t const *const entries)
+{
+	unsigned const n_lanes = env->n_lanes;
+	env->block    = get_nodes_block(entries[0].store);
+	env->stores   = OALLOCN(&env->obst, ir_node*, n_lanes);
+	env->packs    = NEW_ARR_F(pack_t*, 0);
+	env->n_ops    = 0;
+	env->n_splats = 0;
+	ir_nodeset_init(&env->scalars);
+	ir_nodeset_init(&env->removed);
+
+	ir_node **const values = OALLOCN(&env->obst, ir_node*, n_lanes);
+	for (unsigned i = 0; i < n_lanes; ++i) {
+		env->stores[i] = entries[i].store;
+		values[i]      = get_Store_value(entries[i].store);
+	}
+
+	bool     success = false;
+	ir_node *last    = NULL;
+	ir_node *sync    = NULL;
+	pack_t  *root    = NULL;
+	if (!ir_target.allow_vector(op_Store, env->vmode))
+		goto end;
+
+	/* find the Store executed last, the vector Store takes its place */
+	for (unsigned i = 0; i < n_lanes; ++i) {
+		if (count_earlier_stores(env, env->stores[i]) == n_lanes - 1) {
+			last = env->stores[i];
+			break;
+		}
+	}
+	/* otherwise the Stores must be independent, then the vector Store takes
+	 * the place of all of them */
+	if (last == NULL) {
+		sync = get_common_sync(env);
+		if (sync == NULL)
+			goto end;
+	}
+
+	root = build_pack(env, values, 0);
+	if (root == NULL)
+		goto end;
+	/* each splat costs about as much as two scalar operations */
+	if ((env->n_ops + 1) * n_lanes <= env->n_ops + 1 + 2 * env->n_splats)
+		goto end;
+	if (!scalars_are_private(env))
+		goto end;
+
+	for (unsigned i = 0; i < n_lanes; ++i) {
+		ir_node *const store = env->stores[i];
+		if (store == last)
+			continue;
+		if (last != NULL && !can_sink_store(env, store, last))
+			goto end;
+		ir_nodeset_insert(&env->removed, store);
+	}
+	for (size_t p = 0, n = ARR_LEN(env->packs); p < n; ++p) {
+		pack_t const *const pack = env->packs[p];
+		if (pack->kind != PACK_LOAD)
+			continue;
+		for (unsigned i = 0; i < n_lanes; ++i)
+			ir_nodeset_insert(&env->removed, get_Proj_pred(pack->lanes[i]));
+	}
+	for (size_t p = 0, n = ARR_LEN(env->packs); p < n; ++p) {
+		pack_t *const pack = env->packs[p];
+		if (pack->kind != PACK_LOAD)
+			continue;
+		pack->mem = get_pack_load_mem(env, pack);
+		if (pack->mem == NULL)
+			goto end;
+	}
+
+	DB((dbg, LEVEL_2, "vectorizing %u Stores into %+F\n", n_lanes,
+	    env->vmode));
+
+	ir_node *const vector = build_vector(env, root);
+
+	ir_node *mem;
+	if (last != NULL) {
+		for (unsigned i = 0; i < n_lanes; ++i) {
+			ir_node *const store = env->stores[i];
+			if (store == last)
+				continue;
+			ir_node *const store_mem = get_Proj_for_pn(store, pn_Store_M);
+			if (store_mem != NULL)
+				exchange(store_mem, get_Store_mem(store));
+		}
+		mem = get_Store_mem(last);
+	} else {
+		mem = get_independent_stores_mem(env);
+	}
+
+	ir_node  *const store0 = env->stores[0];
+	dbg_info *const dbgi   = get_irn_dbg_info(store0);
+	ir_type  *const type   = new_type_array(get_Store_type(store0), n_lanes);
+	ir_node  *const vstore = new_rd_Store(dbgi, env->block, mem,
+	                                      get_Store_ptr(store0), vector, type,
+	                                      cons_unaligned);
+	if (last != NULL) {
+		exchange(last, vstore);
+	} else {
+		ir_node *const vmem = new_r_Proj(vstore, mode_M, pn_Store_M);
+		replace_in_sync(env, sync, vmem);
+	}
+	success = true;
+
+end:
+	DEL_ARR_F(env->packs);
+	ir_nodeset_destroy(&env->removed);
+	ir_nodeset_destroy(&env->scalars);
+	return success;
+}
+
+static bool is_group(store_entry_t const *const entries, unsigned const n_lanes)
+{
+	ir_node *const store = entries[0].store;
+	ir_node *const block = get_nodes_block(store);
+	ir_mode *const mode  = get_irn_mode(get_Store_value(store));
+	long     const bytes = get_mode_size_bytes(mode);
+	for (unsigned i = 1; i < n_lanes; ++i) {
+		store_entry_t const *const entry = &entries[i];
+		if (get_nodes_block(entry->store) != block
+		 || entry->base != entries[0].base
+		 || entry->offset != entries[0].offset + (long)i * bytes
+		 || get_irn_mode(get_Store_value(entry->store)) != mode)
+			return false;
+	}
+	return true;
+}
+
+void slp_vectorize(ir_graph *irg)
+{
+	FIRM_DBG_REGISTER(dbg, "firm.opt.slp");
+
+	if (ir_target.vector_size == 0 || ir_target.allow_vector == NULL)
+		return;
+
+	assure_irg_properties(irg, IR_GRAPH_PROPERTY_NO_TUPLES
+	                         | IR_GRAPH_PROPERTY_CONSISTENT_OUT_EDGES
+	                         | IR_GRAPH_PROPERTY_CONSISTENT_ENTITY_USAGE);
+	ir_disambiguator_options const opts
+		= get_irg_memory_disambiguator_options(irg);
+	if ((opts & aa_opt_always_alias) == 0)
+		assure_irp_globals_entity_usage_computed();
+
+	store_entry_t *entries = NEW_ARR_F(store_entry_t, 0);
+	irg_walk_graph(irg, NULL, collect_stores, &entries);
+	QSORT_ARR(entries, cmp_store_entries);
+
+	slp_env_t env;
+	obstack_init(&env.obst);
+	env.changed = false;
+	for (size_t i = 0, n = ARR_LEN(entries); i < n;) {
+		ir_node *const store   = entries[i].store;
+		ir_mode *const mode    = get_irn_mode(get_Store_value(store));
+		unsigned const n_lanes
+			= ir_target.vector_size / get_mode_size_bytes(mode);
+		if (i + n_lanes <= n && is_group(&entries[i], n_lanes)) {
+			env.n_lanes = n_lanes;
+			env.vmode   = new_vector_mode(mode, n_lanes);
+			bool const done = vectorize_group(&env, &entries[i]);
+			obstack_free(&env.obst, NULL);
+			obstack_init(&env.obst);
+			if (done) {
+				env.changed = true;
+				i += n_lanes;
+				continue;
+			}
+		}
+		++i;
+	}
+	obstack_free(&env.obst, NULL);
+	DEL_ARR_F(entries);
+
+	confirm_irg_properties(irg, env.changed ? IR_GRAPH_PROPERTIES_CONTROL_FLOW
+	                                        : IR_GRAPH_PROPERTIES_ALL);
+}
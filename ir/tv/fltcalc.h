@@ -46,6 +46,12 @@ typedef struct fp_value fp_value;
 /** Returns the size in bytes of an fp_value */
 unsigned fc_get_value_size(void);
 
+/**
+ * Copies an fp_value. Unlike memcpy() this clears the padding of @p dest, so
+ * the copies of equal values have equal bytes.
+ */
+void fc_copy(fp_value *dest, const fp_value *src);
+
 void fc_val_from_str(const char *str, size_t len, fp_value *result);
 
 /** get the representation of a floating point value
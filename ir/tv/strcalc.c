@@ -21,9 +21,9 @@
 #include <stdlib.h>
 #include <string.h>
 
-#define SC_MASK      ((sc_word)0xFF)
-#define SC_RESULT(x) ((x) & SC_MASK)
-#define SC_CARRY(x)  ((unsigned)(x) >> SC_BITS)
+#define SC_MASK      ((sc_word)-1)
+#define SC_RESULT(x) ((sc_word)(x))
+#define SC_CARRY(x)  ((sc_word)((sc_dword)(x) >> SC_BITS))
 
 static char *output_buffer = NULL;  /**< buffer for output */
 static unsigned bit_pattern_size;   /**< maximum number of bits */
@@ -35,14 +35,21 @@ void sc_zero(sc_word *buffer)
 	memset(buffer, 0, sizeof(buffer[0]) * calc_buffer_size);
 }
 
-static sc_word sex_digit(unsigned x)
+/** Fills @p n words starting at @p buffer with @p word. */
+static void fill_words(sc_word *buffer, sc_word word, unsigned n)
 {
-	return (SC_MASK << (x+1)) & SC_MASK;
+	for (unsigned i = 0; i < n; ++i)
+		buffer[i] = word;
 }
 
 static sc_word max_digit(unsigned x)
 {
-	return (1u << x) - 1;
+	return x == 0 ? 0 : SC_MASK >> (SC_BITS - x);
+}
+
+static sc_word sex_digit(unsigned x)
+{
+	return SC_MASK ^ max_digit(x+1);
 }
 
 static sc_word min_digit(unsigned x)
@@ -108,7 +115,7 @@ void sc_add(const sc_word *val1, const sc_word *val2, sc_word *buffer)
 {
 	sc_word carry = 0;
 	for (unsigned counter = 0; counter < calc_buffer_size; ++counter) {
-		unsigned const sum = val1[counter] + val2[counter] + carry;
+		sc_dword const sum = (sc_dword)val1[counter] + val2[counter] + carry;
 		buffer[counter] = SC_RESULT(sum);
 		carry           = SC_CARRY(sum);
 	}
@@ -123,6 +130,14 @@ void sc_sub(const sc_word *val1, const sc_word *val2, sc_word *buffer)
 	sc_add(val1, temp_buffer, buffer);
 }
 
+/** Returns the number of words of @p value without the leading zero words. */
+static unsigned get_n_words(const sc_word *value, unsigned n)
+{
+	while (n > 0 && value[n-1] == 0)
+		--n;
+	return n;
+}
+
 void sc_mul(const sc_word *val1, const sc_word *val2, sc_word *buffer)
 {
 	sc_word *temp_buffer = ALLOCANZ(sc_word, calc_buffer_size);
@@ -143,12 +158,15 @@ void sc_mul(const sc_word *val1, const sc_word *val2, sc_word *buffer)
 		sign = !sign;
 	}
 
-	for (unsigned c_outer = 0; c_outer < max_value_size; c_outer++) {
+	/* leading zero words do not contribute to the product */
+	unsigned const n_outer = get_n_words(val2, max_value_size);
+	unsigned const n_inner = get_n_words(val1, max_value_size);
+	for (unsigned c_outer = 0; c_outer < n_outer; c_outer++) {
 		sc_word outer = val2[c_outer];
 		if (outer == 0)
 			continue;
-		unsigned carry = 0; /* container for carries */
-		for (unsigned c_inner = 0; c_inner < max_value_size; c_inner++) {
+		sc_word carry = 0; /* container for carries */
+		for (unsigned c_inner = 0; c_inner < n_inner; c_inner++) {
 			sc_word inner = val1[c_inner];
 			/* do the following calculation:
 			 * Add the current carry, the value at position c_outer+c_inner
@@ -157,9 +175,9 @@ void sc_mul(const sc_word *val1, const sc_word *val2, sc_word *buffer)
 			 */
 
 			/* multiplicate the two digits */
-			unsigned const mul = inner*outer;
+			sc_dword const mul = (sc_dword)inner*outer;
 			/* add old value to result of multiplication and the carry */
-			unsigned const sum = temp_buffer[c_inner+c_outer] + mul + carry;
+			sc_dword const sum = temp_buffer[c_inner+c_outer] + mul + carry;
 
 			/* all carries together result in new carry. This is always
 			 * smaller than the base b:
@@ -178,24 +196,100 @@ void sc_mul(const sc_word *val1, const sc_word *val2, sc_word *buffer)
 
 		/* A carry may hang over */
 		/* c_outer is always smaller than max_value_size! */
-		temp_buffer[max_value_size + c_outer] = carry;
+		temp_buffer[n_inner + c_outer] = carry;
 	}
 
 	if (sign)
 		sc_neg(temp_buffer, buffer);
 	else
-		memcpy(buffer, temp_buffer, calc_buffer_size);
+		memcpy(buffer, temp_buffer, calc_buffer_size * sizeof(sc_word));
 }
 
 /**
- * Shift the buffer to left and add an sc digit
+ * Divides the non-negative value @p dividend of @p m words by the
+ * non-negative value @p divisor of @p n words, with m >= n >= 1 (Knuth,
+ * TAOCP Vol. 2, 4.3.1, Algorithm D). The quotient and the remainder must be
+ * zeroed by the caller.
  */
-static void sc_push(sc_word digit, sc_word *buffer)
-{
-	for (unsigned counter = calc_buffer_size - 1; counter-- > 0; ) {
-		buffer[counter+1] = buffer[counter];
+static void divmod_words(const sc_word *dividend, unsigned m,
+                         const sc_word *divisor, unsigned n,
+                         sc_word *quot, sc_word *rem)
+{
+	sc_dword const base = (sc_dword)1 << SC_BITS;
+	if (n == 1) {
+		/* short division */
+		sc_dword const d = divisor[0];
+		sc_dword       r = 0;
+		for (unsigned i = m; i-- > 0; ) {
+			sc_dword const cur = r << SC_BITS | dividend[i];
+			quot[i] = SC_RESULT(cur / d);
+			r       = cur % d;
+		}
+		rem[0] = SC_RESULT(r);
+		return;
+	}
+
+	/* normalize: shift the divisor until its highest bit is set */
+	unsigned const shift = nlz(divisor[n-1]);
+	sc_word *const un    = ALLOCAN(sc_word, m + 1);
+	sc_word *const vn    = ALLOCAN(sc_word, n);
+	for (unsigned i = n; i-- > 1; ) {
+		vn[i] = shift == 0 ? divisor[i]
+		      : divisor[i] << shift | divisor[i-1] >> (SC_BITS - shift);
+	}
+	vn[0] = divisor[0] << shift;
+	un[m] = shift == 0 ? 0 : dividend[m-1] >> (SC_BITS - shift);
+	for (unsigned i = m; i-- > 1; ) {
+		un[i] = shift == 0 ? dividend[i]
+		      : dividend[i] << shift | dividend[i-1] >> (SC_BITS - shift);
+	}
+	un[0] = dividend[0] << shift;
+
+	for (unsigned j = m - n + 1; j-- > 0; ) {
+		/* estimate the quotient digit, it is at most 2 too large */
+		sc_dword const top  = (sc_dword)un[j+n] << SC_BITS | un[j+n-1];
+		sc_dword       qhat = top / vn[n-1];
+		sc_dword       rhat = top % vn[n-1];
+		while (qhat >= base || (rhat < base
+		       && qhat * vn[n-2] > (rhat << SC_BITS | un[j+n-2]))) {
+			--qhat;
+			rhat += vn[n-1];
+		}
+
+		/* multiply and subtract */
+		sc_word borrow = 0;
+		sc_word carry  = 0;
+		for (unsigned i = 0; i < n; ++i) {
+			sc_dword const p    = qhat * vn[i] + carry;
+			sc_word  const sub  = SC_RESULT(p);
+			sc_word  const word = un[i+j];
+			carry     = SC_CARRY(p);
+			un[i+j]   = word - sub - borrow;
+			borrow    = word < sub || (word == sub && borrow);
+		}
+		sc_word const word = un[j+n];
+		un[j+n] = word - carry - borrow;
+		bool const negative = word < carry || (word == carry && borrow);
+
+		/* the estimate was one too large, add back */
+		if (negative) {
+			--qhat;
+			sc_word c = 0;
+			for (unsigned i = 0; i < n; ++i) {
+				sc_dword const sum = (sc_dword)un[i+j] + vn[i] + c;
+				un[i+j] = SC_RESULT(sum);
+				c       = SC_CARRY(sum);
+			}
+			un[j+n] += c;
+		}
+		quot[j] = SC_RESULT(qhat);
+	}
+
+	/* denormalize the remainder */
+	for (unsigned i = 0; i < n; ++i) {
+		rem[i] = shift == 0 ? un[i]
+		       : un[i] >> shift | un[i+1] << (SC_BITS - shift);
 	}
-	buffer[0] = digit;
 }
 
 bool sc_divmod(const sc_word *dividend, const sc_word *divisor,
@@ -225,14 +319,10 @@ bool sc_divmod(const sc_word *dividend, const sc_word *divisor,
 	}
 
 	sc_word *neg_val2 = ALLOCAN(sc_word, calc_buffer_size);
-	sc_neg(divisor, neg_val2);
-	const sc_word *minus_divisor;
 	if (sc_is_negative(divisor)) {
+		sc_neg(divisor, neg_val2);
 		div_sign = !div_sign;
-		minus_divisor = divisor;
 		divisor = neg_val2;
-	} else {
-		minus_divisor = neg_val2;
 	}
 
 	/* if divisor >= dividend division is easy
@@ -243,33 +333,15 @@ bool sc_divmod(const sc_word *dividend, const sc_word *divisor,
 		goto end;
 
 	case ir_relation_less: /* dividend < divisor */
-		memcpy(rem, dividend, calc_buffer_size);
+		memcpy(rem, dividend, calc_buffer_size * sizeof(sc_word));
 		goto end;
 
 	default: /* unluckily division is necessary :( */
 		break;
 	}
 
-	for (unsigned c_dividend = calc_buffer_size; c_dividend-- > 0; ) {
-		sc_push(dividend[c_dividend], rem);
-		sc_push(0, quot);
-
-		if (sc_comp(rem, divisor) != ir_relation_less) {
-			/* remainder >= divisor */
-			/* subtract until the remainder becomes negative, this should
-			 * be faster than comparing remainder with divisor  */
-			sc_add(rem, minus_divisor, rem);
-
-			while (!sc_is_negative(rem)) {
-				/* TODO can this generate carry or is masking redundant? */
-				quot[0] = SC_RESULT(quot[0] + 1);
-				sc_add(rem, minus_divisor, rem);
-			}
-
-			/* subtracted one too much */
-			sc_add(rem, divisor, rem);
-		}
-	}
+	divmod_words(dividend, get_n_words(dividend, calc_buffer_size),
+	             divisor, get_n_words(divisor, calc_buffer_size), quot, rem);
 end:
 	if (div_sign)
 		sc_neg(quot, quot);
@@ -292,10 +364,10 @@ void sc_zero_extend(sc_word *buffer, unsigned from_bits)
 	unsigned bit  = from_bits % SC_BITS;
 	unsigned word = from_bits / SC_BITS;
 	if (bit > 0) {
-		memset(&buffer[word+1], 0, calc_buffer_size-(word+1));
+		fill_words(&buffer[word+1], 0, calc_buffer_size-(word+1));
 		buffer[word] &= max_digit(bit);
 	} else {
-		memset(&buffer[word], 0, calc_buffer_size-word);
+		fill_words(&buffer[word], 0, calc_buffer_size-word);
 	}
 }
 
@@ -307,8 +379,7 @@ void sc_sign_extend(sc_word *buffer, unsigned from_bits)
 	if (sign_bit) {
 		/* sign bit is set, we need sign extension */
 		unsigned word = bits / SC_BITS;
-		for (unsigned i = word + 1; i < calc_buffer_size; ++i)
-			buffer[i] = SC_MASK;
+		fill_words(&buffer[word+1], SC_MASK, calc_buffer_size-(word+1));
 		buffer[word] |= sex_digit(bits % SC_BITS);
 	} else {
 		sc_zero_extend(buffer, from_bits);
@@ -374,61 +445,38 @@ bool sc_val_from_str(bool negative, unsigned base, const char *str, size_t len,
 	return true;
 }
 
-void sc_val_from_long(long value, sc_word *buffer)
+/** Stores the lower 64 bits of a value, the rest of buffer is untouched. */
+static void from_uint64(uint64_t value, sc_word *buffer)
 {
-	bool sign       = value < 0;
-	bool is_minlong = value == LONG_MIN;
-
-	/* use absolute value, special treatment of MIN_LONG to avoid overflow */
-	if (sign) {
-		if (is_minlong)
-			value = -(value+1);
-		else
-			value = -value;
-	}
-
-	sc_zero(buffer);
-
-	sc_word *pos = buffer;
-	while ((value != 0) && (pos < buffer + calc_buffer_size)) {
-		*pos++ = value & SC_MASK;
+	for (unsigned i = 0; i < 64 / SC_BITS && i < calc_buffer_size; ++i) {
+		buffer[i] = SC_RESULT(value);
 		value >>= SC_BITS;
 	}
+}
 
-	if (sign) {
-		if (is_minlong)
-			sc_inc(buffer);
-
-		sc_neg(buffer, buffer);
-	}
+void sc_val_from_long(long value, sc_word *buffer)
+{
+	/* two's complement: the sign is extended into the upper words */
+	fill_words(buffer, value < 0 ? SC_MASK : 0, calc_buffer_size);
+	from_uint64((uint64_t)(int64_t)value, buffer);
 }
 
 void sc_val_from_ulong(unsigned long value, sc_word *buffer)
 {
-	sc_word *pos = buffer;
-
-	while (pos < buffer + calc_buffer_size) {
-		*pos++ = value & SC_MASK;
-		value >>= SC_BITS;
-	}
+	sc_zero(buffer);
+	from_uint64(value, buffer);
 }
 
 long sc_val_to_long(const sc_word *val)
 {
-	unsigned long l = 0;
-	unsigned max_buffer_index = (sizeof(long)*8)/SC_BITS;
-	for (unsigned i = max_buffer_index; i-- > 0; ) {
-		assert(l <= (ULONG_MAX>>SC_BITS) && "signed shift overflow");
-		l = (l << SC_BITS) + val[i];
-	}
-	return l;
+	return (long)sc_val_to_uint64(val);
 }
 
 uint64_t sc_val_to_uint64(const sc_word *val)
 {
 	uint64_t res = 0;
-	for (unsigned i = calc_buffer_size; i-- > 0; ) {
-		res = (res << SC_BITS) + val[i];
+	for (unsigned i = MIN(64 / SC_BITS, calc_buffer_size); i-- > 0; ) {
+		res = res << SC_BITS | val[i];
 	}
 	return res;
 }
@@ -498,7 +546,7 @@ int sc_get_highest_set_bit(const sc_word *value)
 	for (unsigned counter = calc_buffer_size; counter-- > 0; ) {
 		sc_word word = value[counter];
 		if (word != 0)
-			return counter*SC_BITS + (31 - nlz(word));
+			return counter*SC_BITS + (SC_BITS - 1 - nlz(word));
 	}
 	return -1;
 }
@@ -508,7 +556,7 @@ int sc_get_highest_clear_bit(const sc_word *value)
 	for (unsigned counter = calc_buffer_size; counter-- > 0; ) {
 		sc_word word = value[counter] ^ SC_MASK;
 		if (word != 0)
-			return counter*SC_BITS + (31 - nlz(word));
+			return counter*SC_BITS + (SC_BITS - 1 - nlz(word));
 	}
 	return -1;
 }
@@ -526,14 +574,14 @@ int sc_get_lowest_set_bit(const sc_word *value)
 
 void sc_set_bit_at(sc_word *value, unsigned pos)
 {
-	unsigned nibble = pos / SC_BITS;
-	value[nibble] |= 1 << (pos % SC_BITS);
+	unsigned word = pos / SC_BITS;
+	value[word] |= (sc_word)1 << (pos % SC_BITS);
 }
 
 void sc_clear_bit_at(sc_word *value, unsigned pos)
 {
-	unsigned nibble = pos / SC_BITS;
-	value[nibble] &= ~(1 << (pos % SC_BITS));
+	unsigned word = pos / SC_BITS;
+	value[word] &= ~((sc_word)1 << (pos % SC_BITS));
 }
 
 bool sc_is_zero(const sc_word *value, unsigned bits)
@@ -565,17 +613,16 @@ bool sc_is_negative(const sc_word *value)
 
 unsigned char sc_sub_bits(const sc_word *value, unsigned len, unsigned byte_ofs)
 {
-	if (byte_ofs*SC_BITS >= len)
+	unsigned const bit_ofs = byte_ofs * CHAR_BIT;
+	if (bit_ofs >= len)
 		return 0;
 
-	assert(SC_BITS == CHAR_BIT);
-	sc_word val = value[byte_ofs];
+	assert(SC_BITS % CHAR_BIT == 0);
+	unsigned char val = value[bit_ofs / SC_BITS] >> (bit_ofs % SC_BITS);
 	// Mask out if we are at the end
-	if (byte_ofs == (len/SC_BITS)-1) {
-		unsigned bit = len % SC_BITS;
-		if (bit != 0)
-			val &= max_digit(bit);
-	}
+	unsigned const remaining = len - bit_ofs;
+	if (remaining < CHAR_BIT)
+		val &= max_digit(remaining);
 	return val;
 }
 
@@ -600,10 +647,11 @@ void sc_val_from_bytes(unsigned char const *const bytes, size_t n_bytes,
 {
 	assert(n_bytes*CHAR_BIT <= (size_t)calc_buffer_size*SC_BITS);
 
-	sc_word *p = buffer;
-	assert(SC_BITS == CHAR_BIT);
-	memcpy(p, bytes, n_bytes);
-	memset(p+n_bytes, 0, buffer+calc_buffer_size-p);
+	sc_zero(buffer);
+	for (size_t i = 0; i < n_bytes; ++i) {
+		size_t const bit = i * CHAR_BIT;
+		buffer[bit / SC_BITS] |= (sc_word)bytes[i] << (bit % SC_BITS);
+	}
 }
 
 void sc_val_to_bytes(const sc_word *buffer, unsigned char *const dest,
@@ -611,55 +659,34 @@ void sc_val_to_bytes(const sc_word *buffer, unsigned char *const dest,
 {
 	assert(dest_len*CHAR_BIT <= (size_t)calc_buffer_size*SC_BITS);
 
-	assert(SC_BITS == CHAR_BIT);
-	memcpy(dest, buffer, dest_len);
+	for (size_t i = 0; i < dest_len; ++i) {
+		size_t const bit = i * CHAR_BIT;
+		dest[i] = buffer[bit / SC_BITS] >> (bit % SC_BITS);
+	}
 }
 
 void sc_val_from_bits(unsigned char const *const bytes, unsigned from,
                       unsigned to, sc_word *buffer)
 {
 	assert(from < to);
-	assert((to - from) / CHAR_BIT <= calc_buffer_size);
-	assert(CHAR_BIT == 8);
-	assert(SC_BITS == CHAR_BIT);
-
-	sc_word *p = buffer;
-
-	/* see which is the lowest and highest byte, special case if they are
-	 * the same. */
-	const unsigned char *const low      = &bytes[from/CHAR_BIT];
-	const unsigned char *const high     = &bytes[(to-1)/CHAR_BIT];
-	const unsigned             low_bit  = from%CHAR_BIT;
-	const unsigned             high_bit = (to-1)%CHAR_BIT + 1;
-	if (low == high) {
-		uint32_t val
-			= ((uint32_t)*low << (32-high_bit)) >> (32-high_bit+low_bit);
-		*p++ = val & SC_MASK;
-		goto clear_rest;
-	}
-
-	/* lowest byte gets applied partially */
-	uint32_t val = ((uint32_t)*low) >> low_bit;
-	*p     = val & SC_MASK;
-	*(p+1) = 0;
-	unsigned bit = (CHAR_BIT-low_bit)%SC_BITS;
-	p += (CHAR_BIT-low_bit)/SC_BITS;
-	/* fully apply bytes in the middle (but note that they may affect up to 2
-	 * units of the destination number) */
-	for (const unsigned char *mid = low+1; mid < high; ++mid) {
-		uint32_t mval = ((uint32_t)*mid) << bit;
-		*p++   |= (mval >> 0)       & SC_MASK;
-		*p      = (mval >> SC_BITS) & SC_MASK;
-	}
-	/* partially apply the highest byte */
-	uint32_t hval = ((uint32_t)(*high) << (32-high_bit)) >> (32-high_bit-bit);
-	*p++ |= (hval >> 0)       & SC_MASK;
-	if ((hval >> SC_BITS) != 0)
-		*p++ = (hval >> SC_BITS) & SC_MASK;
-
-clear_rest:
-	assert(p <= buffer + calc_buffer_size);
-	memset(p, 0, buffer+calc_buffer_size - p);
+	assert(to - from <= calc_buffer_size * SC_BITS);
+
+	sc_zero(buffer);
+	/* copy the bits in chunks which do not cross a source byte */
+	for (unsigned bit = 0, n_bits = to - from; bit < n_bits; ) {
+		unsigned const src     = from + bit;
+		unsigned const src_bit = src % CHAR_BIT;
+		unsigned const chunk   = MIN(CHAR_BIT - src_bit, n_bits - bit);
+		sc_word  const val     = (bytes[src / CHAR_BIT] >> src_bit)
+		                       & max_digit(chunk);
+
+		unsigned const word     = bit / SC_BITS;
+		unsigned const word_bit = bit % SC_BITS;
+		buffer[word] |= val << word_bit;
+		if (word_bit + chunk > SC_BITS)
+			buffer[word+1] |= val >> (SC_BITS - word_bit);
+		bit += chunk;
+	}
 }
 
 const char *sc_print(const sc_word *value, unsigned bits, enum base_t base,
@@ -683,20 +710,20 @@ char *sc_print_buf(char *buf, size_t buf_len, const sc_word *value,
 	unsigned remaining_bits = bits % SC_BITS;
 	switch (base) {
 	case SC_HEX: {
-		assert(SC_BITS == 8);
+		assert(SC_BITS % 4 == 0);
 		unsigned counter = 0;
 		for ( ; counter < n_full_words; ++counter) {
 			sc_word x = value[counter];
-			*(--pos) = digits[(x >> 0) & 0xf];
-			*(--pos) = digits[(x >> 4) & 0xf];
+			for (unsigned i = 0; i < SC_BITS; i += 4)
+				*(--pos) = digits[(x >> i) & 0xf];
 		}
 
-		/* last nibble must be masked */
+		/* last word must be masked */
 		if (remaining_bits != 0) {
 			sc_word mask = max_digit(remaining_bits);
 			sc_word x    = value[counter++] & mask;
-			*(--pos) = digits[(x >> 0) & 0xf];
-			*(--pos) = digits[(x >> 4) & 0xf];
+			for (unsigned i = 0; i < remaining_bits; i += 4)
+				*(--pos) = digits[(x >> i) & 0xf];
 			assert(pos >= buf);
 		}
 
@@ -709,51 +736,42 @@ char *sc_print_buf(char *buf, size_t buf_len, const sc_word *value,
 		return pos;
 	}
 	case SC_DEC: {
-		sc_word *base_val = ALLOCANZ(sc_word, calc_buffer_size);
-		base_val[0] = 10;
-
-		const sc_word *p        = value;
-		bool           sign     = false;
-		sc_word       *div2_res = ALLOCAN(sc_word, calc_buffer_size);
+		const sc_word *p    = value;
+		bool           sign = false;
+		sc_word       *val  = ALLOCANZ(sc_word, calc_buffer_size);
 		if (is_signed) {
 			/* check for negative values */
 			if (sc_get_bit_at(value, bits-1)) {
-				sc_neg(value, div2_res);
+				sc_neg(value, val);
 				sign = true;
-				p = div2_res;
+				p = val;
 			}
 		}
 
-		/* transfer data into oscillating buffers */
-		sc_word *div1_res = ALLOCANZ(sc_word, calc_buffer_size);
 		unsigned counter = 0;
 		for ( ; counter < n_full_words; ++counter)
-			div1_res[counter] = p[counter];
+			val[counter] = p[counter];
 
-		/* last nibble must be masked */
+		/* last word must be masked */
 		if (bits % SC_BITS) {
 			sc_word mask = max_digit(bits % SC_BITS);
-			div1_res[counter] = p[counter] & mask;
+			val[counter] = p[counter] & mask;
 			++counter;
 		}
 
-		sc_word *m       = div1_res;
-		sc_word *n       = div2_res;
-		sc_word *rem_res = ALLOCAN(sc_word, calc_buffer_size);
-		for (;;) {
-			sc_divmod(m, base_val, n, rem_res);
-			sc_word *t = m;
-			m = n;
-			n = t;
-			*(--pos) = digits[rem_res[0]];
-
-			sc_word x = 0;
-			for (unsigned i = 0; i < calc_buffer_size; ++i)
-				x |= m[i];
-
-			if (x == 0)
-				break;
-		}
+		/* repeated short division by 10, dropping leading zero words */
+		unsigned n_words = counter;
+		do {
+			sc_dword rem = 0;
+			for (unsigned i = n_words; i-- > 0; ) {
+				sc_dword const d = rem << SC_BITS | val[i];
+				val[i] = SC_RESULT(d / 10);
+				rem    = d % 10;
+			}
+			*(--pos) = digits[rem];
+			while (n_words > 0 && val[n_words-1] == 0)
+				--n_words;
+		} while (n_words > 0);
 		assert(pos >= buf);
 		if (sign) {
 			*(--pos) = '-';
@@ -829,7 +847,7 @@ void sc_shlI(const sc_word *value, unsigned shift_count, sc_word *buffer)
 	}
 
 	/* fill up with zeros */
-	memset(buffer, 0, shift_words);
+	fill_words(buffer, 0, shift_words);
 }
 
 void sc_shl(const sc_word *val1, const sc_word *val2, sc_word *buffer)
@@ -867,7 +885,7 @@ bool sc_shrI(const sc_word *value, unsigned shift_count, sc_word *buffer)
 		}
 	} else {
 		sc_word val = value[shift_words];
-		carry_flag |= val & max_digit(shift_bits);
+		carry_flag |= (val & max_digit(shift_bits)) != 0;
 		for (unsigned i = 0; i < calc_buffer_size-shift_words; ++i) {
 			unsigned next_pos = i+shift_words+1;
 			sc_word  next = next_pos < calc_buffer_size ? value[next_pos] : 0;
@@ -878,7 +896,7 @@ bool sc_shrI(const sc_word *value, unsigned shift_count, sc_word *buffer)
 	}
 
 	/* fill upper words with zero */
-	memset(&buffer[calc_buffer_size-shift_words], 0, shift_words);
+	fill_words(&buffer[calc_buffer_size-shift_words], 0, shift_words);
 	return carry_flag;
 }
 
@@ -897,8 +915,7 @@ bool sc_shrsI(const sc_word *value, unsigned shift_count, unsigned bitsize,
 	/* if shifting far enough the result is either 0 or -1 */
 	if (shift_count >= bitsize) {
 		bool carry_flag = !sc_is_zero(value, calc_buffer_size*SC_BITS);
-		assert(SC_BITS <= CHAR_BIT);
-		memset(buffer, sign, calc_buffer_size);
+		fill_words(buffer, sign, calc_buffer_size);
 		return carry_flag;
 	}
 
@@ -914,9 +931,14 @@ bool sc_shrsI(const sc_word *value, unsigned shift_count, unsigned bitsize,
 		}
 	}
 
-	/* TODO: bitsize % SC_BITS != 0 not implemented yet */
-	assert(bitsize % SC_BITS == 0);
-	unsigned limit = bitsize / SC_BITS;
+	/* the highest word may contain bits above bitsize, extend the sign into
+	 * them */
+	unsigned limit = (bitsize + SC_BITS - 1) / SC_BITS;
+	sc_word  high  = value[limit-1];
+	if (bitsize % SC_BITS != 0) {
+		sc_word const mask = max_digit(bitsize % SC_BITS);
+		high = (high & mask) | (sign & ~mask);
+	}
 
 	/* shift to the right */
 	if (shift_bits == 0) {
@@ -924,12 +946,14 @@ bool sc_shrsI(const sc_word *value, unsigned shift_count, unsigned bitsize,
 		for (unsigned i = 0; i < limit-shift_words; ++i) {
 			buffer[i] = value[i+shift_words];
 		}
+		buffer[limit-shift_words-1] = high;
 	} else {
-		sc_word val = value[shift_words];
-		carry_flag |= val & max_digit(shift_bits);
+		sc_word val = shift_words == limit-1 ? high : value[shift_words];
+		carry_flag |= (val & max_digit(shift_bits)) != 0;
 		for (unsigned i = 0; i < limit-shift_words; ++i) {
 			unsigned next_pos = i+shift_words+1;
-			sc_word next = next_pos<limit ? value[next_pos] : sign;
+			sc_word  next     = next_pos < limit-1 ? value[next_pos]
+			                  : next_pos == limit-1 ? high : sign;
 			buffer[i] = SC_RESULT(val >> shift_bits)
 			          | SC_RESULT(next << (SC_BITS - shift_bits));
 			val = next;
@@ -937,9 +961,8 @@ bool sc_shrsI(const sc_word *value, unsigned shift_count, unsigned bitsize,
 	}
 
 	/* fill upper words with extended sign */
-	assert(SC_BITS <= CHAR_BIT);
-	memset(&buffer[limit-shift_words], sign,
-	       calc_buffer_size-(limit-shift_words));
+	fill_words(&buffer[limit-shift_words], sign,
+	           calc_buffer_size-(limit-shift_words));
 	return carry_flag;
 }
 
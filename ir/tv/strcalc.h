@@ -16,9 +16,13 @@
 #include <stdlib.h>
 #include "firm_types.h"
 
-#define SC_BITS 8
+/** Number of bits of a limb (sc_word) of a strcalc value. */
+#define SC_BITS 32
 
-typedef uint8_t sc_word;
+/** A limb of a strcalc value, values are stored little endian. */
+typedef uint32_t sc_word;
+/** Double width limb used for carries, products and quotients. */
+typedef uint64_t sc_dword;
 
 /**
  * The output mode for integer values.
@@ -247,8 +251,8 @@ unsigned sc_get_precision(void);
 /** Return the bit at a given position. */
 static inline bool sc_get_bit_at(const sc_word *value, unsigned pos)
 {
-	unsigned nibble = pos / SC_BITS;
-	return (value[nibble] >> (pos % SC_BITS)) & 1;
+	unsigned word = pos / SC_BITS;
+	return (value[word] >> (pos % SC_BITS)) & 1;
 }
 
 /** Set the bit at the specified position. */
@@ -42,6 +42,9 @@
  * constant target values */
 #define N_CONSTANTS 2048
 
+/** Number of entries of the small integer tarval cache, a power of 2. */
+#define N_SMALL_CACHE 1024
+
 /** A set containing all existing tarvals. */
 static struct set *tarvals = NULL;
 
@@ -51,10 +54,23 @@ static unsigned fp_value_size;
 /** The integer overflow mode. */
 static bool wrap_on_overflow = true;
 
+/** An entry of the small integer tarval cache. */
+typedef struct small_cache_entry_t {
+	ir_mode const *mode;  /**< mode of the cached tarval, NULL if unused */
+	uint64_t       value; /**< normalized value of the cached tarval */
+	ir_tarval     *tv;    /**< the cached tarval */
+} small_cache_entry_t;
+
+/**
+ * A direct mapped cache in front of the tarval set for recently created
+ * integer tarvals of modes with at most 64 bits.
+ */
+static small_cache_entry_t small_cache[N_SMALL_CACHE];
+
 /** Hash a tarval. */
 static unsigned hash_tv(ir_tarval const *const tv)
 {
-	return hash_combine(hash_ptr(tv->mode), hash_data(tv->value, tv->length));
+	return hash_combine(hash_ptr(tv->mode), hash_data((unsigned char const*)tv->value, tv->length));
 }
 
 static int cmp_tv(const void *p1, const void *p2, size_t n)
@@ -81,14 +97,14 @@ static ir_tarval *get_fp_tarval(const fp_value *value, ir_mode *mode)
 	tv->kind   = k_tarval;
 	tv->mode   = mode;
 	tv->length = fp_value_size;
-	memcpy(tv->value, value, fp_value_size);
+	fc_copy((fp_value*)tv->value, value);
 	return identify_tarval(tv);
 }
 
 static ir_tarval *get_int_tarval(const sc_word *value, ir_mode *mode)
 {
 	unsigned size = sc_value_length * sizeof(sc_word);
-	ir_tarval *const tv = ALLOCAF(ir_tarval, value, size);
+	ir_tarval *const tv = ALLOCAF(ir_tarval, value, sc_value_length);
 	tv->kind   = k_tarval;
 	tv->mode   = mode;
 	tv->length = size;
@@ -127,6 +143,161 @@ static ir_tarval *get_int_tarval_overflow(const sc_word *value, ir_mode *mode)
 	return get_int_tarval(value, mode);
 }
 
+/**
+ * Returns true if values of @p mode can be computed with 64 bit machine
+ * arithmetic instead of strcalc. Operations which may overflow only take this
+ * path if wrap_on_overflow is set, as overflows are not detected there.
+ */
+static bool is_small_int_mode(ir_mode const *const mode)
+{
+	return get_mode_arithmetic(mode) == irma_twos_complement
+	    && get_mode_size_bits(mode) <= 64;
+}
+
+/** Returns the lower 64 bits of an integer tarval. */
+static uint64_t get_small_value(ir_tarval const *const tv)
+{
+	uint64_t res = 0;
+	for (unsigned i = 64 / SC_BITS; i-- > 0; )
+		res = res << SC_BITS | tv->value[i];
+	return res;
+}
+
+/**
+ * Truncates @p value to the size of @p mode and sign extends it to 64 bits
+ * for signed modes, which is how values of small modes are stored.
+ */
+static uint64_t normalize_small(uint64_t value, ir_mode const *const mode)
+{
+	unsigned const bits = get_mode_size_bits(mode);
+	if (bits < 64) {
+		uint64_t const mask = ((uint64_t)1 << bits) - 1;
+		value &= mask;
+		if (mode_is_signed(mode) && (value >> (bits - 1)) & 1)
+			value |= ~mask;
+	}
+	return value;
+}
+
+/**
+ * Returns the tarval of @p mode for @p value, which needs not be truncated
+ * to the mode size.
+ */
+static ir_tarval *get_small_int_tarval(uint64_t value, ir_mode *const mode)
+{
+	assert(is_small_int_mode(mode));
+	value = normalize_small(value, mode);
+
+	unsigned const hash = hash_combine(hash_ptr(mode),
+	                                   (unsigned)(value ^ value >> 32));
+	small_cache_entry_t *const entry = &small_cache[hash & (N_SMALL_CACHE-1)];
+	if (entry->mode == mode && entry->value == value)
+		return entry->tv;
+
+	unsigned   const size = sc_value_length * sizeof(sc_word);
+	ir_tarval *const tv   = ALLOCAF(ir_tarval, value, sc_value_length);
+	tv->kind   = k_tarval;
+	tv->mode   = mode;
+	tv->length = size;
+	for (unsigned i = 0; i < 64 / SC_BITS; ++i)
+		tv->value[i] = (sc_word)(value >> (i * SC_BITS));
+	/* upper words are sign or zero extension of the normalized value */
+	sc_word const fill = mode_is_signed(mode) && (int64_t)value < 0
+	                   ? (sc_word)-1 : 0;
+	for (unsigned i = 64 / SC_BITS; i < sc_value_length; ++i)
+		tv->value[i] = fill;
+
+	ir_tarval *const res = identify_tarval(tv);
+	entry->mode  = mode;
+	entry->value = value;
+	entry->tv    = res;
+	return res;
+}
+
+/**
+ * Computes quotient and remainder of two small integer tarvals of the same
+ * mode, rounding towards zero. The divisor must not be zero.
+ */
+static void small_divmod(ir_tarval const *const a, ir_tarval const *const b,
+                         uint64_t *const div, uint64_t *const mod)
+{
+	uint64_t const va = get_small_value(a);
+	uint64_t const vb = get_small_value(b);
+	uint64_t       q;
+	uint64_t       r;
+	if (!mode_is_signed(a->mode)) {
+		q = va / vb;
+		r = va % vb;
+	} else if ((int64_t)vb == -1) {
+		/* INT64_MIN / -1 is undefined in C, the result wraps around */
+		q = -va;
+		r = 0;
+	} else {
+		q = (uint64_t)((int64_t)va / (int64_t)vb);
+		r = (uint64_t)((int64_t)va % (int64_t)vb);
+	}
+	if (div != NULL)
+		*div = q;
+	if (mod != NULL)
+		*mod = r;
+}
+
+/**
+ * Determines the shift count for shifting the small integer tarval @p a by
+ * @p b, applying the modulo shift of the mode.
+ *
+ * @return false if the count does not fit the fast path
+ */
+static bool get_small_shift_count(ir_tarval const *const a,
+                                  ir_tarval const *const b,
+                                  unsigned *const count)
+{
+	if (!is_small_int_mode(a->mode) || !is_small_int_mode(b->mode))
+		return false;
+	uint64_t const vb = get_small_value(b);
+	if (mode_is_signed(b->mode) && (int64_t)vb < 0)
+		return false;
+	unsigned const modulo = get_mode_modulo_shift(a->mode);
+	uint64_t const res    = modulo != 0 ? vb % modulo : vb;
+	*count = res < 64 ? (unsigned)res : 64;
+	return true;
+}
+
+/** Shifts a small integer tarval left. */
+static ir_tarval *small_shl(ir_tarval const *const a, unsigned const count)
+{
+	uint64_t const va = get_small_value(a);
+	return get_small_int_tarval(count < 64 ? va << count : 0, a->mode);
+}
+
+/** Shifts a small integer tarval right, shifting in zeros. */
+static ir_tarval *small_shr(ir_tarval const *const a, unsigned const count)
+{
+	ir_mode *const mode = a->mode;
+	unsigned const bits = get_mode_size_bits(mode);
+	uint64_t       va   = get_small_value(a);
+	if (bits < 64)
+		va &= ((uint64_t)1 << bits) - 1;
+	return get_small_int_tarval(count < 64 ? va >> count : 0, mode);
+}
+
+/**
+ * Shifts a small integer tarval right, replicating the highest bit of the
+ * mode, even for unsigned modes.
+ */
+static ir_tarval *small_shrs(ir_tarval const *const a, unsigned const count)
+{
+	ir_mode *const mode = a->mode;
+	unsigned const bits = get_mode_size_bits(mode);
+	uint64_t       va   = get_small_value(a);
+	if (bits < 64 && (va >> (bits - 1)) & 1)
+		va |= ~(uint64_t)0 << bits;
+	bool     const neg = (int64_t)va < 0;
+	unsigned const c   = count < 64 ? count : 63;
+	uint64_t const res = neg ? ~(~va >> c) : va >> c;
+	return get_small_int_tarval(res, mode);
+}
+
 static ir_tarval tarval_bad_obj;
 static ir_tarval tarval_unknown_obj;
 
@@ -217,6 +388,7 @@ ir_tarval *new_tarval_from_str(const char *str, size_t len, ir_mode *mode)
 
 	case irms_auxiliary:
 	case irms_data:
+	case irms_vector:
 	case irms_internal_boolean:
 		break;
 	}
@@ -226,6 +398,9 @@ ir_tarval *new_tarval_from_str(const char *str, size_t len, ir_mode *mode)
 ir_tarval *new_tarval_from_long(long l, ir_mode *mode)
 {
 	assert(get_mode_arithmetic(mode) == irma_twos_complement);
+	if (is_small_int_mode(mode))
+		return get_small_int_tarval((uint64_t)l, mode);
+
 	sc_word *const buffer = ALLOCAN(sc_word, sc_value_length);
 	sc_val_from_long(l, buffer);
 	return get_int_tarval(buffer, mode);
@@ -315,6 +490,8 @@ int tarval_is_long(ir_tarval const *tv)
 long get_tarval_long(const ir_tarval* tv)
 {
 	assert(tarval_is_long(tv));
+	if (is_small_int_mode(tv->mode))
+		return (long)get_small_value(tv);
 	return sc_val_to_long(tv->value);
 }
 
@@ -335,6 +512,8 @@ bool tarval_is_uint64(ir_tarval const *tv)
 uint64_t get_tarval_uint64(ir_tarval const *tv)
 {
 	assert(tarval_is_uint64(tv));
+	if (is_small_int_mode(tv->mode))
+		return get_small_value(tv);
 	return sc_val_to_uint64(tv->value);
 }
 
@@ -475,6 +654,7 @@ void init_mode_values(ir_mode* mode)
 
 	case irms_auxiliary:
 	case irms_data:
+	case irms_vector:
 		mode->all_one   = tarval_bad;
 		mode->min       = tarval_bad;
 		mode->max       = tarval_bad;
@@ -502,6 +682,7 @@ int tarval_is_negative(ir_tarval const *const a)
 	case irms_auxiliary:
 	case irms_internal_boolean:
 	case irms_data:
+	case irms_vector:
 		break;
 	}
 	panic("invalid mode sort");
@@ -557,6 +738,13 @@ ir_relation tarval_cmp(ir_tarval const *const a, ir_tarval const *const b)
 	case irms_int_number:
 		if (a == b)
 			return ir_relation_equal;
+		if (is_small_int_mode(a->mode)) {
+			uint64_t const va = get_small_value(a);
+			uint64_t const vb = get_small_value(b);
+			bool     const lt = mode_is_signed(a->mode)
+			                  ? (int64_t)va < (int64_t)vb : va < vb;
+			return lt ? ir_relation_less : ir_relation_greater;
+		}
 		return sc_comp(a->value, b->value);
 
 	case irms_internal_boolean:
@@ -566,6 +754,7 @@ ir_relation tarval_cmp(ir_tarval const *const a, ir_tarval const *const b)
 
 	case irms_auxiliary:
 	case irms_data:
+	case irms_vector:
 		break;
 	}
 	panic("invalid mode sort");
@@ -617,6 +806,7 @@ ir_tarval *tarval_convert_to(ir_tarval const *const src,
 		case irms_internal_boolean:
 		case irms_auxiliary:
 		case irms_data:
+		case irms_vector:
 			break;
 		}
 		/* the rest can't be converted */
@@ -629,7 +819,7 @@ ir_tarval *tarval_convert_to(ir_tarval const *const src,
 		case irms_reference:
 		case irms_int_number: {
 			sc_word *const buffer = ALLOCAN(sc_word, sc_value_length);
-			memcpy(buffer, src->value, sc_value_length);
+			memcpy(buffer, src->value, sc_value_length * sizeof(sc_word));
 			return get_int_tarval_overflow(buffer, dst_mode);
 		}
 
@@ -650,6 +840,7 @@ ir_tarval *tarval_convert_to(ir_tarval const *const src,
 		}
 		case irms_auxiliary:
 		case irms_data:
+		case irms_vector:
 		case irms_internal_boolean:
 			break;
 		}
@@ -658,7 +849,7 @@ ir_tarval *tarval_convert_to(ir_tarval const *const src,
 	case irms_reference:
 		if (get_mode_arithmetic(dst_mode) == irma_twos_complement) {
 			sc_word *const buffer = ALLOCAN(sc_word, sc_value_length);
-			memcpy(buffer, src->value, sc_value_length);
+			memcpy(buffer, src->value, sc_value_length * sizeof(sc_word));
 			unsigned bits = get_mode_size_bits(src->mode);
 			if (mode_is_signed(src->mode)) {
 				sc_sign_extend(buffer, bits);
@@ -671,6 +862,7 @@ ir_tarval *tarval_convert_to(ir_tarval const *const src,
 
 	case irms_auxiliary:
 	case irms_data:
+	case irms_vector:
 	case irms_internal_boolean:
 		return tarval_bad;
 	}
@@ -699,6 +891,9 @@ ir_tarval *tarval_not(ir_tarval const *const a)
 		return a == tarval_b_true ? tarval_b_false : tarval_b_true;
 
 	assert(get_mode_arithmetic(mode) == irma_twos_complement);
+	if (is_small_int_mode(mode))
+		return get_small_int_tarval(~get_small_value(a), mode);
+
 	sc_word *const buffer = ALLOCAN(sc_word, sc_value_length);
 	sc_not(a->value, buffer);
 	return get_int_tarval(buffer, mode);
@@ -710,6 +905,9 @@ ir_tarval *tarval_neg(ir_tarval const *const a)
 	switch (get_mode_sort(mode)) {
 	case irms_int_number:
 	case irms_reference: {
+		if (wrap_on_overflow && is_small_int_mode(mode))
+			return get_small_int_tarval(-get_small_value(a), mode);
+
 		sc_word *const buffer = ALLOCAN(sc_word, sc_value_length);
 		sc_neg(a->value, buffer);
 		return get_int_tarval_overflow(buffer, mode);
@@ -723,6 +921,7 @@ ir_tarval *tarval_neg(ir_tarval const *const a)
 
 	case irms_auxiliary:
 	case irms_data:
+	case irms_vector:
 	case irms_internal_boolean:
 		break;
 	}
@@ -745,6 +944,11 @@ ir_tarval *tarval_add(ir_tarval const *a, ir_tarval const *b)
 	case irms_int_number: {
 		/* modes of a,b are equal, so result has mode of a as this might be the
 		 * character */
+		if (wrap_on_overflow && is_small_int_mode(mode)) {
+			return get_small_int_tarval(get_small_value(a) + get_small_value(b),
+			                            mode);
+		}
+
 		sc_word *const buffer = ALLOCAN(sc_word, sc_value_length);
 		sc_add(a->value, b->value, buffer);
 		return get_int_tarval_overflow(buffer, mode);
@@ -758,6 +962,7 @@ ir_tarval *tarval_add(ir_tarval const *a, ir_tarval const *b)
 
 	case irms_auxiliary:
 	case irms_data:
+	case irms_vector:
 	case irms_internal_boolean:
 		return tarval_bad;
 	}
@@ -786,6 +991,11 @@ ir_tarval *tarval_sub(ir_tarval const *a, ir_tarval const *b)
 	case irms_int_number: {
 		/* modes of a,b are equal, so result has mode of a as this might be the
 		 * character */
+		if (wrap_on_overflow && is_small_int_mode(dst_mode)) {
+			return get_small_int_tarval(get_small_value(a) - get_small_value(b),
+			                            dst_mode);
+		}
+
 		sc_word *const buffer = ALLOCAN(sc_word, sc_value_length);
 		sc_sub(a->value, b->value, buffer);
 		return get_int_tarval_overflow(buffer, dst_mode);
@@ -799,6 +1009,7 @@ ir_tarval *tarval_sub(ir_tarval const *a, ir_tarval const *b)
 
 	case irms_auxiliary:
 	case irms_data:
+	case irms_vector:
 	case irms_internal_boolean:
 		return tarval_bad;
 	}
@@ -814,6 +1025,11 @@ ir_tarval *tarval_mul(ir_tarval const *const a, ir_tarval const *const b)
 	case irms_int_number:
 	case irms_reference: {
 		/* modes of a,b are equal */
+		if (wrap_on_overflow && is_small_int_mode(mode)) {
+			return get_small_int_tarval(get_small_value(a) * get_small_value(b),
+			                            mode);
+		}
+
 		sc_word *const buffer = ALLOCAN(sc_word, sc_value_length);
 		sc_mul(a->value, b->value, buffer);
 		return get_int_tarval_overflow(buffer, mode);
@@ -827,6 +1043,7 @@ ir_tarval *tarval_mul(ir_tarval const *const a, ir_tarval const *const b)
 
 	case irms_auxiliary:
 	case irms_data:
+	case irms_vector:
 	case irms_internal_boolean:
 		return tarval_bad;
 	}
@@ -845,6 +1062,12 @@ ir_tarval *tarval_div(ir_tarval const *const a, ir_tarval const *const b)
 		if (b == get_mode_null(mode))
 			return tarval_bad;
 
+		if (is_small_int_mode(mode)) {
+			uint64_t div;
+			small_divmod(a, b, &div, NULL);
+			return get_small_int_tarval(div, mode);
+		}
+
 		sc_word *const buffer = ALLOCAN(sc_word, sc_value_length);
 		sc_div(a->value, b->value, buffer);
 		return get_int_tarval(buffer, mode);
@@ -858,6 +1081,7 @@ ir_tarval *tarval_div(ir_tarval const *const a, ir_tarval const *const b)
 
 	case irms_auxiliary:
 	case irms_data:
+	case irms_vector:
 	case irms_internal_boolean:
 		panic("operation not defined on mode");
 	}
@@ -873,6 +1097,12 @@ ir_tarval *tarval_mod(ir_tarval const *const a, ir_tarval const *const b)
 	/* x/0 error */
 	if (b == get_mode_null(mode))
 		return tarval_bad;
+	if (is_small_int_mode(mode)) {
+		uint64_t mod;
+		small_divmod(a, b, NULL, &mod);
+		return get_small_int_tarval(mod, mode);
+	}
+
 	sc_word *const buffer = ALLOCAN(sc_word, sc_value_length);
 	sc_mod(a->value, b->value, buffer);
 	return get_int_tarval(buffer, mode);
@@ -885,12 +1115,19 @@ ir_tarval *tarval_divmod(ir_tarval const *const a, ir_tarval const *const b,
 	assert(b->mode == mode);
 	assert(get_mode_arithmetic(mode) == irma_twos_complement);
 
-	sc_word *const div_res = ALLOCAN(sc_word, sc_value_length);
-	sc_word *const mod_res = ALLOCAN(sc_word, sc_value_length);
-
 	/* x/0 error */
 	if (b == get_mode_null(mode))
 		return tarval_bad;
+	if (is_small_int_mode(mode)) {
+		uint64_t div_val;
+		uint64_t mod_val;
+		small_divmod(a, b, &div_val, &mod_val);
+		*mod = get_small_int_tarval(mod_val, mode);
+		return get_small_int_tarval(div_val, mode);
+	}
+
+	sc_word *const div_res = ALLOCAN(sc_word, sc_value_length);
+	sc_word *const mod_res = ALLOCAN(sc_word, sc_value_length);
 	sc_divmod(a->value, b->value, div_res, mod_res);
 	*mod = get_int_tarval(mod_res, mode);
 	return get_int_tarval(div_res, mode);
@@ -911,6 +1148,10 @@ ir_tarval *tarval_and(ir_tarval const *const a, ir_tarval const *const b)
 		return a == tarval_b_false ? (ir_tarval*)a : (ir_tarval*)b;
 
 	assert(get_mode_arithmetic(mode) == irma_twos_complement);
+	if (is_small_int_mode(mode))
+		return get_small_int_tarval(get_small_value(a) & get_small_value(b),
+		                            mode);
+
 	sc_word *const buffer = ALLOCAN(sc_word, sc_value_length);
 	sc_and(a->value, b->value, buffer);
 	return get_int_tarval(buffer, mode);
@@ -924,6 +1165,10 @@ ir_tarval *tarval_andnot(ir_tarval const *const a, ir_tarval const *const b)
 		return a == tarval_b_true && b == tarval_b_false ? tarval_b_true
 		                                                 : tarval_b_false;
 	assert(get_mode_arithmetic(mode) == irma_twos_complement);
+	if (is_small_int_mode(mode))
+		return get_small_int_tarval(get_small_value(a) & ~get_small_value(b),
+		                            mode);
+
 	sc_word *const buffer = ALLOCAN(sc_word, sc_value_length);
 	sc_andnot(a->value, b->value, buffer);
 	return get_int_tarval(buffer, mode);
@@ -937,6 +1182,10 @@ ir_tarval *tarval_or(ir_tarval const *const a, ir_tarval const *const b)
 		return a == tarval_b_true ? (ir_tarval*)a : (ir_tarval*)b;
 
 	assert(get_mode_arithmetic(mode) == irma_twos_complement);
+	if (is_small_int_mode(mode))
+		return get_small_int_tarval(get_small_value(a) | get_small_value(b),
+		                            mode);
+
 	sc_word *const buffer = ALLOCAN(sc_word, sc_value_length);
 	sc_or(a->value, b->value, buffer);
 	return get_int_tarval(buffer, mode);
@@ -950,6 +1199,10 @@ ir_tarval *tarval_ornot(ir_tarval const *const a, ir_tarval const *const b)
 		return a == tarval_b_true || b == tarval_b_false ? tarval_b_true
 		                                                 : tarval_b_false;
 	assert(get_mode_arithmetic(mode) == irma_twos_complement);
+	if (is_small_int_mode(mode))
+		return get_small_int_tarval(get_small_value(a) | ~get_small_value(b),
+		                            mode);
+
 	sc_word *const buffer = ALLOCAN(sc_word, sc_value_length);
 	sc_ornot(a->value, b->value, buffer);
 	return get_int_tarval(buffer, mode);
@@ -963,6 +1216,10 @@ ir_tarval *tarval_eor(ir_tarval const *const a, ir_tarval const *const b)
 		return a == b ? tarval_b_false : tarval_b_true;
 
 	assert(get_mode_arithmetic(mode) == irma_twos_complement);
+	if (is_small_int_mode(mode))
+		return get_small_int_tarval(get_small_value(a) ^ get_small_value(b),
+		                            mode);
+
 	sc_word *const buffer = ALLOCAN(sc_word, sc_value_length);
 	sc_xor(a->value, b->value, buffer);
 	return get_int_tarval(buffer, mode);
@@ -974,6 +1231,10 @@ ir_tarval *tarval_shl(ir_tarval const *const a, ir_tarval const *const b)
 	assert(get_mode_arithmetic(a_mode) == irma_twos_complement);
 	assert(get_mode_arithmetic(b->mode) == irma_twos_complement);
 
+	unsigned count;
+	if (get_small_shift_count(a, b, &count))
+		return small_shl(a, count);
+
 	sc_word *temp_val;
 	if (get_mode_modulo_shift(a_mode) != 0) {
 		temp_val = ALLOCAN(sc_word, sc_value_length);
@@ -997,6 +1258,8 @@ ir_tarval *tarval_shl_unsigned(ir_tarval const *const a, unsigned b)
 	unsigned const modulo = get_mode_modulo_shift(mode);
 	if (modulo != 0)
 		b %= modulo;
+	if (is_small_int_mode(mode))
+		return small_shl(a, b);
 	assert((unsigned)(long)b==b);
 
 	sc_word *const buffer = ALLOCAN(sc_word, sc_value_length);
@@ -1010,6 +1273,10 @@ ir_tarval *tarval_shr(ir_tarval const *const a, ir_tarval const *const b)
 	assert(get_mode_arithmetic(a_mode) == irma_twos_complement);
 	assert(get_mode_arithmetic(b->mode) == irma_twos_complement);
 
+	unsigned count;
+	if (get_small_shift_count(a, b, &count))
+		return small_shr(a, count);
+
 	sc_word *temp_val;
 	if (get_mode_modulo_shift(a_mode) != 0) {
 		temp_val = ALLOCAN(sc_word, sc_value_length);
@@ -1022,7 +1289,7 @@ ir_tarval *tarval_shr(ir_tarval const *const a, ir_tarval const *const b)
 
 	sc_word *const temp = ALLOCAN(sc_word, sc_value_length);
 	/* workaround for unnecessary internal higher precision */
-	memcpy(temp, a->value, sc_value_length);
+	memcpy(temp, a->value, sc_value_length * sizeof(sc_word));
 	sc_zero_extend(temp, get_mode_size_bits(a_mode));
 	sc_shr(temp, temp_val, temp);
 	return get_int_tarval(temp, a_mode);
@@ -1036,11 +1303,13 @@ ir_tarval *tarval_shr_unsigned(ir_tarval const *const a, unsigned b)
 	unsigned const modulo = get_mode_modulo_shift(mode);
 	if (modulo != 0)
 		b %= modulo;
+	if (is_small_int_mode(mode))
+		return small_shr(a, b);
 	assert((unsigned)(long)b==b);
 
 	sc_word *const temp = ALLOCAN(sc_word, sc_value_length);
 	/* workaround for unnecessary internal higher precision */
-	memcpy(temp, a->value, sc_value_length);
+	memcpy(temp, a->value, sc_value_length * sizeof(sc_word));
 	sc_zero_extend(temp, get_mode_size_bits(a->mode));
 	sc_shrI(temp, (long)b, temp);
 	return get_int_tarval(temp, mode);
@@ -1052,6 +1321,10 @@ ir_tarval *tarval_shrs(ir_tarval const *const a, ir_tarval const *const b)
 	assert(get_mode_arithmetic(a_mode) == irma_twos_complement);
 	assert(get_mode_arithmetic(b->mode) == irma_twos_complement);
 
+	unsigned count;
+	if (get_small_shift_count(a, b, &count))
+		return small_shrs(a, count);
+
 	sc_word *temp_val;
 	if (get_mode_modulo_shift(a_mode) != 0) {
 		temp_val = ALLOCAN(sc_word, sc_value_length);
@@ -1075,6 +1348,8 @@ ir_tarval *tarval_shrs_unsigned(ir_tarval const *const a, unsigned b)
 	unsigned const modulo = get_mode_modulo_shift(mode);
 	if (modulo != 0)
 		b %= modulo;
+	if (is_small_int_mode(mode))
+		return small_shrs(a, b);
 	assert((unsigned)(long)b==b);
 
 	sc_word *const temp = ALLOCAN(sc_word, sc_value_length);
@@ -1148,6 +1423,7 @@ const char *ir_tarval_to_ascii(char *buf, size_t len, ir_tarval const *tv)
 		return buf;
 	}
 	case irms_data:
+	case irms_vector:
 	case irms_auxiliary:
 		if (tv == tarval_bad)
 			return "bad";
@@ -1178,6 +1454,7 @@ ir_tarval *ir_tarval_from_ascii(const char *buf, ir_mode *mode)
 		return get_fp_tarval(buffer, mode);
 	}
 	case irms_data:
+	case irms_vector:
 	case irms_auxiliary:
 		if (streq(buf, "bad"))
 			return tarval_bad;
@@ -1241,13 +1518,13 @@ unsigned get_tarval_magnitude(ir_tarval const *tv)
 	assert(get_mode_arithmetic(tv->mode) == irma_twos_complement);
 	unsigned const size = get_mode_size_bits(tv->mode);
 	unsigned const neg  = tarval_get_bit(tv, size - 1);
-	unsigned const ext  = neg ? (1U << SC_BITS) - 1 : 0;
+	unsigned const ext  = neg ? UCHAR_MAX : 0;
 
 	unsigned l = get_mode_size_bytes(tv->mode);
 	for (unsigned i = l; i-- != 0;) {
 		unsigned char const v = get_tarval_sub_bits(tv, i);
 		if (v != ext)
-			return i * SC_BITS + (32 - nlz(v ^ ext)) + 1;
+			return i * CHAR_BIT + (32 - nlz(v ^ ext)) + 1;
 	}
 
 	return 1;
@@ -1319,9 +1596,10 @@ int tarval_get_wrap_on_overflow(void)
 
 static ir_tarval *make_b_tarval(unsigned char const val)
 {
-	ir_tarval *const tv = XMALLOCFZ(ir_tarval, value, sc_value_length);
+	unsigned   const size = sc_value_length * sizeof(sc_word);
+	ir_tarval *const tv   = XMALLOCFZ(ir_tarval, value, sc_value_length);
 	tv->kind     = k_tarval;
-	tv->length   = sc_value_length;
+	tv->length   = size;
 	tv->value[0] = val;
 	/* mode will be set later */
 	return tv;
@@ -1360,6 +1638,7 @@ void finish_tarval(void)
 {
 	finish_strcalc();
 	del_set(tarvals); tarvals = NULL;
+	memset(small_cache, 0, sizeof(small_cache));
 }
 
 bool tarval_in_range(ir_tarval const *const min, ir_tarval const *const val, ir_tarval const *const max)
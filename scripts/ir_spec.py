@@ -916,6 +916,16 @@ class Size(TypeConst):
     """A symbolic constant that represents the size of a type"""
 
 
+@op
+class Splat(Node):
+    """Replicates its operand into all elements of a value of the vector
+    mode of the node."""
+    flags = []
+    ins = [
+        ("op", "operand")
+    ]
+
+
 @op
 class Sync(Node):
     """The Sync operation unifies several partial memory blocks. These blocks
@@ -0,0 +1,164 @@
+/* mkdtemp() and the directory functions are not part of C99 */
+#define _POSIX_C_SOURCE 200809L
+#include "firm.h"
+#include "jit.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) && defined(__linux__)
+#include <dirent.h>
+#include <unistd.h>
+
+/** Upper bound for the size of the cache entry of the test function. */
+#define MAX_ENTRY_SIZE 512
+
+/** Creates int32_t name(int32_t x) { return x * 3 + 1; } */
+static ir_graph *new_func(char const *const name)
+{
+	ir_type *const t_int = new_type_primitive(mode_Is);
+	ir_type *const mtp   = new_type_method(1, 1, false, cc_cdecl_set,
+	                                       mtp_no_property);
+	set_method_param_type(mtp, 0, t_int);
+	set_method_res_type(mtp, 0, t_int);
+	ir_entity *const entity
+		= new_global_entity(get_glob_type(), new_id_from_str(name), mtp,
+		                    ir_visibility_external, IR_LINKAGE_DEFAULT);
+	ir_graph *const irg = new_ir_graph(entity, 0);
+	set_current_ir_graph(irg);
+	ir_node *const x   = new_Proj(get_irg_args(irg), mode_Is, 0);
+	ir_node *const mul = new_Mul(x, new_Const_long(mode_Is, 3));
+	ir_node *const res[] = { new_Add(mul, new_Const_long(mode_Is, 1)) };
+	ir_node *const ret   = new_Return(get_store(), 1, res);
+	add_immBlock_pred(get_irg_end_block(irg), ret);
+	mature_immBlock(get_irg_end_block(irg));
+	irg_finalize_cons(irg);
+	return irg;
+}
+
+/**
+ * Compiles @p irg and checks the result. A cache hit skips code generation,
+ * so it leaves the graph alone.
+ */
+static void compile(ir_jit_segment_t *const segment, ir_graph *const irg,
+                    bool const expect_hit)
+{
+	unsigned           const last_idx = get_irg_last_idx(irg);
+	ir_jit_function_t *const function = be_jit_compile(segment, irg);
+	assert(function != NULL);
+	bool const hit = get_irg_last_idx(irg) == last_idx;
+	assert(hit == expect_hit);
+	(void)hit;
+	(void)expect_hit;
+	int32_t (*const f)(int32_t)
+		= (int32_t(*)(int32_t))be_jit_emit_executable(function);
+	assert(f(5) == 16);
+	assert(f(-7) == -20);
+	(void)f;
+}
+
+/** Returns the path of the only cache entry in @p dir. */
+static void get_entry_path(char const *const dir, char *const path,
+                           size_t const size)
+{
+	DIR *const d = opendir(dir);
+	assert(d != NULL);
+	unsigned n = 0;
+	for (struct dirent *e; (e = readdir(d)) != NULL;) {
+		if (e->d_name[0] == '.')
+			continue;
+		snprintf(path, size, "%s/%s", dir, e->d_name);
+		++n;
+	}
+	closedir(d);
+	assert(n == 1);
+	(void)n;
+}
+
+static size_t read_file(char const *const path, char *const buffer,
+                        size_t const size)
+{
+	FILE *const f = fopen(path, "rb");
+	assert(f != NULL);
+	size_t const res = fread(buffer, 1, size, f);
+	assert(res < size);
+	fclose(f);
+	return res;
+}
+
+static void write_file(char const *const path, char const *const data,
+                       size_t const size)
+{
+	FILE *const f = fopen(path, "wb");
+	assert(f != NULL);
+	size_t const res = fwrite(data, 1, size, f);
+	assert(res == size);
+	(void)res;
+	fclose(f);
+}
+#endif
+
+int main(void)
+{
+#if defined(__x86_64__) && defined(__linux__)
+	ir_init();
+	if (!ir_target_set("x86_64-linux-gnu"))
+		return 1;
+	ir_target_init();
+
+	/* identical graphs have the same fingerprint, each one is compiled once
+	 * at most */
+	ir_graph *irgs[MAX_ENTRY_SIZE + 3];
+	size_t    n_irgs = sizeof(irgs) / sizeof(*irgs);
+	for (size_t i = 0; i < n_irgs; ++i) {
+		char name[32];
+		snprintf(name, sizeof(name), "f%u", (unsigned)i);
+		irgs[i] = new_func(name);
+	}
+	be_lower_for_target();
+
+	char dir[] = "/tmp/firm_jit_cache_XXXXXX";
+	if (mkdtemp(dir) == NULL)
+		return 1;
+	ir_jit_segment_t *const segment = be_new_jit_segment();
+	be_jit_set_cache_dir(segment, dir);
+
+	size_t next = 0;
+	compile(segment, irgs[next++], false);
+	compile(segment, irgs[next++], true);
+
+	char path[256];
+	get_entry_path(dir, path, sizeof(path));
+	char         data[MAX_ENTRY_SIZE + 1];
+	size_t const size = read_file(path, data, sizeof(data));
+
+	/* a truncated entry is compiled again and replaced */
+	write_file(path, data, size / 2);
+	compile(segment, irgs[next++], false);
+	char         rewritten[MAX_ENTRY_SIZE + 1];
+	size_t const rewritten_size = read_file(path, rewritten, sizeof(rewritten));
+	assert(rewritten_size == size);
+	assert(memcmp(rewritten, data, size) == 0);
+	(void)rewritten_size;
+
+	/* so is an entry with any damaged byte */
+	for (size_t i = 0; i < size; ++i) {
+		data[i] ^= 0x10;
+		write_file(path, data, size);
+		data[i] ^= 0x10;
+		assert(next < n_irgs);
+		compile(segment, irgs[next++], false);
+	}
+	compile(segment, irgs[next++], true);
+
+	be_destroy_jit_segment(segment);
+	remove(path);
+	rmdir(dir);
+
+	ir_finish();
+#endif
+	return 0;
+}
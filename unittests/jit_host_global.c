@@ -0,0 +1,67 @@
+#include "firm.h"
+#include "jit.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Far away from the executable memory of the jit, so neither 32bit absolute
+ * nor instruction pointer relative displacements reach it. */
+static int64_t host_global = 20;
+
+int main(void)
+{
+#if defined(__x86_64__) && defined(__linux__)
+	ir_init();
+	if (!ir_target_set("x86_64-linux-gnu"))
+		return 1;
+	ir_target_init();
+
+	/* int64_t f(void) { int64_t v = host_global; host_global = v + 5;
+	 *                   return v * 2; } */
+	ir_type   *const t_long = new_type_primitive(mode_Ls);
+	ir_type   *const glob   = get_glob_type();
+	ir_entity *const global
+		= new_global_entity(glob, new_id_from_str("host_global"), t_long,
+		                    ir_visibility_external, IR_LINKAGE_DEFAULT);
+	ir_type *const mtp = new_type_method(0, 1, false, cc_cdecl_set,
+	                                     mtp_no_property);
+	set_method_res_type(mtp, 0, t_long);
+	ir_entity *const func
+		= new_global_entity(glob, new_id_from_str("f"), mtp,
+		                    ir_visibility_external, IR_LINKAGE_DEFAULT);
+
+	ir_graph *const irg = new_ir_graph(func, 0);
+	set_current_ir_graph(irg);
+	ir_node *const addr = new_Address(global);
+	ir_node *const load = new_Load(get_store(), addr, mode_Ls, t_long,
+	                               cons_none);
+	set_store(new_Proj(load, mode_M, pn_Load_M));
+	ir_node *const val = new_Proj(load, mode_Ls, pn_Load_res);
+	ir_node *const sum = new_Add(val, new_Const_long(mode_Ls, 5));
+	ir_node *const store = new_Store(get_store(), addr, sum, t_long,
+	                                 cons_none);
+	set_store(new_Proj(store, mode_M, pn_Store_M));
+	ir_node *const res[] = { new_Mul(val, new_Const_long(mode_Ls, 2)) };
+	ir_node *const ret   = new_Return(get_store(), 1, res);
+	add_immBlock_pred(get_irg_end_block(irg), ret);
+	mature_immBlock(get_irg_end_block(irg));
+	irg_finalize_cons(irg);
+
+	be_lower_for_target();
+	be_jit_set_entity_addr(global, &host_global);
+
+	ir_jit_segment_t  *const segment  = be_new_jit_segment();
+	ir_jit_function_t *const function = be_jit_compile(segment, irg);
+	assert(function != NULL);
+	int64_t (*const f)(void)
+		= (int64_t(*)(void))be_jit_emit_executable(function);
+	int64_t const result = f();
+	assert(result == 40);
+	assert(host_global == 25);
+	(void)result;
+	be_destroy_jit_segment(segment);
+
+	ir_finish();
+#endif
+	return 0;
+}
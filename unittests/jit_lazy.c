@@ -0,0 +1,160 @@
+#include "firm.h"
+#include "jit.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#if defined(__x86_64__) && defined(__linux__)
+/** All integer and all xmm argument registers are used. */
+#define N_INT_PARAMS 6
+#define N_FP_PARAMS  8
+
+/** Creates a method type with @p n_params parameters and a result of @p mode. */
+static ir_type *new_func_type(ir_mode *const mode, size_t const n_params)
+{
+	ir_type *const type = new_type_primitive(mode);
+	ir_type *const mtp  = new_type_method(n_params, 1, false, cc_cdecl_set,
+	                                      mtp_no_property);
+	for (size_t i = 0; i < n_params; ++i)
+		set_method_param_type(mtp, i, type);
+	set_method_res_type(mtp, 0, type);
+	return mtp;
+}
+
+static ir_graph *new_func(char const *const name, ir_type *const mtp)
+{
+	ir_entity *const entity
+		= new_global_entity(get_glob_type(), new_id_from_str(name), mtp,
+		                    ir_visibility_external, IR_LINKAGE_DEFAULT);
+	ir_graph *const irg = new_ir_graph(entity, 0);
+	set_current_ir_graph(irg);
+	return irg;
+}
+
+static void finish_func(ir_graph *const irg, ir_node *const value)
+{
+	ir_node *const res[] = { value };
+	ir_node *const ret   = new_Return(get_store(), 1, res);
+	add_immBlock_pred(get_irg_end_block(irg), ret);
+	mature_immBlock(get_irg_end_block(irg));
+	irg_finalize_cons(irg);
+}
+
+/**
+ * Creates name(x0, ..., xn) { return x0 + 10 * x1 + ... + 10^n * xn; }, so
+ * every mixed up argument changes the result.
+ */
+static ir_graph *new_weighted_sum(char const *const name, ir_mode *const mode,
+                                  size_t const n_params)
+{
+	ir_graph *const irg  = new_func(name, new_func_type(mode, n_params));
+	ir_node  *const args = get_irg_args(irg);
+	ir_node  *sum        = new_Proj(args, mode, 0);
+	double    weight     = 1;
+	for (size_t i = 1; i < n_params; ++i) {
+		weight *= 10;
+		ir_tarval *const tv = mode_is_float(mode)
+			? new_tarval_from_double(weight, mode)
+			: new_tarval_from_long((long)weight, mode);
+		ir_node *const term = new_Mul(new_Proj(args, mode, i), new_Const(tv));
+		sum = new_Add(sum, term);
+	}
+	finish_func(irg, sum);
+	return irg;
+}
+
+/** Creates name(x0, ..., xn) { return callee(x0, ..., xn); } */
+static ir_graph *new_caller(char const *const name, ir_graph *const callee,
+                            ir_mode *const mode, size_t const n_params)
+{
+	ir_entity *const callee_entity = get_irg_entity(callee);
+	ir_type   *const mtp           = get_entity_type(callee_entity);
+	ir_graph  *const irg           = new_func(name, mtp);
+	ir_node   *const args          = get_irg_args(irg);
+	ir_node   *in[N_FP_PARAMS];
+	for (size_t i = 0; i < n_params; ++i)
+		in[i] = new_Proj(args, mode, i);
+	ir_node *const call = new_Call(get_store(), new_Address(callee_entity),
+	                               n_params, in, mtp);
+	set_store(new_Proj(call, mode_M, pn_Call_M));
+	ir_node *const results = new_Proj(call, mode_T, pn_Call_T_result);
+	finish_func(irg, new_Proj(results, mode, 0));
+	return irg;
+}
+
+static void *compile(ir_jit_segment_t *const segment, ir_graph *const irg)
+{
+	ir_jit_function_t *const function = be_jit_compile(segment, irg);
+	assert(function != NULL);
+	return be_jit_emit_executable(function);
+}
+
+typedef int64_t (*int_func_t)(int64_t, int64_t, int64_t, int64_t, int64_t,
+                              int64_t);
+typedef double (*fp_func_t)(double, double, double, double, double, double,
+                            double, double);
+#endif
+
+int main(void)
+{
+#if defined(__x86_64__) && defined(__linux__)
+	ir_init();
+	if (!ir_target_set("x86_64-linux-gnu"))
+		return 1;
+	ir_target_init();
+
+	ir_graph *const lazy_int = new_weighted_sum("lazy_int", mode_Ls,
+	                                            N_INT_PARAMS);
+	ir_graph *const lazy_fp  = new_weighted_sum("lazy_fp", mode_D,
+	                                            N_FP_PARAMS);
+	ir_graph *const call_int = new_caller("call_int", lazy_int, mode_Ls,
+	                                      N_INT_PARAMS);
+	ir_graph *const call_fp  = new_caller("call_fp", lazy_fp, mode_D,
+	                                      N_FP_PARAMS);
+	be_lower_for_target();
+
+	ir_jit_segment_t *const segment = be_new_jit_segment();
+	if (!be_jit_set_lazy(segment, true))
+		return 1;
+	int_func_t const f_int = (int_func_t)compile(segment, call_int);
+	fp_func_t  const f_fp  = (fp_func_t)compile(segment, call_fp);
+
+	/* the callees are only compiled by the first call through their stub */
+	ir_entity  *const int_entity = get_irg_entity(lazy_int);
+	ir_entity  *const fp_entity  = get_irg_entity(lazy_fp);
+	void const *const int_stub   = be_jit_get_entity_addr(int_entity);
+	void const *const fp_stub    = be_jit_get_entity_addr(fp_entity);
+	unsigned    const int_idx    = get_irg_last_idx(lazy_int);
+	unsigned    const fp_idx     = get_irg_last_idx(lazy_fp);
+	assert(int_stub != (void const*)-1);
+	assert(fp_stub != (void const*)-1);
+
+	assert(f_int(1, 2, 3, 4, 5, 6) == 654321);
+	assert(f_fp(1, 2, 3, 4, 5, 6, 7, 8) == 87654321.0);
+	unsigned const int_compiled_idx = get_irg_last_idx(lazy_int);
+	unsigned const fp_compiled_idx  = get_irg_last_idx(lazy_fp);
+	assert(int_compiled_idx != int_idx);
+	assert(fp_compiled_idx != fp_idx);
+
+	/* later calls jump to the code directly, the resolver does not compile
+	 * the graphs again */
+	assert(f_int(6, 5, 4, 3, 2, 1) == 123456);
+	assert(f_fp(8, 7, 6, 5, 4, 3, 2, 1) == 12345678.0);
+	assert(get_irg_last_idx(lazy_int) == int_compiled_idx);
+	assert(get_irg_last_idx(lazy_fp) == fp_compiled_idx);
+	assert(be_jit_get_entity_addr(int_entity) == int_stub);
+	assert(be_jit_get_entity_addr(fp_entity) == fp_stub);
+	(void)f_int;
+	(void)f_fp;
+	(void)int_stub;
+	(void)fp_stub;
+	(void)int_idx;
+	(void)fp_idx;
+	(void)int_compiled_idx;
+	(void)fp_compiled_idx;
+
+	be_destroy_jit_segment(segment);
+	ir_finish();
+#endif
+	return 0;
+}
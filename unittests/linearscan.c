@@ -0,0 +1,165 @@
+/* fork() and pipe() are not part of C99 */
+#define _POSIX_C_SOURCE 200809L
+#include "firm.h"
+#include "jit.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#if defined(__x86_64__) && defined(__linux__)
+#include <sys/wait.h>
+#include <unistd.h>
+
+/** More loop carried values than there are registers. */
+#define N_VALUES  24
+#define N_ROTATED 4
+#define N_INPUTS 16
+
+typedef int64_t (*func_t)(int64_t n, int64_t x);
+
+/**
+ * Creates int64_t loop(int64_t n, int64_t x), which updates N_VALUES values
+ * n times. The variable shifts need %cl, so there are register constraints
+ * within the high register pressure, too.
+ */
+static ir_graph *new_loop(void)
+{
+	ir_type *const t_long = new_type_primitive(mode_Ls);
+	ir_type *const mtp    = new_type_method(2, 1, false, cc_cdecl_set,
+	                                        mtp_no_property);
+	set_method_param_type(mtp, 0, t_long);
+	set_method_param_type(mtp, 1, t_long);
+	set_method_res_type(mtp, 0, t_long);
+	ir_entity *const entity
+		= new_global_entity(get_glob_type(), new_id_from_str("loop"), mtp,
+		                    ir_visibility_external, IR_LINKAGE_DEFAULT);
+	unsigned  const counter = N_VALUES;
+	ir_graph *const irg     = new_ir_graph(entity, N_VALUES + 1);
+	set_current_ir_graph(irg);
+
+	ir_node *const args = get_irg_args(irg);
+	ir_node *const n    = new_Proj(args, mode_Ls, 0);
+	ir_node *const x    = new_Proj(args, mode_Ls, 1);
+	for (unsigned i = 0; i < N_VALUES; ++i)
+		set_value(i, new_Add(x, new_Const_long(mode_Ls, i * 7 + 1)));
+	set_value(counter, new_Const_long(mode_Ls, 0));
+
+	ir_node *const header = new_immBlock();
+	add_immBlock_pred(header, new_Jmp());
+	set_cur_block(header);
+	ir_node *const cmp  = new_Cmp(get_value(counter, mode_Ls), n,
+	                              ir_relation_less);
+	ir_node *const cond = new_Cond(cmp);
+
+	ir_node *const body = new_immBlock();
+	add_immBlock_pred(body, new_Proj(cond, mode_X, pn_Cond_true));
+	mature_immBlock(body);
+	set_cur_block(body);
+	ir_node *const i      = get_value(counter, mode_Ls);
+	ir_node *const amount = new_Conv(new_And(i, new_Const_long(mode_Ls, 7)),
+	                                 mode_Iu);
+	ir_node *values[N_VALUES];
+	for (unsigned v = 0; v < N_VALUES; ++v)
+		values[v] = get_value(v, mode_Ls);
+	/* the first values are rotated, so their phis need a permutation */
+	for (unsigned v = 0; v < N_ROTATED; ++v)
+		set_value(v, values[(v + 1) % N_ROTATED]);
+	for (unsigned v = N_ROTATED; v < N_VALUES; ++v) {
+		ir_node *const next  = values[(v + 1) % N_VALUES];
+		ir_node *const mul   = new_Mul(values[v], values[v % N_ROTATED]);
+		ir_node *const mixed = v % 2 == 0 ? new_Eor(mul, next)
+		                                  : new_Sub(mul, new_Shl(next, amount));
+		set_value(v, new_Add(mixed, i));
+	}
+	set_value(counter, new_Add(i, new_Const_long(mode_Ls, 1)));
+	add_immBlock_pred(header, new_Jmp());
+	mature_immBlock(header);
+
+	ir_node *const exit = new_immBlock();
+	add_immBlock_pred(exit, new_Proj(cond, mode_X, pn_Cond_false));
+	mature_immBlock(exit);
+	set_cur_block(exit);
+	ir_node *res = get_value(0, mode_Ls);
+	for (unsigned v = 1; v < N_VALUES; ++v) {
+		ir_node *const weighted = new_Mul(get_value(v, mode_Ls),
+		                                  new_Const_long(mode_Ls, v + 1));
+		res = new_Eor(res, weighted);
+	}
+	ir_node *const results[] = { res };
+	ir_node *const ret       = new_Return(get_store(), 1, results);
+	add_immBlock_pred(get_irg_end_block(irg), ret);
+	mature_immBlock(get_irg_end_block(irg));
+	irg_finalize_cons(irg);
+	return irg;
+}
+
+/** Compiles the loop with register allocator @p regalloc and runs it. */
+static bool run(char const *const regalloc, int64_t *const results)
+{
+	ir_init();
+	if (!ir_target_set("x86_64-linux-gnu"))
+		return false;
+	char option[64];
+	snprintf(option, sizeof(option), "regalloc=%s", regalloc);
+	if (!ir_target_option(option) || !ir_target_option("verify=1"))
+		return false;
+	ir_target_init();
+
+	ir_graph *const irg = new_loop();
+	be_lower_for_target();
+	ir_jit_segment_t  *const segment  = be_new_jit_segment();
+	ir_jit_function_t *const function = be_jit_compile(segment, irg);
+	if (function == NULL)
+		return false;
+	func_t const f = (func_t)be_jit_emit_executable(function);
+	for (int64_t i = 0; i < N_INPUTS; ++i)
+		results[i] = f(i * 3, i * 1000003 - 42);
+	be_destroy_jit_segment(segment);
+	ir_finish();
+	return true;
+}
+#endif
+
+int main(void)
+{
+#if defined(__x86_64__) && defined(__linux__)
+	/* the register allocator is fixed once the target is initialized, so the
+	 * reference is computed with chordal in a child process */
+	int pipe_fds[2];
+	if (pipe(pipe_fds) != 0)
+		return 1;
+	fflush(NULL);
+	pid_t const child = fork();
+	if (child < 0)
+		return 1;
+	if (child == 0) {
+		close(pipe_fds[0]);
+		int64_t results[N_INPUTS];
+		if (!run("chordal", results))
+			_exit(1);
+		ssize_t const size = write(pipe_fds[1], results, sizeof(results));
+		_exit(size == (ssize_t)sizeof(results) ? 0 : 1);
+	}
+	close(pipe_fds[1]);
+	int64_t reference[N_INPUTS];
+	char   *buffer = (char*)reference;
+	size_t  size   = 0;
+	for (ssize_t res; size < sizeof(reference)
+	     && (res = read(pipe_fds[0], buffer + size, sizeof(reference) - size)) > 0;)
+		size += (size_t)res;
+	close(pipe_fds[0]);
+	int status;
+	if (waitpid(child, &status, 0) != child || !WIFEXITED(status)
+	 || WEXITSTATUS(status) != 0 || size != sizeof(reference))
+		return 1;
+
+	int64_t results[N_INPUTS];
+	if (!run("linearscan", results))
+		return 1;
+	for (unsigned i = 0; i < N_INPUTS; ++i)
+		assert(results[i] == reference[i]);
+	(void)results;
+#endif
+	return 0;
+}
@@ -0,0 +1,273 @@
+#include "firm.h"
+#include "jit.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#if defined(__x86_64__) && defined(__linux__)
+/** Enough elements for several vector iterations and a remainder. */
+#define MAX_N 19
+
+/** The local variables of the loops. */
+enum { VAR_I, VAR_S, N_VARS };
+
+static ir_type *t_int;
+static ir_type *t_ptr;
+
+static ir_graph *new_func(char const *const name, ir_type *const mtp)
+{
+	ir_entity *const entity
+		= new_global_entity(get_glob_type(), new_id_from_str(name), mtp,
+		                    ir_visibility_external, IR_LINKAGE_DEFAULT);
+	ir_graph *const irg = new_ir_graph(entity, N_VARS);
+	set_current_ir_graph(irg);
+	return irg;
+}
+
+/** Returns the address of element i of @p array. */
+static ir_node *new_element_addr(ir_node *const array, ir_node *const i)
+{
+	ir_mode *const offset_mode = get_reference_offset_mode(mode_P);
+	ir_node *const index       = new_Conv(i, offset_mode);
+	ir_node *const size        = new_Const_long(offset_mode, sizeof(int32_t));
+	return new_Add(array, new_Mul(index, size));
+}
+
+static ir_node *load_element(ir_node *const array, ir_node *const i)
+{
+	ir_node *const load = new_Load(get_store(), new_element_addr(array, i),
+	                               mode_Is, t_int, cons_none);
+	set_store(new_Proj(load, mode_M, pn_Load_M));
+	return new_Proj(load, mode_Is, pn_Load_res);
+}
+
+/**
+ * Builds for (i = 0; i < n; ++i) { body(i) } in the current graph, the
+ * current block is the exit of the loop afterwards.
+ */
+static void build_loop(ir_node *const n, void (*const body)(ir_node *i,
+                                                            void *data),
+                       void *const data)
+{
+	set_value(VAR_I, new_Const_long(mode_Is, 0));
+	ir_node *const header = new_immBlock();
+	add_immBlock_pred(header, new_Jmp());
+	set_cur_block(header);
+	ir_node *const cmp  = new_Cmp(get_value(VAR_I, mode_Is), n,
+	                              ir_relation_less);
+	ir_node *const cond = new_Cond(cmp);
+
+	ir_node *const loop = new_immBlock();
+	add_immBlock_pred(loop, new_Proj(cond, mode_X, pn_Cond_true));
+	mature_immBlock(loop);
+	set_cur_block(loop);
+	ir_node *const i = get_value(VAR_I, mode_Is);
+	body(i, data);
+	set_value(VAR_I, new_Add(i, new_Const_long(mode_Is, 1)));
+	add_immBlock_pred(header, new_Jmp());
+	mature_immBlock(header);
+
+	ir_node *const exit = new_immBlock();
+	add_immBlock_pred(exit, new_Proj(cond, mode_X, pn_Cond_false));
+	mature_immBlock(exit);
+	set_cur_block(exit);
+}
+
+static void finish_func(ir_graph *const irg, int const n_res,
+                        ir_node *const *const res)
+{
+	ir_node *const ret = new_Return(get_store(), n_res, res);
+	add_immBlock_pred(get_irg_end_block(irg), ret);
+	mature_immBlock(get_irg_end_block(irg));
+	irg_finalize_cons(irg);
+}
+
+static void build_add_body(ir_node *const i, void *const data)
+{
+	ir_node *const *const args = (ir_node *const*)data;
+	ir_node *const sum   = new_Add(load_element(args[1], i),
+	                               load_element(args[2], i));
+	ir_node *const store = new_Store(get_store(), new_element_addr(args[0], i),
+	                                 sum, t_int, cons_none);
+	set_store(new_Proj(store, mode_M, pn_Store_M));
+}
+
+/**
+ * Creates void add(int32_t *dst, int32_t const *a, int32_t const *b,
+ * int32_t n) { dst[i] = a[i] + b[i]; }. The arrays may overlap, so the
+ * vector loop is guarded by a check at runtime.
+ */
+static ir_graph *new_add(void)
+{
+	ir_type *const mtp = new_type_method(4, 0, false, cc_cdecl_set,
+	                                     mtp_no_property);
+	for (size_t p = 0; p < 3; ++p)
+		set_method_param_type(mtp, p, t_ptr);
+	set_method_param_type(mtp, 3, t_int);
+	ir_graph *const irg    = new_func("add", mtp);
+	ir_node  *const params = get_irg_args(irg);
+	ir_node  *const args[] = {
+		new_Proj(params, mode_P, 0),
+		new_Proj(params, mode_P, 1),
+		new_Proj(params, mode_P, 2),
+	};
+	build_loop(new_Proj(params, mode_Is, 3), build_add_body, (void*)args);
+	finish_func(irg, 0, NULL);
+	return irg;
+}
+
+typedef struct reduce_env_t {
+	ir_node *array;
+	bool     sub;
+} reduce_env_t;
+
+static void build_reduce_body(ir_node *const i, void *const data)
+{
+	reduce_env_t const *const env = (reduce_env_t const*)data;
+	ir_node *const s       = get_value(VAR_S, mode_Is);
+	ir_node *const element = load_element(env->array, i);
+	set_value(VAR_S, env->sub ? new_Sub(s, element) : new_Add(s, element));
+}
+
+/**
+ * Creates int32_t name(int32_t const *a, int32_t n, int32_t s)
+ * { s += a[i] or s -= a[i]; return s; }, which needs a horizontal reduction
+ * after the vector loop.
+ */
+static ir_graph *new_reduce(char const *const name, bool const sub)
+{
+	ir_type *const mtp = new_type_method(3, 1, false, cc_cdecl_set,
+	                                     mtp_no_property);
+	set_method_param_type(mtp, 0, t_ptr);
+	set_method_param_type(mtp, 1, t_int);
+	set_method_param_type(mtp, 2, t_int);
+	set_method_res_type(mtp, 0, t_int);
+	ir_graph *const irg    = new_func(name, mtp);
+	ir_node  *const params = get_irg_args(irg);
+	set_value(VAR_S, new_Proj(params, mode_Is, 2));
+	reduce_env_t env = { new_Proj(params, mode_P, 0), sub };
+	build_loop(new_Proj(params, mode_Is, 1), build_reduce_body, &env);
+	ir_node *const res[] = { get_value(VAR_S, mode_Is) };
+	finish_func(irg, 1, res);
+	return irg;
+}
+
+static void count_vector_node(ir_node *const node, void *const env)
+{
+	unsigned *const counts = (unsigned*)env;
+	ir_mode  *const mode   = is_Store(node) ? get_irn_mode(get_Store_value(node))
+	                                        : get_irn_mode(node);
+	if (!mode_is_vector(mode))
+		return;
+	if (is_Store(node))
+		++counts[0];
+	else if (is_Phi(node))
+		++counts[1];
+}
+
+/** Returns the number of vector Stores and vector Phis of @p irg. */
+static void count_vector_nodes(ir_graph *const irg, unsigned *const counts)
+{
+	counts[0] = 0;
+	counts[1] = 0;
+	irg_walk_graph(irg, NULL, count_vector_node, counts);
+}
+
+static void *compile(ir_jit_segment_t *const segment, ir_graph *const irg)
+{
+	ir_jit_function_t *const function = be_jit_compile(segment, irg);
+	assert(function != NULL);
+	return be_jit_emit_executable(function);
+}
+
+typedef void (*add_func_t)(int32_t*, int32_t const*, int32_t const*, int32_t);
+typedef int32_t (*reduce_func_t)(int32_t const*, int32_t, int32_t);
+
+static void init(int32_t *const array, unsigned const n, int32_t const seed)
+{
+	for (unsigned i = 0; i < n; ++i)
+		array[i] = seed * (int32_t)i - (int32_t)(i * i);
+}
+
+/** Runs add with @p dst and @p a pointing into the same buffer. */
+static void check_add(add_func_t const f, int32_t const n,
+                      int const dst_offset, int const a_offset)
+{
+	int32_t buffer[MAX_N + 8];
+	int32_t expected[MAX_N + 8];
+	int32_t b[MAX_N];
+	init(buffer, MAX_N + 8, 5);
+	init(expected, MAX_N + 8, 5);
+	init(b, MAX_N, -3);
+	for (int32_t i = 0; i < n; ++i)
+		expected[dst_offset + i] = expected[a_offset + i] + b[i];
+	f(buffer + dst_offset, buffer + a_offset, b, n);
+	for (unsigned i = 0; i < MAX_N + 8; ++i)
+		assert(buffer[i] == expected[i]);
+}
+#endif
+
+int main(void)
+{
+#if defined(__x86_64__) && defined(__linux__)
+	ir_init();
+	if (!ir_target_set("x86_64-linux-gnu"))
+		return 1;
+	ir_target_init();
+
+	t_int = new_type_primitive(mode_Is);
+	t_ptr = new_type_pointer(t_int);
+	ir_graph *const add     = new_add();
+	ir_graph *const sum     = new_reduce("sum", false);
+	ir_graph *const sub_sum = new_reduce("sub_sum", true);
+
+	unsigned counts[2];
+	loop_vectorize(add);
+	count_vector_nodes(add, counts);
+	assert(counts[0] == 1);
+	loop_vectorize(sum);
+	count_vector_nodes(sum, counts);
+	assert(counts[1] == 1);
+	loop_vectorize(sub_sum);
+	count_vector_nodes(sub_sum, counts);
+	assert(counts[1] == 1);
+	(void)counts;
+
+	be_lower_for_target();
+	ir_jit_segment_t *const segment = be_new_jit_segment();
+	add_func_t    const f_add     = (add_func_t)compile(segment, add);
+	reduce_func_t const f_sum     = (reduce_func_t)compile(segment, sum);
+	reduce_func_t const f_sub_sum = (reduce_func_t)compile(segment, sub_sum);
+
+	/* trip counts below, at and above the vector length, the runtime check
+	 * has to reject the overlapping arrays */
+	for (int32_t n = -1; n <= MAX_N; ++n) {
+		check_add(f_add, n, 0, 0);
+		check_add(f_add, n, 0, 1);
+		check_add(f_add, n, 1, 0);
+		check_add(f_add, n, 4, 0);
+		check_add(f_add, n, 0, 8);
+	}
+
+	int32_t a[MAX_N];
+	init(a, MAX_N, 7);
+	for (int32_t n = -1; n <= MAX_N; ++n) {
+		int32_t expected = 100;
+		for (int32_t i = 0; i < n; ++i)
+			expected += a[i];
+		assert(f_sum(a, n, 100) == expected);
+		expected = 100;
+		for (int32_t i = 0; i < n; ++i)
+			expected -= a[i];
+		assert(f_sub_sum(a, n, 100) == expected);
+		(void)expected;
+	}
+	(void)f_add;
+	(void)f_sum;
+	(void)f_sub_sum;
+
+	be_destroy_jit_segment(segment);
+	ir_finish();
+#endif
+	return 0;
+}
@@ -0,0 +1,169 @@
+#include "firm.h"
+#include "jit.h"
+#include "util.h"
+#include <assert.h>
+#include <stdint.h>
+
+#if defined(__x86_64__) && defined(__linux__)
+/** A case of the switch, min and max are inclusive. */
+typedef struct switch_case_t {
+	int32_t  min;
+	int32_t  max;
+	unsigned pn;
+} switch_case_t;
+
+/**
+ * The cases are too sparse for a single jump table. They form a signed range
+ * case, a bit test cluster with two targets in [0, 8], a jump table cluster
+ * in [100, 109] and single cases.
+ */
+static const switch_case_t cases[] = {
+	{ -1000000, -1000000, 1 },
+	{     -100,      -90, 2 },
+	{        0,        0, 3 },
+	{        1,        1, 4 },
+	{        2,        2, 3 },
+	{        3,        3, 4 },
+	{        4,        4, 3 },
+	{        5,        5, 4 },
+	{        6,        6, 3 },
+	{        7,        7, 4 },
+	{        8,        8, 3 },
+	{      100,      101, 5 },
+	{      102,      102, 6 },
+	{      103,      103, 7 },
+	{      104,      104, 8 },
+	{      105,      105, 9 },
+	{      107,      107, 5 },
+	{      108,      109, 6 },
+	{     1000,     1000, 10 },
+};
+
+#define N_OUTS 11
+
+typedef int32_t (*func_t)(int32_t);
+
+/** Returns the number of the target of @p x, 0 is the default. */
+static int32_t reference(int32_t const x)
+{
+	for (size_t c = 0; c < ARRAY_SIZE(cases); ++c) {
+		if (cases[c].min <= x && x <= cases[c].max)
+			return (int32_t)cases[c].pn;
+	}
+	return 0;
+}
+
+/**
+ * Creates int32_t name(int32_t x), which returns the number of the switch
+ * target of x.
+ */
+static ir_graph *new_classify(char const *const name)
+{
+	ir_type *const t_int = new_type_primitive(mode_Is);
+	ir_type *const mtp   = new_type_method(1, 1, false, cc_cdecl_set,
+	                                       mtp_no_property);
+	set_method_param_type(mtp, 0, t_int);
+	set_method_res_type(mtp, 0, t_int);
+	ir_entity *const entity
+		= new_global_entity(get_glob_type(), new_id_from_str(name), mtp,
+		                    ir_visibility_external, IR_LINKAGE_DEFAULT);
+	ir_graph *const irg = new_ir_graph(entity, 0);
+	set_current_ir_graph(irg);
+
+	ir_switch_table *const table
+		= ir_new_switch_table(irg, ARRAY_SIZE(cases));
+	for (size_t c = 0; c < ARRAY_SIZE(cases); ++c) {
+		ir_tarval *const min = new_tarval_from_long(cases[c].min, mode_Is);
+		ir_tarval *const max = new_tarval_from_long(cases[c].max, mode_Is);
+		ir_switch_table_set(table, c, min, max, cases[c].pn);
+	}
+	ir_node *const x       = new_Proj(get_irg_args(irg), mode_Is, 0);
+	ir_node *const switchn = new_Switch(x, N_OUTS, table);
+
+	ir_node *const end_block = get_irg_end_block(irg);
+	for (unsigned pn = 0; pn < N_OUTS; ++pn) {
+		ir_node *const block = new_immBlock();
+		add_immBlock_pred(block, new_Proj(switchn, mode_X, pn));
+		mature_immBlock(block);
+		set_cur_block(block);
+		ir_node *const res[] = { new_Const_long(mode_Is, pn) };
+		add_immBlock_pred(end_block, new_Return(get_store(), 1, res));
+	}
+	mature_immBlock(end_block);
+	irg_finalize_cons(irg);
+	return irg;
+}
+
+static void count_node(ir_node *const node, void *const env)
+{
+	unsigned *const counts = (unsigned*)env;
+	if (is_Switch(node))
+		++counts[0];
+	else if (is_Shl(node))
+		++counts[1];
+}
+
+static void check(func_t const f, int32_t const x)
+{
+	assert(f(x) == reference(x));
+	(void)f;
+	(void)x;
+}
+#endif
+
+int main(void)
+{
+#if defined(__x86_64__) && defined(__linux__)
+	ir_init();
+	if (!ir_target_set("x86_64-linux-gnu"))
+		return 1;
+	ir_target_init();
+
+	/* lower like the amd64 backend, so the jump table cluster remains a
+	 * Switch and the bit test cluster shifts by the selector */
+	ir_graph *const tables = new_classify("classify_tables");
+	lower_switch(tables, 4, 256, mode_Iu);
+	unsigned counts[2] = { 0, 0 };
+	irg_walk_graph(tables, NULL, count_node, counts);
+	assert(counts[0] == 1);
+	assert(counts[1] == 1);
+
+	/* the jit cannot emit jump tables, so the executed variant only has bit
+	 * test clusters and single cases */
+	ir_graph *const irg = new_classify("classify");
+	lower_switch(irg, ARRAY_SIZE(cases), 256, mode_Iu);
+	counts[0] = 0;
+	counts[1] = 0;
+	irg_walk_graph(irg, NULL, count_node, counts);
+	assert(counts[0] == 0);
+	assert(counts[1] == 1);
+	(void)counts;
+
+	be_lower_for_target();
+	ir_jit_segment_t  *const segment  = be_new_jit_segment();
+	ir_jit_function_t *const function = be_jit_compile(segment, irg);
+	if (function == NULL)
+		return 1;
+	func_t const f = (func_t)be_jit_emit_executable(function);
+
+	/* every case boundary and its neighbours, values below a signed range
+	 * must not wrap around into it */
+	for (size_t c = 0; c < ARRAY_SIZE(cases); ++c) {
+		for (int32_t d = -2; d <= 2; ++d) {
+			check(f, cases[c].min + d);
+			check(f, cases[c].max + d);
+		}
+	}
+	for (int32_t x = -200; x <= 1200; ++x)
+		check(f, x);
+	check(f, INT32_MIN);
+	check(f, INT32_MIN + 1);
+	check(f, INT32_MAX);
+	check(f, INT32_MAX - 1);
+	check(f, -1000000 + 2147483647);
+
+	be_destroy_jit_segment(segment);
+	ir_finish();
+#endif
+	return 0;
+}
@@ -0,0 +1,168 @@
+#include "firm.h"
+#include "jit.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define N_LANES 4
+
+static int32_t a[N_LANES];
+static int32_t b[N_LANES];
+
+static ir_entity *a_entity;
+static ir_entity *b_entity;
+
+static ir_entity *new_array(char const *const name)
+{
+	ir_type *const t_int   = new_type_primitive(mode_Is);
+	ir_type *const t_array = new_type_array(t_int, N_LANES);
+	return new_global_entity(get_glob_type(), new_id_from_str(name), t_array,
+	                         ir_visibility_external, IR_LINKAGE_DEFAULT);
+}
+
+static ir_node *new_element_addr(ir_entity *const array, unsigned const i)
+{
+	ir_mode *const offset_mode = get_reference_offset_mode(mode_P);
+	return new_Add(new_Address(array),
+	               new_Const_long(offset_mode, i * sizeof(int32_t)));
+}
+
+static ir_node *load_element(ir_entity *const array, unsigned const i)
+{
+	ir_type *const t_int = new_type_primitive(mode_Is);
+	ir_node *const load  = new_Load(get_store(), new_element_addr(array, i),
+	                                mode_Is, t_int, cons_none);
+	set_store(new_Proj(load, mode_M, pn_Load_M));
+	return new_Proj(load, mode_Is, pn_Load_res);
+}
+
+static void store_element(ir_entity *const array, unsigned const i,
+                          ir_node *const value)
+{
+	ir_type *const t_int = new_type_primitive(mode_Is);
+	ir_node *const store = new_Store(get_store(), new_element_addr(array, i),
+	                                 value, t_int, cons_none);
+	set_store(new_Proj(store, mode_M, pn_Store_M));
+}
+
+/** Creates void name(int32_t k), which is built by @p build. */
+static ir_graph *new_func(char const *const name,
+                          void (*const build)(ir_node *k))
+{
+	ir_type *const t_int = new_type_primitive(mode_Is);
+	ir_type *const mtp   = new_type_method(1, 0, false, cc_cdecl_set,
+	                                       mtp_no_property);
+	set_method_param_type(mtp, 0, t_int);
+	ir_entity *const entity
+		= new_global_entity(get_glob_type(), new_id_from_str(name), mtp,
+		                    ir_visibility_external, IR_LINKAGE_DEFAULT);
+	ir_graph *const irg = new_ir_graph(entity, 0);
+	set_current_ir_graph(irg);
+	build(new_Proj(get_irg_args(irg), mode_Is, 0));
+	ir_node *const ret = new_Return(get_store(), 0, NULL);
+	add_immBlock_pred(get_irg_end_block(irg), ret);
+	mature_immBlock(get_irg_end_block(irg));
+	irg_finalize_cons(irg);
+	return irg;
+}
+
+/* b[i] = a[i] - k */
+static void build_sub_param(ir_node *const k)
+{
+	ir_node *lanes[N_LANES];
+	for (unsigned i = 0; i < N_LANES; ++i)
+		lanes[i] = load_element(a_entity, i);
+	for (unsigned i = 0; i < N_LANES; ++i)
+		store_element(b_entity, i, new_Sub(lanes[i], k));
+}
+
+/* b[i] = a[i] - a[0], with a[0] = k between the Stores to b. The Load of a[0]
+ * is also the splatted operand, so it must stay in front of the Store to
+ * a[0]. */
+static void build_sub_first(ir_node *const k)
+{
+	ir_node *lanes[N_LANES];
+	for (unsigned i = 0; i < N_LANES; ++i)
+		lanes[i] = load_element(a_entity, i);
+	for (unsigned i = 0; i < N_LANES; ++i) {
+		if (i == N_LANES / 2)
+			store_element(a_entity, 0, k);
+		/* local optimizations would fold a[0] - a[0] */
+		int const optimize = get_optimize();
+		set_optimize(0);
+		ir_node *const sub = new_Sub(lanes[i], lanes[0]);
+		set_optimize(optimize);
+		store_element(b_entity, i, sub);
+	}
+}
+
+static void count_vector_store(ir_node *const node, void *const env)
+{
+	if (is_Store(node) && mode_is_vector(get_irn_mode(get_Store_value(node))))
+		++*(unsigned*)env;
+}
+
+static unsigned get_n_vector_stores(ir_graph *const irg)
+{
+	unsigned n = 0;
+	irg_walk_graph(irg, NULL, count_vector_store, &n);
+	return n;
+}
+
+typedef void (*func_t)(int32_t);
+
+static func_t compile(ir_jit_segment_t *const segment, ir_graph *const irg)
+{
+	ir_jit_function_t *const function = be_jit_compile(segment, irg);
+	assert(function != NULL);
+	return (func_t)be_jit_emit_executable(function);
+}
+
+static void init_a(void)
+{
+	for (unsigned i = 0; i < N_LANES; ++i)
+		a[i] = 10 * (i + 1);
+}
+
+int main(void)
+{
+#if defined(__x86_64__) && defined(__linux__)
+	ir_init();
+	if (!ir_target_set("x86_64-linux-gnu"))
+		return 1;
+	ir_target_init();
+
+	a_entity = new_array("a");
+	b_entity = new_array("b");
+	ir_graph *const sub_param = new_func("sub_param", build_sub_param);
+	ir_graph *const sub_first = new_func("sub_first", build_sub_first);
+
+	slp_vectorize(sub_param);
+	slp_vectorize(sub_first);
+	assert(get_n_vector_stores(sub_param) == 1);
+	assert(get_n_vector_stores(sub_first) == 0);
+
+	be_lower_for_target();
+	be_jit_set_entity_addr(a_entity, a);
+	be_jit_set_entity_addr(b_entity, b);
+
+	ir_jit_segment_t *const segment = be_new_jit_segment();
+	func_t const f_param = compile(segment, sub_param);
+	func_t const f_first = compile(segment, sub_first);
+
+	init_a();
+	f_param(3);
+	for (unsigned i = 0; i < N_LANES; ++i)
+		assert(b[i] == a[i] - 3);
+
+	init_a();
+	f_first(99);
+	assert(a[0] == 99);
+	for (unsigned i = 0; i < N_LANES; ++i)
+		assert(b[i] == 10 * (int32_t)i);
+
+	be_destroy_jit_segment(segment);
+	ir_finish();
+#endif
+	return 0;
+}
@@ -0,0 +1,244 @@
+#include "firm.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define N_CASES 8
+
+static ir_graph *split_irg;
+static ir_graph *never_irg;
+
+static ir_type *new_func_type(void)
+{
+	ir_type *const t_int = new_type_primitive(mode_Is);
+	ir_type *const mtp   = new_type_method(2, 1, false, cc_cdecl_set,
+	                                       mtp_no_property);
+	set_method_param_type(mtp, 0, t_int);
+	set_method_param_type(mtp, 1, t_int);
+	set_method_res_type(mtp, 0, t_int);
+	return mtp;
+}
+
+static void add_return(ir_graph *const irg, ir_node *const value)
+{
+	ir_node *const res[] = { value };
+	ir_node *const ret   = new_Return(get_store(), 1, res);
+	add_immBlock_pred(get_irg_end_block(irg), ret);
+}
+
+/** Ends the current block with a dense switch over @p sel, which is lowered to
+ * a jump table, every case returns a different constant. */
+static void build_switch(ir_graph *const irg, ir_node *const sel)
+{
+	ir_switch_table *const table = ir_new_switch_table(irg, N_CASES);
+	for (unsigned i = 0; i < N_CASES; ++i) {
+		ir_tarval *const tv = new_tarval_from_long(i, mode_Is);
+		ir_switch_table_set(table, i, tv, tv, i + 1);
+	}
+	ir_node *const sw = new_Switch(sel, N_CASES + 1, table);
+	for (unsigned pn = 0; pn <= N_CASES; ++pn) {
+		ir_node *const block = new_immBlock();
+		add_immBlock_pred(block, new_Proj(sw, mode_X, pn));
+		mature_immBlock(block);
+		set_cur_block(block);
+		add_return(irg, new_Const_long(mode_Is, pn * 7 + 3));
+	}
+}
+
+/** Creates int name(int x, int y), which switches over y if @p split_at_x and
+ * x is zero, otherwise it returns x + 1. */
+static ir_graph *new_switch_func(char const *const name, bool const split_at_x)
+{
+	ir_entity *const entity
+		= new_global_entity(get_glob_type(), new_id_from_str(name),
+		                    new_func_type(), ir_visibility_external,
+		                    IR_LINKAGE_DEFAULT);
+	ir_graph *const irg = new_ir_graph(entity, 0);
+	set_current_ir_graph(irg);
+	ir_node *const args = get_irg_args(irg);
+	ir_node *const x    = new_Proj(args, mode_Is, 0);
+	ir_node *const y    = new_Proj(args, mode_Is, 1);
+	if (split_at_x) {
+		ir_node *const zero = new_Const_long(mode_Is, 0);
+		ir_node *const cond = new_Cond(new_Cmp(x, zero, ir_relation_equal));
+
+		ir_node *const hot = new_immBlock();
+		add_immBlock_pred(hot, new_Proj(cond, mode_X, pn_Cond_false));
+		mature_immBlock(hot);
+		ir_node *const cold = new_immBlock();
+		add_immBlock_pred(cold, new_Proj(cond, mode_X, pn_Cond_true));
+		mature_immBlock(cold);
+
+		set_cur_block(hot);
+		add_return(irg, new_Add(x, new_Const_long(mode_Is, 1)));
+		set_cur_block(cold);
+	}
+	build_switch(irg, y);
+	mature_immBlock(get_irg_end_block(irg));
+	irg_finalize_cons(irg);
+	return irg;
+}
+
+/** Blocks behind the Cond and the Switch of the split function are cold. */
+static bool is_cold_block(ir_node *const block)
+{
+	ir_graph *const irg = get_irn_irg(block);
+	if (irg == never_irg)
+		return true;
+	if (irg != split_irg || get_Block_n_cfgpreds(block) != 1)
+		return false;
+	ir_node *const pred = get_Block_cfgpred(block, 0);
+	if (!is_Proj(pred))
+		return false;
+	ir_node *const pred_pred = get_Proj_pred(pred);
+	return is_Switch(pred_pred)
+	    || (is_Cond(pred_pred) && get_Proj_num(pred) == pn_Cond_true);
+}
+
+static void write_count(ir_node *const block, void *const env)
+{
+	uint32_t const count = is_cold_block(block) ? 0 : 1000;
+	unsigned char const bytes[] = {
+		count, count >> 8, count >> 16, count >> 24
+	};
+	fwrite(bytes, 1, sizeof(bytes), (FILE*)env);
+}
+
+/** Writes a profile in the order the backend reads it. */
+static void write_profile(char const *const filename)
+{
+	FILE *const f = fopen(filename, "wb");
+	assert(f != NULL);
+	fwrite("firmprof", 1, 8, f);
+	for (size_t i = get_irp_n_irgs(); i-- > 0;) {
+		ir_graph *const irg = get_irp_irg(i);
+		assure_irg_properties(irg, IR_GRAPH_PROPERTY_NO_BADS
+			| IR_GRAPH_PROPERTY_NO_UNREACHABLE_CODE
+			| IR_GRAPH_PROPERTY_NO_CRITICAL_EDGES
+			| IR_GRAPH_PROPERTY_MANY_RETURNS);
+		irg_block_walk_graph(irg, write_count, NULL, f);
+	}
+	fclose(f);
+}
+
+static char const *get_section(char const *const line)
+{
+	static char section[256];
+	if (strncmp(line, "\t.section\t", 10) == 0) {
+		size_t const len = strcspn(line + 10, ",\n");
+		assert(len < sizeof(section));
+		memcpy(section, line + 10, len);
+		section[len] = '\0';
+		return section;
+	}
+	static char const *const shortforms[] = {
+		"\t.text\n", "\t.data\n", "\t.bss\n"
+	};
+	for (size_t i = 0; i < sizeof(shortforms) / sizeof(*shortforms); ++i) {
+		if (strcmp(line, shortforms[i]) == 0) {
+			size_t const len = strlen(shortforms[i]) - 2;
+			memcpy(section, shortforms[i] + 1, len);
+			section[len] = '\0';
+			return section;
+		}
+	}
+	return NULL;
+}
+
+typedef struct label_t {
+	char name[64];
+	char section[64];
+} label_t;
+
+/** Checks that the .size of each function is computed in the section of its
+ * label, otherwise the assembler cannot evaluate it. */
+static void check_sections(FILE *const f, char const *const *const names,
+                           size_t const n_names, bool *const seen_hot,
+                           bool *const seen_cold)
+{
+	label_t labels[16];
+	size_t  n_labels = 0;
+	char    current[64] = "";
+	char    line[256];
+	while (fgets(line, sizeof(line), f) != NULL) {
+		char const *const section = get_section(line);
+		if (section != NULL) {
+			strcpy(current, section);
+			if (strcmp(section, ".text.hot") == 0)
+				*seen_hot = true;
+			continue;
+		}
+		for (size_t i = 0; i < n_names; ++i) {
+			char label[64];
+			snprintf(label, sizeof(label), "%s:\n", names[i]);
+			char cold_label[64];
+			snprintf(cold_label, sizeof(cold_label), "%s.cold:\n", names[i]);
+			bool const cold = strcmp(line, cold_label) == 0;
+			if (!cold && strcmp(line, label) != 0)
+				continue;
+			*seen_cold |= cold;
+			assert(n_labels < sizeof(labels) / sizeof(*labels));
+			label_t *const l = &labels[n_labels++];
+			size_t const len = strlen(line) - 2;
+			memcpy(l->name, line, len);
+			l->name[len] = '\0';
+			strcpy(l->section, current);
+		}
+		if (strncmp(line, "\t.size\t", 7) != 0)
+			continue;
+		for (size_t i = 0; i < n_labels; ++i) {
+			char size[160];
+			snprintf(size, sizeof(size), "\t.size\t%s, .-%s\n", labels[i].name,
+			         labels[i].name);
+			if (strcmp(line, size) == 0)
+				assert(strcmp(labels[i].section, current) == 0);
+		}
+	}
+}
+
+int main(void)
+{
+#if defined(__x86_64__) && defined(__linux__)
+	ir_init();
+	if (!ir_target_set("x86_64-linux-gnu"))
+		return 1;
+	if (!ir_target_option("profileuse")
+	 || !ir_target_option("blocksched-coldsection=1"))
+		return 1;
+	ir_target_init();
+
+	/* the switch of hot_switch lands in .text.hot, the one of split_switch in
+	 * its cold part in .text.unlikely and never_switch completely in
+	 * .text.unlikely. Each jump table is emitted into .rodata in between. */
+	new_switch_func("hot_switch", false);
+	split_irg = new_switch_func("split_switch", true);
+	never_irg = new_switch_func("never_switch", false);
+
+	be_lower_for_target();
+	char const *const cup_name = "text_sections_test";
+	char const *const prof_name = "text_sections_test.prof";
+	write_profile(prof_name);
+
+	FILE *const out = tmpfile();
+	assert(out != NULL);
+	be_main(out, cup_name);
+	remove(prof_name);
+
+	rewind(out);
+	char const *const names[] = { "hot_switch", "split_switch", "never_switch" };
+	bool seen_hot  = false;
+	bool seen_cold = false;
+	check_sections(out, names, sizeof(names) / sizeof(*names), &seen_hot,
+	               &seen_cold);
+	fclose(out);
+	assert(seen_hot);
+	assert(seen_cold);
+	(void)seen_hot;
+	(void)seen_cold;
+
+	ir_finish();
+#endif
+	return 0;
+}